@@ -27,6 +27,7 @@
 #include "xplr_bluetooth_types.h"
 #include <string.h>
 #include "freertos/ringbuf.h"
+#include "freertos/task.h"
 
 #if XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BT_CLASSIC
 #include "esp_bt.h"
@@ -59,11 +60,29 @@
 #endif
 
 #define XPLR_BLUETOOTH_MAX_DELAY    (TickType_t)pdMS_TO_TICKS(100)
+#define XPLR_BLUETOOTH_STREAM_STOP_TIMEOUT_MS   (2000U)
+#define XPLR_BLUETOOTH_BLE_WRITE_RETRIES        (10)
+#define XPLR_BLUETOOTH_BLE_WRITE_BACKOFF_MS     (100U)
+
+#if XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BLE
+// Wait for at least a full notification before flushing the stream
+#define XPLR_BLUETOOTH_STREAM_MIN_BATCH     BLE_SEND_MTU
+#else
+#define XPLR_BLUETOOTH_STREAM_MIN_BATCH     (128U)
+#endif
 
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
 
+typedef struct btStream_type {
+    RingbufHandle_t                 ringBuffer;         /*< Byte ring buffer holding the queued stream data */
+    StaticRingbuffer_t              staticBufHandle;    /*< Static ring buffer handle */
+    TaskHandle_t                    task;               /*< Stream writer task */
+    xplrBluetooth_stream_stats_t    stats;              /*< Stream counters */
+    volatile bool                   running;            /*< True while the stream accepts data */
+} btStream_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
@@ -71,6 +90,15 @@
 static int8_t logIndex = -1;
 xplrBluetooth_client_t *btClient;
 SemaphoreHandle_t btSemaphore;
+// Device slot to start from when looking for the first available message
+static uint8_t btReadNextSlot = 0;
+static btStream_t btStream = {
+    .ringBuffer = NULL,
+    .task = NULL,
+    .running = false
+};
+// Guards btStream.stats, updated by the producers and the stream task
+static portMUX_TYPE btStreamStatsMux = portMUX_INITIALIZER_UNLOCKED;
 
 #if XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BLE
 #if XPLRBLUETOOTH_BLE_CHARS == XPLRBLUETOOTH_BLE_NORDIC
@@ -121,19 +149,20 @@ static void btInitDeviceTable(void);
 static void btDeInitDeviceTable(void);
 static xplrBluetooth_error_t btInitDeviceBuffers(char *xplrBluetoothDeviceMessageBuffer,
                                                  size_t xplrBluetoothDeviceMessageBufferSize);
+static xplrBluetooth_error_t btInitDeviceRxBuffers(void);
+static void btDeInitDeviceRxBuffers(void);
+static void btFlushDeviceRxBuffer(xplrBluetooth_connected_device_t *dvc);
 static void btRemoveDevice(uint32_t handle);
 static uint8_t btGetNumOfConnectedDevices(void);
-static void btSetAvailableMessage(uint32_t handle);
 static int8_t btDeviceHandleToIndex(uint32_t handle);
-static xplrBluetooth_connected_device_t *btDeviceHandleToDeviceStructHelper(uint32_t handle);
-static void btCacheMsg(uint32_t handle, uint8_t *incomingMsg, uint32_t incomingMsgLen);
-static void btPlaceMessageBackInBufferHelper(uint8_t items, uint8_t *writeBackBuffer);
+static int8_t btDeviceToIndex(xplrBluetooth_connected_device_t *dvc);
+static int8_t btNextAvailableDeviceIndex(void);
+static void btCacheMsg(uint32_t handle, uint8_t *incomingMsg, size_t incomingMsgLen);
 static int32_t btRead(xplrBluetooth_connected_device_t **dvc, bool readFirstAvailableMsg);
-static xplrBluetooth_connected_device_t *btReadFirstAvailableMsgHelper(uint8_t *message,
-                                                                       size_t messageSize,
-                                                                       int32_t *size,
-                                                                       bool *correctMsgRead);
-static void btUpdateStateHelper(UBaseType_t *itemsRemainingInBuffer);
+static int32_t btReadDeviceMsg(xplrBluetooth_connected_device_t *dvc);
+static void btUpdateStateHelper(void);
+static void btStreamTask(void *arg);
+static void btStreamSendBatch(char *batch, size_t batchSize);
 #if XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BT_CLASSIC
 static xplrBluetooth_error_t btClassicInit(void);
 static xplrBluetooth_error_t btClassicControllerInit(void);
@@ -185,15 +214,12 @@ xplrBluetooth_error_t xplrBluetoothInit(xplrBluetooth_client_t *client,
 
     btClient = client;
     btSemaphore = xplrBluetoothSemaphore;
-    btClient->configuration.ringBuffer = xRingbufferCreateStatic(XPLRBLUETOOTH_RX_BUFFER_SIZE,
-                                                                 RINGBUF_TYPE_NOSPLIT,
-                                                                 btClient->buffer,
-                                                                 &(btClient->configuration.staticBufHandle));
-    if (btClient->configuration.ringBuffer == NULL) {
-        XPLRBLUETOOTH_CONSOLE(E, "Failed to create ring buffer");
-        ret = XPLR_BLUETOOTH_ERROR;
+    btReadNextSlot = 0;
+    btInitDeviceTable();
+    ret = btInitDeviceRxBuffers();
+    if (ret == XPLR_BLUETOOTH_ERROR) {
+        XPLRBLUETOOTH_CONSOLE(E, "Failed to create device RX buffers");
     } else {
-        btInitDeviceTable();
         ret = btInitDeviceBuffers(xplrBluetoothDeviceMessageBuffer, xplrBluetoothDeviceMessageBufferSize);
         if (ret != XPLR_BLUETOOTH_ERROR) {
 #if (XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BT_CLASSIC)
@@ -215,8 +241,12 @@ xplrBluetooth_error_t xplrBluetoothInit(xplrBluetooth_client_t *client,
 xplrBluetooth_error_t xplrBluetoothDeInit(void)
 {
     xplrBluetooth_error_t ret;
-    BaseType_t semaphoreRet;
 
+    if (btStream.running) {
+        xplrBluetoothStreamStop();
+    } else {
+        // Do nothing
+    }
     xplrBluetoothDisconnectAllDevices();
 
 #if (XPLRBLUETOOTH_MODE == XPLRBLUETOOTH_MODE_BT_CLASSIC)
@@ -228,14 +258,7 @@ xplrBluetooth_error_t xplrBluetoothDeInit(void)
     ret = XPLR_BLUETOOTH_ERROR;
 #endif
     btDeInitDeviceTable();
-    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-    if (semaphoreRet == pdTRUE) {
-
-        vRingbufferDelete(btClient->configuration.ringBuffer);
-        xSemaphoreGive(btSemaphore);
-    } else {
-        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
-    }
+    btDeInitDeviceRxBuffers();
 
     return ret;
 }
@@ -363,6 +386,117 @@ xplrBluetooth_connected_device_t *xplrBluetoothPrintConnectedDevices(void)
     return btClient->devices;
 }
 
+xplrBluetooth_error_t xplrBluetoothStreamStart(uint8_t *streamBuffer, size_t streamBufferSize)
+{
+    xplrBluetooth_error_t ret;
+    BaseType_t taskRet;
+
+    if (btStream.running) {
+        XPLRBLUETOOTH_CONSOLE(D, "Stream already running");
+        ret = XPLR_BLUETOOTH_OK;
+    } else if ((streamBuffer == NULL) ||
+               (streamBufferSize < (2 * XPLRBLUETOOTH_STREAM_BATCH_SIZE))) {
+        XPLRBLUETOOTH_CONSOLE(E, "Insufficient stream buffer");
+        ret = XPLR_BLUETOOTH_ERROR;
+    } else {
+        // Byte buffer: the writer can pull any amount, regardless of message boundaries
+        btStream.ringBuffer = xRingbufferCreateStatic(streamBufferSize,
+                                                      RINGBUF_TYPE_BYTEBUF,
+                                                      streamBuffer,
+                                                      &(btStream.staticBufHandle));
+        if (btStream.ringBuffer == NULL) {
+            XPLRBLUETOOTH_CONSOLE(E, "Failed to create stream ring buffer");
+            ret = XPLR_BLUETOOTH_ERROR;
+        } else {
+            portENTER_CRITICAL(&btStreamStatsMux);
+            memset(&btStream.stats, 0, sizeof(btStream.stats));
+            portEXIT_CRITICAL(&btStreamStatsMux);
+            btStream.running = true;
+            taskRet = xTaskCreate(btStreamTask, "btStreamTask", 3 * 1024, NULL, 5, &btStream.task);
+            if (taskRet != pdPASS) {
+                XPLRBLUETOOTH_CONSOLE(E, "Failed to create stream task");
+                btStream.running = false;
+                btStream.task = NULL;
+                vRingbufferDelete(btStream.ringBuffer);
+                btStream.ringBuffer = NULL;
+                ret = XPLR_BLUETOOTH_ERROR;
+            } else {
+                XPLRBLUETOOTH_CONSOLE(I, "Stream started");
+                ret = XPLR_BLUETOOTH_OK;
+            }
+        }
+    }
+
+    return ret;
+}
+
+xplrBluetooth_error_t xplrBluetoothStreamStop(void)
+{
+    xplrBluetooth_error_t ret;
+    xplrBluetooth_stream_stats_t stats;
+    uint32_t waitMs = 0;
+
+    btStream.running = false;
+    // The task exits on its own once its current batch is written
+    while ((btStream.task != NULL) && (waitMs < XPLR_BLUETOOTH_STREAM_STOP_TIMEOUT_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(XPLRBLUETOOTH_STREAM_FLUSH_MS));
+        waitMs += XPLRBLUETOOTH_STREAM_FLUSH_MS;
+    }
+
+    if (btStream.task != NULL) {
+        XPLRBLUETOOTH_CONSOLE(E, "Stream task did not exit");
+        ret = XPLR_BLUETOOTH_ERROR;
+    } else {
+        if (btStream.ringBuffer != NULL) {
+            vRingbufferDelete(btStream.ringBuffer);
+            btStream.ringBuffer = NULL;
+        } else {
+            // Do nothing
+        }
+        xplrBluetoothStreamGetStats(&stats);
+        XPLRBLUETOOTH_CONSOLE(I,
+                              "Stream stopped, queued: %u dropped: %u sent: %u bytes write errors: %u",
+                              stats.msgsQueued,
+                              stats.msgsDropped,
+                              stats.bytesSent,
+                              stats.writeErrors);
+        ret = XPLR_BLUETOOTH_OK;
+    }
+
+    return ret;
+}
+
+xplrBluetooth_error_t xplrBluetoothStreamPush(const char *msg, size_t msgSize)
+{
+    xplrBluetooth_error_t ret;
+    BaseType_t bufRet;
+
+    if (!btStream.running || (msg == NULL) || (msgSize == 0)) {
+        ret = XPLR_BLUETOOTH_ERROR;
+    } else {
+        // Zero timeout: the producer is never held back by a slow link
+        bufRet = xRingbufferSend(btStream.ringBuffer, msg, msgSize, 0);
+        portENTER_CRITICAL(&btStreamStatsMux);
+        if (bufRet != pdTRUE) {
+            btStream.stats.msgsDropped++;
+            ret = XPLR_BLUETOOTH_ERROR;
+        } else {
+            btStream.stats.msgsQueued++;
+            ret = XPLR_BLUETOOTH_OK;
+        }
+        portEXIT_CRITICAL(&btStreamStatsMux);
+    }
+
+    return ret;
+}
+
+void xplrBluetoothStreamGetStats(xplrBluetooth_stream_stats_t *stats)
+{
+    portENTER_CRITICAL(&btStreamStatsMux);
+    memcpy(stats, &btStream.stats, sizeof(xplrBluetooth_stream_stats_t));
+    portEXIT_CRITICAL(&btStreamStatsMux);
+}
+
 int8_t xplrBluetoothInitLogModule(xplr_cfg_logInstance_t *logCfg)
 {
     int8_t ret;
@@ -480,6 +614,74 @@ xplrBluetooth_error_t btInitDeviceBuffers(char *xplrBluetoothDeviceMessageBuffer
     return ret;
 }
 
+xplrBluetooth_error_t btInitDeviceRxBuffers(void)
+{
+    xplrBluetooth_error_t ret;
+    int i;
+    BaseType_t semaphoreRet;
+
+    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
+    if (semaphoreRet == pdTRUE) {
+        ret = XPLR_BLUETOOTH_OK;
+        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+            // Every device slot owns its RX ring buffer so reads never have to skip foreign messages
+            btClient->devices[i].rxBuffer =
+                xRingbufferCreateStatic(XPLRBLUETOOTH_DEVICE_RX_BUFFER_SIZE,
+                                        RINGBUF_TYPE_NOSPLIT,
+                                        btClient->devices[i].rxBufferStorage,
+                                        &(btClient->devices[i].rxStaticBufHandle));
+            if (btClient->devices[i].rxBuffer == NULL) {
+                XPLRBLUETOOTH_CONSOLE(E, "Failed to create ring buffer for device slot %d", i);
+                ret = XPLR_BLUETOOTH_ERROR;
+                break;
+            } else {
+                // Do nothing
+            }
+        }
+        xSemaphoreGive(btSemaphore);
+    } else {
+        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
+        ret = XPLR_BLUETOOTH_ERROR;
+    }
+
+    return ret;
+}
+
+void btDeInitDeviceRxBuffers(void)
+{
+    int i;
+    BaseType_t semaphoreRet;
+
+    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
+    if (semaphoreRet == pdTRUE) {
+        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+            if (btClient->devices[i].rxBuffer != NULL) {
+                vRingbufferDelete(btClient->devices[i].rxBuffer);
+                btClient->devices[i].rxBuffer = NULL;
+            } else {
+                // Do nothing
+            }
+        }
+        xSemaphoreGive(btSemaphore);
+    } else {
+        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
+    }
+}
+
+void btFlushDeviceRxBuffer(xplrBluetooth_connected_device_t *dvc)
+{
+    size_t messageSize;
+    uint8_t *message;
+
+    // Caller must hold btSemaphore
+    message = xRingbufferReceiveFromISR(dvc->rxBuffer, &messageSize);
+    while (message != NULL) {
+        vRingbufferReturnItemFromISR(dvc->rxBuffer, message, NULL);
+        message = xRingbufferReceiveFromISR(dvc->rxBuffer, &messageSize);
+    }
+    dvc->msgAvailable = false;
+}
+
 void btRemoveDevice(uint32_t handle)
 {
     uint8_t index, connectedDevices;
@@ -533,28 +735,6 @@ uint8_t btGetNumOfConnectedDevices(void)
     return counter;
 }
 
-void btSetAvailableMessage(uint32_t handle)
-{
-    uint8_t i;
-    BaseType_t semaphoreRet;
-
-    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-    if (semaphoreRet == pdTRUE) {
-        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
-            // Find the corresponding slot
-            if (btClient->devices[i].handle == handle && btClient->devices[i].connected) {
-                // If the device exists and is connected
-                btClient->devices[i].msgAvailable = true;
-                break;
-            }
-        }
-        btClient->state = XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE;
-        xSemaphoreGive(btSemaphore);
-    } else {
-        XPLRBLUETOOTH_CONSOLE(E, "Couldn't get semaphore");
-    }
-}
-
 int8_t btDeviceHandleToIndex(uint32_t handle)
 {
     uint8_t i;
@@ -585,229 +765,244 @@ int8_t btDeviceHandleToIndex(uint32_t handle)
     return ret;
 }
 
-xplrBluetooth_connected_device_t *btDeviceHandleToDeviceStructHelper(uint32_t handle)
+int8_t btDeviceToIndex(xplrBluetooth_connected_device_t *dvc)
 {
-    xplrBluetooth_connected_device_t *ret = &(btClient->devices[btDeviceHandleToIndex(handle)]);
+    int8_t ret;
+
+    if ((dvc >= btClient->devices) && (dvc < &(btClient->devices[XPLRBLUETOOTH_NUMOF_DEVICES]))) {
+        ret = (int8_t)(dvc - btClient->devices);
+    } else {
+        XPLRBLUETOOTH_CONSOLE(E, "Device does not belong to the client");
+        ret = -1;
+    }
 
     return ret;
 }
 
-void btCacheMsg(uint32_t handle, uint8_t *message, size_t messageSize)
+int8_t btNextAvailableDeviceIndex(void)
 {
-    BaseType_t bufRet, semaphoreRet;
-    if (messageSize <= XPLRBLUETOOTH_MAX_MSG_SIZE) {
-        uint8_t buf[4 + messageSize];
-
-        // The first 4 bytes of every message are the device handle from which the message was received
-        memcpy(buf, &handle, 4);
-        memcpy(&buf[4], message, messageSize);
+    uint8_t i, slot;
+    int8_t ret = -1;
+    UBaseType_t itemsWaiting;
+    BaseType_t semaphoreRet;
 
-        semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-        if (semaphoreRet == pdTRUE) {
-            bufRet = xRingbufferSendFromISR(btClient->configuration.ringBuffer, buf, 4 + messageSize, NULL);
-            if (bufRet != pdTRUE) {
-                XPLRBLUETOOTH_CONSOLE(E, "Buffer full cannot store message");
-                btClient->state = XPLR_BLUETOOTH_CONN_STATE_RX_BUFFER_FULL;
+    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
+    if (semaphoreRet == pdTRUE) {
+        // Start after the last served slot so a busy device cannot starve the rest
+        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+            slot = (btReadNextSlot + i) % XPLRBLUETOOTH_NUMOF_DEVICES;
+            vRingbufferGetInfo(btClient->devices[slot].rxBuffer,
+                               NULL,
+                               NULL,
+                               NULL,
+                               NULL,
+                               &itemsWaiting);
+            if (itemsWaiting != 0) {
+                ret = slot;
+                btReadNextSlot = (slot + 1) % XPLRBLUETOOTH_NUMOF_DEVICES;
+                break;
             } else {
-                btClient->state = XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE;
+                // Do nothing
             }
-            xSemaphoreGive(btSemaphore);
-        } else {
-            XPLRBLUETOOTH_CONSOLE(E, "Couldn't get semaphore");
         }
+        xSemaphoreGive(btSemaphore);
     } else {
-        XPLRBLUETOOTH_CONSOLE(E, "Message larger than configured max message size, discarding...");
+        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
     }
+
+    return ret;
 }
 
-void btPlaceMessageBackInBufferHelper(uint8_t items, uint8_t *writeBackBuffer)
+void btCacheMsg(uint32_t handle, uint8_t *message, size_t messageSize)
 {
-    uint8_t remainingItems = items;
-    size_t messageSize;
-    uint8_t *message = NULL;
-    BaseType_t bufRet;
-    BaseType_t semaphoreRet;
+    int8_t index;
+    BaseType_t bufRet, semaphoreRet;
 
-    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-    if (semaphoreRet == pdTRUE) {
-        while (remainingItems > 0) {
-            message = xRingbufferReceiveFromISR(btClient->configuration.ringBuffer, &messageSize);
-            memcpy(writeBackBuffer, message, messageSize);
-            bufRet = xRingbufferSendFromISR(btClient->configuration.ringBuffer, writeBackBuffer, messageSize,
-                                            NULL);
-            if (bufRet != pdTRUE) {
-                XPLRBLUETOOTH_CONSOLE(E, "Buffer full cannot store message");
-                btClient->state = XPLR_BLUETOOTH_CONN_STATE_RX_BUFFER_FULL;
+    if (messageSize <= XPLRBLUETOOTH_MAX_MSG_SIZE) {
+        index = btDeviceHandleToIndex(handle);
+        if (index == -1) {
+            // Unknown device, btDeviceHandleToIndex will print error
+        } else {
+            semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
+            if (semaphoreRet == pdTRUE) {
+                bufRet = xRingbufferSendFromISR(btClient->devices[index].rxBuffer,
+                                                message,
+                                                messageSize,
+                                                NULL);
+                if (bufRet != pdTRUE) {
+                    XPLRBLUETOOTH_CONSOLE(E, "Buffer full cannot store message");
+                    btClient->state = XPLR_BLUETOOTH_CONN_STATE_RX_BUFFER_FULL;
+                } else {
+                    btClient->devices[index].msgAvailable = true;
+                    btClient->state = XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE;
+                }
+                xSemaphoreGive(btSemaphore);
             } else {
-                remainingItems--;
+                XPLRBLUETOOTH_CONSOLE(E, "Couldn't get semaphore");
             }
         }
-        xSemaphoreGive(btSemaphore);
     } else {
-        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
+        XPLRBLUETOOTH_CONSOLE(E, "Message larger than configured max message size, discarding...");
     }
 }
 
 int32_t btRead(xplrBluetooth_connected_device_t **dvc,
                bool readFirstAvailableMsg)
 {
-    int32_t ret, handleBuf, initialItemsRemainingInBuffer;
-    size_t messageSize;
-    uint8_t *message = NULL;
-    UBaseType_t itemsRemainingInBuffer;
-    BaseType_t semaphoreRet, bufRet;
-    uint8_t writeBackBuffer[4 + XPLRBLUETOOTH_MAX_MSG_SIZE];
-    bool correctMsgRead = false;
-    uint8_t repCounter = 0;
+    int32_t ret;
+    int8_t index;
 
-    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-    if (semaphoreRet == pdTRUE) {
-        vRingbufferGetInfo(btClient->configuration.ringBuffer,
-                           NULL,
-                           NULL,
-                           NULL,
-                           NULL,
-                           &itemsRemainingInBuffer);
-        xSemaphoreGive(btSemaphore);
-    } else {
-        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
-    }
-    initialItemsRemainingInBuffer = itemsRemainingInBuffer;
-    if (itemsRemainingInBuffer != 0) {
-        if (readFirstAvailableMsg) {
-            // Read the first available message in the buffer (from any device)
-            *dvc = btReadFirstAvailableMsgHelper(message,
-                                                 messageSize,
-                                                 &ret,
-                                                 &correctMsgRead);
+    if (readFirstAvailableMsg) {
+        // Read the first available message (from any device)
+        index = btNextAvailableDeviceIndex();
+        if (index == -1) {
+            XPLRBLUETOOTH_CONSOLE(I, "No message to read");
+            ret = 0;
         } else {
-            do {
-                // Keep reading messages until you find the first from the requested device
-                repCounter++;
-                semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-                if (semaphoreRet == pdTRUE) {
-                    message = xRingbufferReceiveFromISR(btClient->configuration.ringBuffer, &messageSize);
-                    xSemaphoreGive(btSemaphore);
-                } else {
-                    XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
-                }
-                memcpy(&handleBuf, message, 4);
-                semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-                if (semaphoreRet == pdTRUE) {
-                    // If the device handle is the same as requested in the function call
-                    if ((*dvc)->handle == handleBuf) {
-                        // Keep the message in the device buffer
-                        memset((*dvc)->msg, '\0', XPLRBLUETOOTH_MAX_MSG_SIZE);
-                        memcpy((*dvc)->msg, &message[4], messageSize - 4);
-                        vRingbufferReturnItemFromISR(btClient->configuration.ringBuffer, message, NULL);
-                        xSemaphoreGive(btSemaphore);
-                    } else {
-                        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
-                    }
-                    ret = messageSize - 4;
-                    correctMsgRead = true;
-                    itemsRemainingInBuffer--;
-                } else {
-                    // If the read message is from a different device then return it to the buffer
-                    memcpy(writeBackBuffer, message, messageSize);
-                    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
-                    if (semaphoreRet == pdTRUE) {
-                        vRingbufferReturnItemFromISR(btClient->configuration.ringBuffer, message, NULL);
-                        bufRet = xRingbufferSendFromISR(btClient->configuration.ringBuffer, writeBackBuffer, messageSize,
-                                                        NULL);
-                        if (bufRet != pdTRUE) {
-                            XPLRBLUETOOTH_CONSOLE(E, "Buffer full cannot store message");
-                            btClient->state = XPLR_BLUETOOTH_CONN_STATE_RX_BUFFER_FULL;
-                        } else {
-                            itemsRemainingInBuffer--;
-                        }
-                        xSemaphoreGive(btSemaphore);
-                    } else {
-                        XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
-                    }
-                    ret = -1;
-                }
-                if (initialItemsRemainingInBuffer == repCounter && !correctMsgRead) {
-                    // Checked all the messages in the buffer and didn't find one from the requested device
-                    XPLRBLUETOOTH_CONSOLE(W, "No message from requested device");
-                    ret = 0;
-                    break;
-                }
-            } while (!correctMsgRead);
-            // Arrange the messages in the buffer in the correct order (if needed)
-            if (repCounter == 1 && correctMsgRead) {
-                // Do nothing
-            } else if (repCounter != 1 && correctMsgRead) {
-                // Place all the remaining messages in the right order
-                btPlaceMessageBackInBufferHelper(itemsRemainingInBuffer, writeBackBuffer);
-            }
+            *dvc = &(btClient->devices[index]);
+            ret = btReadDeviceMsg(*dvc);
         }
     } else {
-        // No message to read
-        XPLRBLUETOOTH_CONSOLE(I, "No message to read");
-        ret = 0;
+        index = btDeviceToIndex(*dvc);
+        if (index == -1) {
+            ret = -1;
+        } else {
+            ret = btReadDeviceMsg(*dvc);
+        }
     }
-    btUpdateStateHelper(&itemsRemainingInBuffer);
+    btUpdateStateHelper();
 
     return ret;
 }
 
-xplrBluetooth_connected_device_t *btReadFirstAvailableMsgHelper(uint8_t *message,
-                                                                size_t messageSize,
-                                                                int32_t *size,
-                                                                bool *correctMsgRead)
+int32_t btReadDeviceMsg(xplrBluetooth_connected_device_t *dvc)
 {
-    xplrBluetooth_connected_device_t *ret;
-    int32_t handle;
+    int32_t ret;
+    size_t messageSize;
+    uint8_t *message;
+    UBaseType_t itemsWaiting;
     BaseType_t semaphoreRet;
 
     semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
     if (semaphoreRet == pdTRUE) {
-
-        message = xRingbufferReceiveFromISR(btClient->configuration.ringBuffer, &messageSize);
+        message = xRingbufferReceiveFromISR(dvc->rxBuffer, &messageSize);
+        if (message != NULL) {
+            // Keep the message in the device buffer
+            memset(dvc->msg, '\0', XPLRBLUETOOTH_MAX_MSG_SIZE);
+            memcpy(dvc->msg, message, messageSize);
+            vRingbufferReturnItemFromISR(dvc->rxBuffer, message, NULL);
+            ret = messageSize;
+        } else {
+            XPLRBLUETOOTH_CONSOLE(W, "No message from requested device");
+            ret = 0;
+        }
+        vRingbufferGetInfo(dvc->rxBuffer, NULL, NULL, NULL, NULL, &itemsWaiting);
+        dvc->msgAvailable = (itemsWaiting != 0);
         xSemaphoreGive(btSemaphore);
     } else {
         XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
+        ret = -1;
     }
-    // Keep the pointer to the device struct
-    memcpy(&handle, message, 4);
-    ret = btDeviceHandleToDeviceStructHelper(handle);
-    // Keep the message in the user provided buffer
+
+    return ret;
+}
+
+void btUpdateStateHelper(void)
+{
+    int i;
+    UBaseType_t itemsWaiting;
+    UBaseType_t itemsRemainingInBuffers = 0;
+    BaseType_t semaphoreRet;
+
     semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
     if (semaphoreRet == pdTRUE) {
-        memset(ret->msg, '\0', XPLRBLUETOOTH_MAX_MSG_SIZE);
-        memcpy(ret->msg, &message[4], messageSize - 4);
-        vRingbufferReturnItemFromISR(btClient->configuration.ringBuffer, message, NULL);
+        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+            vRingbufferGetInfo(btClient->devices[i].rxBuffer,
+                               NULL,
+                               NULL,
+                               NULL,
+                               NULL,
+                               &itemsWaiting);
+            itemsRemainingInBuffers += itemsWaiting;
+        }
+        if (itemsRemainingInBuffers) {
+            btClient->state = XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE;
+        } else {
+            btClient->state = XPLR_BLUETOOTH_CONN_STATE_CONNECTED;
+        }
         xSemaphoreGive(btSemaphore);
     } else {
         XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
     }
-    *size = messageSize - 4;
-    *correctMsgRead = true;
+}
 
-    return ret;
+void btStreamTask(void *arg)
+{
+    char *batch;
+    size_t batchSize;
+    UBaseType_t bytesWaiting;
+
+    while (btStream.running) {
+        vRingbufferGetInfo(btStream.ringBuffer, NULL, NULL, NULL, NULL, &bytesWaiting);
+        if (bytesWaiting < XPLR_BLUETOOTH_STREAM_MIN_BATCH) {
+            // Let the rest of the epoch's messages join the batch
+            vTaskDelay(pdMS_TO_TICKS(XPLRBLUETOOTH_STREAM_FLUSH_MS));
+        } else {
+            // Do nothing
+        }
+        batch = xRingbufferReceiveUpTo(btStream.ringBuffer,
+                                       &batchSize,
+                                       pdMS_TO_TICKS(XPLRBLUETOOTH_STREAM_FLUSH_MS),
+                                       XPLRBLUETOOTH_STREAM_BATCH_SIZE);
+        if (batch != NULL) {
+            // Written straight from the ring buffer, no intermediate copy
+            btStreamSendBatch(batch, batchSize);
+            vRingbufferReturnItem(btStream.ringBuffer, batch);
+        } else {
+            // Nothing queued
+        }
+    }
+
+    btStream.task = NULL;
+    vTaskDelete(NULL);
 }
 
-void btUpdateStateHelper(UBaseType_t *itemsRemainingInBuffer)
+void btStreamSendBatch(char *batch, size_t batchSize)
 {
+    int i;
+    bool connected[XPLRBLUETOOTH_NUMOF_DEVICES];
     BaseType_t semaphoreRet;
+    xplrBluetooth_error_t writeRet;
 
     semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
     if (semaphoreRet == pdTRUE) {
-        vRingbufferGetInfo(btClient->configuration.ringBuffer,
-                           NULL,
-                           NULL,
-                           NULL,
-                           NULL,
-                           itemsRemainingInBuffer);
-        if (*itemsRemainingInBuffer) {
-            btClient->state = XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE;
-        } else {
-            btClient->state = XPLR_BLUETOOTH_CONN_STATE_CONNECTED;
+        for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+            connected[i] = btClient->devices[i].connected;
         }
         xSemaphoreGive(btSemaphore);
     } else {
         XPLRBLUETOOTH_CONSOLE(W, "Couldn't get semaphore");
+        memset(connected, 0, sizeof(connected));
+    }
+
+    // Batches with no device connected are consumed so stale data is never sent later
+    for (i = 0; i < XPLRBLUETOOTH_NUMOF_DEVICES; i++) {
+        if (connected[i]) {
+            /*
+             * On link congestion the write backs off with btSemaphore released,
+             * so only this task waits; the other API calls keep running.
+             */
+            writeRet = xplrBluetoothWrite(&btClient->devices[i], batch, batchSize);
+            portENTER_CRITICAL(&btStreamStatsMux);
+            if (writeRet != XPLR_BLUETOOTH_OK) {
+                btStream.stats.writeErrors++;
+            } else {
+                btStream.stats.bytesSent += batchSize;
+            }
+            portEXIT_CRITICAL(&btStreamStatsMux);
+        } else {
+            // Do nothing
+        }
     }
 }
 
@@ -1054,7 +1249,8 @@ void btClassicAddDevice(uint32_t handle, esp_bd_addr_t address)
                 // Use this slot for the new connected device
                 btClient->devices[i].handle = handle;
                 btClient->devices[i].connected = true;
-                btClient->devices[i].msgAvailable = false;
+                // Drop anything left over from the previous owner of the slot
+                btFlushDeviceRxBuffer(&btClient->devices[i]);
                 memcpy(btClient->devices[i].address, address, ESP_BD_ADDR_LEN * sizeof(uint8_t));
                 break;
             }
@@ -1216,7 +1412,9 @@ xplrBluetooth_error_t bleWrite(xplrBluetooth_connected_device_t *dvc,
                                size_t msgSize)
 {
     xplrBluetooth_error_t ret;
-    int err, i;
+    int err;
+    size_t i = 0;
+    size_t chunkSize;
     bool abort = false;
     struct os_mbuf *memoryBuffer;
     int errCount = 0;
@@ -1225,40 +1423,46 @@ xplrBluetooth_error_t bleWrite(xplrBluetooth_connected_device_t *dvc,
     semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
     if (semaphoreRet == pdTRUE) {
         if (msgSize == 0) {
-            ret = XPLR_BLUETOOTH_ERROR;
             XPLRBLUETOOTH_CONSOLE(E, "msgSize is 0");
+            abort = true;
         } else {
             // Split the message into chucks and send
-            for (i = 0; i < msgSize; i += BLE_SEND_MTU) {
-                while (1) {
-                    if (abort) {
-                        break;
-                    }
-                    if ((BLE_SEND_MTU) < (msgSize - i)) {
-                        memoryBuffer = ble_hs_mbuf_from_flat(&msg[i], (BLE_SEND_MTU));
-                    } else {
-                        memoryBuffer = ble_hs_mbuf_from_flat(&msg[i], (msgSize - i));
-                    }
-                    err = ble_gattc_notify_custom(dvc->handle, bleNotifyCharAttrHandle, memoryBuffer);
-                    // If send fails wait for a while and retry
-                    if (err == BLE_HS_ENOMEM && errCount++ < 10) {
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                    } else if (err) {
-                        XPLRBLUETOOTH_CONSOLE(E, "couldn't send message");
+            while ((i < msgSize) && !abort) {
+                chunkSize = ((msgSize - i) > BLE_SEND_MTU) ? BLE_SEND_MTU : (msgSize - i);
+                memoryBuffer = ble_hs_mbuf_from_flat(&msg[i], chunkSize);
+                err = ble_gattc_notify_custom(dvc->handle, bleNotifyCharAttrHandle, memoryBuffer);
+                if (err == 0) {
+                    i += chunkSize;
+                } else if ((err == BLE_HS_ENOMEM) && (errCount++ < XPLR_BLUETOOTH_BLE_WRITE_RETRIES)) {
+                    /*
+                     * Out of mbufs: wait for the link to drain and retry. The semaphore
+                     * is released meanwhile so the other API calls are not held up.
+                     */
+                    xSemaphoreGive(btSemaphore);
+                    vTaskDelay(pdMS_TO_TICKS(XPLR_BLUETOOTH_BLE_WRITE_BACKOFF_MS));
+                    semaphoreRet = xSemaphoreTake(btSemaphore, XPLR_BLUETOOTH_MAX_DELAY);
+                    if (semaphoreRet != pdTRUE) {
+                        XPLRBLUETOOTH_CONSOLE(E, "Couldn't get semaphore");
+                        abort = true;
+                    } else if (!dvc->connected) {
+                        // Disconnected while backing off
+                        XPLRBLUETOOTH_CONSOLE(W, "device disconnected");
                         abort = true;
                     } else {
-                        // If message chunk is sent successfully exit the while loop
-                        break;
+                        // Do nothing
                     }
+                } else {
+                    XPLRBLUETOOTH_CONSOLE(E, "couldn't send message");
+                    abort = true;
                 }
             }
-            if (i >= msgSize) {
-                ret = XPLR_BLUETOOTH_OK;
-            } else {
-                ret = XPLR_BLUETOOTH_ERROR;
-            }
         }
-        xSemaphoreGive(btSemaphore);
+        if (semaphoreRet == pdTRUE) {
+            xSemaphoreGive(btSemaphore);
+        } else {
+            // Not held
+        }
+        ret = (abort) ? XPLR_BLUETOOTH_ERROR : XPLR_BLUETOOTH_OK;
     } else {
         // Couldn't get semaphore returning error
         ret = XPLR_BLUETOOTH_ERROR;
@@ -1280,7 +1484,8 @@ void bleAddDevice(uint32_t handle, ble_addr_t address)
                 // Use this slot for the new connected device
                 btClient->devices[i].handle = handle;
                 btClient->devices[i].connected = true;
-                btClient->devices[i].msgAvailable = false;
+                // Drop anything left over from the previous owner of the slot
+                btFlushDeviceRxBuffer(&btClient->devices[i]);
                 memcpy(&(btClient->devices[i].address), &address, 6 * sizeof(uint8_t));
                 break;
             }
@@ -1440,7 +1645,6 @@ void BtClassicSPPcb(esp_spp_cb_event_t event, esp_spp_cb_param_t *param)
         case ESP_SPP_DATA_IND_EVT:
             // Received SPP data
             btCacheMsg(param->data_ind.handle, param->data_ind.data, param->data_ind.len);
-            btSetAvailableMessage(param->data_ind.handle);
             break;
         case ESP_SPP_CONG_EVT:
             XPLRBLUETOOTH_CONSOLE(W, "ESP_SPP_CONG_EVT");
@@ -1587,7 +1791,6 @@ int bleReceiveMsgCb(uint16_t conn_handle,
                     void *arg)
 {
     btCacheMsg(conn_handle, ctxt->om->om_data, ctxt->om->om_len);
-    btSetAvailableMessage(conn_handle);
     // int return just for compatibility with the callback type
     // errors are handled by xplr ble client
     return 0;
@@ -107,16 +107,18 @@ void xplrBluetoothDisconnectDevice(xplrBluetooth_connected_device_t *dvc);
 xplrBluetooth_conn_state_t xplrBluetoothGetState(void);
 
 /**
- * @brief Read incoming message from a connected Bluetooth/BLE device
+ * @brief Read incoming message from a connected Bluetooth/BLE device.
+ * Each device has its own RX queue, messages from other devices are left untouched.
  *
  * @param  dvc     pointer to xplrBluetooth_connected_device_t struct
  *
- * @return size of incoming message in bytes
+ * @return size of incoming message in bytes, 0 if no message is queued, -1 on error
  */
 int32_t xplrBluetoothRead(xplrBluetooth_connected_device_t *dvc);
 
 /**
  * @brief Read the first incoming message in the queue (from any connected Bluetooth/BLE device)
+ * Device queues are served round-robin so a single device cannot starve the rest.
  *
  * @param  dvc     pointer to xplrBluetooth_connected_device_t struct
  *
@@ -152,6 +154,43 @@ void xplrBluetoothPrintDiagnostics(xplrBluetooth_connected_device_t *dvc);
  */
 xplrBluetooth_connected_device_t *xplrBluetoothPrintConnectedDevices(void);
 
+/**
+ * @brief Start streaming to all connected devices.
+ * Data pushed to the stream is batched in up to XPLRBLUETOOTH_STREAM_BATCH_SIZE writes
+ * by a dedicated task, so producers (e.g. GNSS async callbacks) never block on the link.
+ *
+ * @param  streamBuffer      user provided buffer holding the queued stream data (32-bit aligned)
+ * @param  streamBufferSize  size of streamBuffer, at least 2 * XPLRBLUETOOTH_STREAM_BATCH_SIZE
+ *
+ * @return XPLR_BLUETOOTH_OK on success, XPLR_BLUETOOTH_ERROR otherwise.
+ */
+xplrBluetooth_error_t xplrBluetoothStreamStart(uint8_t *streamBuffer, size_t streamBufferSize);
+
+/**
+ * @brief Stop streaming and release the stream buffer.
+ *
+ * @return XPLR_BLUETOOTH_OK on success, XPLR_BLUETOOTH_ERROR otherwise.
+ */
+xplrBluetooth_error_t xplrBluetoothStreamStop(void);
+
+/**
+ * @brief Queue a message (e.g. NMEA sentence or UBX frame) to the stream. Never blocks.
+ * Messages are queued whole or dropped whole when the stream buffer is full.
+ *
+ * @param  msg      message to queue
+ * @param  msgSize  size of message in bytes
+ *
+ * @return XPLR_BLUETOOTH_OK on success, XPLR_BLUETOOTH_ERROR if dropped or stream not running.
+ */
+xplrBluetooth_error_t xplrBluetoothStreamPush(const char *msg, size_t msgSize);
+
+/**
+ * @brief Get the stream counters
+ *
+ * @param  stats   pointer to xplrBluetooth_stream_stats_t struct to fill
+ */
+void xplrBluetoothStreamGetStats(xplrBluetooth_stream_stats_t *stats);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
@@ -69,10 +69,15 @@ typedef enum {
 
 typedef struct xplrBluetooth_config_type {
     char                            deviceName[64];     /*< Bluetooth Classic/BLE server name */
-    RingbufHandle_t                 ringBuffer;          /*< Ring buffer handle */
-    StaticRingbuffer_t              staticBufHandle;    /*< Static ring buffer handle */
 } xplrBluetooth_config_t;
 
+typedef struct xplrBluetooth_stream_stats_type {
+    uint32_t                        msgsQueued;         /*< Messages accepted by the stream */
+    uint32_t                        msgsDropped;        /*< Messages dropped because the stream buffer was full */
+    uint32_t                        bytesSent;          /*< Bytes written to the connected devices */
+    uint32_t                        writeErrors;        /*< Batches that failed to be written to a device */
+} xplrBluetooth_stream_stats_t;
+
 typedef struct xplrBluetooth_diagnostics_type {
     xplrBluetooth_conn_state_t      state;              /*< State of connected device */
     int8_t                          rssi;               /*< RSSI of connected device */
@@ -92,13 +97,15 @@ typedef struct xplrBluetooth_connected_device_type {
     bool                            msgAvailable;       /*< True if message is available from this connected device */
     bool                            connected;          /*< True if device is connected (data invalid if this flag is false) */
     char                            *msg;               /*< Device RX message buffer */
+    RingbufHandle_t                 rxBuffer;           /*< Device RX ring buffer handle */
+    StaticRingbuffer_t              rxStaticBufHandle;  /*< Device RX static ring buffer handle */
+    uint8_t                         rxBufferStorage[XPLRBLUETOOTH_DEVICE_RX_BUFFER_SIZE];  /*< Static memory allocation for device RX ring buffer */
 } xplrBluetooth_connected_device_t;
 
 typedef struct xplrBluetooth_client_type {
     xplrBluetooth_connected_device_t    devices[XPLRBLUETOOTH_NUMOF_DEVICES];   /*< Array containing the currently connected devices*/
     xplrBluetooth_config_t              configuration;                          /*< Configuration struct */
     xplrBluetooth_conn_state_t          state;                                  /*< State of the HPGLib Bluetooth client FSM */
-    uint8_t                             buffer[XPLRBLUETOOTH_RX_BUFFER_SIZE];   /*< Static memory allocation for ring buffer*/
 } xplrBluetooth_client_t;
 // *INDENT-ON*
 #ifdef __cplusplus
@@ -21,8 +21,10 @@
  */
 
 #include "string.h"
+#include "stdlib.h"
 #include "esp_task_wdt.h"
 #include "xplr_com.h"
+#include "xplr_nvs.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -38,6 +40,30 @@
 #define XPLRCOM_CONSOLE(message, ...) do{} while(0)
 #endif
 
+/**
+ * Stack and priority of the background network scan task.
+ */
+#define XPLRCOM_CELL_SCAN_TASK_STACK    (4 * 1024)
+#define XPLRCOM_CELL_SCAN_TASK_PRIO     (3)
+
+/**
+ * Polling period and max retries when waiting for a cancelled scan to exit.
+ * ubxlib checks the keep going callback about once per second.
+ */
+#define XPLRCOM_CELL_SCAN_STOP_WAIT_MS  (100)
+#define XPLRCOM_CELL_SCAN_STOP_RETRIES  (100)
+
+/**
+ * Growth factor of the retry delay unless set with xplrComCellFsmSetBackoff().
+ */
+#define XPLRCOM_CELL_BACKOFF_MULTIPLIER (2U)
+
+/**
+ * NVS namespace prefix and key of the MNO/RAT/bands fingerprint.
+ */
+#define XPLRCOM_CELL_NVS_NAMESPACE      "xplrCom"
+#define XPLRCOM_CELL_NVS_KEY_PROFILE    "profileHash"
+
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
@@ -52,6 +78,22 @@ typedef struct xplrCom_type {
                                                          element 1 holds previous state */
     int8_t                          retries;
     bool                            cntrlRestart;
+    xplrCom_cell_scan_t             scan;           /**< results of the last finished network scan */
+    xplrCom_cell_scan_t             scanWork;       /**< results of the running network scan */
+    volatile xplrCom_cell_scan_state_t scanState;   /**< state of the network scan */
+    volatile bool                   scanCancel;     /**< abort the running network scan */
+    TaskHandle_t                    scanTask;       /**< background network scan task */
+    SemaphoreHandle_t               scanMutex;      /**< guards scan, scanState and scanTask */
+    xplrCom_cell_backoff_t          backoff;        /**< retry policy of the connection fsm */
+    xplrCom_cell_fsmStats_t         fsmStats;       /**< connection fsm timing and retries */
+    int64_t                         stateEnter;     /**< time the current fsm state was entered */
+    int64_t                         connectStart;   /**< time the device open started */
+    int64_t                         retryAt;        /**< time the failed step may run again */
+    uint32_t                        retryDelayMs;   /**< delay before the next retry */
+    uint32_t                        profileHash;    /**< fingerprint of the MNO/RAT/bands applied to the module */
+    bool                            profileSkipped; /**< MNO/RAT/bands setup skipped in this connection */
+    bool                            nvsReady;       /**< nvs holding profileHash is initialized */
+    xplrNvs_t                       nvs;            /**< storage of profileHash */
 } xplrCom_t;
 
 /* ----------------------------------------------------------------
@@ -110,12 +152,27 @@ static xplrCom_error_t cellDvcSetBands(int8_t index);
 static xplrCom_error_t cellDvcRegister(int8_t index);
 static void            cellDvcGetNetworkInfo(int8_t index, xplrCom_cell_netInfo_t *info);
 static void            cellConsumeRestartMsg(int8_t index);
+static xplrCom_error_t cellScanBegin(int8_t index);
+static xplrCom_cell_scan_state_t cellScanRun(int8_t index);
+static void            cellScanAddResult(xplrCom_cell_scan_t *scan,
+                                         const char *name,
+                                         const char *mccMnc,
+                                         uCellNetRat_t rat);
+static void            cellScanAddSignal(int8_t index, xplrCom_cell_scan_t *scan);
+static xplrCom_error_t cellScanStop(int8_t index);
+static void            cellScanTask(void *pvParams);
+static xplrCom_error_t cellFsmRetry(int8_t index, xplrCom_error_t stepRet);
+static void            cellFsmTiming(int8_t index, xplrCom_cell_connect_t prevState);
+static uint32_t        cellProfileHash(int8_t index);
+static bool            cellProfileIsApplied(int8_t index);
+static void            cellProfileSave(int8_t index, uint32_t hash);
 
 /* ----------------------------------------------------------------
  * STATIC CALLBACK FUNCTION PROTOTYPES
  * -------------------------------------------------------------- */
 
 bool cbCellWait(void (*ptr));
+static bool cbCellScanKeepGoing(uDeviceHandle_t handler);
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTION DEFINITIONS
@@ -270,121 +327,154 @@ bool xplrComIsRstControlled(int8_t dvcProfile)
 xplrCom_error_t xplrComCellFsmConnect(int8_t dvcProfile)
 {
     xplrCom_error_t ret;
-    xplrCom_cell_connect_t *fsm = comDevices[dvcProfile].cellFsm;
+    xplrCom_t *dvc = &comDevices[dvcProfile];
+    xplrCom_cell_connect_t *fsm = dvc->cellFsm;
+    xplrCom_cell_connect_t prevState = fsm[0];
 
-    switch (fsm[0]) {
-        case XPLR_COM_CELL_CONNECT_INIT:
-        case XPLR_COM_CELL_CONNECT_OPENDEVICE:
-            fsm[1] = fsm[0]; /* hold current state */
-            ret = cellDvcOpen(dvcProfile); /* open device */
-            if (ret == XPLR_COM_OK) {
-                fsm[0] = XPLR_COM_CELL_CONNECT_SET_MNO; /* dvc open, continue with MNO */
-                XPLRCOM_CONSOLE(D, "open ok, configuring MNO");
-            } else {
-                fsm[0] = XPLR_COM_CELL_CONNECT_ERROR; /* failed to open, go to error state */
-                XPLRCOM_CONSOLE(E, "open failed with code: %d", ret);
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT_SET_MNO:
-            fsm[1] = fsm[0]; /* hold current state */
-            /* not all modules are capable to change MNO profile, handle it */
-            ret = cellDvcSetMno(dvcProfile); /* check if MNO needs to be changed */
-            if (ret == XPLR_COM_OK) {
-                fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* MNO ok or could not be changed, check dvc rdy */
-                XPLRCOM_CONSOLE(D, "MNO ok or cannot be changed, checking device");
-            } else {
-                fsm[0] = XPLR_COM_CELL_CONNECT_ERROR; /* failed to set or read MNO, go to error state */
-                XPLRCOM_CONSOLE(E, "MNO Set failed with code: %d", ret);
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT_SET_RAT:
-            fsm[1] = fsm[0]; /* hold current state */
-            ret = cellDvcSetRat(dvcProfile); /* update dvc RAT if needed */
-            if (ret == XPLR_COM_OK) {
-                fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* RAT updated, check dvc rdy */
-                XPLRCOM_CONSOLE(D, "RAT ok, checking device");
-            } else {
-                fsm[0] = XPLR_COM_CELL_CONNECT_ERROR; /* failed to set / read RAT list, go to error state */
-                XPLRCOM_CONSOLE(E, "RAT Set failed with code: %d", ret);
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT_SET_BANDS:
-            fsm[1] = fsm[0]; /* hold current state */
-            ret = cellDvcSetBands(dvcProfile); /* update dvc bands if needed */
-            if (ret == XPLR_COM_OK) {
-                fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* Bands updated, check dvc rdy */
-                XPLRCOM_CONSOLE(D, "bands ok, checking device");
-            } else {
-                fsm[0] = XPLR_COM_CELL_CONNECT_ERROR; /* failed to set / read band list, go to error state */
-                XPLRCOM_CONSOLE(E,  "bands Set failed with code: %d", ret);
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT:
-            fsm[1] = fsm[0]; /* hold current state */
-            ret = cellDvcRegister(dvcProfile); /* register dvc to cellular carrier */
-            if (ret == XPLR_COM_OK) {
-                fsm[0] = XPLR_COM_CELL_CONNECT_OK; /* dvc connected to network, switch to connected */
-                XPLRCOM_CONSOLE(D, "dvc interface up, switching to connected");
-            } else {
-                fsm[0] = XPLR_COM_CELL_CONNECT_ERROR; /* failed to set / read band list, go to error state */
-                XPLRCOM_CONSOLE(E, "dvc register failed with code: %d", ret);
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT_CHECK_READY:
-            /* performing certain configuration actions may require a reboot from the module.
-             * rebooting phase may take several seconds thus it is suggested to check if device is ready
-             * by calling the cellDvcCheckReady() function. */
-            ret = cellDvcCheckReady(dvcProfile);
-            if (ret == XPLR_COM_OK) {
-                if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_MNO) { /* dvc rdy after mno set reboot */
-                    fsm[1] = fsm[0]; /* hold current state */
-                    fsm[0] = XPLR_COM_CELL_CONNECT_SET_RAT;
-                    XPLRCOM_CONSOLE(D, "dvc rdy, setting RAT(s)...");
-                } else if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_RAT) { /* dvc rdy after rat set reboot */
-                    fsm[1] = fsm[0]; /* hold current state */
-                    fsm[0] = XPLR_COM_CELL_CONNECT_SET_BANDS;
-                    XPLRCOM_CONSOLE(D, "dvc rdy, setting Band(s)...");
-                } else if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_BANDS) { /* dvc rdy after bands set reboot */
-                    fsm[1] = fsm[0]; /* hold current state */
+    if ((dvc->retryAt != 0) && (esp_timer_get_time() < dvc->retryAt)) {
+        ret = XPLR_COM_BUSY; /* failed step backing off, try again later */
+    } else {
+        switch (fsm[0]) {
+            case XPLR_COM_CELL_CONNECT_INIT:
+            case XPLR_COM_CELL_CONNECT_OPENDEVICE:
+                if (dvc->retries == 0) {
+                    dvc->connectStart = esp_timer_get_time();
+                }
+                fsm[1] = fsm[0]; /* hold current state */
+                ret = cellDvcOpen(dvcProfile); /* open device */
+                if (ret != XPLR_COM_OK) {
+                    XPLRCOM_CONSOLE(E, "open failed with code: %d", ret);
+                    ret = cellFsmRetry(dvcProfile, ret);
+                } else if (cellProfileIsApplied(dvcProfile)) {
+                    /* MNO, RAT and bands unchanged since they were last applied, register straight away */
+                    dvc->profileSkipped = true;
+                    dvc->fsmStats.profileSkips++;
                     fsm[0] = XPLR_COM_CELL_CONNECT;
-                    XPLRCOM_CONSOLE(D, "dvc rdy, scanning networks...");
+                    XPLRCOM_CONSOLE(D, "open ok, profile already applied, registering");
                 } else {
-                    /* ok... we should not be here. actually you should never be here.
-                     * just in case, try to recover by running again previous state */
-                    fsm[0] = fsm[1];
-                    XPLRCOM_CONSOLE(E,
-                                    "dvc rdy after unknown conditions, running previous state: %d",
-                                    (int32_t)fsm[1]);
+                    dvc->profileSkipped = false;
+                    fsm[0] = XPLR_COM_CELL_CONNECT_SET_MNO; /* dvc open, continue with MNO */
+                    XPLRCOM_CONSOLE(D, "open ok, configuring MNO");
                 }
-            } else { /* dvc busy, retry */
-                // TODO: add max retries
-                XPLRCOM_CONSOLE(W, "dvc busy, check again: %d", ret);
-                ret = XPLR_COM_OK; /* mask return value from busy to ok*/
-            }
-            break;
-        case XPLR_COM_CELL_CONNECT_OK:
-            cellDvcGetNetworkInfo(dvcProfile, &currentNetInfo);
-            fsm[1] = fsm[0]; /* hold current state */
-            fsm[0] = XPLR_COM_CELL_CONNECTED;
-            XPLRCOM_CONSOLE(I, "dvc connected!");
-            ret = XPLR_COM_OK;
-            break;
-        case XPLR_COM_CELL_CONNECTED:
-            ret = XPLR_COM_OK;
-            break;
-        case XPLR_COM_CELL_CONNECT_TIMEOUT:
-        case XPLR_COM_CELL_CONNECT_ERROR:
-            if (fsm[0] != fsm[1]) { /* print error msg once*/
+                break;
+            case XPLR_COM_CELL_CONNECT_SET_MNO:
+                fsm[1] = fsm[0]; /* hold current state */
+                /* not all modules are capable to change MNO profile, handle it */
+                ret = cellDvcSetMno(dvcProfile); /* check if MNO needs to be changed */
+                if (ret == XPLR_COM_OK) {
+                    fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* MNO ok or could not be changed, check dvc rdy */
+                    XPLRCOM_CONSOLE(D, "MNO ok or cannot be changed, checking device");
+                } else {
+                    XPLRCOM_CONSOLE(E, "MNO Set failed with code: %d", ret);
+                    ret = cellFsmRetry(dvcProfile, ret); /* failed to set or read MNO */
+                }
+                break;
+            case XPLR_COM_CELL_CONNECT_SET_RAT:
+                fsm[1] = fsm[0]; /* hold current state */
+                ret = cellDvcSetRat(dvcProfile); /* update dvc RAT if needed */
+                if (ret == XPLR_COM_OK) {
+                    fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* RAT updated, check dvc rdy */
+                    XPLRCOM_CONSOLE(D, "RAT ok, checking device");
+                } else {
+                    XPLRCOM_CONSOLE(E, "RAT Set failed with code: %d", ret);
+                    ret = cellFsmRetry(dvcProfile, ret); /* failed to set / read RAT list */
+                }
+                break;
+            case XPLR_COM_CELL_CONNECT_SET_BANDS:
                 fsm[1] = fsm[0]; /* hold current state */
-                XPLRCOM_CONSOLE(E, "dvc %d in error!", dvcProfile);
+                ret = cellDvcSetBands(dvcProfile); /* update dvc bands if needed */
+                if (ret == XPLR_COM_OK) {
+                    fsm[0] = XPLR_COM_CELL_CONNECT_CHECK_READY; /* Bands updated, check dvc rdy */
+                    XPLRCOM_CONSOLE(D, "bands ok, checking device");
+                } else {
+                    XPLRCOM_CONSOLE(E,  "bands Set failed with code: %d", ret);
+                    ret = cellFsmRetry(dvcProfile, ret); /* failed to set / read band list */
+                }
+                break;
+            case XPLR_COM_CELL_CONNECT:
+                fsm[1] = fsm[0]; /* hold current state */
+                ret = cellDvcRegister(dvcProfile); /* register dvc to cellular carrier */
+                if (ret == XPLR_COM_OK) {
+                    fsm[0] = XPLR_COM_CELL_CONNECT_OK; /* dvc connected to network, switch to connected */
+                    XPLRCOM_CONSOLE(D, "dvc interface up, switching to connected");
+                } else {
+                    XPLRCOM_CONSOLE(E, "dvc register failed with code: %d", ret);
+                    ret = cellFsmRetry(dvcProfile, ret);
+                    if ((fsm[0] == XPLR_COM_CELL_CONNECT_ERROR) && dvc->profileSkipped) {
+                        /* the module may not hold the profile anymore, negotiate it on the next attempt */
+                        cellProfileSave(dvcProfile, 0);
+                    }
+                }
+                break;
+            case XPLR_COM_CELL_CONNECT_CHECK_READY:
+                /* performing certain configuration actions may require a reboot from the module.
+                 * rebooting phase may take several seconds thus it is suggested to check if device is ready
+                 * by calling the cellDvcCheckReady() function. */
+                ret = cellDvcCheckReady(dvcProfile);
+                if (ret == XPLR_COM_OK) {
+                    if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_MNO) { /* dvc rdy after mno set reboot */
+                        fsm[1] = fsm[0]; /* hold current state */
+                        fsm[0] = XPLR_COM_CELL_CONNECT_SET_RAT;
+                        XPLRCOM_CONSOLE(D, "dvc rdy, setting RAT(s)...");
+                    } else if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_RAT) { /* dvc rdy after rat set reboot */
+                        fsm[1] = fsm[0]; /* hold current state */
+                        fsm[0] = XPLR_COM_CELL_CONNECT_SET_BANDS;
+                        XPLRCOM_CONSOLE(D, "dvc rdy, setting Band(s)...");
+                    } else if (fsm[1] == XPLR_COM_CELL_CONNECT_SET_BANDS) { /* dvc rdy after bands set reboot */
+                        fsm[1] = fsm[0]; /* hold current state */
+                        fsm[0] = XPLR_COM_CELL_CONNECT;
+                        XPLRCOM_CONSOLE(D, "dvc rdy, scanning networks...");
+                    } else {
+                        /* ok... we should not be here. actually you should never be here.
+                         * just in case, try to recover by running again previous state */
+                        fsm[0] = fsm[1];
+                        XPLRCOM_CONSOLE(E,
+                                        "dvc rdy after unknown conditions, running previous state: %d",
+                                        (int32_t)fsm[1]);
+                    }
+                } else if ((esp_timer_get_time() - dvc->stateEnter) >
+                           ((int64_t)dvc->backoff.readyTimeoutMs * 1000)) {
+                    fsm[1] = fsm[0];
+                    fsm[0] = XPLR_COM_CELL_CONNECT_TIMEOUT;
+                    dvc->fsmStats.timeouts++;
+                    ret = XPLR_COM_ERROR;
+                    XPLRCOM_CONSOLE(E, "dvc still busy after %ums, timing out", dvc->backoff.readyTimeoutMs);
+                } else { /* dvc busy, retry */
+                    XPLRCOM_CONSOLE(W, "dvc busy, check again: %d", ret);
+                    ret = XPLR_COM_OK; /* mask return value from busy to ok*/
+                }
+                break;
+            case XPLR_COM_CELL_CONNECT_OK:
                 cellDvcGetNetworkInfo(dvcProfile, &currentNetInfo);
-            }
-            ret = XPLR_COM_ERROR;
-            break;
+                if (!dvc->profileSkipped) {
+                    cellProfileSave(dvcProfile, cellProfileHash(dvcProfile));
+                }
+                dvc->fsmStats.connects++;
+                dvc->fsmStats.lastConnectMs = (uint32_t)((esp_timer_get_time() - dvc->connectStart) / 1000);
+                fsm[1] = fsm[0]; /* hold current state */
+                fsm[0] = XPLR_COM_CELL_CONNECTED;
+                XPLRCOM_CONSOLE(I, "dvc connected in %ums!", dvc->fsmStats.lastConnectMs);
+                ret = XPLR_COM_OK;
+                break;
+            case XPLR_COM_CELL_CONNECTED:
+                ret = XPLR_COM_OK;
+                break;
+            case XPLR_COM_CELL_CONNECT_TIMEOUT:
+            case XPLR_COM_CELL_CONNECT_ERROR:
+                if (fsm[0] != fsm[1]) { /* print error msg once*/
+                    fsm[1] = fsm[0]; /* hold current state */
+                    XPLRCOM_CONSOLE(E, "dvc %d in error!", dvcProfile);
+                    cellDvcGetNetworkInfo(dvcProfile, &currentNetInfo);
+                }
+                ret = XPLR_COM_ERROR;
+                break;
 
-        default:
-            ret = XPLR_COM_ERROR;
-            break;
+            default:
+                ret = XPLR_COM_ERROR;
+                break;
+        }
+
+        cellFsmTiming(dvcProfile, prevState);
     }
 
     return ret;
@@ -394,6 +484,7 @@ xplrCom_error_t xplrComCellFsmConnectReset(int8_t dvcProfile)
 {
     xplrCom_error_t ret;
     xplrCom_cell_connect_t *fsm = comDevices[dvcProfile].cellFsm;
+    xplrCom_cell_connect_t prevState = fsm[0];
 
     if ((fsm[0] == XPLR_COM_CELL_CONNECT_ERROR) || (fsm[0] == XPLR_COM_CELL_CONNECT_TIMEOUT)) {
         /* reseting from erroneous state, perform POR */
@@ -431,6 +522,8 @@ xplrCom_error_t xplrComCellFsmConnectReset(int8_t dvcProfile)
         XPLRCOM_CONSOLE(W, "warning, trying to reset from state [%d]", fsm[0]);
     }
 
+    cellFsmTiming(dvcProfile, prevState);
+
     return ret;
 }
 
@@ -439,51 +532,175 @@ xplrCom_cell_connect_t xplrComCellFsmConnectGetState(int8_t dvcProfile)
     return comDevices[dvcProfile].cellFsm[0];
 }
 
+xplrCom_error_t xplrComCellFsmSetBackoff(int8_t dvcProfile, const xplrCom_cell_backoff_t *backoff)
+{
+    xplrCom_error_t ret;
+
+    if ((backoff == NULL) || (backoff->multiplier == 0) ||
+        (backoff->initialDelayMs > backoff->maxDelayMs)) {
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "invalid backoff policy");
+    } else {
+        memcpy(&comDevices[dvcProfile].backoff, backoff, sizeof(xplrCom_cell_backoff_t));
+        ret = XPLR_COM_OK;
+    }
+
+    return ret;
+}
+
+xplrCom_error_t xplrComCellFsmGetStats(int8_t dvcProfile, xplrCom_cell_fsmStats_t *stats)
+{
+    xplrCom_error_t ret;
+
+    if (stats == NULL) {
+        ret = XPLR_COM_ERROR;
+    } else {
+        memcpy(stats, &comDevices[dvcProfile].fsmStats, sizeof(xplrCom_cell_fsmStats_t));
+        ret = XPLR_COM_OK;
+    }
+
+    return ret;
+}
+
+void xplrComCellFsmClearStats(int8_t dvcProfile)
+{
+    memset(&comDevices[dvcProfile].fsmStats, 0, sizeof(xplrCom_cell_fsmStats_t));
+}
+
+void xplrComCellForgetProfile(int8_t dvcProfile)
+{
+    cellProfileSave(dvcProfile, 0);
+}
+
 void xplrComCellNetworkInfo(int8_t dvcProfile, xplrCom_cell_netInfo_t *info)
 {
     cellDvcGetNetworkInfo(dvcProfile, &currentNetInfo);
     memcpy(info, &currentNetInfo, sizeof(xplrCom_cell_netInfo_t));
 }
 
-int16_t xplrComCellNetworkScan(int8_t dvcProfile, char *scanBuff)
+int16_t xplrComCellNetworkScan(int8_t dvcProfile, char *scanBuff, size_t size)
 {
-    int32_t ubxlibRet;
-    int8_t found;
-    uDeviceHandle_t dvcHandler = comDevices[dvcProfile].handler;
-    char buff[64] = {0};
+    xplrCom_t *dvc = &comDevices[dvcProfile];
+    xplrCom_cell_scanResult_t *result;
+    size_t len = 0;
+    int written;
     int16_t ret;
 
-    found = uCellNetScanGetFirst(dvcHandler, NULL, 0, buff, NULL, NULL);
-    XPLRCOM_CONSOLE(D, "Networks found: %d\n", found);
-    XPLRCOM_CONSOLE(D, "### %d: network: %s\n", found, buff);
-    strcat(scanBuff, buff);
-    ret = found;
-    for (int8_t i = 0; i < found; i++) {
-        ubxlibRet = uCellNetScanGetNext(dvcHandler, NULL, 0, buff, NULL);
-        strcat(scanBuff, buff);
-        XPLRCOM_CONSOLE(D, "### %d: network: %s\n", ubxlibRet, buff);
-        if (ubxlibRet < 0) {
-            uCellNetScanGetLast(dvcHandler);
-            break;
+    if ((scanBuff == NULL) || (size == 0)) {
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "invalid scan buffer");
+    } else if (cellScanBegin(dvcProfile) != XPLR_COM_OK) {
+        ret = XPLR_COM_ERROR;
+    } else if (cellScanRun(dvcProfile) != XPLR_COM_CELL_SCAN_DONE) {
+        ret = XPLR_COM_ERROR;
+    } else {
+        scanBuff[0] = 0;
+        ret = dvc->scanWork.numOfResults;
+        for (uint8_t i = 0; i < dvc->scanWork.numOfResults; i++) {
+            result = &dvc->scanWork.results[i];
+            written = snprintf(&scanBuff[len], size - len, "%s %s\n", result->mccMnc, result->operatorName);
+            if ((written < 0) || ((size_t)written >= (size - len))) {
+                /* do not leave a partial line behind */
+                scanBuff[len] = 0;
+                XPLRCOM_CONSOLE(W, "scan buffer full, %d of %d networks written", i, ret);
+                break;
+            } else {
+                len += written;
+            }
         }
     }
 
     return ret;
 }
 
+xplrCom_error_t xplrComCellNetworkScanStart(int8_t dvcProfile)
+{
+    xplrCom_t *dvc = &comDevices[dvcProfile];
+    BaseType_t xRet;
+    xplrCom_error_t ret;
+
+    ret = cellScanBegin(dvcProfile);
+    if (ret == XPLR_COM_OK) {
+        xSemaphoreTake(dvc->scanMutex, portMAX_DELAY);
+        xRet = xTaskCreate(cellScanTask,
+                           "cellScanTask",
+                           XPLRCOM_CELL_SCAN_TASK_STACK,
+                           (void *)(intptr_t)dvcProfile,
+                           XPLRCOM_CELL_SCAN_TASK_PRIO,
+                           &dvc->scanTask);
+        if (xRet != pdPASS) {
+            dvc->scanTask = NULL;
+            dvc->scanState = XPLR_COM_CELL_SCAN_ERROR;
+            ret = XPLR_COM_ERROR;
+            XPLRCOM_CONSOLE(E, "could not create the scan task");
+        } else {
+            XPLRCOM_CONSOLE(D, "network scan started");
+        }
+        xSemaphoreGive(dvc->scanMutex);
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+xplrCom_error_t xplrComCellNetworkScanCancel(int8_t dvcProfile)
+{
+    return cellScanStop(dvcProfile);
+}
+
+xplrCom_cell_scan_state_t xplrComCellNetworkScanGetState(int8_t dvcProfile)
+{
+    return comDevices[dvcProfile].scanState;
+}
+
+xplrCom_error_t xplrComCellNetworkScanGetResults(int8_t dvcProfile,
+                                                 xplrCom_cell_scan_t *scan,
+                                                 uint32_t maxAgeS)
+{
+    xplrCom_t *dvc = &comDevices[dvcProfile];
+    xplrCom_error_t ret;
+
+    if ((scan == NULL) || (dvc->scanMutex == NULL)) {
+        ret = XPLR_COM_ERROR;
+    } else {
+        xSemaphoreTake(dvc->scanMutex, portMAX_DELAY);
+        if (dvc->scan.timestamp == 0) {
+            ret = XPLR_COM_ERROR;
+            XPLRCOM_CONSOLE(W, "no scan results available");
+        } else if ((maxAgeS > 0) &&
+                   (MICROTOSEC(esp_timer_get_time() - dvc->scan.timestamp) > maxAgeS)) {
+            ret = XPLR_COM_ERROR;
+            XPLRCOM_CONSOLE(W, "scan results older than %us", maxAgeS);
+        } else {
+            memcpy(scan, &dvc->scan, sizeof(xplrCom_cell_scan_t));
+            ret = XPLR_COM_OK;
+        }
+        xSemaphoreGive(dvc->scanMutex);
+    }
+
+    return ret;
+}
+
 xplrCom_error_t xplrComCellPowerDown(int8_t dvcProfile)
 {
     int32_t ubxlibRet;
     uDeviceHandle_t dvcHandler = comDevices[dvcProfile].handler;
     xplrCom_error_t ret;
 
-    ubxlibRet = uDeviceClose(dvcHandler, true);
-    if (ubxlibRet == 0) {
-        ret = XPLR_COM_OK;
-        XPLRCOM_CONSOLE(D, "dvc powered down, ok");
-    } else {
+    if (cellScanStop(dvcProfile) != XPLR_COM_OK) {
+        /* the scan task is still in AT+COPS=? on this handle, do not close it */
         ret = XPLR_COM_ERROR;
-        XPLRCOM_CONSOLE(E, "error (%d) powering down dvc", ubxlibRet);
+        XPLRCOM_CONSOLE(E, "dvc not powered down, its network scan is still running");
+    } else {
+        ubxlibRet = uDeviceClose(dvcHandler, true);
+        if (ubxlibRet == 0) {
+            ret = XPLR_COM_OK;
+            XPLRCOM_CONSOLE(D, "dvc powered down, ok");
+        } else {
+            ret = XPLR_COM_ERROR;
+            XPLRCOM_CONSOLE(E, "error (%d) powering down dvc", ubxlibRet);
+        }
     }
 
     return ret;
@@ -492,10 +709,12 @@ xplrCom_error_t xplrComCellPowerDown(int8_t dvcProfile)
 void xplrComCellPowerResume(int8_t dvcProfile)
 {
     xplrCom_cell_connect_t *fsm = comDevices[dvcProfile].cellFsm;
+    xplrCom_cell_connect_t prevState = fsm[0];
 
     /* power down can be triggered from any state of xplrComCellFsmConnect.
      * resuming can be achieved by hot reseting the fsm state of xplrComCellFsmConnect(). */
     fsm[0] = XPLR_COM_CELL_CONNECT_INIT;
+    cellFsmTiming(dvcProfile, prevState);
     XPLRCOM_CONSOLE(D, "resuming power to device...");
 }
 
@@ -593,9 +812,21 @@ xplrCom_error_t dvcRemoveSlot(int8_t index)
     xplrCom_error_t ret;
 
     if ((index < XPLRCOM_NUMOF_DEVICES) && (&comDevices[index] != NULL)) {
-        memset(&comDevices[index], (int)NULL, sizeof(xplrCom_t));
-        ret = XPLR_COM_OK;
-        XPLRCOM_CONSOLE(D, "slot %d removed", index);
+        if (cellScanStop(index) != XPLR_COM_OK) {
+            /* the scan task still uses the slot and its mutex, keep them */
+            ret = XPLR_COM_ERROR;
+            XPLRCOM_CONSOLE(E, "slot %d kept, its network scan is still running", index);
+        } else {
+            if (comDevices[index].scanMutex != NULL) {
+                vSemaphoreDelete(comDevices[index].scanMutex);
+            }
+            if (comDevices[index].nvsReady) {
+                (void)xplrNvsDeInit(&comDevices[index].nvs);
+            }
+            memset(&comDevices[index], (int)NULL, sizeof(xplrCom_t));
+            ret = XPLR_COM_OK;
+            XPLRCOM_CONSOLE(D, "slot %d removed", index);
+        }
     } else {
         ret = XPLR_COM_ERROR;
         XPLRCOM_CONSOLE(E, "failed to remove slot %d", index);
@@ -606,12 +837,15 @@ xplrCom_error_t dvcRemoveSlot(int8_t index)
 
 xplrCom_error_t dvcRemoveAllSlots(void)
 {
+    xplrCom_error_t ret = XPLR_COM_OK;
+
     for (int8_t i = 0; i < XPLRCOM_NUMOF_DEVICES; i++) {
-        memset(&comDevices[i], (int)NULL, sizeof(xplrCom_t));
-        XPLRCOM_CONSOLE(D, "slot %d removed", i);
+        if (dvcRemoveSlot(i) != XPLR_COM_OK) {
+            ret = XPLR_COM_ERROR;
+        }
     }
 
-    return XPLR_COM_OK;
+    return ret;
 }
 
 xplrCom_error_t cellSetConfig(xplrCom_cell_config_t *cfg)
@@ -632,6 +866,37 @@ xplrCom_error_t cellSetConfig(xplrCom_cell_config_t *cfg)
             comDevices[dvcProfile].cellSettings = cfg;
             comDevices[dvcProfile].cellFsm[0] = XPLR_COM_CELL_CONNECT_INIT;
             comDevices[dvcProfile].cellFsm[1] = XPLR_COM_CELL_CONNECT_INIT;
+            if (comDevices[dvcProfile].scanMutex == NULL) {
+                comDevices[dvcProfile].scanMutex = xSemaphoreCreateMutex();
+            }
+            if (comDevices[dvcProfile].backoff.multiplier == 0) {
+                /* not set by the user */
+                comDevices[dvcProfile].backoff.maxRetries = XPLRCOM_CELL_RETRY_MAX;
+                comDevices[dvcProfile].backoff.multiplier = XPLRCOM_CELL_BACKOFF_MULTIPLIER;
+                comDevices[dvcProfile].backoff.initialDelayMs = XPLRCOM_CELL_BACKOFF_INITIAL_MS;
+                comDevices[dvcProfile].backoff.maxDelayMs = XPLRCOM_CELL_BACKOFF_MAX_MS;
+                comDevices[dvcProfile].backoff.readyTimeoutMs = XPLRCOM_CELL_READY_TIMEOUT_MS;
+            }
+            comDevices[dvcProfile].retries = 0;
+            comDevices[dvcProfile].retryAt = 0;
+            comDevices[dvcProfile].retryDelayMs = comDevices[dvcProfile].backoff.initialDelayMs;
+            comDevices[dvcProfile].stateEnter = esp_timer_get_time();
+#if (1 == XPLRCOM_CELL_PROFILE_CACHE_ACTIVE)
+            if (!comDevices[dvcProfile].nvsReady) {
+                char nvsNamespace[NVS_KEY_NAME_MAX_SIZE];
+                snprintf(nvsNamespace, sizeof(nvsNamespace), "%s%d", XPLRCOM_CELL_NVS_NAMESPACE, dvcProfile);
+                if (xplrNvsInit(&comDevices[dvcProfile].nvs, nvsNamespace) == XPLR_NVS_OK) {
+                    comDevices[dvcProfile].nvsReady = true;
+                    if (xplrNvsReadU32(&comDevices[dvcProfile].nvs,
+                                       XPLRCOM_CELL_NVS_KEY_PROFILE,
+                                       &comDevices[dvcProfile].profileHash) != XPLR_NVS_OK) {
+                        comDevices[dvcProfile].profileHash = 0;
+                    }
+                } else {
+                    XPLRCOM_CONSOLE(W, "no nvs, MNO/RAT/bands will be checked on every connection");
+                }
+            }
+#endif
             /* config rest of settings in device config*/
             comDevices[dvcProfile].deviceSettings.deviceType = U_DEVICE_TYPE_CELL;
             comDevices[dvcProfile].deviceNetwork = U_NETWORK_TYPE_CELL;
@@ -695,7 +960,11 @@ xplrCom_error_t cellDvcReset(int8_t index, bool por)
     xplrCom_cell_config_t  *cellCfg = comDevices[index].cellSettings;
     xplrCom_error_t ret;
 
-    if (por) {
+    if (cellScanStop(index) != XPLR_COM_OK) {
+        /* the scan cannot outlive the device handle, keep the device as it is */
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "dvc not reset, its network scan is still running");
+    } else if (por) {
         ubxlibRet = uDeviceClose(dvcHandler, true); /* dvc close and power off */
         if (ubxlibRet == 0) {
             XPLRCOM_CONSOLE(D, "dvc powered down, ok");
@@ -939,6 +1208,323 @@ static void cellConsumeRestartMsg(int8_t index)
     comDevices[index].cntrlRestart = false;
 }
 
+/**
+ * Marks a network scan as running, unless one already is.
+ */
+static xplrCom_error_t cellScanBegin(int8_t index)
+{
+    xplrCom_t *dvc = &comDevices[index];
+    xplrCom_error_t ret;
+
+    if ((dvc->handler == NULL) || (dvc->scanMutex == NULL)) {
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "dvc %d not open, cannot scan", index);
+    } else {
+        xSemaphoreTake(dvc->scanMutex, portMAX_DELAY);
+        if ((dvc->scanState == XPLR_COM_CELL_SCAN_RUNNING) || (dvc->scanTask != NULL)) {
+            ret = XPLR_COM_BUSY;
+            XPLRCOM_CONSOLE(W, "network scan already running");
+        } else {
+            dvc->scanState = XPLR_COM_CELL_SCAN_RUNNING;
+            dvc->scanCancel = false;
+            ret = XPLR_COM_OK;
+        }
+        xSemaphoreGive(dvc->scanMutex);
+    }
+
+    return ret;
+}
+
+/**
+ * Runs a network scan, blocking until the module reports the networks
+ * or the scan is cancelled. Finished results replace the cached ones.
+ */
+static xplrCom_cell_scan_state_t cellScanRun(int8_t index)
+{
+    xplrCom_t *dvc = &comDevices[index];
+    xplrCom_cell_scan_t *work = &dvc->scanWork;
+    uDeviceHandle_t dvcHandler = dvc->handler;
+    char name[U_CELL_NET_MAX_NAME_LENGTH_BYTES];
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES];
+    uCellNetRat_t rat;
+    int32_t found;
+    int32_t ubxlibRet;
+    int64_t start = esp_timer_get_time();
+    xplrCom_cell_scan_state_t ret;
+
+    memset(work, 0, sizeof(xplrCom_cell_scan_t));
+    memset(name, 0, sizeof(name));
+    memset(mccMnc, 0, sizeof(mccMnc));
+    found = uCellNetScanGetFirst(dvcHandler, name, sizeof(name), mccMnc, &rat, cbCellScanKeepGoing);
+    ubxlibRet = found;
+    for (int32_t i = 0; (i < found) && (ubxlibRet >= 0); i++) {
+        if (i > 0) {
+            ubxlibRet = uCellNetScanGetNext(dvcHandler, name, sizeof(name), mccMnc, &rat);
+        }
+        if (ubxlibRet < 0) {
+            XPLRCOM_CONSOLE(W, "error (%d) reading network %d of %d", ubxlibRet, i, found);
+        } else if (work->numOfResults < XPLRCOM_CELL_SCAN_MAX_RESULTS) {
+            cellScanAddResult(work, name, mccMnc, rat);
+        } else {
+            work->truncated = true;
+            XPLRCOM_CONSOLE(W, "%d networks found, keeping the first %d",
+                            found, XPLRCOM_CELL_SCAN_MAX_RESULTS);
+            break;
+        }
+    }
+    uCellNetScanGetLast(dvcHandler); /* free what ubxlib still holds */
+
+    if (dvc->scanCancel) {
+        ret = XPLR_COM_CELL_SCAN_CANCELLED;
+        XPLRCOM_CONSOLE(W, "network scan cancelled");
+    } else if (found < 0) {
+        ret = XPLR_COM_CELL_SCAN_ERROR;
+        XPLRCOM_CONSOLE(E, "network scan failed with code %d", found);
+    } else {
+        cellScanAddSignal(index, work);
+        work->timestamp = esp_timer_get_time();
+        work->durationMs = (uint32_t)((work->timestamp - start) / 1000);
+        ret = XPLR_COM_CELL_SCAN_DONE;
+        XPLRCOM_CONSOLE(D, "%d networks found in %ums", found, work->durationMs);
+    }
+
+    xSemaphoreTake(dvc->scanMutex, portMAX_DELAY);
+    if (ret == XPLR_COM_CELL_SCAN_DONE) {
+        memcpy(&dvc->scan, work, sizeof(xplrCom_cell_scan_t));
+    } else {
+        // do nothing
+    }
+    dvc->scanState = ret;
+    xSemaphoreGive(dvc->scanMutex);
+
+    return ret;
+}
+
+static void cellScanAddResult(xplrCom_cell_scan_t *scan,
+                              const char *name,
+                              const char *mccMnc,
+                              uCellNetRat_t rat)
+{
+    xplrCom_cell_scanResult_t *result = &scan->results[scan->numOfResults];
+    char mcc[4] = {0};
+
+    memset(result, 0, sizeof(xplrCom_cell_scanResult_t));
+    strncpy(result->operatorName, name, sizeof(result->operatorName) - 1);
+    strncpy(result->mccMnc, mccMnc, sizeof(result->mccMnc) - 1);
+    /* MCC is always 3 digits, MNC is the remaining 2 or 3 */
+    if (strlen(result->mccMnc) > 3) {
+        memcpy(mcc, result->mccMnc, 3);
+        result->Mcc = atoi(mcc);
+        result->Mnc = atoi(&result->mccMnc[3]);
+    } else {
+        XPLRCOM_CONSOLE(W, "malformed MCC/MNC [%s]", result->mccMnc);
+    }
+    result->rat = rat;
+    scan->numOfResults++;
+    XPLRCOM_CONSOLE(D, "network %d: %s [%s] %s", scan->numOfResults, result->operatorName,
+                    result->mccMnc, ratStr[rat]);
+}
+
+/**
+ * The scan reports no signal levels, those are only known for the serving cell.
+ * Mark the registered operator and attach the serving cell signal to it.
+ */
+static void cellScanAddSignal(int8_t index, xplrCom_cell_scan_t *scan)
+{
+    uDeviceHandle_t dvcHandler = comDevices[index].handler;
+    xplrCom_cell_scanResult_t *result;
+    uCellNetRat_t activeRat;
+    int32_t mcc;
+    int32_t mnc;
+    int32_t ubxlibRet;
+
+    if (uCellNetIsRegistered(dvcHandler) && (uCellNetGetMccMnc(dvcHandler, &mcc, &mnc) == 0)) {
+        activeRat = uCellNetGetActiveRat(dvcHandler);
+        ubxlibRet = uCellInfoRefreshRadioParameters(dvcHandler);
+        for (uint8_t i = 0; i < scan->numOfResults; i++) {
+            result = &scan->results[i];
+            if ((result->Mcc == mcc) && (result->Mnc == mnc) && (result->rat == activeRat)) {
+                result->registered = true;
+                if (ubxlibRet == 0) {
+                    result->rssiDbm = uCellInfoGetRssiDbm(dvcHandler);
+                    result->rsrpDbm = uCellInfoGetRsrpDbm(dvcHandler);
+                } else {
+                    XPLRCOM_CONSOLE(W, "could not read radio parameters (%d)", ubxlibRet);
+                }
+            } else {
+                // do nothing
+            }
+        }
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Cancels a running scan and waits for it to finish.
+ */
+static xplrCom_error_t cellScanStop(int8_t index)
+{
+    xplrCom_t *dvc = &comDevices[index];
+    uint8_t retries;
+    xplrCom_error_t ret;
+
+    dvc->scanCancel = true;
+    for (retries = 0;
+         ((dvc->scanTask != NULL) || (dvc->scanState == XPLR_COM_CELL_SCAN_RUNNING)) &&
+         (retries < XPLRCOM_CELL_SCAN_STOP_RETRIES);
+         retries++) {
+        vTaskDelay(pdMS_TO_TICKS(XPLRCOM_CELL_SCAN_STOP_WAIT_MS));
+    }
+
+    if ((dvc->scanTask != NULL) || (dvc->scanState == XPLR_COM_CELL_SCAN_RUNNING)) {
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "network scan did not stop");
+    } else {
+        ret = XPLR_COM_OK;
+    }
+
+    return ret;
+}
+
+/**
+ * Handles a failed connection step: retries it after a growing delay
+ * or gives up and moves the FSM to error.
+ */
+static xplrCom_error_t cellFsmRetry(int8_t index, xplrCom_error_t stepRet)
+{
+    xplrCom_t *dvc = &comDevices[index];
+    xplrCom_cell_connect_t *fsm = dvc->cellFsm;
+    xplrCom_error_t ret;
+
+    if (fsm[0] >= XPLR_COM_CELL_CONNECT_OK) {
+        dvc->fsmStats.states[fsm[0]].failures++;
+    }
+
+    if (dvc->retries < dvc->backoff.maxRetries) {
+        dvc->retries++;
+        dvc->fsmStats.retries++;
+        dvc->fsmStats.backoffMs += dvc->retryDelayMs;
+        dvc->retryAt = esp_timer_get_time() + ((int64_t)dvc->retryDelayMs * 1000);
+        XPLRCOM_CONSOLE(W, "step %d failed (%d), retry %d/%d in %ums",
+                        fsm[0], stepRet, dvc->retries, dvc->backoff.maxRetries, dvc->retryDelayMs);
+        if (dvc->retryDelayMs < (dvc->backoff.maxDelayMs / dvc->backoff.multiplier)) {
+            dvc->retryDelayMs *= dvc->backoff.multiplier;
+        } else {
+            dvc->retryDelayMs = dvc->backoff.maxDelayMs;
+        }
+        ret = XPLR_COM_BUSY;
+    } else {
+        fsm[0] = XPLR_COM_CELL_CONNECT_ERROR;
+        dvc->fsmStats.errors++;
+        ret = XPLR_COM_ERROR;
+        XPLRCOM_CONSOLE(E, "step %d failed after %d retries", fsm[1], dvc->retries);
+    }
+
+    return ret;
+}
+
+/**
+ * Accounts the time spent in a state once the FSM leaves it and
+ * restarts the retry policy for the new state.
+ */
+static void cellFsmTiming(int8_t index, xplrCom_cell_connect_t prevState)
+{
+    xplrCom_t *dvc = &comDevices[index];
+    xplrCom_cell_stateStats_t *stats;
+    int64_t now;
+    uint32_t elapsedMs;
+
+    if (dvc->cellFsm[0] != prevState) {
+        now = esp_timer_get_time();
+        if ((prevState >= XPLR_COM_CELL_CONNECT_OK) && (prevState <= XPLR_COM_CELL_CONNECTED)) {
+            stats = &dvc->fsmStats.states[prevState];
+            elapsedMs = (uint32_t)((now - dvc->stateEnter) / 1000);
+            stats->entries++;
+            stats->lastMs = elapsedMs;
+            stats->totalMs += elapsedMs;
+            if (elapsedMs > stats->maxMs) {
+                stats->maxMs = elapsedMs;
+            }
+        }
+        dvc->stateEnter = now;
+        dvc->retries = 0;
+        dvc->retryAt = 0;
+        dvc->retryDelayMs = dvc->backoff.initialDelayMs;
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * FNV-1a of the MNO, RAT list and band masks in the config.
+ */
+static uint32_t cellProfileHash(int8_t index)
+{
+    const xplrCom_cell_config_t *cfg = comDevices[index].cellSettings;
+    const uint8_t *parts[3] = {(const uint8_t *) &cfg->mno,
+                               (const uint8_t *)cfg->ratList,
+                               (const uint8_t *)cfg->bandList
+                              };
+    const size_t sizes[3] = {sizeof(cfg->mno), sizeof(cfg->ratList), sizeof(cfg->bandList)};
+    uint32_t hash = 2166136261U;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+            hash ^= parts[i][j];
+            hash *= 16777619U;
+        }
+    }
+
+    /* 0 means no profile applied */
+    return (hash != 0) ? hash : 1;
+}
+
+static bool cellProfileIsApplied(int8_t index)
+{
+    bool ret;
+
+#if (1 == XPLRCOM_CELL_PROFILE_CACHE_ACTIVE)
+    ret = (comDevices[index].profileHash != 0) &&
+          (comDevices[index].profileHash == cellProfileHash(index));
+#else
+    ret = false;
+#endif
+
+    return ret;
+}
+
+/**
+ * Remembers the profile applied to the module, 0 to forget it.
+ */
+static void cellProfileSave(int8_t index, uint32_t hash)
+{
+    xplrCom_t *dvc = &comDevices[index];
+
+    if (dvc->profileHash != hash) {
+        dvc->profileHash = hash;
+        if (dvc->nvsReady &&
+            (xplrNvsWriteU32(&dvc->nvs, XPLRCOM_CELL_NVS_KEY_PROFILE, hash) != XPLR_NVS_OK)) {
+            XPLRCOM_CONSOLE(W, "could not store the applied profile");
+        }
+    } else {
+        // do nothing
+    }
+}
+
+static void cellScanTask(void *pvParams)
+{
+    int8_t index = (int8_t)(intptr_t)pvParams;
+    xplrCom_t *dvc = &comDevices[index];
+
+    (void)cellScanRun(index);
+
+    xSemaphoreTake(dvc->scanMutex, portMAX_DELAY);
+    dvc->scanTask = NULL;
+    xSemaphoreGive(dvc->scanMutex);
+    vTaskDelete(NULL);
+}
+
 /* ----------------------------------------------------------------
  * STATIC CALLBACK FUNCTION DEFINITIONS
  * -------------------------------------------------------------- */
@@ -948,4 +1534,18 @@ bool cbCellWait(void (*ptr))
     XPLRCOM_CONSOLE(W, "cell wait callback fired");
     esp_task_wdt_reset();
     return true;
+}
+
+static bool cbCellScanKeepGoing(uDeviceHandle_t handler)
+{
+    bool ret = true;
+
+    for (int8_t i = 0; i < XPLRCOM_NUMOF_DEVICES; i++) {
+        if (comDevices[i].handler == handler) {
+            ret = !comDevices[i].scanCancel;
+            break;
+        }
+    }
+
+    return ret;
 }
\ No newline at end of file
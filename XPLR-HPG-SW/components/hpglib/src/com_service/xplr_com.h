@@ -138,6 +138,7 @@ xplrCom_error_t xplrComCellFsmConnect(int8_t dvcProfile);
  * meaning that it will power of, reconfigure the API and power back on the device.
  * Reseting from CELL_FSM_CONNECT_OK will force the device to soft reset by closing the device
  * on the ubxlib side, opening it back on and reset the xplrComCellFsmConnect() FSM to init state.
+ * A running network scan is cancelled first; if it does not stop the device is left untouched.
  *
  * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
  * @return XPLR_COM_OK on success, XPLR_COM_ERROR otherwise.
@@ -153,15 +154,97 @@ xplrCom_error_t xplrComCellFsmConnectReset(int8_t dvcProfile);
 xplrCom_cell_connect_t xplrComCellFsmConnectGetState(int8_t dvcProfile);
 
 /**
- * @brief Perform network scan.
- * Scan results are stored in scanBuff. Make sure to provide a big enough
- * buffer, typically 512b.
+ * @brief Set the retry policy of xplrComCellFsmConnect().
+ * A failing step is retried in place after a growing delay, during which
+ * xplrComCellFsmConnect() returns XPLR_COM_BUSY. Once maxRetries are used up the FSM
+ * goes to XPLR_COM_CELL_CONNECT_ERROR. Defaults come from xplr_hpglib_cfg.h.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @param  backoff    retry policy to apply.
+ * @return XPLR_COM_OK on success, XPLR_COM_ERROR otherwise.
+ */
+xplrCom_error_t xplrComCellFsmSetBackoff(int8_t dvcProfile, const xplrCom_cell_backoff_t *backoff);
+
+/**
+ * @brief Get timing and retry counters of xplrComCellFsmConnect().
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @param  stats      structure receiving the counters.
+ * @return XPLR_COM_OK on success, XPLR_COM_ERROR otherwise.
+ */
+xplrCom_error_t xplrComCellFsmGetStats(int8_t dvcProfile, xplrCom_cell_fsmStats_t *stats);
+
+/**
+ * @brief Clear the timing and retry counters of xplrComCellFsmConnect().
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ */
+void xplrComCellFsmClearStats(int8_t dvcProfile);
+
+/**
+ * @brief Forget the MNO, RAT and bands applied to the module.
+ * Once a connection succeeds its MNO, RAT and band settings are remembered in NVS, and
+ * later connections with the same settings go from device open straight to registration.
+ * Call this when the module was replaced or reconfigured outside of the library.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ */
+void xplrComCellForgetProfile(int8_t dvcProfile);
+
+/**
+ * @brief Perform a blocking network scan.
+ * A scan may take several minutes, prefer xplrComCellNetworkScanStart().
+ * Networks are written to scanBuff as "<MCC/MNC> <operator>" lines, as many as fit
+ * in size bytes. The results are also cached, see xplrComCellNetworkScanGetResults().
  *
  * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
  * @param  scanBuff   pointer to store scan results.
+ * @param  size       size of scanBuff in bytes.
  * @return number of networks found or negative error code.
  */
-int16_t xplrComCellNetworkScan(int8_t dvcProfile, char *scanBuff);
+int16_t xplrComCellNetworkScan(int8_t dvcProfile, char *scanBuff, size_t size);
+
+/**
+ * @brief Start a network scan in the background.
+ * The scan runs in its own task and its results replace the cached ones once finished.
+ * Poll xplrComCellNetworkScanGetState() to know when results are available.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @return XPLR_COM_OK on success, XPLR_COM_BUSY if a scan is already running,
+ *         XPLR_COM_ERROR otherwise.
+ */
+xplrCom_error_t xplrComCellNetworkScanStart(int8_t dvcProfile);
+
+/**
+ * @brief Cancel a running network scan.
+ * The module is told to abort the scan and the function returns once the scan task has
+ * exited. Cached results of previous scans are kept.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @return XPLR_COM_OK on success or if no scan was running, XPLR_COM_ERROR otherwise.
+ */
+xplrCom_error_t xplrComCellNetworkScanCancel(int8_t dvcProfile);
+
+/**
+ * @brief Get the state of the network scan.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @return state of the running or last network scan.
+ */
+xplrCom_cell_scan_state_t xplrComCellNetworkScanGetState(int8_t dvcProfile);
+
+/**
+ * @brief Get the cached results of the last finished network scan.
+ *
+ * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
+ * @param  scan       structure receiving the results.
+ * @param  maxAgeS    oldest results accepted in seconds, 0 to accept results of any age.
+ * @return XPLR_COM_OK when results were copied, XPLR_COM_ERROR if there are no results
+ *         or they are older than maxAgeS.
+ */
+xplrCom_error_t xplrComCellNetworkScanGetResults(int8_t dvcProfile,
+                                                 xplrCom_cell_scan_t *scan,
+                                                 uint32_t maxAgeS);
 
 /**
  * @brief Get current network info.
@@ -179,6 +262,7 @@ void xplrComCellNetworkInfo(int8_t dvcProfile, xplrCom_cell_netInfo_t *info);
  * To resume call xplrComCellPowerResume().
  * Make sure that a pwr pin is connected to the cellular module
  * or you might end up locked out from the device.
+ * A running network scan is cancelled first; if it does not stop the device is not powered down.
  *
  * @param  dvcProfile device profile id. Stored in xplrCom_cell_config_t
  * @return XPLR_COM_OK on success, XPLR_COM_ERROR otherwise.
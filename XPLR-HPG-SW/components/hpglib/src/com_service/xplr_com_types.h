@@ -42,8 +42,9 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#define XPLRCOM_CELL_RAT_SIZE        3U
-#define XPLRCOM_CELL_REBOOT_WAIT_MS  5000U
+#define XPLRCOM_CELL_RAT_SIZE          3U
+#define XPLRCOM_CELL_REBOOT_WAIT_MS    5000U
+#define XPLRCOM_CELL_SCAN_MAX_RESULTS  16U
 
 /* ----------------------------------------------------------------
  * PUBLIC TYPES
@@ -71,6 +72,15 @@ typedef enum {
     XPLR_COM_CELL_CONNECTED
 } xplrCom_cell_connect_t;
 
+/** States of the network scan of a cellular device. */
+typedef enum {
+    XPLR_COM_CELL_SCAN_ERROR = -1,  /**< last scan failed. */
+    XPLR_COM_CELL_SCAN_IDLE,        /**< no scan performed yet. */
+    XPLR_COM_CELL_SCAN_RUNNING,     /**< scan in progress. */
+    XPLR_COM_CELL_SCAN_DONE,        /**< scan finished, results cached. */
+    XPLR_COM_CELL_SCAN_CANCELLED    /**< scan cancelled before finishing. */
+} xplrCom_cell_scan_state_t;
+
 /*INDENT-OFF*/
 
 /** Cellular configuration struct for setting up deviceSettings.
@@ -108,6 +118,67 @@ typedef struct xplrCom_cell_netInfo_type {
                                                              Can be any status as described in uCellNetStatus_t */
 } xplrCom_cell_netInfo_t;
 
+/** Retry policy of the cellular connection FSM.
+ * A failing step is retried after a delay that starts at initialDelayMs and is multiplied
+ * on every retry up to maxDelayMs. Set with xplrComCellFsmSetBackoff().
+*/
+typedef struct xplrCom_cell_backoff_type {
+    uint8_t             maxRetries;         /**< retries of a failing step before going to error, 0 to disable. */
+    uint8_t             multiplier;         /**< growth factor of the delay per retry. */
+    uint32_t            initialDelayMs;     /**< delay before the first retry. */
+    uint32_t            maxDelayMs;         /**< upper limit of the delay. */
+    uint32_t            readyTimeoutMs;     /**< time the module may stay busy before the FSM times out. */
+} xplrCom_cell_backoff_t;
+
+/** Timing of a state of the cellular connection FSM. */
+typedef struct xplrCom_cell_stateStats_type {
+    uint32_t            entries;            /**< times the state was entered. */
+    uint32_t            failures;           /**< times the step failed. */
+    uint32_t            lastMs;             /**< time spent in the state the last time. */
+    uint32_t            maxMs;              /**< longest time spent in the state. */
+    uint32_t            totalMs;            /**< total time spent in the state. */
+} xplrCom_cell_stateStats_t;
+
+/** Timing and retry counters of the cellular connection FSM.
+ * To retrieve it xplrComCellFsmGetStats() needs to be called.
+*/
+typedef struct xplrCom_cell_fsmStats_type {
+    xplrCom_cell_stateStats_t   states[XPLR_COM_CELL_CONNECTED + 1];    /**< indexed by xplrCom_cell_connect_t. */
+    uint32_t                    connects;           /**< times the FSM reached the connected state. */
+    uint32_t                    errors;             /**< times the FSM gave up and went to error. */
+    uint32_t                    timeouts;           /**< times the module stayed busy for too long. */
+    uint32_t                    retries;            /**< retries of failing steps. */
+    uint32_t                    profileSkips;       /**< times MNO, RAT and band setup was skipped. */
+    uint32_t                    lastConnectMs;      /**< time from device open to connected, last time. */
+    uint32_t                    backoffMs;          /**< total time waited before retries. */
+} xplrCom_cell_fsmStats_t;
+
+/** A network found by the cellular network scan. */
+typedef struct xplrCom_cell_scanResult_type {
+    char                operatorName[32];                       /**< operator name as reported by the network. */
+    char                mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES];/**< MCC/MNC string of the operator. */
+    int32_t             Mcc;                                    /**< MCC of the operator. */
+    int32_t             Mnc;                                    /**< MNC of the operator. */
+    uCellNetRat_t       rat;                                    /**< RAT the operator was found on. */
+    bool                registered;                             /**< device is registered to this operator. */
+    int32_t             rssiDbm;                                /**< RSSI of the serving cell, 0 if not known.
+                                                                     Only available for the registered operator. */
+    int32_t             rsrpDbm;                                /**< RSRP of the serving cell, 0 if not known.
+                                                                     Only available for the registered operator. */
+} xplrCom_cell_scanResult_t;
+
+/** Results of the last cellular network scan.
+ * To retrieve it xplrComCellNetworkScanGetResults() needs to be called.
+*/
+typedef struct xplrCom_cell_scan_type {
+    int64_t                     timestamp;                                  /**< time the results were taken (us since boot). */
+    uint32_t                    durationMs;                                 /**< time the scan took. */
+    uint8_t                     numOfResults;                               /**< valid entries in results. */
+    bool                        truncated;                                  /**< more networks were found than
+                                                                                 XPLRCOM_CELL_SCAN_MAX_RESULTS. */
+    xplrCom_cell_scanResult_t   results[XPLRCOM_CELL_SCAN_MAX_RESULTS];     /**< networks found. */
+} xplrCom_cell_scan_t;
+
 /*INDENT-ON*/
 
 #ifdef __cplusplus
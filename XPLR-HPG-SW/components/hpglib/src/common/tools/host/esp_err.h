@@ -0,0 +1,14 @@
+/*
+ * Host stand-in of the ESP-IDF esp_err.h, only what the portable
+ * common sources use. Not part of the firmware build.
+ */
+
+#ifndef _XPLR_HOST_ESP_ERR_H_
+#define _XPLR_HOST_ESP_ERR_H_
+
+typedef int esp_err_t;
+
+#define ESP_OK      (0)
+#define ESP_FAIL    (-1)
+
+#endif /* _XPLR_HOST_ESP_ERR_H_ */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in of the ESP-IDF esp_log.h, included by xplr_hpglib_cfg.h
+ * for its logging macros, which the portable common sources do not use.
+ * Not part of the firmware build.
+ */
+
+#ifndef _XPLR_HOST_ESP_LOG_H_
+#define _XPLR_HOST_ESP_LOG_H_
+
+#endif /* _XPLR_HOST_ESP_LOG_H_ */
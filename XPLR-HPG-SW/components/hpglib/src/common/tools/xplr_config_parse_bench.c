@@ -0,0 +1,244 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host benchmark of xplrParseConfigSettings(), built from the firmware source
+ * (xplr_common_config.c) with the cJSON shipped in ESP-IDF. esp_err.h and
+ * esp_log.h come from tools/host.
+ *
+ * Build on Linux:
+ *   gcc -O2 -DCONFIG_BOARD_XPLR_HPG2_C214 -Ihost -I.. -I$IDF_PATH/components/json/cJSON \
+ *       xplr_config_parse_bench.c ../xplr_common_config.c \
+ *       $IDF_PATH/components/json/cJSON/cJSON.c -o xplr_config_parse_bench
+ *
+ * Usage:
+ *   xplr_config_parse_bench [-n iterations] [config.json ...]
+ *
+ * Without files bin/xplr_config_template.json is used, the file that
+ * docs/README_xplr_config_file.md asks to start from. For each file the time
+ * per load and the peak heap taken by cJSON during the load are reported,
+ * next to the peak heap of a single tree of the whole file, which is what a
+ * loader parsing the file at once needs. The settings read are printed, and
+ * a few malformed payloads must be rejected. Prints PASS or FAIL, exit code
+ * 0 on PASS.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cJSON.h"
+#include "xplr_common.h"
+
+#define DEFAULT_CONFIG      "../../../../../bin/xplr_config_template.json"
+#define DEFAULT_ITERATIONS  (20000U)
+
+static size_t heapNow;
+static size_t heapPeak;
+
+/* ----------------------------------------------------------------
+ * HEAP ACCOUNTING
+ * -------------------------------------------------------------- */
+
+static void *benchMalloc(size_t size)
+{
+    size_t *block = malloc(sizeof(size_t) + size);
+
+    if (block != NULL) {
+        *block = size;
+        heapNow += size;
+        if (heapNow > heapPeak) {
+            heapPeak = heapNow;
+        }
+        block++;
+    }
+
+    return block;
+}
+
+static void benchFree(void *ptr)
+{
+    size_t *block = ptr;
+
+    if (block != NULL) {
+        block--;
+        heapNow -= *block;
+        free(block);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * BENCHMARK
+ * -------------------------------------------------------------- */
+
+static double nowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static char *readFile(const char *path, long *len)
+{
+    FILE *file = fopen(path, "rb");
+    char *buf = NULL;
+
+    if (file != NULL) {
+        if ((fseek(file, 0, SEEK_END) == 0) && ((*len = ftell(file)) > 0)) {
+            rewind(file);
+            buf = malloc((size_t)*len + 1);
+            if ((buf != NULL) && (fread(buf, 1, (size_t)*len, file) == (size_t)*len)) {
+                buf[*len] = '\0';
+            } else {
+                free(buf);
+                buf = NULL;
+            }
+        }
+        fclose(file);
+    }
+
+    return buf;
+}
+
+static void printSettings(const xplr_cfg_t *cfg)
+{
+    printf("  app: runTime %u loc %u stat %u mqttWdg %d\n",
+           (unsigned)cfg->appCfg.runTime,
+           (unsigned)cfg->appCfg.locInterval,
+           (unsigned)cfg->appCfg.statInterval,
+           (int)cfg->appCfg.mqttWdgEnable);
+    printf("  cell apn \"%s\", wifi ssid \"%s\"\n", cfg->cellCfg.apn, cfg->wifiCfg.ssid);
+    printf("  thingstream region \"%s\", ntrip host \"%s\" port %u\n",
+           cfg->tsCfg.region,
+           cfg->ntripCfg.host,
+           (unsigned)cfg->ntripCfg.port);
+    printf("  log instances %d, dr enable %d, gnss module %d source %d\n",
+           (int)cfg->logCfg.numOfInstances,
+           (int)cfg->drCfg.enable,
+           (int)cfg->gnssCfg.module,
+           (int)cfg->gnssCfg.corrDataSrc);
+}
+
+static int benchFile(const char *path, unsigned iterations)
+{
+    static xplr_cfg_t cfg;
+    size_t peakLoad, peakTree;
+    double start, usLoad;
+    cJSON *tree;
+    char *payload;
+    long len = 0;
+    int ret = 0;
+
+    payload = readFile(path, &len);
+    if (payload == NULL) {
+        printf("%s: cannot read\n", path);
+        ret = 1;
+    } else {
+        memset(&cfg, 0, sizeof(cfg));
+        heapPeak = 0;
+        if (xplrParseConfigSettings(payload, &cfg) != ESP_OK) {
+            printf("%s: FAIL, not accepted\n", path);
+            ret = 1;
+        } else {
+            peakLoad = heapPeak;
+
+            heapPeak = 0;
+            tree = cJSON_Parse(payload);
+            peakTree = heapPeak;
+            cJSON_Delete(tree);
+
+            start = nowUs();
+            for (unsigned i = 0; i < iterations; i++) {
+                (void)xplrParseConfigSettings(payload, &cfg);
+            }
+            usLoad = (nowUs() - start) / iterations;
+
+            printf("%s (%ld bytes, %u loads)\n", path, len, iterations);
+            printf("  xplrParseConfigSettings: %8.1f us/load, peak heap %6zu bytes\n", usLoad, peakLoad);
+            printf("  whole file as one tree:               peak heap %6zu bytes\n", peakTree);
+            printSettings(&cfg);
+        }
+        if (heapNow != 0) {
+            printf("  FAIL: %zu bytes not freed\n", heapNow);
+            ret = 1;
+        }
+        free(payload);
+    }
+
+    return ret;
+}
+
+/* payloads xplrParseConfigSettings() must reject, without leaking */
+static int checkRejected(void)
+{
+    static const char *bad[] = {
+        "",
+        "[1, 2]",
+        "{\"AppSettings\": {\"RunTimeUtc\": 1}",
+        "{\"AppSettings\": {\"RunTimeUtc\": 1]}",
+        "{\"AppSettings\": \"{\\\"not\\\": \\\"a section\\\"}\"}",
+        "{\"AppSettings\": {\"RunTimeUtc\": 1, \"LocationPrintInterval\": ,}}"
+    };
+    static xplr_cfg_t cfg;
+    int ret = 0;
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (xplrParseConfigSettings((char *)bad[i], &cfg) == ESP_OK) {
+            printf("  FAIL: accepted %s\n", bad[i]);
+            ret = 1;
+        }
+        if (heapNow != 0) {
+            printf("  FAIL: %zu bytes not freed after %s\n", heapNow, bad[i]);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    cJSON_Hooks hooks = { benchMalloc, benchFree };
+    unsigned iterations = DEFAULT_ITERATIONS;
+    int files = 0;
+    int ret = 0;
+    int i;
+
+    cJSON_InitHooks(&hooks);
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iterations = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else {
+            ret |= benchFile(argv[i], (iterations > 0) ? iterations : 1U);
+            files++;
+        }
+    }
+    if (files == 0) {
+        ret |= benchFile(DEFAULT_CONFIG, (iterations > 0) ? iterations : 1U);
+    }
+
+    /* the rejected payloads print their errors, keep them apart */
+    printf("malformed payloads:\n");
+    ret |= checkRejected();
+
+    printf("%s\n", (ret == 0) ? "PASS" : "FAIL");
+
+    return ret;
+}
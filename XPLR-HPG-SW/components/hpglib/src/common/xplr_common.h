@@ -201,6 +201,7 @@ int32_t xplrGetDeviceMac(uint8_t *mac);
 /**
  * @brief Set base MAC address of the MCU to u-blox MAC. Base MAC is the WIFI_STA address,
  * the other 3 MAC addresses (WIFI_AP, BT, ETH) are calculated from the base MAC. So we only need to set the base MAC.
+ * The otp content is kept in RAM from here on (otp_snapshot_load()), for the rf calibration and otp_get_identity().
  *
  * @return      ESP_OK on success, ESP_FAIL otherwise.
  */
@@ -256,7 +257,9 @@ void xplrMemUsagePrint(uint8_t periodSecs);
 
 /**
  * @brief Function that parses module settings from the xplr_config.json
- *        configuration file
+ *        configuration file. The payload is checked once and each module
+ *        section is then parsed on its own, so only one section's JSON tree
+ *        is held in heap at a time.
  *
  * @param payload   the data fetched from the json file
  * @param settings  struct containing the parsed configuration options and settings
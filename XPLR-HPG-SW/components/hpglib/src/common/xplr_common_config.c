@@ -0,0 +1,822 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only cJSON and the C standard library here: the configuration
+ * parser is also built on a host, see tools/xplr_config_parse_bench.c
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "xplr_common.h"
+#include "cJSON.h"
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static esp_err_t parseAppConfig(cJSON *root, xplr_cfg_app_t *appCfg);
+static esp_err_t parseCellConfig(cJSON *root, xplr_cfg_cell_t *cellCfg);
+static esp_err_t parseWifiConfig(cJSON *root, xplr_cfg_wifi_t *wifiCfg);
+static esp_err_t parseTsConfig(cJSON *root, xplr_cfg_thingstream_t *tsCfg);
+static esp_err_t parseNtripConfig(cJSON *root, xplr_cfg_ntrip_t *ntripCfg);
+static esp_err_t parseLogConfig(cJSON *root, xplr_cfg_log_t *logCfg);
+static esp_err_t parseDrConfig(cJSON *root, xplr_cfg_dr_t *drCfg);
+static esp_err_t parseGnssConfig(cJSON *root, xplr_cfg_gnss_t *gnssCfg);
+static cJSON *sectionTree(const char *payload, const char *name);
+static const char *skipSpace(const char *p);
+static const char *skipString(const char *p);
+static const char *skipValue(const char *p);
+static bool findSection(const char *payload, const char *name, const char **value, size_t *len);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTION DEFINITIONS
+ * -------------------------------------------------------------- */
+
+esp_err_t xplrParseConfigSettings(char *payload, xplr_cfg_t *settings)
+{
+    esp_err_t ret;
+    esp_err_t err[8];
+    cJSON *root;
+
+    if (payload == NULL || settings == NULL) {
+        printf("Invalid Parameters. Cannot Parse Configuration\n");
+        ret = ESP_FAIL;
+    } else if ((*skipSpace(payload) != '{') || (skipValue(skipSpace(payload)) == NULL)) {
+        printf("Configuration payload is not valid JSON\n");
+        ret = ESP_FAIL;
+    } else {
+        /**
+         * Only one section is turned into a JSON tree at a time,
+         * so the heap taken is that of the largest section, not of the whole file.
+         */
+        root = sectionTree(payload, "AppSettings");
+        err[0] = parseAppConfig(root, &settings->appCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "CellSettings");
+        err[1] = parseCellConfig(root, &settings->cellCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "WifiSettings");
+        err[2] = parseWifiConfig(root, &settings->wifiCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "ThingstreamSettings");
+        err[3] = parseTsConfig(root, &settings->tsCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "NTRIPSettings");
+        err[4] = parseNtripConfig(root, &settings->ntripCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "LogSettings");
+        err[5] = parseLogConfig(root, &settings->logCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "DeadReckoningSettings");
+        err[6] = parseDrConfig(root, &settings->drCfg);
+        cJSON_Delete(root);
+        root = sectionTree(payload, "GNSSModuleSettings");
+        err[7] = parseGnssConfig(root, &settings->gnssCfg);
+        cJSON_Delete(root);
+        for (int i = 0; i < 8; i++) {
+            if (err[i] != ESP_OK) {
+                ret = ESP_FAIL;
+                break;
+            } else {
+                ret = ESP_OK;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DEFINITIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * Tree of one top level member, under a root holding only that member.
+ * A missing or invalid member gives an empty root, the section parser
+ * reports it. NULL only if out of memory, also reported by the parser.
+ */
+static cJSON *sectionTree(const char *payload, const char *name)
+{
+    cJSON *root;
+    cJSON *value;
+    const char *start;
+    size_t len;
+
+    root = cJSON_CreateObject();
+    if ((root != NULL) && findSection(payload, name, &start, &len)) {
+        value = cJSON_ParseWithLength(start, len);
+        if (value == NULL) {
+            printf("%s is not valid JSON\n", name);
+        } else {
+            cJSON_AddItemToObject(root, name, value);
+        }
+    } else {
+        // do nothing
+    }
+
+    return root;
+}
+
+static const char *skipSpace(const char *p)
+{
+    while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) {
+        p++;
+    }
+
+    return p;
+}
+
+/* p on the opening quote, returns past the closing one or NULL */
+static const char *skipString(const char *p)
+{
+    const char *ret = NULL;
+
+    for (p++; *p != 0; p++) {
+        if (*p == '\\') {
+            if (*(p + 1) == 0) {
+                break;
+            } else {
+                p++;
+            }
+        } else if (*p == '"') {
+            ret = p + 1;
+            break;
+        } else {
+            // do nothing
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Returns the end of the value at p, only following its structure:
+ * the values themselves are checked by cJSON when their section is parsed.
+ * NULL if the value is truncated or its brackets do not match.
+ */
+static const char *skipValue(const char *p)
+{
+    char stack[32];
+    uint8_t depth = 0;
+    const char *ret = NULL;
+
+    while ((p != NULL) && (*p != 0) && (ret == NULL)) {
+        if (*p == '"') {
+            p = skipString(p);
+            if ((p != NULL) && (depth == 0)) {
+                ret = p;
+            }
+        } else if ((*p == '{') || (*p == '[')) {
+            if (depth < sizeof(stack)) {
+                stack[depth++] = (*p == '{') ? '}' : ']';
+                p++;
+            } else {
+                p = NULL;
+            }
+        } else if ((depth == 0) && ((*p == ',') || (*p == '}') || (*p == ']') || (*p == ' ') ||
+                                    (*p == '\t') || (*p == '\r') || (*p == '\n'))) {
+            /* end of a number or literal */
+            ret = p;
+        } else if ((*p == '}') || (*p == ']')) {
+            if (stack[depth - 1] == *p) {
+                depth--;
+                p++;
+                if (depth == 0) {
+                    ret = p;
+                }
+            } else {
+                p = NULL;
+            }
+        } else {
+            p++;
+        }
+    }
+
+    if ((ret == NULL) && (p != NULL) && (*p == 0) && (depth == 0)) {
+        /* number or literal ending the payload */
+        ret = p;
+    }
+
+    return ret;
+}
+
+/* Locate the value of a top level member, matched like cJSON_GetObjectItem() does */
+static bool findSection(const char *payload, const char *name, const char **value, size_t *len)
+{
+    const char *p = skipSpace(payload);
+    const char *key;
+    const char *end;
+    size_t nameLen = strlen(name);
+    bool ret = false;
+
+    if (*p == '{') {
+        p = skipSpace(p + 1);
+        while ((*p == '"') && !ret) {
+            key = p + 1;
+            p = skipString(p);
+            if (p == NULL) {
+                break;
+            }
+            p = skipSpace(p);
+            if (*p != ':') {
+                break;
+            }
+            p = skipSpace(p + 1);
+            end = skipValue(p);
+            if ((end == NULL) || (end == p)) {
+                break;
+            }
+            if (((size_t)(skipString(key - 1) - key - 1) == nameLen) &&
+                (strncasecmp(key, name, nameLen) == 0)) {
+                *value = p;
+                *len = (size_t)(end - p);
+                ret = true;
+            } else {
+                p = skipSpace(end);
+                if (*p == ',') {
+                    p = skipSpace(p + 1);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseAppConfig(cJSON *root, xplr_cfg_app_t *appCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *appSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || appCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse application configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "AppSettings")) {
+            appSettings = cJSON_GetObjectItem(root, "AppSettings");
+            /* Check for individual settings */
+            settingsFound = cJSON_HasObjectItem(appSettings, "RunTimeUtc");
+            settingsFound &= cJSON_HasObjectItem(appSettings, "LocationPrintInterval");
+            settingsFound &= cJSON_HasObjectItem(appSettings, "StatisticsPrintInterval");
+            settingsFound &= cJSON_HasObjectItem(appSettings, "MQTTClientWatchdogEnable");
+            if (settingsFound) {
+                abort = false;
+                /* Parse individual settings */
+                if (!abort) {
+                    element = cJSON_GetObjectItem(appSettings, "RunTimeUtc");
+                    if (cJSON_IsNumber(element)) {
+                        appCfg->runTime = element->valuedouble;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(appSettings, "LocationPrintInterval");
+                    if (cJSON_IsNumber(element)) {
+                        appCfg->locInterval = element->valuedouble;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(appSettings, "StatisticsPrintInterval");
+                    if (cJSON_IsNumber(element)) {
+                        appCfg->statInterval = element->valuedouble;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(appSettings, "MQTTClientWatchdogEnable");
+                    if (cJSON_IsBool(element)) {
+                        appCfg->mqttWdgEnable = (bool) element->valueint;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Application configuration contains invalid value types");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete application settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find AppSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseCellConfig(cJSON *root, xplr_cfg_cell_t *cellCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *cellSettings;
+    bool settingsFound;
+
+    if (root == NULL || cellCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse cell configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "CellSettings")) {
+            cellSettings = cJSON_GetObjectItem(root, "CellSettings");
+            settingsFound = cJSON_HasObjectItem(cellSettings, "APN");
+            if (settingsFound) {
+                element = cJSON_GetObjectItem(cellSettings, "APN");
+                if (cJSON_IsString(element)) {
+                    strncpy(cellCfg->apn, element->valuestring, 31);
+                    ret = ESP_OK;
+                } else {
+                    printf("Cell configuration contains invalid value types");
+                    ret = ESP_FAIL;
+                }
+            } else {
+                printf("Incomplete cell module settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find CellSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseWifiConfig(cJSON *root, xplr_cfg_wifi_t *wifiCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *wifiSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || wifiCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse wifi configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "WifiSettings")) {
+            wifiSettings = cJSON_GetObjectItem(root, "WifiSettings");
+            settingsFound = cJSON_HasObjectItem(wifiSettings, "SSID");
+            settingsFound &= cJSON_HasObjectItem(wifiSettings, "Password");
+            if (settingsFound) {
+                /* Parse individual settings */
+                abort = false;
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(wifiSettings, "SSID");
+                    if (cJSON_IsString(element)) {
+                        strncpy(wifiCfg->ssid, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(wifiSettings, "Password");
+                    if (cJSON_IsString(element)) {
+                        strncpy(wifiCfg->pwd, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Wifi configuration contains invalid value types");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete wifi module settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find WifiSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseTsConfig(cJSON *root, xplr_cfg_thingstream_t *tsCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *tsSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || tsCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse thingstream configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "ThingstreamSettings")) {
+            tsSettings = cJSON_GetObjectItem(root, "ThingstreamSettings");
+            settingsFound = cJSON_HasObjectItem(tsSettings, "Region");
+            settingsFound &= cJSON_HasObjectItem(tsSettings, "ConfigFilename");
+            settingsFound &= cJSON_HasObjectItem(tsSettings, "ZTPToken");
+            if (settingsFound) {
+                /* Parse individual settings */
+                abort = false;
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(tsSettings, "Region");
+                    if (cJSON_IsString(element)) {
+                        strncpy(tsCfg->region, element->valuestring, 31);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(tsSettings, "ConfigFilename");
+                    if (cJSON_IsString(element)) {
+                        strncpy(tsCfg->uCenterConfigFilename, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(tsSettings, "ZTPToken");
+                    if (cJSON_IsString(element)) {
+                        strncpy(tsCfg->ztpToken, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Thingstream module configuration contains invalid value types\n");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete Thingstream module settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find ThingstreamSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseNtripConfig(cJSON *root, xplr_cfg_ntrip_t *ntripCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *ntripSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || ntripCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse NTRIP Client configuration.\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "NTRIPSettings")) {
+            ntripSettings = cJSON_GetObjectItem(root, "NTRIPSettings");
+            settingsFound = cJSON_HasObjectItem(ntripSettings, "Host");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "Port");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "MountPoint");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "UserAgent");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "SendGGA");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "UseAuthentication");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "Username");
+            settingsFound &= cJSON_HasObjectItem(ntripSettings, "Password");
+            if (settingsFound) {
+                /* Parse individual settings */
+                abort = false;
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "Host");
+                    if (cJSON_IsString(element)) {
+                        strncpy(ntripCfg->host, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "Port");
+                    if (cJSON_IsNumber(element)) {
+                        ntripCfg->port = (uint16_t)element->valueint;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "MountPoint");
+                    if (cJSON_IsString(element)) {
+                        strncpy(ntripCfg->mountpoint, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "UserAgent");
+                    if (cJSON_IsString(element)) {
+                        strncpy(ntripCfg->userAgent, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "SendGGA");
+                    if (cJSON_IsBool(element)) {
+                        ntripCfg->sendGGA = (bool)element->valueint;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(ntripSettings, "UseAuthentication");
+                    if (cJSON_IsBool(element)) {
+                        ntripCfg->useAuth = (bool)element->valueint;
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort && ntripCfg->useAuth) {
+                    element = cJSON_GetObjectItem(ntripSettings, "Username");
+                    if (cJSON_IsString(element)) {
+                        strncpy(ntripCfg->username, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (!abort && ntripCfg->useAuth) {
+                    element = cJSON_GetObjectItem(ntripSettings, "Password");
+                    if (cJSON_IsString(element)) {
+                        strncpy(ntripCfg->password, element->valuestring, 63);
+                    } else {
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("NTRIP Client configuration contains invalid value types\n");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete NTRIP client settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find NTRIPSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseLogConfig(cJSON *root, xplr_cfg_log_t *logCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *logSettings, *instances;
+    bool settingsFound, abort;
+
+    if (root == NULL || logCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse logging configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "LogSettings")) {
+            logSettings = cJSON_GetObjectItem(root, "LogSettings");
+            /* Check for individual settings */
+            settingsFound = cJSON_HasObjectItem(logSettings, "Instances");
+            settingsFound &= cJSON_HasObjectItem(logSettings, "FilenameUpdateInterval");
+            settingsFound &= cJSON_HasObjectItem(logSettings, "HotPlugEnable");
+            if (settingsFound) {
+                /* All settings exist we need to parse the data */
+                abort = false;
+                /* Parse log instances */
+                instances = cJSON_GetObjectItem(logSettings, "Instances");
+                if (cJSON_IsArray(instances)) {
+                    logCfg->numOfInstances = cJSON_GetArraySize(instances);
+                    if ((logCfg->numOfInstances > 0) && (logCfg->numOfInstances <= XPLR_LOG_MAX_INSTANCES)) {
+                        for (int i = 0; i < logCfg->numOfInstances; i++) {
+                            element = cJSON_GetArrayItem(instances, i);
+                            if (element != NULL) {
+                                strncpy(logCfg->instance[i].description,
+                                        cJSON_GetObjectItem(element, "Description")->valuestring,
+                                        63);
+                                strncpy(logCfg->instance[i].filename, cJSON_GetObjectItem(element, "Filename")->valuestring, 63);
+                                logCfg->instance[i].enable = (bool)cJSON_GetObjectItem(element, "Enable")->valueint;
+                                logCfg->instance[i].erasePrev = (bool)cJSON_GetObjectItem(element, "ErasePrev")->valueint;
+                                logCfg->instance[i].sizeInterval = (uint64_t)(cJSON_GetObjectItem(element,
+                                                                                                  "SizeIntervalKBytes")->valueint) * 1024;
+                            } else {
+                                abort = true;
+                                break;
+                            }
+                        }
+                    } else {
+                        printf("Invalid log instance number\n");
+                        abort = true;
+                    }
+                } else {
+                    abort = true;
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(logSettings, "FilenameUpdateInterval");
+                    if (cJSON_IsNumber(element)) {
+                        logCfg->filenameInterval = (uint64_t) element->valueint;
+                    } else {
+                        printf("Invalid filename increment interval value\n");
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(logSettings, "HotPlugEnable");
+                    if (cJSON_IsBool(element)) {
+                        logCfg->hotPlugEnable = (bool)element->valueint;
+                    } else {
+                        printf("Invalid hot plug enable option\n");
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Invalid log module configuration options\n");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete Log module settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find LogSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseDrConfig(cJSON *root, xplr_cfg_dr_t *drCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *drSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || drCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse dead reckoning configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "DeadReckoningSettings")) {
+            drSettings = cJSON_GetObjectItem(root, "DeadReckoningSettings");
+            settingsFound = cJSON_HasObjectItem(drSettings, "Enable");
+            settingsFound &= cJSON_HasObjectItem(drSettings, "PrintIMUData");
+            if (settingsFound) {
+                abort = false;
+                element = cJSON_GetObjectItem(drSettings, "Enable");
+                if (cJSON_IsBool(element)) {
+                    drCfg->enable = (bool)element->valueint;
+                } else {
+                    printf("Could not find DR enable option\n");
+                    abort = true;
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(drSettings, "PrintIMUData");
+                    if (cJSON_IsBool(element)) {
+                        drCfg->printImuData = (bool)element->valueint;
+                    } else {
+                        printf("Could not find print IMU data option\n");
+                        abort = true;
+                    }
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(drSettings, "PrintInterval");
+                    if (cJSON_IsNumber(element)) {
+                        drCfg->printInterval = (uint32_t)element->valueint;
+                    } else {
+                        printf("Could not find print IMU data interval option\n");
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Invalid DR module configuration options\n");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete Dead Reckoning settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find DrSettings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static esp_err_t parseGnssConfig(cJSON *root, xplr_cfg_gnss_t *gnssCfg)
+{
+    esp_err_t ret;
+    cJSON *element, *gnssSettings;
+    bool settingsFound, abort;
+
+    if (root == NULL || gnssCfg == NULL) {
+        printf("Invalid Parameters. Cannot parse dead reckoning configuration\n");
+        ret = ESP_FAIL;
+    } else {
+        if (cJSON_HasObjectItem(root, "GNSSModuleSettings")) {
+            gnssSettings = cJSON_GetObjectItem(root, "GNSSModuleSettings");
+            settingsFound = cJSON_HasObjectItem(gnssSettings, "Module");
+            settingsFound &= cJSON_HasObjectItem(gnssSettings, "CorrectionDataSource");
+            if (settingsFound) {
+                abort = false;
+                element = cJSON_GetObjectItem(gnssSettings, "Module");
+                if (cJSON_IsString(element)) {
+                    if (strcmp(element->valuestring, "F9R") == 0) {
+                        gnssCfg->module = 0;
+                    } else if (strcmp(element->valuestring, "F9P") == 0) {
+                        gnssCfg->module = 1;
+                    } else {
+                        printf("Invalid GNSS module option\n");
+                        gnssCfg->module = -1;
+                        abort = true;
+                    }
+                } else {
+                    printf("Could not find GNSS module option\n");
+                    abort = true;
+                }
+
+                if (!abort) {
+                    element = cJSON_GetObjectItem(gnssSettings, "CorrectionDataSource");
+                    if (cJSON_IsString(element)) {
+                        if (strcmp(element->valuestring, "IP") == 0) {
+                            gnssCfg->corrDataSrc = 0;
+                        } else if (strcmp(element->valuestring, "LBAND") == 0) {
+                            gnssCfg->corrDataSrc = 1;
+                        } else {
+                            printf("Invalid correction data source option\n");
+                            abort = true;
+                        }
+                    } else {
+                        printf("Could not find correction data source option\n");
+                        abort = true;
+                    }
+                }
+
+                if (abort) {
+                    printf("Invalid GNSS module configuration options\n");
+                    ret = ESP_FAIL;
+                } else {
+                    ret = ESP_OK;
+                }
+            } else {
+                printf("Incomplete GNSS module settings in configuration file\n");
+                ret = ESP_FAIL;
+            }
+        } else {
+            printf("Cannot find GNSS Module Settings\n");
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
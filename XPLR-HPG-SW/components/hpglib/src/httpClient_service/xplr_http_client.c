@@ -21,7 +21,11 @@
  */
 
 #include "string.h"
+#include "stdlib.h"
 #include "esp_task_wdt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "xplr_http_client.h"
 #include "u_cell_http.h"
 #include "./../../../components/hpglib/src/common/xplr_common.h"
@@ -40,20 +44,62 @@
 #define XPLRCELL_HTTP_CONSOLE(message, ...) do{} while(0)
 #endif
 
+#define XPLRCELL_HTTP_ASYNC_TASK_STACK      (4 * 1024)
+#define XPLRCELL_HTTP_ASYNC_TASK_PRIO       (3)
+#define XPLRCELL_HTTP_ASYNC_POLL_MS         (500U)  /* worker wake up period, to check for timeouts */
+#define XPLRCELL_HTTP_ASYNC_TIMEOUT_MARGIN_S (5U)   /* added to the client timeout before giving up a request */
+#define XPLRCELL_HTTP_ASYNC_SINK_CHUNK      (512U)  /* response bytes handed to a sink per call */
+
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
 
+typedef enum {
+    XPLR_CELL_HTTP_ASYNC_IDLE = 0,  /**< client free for a new request. */
+    XPLR_CELL_HTTP_ASYNC_SENT,      /**< request sent, waiting for the response. */
+    XPLR_CELL_HTTP_ASYNC_CLOSING,   /**< request given up, its connection is being closed. */
+    XPLR_CELL_HTTP_ASYNC_COMPLETED  /**< response (or error) ready to be delivered. */
+} xplrCell_http_async_state_t;
+
 // *INDENT-OFF*
+/** Queued asynchronous request. */
+typedef struct xplrCell_http_async_item_type {
+    xplrCell_http_request_t         request;
+    int8_t                          clientId;       /**< client resolved at submission */
+    int32_t                         id;
+} xplrCell_http_async_item_t;
+
+/** Asynchronous request in flight on a client. */
+typedef struct xplrCell_http_async_slot_type {
+    xplrCell_http_async_state_t     state;
+    xplrCell_http_async_item_t      item;
+    int8_t                          dvcProfile;
+    int32_t                         status;         /**< http status code or negative error */
+    size_t                          rspSize;        /**< bytes received */
+    size_t                          rspIo;          /**< size of rsp given to, and updated by, ubxlib */
+    bool                            truncated;      /**< response longer than XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE */
+    char                            *rsp;           /**< response buffer, allocated on first use, one byte over
+                                                         XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE to spot longer responses */
+    char                            contentType[U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES];
+    TickType_t                      startTick;
+} xplrCell_http_async_slot_t;
+
 typedef struct xplrCell_Http_type {
-    int8_t                          *dvcProfile;                                                    /**< hpglib device id */
+    int8_t                          dvcProfile;                                                     /**< hpglib device id */
     uDeviceHandle_t                 handler;                                                        /**< ubxlib device handler */
-    xplrCell_http_client_t          *client[XPLRCELL_MQTT_NUMOF_CLIENTS];                           /**< pointer to hpglib http cell client module */
-    uHttpClientContext_t            *clientContext[XPLRCELL_MQTT_NUMOF_CLIENTS];                    /**< ubxlib private client context of http api */
-    uHttpClientConnection_t         clientConnection[XPLRCELL_MQTT_NUMOF_CLIENTS];                  /**< ubxlib private connection of http api */
-    uSecurityTlsSettings_t          clientTlsSettings[XPLRCELL_MQTT_NUMOF_CLIENTS];                 /**< ubxlib private tls settings of http client */
-
-    void                            (*uHttpClientResponseCallback_t[XPLRCELL_MQTT_NUMOF_CLIENTS]);  /**< array of function pointers to msg received callback. */
+    xplrCell_http_client_t          *client[XPLRCELL_HTTP_NUMOF_CLIENTS];                           /**< pointer to hpglib http cell client module */
+    uHttpClientContext_t            *clientContext[XPLRCELL_HTTP_NUMOF_CLIENTS];                    /**< ubxlib private client context of http api */
+    uHttpClientConnection_t         clientConnection[XPLRCELL_HTTP_NUMOF_CLIENTS];                  /**< ubxlib private connection of http api */
+    uSecurityTlsSettings_t          clientTlsSettings[XPLRCELL_HTTP_NUMOF_CLIENTS];                 /**< ubxlib private tls settings of http client */
+
+    void                            (*uHttpClientResponseCallback_t[XPLRCELL_HTTP_NUMOF_CLIENTS]);  /**< array of function pointers to msg received callback. */
+
+    xplrCell_http_async_slot_t      asyncSlot[XPLRCELL_HTTP_NUMOF_CLIENTS];                         /**< request in flight per client */
+    xplrCell_http_async_item_t      asyncQueue[XPLRCELL_HTTP_ASYNC_QUEUE_LEN];                      /**< requests waiting, oldest first */
+    uint8_t                         asyncQueueLen;
+    int32_t                         asyncNextId;
+    TaskHandle_t                    asyncTask;                                                      /**< worker, exists while requests are pending */
+    SemaphoreHandle_t               asyncMutex;                                                     /**< guards the async members */
 } xplrCell_Http_t;
 // *INDENT-ON*
 
@@ -76,6 +122,22 @@ static xplrCell_http_error_t clientNvsReadConfig(int8_t dvcProfile, int8_t clien
 static xplrCell_http_error_t clientNvsUpdate(int8_t dvcProfile, int8_t clientId);
 static xplrCell_http_error_t clientNvsErase(int8_t dvcProfile, int8_t clientId);
 static xplrCell_http_error_t clientConnect(int8_t dvcProfile, int8_t clientId);
+static int8_t asyncRoute(int8_t dvcProfile, const xplrCell_http_request_t *request);
+static bool asyncIdle(xplrCell_Http_t *instance);
+static void asyncDispatch(int8_t dvcProfile);
+static void asyncSend(int8_t dvcProfile, int8_t clientId);
+static void asyncCheckTimeouts(int8_t dvcProfile);
+static void asyncDeliver(int8_t dvcProfile);
+static void asyncTask(void *pvParams);
+
+/* ----------------------------------------------------------------
+ * STATIC CALLBACK FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static void asyncResponseCb(uDeviceHandle_t devHandle,
+                            int32_t statusCodeOrError,
+                            size_t responseSize,
+                            void *pResponseCallbackParam);
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTION DEFINITIONS
@@ -85,14 +147,23 @@ xplrCell_http_error_t xplrCellHttpConnect(int8_t dvcProfile,
                                           int8_t clientId,
                                           xplrCell_http_client_t *client)
 {
-    xplrCell_Http_t  *instance = &http[dvcProfile];
+    xplrCell_Http_t  *instance;
     xplrCell_http_error_t ret;
 
-    if (dvcProfile < XPLRCELL_MQTT_NUMOF_CLIENTS) {
-        memset(instance, 0x00, sizeof(xplrCell_Http_t));
-        /* Retrieve user settings to configure device */
-        instance->dvcProfile = &dvcProfile;
+    if ((dvcProfile >= 0) && (dvcProfile < XPLRCOM_NUMOF_DEVICES) &&
+        (clientId >= 0) && (clientId < XPLRCELL_HTTP_NUMOF_CLIENTS) &&
+        (client != NULL)) {
+        instance = &http[dvcProfile];
+        if (instance->asyncMutex == NULL) {
+            instance->asyncMutex = xSemaphoreCreateMutex();
+        } else {
+            // do nothing
+        }
+        /* Retrieve user settings to configure device, other clients of the device are left as they are */
+        instance->dvcProfile = dvcProfile;
+        instance->clientContext[clientId] = NULL;
         instance->client[clientId] = client;
+        instance->asyncSlot[clientId].dvcProfile = dvcProfile;
         instance->client[clientId]->id = clientId;
         instance->client[clientId]->fsm[0] = XPLR_CELL_HTTP_CLIENT_FSM_CONNECT;
         if (client->settings.async) {
@@ -121,7 +192,8 @@ xplrCell_http_error_t xplrCellHttpConnect(int8_t dvcProfile,
             ret = clientConnect(dvcProfile, clientId);
         }
     } else {
-        XPLRCELL_HTTP_CONSOLE(E, "HTTP init error, profile %d out of index.", dvcProfile);
+        XPLRCELL_HTTP_CONSOLE(E, "HTTP init error, profile %d or client %d out of index.",
+                              dvcProfile, clientId);
         ret = XPLR_CELL_HTTP_ERROR;
     }
 
@@ -132,16 +204,80 @@ void xplrCellHttpDeInit(int8_t dvcProfile, int8_t clientId)
 {
     uHttpClientConnection_t *connection = &http[dvcProfile].clientConnection[clientId];
     uSecurityTlsSettings_t *tlsSettings = &http[dvcProfile].clientTlsSettings[clientId];
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_async_slot_t *slot = &instance->asyncSlot[clientId];
+
     xplrCellHttpDisconnect(dvcProfile, clientId);
     memset(connection, 0x00, sizeof(uHttpClientConnection_t));
     memset(tlsSettings, 0x00, sizeof(uSecurityTlsSettings_t));
 
+    /* a response still to be delivered is freed by the worker */
+    if (instance->asyncMutex != NULL) {
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        if (slot->state == XPLR_CELL_HTTP_ASYNC_IDLE) {
+            free(slot->rsp);
+            slot->rsp = NULL;
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    } else {
+        // do nothing
+    }
 }
 
 void xplrCellHttpDisconnect(int8_t dvcProfile, int8_t clientId)
 {
-    uHttpClientContext_t *context = http[dvcProfile].clientContext[clientId];
-    uHttpClientClose(context);
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    uHttpClientContext_t *context;
+    xplrCell_http_async_slot_t *slot = &instance->asyncSlot[clientId];
+    bool closing = false;
+
+    if (instance->asyncMutex != NULL) {
+        /*
+         * the request in flight keeps its slot until the connection is closed,
+         * ubxlib may still write its response until then. The queued ones are
+         * dropped by the worker.
+         */
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        context = instance->clientContext[clientId];
+        instance->clientContext[clientId] = NULL;
+        if (slot->state == XPLR_CELL_HTTP_ASYNC_SENT) {
+            slot->state = XPLR_CELL_HTTP_ASYNC_CLOSING;
+            closing = true;
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    } else {
+        context = instance->clientContext[clientId];
+        instance->clientContext[clientId] = NULL;
+    }
+
+    if (context != NULL) {
+        uHttpClientClose(context);
+    } else {
+        // do nothing
+    }
+
+    if (instance->asyncMutex != NULL) {
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        if (closing) {
+            slot->status = XPLR_CELL_HTTP_STATUS_DROPPED;
+            slot->rspSize = 0;
+            slot->state = XPLR_CELL_HTTP_ASYNC_COMPLETED;
+        } else {
+            // do nothing
+        }
+        if (instance->asyncTask != NULL) {
+            xTaskNotifyGive(instance->asyncTask);
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    } else {
+        // do nothing
+    }
 }
 
 xplrCell_http_error_t xplrCellHttpCertificateSaveRootCA(int8_t dvcProfile,
@@ -271,13 +407,21 @@ xplrCell_http_error_t xplrCellHttpPostRequest(int8_t dvcProfile,
     xplrCell_http_client_t *client = http[dvcProfile].client[clientId];
     uHttpClientContext_t *context = http[dvcProfile].clientContext[clientId];
     int32_t ubxResult;
-    xplrCell_http_error_t ret;
+    xplrCell_http_error_t ret = XPLR_CELL_HTTP_ERROR;
 
-    if (data != NULL) {
+    if (http[dvcProfile].asyncSlot[clientId].state != XPLR_CELL_HTTP_ASYNC_IDLE) {
+        XPLRCELL_HTTP_CONSOLE(W, "Device %d, Http client %d serving an asynchronous request.",
+                              dvcProfile, clientId);
+        ret = XPLR_CELL_HTTP_BUSY;
+    } else if (data != NULL) {
         client->session->data = *data;
+    } else {
+        // do nothing
     }
 
-    if (client->session->data.path != NULL) {
+    if (ret == XPLR_CELL_HTTP_BUSY) {
+        // do nothing
+    } else if (client->session->data.path != NULL) {
         ubxResult = uHttpClientPostRequest(context,
                                            client->session->data.path,
                                            &client->session->data.buffer[0],
@@ -321,13 +465,21 @@ xplrCell_http_error_t xplrCellHttpGetRequest(int8_t dvcProfile,
     xplrCell_http_client_t *client = http[dvcProfile].client[clientId];
     uHttpClientContext_t *context = http[dvcProfile].clientContext[clientId];
     int32_t ubxResult;
-    xplrCell_http_error_t ret;
+    xplrCell_http_error_t ret = XPLR_CELL_HTTP_ERROR;
 
-    if (data != NULL) {
+    if (http[dvcProfile].asyncSlot[clientId].state != XPLR_CELL_HTTP_ASYNC_IDLE) {
+        XPLRCELL_HTTP_CONSOLE(W, "Device %d, Http client %d serving an asynchronous request.",
+                              dvcProfile, clientId);
+        ret = XPLR_CELL_HTTP_BUSY;
+    } else if (data != NULL) {
         client->session->data = *data;
+    } else {
+        // do nothing
     }
 
-    if (client->session->data.path != NULL) {
+    if (ret == XPLR_CELL_HTTP_BUSY) {
+        // do nothing
+    } else if (client->session->data.path != NULL) {
         ubxResult = uHttpClientGetRequest(context,
                                           client->session->data.path,
                                           &client->session->data.buffer[0],
@@ -361,6 +513,135 @@ xplrCell_http_error_t xplrCellHttpGetRequest(int8_t dvcProfile,
     return ret;
 }
 
+xplrCell_http_error_t xplrCellHttpRequestAsync(int8_t dvcProfile,
+                                               const xplrCell_http_request_t *request,
+                                               int32_t *requestId)
+{
+    xplrCell_Http_t *instance;
+    xplrCell_http_async_item_t *item;
+    int8_t clientId;
+    BaseType_t xRet;
+    xplrCell_http_error_t ret;
+
+    if ((dvcProfile < 0) || (dvcProfile >= XPLRCOM_NUMOF_DEVICES) ||
+        (request == NULL) || (request->path == NULL) ||
+        (http[dvcProfile].asyncMutex == NULL)) {
+        XPLRCELL_HTTP_CONSOLE(E, "Invalid asynchronous request.");
+        ret = XPLR_CELL_HTTP_ERROR;
+    } else {
+        instance = &http[dvcProfile];
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        clientId = asyncRoute(dvcProfile, request);
+        if (clientId < 0) {
+            ret = XPLR_CELL_HTTP_ERROR;
+        } else if (instance->asyncQueueLen >= XPLRCELL_HTTP_ASYNC_QUEUE_LEN) {
+            XPLRCELL_HTTP_CONSOLE(W, "Device %d, asynchronous request queue full.", dvcProfile);
+            ret = XPLR_CELL_HTTP_BUSY;
+        } else {
+            item = &instance->asyncQueue[instance->asyncQueueLen];
+            item->request = *request;
+            item->clientId = clientId;
+            item->id = instance->asyncNextId;
+            ret = XPLR_CELL_HTTP_OK;
+
+            if (instance->asyncTask == NULL) {
+                xRet = xTaskCreate(asyncTask,
+                                   "cellHttpTask",
+                                   XPLRCELL_HTTP_ASYNC_TASK_STACK,
+                                   (void *)(intptr_t)dvcProfile,
+                                   XPLRCELL_HTTP_ASYNC_TASK_PRIO,
+                                   &instance->asyncTask);
+                if (xRet != pdPASS) {
+                    instance->asyncTask = NULL;
+                    XPLRCELL_HTTP_CONSOLE(E, "Device %d, could not create the http task.", dvcProfile);
+                    ret = XPLR_CELL_HTTP_ERROR;
+                } else {
+                    // do nothing
+                }
+            } else {
+                xTaskNotifyGive(instance->asyncTask);
+            }
+
+            if (ret == XPLR_CELL_HTTP_OK) {
+                instance->asyncQueueLen++;
+                instance->asyncNextId = (instance->asyncNextId < INT32_MAX) ?
+                                        (instance->asyncNextId + 1) : 0;
+                if (requestId != NULL) {
+                    *requestId = item->id;
+                } else {
+                    // do nothing
+                }
+                XPLRCELL_HTTP_CONSOLE(D, "Device %d, request %d to %s queued on client %d.",
+                                      dvcProfile, item->id, request->path, clientId);
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    }
+
+    return ret;
+}
+
+xplrCell_http_error_t xplrCellHttpCancelAsync(int8_t dvcProfile, int32_t requestId)
+{
+    xplrCell_Http_t *instance;
+    xplrCell_http_error_t ret = XPLR_CELL_HTTP_ERROR;
+
+    if ((dvcProfile >= 0) && (dvcProfile < XPLRCOM_NUMOF_DEVICES) &&
+        (http[dvcProfile].asyncMutex != NULL)) {
+        instance = &http[dvcProfile];
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        for (uint8_t i = 0; (i < instance->asyncQueueLen) && (ret != XPLR_CELL_HTTP_OK); i++) {
+            if (instance->asyncQueue[i].id == requestId) {
+                memmove(&instance->asyncQueue[i],
+                        &instance->asyncQueue[i + 1],
+                        (instance->asyncQueueLen - i - 1) * sizeof(xplrCell_http_async_item_t));
+                instance->asyncQueueLen--;
+                ret = XPLR_CELL_HTTP_OK;
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    } else {
+        // do nothing
+    }
+
+    if (ret != XPLR_CELL_HTTP_OK) {
+        XPLRCELL_HTTP_CONSOLE(W, "Device %d, request %d is not queued.", dvcProfile, requestId);
+    } else {
+        XPLRCELL_HTTP_CONSOLE(D, "Device %d, request %d cancelled.", dvcProfile, requestId);
+    }
+
+    return ret;
+}
+
+uint8_t xplrCellHttpGetAsyncPending(int8_t dvcProfile)
+{
+    xplrCell_Http_t *instance;
+    uint8_t ret = 0;
+
+    if ((dvcProfile >= 0) && (dvcProfile < XPLRCOM_NUMOF_DEVICES) &&
+        (http[dvcProfile].asyncMutex != NULL)) {
+        instance = &http[dvcProfile];
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        ret = instance->asyncQueueLen;
+        for (int8_t i = 0; i < XPLRCELL_HTTP_NUMOF_CLIENTS; i++) {
+            if (instance->asyncSlot[i].state != XPLR_CELL_HTTP_ASYNC_IDLE) {
+                ret++;
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGive(instance->asyncMutex);
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
 int8_t xplrCellHttpInitLogModule(xplr_cfg_logInstance_t *logCfg)
 {
     int8_t ret;
@@ -586,9 +867,13 @@ xplrCell_http_error_t clientConnect(int8_t dvcProfile, int8_t clientId)
     connection->pServerName = client->settings.serverAddress;
     connection->timeoutSeconds = client->settings.timeoutSeconds;
     connection->errorOnBusy = client->settings.errorOnBusy;
-    if (client->settings.async) {
+    if (client->settings.async && (client->responseCb != NULL)) {
         connection->pResponseCallback = client->responseCb;
         connection->pResponseCallbackParam = &client->msgAvailable;
+    } else if (client->settings.async) {
+        /* no user callback, the client serves xplrCellHttpRequestAsync() */
+        connection->pResponseCallback = asyncResponseCb;
+        connection->pResponseCallbackParam = &http[dvcProfile].asyncSlot[clientId];
     } else {
         connection->pResponseCallback = NULL;
         connection->pResponseCallbackParam = NULL;
@@ -729,4 +1014,402 @@ xplrCell_http_error_t clientConnect(int8_t dvcProfile, int8_t clientId)
     return ret;
 }
 
+/**
+ * Client serving a request, either the one asked for or the one connected
+ * to the request host. Call with the async mutex taken.
+ */
+static int8_t asyncRoute(int8_t dvcProfile, const xplrCell_http_request_t *request)
+{
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_client_t *client;
+    size_t hostLen;
+    int8_t ret = -1;
+
+    if (request->clientId >= 0) {
+        if (request->clientId < XPLRCELL_HTTP_NUMOF_CLIENTS) {
+            ret = request->clientId;
+        } else {
+            // do nothing
+        }
+    } else if (request->host != NULL) {
+        /* the server address may carry a port, the host may not */
+        hostLen = strlen(request->host);
+        for (int8_t i = 0; (i < XPLRCELL_HTTP_NUMOF_CLIENTS) && (ret < 0); i++) {
+            client = instance->client[i];
+            if ((client != NULL) &&
+                (instance->clientContext[i] != NULL) &&
+                (client->settings.serverAddress != NULL) &&
+                (strncmp(client->settings.serverAddress, request->host, hostLen) == 0) &&
+                ((client->settings.serverAddress[hostLen] == 0) ||
+                 (client->settings.serverAddress[hostLen] == ':'))) {
+                ret = i;
+            } else {
+                // do nothing
+            }
+        }
+    } else {
+        // do nothing
+    }
+
+    if (ret < 0) {
+        XPLRCELL_HTTP_CONSOLE(E, "Device %d, no client connected for the request.", dvcProfile);
+    } else if ((instance->client[ret] == NULL) || (instance->clientContext[ret] == NULL)) {
+        XPLRCELL_HTTP_CONSOLE(E, "Device %d, client %d not connected.", dvcProfile, ret);
+        ret = -1;
+    } else if (!instance->client[ret]->settings.async ||
+               (instance->client[ret]->responseCb != NULL)) {
+        XPLRCELL_HTTP_CONSOLE(E, "Device %d, client %d not set up for asynchronous requests.",
+                              dvcProfile, ret);
+        ret = -1;
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+/**
+ * True when nothing is queued or in flight. Call with the async mutex taken.
+ */
+static bool asyncIdle(xplrCell_Http_t *instance)
+{
+    bool ret = (instance->asyncQueueLen == 0);
+
+    for (int8_t i = 0; (i < XPLRCELL_HTTP_NUMOF_CLIENTS) && ret; i++) {
+        ret = (instance->asyncSlot[i].state == XPLR_CELL_HTTP_ASYNC_IDLE);
+    }
+
+    return ret;
+}
+
+/**
+ * Sends the oldest queued request of every free client, so that a busy
+ * client does not hold back the requests of the others.
+ * Requests of disconnected clients are dropped.
+ */
+static void asyncDispatch(int8_t dvcProfile)
+{
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_async_item_t item;
+    xplrCell_http_async_slot_t *slot;
+    uint8_t i;
+    bool dropped;
+    bool sent;
+
+    do {
+        dropped = false;
+        sent = false;
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        i = 0;
+        while ((i < instance->asyncQueueLen) && !dropped && !sent) {
+            item = instance->asyncQueue[i];
+            slot = &instance->asyncSlot[item.clientId];
+            if (instance->clientContext[item.clientId] == NULL) {
+                dropped = true;
+            } else if (slot->state == XPLR_CELL_HTTP_ASYNC_IDLE) {
+                slot->item = item;
+                slot->status = 0;
+                slot->rspSize = 0;
+                slot->truncated = false;
+                slot->startTick = xTaskGetTickCount();
+                slot->state = XPLR_CELL_HTTP_ASYNC_SENT;
+                sent = true;
+            } else {
+                i++;
+            }
+        }
+        if (dropped || sent) {
+            memmove(&instance->asyncQueue[i],
+                    &instance->asyncQueue[i + 1],
+                    (instance->asyncQueueLen - i - 1) * sizeof(xplrCell_http_async_item_t));
+            instance->asyncQueueLen--;
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+
+        /* item is only set when a request was taken from the queue */
+        if (dropped) {
+            XPLRCELL_HTTP_CONSOLE(W, "Device %d, request %d dropped, client %d disconnected.",
+                                  dvcProfile, item.id, item.clientId);
+            if (item.request.done != NULL) {
+                item.request.done(dvcProfile, item.id, XPLR_CELL_HTTP_STATUS_DROPPED, 0, false,
+                                  item.request.doneArg);
+            } else {
+                // do nothing
+            }
+        } else if (sent) {
+            asyncSend(dvcProfile, item.clientId);
+        } else {
+            // do nothing
+        }
+    } while (dropped || sent);
+}
+
+/**
+ * Hands the request of a slot, already marked as sent, to ubxlib.
+ * The mutex is held meanwhile so that the connection is not closed under it.
+ */
+static void asyncSend(int8_t dvcProfile, int8_t clientId)
+{
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_async_slot_t *slot = &instance->asyncSlot[clientId];
+    xplrCell_http_request_t *request = &slot->item.request;
+    uHttpClientContext_t *context;
+    int32_t ubxResult;
+
+    xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+    context = instance->clientContext[clientId];
+    if (slot->rsp == NULL) {
+        slot->rsp = malloc(XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE + 1);
+    } else {
+        // do nothing
+    }
+
+    if (slot->rsp == NULL) {
+        ubxResult = (int32_t)U_ERROR_COMMON_NO_MEMORY;
+    } else if ((context == NULL) || (slot->state != XPLR_CELL_HTTP_ASYNC_SENT)) {
+        ubxResult = XPLR_CELL_HTTP_STATUS_DROPPED;
+    } else {
+        slot->rspIo = XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE + 1;
+        if (request->method == XPLR_CELL_HTTP_METHOD_POST) {
+            ubxResult = uHttpClientPostRequest(context,
+                                               request->path,
+                                               request->body,
+                                               request->bodySize,
+                                               request->contentType,
+                                               slot->rsp,
+                                               &slot->rspIo,
+                                               slot->contentType);
+        } else {
+            ubxResult = uHttpClientGetRequest(context,
+                                              request->path,
+                                              slot->rsp,
+                                              &slot->rspIo,
+                                              slot->contentType);
+        }
+    }
+
+    if ((ubxResult < 0) && (slot->state == XPLR_CELL_HTTP_ASYNC_SENT)) {
+        slot->status = ubxResult;
+        slot->rspSize = 0;
+        slot->state = XPLR_CELL_HTTP_ASYNC_COMPLETED;
+    } else {
+        // do nothing
+    }
+    xSemaphoreGive(instance->asyncMutex);
+
+    if (ubxResult < 0) {
+        XPLRCELL_HTTP_CONSOLE(E, "Device %d, Http client %d failed to send request %d (%d).",
+                              dvcProfile, clientId, slot->item.id, ubxResult);
+    } else {
+        XPLRCELL_HTTP_CONSOLE(D, "Device %d, Http client %d sent request %d to %s.",
+                              dvcProfile, clientId, slot->item.id, request->path);
+    }
+}
+
+/**
+ * Gives up requests without a response past the client timeout and reopens
+ * their connection, so that a late response cannot land in the next request.
+ */
+static void asyncCheckTimeouts(int8_t dvcProfile)
+{
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_async_slot_t *slot;
+    xplrCell_http_client_t *client;
+    uHttpClientContext_t *context;
+    TickType_t limit;
+    bool expired;
+
+    for (int8_t i = 0; i < XPLRCELL_HTTP_NUMOF_CLIENTS; i++) {
+        slot = &instance->asyncSlot[i];
+        client = instance->client[i];
+        context = NULL;
+        expired = false;
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        if ((slot->state == XPLR_CELL_HTTP_ASYNC_SENT) && (client != NULL)) {
+            limit = pdMS_TO_TICKS(((uint32_t)client->settings.timeoutSeconds +
+                                   XPLRCELL_HTTP_ASYNC_TIMEOUT_MARGIN_S) * 1000U);
+            if ((xTaskGetTickCount() - slot->startTick) > limit) {
+                slot->state = XPLR_CELL_HTTP_ASYNC_CLOSING;
+                context = instance->clientContext[i];
+                instance->clientContext[i] = NULL;
+                expired = true;
+            } else {
+                // do nothing
+            }
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+
+        if (expired) {
+            XPLRCELL_HTTP_CONSOLE(W, "Device %d, Http client %d request %d timed out, reconnecting.",
+                                  dvcProfile, i, slot->item.id);
+            if (context != NULL) {
+                uHttpClientClose(context);
+            } else {
+                // do nothing
+            }
+            xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+            if (slot->state == XPLR_CELL_HTTP_ASYNC_CLOSING) {
+                slot->status = (int32_t)U_ERROR_COMMON_TIMEOUT;
+                slot->rspSize = 0;
+                slot->state = XPLR_CELL_HTTP_ASYNC_COMPLETED;
+            } else {
+                // do nothing
+            }
+            xSemaphoreGive(instance->asyncMutex);
+        } else {
+            // do nothing
+        }
+
+        if (expired && (context != NULL)) {
+            if (clientConnect(dvcProfile, i) != XPLR_CELL_HTTP_OK) {
+                XPLRCELL_HTTP_CONSOLE(E, "Device %d, Http client %d could not reconnect.",
+                                      dvcProfile, i);
+            } else {
+                // do nothing
+            }
+        } else {
+            // do nothing
+        }
+    }
+}
+
+/**
+ * Hands completed responses to their sink and done callbacks.
+ * A completed slot is left only here, so it is read without the mutex.
+ */
+static void asyncDeliver(int8_t dvcProfile)
+{
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    xplrCell_http_async_slot_t *slot;
+    xplrCell_http_request_t *request;
+    size_t offset;
+    size_t length;
+    bool completed;
+    bool keep;
+
+    for (int8_t i = 0; i < XPLRCELL_HTTP_NUMOF_CLIENTS; i++) {
+        slot = &instance->asyncSlot[i];
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        completed = (slot->state == XPLR_CELL_HTTP_ASYNC_COMPLETED);
+        xSemaphoreGive(instance->asyncMutex);
+
+        if (completed) {
+            request = &slot->item.request;
+            if ((request->sink != NULL) && (slot->status >= 0) && (slot->rsp != NULL)) {
+                keep = true;
+                for (offset = 0; (offset < slot->rspSize) && keep; offset += length) {
+                    length = slot->rspSize - offset;
+                    if (length > XPLRCELL_HTTP_ASYNC_SINK_CHUNK) {
+                        length = XPLRCELL_HTTP_ASYNC_SINK_CHUNK;
+                    } else {
+                        // do nothing
+                    }
+                    keep = request->sink(&slot->rsp[offset], length, offset, request->sinkArg);
+                }
+            } else {
+                // do nothing
+            }
+
+            if (slot->truncated) {
+                XPLRCELL_HTTP_CONSOLE(W, "Device %d, Http client %d request %d response truncated to %u bytes.",
+                                      dvcProfile, i, slot->item.id, (unsigned int)slot->rspSize);
+            } else {
+                // do nothing
+            }
+            XPLRCELL_HTTP_CONSOLE(D, "Device %d, Http client %d request %d done (%d, %u bytes).",
+                                  dvcProfile, i, slot->item.id, slot->status,
+                                  (unsigned int)slot->rspSize);
+            if (request->done != NULL) {
+                request->done(dvcProfile, slot->item.id, slot->status, slot->rspSize,
+                              slot->truncated, request->doneArg);
+            } else {
+                // do nothing
+            }
+
+            xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+            slot->state = XPLR_CELL_HTTP_ASYNC_IDLE;
+            if (instance->clientContext[i] == NULL) {
+                free(slot->rsp);
+                slot->rsp = NULL;
+            } else {
+                // do nothing
+            }
+            xSemaphoreGive(instance->asyncMutex);
+        } else {
+            // do nothing
+        }
+    }
+}
+
+static void asyncTask(void *pvParams)
+{
+    int8_t dvcProfile = (int8_t)(intptr_t)pvParams;
+    xplrCell_Http_t *instance = &http[dvcProfile];
+    bool idle = false;
+
+    while (!idle) {
+        asyncCheckTimeouts(dvcProfile);
+        asyncDeliver(dvcProfile);
+        asyncDispatch(dvcProfile);
+
+        xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+        idle = asyncIdle(instance);
+        if (idle) {
+            instance->asyncTask = NULL;
+        } else {
+            // do nothing
+        }
+        xSemaphoreGive(instance->asyncMutex);
+
+        if (!idle) {
+            (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(XPLRCELL_HTTP_ASYNC_POLL_MS));
+        } else {
+            // do nothing
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC CALLBACK FUNCTION DEFINITIONS
+ * -------------------------------------------------------------- */
+
+static void asyncResponseCb(uDeviceHandle_t devHandle,
+                            int32_t statusCodeOrError,
+                            size_t responseSize,
+                            void *pResponseCallbackParam)
+{
+    xplrCell_http_async_slot_t *slot = (xplrCell_http_async_slot_t *)pResponseCallbackParam;
+    xplrCell_Http_t *instance = &http[slot->dvcProfile];
+    (void)devHandle;
+
+    xSemaphoreTake(instance->asyncMutex, portMAX_DELAY);
+    /* a request given up or dropped already left the sent state */
+    if (slot->state == XPLR_CELL_HTTP_ASYNC_SENT) {
+        slot->status = statusCodeOrError;
+        slot->rspSize = (statusCodeOrError >= 0) ? responseSize : 0;
+        /* the buffer has room for one more byte, filling it means the body was cut */
+        if (slot->rspSize > XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE) {
+            slot->rspSize = XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE;
+            slot->truncated = true;
+        } else {
+            // do nothing
+        }
+        slot->state = XPLR_CELL_HTTP_ASYNC_COMPLETED;
+        if (instance->asyncTask != NULL) {
+            xTaskNotifyGive(instance->asyncTask);
+        } else {
+            // do nothing
+        }
+    } else {
+        // do nothing
+    }
+    xSemaphoreGive(instance->asyncMutex);
+}
+
 // End of file
@@ -68,6 +68,9 @@ void xplrCellHttpDeInit(int8_t dvcProfile, int8_t clientId);
 /**
  * @brief Disconnect HTTP client from current server.
  *        Checks if client is currently connected to a server and disconnects.
+ *        An asynchronous request in flight on the client is reported as
+ *        XPLR_CELL_HTTP_STATUS_DROPPED once the connection is closed, queued
+ *        ones are dropped by the worker.
  *
  * @param  dvcProfile   hpgLib device id.
  * @param  clientId     HTTP client index to disconnect from server.
@@ -135,6 +138,47 @@ xplrCell_http_error_t xplrCellHttpGetRequest(int8_t dvcProfile,
                                              int8_t clientId,
                                              xplrCell_http_dataTransfer_t *data);
 
+/**
+ * @brief Queue an asynchronous HTTP request.
+ *        Requests wait in a bounded queue per device and are sent by a worker task
+ *        over connections already open with xplrCellHttpConnect(), which stay open
+ *        between requests. Each client serves one request at a time, so requests
+ *        to different clients are in flight together while the ones to the same
+ *        client keep their order.
+ *        The response body is handed to request->sink in pieces, then request->done
+ *        is called, both from the worker task. Bodies longer than
+ *        XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE are cut to that size and reported
+ *        as truncated to request->done.
+ *        Clients opened with settings.async need a NULL responseCb to be used here.
+ *
+ * @param  dvcProfile   hpgLib device id.
+ * @param  request      request to send, copied in the queue.
+ * @param  requestId    returns the id given to done, can be NULL.
+ * @return XPLR_CELL_HTTP_OK on success, XPLR_CELL_HTTP_BUSY when the queue is full,
+ *         XPLR_CELL_HTTP_ERROR otherwise.
+ */
+xplrCell_http_error_t xplrCellHttpRequestAsync(int8_t dvcProfile,
+                                               const xplrCell_http_request_t *request,
+                                               int32_t *requestId);
+
+/**
+ * @brief Remove an asynchronous request that is still waiting in the queue.
+ *        Its done callback is not called. Requests already sent cannot be cancelled.
+ *
+ * @param  dvcProfile   hpgLib device id.
+ * @param  requestId    id returned by xplrCellHttpRequestAsync().
+ * @return XPLR_CELL_HTTP_OK on success, XPLR_CELL_HTTP_ERROR if not queued.
+ */
+xplrCell_http_error_t xplrCellHttpCancelAsync(int8_t dvcProfile, int32_t requestId);
+
+/**
+ * @brief Number of asynchronous requests queued or in flight.
+ *
+ * @param  dvcProfile   hpgLib device id.
+ * @return requests not done yet.
+ */
+uint8_t xplrCellHttpGetAsyncPending(int8_t dvcProfile);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
@@ -43,6 +43,9 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** Status of an asynchronous request dropped because its client was disconnected. */
+#define XPLR_CELL_HTTP_STATUS_DROPPED   (-1000)
+
 /* ----------------------------------------------------------------
  * PUBLIC TYPES
  * -------------------------------------------------------------- */
@@ -108,6 +111,49 @@ typedef enum {
     XPLR_CELL_HTTP_CLIENT_FSM_READY
 } xplrCell_http_client_fsm_t;
 
+/** Methods of an asynchronous HTTP request. */
+typedef enum {
+    XPLR_CELL_HTTP_METHOD_GET = 0,  /**< HTTP GET. */
+    XPLR_CELL_HTTP_METHOD_POST      /**< HTTP POST. */
+} xplrCell_http_method_t;
+
+/**
+ * Receives the response body of an asynchronous request piece by piece.
+ * Return false to drop the rest of the body.
+ */
+typedef bool (*xplrCell_http_sink_t)(const char *data, size_t length, size_t offset, void *arg);
+
+/**
+ * Called once an asynchronous request is over, after its body went to the sink.
+ * statusCode is the HTTP status code, or a negative ubxlib error code or
+ * XPLR_CELL_HTTP_STATUS_DROPPED when the request failed.
+ * truncated is set when the body was longer than XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE,
+ * only its first rspSize bytes went to the sink then.
+ */
+typedef void (*xplrCell_http_done_t)(int8_t dvcProfile,
+                                     int32_t requestId,
+                                     int32_t statusCode,
+                                     size_t rspSize,
+                                     bool truncated,
+                                     void *arg);
+
+/** Asynchronous HTTP request, given to xplrCellHttpRequestAsync(). */
+// *INDENT-OFF*
+typedef struct xplrCell_http_request_type {
+    xplrCell_http_method_t  method;         /**< GET or POST. */
+    int8_t                  clientId;       /**< client to use, -1 to use the client connected to host. */
+    const char              *host;          /**< server address, used when clientId is -1. */
+    const char              *path;          /**< path of the request, must stay valid until done. */
+    const char              *body;          /**< POST body, must stay valid until done. */
+    size_t                  bodySize;       /**< POST body size. */
+    const char              *contentType;   /**< POST content type. */
+    xplrCell_http_sink_t    sink;           /**< receives the response body, can be NULL. */
+    void                    *sinkArg;       /**< user argument of sink. */
+    xplrCell_http_done_t    done;           /**< completion callback, can be NULL. */
+    void                    *doneArg;       /**< user argument of done. */
+} xplrCell_http_request_t;
+// *INDENT-ON*
+
 typedef struct xplrCell_http_dataTransfer_type {
     char            *path;
     char            contentType[U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES];
@@ -148,7 +194,9 @@ typedef struct xplrCell_http_client_type {
                                                        element 0 holds most current state.
                                                        d element 1 holds previous state */
     bool                            msgAvailable; /**< indicates if a message is available to read. */
-    uHttpClientResponseCallback_t   *responseCb;  /**< function pointer to msg received callback. */
+    uHttpClientResponseCallback_t   *responseCb;  /**< function pointer to msg received callback.
+                                                       NULL with settings.async to serve
+                                                       xplrCellHttpRequestAsync() requests. */
 } xplrCell_http_client_t;
 
 #ifdef __cplusplus
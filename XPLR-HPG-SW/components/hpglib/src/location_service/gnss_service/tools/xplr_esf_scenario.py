@@ -0,0 +1,366 @@
+#!/usr/bin/env python
+#
+# Copyright 2023 u-blox Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Synthesize a UBX stream of a ZED-F9R driving through a Dead Reckoning
+scenario, for replay through the GNSS service parsers with
+xplrGnssReplayUbxMessage().
+
+Every epoch (1 Hz) holds NAV-PVT, NAV-HPPOSLLH, ESF-INS, ESF-ALG and
+ESF-STATUS, with the payload offsets the parsers in xplr_gnss.c decode,
+preceded by UPD-SOS when the receiver reports its Save on Shutdown status.
+The expected DR state of each epoch, whether the ESF-ALG angles are within
+the mount alignment limits and the expected Save on Shutdown status are
+printed, or written as CSV with --expect, to compare against
+xplrGnssGetDrHealth(), the DR events and the decoders of xplr_gnss_dr.c.
+
+Scenarios:
+  tunnel        open sky, GNSS lost for a while, fusion keeps going
+  garage        drive in, GNSS lost, parked, fusion restarts on exit
+  dropout       wheel tick sensor stops, fusion suspended until it is back
+  misalignment  sensor moved: alignment errors, re-calibration, angles on and
+                out of the alignment limits
+  shutdown      restore status at start, backup acknowledges when parking
+"""
+
+import argparse
+import csv
+import math
+import struct
+import sys
+
+# ESF-ALG status (flags bits 1-3)
+ALG_USER_DEFINED = 0
+ALG_RPY_CALIBRATING = 2
+ALG_FINE = 4
+
+# ESF-STATUS fusion mode
+FUSION_INIT = 0
+FUSION_ENABLED = 1
+FUSION_SUSPENDED = 2
+
+# ESF-ALG errors
+ALG_ERR_TILT = 0x01
+ALG_ERR_YAW = 0x02
+ALG_ERR_ANGLE = 0x04
+
+# ESF-STATUS sensor faults
+FAULT_MISSING_MEAS = 0x04
+
+# IMU mount alignment limits in 1e-2 degrees, CFG-SFIMU-IMU_MNTALG
+YAW_MAX = 36000
+PITCH_MIN, PITCH_MAX = -9000, 9000
+ROLL_MIN, ROLL_MAX = -18000, 18000
+
+# angles reported while re-calibrating: (yaw, pitch, roll), within limits
+ALIGN_CASES = (
+    ((36500, -9500, 18500), False),
+    ((YAW_MAX, PITCH_MIN, ROLL_MIN), True),
+    ((0, PITCH_MAX, ROLL_MAX), True),
+    ((YAW_MAX + 1, 0, 0), False),
+    ((0xFFFFFFFF, 0, 0), False),
+    ((0, PITCH_MIN - 1, 0), False),
+    ((0, PITCH_MAX + 1, 0), False),
+    ((0, 0, ROLL_MIN - 1), False),
+    ((0, 0, ROLL_MAX + 1), False),
+    ((0, -32768, 32767), False),
+)
+
+# UPD-SOS commands and Save on Shutdown states (xplrGnssSoSConfigStates_t)
+SOS_CMD_CREATE_ACK = 2
+SOS_CMD_RESTORED = 3
+SOS_ERROR = -1
+SOS_INITIAL = 0
+SOS_UNKNOWN = 1
+SOS_ACKNOWLEDGED = 2
+SOS_FAILED_RESTORE = 3
+SOS_RESTORED = 4
+SOS_NO_BACKUP = 5
+
+# shutdown scenario, (second, cmd, response): negative seconds count from the end
+SOS_EVENTS = (
+    (0, SOS_CMD_RESTORED, 2),       # restored from backup
+    (5, SOS_CMD_RESTORED, 3),       # no backup
+    (10, SOS_CMD_RESTORED, 1),      # backup there but not restored
+    (15, SOS_CMD_RESTORED, 0),      # unknown
+    (20, SOS_CMD_RESTORED, 7),      # invalid response
+    (-20, SOS_CMD_CREATE_ACK, 1),   # backup created
+    (-15, SOS_CMD_CREATE_ACK, 0),   # not acknowledged
+    (-10, SOS_CMD_CREATE_ACK, 9),   # invalid response
+    (-8, 5, 0),                     # unknown command
+    (-3, SOS_CMD_CREATE_ACK, 1),    # backup created
+)
+
+# sensor type, used for fusion
+SENSORS = (5, 8, 9, 12, 13, 14, 16, 17, 18)
+WHEEL_TICKS = (8, 9)
+
+FIX_NONE = 0
+FIX_DR = 1
+FIX_3D = 3
+
+GPS_EPOCH_ITOW_MS = 345600000
+
+
+def ubx_frame(msg_class, msg_id, payload):
+    """Wraps a payload in sync chars, header and Fletcher checksum."""
+    body = struct.pack("<BBH", msg_class, msg_id, len(payload)) + payload
+    ck_a = ck_b = 0
+    for byte in body:
+        ck_a = (ck_a + byte) & 0xFF
+        ck_b = (ck_b + ck_a) & 0xFF
+    return b"\xb5\x62" + body + bytes((ck_a, ck_b))
+
+
+def nav_pvt(itow, fix, lat, lon, h_acc_mm, speed_mms, heading):
+    payload = bytearray(92)
+    struct.pack_into("<IHBBBBB", payload, 0, itow, 2023, 6, 1, 12, 0, 0)
+    payload[20] = fix
+    payload[21] = 0x01 if fix != FIX_NONE else 0x00
+    payload[23] = 0 if fix in (FIX_NONE, FIX_DR) else 18
+    struct.pack_into("<iiii", payload, 24, int(lon * 1e7), int(lat * 1e7), 100000, 52000)
+    struct.pack_into("<II", payload, 40, h_acc_mm, h_acc_mm * 2)
+    struct.pack_into("<i", payload, 60, speed_mms)
+    struct.pack_into("<i", payload, 64, int(heading * 1e5))
+    return ubx_frame(0x01, 0x07, bytes(payload))
+
+
+def nav_hpposllh(itow, lat, lon, h_acc_mm):
+    payload = bytearray(36)
+    struct.pack_into("<I", payload, 4, itow)
+    struct.pack_into("<iiii", payload, 8, int(lon * 1e7), int(lat * 1e7), 100000, 52000)
+    struct.pack_into("<II", payload, 28, h_acc_mm * 10, h_acc_mm * 20)
+    return ubx_frame(0x01, 0x14, bytes(payload))
+
+
+def esf_ins(itow, yaw_rate, accel_x):
+    payload = bytearray(36)
+    struct.pack_into("<I", payload, 0, 0x3F00)
+    struct.pack_into("<I", payload, 8, itow)
+    struct.pack_into("<iiiiii", payload, 12, 0, 0, int(yaw_rate * 1e3),
+                     int(accel_x * 1e2), 0, 0)
+    return ubx_frame(0x10, 0x15, bytes(payload))
+
+
+def esf_alg(itow, status, errors, yaw, pitch, roll):
+    payload = bytearray(16)
+    struct.pack_into("<I", payload, 0, itow)
+    payload[4] = 1
+    payload[5] = (status << 1) & 0x0E
+    payload[6] = errors
+    struct.pack_into("<Ihh", payload, 8, yaw, pitch, roll)
+    return ubx_frame(0x10, 0x14, bytes(payload))
+
+
+def esf_status(itow, fusion, faults):
+    payload = bytearray(16 + 4 * len(SENSORS))
+    struct.pack_into("<I", payload, 0, itow)
+    payload[4] = 2
+    payload[12] = fusion
+    payload[15] = len(SENSORS)
+    for i, sensor in enumerate(SENSORS):
+        fault = faults.get(sensor, 0)
+        ready = 0 if fault else 1
+        calib = 1 if fault else 2
+        struct.pack_into("<BBBB", payload, 16 + 4 * i,
+                         sensor | (1 << 6) | (ready << 7), calib, 10, fault)
+    return ubx_frame(0x10, 0x10, bytes(payload))
+
+
+def upd_sos(cmd, response):
+    payload = bytearray(8)
+    payload[0] = cmd
+    payload[4] = response
+    return ubx_frame(0x09, 0x14, bytes(payload))
+
+
+def align_valid(yaw, pitch, roll):
+    return (yaw <= YAW_MAX and PITCH_MIN <= pitch <= PITCH_MAX and
+            ROLL_MIN <= roll <= ROLL_MAX)
+
+
+class Backup:
+    """Save on Shutdown status as the HPS interface description defines it."""
+
+    def __init__(self):
+        self.state = SOS_INITIAL
+        self.has_backup = 0
+        self.is_restored = 0
+
+    def update(self, cmd, response):
+        if cmd == SOS_CMD_CREATE_ACK:
+            self.has_backup = 1 if response == 1 else 0
+            self.state = {0: SOS_UNKNOWN, 1: SOS_ACKNOWLEDGED}.get(response, SOS_ERROR)
+        elif cmd == SOS_CMD_RESTORED:
+            self.is_restored = 1 if response == 2 else 0
+            if response == 1:
+                self.has_backup = 1
+            self.state = {0: SOS_UNKNOWN, 1: SOS_FAILED_RESTORE, 2: SOS_RESTORED,
+                          3: SOS_NO_BACKUP}.get(response, SOS_ERROR)
+        else:
+            self.has_backup = 0
+            self.is_restored = 0
+            self.state = SOS_ERROR
+
+
+class Epoch:
+    """Vehicle and receiver state of one second."""
+
+    def __init__(self):
+        self.fix = FIX_3D
+        self.h_acc_mm = 20
+        self.speed = 12.0
+        self.alg = ALG_FINE
+        self.alg_errors = 0
+        self.angles = (18000, -120, 80)
+        self.fusion = FUSION_ENABLED
+        self.faults = {}
+        self.sos = None
+        self.note = ""
+
+
+def scenario_tunnel(t, e, duration):
+    start, end = duration // 3, 2 * duration // 3
+    if start <= t < end:
+        e.fix = FIX_DR
+        e.h_acc_mm = 20 + 400 * (t - start)
+        e.note = "in tunnel"
+
+
+def scenario_garage(t, e, duration):
+    enter, leave = duration // 4, 3 * duration // 4
+    if enter <= t < leave:
+        e.fix = FIX_DR if t < enter + 10 else FIX_NONE
+        e.speed = max(0.0, 12.0 - 2.0 * (t - enter))
+        e.h_acc_mm = 5000
+        e.note = "parked" if e.speed == 0 else "entering"
+    elif leave <= t < leave + 20:
+        e.fusion = FUSION_INIT
+        e.alg = ALG_RPY_CALIBRATING
+        e.note = "fusion restarting"
+
+
+def scenario_dropout(t, e, duration):
+    start, end = duration // 3, duration // 3 + 15
+    if start <= t < end:
+        e.faults = {sensor: FAULT_MISSING_MEAS for sensor in WHEEL_TICKS}
+        e.fusion = FUSION_SUSPENDED
+        e.note = "wheel ticks missing"
+
+
+def scenario_misalignment(t, e, duration):
+    moved = duration // 3
+    if moved <= t < moved + 5:
+        e.alg_errors = ALG_ERR_YAW | ALG_ERR_ANGLE
+        e.note = "sensor moved"
+    elif moved + 5 <= t < 2 * duration // 3:
+        e.alg = ALG_RPY_CALIBRATING
+        e.alg_errors = ALG_ERR_TILT
+        e.fusion = FUSION_INIT
+        # on and out of the yaw/pitch/roll limits, one case per second
+        e.angles, valid = ALIGN_CASES[(t - moved - 5) % len(ALIGN_CASES)]
+        e.note = "re-calibrating, angles %s" % ("in limits" if valid else "out of limits")
+    elif t >= 2 * duration // 3:
+        e.angles = (9000, 150, -60)
+        e.note = "aligned again"
+
+
+def scenario_shutdown(t, e, duration):
+    for second, cmd, response in SOS_EVENTS:
+        if t == second % duration:
+            e.sos = (cmd, response)
+            e.note = "UPD-SOS cmd %d response %d" % (cmd, response)
+    if t >= duration - 25:
+        e.speed = max(0.0, 12.0 - 2.0 * (t - duration + 25))
+        e.note = e.note or "parking"
+
+
+SCENARIOS = {
+    "tunnel": scenario_tunnel,
+    "garage": scenario_garage,
+    "dropout": scenario_dropout,
+    "misalignment": scenario_misalignment,
+    "shutdown": scenario_shutdown,
+}
+
+
+def generate(name, duration, lat, lon, heading):
+    """Yields (epoch second, Epoch, Backup, frames) for the whole scenario."""
+    backup = Backup()
+    for t in range(duration):
+        epoch = Epoch()
+        SCENARIOS[name](t, epoch, duration)
+        itow = GPS_EPOCH_ITOW_MS + 1000 * t
+        dist = epoch.speed * t
+        lat_t = lat + (dist * math.cos(math.radians(heading))) / 111320.0
+        lon_t = lon + (dist * math.sin(math.radians(heading))) / (111320.0 * math.cos(math.radians(lat)))
+        frames = [
+            nav_pvt(itow, epoch.fix, lat_t, lon_t, epoch.h_acc_mm, int(epoch.speed * 1000), heading),
+            nav_hpposllh(itow, lat_t, lon_t, epoch.h_acc_mm),
+            esf_ins(itow, 0.0, 0.0),
+            esf_alg(itow, epoch.alg, epoch.alg_errors, *epoch.angles),
+            esf_status(itow, epoch.fusion, epoch.faults),
+        ]
+        if epoch.sos is not None:
+            backup.update(*epoch.sos)
+            frames.insert(0, upd_sos(*epoch.sos))
+        yield t, epoch, backup, frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("scenario", choices=sorted(SCENARIOS))
+    parser.add_argument("output", help="UBX file to write")
+    parser.add_argument("--duration", type=int, default=180, help="length in seconds")
+    parser.add_argument("--lat", type=float, default=37.9755, help="start latitude")
+    parser.add_argument("--lon", type=float, default=23.7348, help="start longitude")
+    parser.add_argument("--heading", type=float, default=90.0, help="driving direction in degrees")
+    parser.add_argument("--expect", help="CSV file receiving the expected state of each epoch")
+    args = parser.parse_args()
+
+    frames_out = 0
+    rows = []
+    with open(args.output, "wb") as out:
+        for t, epoch, backup, frames in generate(args.scenario, args.duration,
+                                         args.lat, args.lon, args.heading):
+            for frame in frames:
+                out.write(frame)
+            frames_out += len(frames)
+            rows.append((t, epoch.fix, epoch.fusion, epoch.alg, epoch.alg_errors,
+                         sum(set(epoch.faults.values())), int(align_valid(*epoch.angles)),
+                         backup.state, backup.has_backup, backup.is_restored, epoch.note))
+
+    if args.expect:
+        with open(args.expect, "w", newline="") as expect:
+            writer = csv.writer(expect)
+            writer.writerow(("second", "fixType", "fusionMode", "algStatus",
+                             "algErrors", "sensorFaults", "anglesValid",
+                             "sosState", "hasBackup", "isRestored", "note"))
+            writer.writerows(rows)
+    else:
+        last = None
+        for row in rows:
+            if row[1:] != last:
+                print("%4ds fix=%d fusion=%d alg=%d algErr=0x%02x faults=0x%02x "
+                      "anglesValid=%d sos=%d hasBackup=%d restored=%d %s" % row)
+                last = row[1:]
+
+    print("%s: %d frames, %d epochs" % (args.output, frames_out, args.duration), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,491 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host replay of the Dead Reckoning scenarios of xplr_esf_scenario.py
+ * through the ESF and UPD-SOS decoders of the GNSS parsers (xplr_gnss_dr.c).
+ *
+ * Every scenario is generated with its expected state, then replayed frame
+ * by frame with the time taken from the iTOW of the frames. At the end of
+ * every epoch the decoded fusion mode, alignment status, alignment errors
+ * and sensor faults must match the expected ones, the ESF-INS, ESF-ALG and
+ * ESF-STATUS of the epoch must carry the same iTOW and the calibration score
+ * must follow the decoded state. The ESF-ALG angles must pass or fail the
+ * mount alignment limits as the scenario expects, on and beyond every limit,
+ * and the Save on Shutdown status decoded from UPD-SOS must match the one of
+ * the epoch. At the end of a scenario the DR health must
+ * count the alignment transitions, fault events, time in each fusion mode,
+ * time converged and degradations the scenario went through.
+ *
+ * The scenarios are then replayed again and again to report the messages
+ * decoded per second, frame checks included.
+ *
+ * Build and run on Linux, from this directory (python3 generates the scenarios):
+ *   gcc -O2 -g -I.. xplr_gnss_dr_replay.c ../xplr_gnss_dr.c -o xplr_gnss_dr_replay
+ *   gcc -O1 -g -fsanitize=address,undefined -I.. xplr_gnss_dr_replay.c ../xplr_gnss_dr.c -o xplr_gnss_dr_replay
+ *
+ * Usage:
+ *   xplr_gnss_dr_replay [-n passes] [scenario ...]
+ *
+ * Without scenarios tunnel, garage, dropout, misalignment and shutdown are
+ * replayed.
+ * Prints the checks of every scenario and PASS, or FAIL with the first
+ * mismatching epochs. The exit code is 0 on PASS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xplr_gnss_dr.h"
+
+#define SCENARIO_SCRIPT     "xplr_esf_scenario.py"
+#define DEFAULT_PASSES      (200U)
+#define EPOCHS_MAX          (3600U)
+#define FAILS_PRINTED       (5U)
+
+typedef struct {
+    int fixType;
+    int fusionMode;
+    int algStatus;
+    int algErrors;
+    int sensorFaults;
+    int anglesValid;
+    int sosState;
+    int hasBackup;
+    int isRestored;
+} expect_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    expect_t expect[EPOCHS_MAX];
+    unsigned epochs;
+} scenario_t;
+
+typedef struct {
+    unsigned frames;
+    unsigned esfFrames;
+    unsigned sosFrames;
+    unsigned outOfLimits;
+    unsigned degraded;
+    unsigned fails;
+    int sosDecoded;         /* result of the UPD-SOS of the epoch, -1 if none */
+} replay_t;
+
+static const char *defaultScenarios[] = {
+    "tunnel",
+    "garage",
+    "dropout",
+    "misalignment",
+    "shutdown"
+};
+
+/* ----------------------------------------------------------------
+ * SCENARIO FILES
+ * -------------------------------------------------------------- */
+
+static uint8_t *readFile(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t *buf = NULL;
+    long len;
+
+    if (file != NULL) {
+        if ((fseek(file, 0, SEEK_END) == 0) && ((len = ftell(file)) > 0)) {
+            rewind(file);
+            buf = malloc((size_t)len);
+            if ((buf != NULL) && (fread(buf, 1, (size_t)len, file) == (size_t)len)) {
+                *size = (size_t)len;
+            } else {
+                free(buf);
+                buf = NULL;
+            }
+        }
+        fclose(file);
+    }
+
+    return buf;
+}
+
+static int readExpect(const char *path, scenario_t *sc)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    unsigned second;
+    expect_t *e;
+    int ret = -1;
+
+    if (file != NULL) {
+        sc->epochs = 0;
+        ret = 0;
+        /*
+         * header, then second,fixType,fusionMode,algStatus,algErrors,sensorFaults,
+         * anglesValid,sosState,hasBackup,isRestored,note
+         */
+        while ((ret == 0) && (fgets(line, sizeof(line), file) != NULL)) {
+            if ((line[0] < '0') || (line[0] > '9')) {
+                continue;
+            }
+            e = &sc->expect[sc->epochs];
+            if ((sc->epochs >= EPOCHS_MAX) ||
+                (sscanf(line, "%u,%d,%d,%d,%d,%d,%d,%d,%d,%d", &second, &e->fixType,
+                        &e->fusionMode, &e->algStatus, &e->algErrors, &e->sensorFaults,
+                        &e->anglesValid, &e->sosState, &e->hasBackup, &e->isRestored) != 10) ||
+                (second != sc->epochs)) {
+                ret = -1;
+            } else {
+                sc->epochs++;
+            }
+        }
+        fclose(file);
+    }
+
+    return ret;
+}
+
+static int generate(const char *name, scenario_t *sc)
+{
+    char ubx[128];
+    char csv[128];
+    char cmd[512];
+    int ret = -1;
+
+    snprintf(ubx, sizeof(ubx), "xplr_dr_replay_%s.ubx", name);
+    snprintf(csv, sizeof(csv), "xplr_dr_replay_%s.csv", name);
+    snprintf(cmd, sizeof(cmd), "python3 %s %s %s --expect %s 2>/dev/null",
+             SCENARIO_SCRIPT, name, ubx, csv);
+    if (system(cmd) == 0) {
+        sc->data = readFile(ubx, &sc->size);
+        if ((sc->data != NULL) && (readExpect(csv, sc) == 0) && (sc->epochs > 0)) {
+            ret = 0;
+        }
+    }
+    remove(ubx);
+    remove(csv);
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * EXPECTATIONS
+ * -------------------------------------------------------------- */
+
+static int isConverged(int algStatus)
+{
+    return (algStatus == XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT) ||
+           (algStatus == XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT);
+}
+
+/* score of the calibration documented in xplr_gnss_dr.c, from the decoded sensors */
+static unsigned expectedScore(const xplrGnssDrData_t *dr, const expect_t *e)
+{
+    unsigned score = 0;
+    unsigned used = 0;
+    unsigned good = 0;
+    uint8_t i;
+
+    if (isConverged(e->algStatus)) {
+        score = (e->algStatus == XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT) ? 60 : 40;
+        score += (e->algErrors == 0) ? 20 : 0;
+        for (i = 0; i < dr->status.numSens; i++) {
+            if (dr->status.sensor[i].used) {
+                used++;
+                good += (dr->status.sensor[i].calibStatus == XPLR_GNNS_SENSOR_CALIB_CALIBRATED) &&
+                        (dr->status.sensor[i].faults.allFaults == 0);
+            }
+        }
+        score += (used > 0) ? (20 * good) / used : 0;
+    }
+
+    return score;
+}
+
+static void fail(replay_t *rp, unsigned epoch, const char *what, long got, long want)
+{
+    if (rp->fails < FAILS_PRINTED) {
+        printf("    epoch %u: %s is %ld, expected %ld\n", epoch, what, got, want);
+    }
+    rp->fails++;
+}
+
+static void checkEpoch(replay_t *rp,
+                       const xplrGnssDrData_t *dr,
+                       const xplrGnssShutdownCfg_t *backup,
+                       const expect_t *e,
+                       unsigned epoch)
+{
+    int anglesValid = xplrGnssDrAlignValsValid(&dr->info.data);
+
+    if (dr->status.fusionMode != e->fusionMode) {
+        fail(rp, epoch, "fusion mode", dr->status.fusionMode, e->fusionMode);
+    }
+    if (dr->info.status != e->algStatus) {
+        fail(rp, epoch, "alignment status", dr->info.status, e->algStatus);
+    }
+    if (dr->health.algErrors != e->algErrors) {
+        fail(rp, epoch, "alignment errors", dr->health.algErrors, e->algErrors);
+    }
+    if (dr->health.sensorFaults != e->sensorFaults) {
+        fail(rp, epoch, "sensor faults", dr->health.sensorFaults, e->sensorFaults);
+    }
+    if ((dr->health.fusionMode != dr->status.fusionMode) || (dr->health.algStatus != dr->info.status)) {
+        fail(rp, epoch, "health out of step", dr->health.fusionMode, dr->status.fusionMode);
+    }
+    if ((dr->info.epoch.iTOW != dr->status.epoch.iTOW) ||
+        (dr->dynamics.epoch.iTOW != dr->status.epoch.iTOW)) {
+        fail(rp, epoch, "ESF-INS/ALG iTOW", dr->info.epoch.iTOW, dr->status.epoch.iTOW);
+    }
+    if (dr->dynamics.valFlags.allFlags != 0x3F) {
+        fail(rp, epoch, "ESF-INS validity flags", dr->dynamics.valFlags.allFlags, 0x3F);
+    }
+    if (dr->health.score != expectedScore(dr, e)) {
+        fail(rp, epoch, "score", dr->health.score, expectedScore(dr, e));
+    }
+    if (anglesValid != e->anglesValid) {
+        fail(rp, epoch, "alignment angles within limits", anglesValid, e->anglesValid);
+    }
+    rp->outOfLimits += !anglesValid;
+    if (backup->state != e->sosState) {
+        fail(rp, epoch, "Save on Shutdown state", backup->state, e->sosState);
+    }
+    if ((backup->hasBackup != e->hasBackup) || (backup->isRestored != e->isRestored)) {
+        /* as hasBackup * 10 + isRestored */
+        fail(rp, epoch, "Save on Shutdown backup/restored flags",
+             backup->hasBackup * 10 + backup->isRestored, e->hasBackup * 10 + e->isRestored);
+    }
+    if ((rp->sosDecoded >= 0) && (rp->sosDecoded != (e->sosState != XPLR_GNSS_SOS_STATE_ERROR))) {
+        fail(rp, epoch, "UPD-SOS decode result", rp->sosDecoded, e->sosState != XPLR_GNSS_SOS_STATE_ERROR);
+    }
+    rp->sosDecoded = -1;
+}
+
+/* what the DR health must have counted over the whole scenario */
+static void checkScenario(replay_t *rp, const xplrGnssDrData_t *dr, const scenario_t *sc)
+{
+    uint32_t dwellMs[XPLR_GNSS_FUSION_MODE_DISABLED + 1] = {0};
+    unsigned transitions = 0;
+    unsigned faultEvents = 0;
+    unsigned degraded = 0;
+    uint32_t convergedMs = 0;
+    const expect_t *e;
+    const expect_t *prev;
+    unsigned t;
+    int mode;
+
+    for (t = 0; t < sc->epochs; t++) {
+        e = &sc->expect[t];
+        prev = (t > 0) ? &sc->expect[t - 1] : NULL;
+        if ((prev == NULL) || (e->algStatus != prev->algStatus)) {
+            transitions++;
+        }
+        /* ESF-ALG: alignment lost or new error, ESF-STATUS: new fault or fusion lost */
+        if (((e->algErrors & ~(prev ? prev->algErrors : 0)) != 0) ||
+            ((prev != NULL) && isConverged(prev->algStatus) && !isConverged(e->algStatus))) {
+            degraded++;
+        }
+        if ((e->sensorFaults & ~(prev ? prev->sensorFaults : 0)) != 0) {
+            faultEvents++;
+            degraded++;
+        } else if ((prev != NULL) && (prev->fusionMode == XPLR_GNSS_FUSION_MODE_ENABLED) &&
+                   ((e->fusionMode == XPLR_GNSS_FUSION_MODE_SUSPENDED) ||
+                    (e->fusionMode == XPLR_GNSS_FUSION_MODE_DISABLED))) {
+            degraded++;
+        }
+        if (t + 1 < sc->epochs) {
+            dwellMs[e->fusionMode] += 1000;
+        }
+        if (isConverged(e->algStatus) && (e->algErrors == 0)) {
+            convergedMs = ((prev != NULL) && isConverged(prev->algStatus) && (prev->algErrors == 0)) ?
+                          convergedMs + 1000 : 0;
+        } else {
+            convergedMs = 0;
+        }
+    }
+
+    if (dr->health.algTransitions != transitions) {
+        fail(rp, sc->epochs, "alignment transitions", dr->health.algTransitions, transitions);
+    }
+    if (dr->health.faultEvents != faultEvents) {
+        fail(rp, sc->epochs, "fault events", dr->health.faultEvents, faultEvents);
+    }
+    if (rp->degraded != degraded) {
+        fail(rp, sc->epochs, "degradations", rp->degraded, degraded);
+    }
+    for (mode = XPLR_GNSS_FUSION_MODE_INITIALIZATION; mode <= XPLR_GNSS_FUSION_MODE_DISABLED; mode++) {
+        if (dr->health.fusionDwellMs[mode] != dwellMs[mode]) {
+            fail(rp, sc->epochs, "fusion mode dwell ms", dr->health.fusionDwellMs[mode], dwellMs[mode]);
+        }
+    }
+    if (dr->health.convergedMs != convergedMs) {
+        fail(rp, sc->epochs, "converged ms", dr->health.convergedMs, convergedMs);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * REPLAY
+ * -------------------------------------------------------------- */
+
+/* what the UBX callback and gnssUbxDispatch() do with every frame */
+static void replay(const scenario_t *sc,
+                   xplrGnssDrData_t *dr,
+                   xplrGnssShutdownCfg_t *backup,
+                   replay_t *rp,
+                   int check)
+{
+    const uint8_t *frame;
+    size_t offset = 0;
+    size_t size;
+    int64_t nowUs;
+    unsigned epoch = 0;
+    bool degraded;
+
+    memset(dr, 0, sizeof(*dr));
+    xplrGnssDrReset(dr);
+    memset(backup, 0, sizeof(*backup));
+    memset(rp, 0, sizeof(*rp));
+    rp->sosDecoded = -1;
+
+    while (offset + 8 <= sc->size) {
+        frame = sc->data + offset;
+        size = (size_t)(frame[4] | (frame[5] << 8)) + 8;
+        if ((offset + size > sc->size) || !xplrGnssDrUbxFrameValid(frame, size)) {
+            fail(rp, epoch, "invalid frame at offset", (long)offset, -1);
+            break;
+        }
+        offset += size;
+        rp->frames++;
+        if ((frame[2] == XPLR_GNSS_DR_UBX_CLASS_UPD) && (frame[3] == XPLR_GNSS_DR_UBX_ID_UPD_SOS)) {
+            rp->sosFrames++;
+            rp->sosDecoded = xplrGnssDrUpdSosDecode(backup, frame);
+            continue;
+        }
+        if (frame[2] != XPLR_GNSS_DR_UBX_CLASS_ESF) {
+            continue;
+        }
+        rp->esfFrames++;
+        nowUs = (int64_t)(frame[6] | (frame[7] << 8) | (frame[8] << 16) | ((uint32_t)frame[9] << 24)) * 1000;
+        switch (frame[3]) {
+            case XPLR_GNSS_DR_UBX_ID_ESF_INS:
+                xplrGnssDrEsfInsDecode(dr, frame);
+                break;
+            case XPLR_GNSS_DR_UBX_ID_ESF_ALG:
+                rp->degraded += xplrGnssDrEsfAlgDecode(dr, frame, nowUs);
+                break;
+            case XPLR_GNSS_DR_UBX_ID_ESF_STATUS:
+                if (!xplrGnssDrEsfStatusDecode(dr, frame, nowUs, &degraded)) {
+                    fail(rp, epoch, "ESF-STATUS rejected, sensors", frame[21], XPLR_GNSS_SENSORS_MAX_CNT);
+                }
+                rp->degraded += degraded;
+                /* last message of an epoch */
+                if (check && (epoch < sc->epochs)) {
+                    checkEpoch(rp, dr, backup, &sc->expect[epoch], epoch);
+                }
+                epoch++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (check) {
+        if (epoch != sc->epochs) {
+            fail(rp, epoch, "epochs replayed", epoch, sc->epochs);
+        }
+        checkScenario(rp, dr, sc);
+    }
+}
+
+static double nowSec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* ----------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+    static scenario_t scenarios[sizeof(defaultScenarios) / sizeof(defaultScenarios[0]) + 8];
+    const char *names[sizeof(scenarios) / sizeof(scenarios[0])];
+    unsigned numScenarios = 0;
+    unsigned passes = DEFAULT_PASSES;
+    unsigned long long frames = 0;
+    xplrGnssDrData_t dr;
+    xplrGnssShutdownCfg_t backup;
+    replay_t rp;
+    double start;
+    double elapsed;
+    unsigned i;
+    unsigned p;
+    int ret = 0;
+
+    for (i = 1; i < (unsigned)argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < (unsigned)argc)) {
+            passes = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (numScenarios < sizeof(names) / sizeof(names[0])) {
+            names[numScenarios++] = argv[i];
+        }
+    }
+    if (numScenarios == 0) {
+        for (i = 0; i < sizeof(defaultScenarios) / sizeof(defaultScenarios[0]); i++) {
+            names[numScenarios++] = defaultScenarios[i];
+        }
+    }
+
+    for (i = 0; i < numScenarios; i++) {
+        if (generate(names[i], &scenarios[i]) != 0) {
+            printf("%s: cannot generate with %s\n", names[i], SCENARIO_SCRIPT);
+            return 2;
+        }
+        replay(&scenarios[i], &dr, &backup, &rp, 1);
+        printf("%-13s %4u epochs, %5u frames (%u ESF, %u UPD-SOS): %u alignment transitions, "
+               "%u fault events, %u degradations, fusion enabled %u s, score %u, "
+               "%u epochs out of alignment limits -> %s\n",
+               names[i], scenarios[i].epochs, rp.frames, rp.esfFrames, rp.sosFrames,
+               dr.health.algTransitions, dr.health.faultEvents, rp.degraded,
+               dr.health.fusionDwellMs[XPLR_GNSS_FUSION_MODE_ENABLED] / 1000,
+               dr.health.score, rp.outOfLimits, (rp.fails == 0) ? "ok" : "FAIL");
+        if (rp.fails > 0) {
+            ret = 1;
+        }
+    }
+
+    start = nowSec();
+    for (p = 0; p < passes; p++) {
+        for (i = 0; i < numScenarios; i++) {
+            replay(&scenarios[i], &dr, &backup, &rp, 0);
+            frames += rp.frames;
+        }
+    }
+    elapsed = nowSec() - start;
+    if ((passes > 0) && (elapsed > 0)) {
+        printf("replay: %llu messages in %.3f s, %.0f messages/s, %.0f ns/message\n",
+               frames, elapsed, frames / elapsed, elapsed * 1e9 / frames);
+    }
+
+    for (i = 0; i < numScenarios; i++) {
+        free(scenarios[i].data);
+    }
+    printf("%s\n", (ret == 0) ? "PASS" : "FAIL");
+
+    return ret;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host stress test of the sequence lock guarding the GNSS data product
+ * snapshots (xplr_gnss_seqlock.h). One writer publishes a snapshot as fast
+ * as it can, the size of a location, with every word set to the number of
+ * the publication. Readers copy it the way gnssSnapshotRead() does, with the
+ * same number of retries, and check that every copy holds a single
+ * publication and that publications never go back in time.
+ *
+ * A reader copying without the lock runs alongside as a control: the torn
+ * copies it sees show that the test does overlap reads and publications.
+ * On a single CPU host the overlaps come from preemption.
+ *
+ * Build on Linux:
+ *   gcc -O2 -g -pthread -I.. xplr_gnss_seqlock_stress.c -o xplr_gnss_seqlock_stress
+ * ThreadSanitizer reports the copy of a sequence lock as a data race by
+ * design, the copy being thrown away when it overlaps a publication.
+ *
+ * Usage:
+ *   xplr_gnss_seqlock_stress [-t seconds] [-r readers]
+ *
+ * Prints the reads, retries, timeouts and torn copies of each reader and
+ * PASS when no guarded copy was torn or out of order, FAIL otherwise. The
+ * writer publishes back to back, far more often than the GNSS task, so
+ * readers time out often: gnssSnapshotRead() then reports ESP_ERR_TIMEOUT.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "xplr_gnss_seqlock.h"
+
+#define SNAPSHOT_WORDS      (48U)   /* about the size of xplrGnssLocation_t */
+#define READ_RETRIES        (8U)    /* XPLR_GNSS_SNAPSHOT_READ_RETRIES */
+#define DEFAULT_SECONDS     (3U)
+#define READERS_MAX         (8U)
+
+typedef struct {
+    uint32_t word[SNAPSHOT_WORDS];
+} snapshot_t;
+
+typedef struct {
+    pthread_t thread;
+    int guarded;
+    unsigned long long reads;
+    unsigned long long retries;
+    unsigned long long timeouts;
+    unsigned long long torn;
+    unsigned long long backwards;
+} reader_t;
+
+static uint32_t seq;
+static snapshot_t published;
+static int stop;
+static unsigned long long publications;
+
+/* ----------------------------------------------------------------
+ * WRITER AND READERS
+ * -------------------------------------------------------------- */
+
+static void *writerTask(void *arg)
+{
+    snapshot_t local;
+    uint32_t n = 0;
+    size_t i;
+
+    (void)arg;
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        n++;
+        for (i = 0; i < SNAPSHOT_WORDS; i++) {
+            local.word[i] = n;
+        }
+        xplrGnssSeqlockPublish(&seq, &published, &local, sizeof(local));
+    }
+    publications = n;
+
+    return NULL;
+}
+
+static int snapshotTorn(const snapshot_t *copy)
+{
+    size_t i;
+    int ret = 0;
+
+    for (i = 1; i < SNAPSHOT_WORDS; i++) {
+        if (copy->word[i] != copy->word[0]) {
+            ret = 1;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static void *readerTask(void *arg)
+{
+    reader_t *reader = arg;
+    snapshot_t copy;
+    uint32_t last = 0;
+    uint8_t retries;
+    int ok;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        if (reader->guarded) {
+            ok = 0;
+            for (retries = 0; retries < READ_RETRIES; retries++) {
+                if (xplrGnssSeqlockTryRead(&seq, &copy, &published, sizeof(copy))) {
+                    ok = 1;
+                    break;
+                }
+                reader->retries++;
+            }
+            if (!ok) {
+                reader->timeouts++;
+                continue;
+            }
+        } else {
+            memcpy(&copy, (const void *)&published, sizeof(copy));
+        }
+        reader->reads++;
+        if (snapshotTorn(&copy)) {
+            reader->torn++;
+        } else if (copy.word[0] < last) {
+            reader->backwards++;
+        } else {
+            last = copy.word[0];
+        }
+    }
+
+    return NULL;
+}
+
+/* ----------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+    reader_t readers[READERS_MAX + 1];
+    unsigned seconds = DEFAULT_SECONDS;
+    unsigned guarded = 2;
+    pthread_t writer;
+    unsigned i;
+    int ret = 0;
+
+    for (i = 1; i < (unsigned)argc; i++) {
+        if ((strcmp(argv[i], "-t") == 0) && (i + 1 < (unsigned)argc)) {
+            seconds = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < (unsigned)argc)) {
+            guarded = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else {
+            printf("usage: %s [-t seconds] [-r readers]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((guarded == 0) || (guarded > READERS_MAX)) {
+        guarded = 2;
+    }
+
+    memset(readers, 0, sizeof(readers));
+    for (i = 0; i <= guarded; i++) {
+        readers[i].guarded = (i < guarded);
+    }
+
+    pthread_create(&writer, NULL, writerTask, NULL);
+    for (i = 0; i <= guarded; i++) {
+        pthread_create(&readers[i].thread, NULL, readerTask, &readers[i]);
+    }
+    sleep(seconds);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    pthread_join(writer, NULL);
+    for (i = 0; i <= guarded; i++) {
+        pthread_join(readers[i].thread, NULL);
+    }
+
+    printf("%u s, %ld CPUs, %llu publications of %zu bytes\n",
+           seconds, sysconf(_SC_NPROCESSORS_ONLN), publications, sizeof(snapshot_t));
+    for (i = 0; i <= guarded; i++) {
+        printf("  %-9s reader %u: %12llu reads, %10llu retries, %6llu timeouts, %8llu torn, %6llu backwards\n",
+               readers[i].guarded ? "seqlock" : "unguarded", i,
+               readers[i].reads, readers[i].retries, readers[i].timeouts,
+               readers[i].torn, readers[i].backwards);
+        if (readers[i].guarded &&
+            ((readers[i].torn > 0) || (readers[i].backwards > 0) || (readers[i].reads == 0))) {
+            ret = 1;
+        }
+    }
+    printf("%s\n", (ret == 0) ? "PASS" : "FAIL");
+
+    return ret;
+}
@@ -22,10 +22,13 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <time.h>
 #include "string.h"
 #include "esp_task_wdt.h"
 #include "u_cfg_app_platform_specific.h"
 #include "xplr_gnss.h"
+#include "xplr_gnss_seqlock.h"
+#include "xplr_gnss_dr.h"
 #include "./../../../components/hpglib/src/common/xplr_common.h"
 
 /* ----------------------------------------------------------------
@@ -98,6 +101,44 @@
 #define XPLR_GNSS_LOG_RING_BUF_SIZE     3*1024 //bytes
 #define XPLR_GNSS_LOG_RING_BUF_TIMEOUT  portMAX_DELAY
 
+/**
+ * Times a reader retries copying a snapshot that is being
+ * published before giving up
+ */
+#define XPLR_GNSS_SNAPSHOT_READ_RETRIES (8U)
+
+/**
+ * iTOW marking a location part not yet received
+ */
+#define XPLR_GNSS_ITOW_INVALID          (UINT32_MAX)
+
+/**
+ * Interval to store the last known position in NVS for the next warm start
+ */
+#define XPLR_GNSS_WARM_START_SAVE_INTERVAL_S    (600U)
+
+/**
+ * Accuracy given to the stored position when injected at start,
+ * covers the distance the device may have moved while switched off
+ */
+#define XPLR_GNSS_WARM_START_POS_ACC_CM         (1000000U)
+
+/**
+ * Accuracy given to the system clock when injected at start
+ */
+#define XPLR_GNSS_WARM_START_TIME_ACC_S         (10U)
+
+/**
+ * Layout version of the position record stored in NVS
+ */
+#define XPLR_GNSS_WARM_START_REC_VERSION        (1U)
+
+/**
+ * Time an automatic alignment has to stay converged without errors
+ * before it may replace the calibration stored in NVS
+ */
+#define XPLR_GNSS_DR_CALIB_SETTLE_S             (60U)
+
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
@@ -111,18 +152,12 @@ typedef enum {
  * Struct that contains location data
  */
 typedef struct xplrGnssLocData_type {
-    xplrGnssLocation_t locData;     /**< location info */
+    xplrGnssLocation_t locData;     /**< location info, assembled by the parsers */
+    uint32_t pvtITOW;               /**< iTOW of the NAV-PVT part of locData */
+    uint32_t accITOW;               /**< iTOW of the NAV-HPPOSLLH part of locData */
+    uint8_t noFixCnt;               /**< consecutive GGA messages without a fix type */
 } xplrGnssLocData_t;
 
-/**
- * Dead Reckoning data
- */
-typedef struct xplrGnssDrData_type {
-    xplrGnssImuAlignmentInfo_t info;    /**< IMU Alignment Information */
-    xplrGnssImuFusionStatus_t status;   /**< IMU Fusion status */
-    xplrGnssImuVehDynMeas_t dynamics;   /**< IMU Vehicle dynamics */
-} xplrGnssDrData_t;
-
 /**
  * Async Ids
  **/
@@ -170,16 +205,98 @@ typedef struct xplrGnssOptions_type {
     int64_t lastWatchdogTime;       /**< Last time DR flag was refreshed */
     int64_t genericTimer;           /**< Used to time misc actions */
     uint8_t ubxRetries;             /**< ubx lib read command retry */
+    xplrGnssRawMsgSink_t rawSink;   /**< forwards raw async messages, NULL if unused */
+    void *rawSinkArg;               /**< user argument of the raw message sink */
+    bool sosWaitingAck;             /**< Save on Shutdown backup issued, waiting for its ack */
+    bool clearBackupWaitingAck;     /**< clear backup issued, waiting for its ack */
 } xplrGnssOptions_t;
 
+/**
+ * Published copies of the GNSS data products.
+ * Written only from the ubxlib callback task and read lock-free:
+ * each copy is guarded by a sequence counter which is odd while
+ * a publication is in progress.
+ */
+typedef struct xplrGnssSnapshots_type {
+    uint32_t locSeq;                    /**< sequence of loc */
+    xplrGnssLocation_t loc;             /**< location */
+    uint32_t infoSeq;                   /**< sequence of info */
+    xplrGnssImuAlignmentInfo_t info;    /**< IMU alignment info */
+    uint32_t statusSeq;                 /**< sequence of status */
+    xplrGnssImuFusionStatus_t status;   /**< ESF status */
+    uint32_t dynamicsSeq;               /**< sequence of dynamics */
+    xplrGnssImuVehDynMeas_t dynamics;   /**< vehicle dynamics */
+    uint32_t healthSeq;                 /**< sequence of health */
+    xplrGnssDrHealth_t health;          /**< DR calibration lifecycle */
+} xplrGnssSnapshots_t;
+
+/**
+ * Event subscriber slot
+ */
+typedef struct xplrGnssSubscriber_type {
+    bool inUse;                     /**< slot is taken */
+    xplrGnssSubscriberCfg_t cfg;    /**< subscriber settings */
+    QueueHandle_t queue;            /**< events of queue subscribers, NULL for callbacks */
+    StaticQueue_t queueBuf;         /**< queue control block */
+    uint8_t queueStorage[XPLRGNSS_EVENT_QUEUE_DEPTH * sizeof(xplrGnssEvent_t)];
+    int8_t accuracyBelow;           /**< -1 unknown, 0 above, 1 at or below the threshold */
+    uint32_t dropped;               /**< events lost because the queue was full */
+} xplrGnssSubscriber_t;
+
+/**
+ * Event subscribers and the state events are raised from.
+ * The table is walked from the ubxlib callback task, the mutex is
+ * recursive so callbacks may unsubscribe themselves.
+ */
+typedef struct xplrGnssEvents_type {
+    SemaphoreHandle_t xSemSubscribers;      /**< guards sub */
+    StaticSemaphore_t xSemBuf;              /**< mutex control block */
+    xplrGnssSubscriber_t sub[XPLRGNSS_SUBSCRIBERS_MAX];
+    uint32_t lastLocITOW;                   /**< iTOW of the last location event */
+    xplrGnssLocFixType_t lastFixType;       /**< fix type of the last location */
+    xplrGnssFusionMode_t lastFusionMode;    /**< fusion mode of the last ESF-STATUS */
+    xplrGnssEsfAlgStatus_t lastAlgStatus;   /**< alignment status of the last ESF-ALG */
+} xplrGnssEvents_t;
+
+/**
+ * Last known position stored in NVS for the next warm start
+ */
+typedef struct xplrGnssWarmStartRec_type {
+    uint32_t version;           /**< layout version */
+    int32_t latitudeX1e7;       /**< latitude in ten millionths of a degree */
+    int32_t longitudeX1e7;      /**< longitude in ten millionths of a degree */
+    int32_t altitudeMm;         /**< altitude in mm */
+    int64_t timeUtc;            /**< UTC time of the position in seconds */
+} xplrGnssWarmStartRec_t;
+
+/**
+ * Warm start and time-to-fix bookkeeping
+ */
+typedef struct xplrGnssWarmStart_type {
+    xplrGnssTtff_t ttff;                /**< milestones of this boot */
+    xplrGnssTtffHistogram_t hist;       /**< time-to-fix histogram, mirrors NVS */
+    xplrGnssWarmStartRec_t rec;         /**< last known position */
+    volatile uint32_t reachedMask;      /**< milestones reached, set by the ubxlib callback task */
+    uint32_t storedMask;                /**< milestones already counted in hist */
+    int64_t lastSave;                   /**< time the position was last stored in us */
+    bool bootCounted;                   /**< this boot is counted in hist */
+    volatile bool keysChanged;          /**< decryption keys to be cached in NVS */
+    bool keysPending;                   /**< keys in the config not yet accepted by the module */
+    volatile bool histClear;            /**< hist to be cleared */
+} xplrGnssWarmStart_t;
+
 /**
  * Settings and data struct for GNSS devices
  */
 typedef struct xplrGnss_type {
-    xplrGnssDeviceCfg_t *conf;  /**< GNSS module configuration */
-    xplrGnssOptions_t options;  /**< options */
-    xplrGnssLocData_t locData;  /**< location data */
-    xplrGnssDrData_t drData;    /**< dead reckoning data */
+    xplrGnssDeviceCfg_t *conf;      /**< GNSS module configuration */
+    xplrGnssOptions_t options;      /**< options */
+    xplrGnssLocData_t locData;      /**< location data */
+    xplrGnssDrData_t drData;        /**< dead reckoning data */
+    xplrGnssSnapshots_t snapshots;  /**< published data products */
+    xplrGnssEvents_t events;        /**< event subscribers */
+    xplrGnssStats_t stats;          /**< message statistics */
+    xplrGnssWarmStart_t warmStart;  /**< warm start and time-to-fix */
 } xplrGnss_t;
 
 /* ----------------------------------------------------------------
@@ -194,16 +311,6 @@ static const int32_t gnssSensDefaultCalibValYaw   = 40000;  // 400.00
 static const int32_t gnssSensDefaultCalibValPitch = 10000;  // 100.00
 static const int32_t gnssSensDefaultCalibValRoll  = 20000;  // 200.00
 
-/**
- * Valid calibration limits
- * All vals in integer degrees
- */
-static const uint32_t gnssSensMaxValYaw   =  36000;   // 360.00
-static const int32_t  gnssSensMaxValPitch =   9000;   //  90.00
-static const int32_t  gnssSensMinValPitch =  -9000;   // -90.00
-static const int32_t  gnssSensMaxValRoll  =  18000;   // 360.00
-static const int32_t  gnssSensMinValRoll  = -18000;   // 360.00
-
 /**
  * Fusion type strings
  * Taken as is from ZED F9R specs file
@@ -465,9 +572,25 @@ static const uGnssMessageId_t msgIdUNmeaMessages = {
 static const char nvsNamespace[] = "gnssDvc_";
 
 /**
- * An array of gnss devices
+ * Upper limits of the time-to-fix histogram bins in seconds,
+ * the last bin takes everything above
+ */
+static const uint32_t gnssTtffBinLimitsSec[XPLR_GNSS_TTFF_HIST_BINS - 1] = {
+    5, 10, 20, 30, 60, 120, 300
+};
+
+static const char *gnssTtffNames[XPLR_GNSS_TTFF_NUMOF_MILESTONES] = {
+    "First fix",
+    "RTK float",
+    "RTK fixed"
+};
+
+/**
+ * An array of gnss devices, every one of them with its async IDs
+ * marked as not running
  */
-static xplrGnss_t dvc[XPLRGNSS_NUMOF_DEVICES] = {{
+static xplrGnss_t dvc[XPLRGNSS_NUMOF_DEVICES] = {
+    [0 ... (XPLRGNSS_NUMOF_DEVICES - 1)] = {
         .options.state = {
             XPLR_GNSS_STATE_UNCONFIGURED,
             XPLR_GNSS_STATE_UNCONFIGURED
@@ -478,15 +601,25 @@ static xplrGnss_t dvc[XPLRGNSS_NUMOF_DEVICES] = {{
         .options.asyncIds.ahUbxId  = -1,
         .options.lastActTime = 0,
         .options.lastWatchdogTime = 0,
-        .options.genericTimer = 0
+        .options.genericTimer = 0,
+        .options.rawSink = NULL,
+        .options.rawSinkArg = NULL
     }
 };
 
 static const char *gLocationUrlPart = "https://maps.google.com/?q=";
 
+/**
+ * Keeps snapshot publication from being preempted, so a reader
+ * on the same core never finds a publication in progress
+ */
+static portMUX_TYPE gnssSnapshotMux = portMUX_INITIALIZER_UNLOCKED;
+
 #if (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLRGNSS_LOG_ACTIVE)
 // Semaphore to guarantee atomic access to the async log task struct
 static SemaphoreHandle_t xSemaphore = NULL;
+// Devices whose messages go to the async log
+static uint32_t asyncLogDvcMask = XPLR_GNSS_DVC_MASK(0);
 #endif
 /* Logging indexes */
 int8_t infoLogIndex = -1;
@@ -554,9 +687,30 @@ static esp_err_t gnssAckNakParser(xplrGnss_t *locDvc, char *buffer);
 static esp_err_t gnssImuSetCalibData(uint8_t dvcProfile);
 static esp_err_t gnssEsfAlgParser(xplrGnss_t *locDvc, char *buffer);
 static esp_err_t gnssEsfStatusParser(xplrGnss_t *locDvc, char *buffer);
-static bool gnssCheckYawValLimits(uint32_t yaw);
-static bool gnssCheckPitchValLimits(int16_t pitch);
-static bool gnssCheckRollValLimits(int16_t roll);
+static void gnssSnapshotsReset(xplrGnss_t *locDvc);
+static void gnssLocationPublish(xplrGnss_t *locDvc);
+static void gnssSnapshotPublish(uint32_t *seq,
+                                void *dst,
+                                const void *src,
+                                size_t size,
+                                xplrGnssEpoch_t *epoch);
+static esp_err_t gnssSnapshotRead(const uint32_t *seq, void *dst, const void *src, size_t size);
+static xplrGnssSubscriber_t *gnssSubscriberGet(uint8_t dvcProfile, int8_t subId);
+static void gnssCorrStatsUpdate(xplrGnss_t *locDvc, esp_err_t result);
+static void gnssEventsLocation(xplrGnss_t *locDvc);
+static void gnssEventsDr(xplrGnss_t *locDvc,
+                         xplrGnssEventType_t type,
+                         const xplrGnssEpoch_t *epoch);
+static void gnssDrCalibCandidate(xplrGnss_t *locDvc);
+static void gnssDrHealthPublish(xplrGnss_t *locDvc, bool degraded);
+static void gnssEventDeliver(xplrGnssSubscriber_t *sub, const xplrGnssEvent_t *event);
+static esp_err_t gnssWarmStart(uint8_t dvcProfile);
+static esp_err_t gnssWarmStartAidPosition(uint8_t dvcProfile);
+static esp_err_t gnssWarmStartAidTime(uint8_t dvcProfile);
+static esp_err_t gnssWarmStartKeys(uint8_t dvcProfile);
+static void gnssWarmStartMilestones(xplrGnss_t *locDvc);
+static bool gnssWarmStartSaveDue(xplrGnss_t *locDvc);
+static esp_err_t gnssWarmStartSave(uint8_t dvcProfile);
 static bool gnssCheckAlignValsLimits(uint8_t dvcProfile);
 static esp_err_t gnssDrSetAlignMode(uint8_t dvcProfile);
 
@@ -610,6 +764,7 @@ static void gnssUbxProtocolCB(uDeviceHandle_t gnssHandle,
                               const uGnssMessageId_t *msgIdToFilter,
                               int32_t errorCodeOrLength,
                               void *callbackParam);
+static esp_err_t gnssUbxDispatch(xplrGnss_t *locDvc, const uGnssMessageId_t *msgId, char *buffer);
 static void gnssNmeaProtocolCB(uDeviceHandle_t gnssHandle,
                                const uGnssMessageId_t *msgIdToFilter,
                                int32_t errorCodeOrLength,
@@ -643,6 +798,12 @@ esp_err_t xplrGnssStartDevice(uint8_t dvcProfile, xplrGnssDeviceCfg_t *conf)
                 XPLRGNSS_CONSOLE(W, "Gnss with ID [%d] is already configured and running.", dvcProfile);
             } else {
                 locDvc->conf = conf;
+                if (locDvc->events.xSemSubscribers == NULL) {
+                    locDvc->events.xSemSubscribers =
+                        xSemaphoreCreateRecursiveMutexStatic(&locDvc->events.xSemBuf);
+                } else {
+                    // do nothing
+                }
                 locDvc->options.flags.status.gnssIsConfigured = 1;
                 XPLRGNSS_CONSOLE(D, "GNSS module configured successfully.");
             }
@@ -662,6 +823,7 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
     esp_err_t espRet;
     xplrGnssError_t ret;
     uint8_t restartMsg[4] = {0};
+    xplrGnssImuAlignmentInfo_t alignInfo;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
     if (boolRet) {
@@ -767,6 +929,13 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
                     espRet = gnssSetDecrKeys(dvcProfile);
                     if (espRet == ESP_OK) {
                         XPLRGNSS_CONSOLE(D, "Set configured decryption keys.");
+                        if (locDvc->warmStart.keysPending) {
+                            /* keys the module refused earlier, cache them now */
+                            locDvc->warmStart.keysPending = false;
+                            locDvc->warmStart.keysChanged = true;
+                        } else {
+                            // do nothing
+                        }
                         gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_SET_CFG_CORR_SOURCE);
                     } else {
                         XPLRGNSS_CONSOLE(E, "Failed to set configured decryption keys.");
@@ -818,13 +987,7 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
                 XPLRGNSS_CONSOLE(D, "Trying to init NVS.");
                 espRet = gnssNvsInit(dvcProfile);
                 if (espRet == ESP_OK) {
-                    if (locDvc->conf->dr.enable) {
-                        XPLRGNSS_CONSOLE(D,
-                                         "Detected Dead Reckoning enable option in config. Initializing Dead Reckoning.");
-                        gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DR_INIT);
-                    } else {
-                        gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DEVICE_READY);
-                    }
+                    gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_WARM_START);
                     XPLRGNSS_CONSOLE(D, "Initialized NVS.");
                 } else {
                     gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_ERROR);
@@ -836,6 +999,35 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
                 ret = XPLR_GNSS_OK;
                 break;
 
+            case XPLR_GNSS_STATE_WARM_START:
+                XPLRGNSS_CONSOLE(D, "Trying to warm start.");
+                espRet = gnssWarmStart(dvcProfile);
+                if (espRet != ESP_OK) {
+                    XPLRGNSS_CONSOLE(W, "Warm start incomplete, starting with partial aiding.");
+                } else {
+                    // do nothing
+                }
+                if (locDvc->conf->dr.enable) {
+                    XPLRGNSS_CONSOLE(D,
+                                     "Detected Dead Reckoning enable option in config. Initializing Dead Reckoning.");
+                    gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DR_INIT);
+                } else {
+                    gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DEVICE_READY);
+                }
+                ret = XPLR_GNSS_OK;
+                break;
+
+            case XPLR_GNSS_STATE_WARM_START_SAVE:
+                espRet = gnssWarmStartSave(dvcProfile);
+                if (espRet != ESP_OK) {
+                    XPLRGNSS_CONSOLE(W, "Could not store warm start data in NVS.");
+                } else {
+                    // do nothing
+                }
+                gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DEVICE_READY);
+                ret = XPLR_GNSS_OK;
+                break;
+
             case XPLR_GNSS_STATE_DR_INIT:
                 XPLRGNSS_CONSOLE(D, "Trying to init Dead Reckoning.");
                 if (locDvc->conf->dr.mode == XPLR_GNSS_IMU_CALIBRATION_MANUAL) {
@@ -894,11 +1086,17 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
             case XPLR_GNSS_STATE_NVS_UPDATE:
                 XPLRGNSS_CONSOLE(D, "Trying to update/save to NVS.");
                 locDvc->options.flags.status.drUpdateNvs = 2;
-                locDvc->conf->dr.alignVals.yaw   = locDvc->drData.info.data.yaw;
-                locDvc->conf->dr.alignVals.pitch = locDvc->drData.info.data.pitch;
-                locDvc->conf->dr.alignVals.roll  = locDvc->drData.info.data.roll;
-                espRet = gnssNvsUpdate(dvcProfile);
+                espRet = xplrGnssGetImuAlignmentInfo(dvcProfile, &alignInfo);
+                if (espRet == ESP_OK) {
+                    locDvc->conf->dr.alignVals.yaw   = alignInfo.data.yaw;
+                    locDvc->conf->dr.alignVals.pitch = alignInfo.data.pitch;
+                    locDvc->conf->dr.alignVals.roll  = alignInfo.data.roll;
+                    espRet = gnssNvsUpdate(dvcProfile);
+                } else {
+                    // do nothing
+                }
                 if (espRet == ESP_OK) {
+                    locDvc->drData.storedScore = locDvc->drData.candidateScore;
                     XPLRGNSS_CONSOLE(D, "Saved alignemnt data to NVS.");
                     gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_DEVICE_READY);
                 } else {
@@ -930,6 +1128,12 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
                 }
                 break;
             case XPLR_GNSS_STATE_SAVE_ON_SHUTDOWN:
+                if (!locDvc->options.sosWaitingAck) {
+                    /* keep the last known position for the next boot */
+                    (void)gnssWarmStartSave(dvcProfile);
+                } else {
+                    // do nothing
+                }
                 espRet = gnssSaveOnShutdown(dvcProfile);
                 if (espRet == ESP_OK) {
                     XPLRGNSS_CONSOLE(D, "Save on Shutdown complete. Turning off device");
@@ -972,6 +1176,9 @@ xplrGnssError_t xplrGnssFsm(uint8_t dvcProfile)
 
                     if (locDvc->options.flags.status.drUpdateNvs == 1) {
                         gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_NVS_UPDATE);
+                    } else if ((locDvc->options.state[0] == XPLR_GNSS_STATE_DEVICE_READY) &&
+                               gnssWarmStartSaveDue(locDvc)) {
+                        gnssUpdateNextState(dvcProfile, XPLR_GNSS_STATE_WARM_START_SAVE);
                     } else {
                         // do nothing
                     }
@@ -1365,6 +1572,7 @@ esp_err_t xplrGnssUbxMessagesAsyncStart(uint8_t dvcProfile)
             XPLRGNSS_CONSOLE(D, "Looks like Gnss UBX Messages async is already running!");
             ret = ESP_OK;
         } else {
+            gnssSnapshotsReset(locDvc);
             locDvc->options.asyncIds.ahUbxId = uGnssMsgReceiveStart(locDvc->options.dvcHandler,
                                                                     &msgIdUbxMessages,
                                                                     gnssUbxProtocolCB,
@@ -1635,7 +1843,9 @@ bool xplrGnssIsDrCalibrated(uint8_t dvcProfile)
 esp_err_t xplrGnssSendDecryptionKeys(uint8_t dvcProfile, const char *buffer, size_t size)
 {
     xplrGnss_t *locDvc = NULL;
+    xplrGnssDecryptionKeys_t *keys;
     esp_err_t ret;
+    bool changed;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
     if (!boolRet || (buffer == NULL)) {
@@ -1643,18 +1853,33 @@ esp_err_t xplrGnssSendDecryptionKeys(uint8_t dvcProfile, const char *buffer, siz
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
     } else {
         locDvc = &dvc[dvcProfile];
+        keys = &locDvc->conf->corrData.keys;
         if ((size > 0) && (size < XPLR_GNSS_DECRYPTION_KEYS_LEN)) {
-            memcpy(locDvc->conf->corrData.keys.keys, buffer, size);
-            locDvc->conf->corrData.keys.size = size;
+            /* the same keys are resent on every MQTT (re)subscription */
+            changed = locDvc->warmStart.keysPending ||
+                      (keys->size != size) ||
+                      (memcmp(keys->keys, buffer, size) != 0);
+            memcpy(keys->keys, buffer, size);
+            keys->size = size;
             XPLRGNSS_CONSOLE(D, "Saved keys into config struct.");
             ret = gnssSetDecrKeys(dvcProfile);
-            ret = ESP_OK;
+            if (ret != ESP_OK) {
+                /* kept in the config for the next start, cached once accepted */
+                XPLRGNSS_CONSOLE(E, "Failed to send decryption keys!");
+                locDvc->warmStart.keysPending = true;
+            } else if (changed) {
+                locDvc->warmStart.keysPending = false;
+                locDvc->warmStart.keysChanged = true;
+            } else {
+                XPLRGNSS_CONSOLE(D, "Decryption keys unchanged, NVS cache kept.");
+            }
         } else {
             XPLRGNSS_CONSOLE(E, "Size [%d] seems to be invalid for storing key!", size);
             XPLRGNSS_CONSOLE(E, "Will not send keys!");
             locDvc->conf->corrData.keys.size = 0;
             ret = ESP_FAIL;
         }
+        gnssCorrStatsUpdate(locDvc, ret);
     }
 
     return ret;
@@ -1670,6 +1895,7 @@ esp_err_t xplrGnssSendCorrectionData(uint8_t dvcProfile, const char *buffer, siz
         ret = ESP_ERR_INVALID_ARG;
     } else {
         ret = xplrGnssSendFormattedCommand(dvcProfile, buffer, size);
+        gnssCorrStatsUpdate(&dvc[dvcProfile], ret);
     }
 
     return ret;
@@ -1726,6 +1952,7 @@ esp_err_t xplrGnssSendRtcmCorrectionData(uint8_t dvcProfile, const char *buffer,
         } else {
             // do nothing
         }
+        gnssCorrStatsUpdate(&dvc[dvcProfile], ret);
     }
 
     return ret;
@@ -1750,182 +1977,248 @@ esp_err_t xplrGnssSendRtcmFormattedCommand(uint8_t dvcProfile, const char *buffe
     return ret;
 }
 
-bool xplrGnssHasMessage(uint8_t dvcProfile)
+esp_err_t xplrGnssRouteCorrectionData(uint32_t dvcMask,
+                                      xplrGnssCorrFormat_t format,
+                                      const char *buffer,
+                                      size_t size)
 {
-    xplrGnss_t *locDvc = NULL;
-    bool ret;
-    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+    esp_err_t ret;
+    esp_err_t espRet;
+    uint8_t dvcProfile;
 
-    if (boolRet) {
-        locDvc = &dvc[dvcProfile];
-        if (locDvc->options.flags.status.locMsgDataAvailable &&
-            locDvc->options.flags.status.locMsgDataRefreshed) {
-            ret = true;
-        } else {
-            ret = false;
-        }
-    } else {
+    if ((buffer == NULL) || (size == 0) || ((dvcMask & XPLR_GNSS_DVC_MASK_ALL) == 0)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
-        ret = false;
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        ret = ESP_OK;
+        for (dvcProfile = 0; dvcProfile < XPLRGNSS_NUMOF_DEVICES; dvcProfile++) {
+            if (((dvcMask & XPLR_GNSS_DVC_MASK(dvcProfile)) != 0) &&
+                (dvc[dvcProfile].options.flags.status.gnssIsConfigured == 1)) {
+                switch (format) {
+                    case XPLR_GNSS_CORR_FORMAT_SPARTN:
+                        espRet = xplrGnssSendCorrectionData(dvcProfile, buffer, size);
+                        break;
+                    case XPLR_GNSS_CORR_FORMAT_RTCM:
+                        espRet = xplrGnssSendRtcmCorrectionData(dvcProfile, buffer, size);
+                        break;
+                    case XPLR_GNSS_CORR_FORMAT_KEYS:
+                        espRet = xplrGnssSendDecryptionKeys(dvcProfile, buffer, size);
+                        break;
+
+                    default:
+                        XPLRGNSS_CONSOLE(E, "Invalid correction data format [%d]!", format);
+                        espRet = ESP_ERR_INVALID_ARG;
+                        break;
+                }
+
+                if (espRet != ESP_OK) {
+                    XPLRGNSS_CONSOLE(W, "Routing correction data to GNSS [%u] failed!", dvcProfile);
+                    ret = (espRet == ESP_ERR_INVALID_ARG) ? espRet : ESP_FAIL;
+                } else {
+                    // do nothing
+                }
+            } else {
+                // do nothing
+            }
+        }
     }
 
     return ret;
 }
 
-esp_err_t xplrGnssConsumeMessage(uint8_t dvcProfile)
+esp_err_t xplrGnssGetStatistics(uint8_t dvcProfile, xplrGnssStats_t *stats)
 {
-    xplrGnss_t *locDvc = NULL;
     esp_err_t ret;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (boolRet) {
-        locDvc = &dvc[dvcProfile];
-        locDvc->options.flags.status.locMsgDataRefreshed = 0;
-        ret = ESP_OK;
-    } else {
+    if (!boolRet || (stats == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
+    } else {
+        *stats = dvc[dvcProfile].stats;
+        ret = ESP_OK;
     }
 
     return ret;
 }
 
-esp_err_t xplrGnssNvsDeleteCalibrations(uint8_t dvcProfile)
+esp_err_t xplrGnssGetTtff(uint8_t dvcProfile, xplrGnssTtff_t *ttff)
 {
     esp_err_t ret;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (boolRet) {
-        ret = gnssNvsErase(dvcProfile);
+    if (!boolRet || (ttff == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
     } else {
+        *ttff = dvc[dvcProfile].warmStart.ttff;
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssGetTtffHistogram(uint8_t dvcProfile, xplrGnssTtffHistogram_t *hist)
+{
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (!boolRet || (hist == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
+    } else if (!dvc[dvcProfile].warmStart.bootCounted) {
+        XPLRGNSS_CONSOLE(W, "Histogram not loaded from NVS yet!");
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        *hist = dvc[dvcProfile].warmStart.hist;
+        ret = ESP_OK;
     }
 
     return ret;
 }
 
-int64_t xplrGnssGetTimestampUTC(uint8_t dvcProfile)
+esp_err_t xplrGnssClearTtffHistogram(uint8_t dvcProfile)
 {
-    xplrGnss_t *locDvc = NULL;
-    int64_t timestamp;
+    esp_err_t ret;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (boolRet) {
-        locDvc = &dvc[dvcProfile];
-        timestamp = locDvc->locData.locData.location.timeUtc;
+    if (!boolRet) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
     } else {
-        timestamp = -1;
+        /* cleared and stored by the FSM, which owns the histogram */
+        dvc[dvcProfile].warmStart.histClear = true;
+        ret = ESP_OK;
     }
 
-    return timestamp;
+    return ret;
 }
 
-esp_err_t xplrGnssGetGmapsLocation(uint8_t dvcProfile, char *gmapsLocationRes, uint16_t maxLen)
+esp_err_t xplrGnssReplayUbxMessage(uint8_t dvcProfile, const char *buffer, size_t size)
 {
     xplrGnss_t *locDvc = NULL;
+    uGnssMessageId_t msgId;
+    char frame[XPLR_GNSS_UBX_BUFF_SIZE];
     esp_err_t ret;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
-    int writeLen;
 
-    if (!boolRet || (gmapsLocationRes == NULL)) {
+    if (!boolRet || (buffer == NULL) || (size < U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) ||
+        (size >= XPLR_GNSS_UBX_BUFF_SIZE)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
         locDvc = &dvc[dvcProfile];
-        writeLen = snprintf(gmapsLocationRes,
-                            maxLen,
-                            "%s%f,%f",
-                            gLocationUrlPart,
-                            locDvc->locData.locData.location.latitudeX1e7  * (1e-7),
-                            locDvc->locData.locData.location.longitudeX1e7 * (1e-7));
-
-        if (writeLen < 0) {
-            XPLRGNSS_CONSOLE(E, "Getting GMaps location failed with error code[%d]!", writeLen);
-            ret = ESP_FAIL;
-        } else if (writeLen == 0) {
-            XPLRGNSS_CONSOLE(E, "Getting GMpas location failed!");
-            XPLRGNSS_CONSOLE(E, "Nothing was written in the buffer");
-            ret = ESP_FAIL;
-        } else if (writeLen >= maxLen) {
-            XPLRGNSS_CONSOLE(E, "Getting GMaps location failed!");
-            XPLRGNSS_CONSOLE(E, "Write length %d is larger than buffer size %d", writeLen, maxLen);
-            ret = ESP_FAIL;
+        if ((locDvc->conf == NULL) || (locDvc->options.asyncIds.ahUbxId >= 0)) {
+            XPLRGNSS_CONSOLE(E, "Replay needs a started device with its UBX async stopped!");
+            ret = ESP_ERR_INVALID_STATE;
         } else {
-#if 1 == XPLR_GNSS_XTRA_DEBUG
-            XPLRGNSS_CONSOLE(D, "Got GMaps location successfully.");
-#endif
-            ret = ESP_OK;
+            if (!xplrGnssDrUbxFrameValid((const uint8_t *)buffer, size)) {
+                XPLRGNSS_CONSOLE(W, "Not a valid UBX frame!");
+                locDvc->stats.readErrors++;
+                ret = ESP_ERR_INVALID_ARG;
+            } else {
+                /* parsers may modify the buffer */
+                memcpy(frame, buffer, size);
+                msgId.type = U_GNSS_PROTOCOL_UBX;
+                msgId.id.ubx = ((uint16_t)(uint8_t)buffer[2] << 8) | (uint8_t)buffer[3];
+                locDvc->stats.ubxMsgs++;
+                ret = gnssUbxDispatch(locDvc, &msgId, frame);
+            }
         }
     }
 
     return ret;
 }
 
-esp_err_t xplrGnssPrintGmapsLocation(uint8_t dvcProfile)
+esp_err_t xplrGnssSetRawMsgSink(uint8_t dvcProfile, xplrGnssRawMsgSink_t sink, void *arg)
 {
+    xplrGnss_t *locDvc = NULL;
     esp_err_t ret;
-
-#if (1 == XPLRGNSS_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
-    char gmapsLocationRes[64];
-    bool hasMessage;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
     if (boolRet) {
-        hasMessage = xplrGnssHasMessage(dvcProfile);
-        if (hasMessage) {
-            ret = xplrGnssGetGmapsLocation(dvcProfile, gmapsLocationRes, ELEMENTCNT(gmapsLocationRes));
-            if (ret != ESP_OK) {
-                XPLRGNSS_CONSOLE(E, "Error printing GMaps location!");
-            } else {
-                XPLRGNSS_CONSOLE(I, "Printing GMapsLocation!");
-                XPLRGNSS_CONSOLE(I, "Gmaps Location: %s", gmapsLocationRes);
-            }
-        }
+        locDvc = &dvc[dvcProfile];
+        // Clear the sink while its argument is updated
+        locDvc->options.rawSink = NULL;
+        locDvc->options.rawSinkArg = arg;
+        locDvc->options.rawSink = sink;
         ret = ESP_OK;
     } else {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     }
-#else
-    ret = ESP_OK;
-#endif
 
     return ret;
 }
 
-esp_err_t xplrGnssGetDeviceInfo(uint8_t dvcProfile, xplrLocDvcInfo_t *dvcInfo)
+esp_err_t xplrGnssSubscribe(uint8_t dvcProfile, const xplrGnssSubscriberCfg_t *cfg, int8_t *subId)
 {
     xplrGnss_t *locDvc = NULL;
+    xplrGnssSubscriber_t *sub;
     esp_err_t ret;
+    int8_t i;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (!boolRet || (dvcInfo == NULL)) {
+    if ((!boolRet) || (cfg == NULL) || (subId == NULL) || (cfg->events == 0)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
+    } else if (dvc[dvcProfile].events.xSemSubscribers == NULL) {
+        XPLRGNSS_CONSOLE(E, "GNSS device not started, cannot subscribe!");
+        ret = ESP_ERR_INVALID_STATE;
     } else {
         locDvc = &dvc[dvcProfile];
-        ret = xplrHlprLocSrvcGetDeviceInfo(&locDvc->conf->hw,
-                                           locDvc->options.dvcHandler,
-                                           dvcInfo);
+        ret = ESP_ERR_NO_MEM;
+        xSemaphoreTakeRecursive(locDvc->events.xSemSubscribers, portMAX_DELAY);
+        for (i = 0; i < XPLRGNSS_SUBSCRIBERS_MAX; i++) {
+            sub = &locDvc->events.sub[i];
+            if (!sub->inUse) {
+                sub->cfg = *cfg;
+                sub->accuracyBelow = -1;
+                sub->dropped = 0;
+                if (cfg->cb == NULL) {
+                    sub->queue = xQueueCreateStatic(XPLRGNSS_EVENT_QUEUE_DEPTH,
+                                                    sizeof(xplrGnssEvent_t),
+                                                    sub->queueStorage,
+                                                    &sub->queueBuf);
+                } else {
+                    sub->queue = NULL;
+                }
+                sub->inUse = true;
+                *subId = i;
+                ret = ESP_OK;
+                break;
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGiveRecursive(locDvc->events.xSemSubscribers);
+
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(E, "No free subscriber slot!");
+        } else {
+            XPLRGNSS_CONSOLE(D, "Subscriber [%d] registered for events 0x%02x.", *subId, cfg->events);
+        }
     }
 
     return ret;
 }
 
-esp_err_t xplrGnssPrintDeviceInfo(uint8_t dvcProfile)
+esp_err_t xplrGnssUnsubscribe(uint8_t dvcProfile, int8_t subId)
 {
+    xplrGnssSubscriber_t *sub = gnssSubscriberGet(dvcProfile, subId);
     esp_err_t ret;
-    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
-    xplrLocDvcInfo_t dvcInfo;
 
-    if (boolRet) {
-        ret = xplrGnssGetDeviceInfo(dvcProfile, &dvcInfo);
-        if (ret == ESP_OK) {
-            ret = xplrHlprLocSrvcPrintDeviceInfo(&dvcInfo);
+    if (sub != NULL) {
+        xSemaphoreTakeRecursive(dvc[dvcProfile].events.xSemSubscribers, portMAX_DELAY);
+        sub->inUse = false;
+        if (sub->queue != NULL) {
+            vQueueDelete(sub->queue);
+            sub->queue = NULL;
         } else {
-            XPLRGNSS_CONSOLE(E, "Failed getting device info!");
+            // do nothing
         }
+        xSemaphoreGiveRecursive(dvc[dvcProfile].events.xSemSubscribers);
+        ret = ESP_OK;
     } else {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
@@ -1934,72 +2227,331 @@ esp_err_t xplrGnssPrintDeviceInfo(uint8_t dvcProfile)
     return ret;
 }
 
-esp_err_t xplrGnssGetLocationData(uint8_t dvcProfile, xplrGnssLocation_t *locData)
+esp_err_t xplrGnssWaitEvent(uint8_t dvcProfile,
+                            int8_t subId,
+                            xplrGnssEvent_t *event,
+                            TickType_t timeout)
 {
-    xplrGnss_t *locDvc = NULL;
+    xplrGnssSubscriber_t *sub = gnssSubscriberGet(dvcProfile, subId);
     esp_err_t ret;
-    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (!boolRet || (locData == NULL)) {
+    if ((sub == NULL) || (sub->queue == NULL) || (event == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
-    } else {
-        locDvc = &dvc[dvcProfile];
-        memcpy(locData, &locDvc->locData.locData, sizeof(xplrGnssLocation_t));
+    } else if (xQueueReceive(sub->queue, event, timeout) == pdTRUE) {
         ret = ESP_OK;
+    } else {
+        ret = ESP_ERR_TIMEOUT;
     }
 
     return ret;
 }
 
-esp_err_t xplrGnssPrintLocationData(xplrGnssLocation_t *locData)
+esp_err_t xplrGnssGetEventsDropped(uint8_t dvcProfile, int8_t subId, uint32_t *dropped)
 {
+    xplrGnssSubscriber_t *sub = gnssSubscriberGet(dvcProfile, subId);
     esp_err_t ret;
 
-#if (1 == XPLRGNSS_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
-    char locFixTypeStr[XPLR_GNSS_LOCFIX_STR_MAX_LEN];
-
-    if (locData == NULL) {
+    if ((sub == NULL) || (dropped == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
-        ret = gnssFixTypeToString(locData, locFixTypeStr, ELEMENTCNT(locFixTypeStr));
-        if (ret == ESP_OK) {
-#if (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLRLOCATION_LOG_ACTIVE)
-            if (xplrLogIsEnabled(asyncLogIndex)) {
-                gnssLogLocationPrinter(locFixTypeStr, locData);
-            } else {
-                // do nothing
-            }
-#endif
-            gnssLocationPrinter(locFixTypeStr, locData);
-        } else {
-            XPLRGNSS_CONSOLE(E, "Error converting Fix type to string!");
-        }
+        *dropped = sub->dropped;
+        ret = ESP_OK;
     }
-#else
-    ret = ESP_OK;
-#endif
 
     return ret;
 }
 
-esp_err_t xplrGnssGetImuAlignmentInfo(uint8_t dvcProfile,
-                                      xplrGnssImuAlignmentInfo_t *info)
+bool xplrGnssHasMessage(uint8_t dvcProfile)
+{
+    xplrGnss_t *locDvc = NULL;
+    bool ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (boolRet) {
+        locDvc = &dvc[dvcProfile];
+        if (locDvc->options.flags.status.locMsgDataAvailable &&
+            locDvc->options.flags.status.locMsgDataRefreshed) {
+            ret = true;
+        } else {
+            ret = false;
+        }
+    } else {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = false;
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssConsumeMessage(uint8_t dvcProfile)
 {
     xplrGnss_t *locDvc = NULL;
     esp_err_t ret;
     bool boolRet = gnssIsDvcProfileValid(dvcProfile);
 
-    if (!boolRet || (info == NULL)) {
+    if (boolRet) {
+        locDvc = &dvc[dvcProfile];
+        locDvc->options.flags.status.locMsgDataRefreshed = 0;
+        ret = ESP_OK;
+    } else {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssNvsDeleteCalibrations(uint8_t dvcProfile)
+{
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (boolRet) {
+        ret = gnssNvsErase(dvcProfile);
+    } else {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    return ret;
+}
+
+int64_t xplrGnssGetTimestampUTC(uint8_t dvcProfile)
+{
+    xplrGnss_t *locDvc = NULL;
+    int64_t timestamp;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+    xplrGnssLocation_t loc;
+
+    if (boolRet) {
+        locDvc = &dvc[dvcProfile];
+        if (gnssSnapshotRead(&locDvc->snapshots.locSeq,
+                             &loc,
+                             &locDvc->snapshots.loc,
+                             sizeof(loc)) == ESP_OK) {
+            timestamp = loc.location.timeUtc;
+        } else {
+            timestamp = -1;
+        }
+    } else {
+        timestamp = -1;
+    }
+
+    return timestamp;
+}
+
+esp_err_t xplrGnssGetGmapsLocation(uint8_t dvcProfile, char *gmapsLocationRes, uint16_t maxLen)
+{
+    xplrGnss_t *locDvc = NULL;
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+    int writeLen;
+    xplrGnssLocation_t loc;
+
+    if (!boolRet || (gmapsLocationRes == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
         locDvc = &dvc[dvcProfile];
-        memcpy(info,
-               &locDvc->drData.info,
-               sizeof(xplrGnssImuAlignmentInfo_t));
+        ret = gnssSnapshotRead(&locDvc->snapshots.locSeq,
+                               &loc,
+                               &locDvc->snapshots.loc,
+                               sizeof(loc));
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(E, "Could not read location snapshot!");
+        } else {
+            writeLen = snprintf(gmapsLocationRes,
+                                maxLen,
+                                "%s%f,%f",
+                                gLocationUrlPart,
+                                loc.location.latitudeX1e7  * (1e-7),
+                                loc.location.longitudeX1e7 * (1e-7));
+
+            if (writeLen < 0) {
+                XPLRGNSS_CONSOLE(E, "Getting GMaps location failed with error code[%d]!", writeLen);
+                ret = ESP_FAIL;
+            } else if (writeLen == 0) {
+                XPLRGNSS_CONSOLE(E, "Getting GMpas location failed!");
+                XPLRGNSS_CONSOLE(E, "Nothing was written in the buffer");
+                ret = ESP_FAIL;
+            } else if (writeLen >= maxLen) {
+                XPLRGNSS_CONSOLE(E, "Getting GMaps location failed!");
+                XPLRGNSS_CONSOLE(E, "Write length %d is larger than buffer size %d", writeLen, maxLen);
+                ret = ESP_FAIL;
+            } else {
+#if 1 == XPLR_GNSS_XTRA_DEBUG
+                XPLRGNSS_CONSOLE(D, "Got GMaps location successfully.");
+#endif
+                ret = ESP_OK;
+            }
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssPrintGmapsLocation(uint8_t dvcProfile)
+{
+    esp_err_t ret;
+
+#if (1 == XPLRGNSS_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
+    char gmapsLocationRes[64];
+    bool hasMessage;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (boolRet) {
+        hasMessage = xplrGnssHasMessage(dvcProfile);
+        if (hasMessage) {
+            ret = xplrGnssGetGmapsLocation(dvcProfile, gmapsLocationRes, ELEMENTCNT(gmapsLocationRes));
+            if (ret != ESP_OK) {
+                XPLRGNSS_CONSOLE(E, "Error printing GMaps location!");
+            } else {
+                XPLRGNSS_CONSOLE(I, "Printing GMapsLocation!");
+                XPLRGNSS_CONSOLE(I, "Gmaps Location: %s", gmapsLocationRes);
+            }
+        }
         ret = ESP_OK;
+    } else {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+#else
+    ret = ESP_OK;
+#endif
+
+    return ret;
+}
+
+esp_err_t xplrGnssGetDeviceInfo(uint8_t dvcProfile, xplrLocDvcInfo_t *dvcInfo)
+{
+    xplrGnss_t *locDvc = NULL;
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (!boolRet || (dvcInfo == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        locDvc = &dvc[dvcProfile];
+        ret = xplrHlprLocSrvcGetDeviceInfo(&locDvc->conf->hw,
+                                           locDvc->options.dvcHandler,
+                                           dvcInfo);
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssPrintDeviceInfo(uint8_t dvcProfile)
+{
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+    xplrLocDvcInfo_t dvcInfo;
+
+    if (boolRet) {
+        ret = xplrGnssGetDeviceInfo(dvcProfile, &dvcInfo);
+        if (ret == ESP_OK) {
+            ret = xplrHlprLocSrvcPrintDeviceInfo(&dvcInfo);
+        } else {
+            XPLRGNSS_CONSOLE(E, "Failed getting device info!");
+        }
+    } else {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssGetLocationData(uint8_t dvcProfile, xplrGnssLocation_t *locData)
+{
+    xplrGnss_t *locDvc = NULL;
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (!boolRet || (locData == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        locDvc = &dvc[dvcProfile];
+        ret = gnssSnapshotRead(&locDvc->snapshots.locSeq,
+                               locData,
+                               &locDvc->snapshots.loc,
+                               sizeof(xplrGnssLocation_t));
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssPrintLocationData(xplrGnssLocation_t *locData)
+{
+    esp_err_t ret;
+
+#if (1 == XPLRGNSS_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
+    char locFixTypeStr[XPLR_GNSS_LOCFIX_STR_MAX_LEN];
+
+    if (locData == NULL) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        ret = gnssFixTypeToString(locData, locFixTypeStr, ELEMENTCNT(locFixTypeStr));
+        if (ret == ESP_OK) {
+#if (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLRLOCATION_LOG_ACTIVE)
+            if (xplrLogIsEnabled(asyncLogIndex)) {
+                gnssLogLocationPrinter(locFixTypeStr, locData);
+            } else {
+                // do nothing
+            }
+#endif
+            gnssLocationPrinter(locFixTypeStr, locData);
+        } else {
+            XPLRGNSS_CONSOLE(E, "Error converting Fix type to string!");
+        }
+    }
+#else
+    ret = ESP_OK;
+#endif
+
+    return ret;
+}
+
+esp_err_t xplrGnssGetImuAlignmentInfo(uint8_t dvcProfile,
+                                      xplrGnssImuAlignmentInfo_t *info)
+{
+    xplrGnss_t *locDvc = NULL;
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (!boolRet || (info == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        locDvc = &dvc[dvcProfile];
+        ret = gnssSnapshotRead(&locDvc->snapshots.infoSeq,
+                               info,
+                               &locDvc->snapshots.info,
+                               sizeof(xplrGnssImuAlignmentInfo_t));
+    }
+
+    return ret;
+}
+
+esp_err_t xplrGnssGetDrHealth(uint8_t dvcProfile, xplrGnssDrHealth_t *health)
+{
+    xplrGnss_t *locDvc = NULL;
+    esp_err_t ret;
+    bool boolRet = gnssIsDvcProfileValid(dvcProfile);
+
+    if (!boolRet || (health == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        locDvc = &dvc[dvcProfile];
+        ret = gnssSnapshotRead(&locDvc->snapshots.healthSeq,
+                               health,
+                               &locDvc->snapshots.health,
+                               sizeof(xplrGnssDrHealth_t));
     }
 
     return ret;
@@ -2058,10 +2610,10 @@ esp_err_t xplrGnssGetImuAlignmentStatus(uint8_t dvcProfile,
         ret = ESP_ERR_INVALID_ARG;
     } else {
         locDvc = &dvc[dvcProfile];
-        memcpy(status,
-               &locDvc->drData.status,
-               sizeof(xplrGnssImuFusionStatus_t));
-        ret = ESP_OK;
+        ret = gnssSnapshotRead(&locDvc->snapshots.statusSeq,
+                               status,
+                               &locDvc->snapshots.status,
+                               sizeof(xplrGnssImuFusionStatus_t));
     }
 
     return ret;
@@ -2110,10 +2662,10 @@ esp_err_t xplrGnssGetImuVehicleDynamics(uint8_t dvcProfile,
         ret = ESP_ERR_INVALID_ARG;
     } else {
         locDvc = &dvc[dvcProfile];
-        memcpy(dynamics,
-               &locDvc->drData.dynamics,
-               sizeof(xplrGnssImuVehDynMeas_t));
-        ret = ESP_OK;
+        ret = gnssSnapshotRead(&locDvc->snapshots.dynamicsSeq,
+                               dynamics,
+                               &locDvc->snapshots.dynamics,
+                               sizeof(xplrGnssImuVehDynMeas_t));
     }
 
     return ret;
@@ -2352,6 +2904,21 @@ esp_err_t xplrGnssAsyncLogDeInit(void)
     return ret;
 }
 
+esp_err_t xplrGnssAsyncLogSelectDevices(uint32_t dvcMask)
+{
+    esp_err_t ret;
+
+    if ((dvcMask & ~XPLR_GNSS_DVC_MASK_ALL) != 0) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        asyncLogDvcMask = dvcMask;
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
 int8_t xplrGnssInitLogModule(xplr_cfg_logInstance_t *logCfg)
 {
     int8_t ret;
@@ -2533,11 +3100,10 @@ static esp_err_t gnssSaveOnShutdown(uint8_t dvcProfile)
      * Restart message payload (HotStart, Controlled GNSS stop). Check page 61 of HPS-1.30 Interface manual
     */
     uint8_t restartMsg[4] = {0x00, 0x00, 0x08, 0x00};
-    static bool waitingAck = false;
     bool isProfileValid = gnssIsDvcProfileValid(dvcProfile);
 
     if (isProfileValid) {
-        if (!waitingAck) {
+        if (!dvc[dvcProfile].options.sosWaitingAck) {
             /*Stop ZED with Controlled GNSS stop and BBR mask of 0 (Hotstart)*/
             length = uUbxProtocolEncode(0x06,
                                         0x04,
@@ -2550,7 +3116,7 @@ static esp_err_t gnssSaveOnShutdown(uint8_t dvcProfile)
                 if (ret == ESP_OK) {
                     ret = gnssCreateBackup(dvcProfile);
                     if (ret == ESP_OK) {
-                        waitingAck = true;
+                        dvc[dvcProfile].options.sosWaitingAck = true;
                     } else {
                         XPLRGNSS_CONSOLE(E, "Error in backup creation for Save on Shutdown routine");
                     }
@@ -2706,13 +3272,12 @@ static esp_err_t gnssClearBackup(uint8_t dvcProfile)
     uint8_t message[4] = {0x01, 0x00, 0x00, 0x00};
     uint8_t buffer[4 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES] = {0};
     int16_t length = 0;
-    static bool waitingAck = false;
     bool isProfileValid = gnssIsDvcProfileValid(dvcProfile);
 
     if (isProfileValid) {
         /*Check if system was restored from backup */
         if (locDvc->conf->backup.isRestored) {
-            if (!waitingAck) {
+            if (!locDvc->options.clearBackupWaitingAck) {
                 locDvc->conf->backup.cmdAck = 0;
                 /*Clear backup*/
                 length = uUbxProtocolEncode(0x09,
@@ -2724,7 +3289,7 @@ static esp_err_t gnssClearBackup(uint8_t dvcProfile)
                     ret = xplrGnssSendFormattedCommand(dvcProfile, (const char *) buffer, length);
                     if (ret == ESP_OK) {
                         XPLRGNSS_CONSOLE(D, "Clear Backup command issued successfully");
-                        waitingAck = true;
+                        locDvc->options.clearBackupWaitingAck = true;
                     } else {
                         XPLRGNSS_CONSOLE(E, "Failed to issue Clear Backup command!");
                         ret = ESP_FAIL;
@@ -2844,12 +3409,13 @@ static esp_err_t gnssGetLocFixType(xplrGnss_t *locDvc, char *buffer)
     esp_err_t ret;
     uint8_t strIdx;
     uint8_t commaCnt = 0;
-    static uint8_t noFixCnt;
+    xplrGnssLocFixType_t prevFixType;
 
     if ((locDvc == NULL) || (buffer == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
+        prevFixType = locDvc->locData.locData.locFixType;
         /**
          * We are parsing the following message:
          *      $GNGGA,185115.00,3758.82530,N,02339.41564,E,1,12,0.54,64.8,M,33.1,M,,*7E
@@ -2887,13 +3453,13 @@ static esp_err_t gnssGetLocFixType(xplrGnss_t *locDvc, char *buffer)
                 XPLRGNSS_CONSOLE(W, "Seems like GNGGA is terminating early.");
                 ret = ESP_FAIL;
             } else if (buffer[strIdx + 1] == ',') {
-                if (noFixCnt == 10) {
+                if (locDvc->locData.noFixCnt == 10) {
                     locDvc->locData.locData.locFixType = XPLR_GNSS_LOCFIX_INVALID;
 #if 1 == XPLR_GNSS_XTRA_DEBUG
                     XPLRGNSS_CONSOLE(W, "Seems like location fix type has not been parsed for the last 10 messages!");
 #endif
-                } else if (noFixCnt < 10) {
-                    noFixCnt++;
+                } else if (locDvc->locData.noFixCnt < 10) {
+                    locDvc->locData.noFixCnt++;
                 } else {
                     // do nothing
                 }
@@ -2905,7 +3471,7 @@ static esp_err_t gnssGetLocFixType(xplrGnss_t *locDvc, char *buffer)
                 XPLRGNSS_CONSOLE(W, "Seems like location fix type is not a valid char [%c]!", buffer[strIdx + 1]);
                 ret = ESP_FAIL;
             } else {
-                noFixCnt = 0;
+                locDvc->locData.noFixCnt = 0;
                 locDvc->locData.locData.locFixType = buffer[strIdx + 1] - '0';
 
                 switch (locDvc->locData.locData.locFixType) {
@@ -2924,13 +3490,24 @@ static esp_err_t gnssGetLocFixType(xplrGnss_t *locDvc, char *buffer)
                 }
             }
         } else {
-            if (noFixCnt < 10) {
-                noFixCnt++;
+            if (locDvc->locData.noFixCnt < 10) {
+                locDvc->locData.noFixCnt++;
             } else {
                 // do nothing
             }
             ret = ESP_OK;
         }
+
+        /**
+         * GGA carries no iTOW: a fix type change is published along with
+         * the last complete epoch, or with the next one if it is still
+         * being assembled
+         */
+        if (locDvc->locData.locData.locFixType != prevFixType) {
+            gnssLocationPublish(locDvc);
+        } else {
+            // do nothing
+        }
     }
 
     return ret;
@@ -2967,13 +3544,10 @@ static esp_err_t gnssAccuracyParser(xplrGnss_t *locDvc, char *buffer)
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
-        locDvc->locData.locData.accuracy.horizontal = 0;
-        locDvc->locData.locData.accuracy.vertical   = 0;
-
         locDvc->locData.locData.accuracy.horizontal = (uint32_t) uUbxProtocolUint32Decode(buffer + 34);
         locDvc->locData.locData.accuracy.vertical   = (uint32_t) uUbxProtocolUint32Decode(buffer + 38);
-
-        locDvc->options.flags.status.locMsgDataRefreshed = 1;
+        locDvc->locData.accITOW = (uint32_t) uUbxProtocolUint32Decode(buffer + 10);
+        gnssLocationPublish(locDvc);
 
         ret = ESP_OK;
     }
@@ -3118,19 +3692,15 @@ static esp_err_t gnssImuSetCalibData(uint8_t dvcProfile)
 static esp_err_t gnssEsfAlgParser(xplrGnss_t *locDvc, char *buffer)
 {
     esp_err_t ret;
-    uint8_t flags = 0;
+    bool degraded;
 
     if ((locDvc == NULL) || (buffer == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
-        flags = buffer[11];
-        locDvc->drData.info.mode = (flags & 1);
-        locDvc->drData.info.data.yaw   = (uint32_t) uUbxProtocolUint32Decode(buffer + 14);
-        locDvc->drData.info.data.pitch = (int16_t)  uUbxProtocolUint16Decode(buffer + 18);
-        locDvc->drData.info.data.roll  = (int16_t)  uUbxProtocolUint16Decode(buffer + 20);
-        flags >>= 1;
-        locDvc->drData.info.status = flags;
+        degraded = xplrGnssDrEsfAlgDecode(&locDvc->drData,
+                                          (const uint8_t *)buffer,
+                                          esp_timer_get_time());
 
         switch (locDvc->drData.info.status) {
             case XPLR_GNSS_ALG_STATUS_USER_DEFINED:
@@ -3151,20 +3721,28 @@ static esp_err_t gnssEsfAlgParser(xplrGnss_t *locDvc, char *buffer)
 
             case XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT:
             case XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT:
-                if ((locDvc->options.flags.status.drUpdateNvs == 0) &&
-                    (locDvc->conf->dr.mode == XPLR_GNSS_IMU_CALIBRATION_AUTO)) {
-                    locDvc->options.flags.status.drUpdateNvs = 1;
-                } else {
-                    // do nothing
-                }
+                /* gnssDrCalibCandidate decides when the alignment is worth storing */
                 locDvc->options.flags.status.drIsCalibrated = 1;
                 break;
 
             default:
-                locDvc->drData.info.status = XPLR_GNSS_ALG_STATUS_UNKNOWN;
                 locDvc->options.flags.status.drIsCalibrated = 0;
                 break;
         }
+
+        gnssDrCalibCandidate(locDvc);
+        gnssDrHealthPublish(locDvc, degraded);
+        gnssSnapshotPublish(&locDvc->snapshots.infoSeq,
+                            &locDvc->snapshots.info,
+                            &locDvc->drData.info,
+                            sizeof(xplrGnssImuAlignmentInfo_t),
+                            &locDvc->drData.info.epoch);
+        if (locDvc->drData.info.status != locDvc->events.lastAlgStatus) {
+            locDvc->events.lastAlgStatus = locDvc->drData.info.status;
+            gnssEventsDr(locDvc, XPLR_GNSS_EVENT_DR_STATE, &locDvc->drData.info.epoch);
+        } else {
+            // do nothing
+        }
         ret = ESP_OK;
     }
 
@@ -3178,48 +3756,42 @@ static esp_err_t gnssEsfAlgParser(xplrGnss_t *locDvc, char *buffer)
 static esp_err_t gnssEsfStatusParser(xplrGnss_t *locDvc, char *buffer)
 {
     esp_err_t ret;
-    uint8_t numSens;
+    uint8_t lastFaults;
+    bool degraded;
 
     if ((locDvc == NULL) || (buffer == NULL)) {
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
-        if (buffer[21] > XPLR_GNSS_SENSORS_MAX_CNT) {
+        lastFaults = locDvc->drData.health.sensorFaults;
+        if (!xplrGnssDrEsfStatusDecode(&locDvc->drData,
+                                       (const uint8_t *)buffer,
+                                       esp_timer_get_time(),
+                                       &degraded)) {
             XPLRGNSS_CONSOLE(E, "Too many sensors!");
             ret = ESP_FAIL;
         } else {
-            locDvc->drData.status.fusionMode = buffer[18];
-            locDvc->drData.status.numSens = buffer[21];
-
-            for (numSens = 0; numSens < buffer[21]; numSens++) {
-                locDvc->drData.status.sensor[numSens].type  = buffer[22 + (4 * numSens)] & 0b00111111;
-                locDvc->drData.status.sensor[numSens].used  = (buffer[22 + (4 * numSens)] >> 6) & 1;
-                locDvc->drData.status.sensor[numSens].ready = (buffer[22 + (4 * numSens)] >> 7) & 1;
-
-                switch (buffer[23 + (4 * numSens)] & 0b00000011) {
-                    case 0:
-                        locDvc->drData.status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_NOT_CALIBRATED;
-                        break;
-                    case 1:
-                        locDvc->drData.status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_CALIBRATING;
-                        break;
-
-                    case 2:
-                    case 3:
-                        locDvc->drData.status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_CALIBRATED;
-                        break;
-
-                    default:
-                        locDvc->drData.status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_UNKNOWN;
-                        break;
-                }
-
-                locDvc->drData.status.sensor[numSens].freq = buffer[24 + (4 * numSens)];
-                locDvc->drData.status.sensor[numSens].faults.allFaults = buffer[25 + (4 * numSens)];
+            if ((locDvc->drData.health.sensorFaults & ~lastFaults) != 0) {
+                XPLRGNSS_CONSOLE(W,
+                                 "New sensor fault flags [0x%02x]!",
+                                 locDvc->drData.health.sensorFaults & ~lastFaults);
+            } else {
+                // do nothing
+            }
+            gnssDrHealthPublish(locDvc, degraded);
+            gnssSnapshotPublish(&locDvc->snapshots.statusSeq,
+                                &locDvc->snapshots.status,
+                                &locDvc->drData.status,
+                                sizeof(xplrGnssImuFusionStatus_t),
+                                &locDvc->drData.status.epoch);
+            if (locDvc->drData.status.fusionMode != locDvc->events.lastFusionMode) {
+                locDvc->events.lastFusionMode = locDvc->drData.status.fusionMode;
+                gnssEventsDr(locDvc, XPLR_GNSS_EVENT_DR_STATE, &locDvc->drData.status.epoch);
+            } else {
+                // do nothing
             }
+            ret = ESP_OK;
         }
-
-        ret = ESP_OK;
     }
 
     return ret;
@@ -3237,14 +3809,12 @@ static esp_err_t gnssEsfInsParser(xplrGnss_t *locDvc, char *buffer)
         XPLRGNSS_CONSOLE(E, "Invalid argument!");
         ret = ESP_ERR_INVALID_ARG;
     } else {
-        locDvc->drData.dynamics.valFlags.allFlags = buffer[7] & 0b00111111;
-
-        locDvc->drData.dynamics.xAngRate = (int32_t) uUbxProtocolUint32Decode(buffer + 18);
-        locDvc->drData.dynamics.yAngRate = (int32_t) uUbxProtocolUint32Decode(buffer + 22);
-        locDvc->drData.dynamics.zAngRate = (int32_t) uUbxProtocolUint32Decode(buffer + 26);
-        locDvc->drData.dynamics.xAccel = (int32_t) uUbxProtocolUint32Decode(buffer + 30);
-        locDvc->drData.dynamics.yAccel = (int32_t) uUbxProtocolUint32Decode(buffer + 34);
-        locDvc->drData.dynamics.zAccel = (int32_t) uUbxProtocolUint32Decode(buffer + 38);
+        xplrGnssDrEsfInsDecode(&locDvc->drData, (const uint8_t *)buffer);
+        gnssSnapshotPublish(&locDvc->snapshots.dynamicsSeq,
+                            &locDvc->snapshots.dynamics,
+                            &locDvc->drData.dynamics,
+                            sizeof(xplrGnssImuVehDynMeas_t),
+                            &locDvc->drData.dynamics.epoch);
         ret = ESP_OK;
     }
 
@@ -3258,199 +3828,790 @@ static esp_err_t gnssEsfInsParser(xplrGnss_t *locDvc, char *buffer)
 static esp_err_t gnssUpdSoSParser(xplrGnss_t *locDvc, char *buffer)
 {
     esp_err_t ret;
-    uint8_t cmd;
-    uint8_t response;
 
     if ((locDvc == NULL) || (buffer == NULL)) {
         ret = ESP_ERR_INVALID_ARG;
+    } else if (xplrGnssDrUpdSosDecode(&locDvc->conf->backup, (const uint8_t *)buffer)) {
+        ret = ESP_OK;
     } else {
-        /*Check page 173 of HPS 1.30 Interface manual for more information on the parsing of the message*/
-        cmd = (uint8_t) buffer[6];
-        response = (uint8_t) buffer[6 + 4];
-        switch (cmd) {
-            case 2U:
-                /*Backup creation acknowledge*/
-                if (response == 0) {
-                    locDvc->conf->backup.hasBackup = 0;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_UNKNOWN;
-                } else if (response == 1) {
-                    locDvc->conf->backup.hasBackup = 1;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_ACKNOWLEDGED;
-                } else {
-                    locDvc->conf->backup.hasBackup = 0;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_ERROR;
-                }
-                break;
-            case 3U:
-                /*System restored from backup*/
-                if (response == 0x00) {
-                    locDvc->conf->backup.isRestored = 0;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_UNKNOWN;
-                } else if (response == 0x01) {
-                    locDvc->conf->backup.isRestored = 0;
-                    locDvc->conf->backup.hasBackup = 1;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_FAILED_RESTORE;
-                } else if (response == 0x02) {
-                    locDvc->conf->backup.isRestored = 1;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_RESTORED;
-                } else if (response == 0x03) {
-                    locDvc->conf->backup.isRestored = 0;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_NO_BACKUP;
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
+/**
+ * ACK-ACK Parser
+ * Acknowledgment message parser
+*/
+static esp_err_t gnssAckAckParser(xplrGnss_t *locDvc, char *buffer)
+{
+    esp_err_t ret;
+    uint16_t response;
+
+    if ((locDvc == NULL) || (buffer == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        response = uUbxProtocolUint16Decode(buffer + 6);
+        response = ((response << 8) & 0xFF00) | ((response >> 8) & 0x00FF);
+        /*Check if msgIdUpdSoS responded ACK*/
+        if (response == msgIdUpdSoS.id.ubx) {
+            ret = ESP_OK;
+            locDvc->conf->backup.cmdAck = 1;
+        } else {
+            ret = ESP_OK;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * ACK-NACK Parser
+ * Acknowledgment message parser
+*/
+static esp_err_t gnssAckNakParser(xplrGnss_t *locDvc, char *buffer)
+{
+    esp_err_t ret;
+    uint16_t response;
+
+    if ((locDvc == NULL) || (buffer == NULL)) {
+        XPLRGNSS_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        response = uUbxProtocolUint16Decode(buffer + 6);
+        response = ((response << 8) & 0xFF00) | ((response >> 8) & 0x00FF);
+        /*Check if msgIdUpdSoS responded NACK*/
+        if (response == msgIdUpdSoS.id.ubx) {
+            ret = ESP_OK;
+            locDvc->conf->backup.cmdAck = -1;
+        } else {
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Geolocation parser
+ */
+static esp_err_t gnssGeolocationParser(xplrGnss_t *locDvc, char *buffer)
+{
+    esp_err_t ret;
+    int32_t months;
+    int32_t year;
+    int64_t t = -1;
+
+    switch (locDvc->conf->hw.dvcConfig.deviceType) {
+        case U_DEVICE_TYPE_GNSS:
+            locDvc->locData.locData.location.type = U_LOCATION_TYPE_GNSS;
+            break;
+        default:
+            locDvc->locData.locData.location.type = U_LOCATION_TYPE_NONE;
+            break;
+    }
+
+    /**
+     * Time conversion taken from ubxlib
+     */
+    if ((buffer[17] & 0x03) == 0x03) {
+        /**
+         * Time and date are valid; we don't indicate
+         * success based on this but we report it anyway
+         * if it is valid
+         */
+        t = 0;
+
+        /**
+         * Year is 1999-2099, so need to adjust to get year since 1970
+         */
+        year = ((int32_t) uUbxProtocolUint16Decode(buffer + 10) - 1999) + 29;
+
+        /**
+         * Month (1 to 12), so take away 1 to make it zero-based
+         */
+        months = buffer[12] - 1;
+        months += year * 12;
+
+        // Work out the number of seconds due to the year/month count
+        t += uTimeMonthsToSecondsUtc(months);
+        // Day (1 to 31)
+        t += ((int32_t) buffer[13] - 1) * 3600 * 24;
+        // Hour (0 to 23)
+        t += ((int32_t) buffer[14]) * 3600;
+        // Minute (0 to 59)
+        t += ((int32_t) buffer[15]) * 60;
+        // Second (0 to 60)
+        t += buffer[16];
+    }
+
+    locDvc->locData.locData.location.timeUtc = t;
+
+    if (buffer[27] & 0x01) {
+        locDvc->locData.locData.location.svs = (int32_t) buffer[29];
+        locDvc->locData.locData.location.longitudeX1e7 = (int32_t) uUbxProtocolUint32Decode(buffer + 30);
+        locDvc->locData.locData.location.latitudeX1e7 = (int32_t) uUbxProtocolUint32Decode(buffer + 34);
+
+        /*INDENT-OFF*/
+        if (buffer[26] == 0x03) {
+            locDvc->locData.locData.location.altitudeMillimetres = (int32_t) uUbxProtocolUint32Decode(buffer + 42);
+        } else {
+            locDvc->locData.locData.location.altitudeMillimetres = INT_MIN;
+        }
+
+        locDvc->locData.locData.location.radiusMillimetres = (int32_t) uUbxProtocolUint32Decode(buffer + 46);
+        locDvc->locData.locData.location.speedMillimetresPerSecond = (int32_t) uUbxProtocolUint32Decode(buffer + 66);
+        /*INDENT-ON*/
+
+        locDvc->options.flags.status.locMsgDataAvailable = 1;
+    } else {
+        locDvc->options.flags.status.locMsgDataAvailable = 0;
+    }
+
+    locDvc->locData.pvtITOW = (uint32_t) uUbxProtocolUint32Decode(buffer + 6);
+    gnssLocationPublish(locDvc);
+
+    ret = ESP_OK;
+
+    return ret;
+}
+
+/**
+ * Resets the location assembly, called before (re)starting the UBX async
+ */
+static void gnssSnapshotsReset(xplrGnss_t *locDvc)
+{
+    locDvc->locData.pvtITOW = XPLR_GNSS_ITOW_INVALID;
+    locDvc->locData.accITOW = XPLR_GNSS_ITOW_INVALID;
+    locDvc->events.lastLocITOW = XPLR_GNSS_ITOW_INVALID;
+    locDvc->events.lastFixType = XPLR_GNSS_LOCFIX_INVALID;
+    locDvc->events.lastFusionMode = XPLR_GNSS_FUSION_MODE_UNKNOWN;
+    locDvc->events.lastAlgStatus = XPLR_GNSS_ALG_STATUS_UNKNOWN;
+    xplrGnssDrReset(&locDvc->drData);
+}
+
+/**
+ * Publishes the location once NAV-PVT and NAV-HPPOSLLH of the
+ * same epoch have both been parsed
+ */
+static void gnssLocationPublish(xplrGnss_t *locDvc)
+{
+    if ((locDvc->locData.pvtITOW != XPLR_GNSS_ITOW_INVALID) &&
+        (locDvc->locData.pvtITOW == locDvc->locData.accITOW)) {
+        locDvc->locData.locData.epoch.iTOW = locDvc->locData.pvtITOW;
+        gnssSnapshotPublish(&locDvc->snapshots.locSeq,
+                            &locDvc->snapshots.loc,
+                            &locDvc->locData.locData,
+                            sizeof(xplrGnssLocation_t),
+                            &locDvc->locData.locData.epoch);
+        locDvc->options.flags.status.locMsgDataRefreshed = 1;
+        gnssWarmStartMilestones(locDvc);
+        gnssEventsLocation(locDvc);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Counts a correction data/keys message sent to a device
+ */
+static void gnssCorrStatsUpdate(xplrGnss_t *locDvc, esp_err_t result)
+{
+    if (result == ESP_OK) {
+        locDvc->stats.corrMsgs++;
+    } else {
+        locDvc->stats.corrErrors++;
+    }
+}
+
+/**
+ * Returns an active subscriber slot, NULL if the ids are not valid
+ */
+static xplrGnssSubscriber_t *gnssSubscriberGet(uint8_t dvcProfile, int8_t subId)
+{
+    xplrGnssSubscriber_t *ret = NULL;
+
+    if (gnssIsDvcProfileValid(dvcProfile) &&
+        (subId >= 0) && (subId < XPLRGNSS_SUBSCRIBERS_MAX) &&
+        dvc[dvcProfile].events.sub[subId].inUse) {
+        ret = &dvc[dvcProfile].events.sub[subId];
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+/**
+ * Fans a freshly published location out to the subscribers.
+ * Called from the ubxlib callback task only.
+ */
+static void gnssEventsLocation(xplrGnss_t *locDvc)
+{
+    xplrGnssSubscriber_t *sub;
+    xplrGnssEvent_t event;
+    const xplrGnssLocation_t *loc = &locDvc->locData.locData;
+    bool newEpoch = (loc->epoch.iTOW != locDvc->events.lastLocITOW);
+    bool newFixType = (loc->locFixType != locDvc->events.lastFixType);
+    int8_t below;
+    uint8_t i;
+
+    locDvc->events.lastLocITOW = loc->epoch.iTOW;
+    locDvc->events.lastFixType = loc->locFixType;
+
+    if (locDvc->events.xSemSubscribers != NULL) {
+        event.dvcProfile = (uint8_t)(locDvc - dvc);
+        event.data.location = *loc;
+        xSemaphoreTakeRecursive(locDvc->events.xSemSubscribers, portMAX_DELAY);
+        for (i = 0; i < XPLRGNSS_SUBSCRIBERS_MAX; i++) {
+            sub = &locDvc->events.sub[i];
+            if (sub->inUse && newEpoch && ((sub->cfg.events & XPLR_GNSS_EVENT_LOCATION) != 0)) {
+                event.type = XPLR_GNSS_EVENT_LOCATION;
+                gnssEventDeliver(sub, &event);
+            } else {
+                // do nothing
+            }
+
+            if (sub->inUse && newFixType && ((sub->cfg.events & XPLR_GNSS_EVENT_FIX_TYPE) != 0)) {
+                event.type = XPLR_GNSS_EVENT_FIX_TYPE;
+                gnssEventDeliver(sub, &event);
+            } else {
+                // do nothing
+            }
+
+            if (sub->inUse && newEpoch && ((sub->cfg.events & XPLR_GNSS_EVENT_ACCURACY) != 0)) {
+                below = (loc->accuracy.horizontal <= sub->cfg.accuracyThreshold) ? 1 : 0;
+                if (below != sub->accuracyBelow) {
+                    sub->accuracyBelow = below;
+                    event.type = XPLR_GNSS_EVENT_ACCURACY;
+                    gnssEventDeliver(sub, &event);
                 } else {
-                    locDvc->conf->backup.isRestored = 0;
-                    locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_ERROR;
+                    // do nothing
                 }
-                break;
-            default:
-                locDvc->conf->backup.hasBackup = 0;
-                locDvc->conf->backup.isRestored = 0;
-                locDvc->conf->backup.state = XPLR_GNSS_SOS_STATE_ERROR;
-                break;
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGiveRecursive(locDvc->events.xSemSubscribers);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Fans a fusion mode or alignment status change out to the subscribers.
+ * Called from the ubxlib callback task only.
+ */
+static void gnssEventsDr(xplrGnss_t *locDvc,
+                         xplrGnssEventType_t type,
+                         const xplrGnssEpoch_t *epoch)
+{
+    xplrGnssSubscriber_t *sub;
+    xplrGnssEvent_t event;
+    uint8_t i;
+
+    if (locDvc->events.xSemSubscribers != NULL) {
+        event.type = type;
+        event.dvcProfile = (uint8_t)(locDvc - dvc);
+        event.data.dr.fusionMode = locDvc->drData.status.fusionMode;
+        event.data.dr.algStatus = locDvc->drData.info.status;
+        event.data.dr.algErrors = locDvc->drData.health.algErrors;
+        event.data.dr.sensorFaults = locDvc->drData.health.sensorFaults;
+        event.data.dr.score = locDvc->drData.health.score;
+        event.data.dr.epoch = *epoch;
+        xSemaphoreTakeRecursive(locDvc->events.xSemSubscribers, portMAX_DELAY);
+        for (i = 0; i < XPLRGNSS_SUBSCRIBERS_MAX; i++) {
+            sub = &locDvc->events.sub[i];
+            if (sub->inUse && ((sub->cfg.events & type) != 0)) {
+                gnssEventDeliver(sub, &event);
+            } else {
+                // do nothing
+            }
+        }
+        xSemaphoreGiveRecursive(locDvc->events.xSemSubscribers);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Hands an event to a subscriber without blocking.
+ * A full queue loses its oldest event so the latest state always gets through.
+ */
+static void gnssEventDeliver(xplrGnssSubscriber_t *sub, const xplrGnssEvent_t *event)
+{
+    xplrGnssEvent_t stale;
+
+    if (sub->cfg.cb != NULL) {
+        sub->cfg.cb(event, sub->cfg.cbArg);
+    } else if (xQueueSend(sub->queue, event, 0) != pdTRUE) {
+        (void)xQueueReceive(sub->queue, &stale, 0);
+        sub->dropped++;
+        (void)xQueueSend(sub->queue, event, 0);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Flags the FSM to store an automatic alignment once it has settled and
+ * scores better than the stored one. Called from the ubxlib callback task only.
+ */
+static void gnssDrCalibCandidate(xplrGnss_t *locDvc)
+{
+    const xplrGnssDrHealth_t *health = &locDvc->drData.health;
+
+    if ((locDvc->conf != NULL) &&
+        (locDvc->conf->dr.mode == XPLR_GNSS_IMU_CALIBRATION_AUTO) &&
+        (health->convergedMs >= (XPLR_GNSS_DR_CALIB_SETTLE_S * 1000U)) &&
+        (health->score > locDvc->drData.storedScore) &&
+        (locDvc->options.flags.status.drUpdateNvs != 1)) {
+        XPLRGNSS_CONSOLE(I,
+                         "Alignment settled with score %u, better than stored %u.",
+                         health->score,
+                         locDvc->drData.storedScore);
+        locDvc->drData.candidateScore = health->score;
+        locDvc->options.flags.status.drUpdateNvs = 1;
+    } else {
+        // do nothing
+    }
+}
 
+/**
+ * Publishes the DR health and raises a degradation event if needed
+ */
+static void gnssDrHealthPublish(xplrGnss_t *locDvc, bool degraded)
+{
+    locDvc->drData.health.storedScore = locDvc->drData.storedScore;
+    gnssSnapshotPublish(&locDvc->snapshots.healthSeq,
+                        &locDvc->snapshots.health,
+                        &locDvc->drData.health,
+                        sizeof(xplrGnssDrHealth_t),
+                        &locDvc->drData.health.epoch);
+    if (degraded) {
+        gnssEventsDr(locDvc, XPLR_GNSS_EVENT_DR_DEGRADED, &locDvc->drData.health.epoch);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Counts this boot in the time-to-fix histogram and gives the
+ * receiver the last known position, the time and the cached
+ * decryption keys, so it does not have to start cold
+ */
+static esp_err_t gnssWarmStart(uint8_t dvcProfile)
+{
+    xplrGnss_t *locDvc = &dvc[dvcProfile];
+    xplrGnssWarmStart_t *warm = &locDvc->warmStart;
+    xplrLocNvs_t *storage = &locDvc->options.storage;
+    xplrNvs_error_t err;
+    size_t size;
+    esp_err_t ret = ESP_OK;
+
+    if (!warm->bootCounted) {
+        size = sizeof(warm->hist);
+        err = xplrNvsReadBlob(&storage->nvs, "ttffHist", &warm->hist, &size);
+        if ((err != XPLR_NVS_OK) || (size != sizeof(warm->hist))) {
+            XPLRGNSS_CONSOLE(W, "No time-to-fix histogram in <%s>, starting a new one.", storage->id);
+            memset(&warm->hist, 0, sizeof(warm->hist));
+        } else {
+            // do nothing
         }
-        if (locDvc->conf->backup.state == XPLR_GNSS_SOS_STATE_ERROR) {
+        warm->hist.boots++;
+        warm->bootCounted = true;
+        err = xplrNvsWriteBlob(&storage->nvs, "ttffHist", &warm->hist, sizeof(warm->hist));
+        if (err != XPLR_NVS_OK) {
             ret = ESP_FAIL;
         } else {
-            ret = ESP_OK;
+            // do nothing
         }
+    } else {
+        // restarted, this boot is already counted
+    }
+
+#if (1 == XPLRGNSS_WARM_START_ACTIVE)
+    size = sizeof(warm->rec);
+    err = xplrNvsReadBlob(&storage->nvs, "warmPos", &warm->rec, &size);
+    if ((err != XPLR_NVS_OK) ||
+        (size != sizeof(warm->rec)) ||
+        (warm->rec.version != XPLR_GNSS_WARM_START_REC_VERSION)) {
+        XPLRGNSS_CONSOLE(D, "No last known position stored, no position aiding.");
+        memset(&warm->rec, 0, sizeof(warm->rec));
+    } else {
+        if (gnssWarmStartAidPosition(dvcProfile) == ESP_OK) {
+            warm->ttff.aided = true;
+        } else {
+            ret = ESP_FAIL;
+        }
+        if (gnssWarmStartAidTime(dvcProfile) != ESP_OK) {
+            ret = ESP_FAIL;
+        } else {
+            // do nothing
+        }
+    }
+
+    if (gnssWarmStartKeys(dvcProfile) != ESP_OK) {
+        ret = ESP_FAIL;
+    } else {
+        // do nothing
+    }
+#endif
+
+    return ret;
+}
+
+/**
+ * Injects the last known position with UBX-MGA-INI-POS_LLH
+ */
+static esp_err_t gnssWarmStartAidPosition(uint8_t dvcProfile)
+{
+    const xplrGnssWarmStartRec_t *rec = &dvc[dvcProfile].warmStart.rec;
+    uint8_t payload[20] = {0};
+    uint8_t buffer[20 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES] = {0};
+    uint32_t val;
+    int16_t length;
+    esp_err_t ret;
+
+    payload[0] = 0x01;  /* POS_LLH */
+    val = uUbxProtocolUint32Encode((uint32_t)rec->latitudeX1e7);
+    memcpy(&payload[4], &val, sizeof(val));
+    val = uUbxProtocolUint32Encode((uint32_t)rec->longitudeX1e7);
+    memcpy(&payload[8], &val, sizeof(val));
+    val = uUbxProtocolUint32Encode((uint32_t)(rec->altitudeMm / 10));
+    memcpy(&payload[12], &val, sizeof(val));
+    val = uUbxProtocolUint32Encode(XPLR_GNSS_WARM_START_POS_ACC_CM);
+    memcpy(&payload[16], &val, sizeof(val));
+
+    length = uUbxProtocolEncode(0x13,
+                                0x40,
+                                (const char *) payload,
+                                sizeof(payload),
+                                (char *) buffer);
+    if (length > 0) {
+        ret = xplrGnssSendFormattedCommand(dvcProfile, (const char *) buffer, length);
+        if (ret == ESP_OK) {
+            XPLRGNSS_CONSOLE(I,
+                             "Injected last known position (%d, %d).",
+                             rec->latitudeX1e7,
+                             rec->longitudeX1e7);
+        } else {
+            XPLRGNSS_CONSOLE(E, "Failed to inject last known position!");
+        }
+    } else {
+        XPLRGNSS_CONSOLE(E, "Encoding UBX command failed with error code [%d]!", length);
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
+/**
+ * Injects the system time with UBX-MGA-INI-TIME_UTC.
+ * Only done when the clock is set (e.g. by SNTP before the GNSS start):
+ * a clock behind the stored position time has not been set since boot.
+ */
+static esp_err_t gnssWarmStartAidTime(uint8_t dvcProfile)
+{
+    const xplrGnssWarmStartRec_t *rec = &dvc[dvcProfile].warmStart.rec;
+    uint8_t payload[24] = {0};
+    uint8_t buffer[24 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES] = {0};
+    time_t now = time(NULL);
+    struct tm utc;
+    uint16_t val;
+    int16_t length;
+    esp_err_t ret;
+
+    if ((rec->timeUtc <= 0) || ((int64_t)now < rec->timeUtc)) {
+        XPLRGNSS_CONSOLE(D, "System time not set, no time aiding.");
+        ret = ESP_OK;
+    } else {
+        gmtime_r(&now, &utc);
+        payload[0] = 0x10;  /* TIME_UTC */
+        payload[3] = 0x80;  /* leap seconds unknown */
+        val = uUbxProtocolUint16Encode((uint16_t)(utc.tm_year + 1900));
+        memcpy(&payload[4], &val, sizeof(val));
+        payload[6] = (uint8_t)(utc.tm_mon + 1);
+        payload[7] = (uint8_t)utc.tm_mday;
+        payload[8] = (uint8_t)utc.tm_hour;
+        payload[9] = (uint8_t)utc.tm_min;
+        payload[10] = (uint8_t)utc.tm_sec;
+        val = uUbxProtocolUint16Encode(XPLR_GNSS_WARM_START_TIME_ACC_S);
+        memcpy(&payload[16], &val, sizeof(val));
+
+        length = uUbxProtocolEncode(0x13,
+                                    0x40,
+                                    (const char *) payload,
+                                    sizeof(payload),
+                                    (char *) buffer);
+        if (length > 0) {
+            ret = xplrGnssSendFormattedCommand(dvcProfile, (const char *) buffer, length);
+            if (ret == ESP_OK) {
+                XPLRGNSS_CONSOLE(I, "Injected system time.");
+            } else {
+                XPLRGNSS_CONSOLE(E, "Failed to inject system time!");
+            }
+        } else {
+            XPLRGNSS_CONSOLE(E, "Encoding UBX command failed with error code [%d]!", length);
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Sends the decryption keys cached in NVS when the application did not
+ * configure any, so SPARTN can be decrypted before the keys arrive over MQTT
+ */
+static esp_err_t gnssWarmStartKeys(uint8_t dvcProfile)
+{
+    xplrGnss_t *locDvc = &dvc[dvcProfile];
+    xplrGnssDecryptionKeys_t *keys = &locDvc->conf->corrData.keys;
+    xplrLocNvs_t *storage = &locDvc->options.storage;
+    char cached[XPLR_GNSS_DECRYPTION_KEYS_LEN];
+    size_t size = sizeof(cached);
+    xplrNvs_error_t err;
+    esp_err_t ret;
+
+    err = xplrNvsReadBlob(&storage->nvs, "decrKeys", cached, &size);
+    if ((err != XPLR_NVS_OK) || (size == 0) || (size >= XPLR_GNSS_DECRYPTION_KEYS_LEN)) {
+        size = 0;
+    } else {
+        // do nothing
+    }
+
+    if (keys->size > 0) {
+        /* keys were sent already, refresh the cache if they differ */
+        if ((size != keys->size) || (memcmp(cached, keys->keys, size) != 0)) {
+            locDvc->warmStart.keysChanged = true;
+        } else {
+            // do nothing
+        }
+        ret = ESP_OK;
+    } else if (size > 0) {
+        memcpy(keys->keys, cached, size);
+        keys->size = size;
+        ret = gnssSetDecrKeys(dvcProfile);
+        if (ret == ESP_OK) {
+            XPLRGNSS_CONSOLE(I, "Sent cached decryption keys.");
+        } else {
+            XPLRGNSS_CONSOLE(E, "Failed to send cached decryption keys!");
+        }
+    } else {
+        XPLRGNSS_CONSOLE(D, "No cached decryption keys.");
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+/**
+ * Times the startup milestones from the fix type of a published location.
+ * Called from the ubxlib callback task only.
+ */
+static void gnssWarmStartMilestones(xplrGnss_t *locDvc)
+{
+    xplrGnssWarmStart_t *warm = &locDvc->warmStart;
+    uint32_t reached;
+    uint32_t nowMs;
+    uint8_t i;
+
+    switch (locDvc->locData.locData.locFixType) {
+        case XPLR_GNSS_LOCFIX_FIXED_RTK:
+            reached = (1U << XPLR_GNSS_TTFF_FIRST_FIX) |
+                      (1U << XPLR_GNSS_TTFF_RTK_FLOAT) |
+                      (1U << XPLR_GNSS_TTFF_RTK_FIXED);
+            break;
+        case XPLR_GNSS_LOCFIX_FLOAT_RTK:
+            reached = (1U << XPLR_GNSS_TTFF_FIRST_FIX) | (1U << XPLR_GNSS_TTFF_RTK_FLOAT);
+            break;
+        case XPLR_GNSS_LOCFIX_2D3D:
+        case XPLR_GNSS_LOCFIX_DGNSS:
+            reached = (1U << XPLR_GNSS_TTFF_FIRST_FIX);
+            break;
+        default:
+            reached = 0;
+            break;
+    }
+
+    reached &= ~warm->reachedMask;
+    if (reached != 0) {
+        nowMs = (uint32_t)(esp_timer_get_time() / 1000);
+        for (i = 0; i < XPLR_GNSS_TTFF_NUMOF_MILESTONES; i++) {
+            if ((reached & (1U << i)) != 0) {
+                warm->ttff.ms[i] = nowMs;
+                XPLRGNSS_CONSOLE(I, "%s after %u ms from boot.", gnssTtffNames[i], nowMs);
+            } else {
+                // do nothing
+            }
+        }
+        warm->reachedMask |= reached;
+    } else {
+        // do nothing
     }
-
-    return ret;
 }
 
 /**
- * ACK-ACK Parser
- * Acknowledgment message parser
-*/
-static esp_err_t gnssAckAckParser(xplrGnss_t *locDvc, char *buffer)
+ * Checks if there is warm start data to store in NVS
+ */
+static bool gnssWarmStartSaveDue(xplrGnss_t *locDvc)
 {
-    esp_err_t ret;
-    uint16_t response;
+    xplrGnssWarmStart_t *warm = &locDvc->warmStart;
+    bool ret;
 
-    if ((locDvc == NULL) || (buffer == NULL)) {
-        XPLRGNSS_CONSOLE(E, "Invalid argument!");
-        ret = ESP_ERR_INVALID_ARG;
+    if (!warm->bootCounted) {
+        ret = false;
+    } else if ((warm->reachedMask != warm->storedMask) || warm->histClear || warm->keysChanged) {
+        ret = true;
+    } else if (((warm->reachedMask & (1U << XPLR_GNSS_TTFF_FIRST_FIX)) != 0) &&
+               (MICROTOSEC(esp_timer_get_time() - warm->lastSave) >= XPLR_GNSS_WARM_START_SAVE_INTERVAL_S)) {
+        ret = true;
     } else {
-        response = uUbxProtocolUint16Decode(buffer + 6);
-        response = ((response << 8) & 0xFF00) | ((response >> 8) & 0x00FF);
-        /*Check if msgIdUpdSoS responded ACK*/
-        if (response == msgIdUpdSoS.id.ubx) {
-            ret = ESP_OK;
-            locDvc->conf->backup.cmdAck = 1;
-        } else {
-            ret = ESP_OK;
-        }
+        ret = false;
     }
 
     return ret;
 }
 
 /**
- * ACK-NACK Parser
- * Acknowledgment message parser
-*/
-static esp_err_t gnssAckNakParser(xplrGnss_t *locDvc, char *buffer)
+ * Stores the new milestones in the histogram, the last known position
+ * and changed decryption keys to NVS
+ */
+static esp_err_t gnssWarmStartSave(uint8_t dvcProfile)
 {
-    esp_err_t ret;
-    uint16_t response;
+    xplrGnss_t *locDvc = &dvc[dvcProfile];
+    xplrGnssWarmStart_t *warm = &locDvc->warmStart;
+    xplrLocNvs_t *storage = &locDvc->options.storage;
+    xplrGnssLocation_t loc;
+    uint32_t newMask = warm->reachedMask & ~warm->storedMask;
+    uint32_t sec;
+    uint8_t i, bin;
+    bool histChanged = (newMask != 0);
+    esp_err_t ret = ESP_OK;
+
+    if (warm->histClear) {
+        warm->histClear = false;
+        memset(&warm->hist, 0, sizeof(warm->hist));
+        histChanged = true;
+    } else {
+        // do nothing
+    }
 
-    if ((locDvc == NULL) || (buffer == NULL)) {
-        XPLRGNSS_CONSOLE(E, "Invalid argument!");
-        ret = ESP_ERR_INVALID_ARG;
+    for (i = 0; i < XPLR_GNSS_TTFF_NUMOF_MILESTONES; i++) {
+        if ((newMask & (1U << i)) != 0) {
+            sec = warm->ttff.ms[i] / 1000;
+            bin = 0;
+            while ((bin < (XPLR_GNSS_TTFF_HIST_BINS - 1)) && (sec >= gnssTtffBinLimitsSec[bin])) {
+                bin++;
+            }
+            if (warm->hist.count[i][bin] < UINT16_MAX) {
+                warm->hist.count[i][bin]++;
+            } else {
+                // do nothing
+            }
+        } else {
+            // do nothing
+        }
+    }
+    warm->storedMask |= newMask;
+
+    if (histChanged &&
+        (xplrNvsWriteBlob(&storage->nvs, "ttffHist", &warm->hist, sizeof(warm->hist)) != XPLR_NVS_OK)) {
+        ret = ESP_FAIL;
     } else {
-        response = uUbxProtocolUint16Decode(buffer + 6);
-        response = ((response << 8) & 0xFF00) | ((response >> 8) & 0x00FF);
-        /*Check if msgIdUpdSoS responded NACK*/
-        if (response == msgIdUpdSoS.id.ubx) {
-            ret = ESP_OK;
-            locDvc->conf->backup.cmdAck = -1;
+        // do nothing
+    }
+
+    warm->lastSave = esp_timer_get_time();
+    if (((warm->reachedMask & (1U << XPLR_GNSS_TTFF_FIRST_FIX)) != 0) &&
+        (gnssSnapshotRead(&locDvc->snapshots.locSeq,
+                          &loc,
+                          &locDvc->snapshots.loc,
+                          sizeof(loc)) == ESP_OK) &&
+        (loc.locFixType != XPLR_GNSS_LOCFIX_INVALID) &&
+        (loc.locFixType != XPLR_GNSS_LOCFIX_DEAD_RECKONING)) {
+        warm->rec.version = XPLR_GNSS_WARM_START_REC_VERSION;
+        warm->rec.latitudeX1e7 = loc.location.latitudeX1e7;
+        warm->rec.longitudeX1e7 = loc.location.longitudeX1e7;
+        warm->rec.altitudeMm = loc.location.altitudeMillimetres;
+        warm->rec.timeUtc = loc.location.timeUtc;
+        if (xplrNvsWriteBlob(&storage->nvs, "warmPos", &warm->rec, sizeof(warm->rec)) != XPLR_NVS_OK) {
+            ret = ESP_FAIL;
         } else {
+            // do nothing
+        }
+    } else {
+        // no fix to remember
+    }
+
+#if (1 == XPLRGNSS_WARM_START_ACTIVE)
+    if (warm->keysChanged) {
+        warm->keysChanged = false;
+        if ((locDvc->conf->corrData.keys.size > 0) &&
+            (xplrNvsWriteBlob(&storage->nvs,
+                              "decrKeys",
+                              locDvc->conf->corrData.keys.keys,
+                              locDvc->conf->corrData.keys.size) != XPLR_NVS_OK)) {
             ret = ESP_FAIL;
+        } else {
+            // do nothing
         }
+    } else {
+        // do nothing
     }
+#else
+    warm->keysChanged = false;
+#endif
 
     return ret;
 }
 
 /**
- * Geolocation parser
+ * Sequence locked publication of a data product.
+ * epoch is the one embedded in src, its counter and timestamp are
+ * updated here. Only ever called from the ubxlib callback task.
  */
-static esp_err_t gnssGeolocationParser(xplrGnss_t *locDvc, char *buffer)
+static void gnssSnapshotPublish(uint32_t *seq,
+                                void *dst,
+                                const void *src,
+                                size_t size,
+                                xplrGnssEpoch_t *epoch)
 {
-    esp_err_t ret;
-    int32_t months;
-    int32_t year;
-    int64_t t = -1;
-
-    switch (locDvc->conf->hw.dvcConfig.deviceType) {
-        case U_DEVICE_TYPE_GNSS:
-            locDvc->locData.locData.location.type = U_LOCATION_TYPE_GNSS;
-            break;
-        default:
-            locDvc->locData.locData.location.type = U_LOCATION_TYPE_NONE;
-            break;
-    }
-
-    /**
-     * Time conversion taken from ubxlib
-     */
-    if ((buffer[17] & 0x03) == 0x03) {
-        /**
-         * Time and date are valid; we don't indicate
-         * success based on this but we report it anyway
-         * if it is valid
-         */
-        t = 0;
-
-        /**
-         * Year is 1999-2099, so need to adjust to get year since 1970
-         */
-        year = ((int32_t) uUbxProtocolUint16Decode(buffer + 10) - 1999) + 29;
-
-        /**
-         * Month (1 to 12), so take away 1 to make it zero-based
-         */
-        months = buffer[12] - 1;
-        months += year * 12;
-
-        // Work out the number of seconds due to the year/month count
-        t += uTimeMonthsToSecondsUtc(months);
-        // Day (1 to 31)
-        t += ((int32_t) buffer[13] - 1) * 3600 * 24;
-        // Hour (0 to 23)
-        t += ((int32_t) buffer[14]) * 3600;
-        // Minute (0 to 59)
-        t += ((int32_t) buffer[15]) * 60;
-        // Second (0 to 60)
-        t += buffer[16];
-    }
+    epoch->seq++;
+    epoch->timestamp = esp_timer_get_time();
 
-    locDvc->locData.locData.location.timeUtc = t;
+    portENTER_CRITICAL(&gnssSnapshotMux);
+    xplrGnssSeqlockPublish(seq, dst, src, size);
+    portEXIT_CRITICAL(&gnssSnapshotMux);
+}
 
-    if (buffer[27] & 0x01) {
-        locDvc->locData.locData.location.svs = (int32_t) buffer[29];
-        locDvc->locData.locData.location.longitudeX1e7 = (int32_t) uUbxProtocolUint32Decode(buffer + 30);
-        locDvc->locData.locData.location.latitudeX1e7 = (int32_t) uUbxProtocolUint32Decode(buffer + 34);
+/**
+ * Lock-free read of a published data product.
+ * Retries while the copy overlaps a publication, never blocks the writer.
+ */
+static esp_err_t gnssSnapshotRead(const uint32_t *seq, void *dst, const void *src, size_t size)
+{
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    uint8_t retries;
 
-        /*INDENT-OFF*/
-        if (buffer[26] == 0x03) {
-            locDvc->locData.locData.location.altitudeMillimetres = (int32_t) uUbxProtocolUint32Decode(buffer + 42);
+    for (retries = 0; retries < XPLR_GNSS_SNAPSHOT_READ_RETRIES; retries++) {
+        if (xplrGnssSeqlockTryRead(seq, dst, src, size)) {
+            ret = ESP_OK;
+            break;
         } else {
-            locDvc->locData.locData.location.altitudeMillimetres = INT_MIN;
+            // do nothing
         }
+    }
 
-        locDvc->locData.locData.location.radiusMillimetres = (int32_t) uUbxProtocolUint32Decode(buffer + 46);
-        locDvc->locData.locData.location.speedMillimetresPerSecond = (int32_t) uUbxProtocolUint32Decode(buffer + 66);
-        /*INDENT-ON*/
-
-        locDvc->options.flags.status.locMsgDataAvailable = 1;
-        locDvc->options.flags.status.locMsgDataRefreshed = 1;
+    if (ret != ESP_OK) {
+        XPLRGNSS_CONSOLE(W, "Snapshot kept changing while being read!");
     } else {
-        locDvc->options.flags.status.locMsgDataAvailable = 0;
+        // do nothing
     }
 
-    ret = ESP_OK;
-
     return ret;
 }
 
@@ -3973,15 +5134,16 @@ static esp_err_t gnssNvsWriteDefaults(uint8_t dvcProfile)
     xplrGnss_t *locDvc = &dvc[dvcProfile];
     esp_err_t ret;
     xplrLocNvs_t *storage = &locDvc->options.storage;
-    xplrNvs_error_t err[4];
+    xplrNvs_error_t err[5];
 
     XPLRGNSS_CONSOLE(D, "Writing default settings in NVS");
     err[0] = xplrNvsWriteString(&storage->nvs, "id", storage->id);
     err[1] = xplrNvsWriteU32(&storage->nvs, "yaw", gnssSensDefaultCalibValYaw);
     err[2] = xplrNvsWriteI16(&storage->nvs, "pitch", gnssSensDefaultCalibValPitch);
     err[3] = xplrNvsWriteI16(&storage->nvs, "roll", gnssSensDefaultCalibValRoll);
+    err[4] = xplrNvsWriteU8(&storage->nvs, "calibScore", 0);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 5; i++) {
         if (err[i] != XPLR_NVS_OK) {
             ret = ESP_FAIL;
             XPLRGNSS_CONSOLE(E, "Error writing element %u of default settings in NVS", i);
@@ -4004,6 +5166,7 @@ static esp_err_t gnssNvsReadConfig(uint8_t dvcProfile)
     xplrLocNvs_t *storage = &locDvc->options.storage;
     size_t size = NVS_KEY_NAME_MAX_SIZE;
     xplrNvs_error_t err[4];
+    uint8_t score;
 
     err[0] = xplrNvsReadString(&storage->nvs, "id", storage->id, &size);
 
@@ -4027,10 +5190,18 @@ static esp_err_t gnssNvsReadConfig(uint8_t dvcProfile)
     }
 
     if (ret == ESP_OK) {
+        /* stored before scores were kept: any converged calibration may replace it */
+        if (xplrNvsReadU8(&storage->nvs, "calibScore", &score) != XPLR_NVS_OK) {
+            score = 0;
+        } else {
+            // do nothing
+        }
+        locDvc->drData.storedScore = score;
         XPLRGNSS_CONSOLE(D, "Read NVS id: <%s>", storage->id);
         XPLRGNSS_CONSOLE(D, "Read NVS yaw: <%d>", locDvc->conf->dr.alignVals.yaw);
         XPLRGNSS_CONSOLE(D, "Read NVS pitch: <%d>", locDvc->conf->dr.alignVals.pitch);
         XPLRGNSS_CONSOLE(D, "Read NVS roll: <%d>", locDvc->conf->dr.alignVals.roll);
+        XPLRGNSS_CONSOLE(D, "Read NVS calibration score: <%u>", score);
     } else {
         // do nothing
     }
@@ -4046,7 +5217,7 @@ esp_err_t gnssNvsUpdate(uint8_t dvcProfile)
     xplrGnss_t *locDvc = &dvc[dvcProfile];
     esp_err_t ret;
     xplrLocNvs_t *storage = &locDvc->options.storage;
-    xplrNvs_error_t err[4];
+    xplrNvs_error_t err[5];
     bool valsValid;
 
     valsValid = gnssCheckAlignValsLimits(dvcProfile);
@@ -4063,8 +5234,11 @@ esp_err_t gnssNvsUpdate(uint8_t dvcProfile)
         err[3] = xplrNvsWriteI16(&storage->nvs,
                                  "roll",
                                  locDvc->conf->dr.alignVals.roll);
+        err[4] = xplrNvsWriteU8(&storage->nvs,
+                                "calibScore",
+                                locDvc->drData.candidateScore);
 
-        for (int i = 0; i < 4; i++) {
+        for (int i = 0; i < 5; i++) {
             if (err[i] != XPLR_NVS_OK) {
                 ret = ESP_FAIL;
                 break;
@@ -4094,6 +5268,8 @@ esp_err_t gnssNvsErase(uint8_t dvcProfile)
     err[1] = xplrNvsEraseKey(&storage->nvs, "yaw");
     err[2] = xplrNvsEraseKey(&storage->nvs, "pitch");
     err[3] = xplrNvsEraseKey(&storage->nvs, "roll");
+    (void)xplrNvsEraseKey(&storage->nvs, "calibScore");
+    locDvc->drData.storedScore = 0;
 
     for (int i = 0; i < 4; i++) {
         if (err[i] != XPLR_NVS_OK) {
@@ -4107,68 +5283,14 @@ esp_err_t gnssNvsErase(uint8_t dvcProfile)
     return ret;
 }
 
-/**
- * Checks if Yaw value is valid
- */
-static bool gnssCheckYawValLimits(uint32_t yaw)
-{
-    bool ret;
-    if (yaw > gnssSensMaxValYaw) {
-        ret = false;
-    } else {
-        ret = true;
-    }
-    return ret;
-}
-
-/**
- * Checks if Pitch value is valid
- */
-static bool gnssCheckPitchValLimits(int16_t pitch)
-{
-    bool ret;
-    if ((pitch < gnssSensMinValPitch) ||
-        (pitch > gnssSensMaxValPitch)) {
-        ret = false;
-    } else {
-        ret = true;
-    }
-    return ret;
-}
-
-/**
- * Checks if Roll value is valid
- */
-static bool gnssCheckRollValLimits(int16_t roll)
-{
-    bool ret;
-    if ((roll < gnssSensMinValRoll) ||
-        (roll > gnssSensMaxValRoll)) {
-        ret = false;
-    } else {
-        ret = true;
-    }
-    return ret;
-}
-
 /**
  * Checks if all calibrations values are valid
  */
 static bool gnssCheckAlignValsLimits(uint8_t dvcProfile)
 {
     xplrGnss_t *locDvc = &dvc[dvcProfile];
-    bool validYaw, validRoll, validPitch, ret;
-
-    validYaw = gnssCheckYawValLimits(locDvc->conf->dr.alignVals.yaw);
-    validPitch = gnssCheckPitchValLimits(locDvc->conf->dr.alignVals.pitch);
-    validRoll = gnssCheckRollValLimits(locDvc->conf->dr.alignVals.roll);
-    if (validYaw && validRoll && validPitch) {
-        ret = true;
-    } else {
-        ret = false;
-    }
 
-    return ret;
+    return xplrGnssDrAlignValsValid(&locDvc->conf->dr.alignVals);
 }
 
 /**
@@ -4704,85 +5826,122 @@ static void gnssUbxProtocolCB(uDeviceHandle_t gnssHandle,
                               int32_t errorCodeOrLength,
                               void *callbackParam)
 {
-    esp_err_t ret;
     int cbRead = 0;
     xplrGnss_t *locDvc = (xplrGnss_t *)callbackParam;
     char buffer[XPLR_GNSS_UBX_BUFF_SIZE];
+    xplrGnssRawMsgSink_t rawSink;
 
     if (errorCodeOrLength > 0) {
         if (errorCodeOrLength < XPLR_GNSS_UBX_BUFF_SIZE) {
             cbRead = uGnssMsgReceiveCallbackRead(gnssHandle, buffer, errorCodeOrLength);
             if (cbRead == errorCodeOrLength) {
                 gnssFeedWatchdog(locDvc);
+                locDvc->stats.ubxMsgs++;
 #if (1 == XPLRGNSS_LOG_ACTIVE) && (1 == XPLR_HPGLIB_LOG_ENABLED)
-                gnssLogCallback(buffer, cbRead);
+                if ((asyncLogDvcMask & XPLR_GNSS_DVC_MASK(locDvc - dvc)) != 0) {
+                    gnssLogCallback(buffer, cbRead);
+                } else {
+                    // do nothing
+                }
 #endif
-                if (gnssUbxIsMessageId(msgIdToFilter, &msgIdHpposllh)) {
-                    ret = gnssAccuracyParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "Gnss Accuracy parser failed!");
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdNavPvt)) {
-                    ret = gnssGeolocationParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "Gnss Geolocation parser failed!");
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdEsfAlg)) {
-                    ret = gnssEsfAlgParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "Gnss ESF-ALG parser failed!");
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdEsfStatus)) {
-                    ret = gnssEsfStatusParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "Gnss ESF-STAT parser failed!");
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdEsfIns)) {
-                    ret = gnssEsfInsParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "Gnss ESF-INS parser failed!");
-                    } else {
-                        // do nothing
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdUpdSoS)) {
-                    ret = gnssUpdSoSParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "GNSS UPD-SOS parser failed!");
-                    } else {
-                        //Message is parsed. Do nothing
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdAckAck)) {
-                    ret = gnssAckAckParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "GNSS ACK-ACK parser failed!");
-                    } else {
-                        //Message is parsed. Do nothing
-                    }
-                } else if (gnssUbxIsMessageId(msgIdToFilter, &msgIdAckNak)) {
-                    ret = gnssAckNakParser(locDvc, buffer);
-                    if (ret != ESP_OK) {
-                        XPLRGNSS_CONSOLE(W, "GNSS ACK-NACK parser failed!");
-                    } else {
-                        //Message is parsed. Do nothing
-                    }
+                rawSink = locDvc->options.rawSink;
+                if (rawSink != NULL) {
+                    rawSink(U_GNSS_PROTOCOL_UBX, buffer, cbRead, locDvc->options.rawSinkArg);
                 }
+                (void)gnssUbxDispatch(locDvc, msgIdToFilter, buffer);
             } else {
+                locDvc->stats.readErrors++;
                 XPLRGNSS_CONSOLE(W,
                                  "Ubx protocol async length read missmatch: read [%d] bytes - message must be size [%d]!",
                                  cbRead,
                                  errorCodeOrLength);
             }
         } else {
+            locDvc->stats.readErrors++;
             XPLRGNSS_CONSOLE(E,
                              "Ubx protocol buffer [%d] not large enough: read size [%d]!",
                              XPLR_GNSS_UBX_BUFF_SIZE,
                              cbRead);
         }
     } else {
+        locDvc->stats.readErrors++;
         XPLRGNSS_CONSOLE(E, "Ubx protocol async read error: [%d]!", cbRead);
     }
 }
 
+/**
+ * Runs a UBX message through its parser, timing the parsers
+ */
+static esp_err_t gnssUbxDispatch(xplrGnss_t *locDvc, const uGnssMessageId_t *msgId, char *buffer)
+{
+    esp_err_t ret;
+    int64_t start = esp_timer_get_time();
+
+    if (gnssUbxIsMessageId(msgId, &msgIdHpposllh)) {
+        ret = gnssAccuracyParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "Gnss Accuracy parser failed!");
+            locDvc->stats.parseErrors++;
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdNavPvt)) {
+        ret = gnssGeolocationParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "Gnss Geolocation parser failed!");
+            locDvc->stats.parseErrors++;
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdEsfAlg)) {
+        ret = gnssEsfAlgParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "Gnss ESF-ALG parser failed!");
+            locDvc->stats.parseErrors++;
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdEsfStatus)) {
+        ret = gnssEsfStatusParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "Gnss ESF-STAT parser failed!");
+            locDvc->stats.parseErrors++;
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdEsfIns)) {
+        ret = gnssEsfInsParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "Gnss ESF-INS parser failed!");
+            locDvc->stats.parseErrors++;
+        } else {
+            // do nothing
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdUpdSoS)) {
+        ret = gnssUpdSoSParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "GNSS UPD-SOS parser failed!");
+            locDvc->stats.parseErrors++;
+        } else {
+            //Message is parsed. Do nothing
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdAckAck)) {
+        ret = gnssAckAckParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "GNSS ACK-ACK parser failed!");
+            locDvc->stats.parseErrors++;
+        } else {
+            //Message is parsed. Do nothing
+        }
+    } else if (gnssUbxIsMessageId(msgId, &msgIdAckNak)) {
+        ret = gnssAckNakParser(locDvc, buffer);
+        if (ret != ESP_OK) {
+            XPLRGNSS_CONSOLE(W, "GNSS ACK-NACK parser failed!");
+            locDvc->stats.parseErrors++;
+        } else {
+            //Message is parsed. Do nothing
+        }
+    } else {
+        ret = ESP_OK;
+    }
+
+    locDvc->stats.ubxParseUs += (uint64_t)(esp_timer_get_time() - start);
+
+    return ret;
+}
+
 /**
 * All payloads in this callback are in text form
  * **/
@@ -4795,20 +5954,31 @@ static void gnssNmeaProtocolCB(uDeviceHandle_t gnssHandle,
     int cbRead = 0;
     xplrGnss_t *locDvc = (xplrGnss_t *)callbackParam;
     char buffer[XPLR_GNSS_NMEA_BUFF_SIZE];
+    xplrGnssRawMsgSink_t rawSink;
 
     if (errorCodeOrLength > 0) {
         if (errorCodeOrLength < XPLR_GNSS_NMEA_BUFF_SIZE) {
             cbRead = uGnssMsgReceiveCallbackRead(gnssHandle, buffer, errorCodeOrLength);
             if (cbRead == errorCodeOrLength) {
                 gnssFeedWatchdog(locDvc);
+                locDvc->stats.nmeaMsgs++;
 #if (1 == XPLRGNSS_LOG_ACTIVE) && (1 == XPLR_HPGLIB_LOG_ENABLED)
-                gnssLogCallback(buffer, cbRead);
+                if ((asyncLogDvcMask & XPLR_GNSS_DVC_MASK(locDvc - dvc)) != 0) {
+                    gnssLogCallback(buffer, cbRead);
+                } else {
+                    // do nothing
+                }
 #endif
                 buffer[cbRead] = 0;
+                rawSink = locDvc->options.rawSink;
+                if (rawSink != NULL) {
+                    rawSink(U_GNSS_PROTOCOL_NMEA, buffer, cbRead, locDvc->options.rawSinkArg);
+                }
                 if (gnssNmeaIsMessageId(msgIdToFilter, &msgIdFixType)) {
                     ret = gnssGetLocFixType(locDvc, buffer);
                     if (ret != ESP_OK) {
                         XPLRGNSS_CONSOLE(W, "Gnss LOC-FIX parser failed!");
+                        locDvc->stats.parseErrors++;
                     } else {
                         // do nothing
                     }
@@ -4816,18 +5986,21 @@ static void gnssNmeaProtocolCB(uDeviceHandle_t gnssHandle,
                     // do nothing
                 }
             } else {
+                locDvc->stats.readErrors++;
                 XPLRGNSS_CONSOLE(W,
                                  "NMEA protocol async length read missmatch: read [%d] bytes - message must be size [%d]!",
                                  cbRead,
                                  errorCodeOrLength);
             }
         } else {
+            locDvc->stats.readErrors++;
             XPLRGNSS_CONSOLE(E,
                              "NMEA protocol buffer [%d] not large enough: read size [%d]!",
                              XPLR_GNSS_NMEA_BUFF_SIZE,
                              cbRead);
         }
     } else {
+        locDvc->stats.readErrors++;
         XPLRGNSS_CONSOLE(E, "NMEA protocol async read error: [%d]!", cbRead);
     }
 }
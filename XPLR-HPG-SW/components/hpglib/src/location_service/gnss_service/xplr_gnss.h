@@ -50,6 +50,13 @@ extern "C" {
  */
 #define XPLR_GNSS_FUNCTIONS_TIMEOUTS_MS XPLR_HLPRLOCSRVC_FUNCTIONS_TIMEOUTS_MS
 
+/**
+ * Device mask bit of a device profile and mask of all device profiles,
+ * used when routing correction data to several receivers
+ */
+#define XPLR_GNSS_DVC_MASK(dvcProfile)  (1UL << (dvcProfile))
+#define XPLR_GNSS_DVC_MASK_ALL          ((1UL << XPLRGNSS_NUMOF_DEVICES) - 1UL)
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTION PROTOTYPES
  * -------------------------------------------------------------- */
@@ -314,7 +321,9 @@ bool xplrGnssIsDrCalibrated(uint8_t dvcProfile);
  * stores them to the GNSS configuration struct. If populated the keys
  * can be used when the device restarts without the need to resend from
  * e.g. MQTT.
- * Keys will be refreshed every time this function gets called.
+ * Keys will be refreshed every time this function gets called. They are
+ * cached in NVS for the next start only when the module accepted them and
+ * they differ from the cached ones.
  *
  * @param dvcProfile  an integer number denoting the device profile/index.
  * @param buffer      a buffer containing data to send.
@@ -368,6 +377,79 @@ esp_err_t xplrGnssSendRtcmCorrectionData(uint8_t dvcProfile, const char *buffer,
  */
 esp_err_t xplrGnssSendRtcmFormattedCommand(uint8_t dvcProfile, const char *buffer, size_t size);
 
+/**
+ * @brief Sends one correction stream (or its decryption keys) to several
+ * GNSS devices, e.g. the receivers of a dual antenna heading rig.
+ * Devices of the mask that have not been started are skipped, a failure
+ * on one device does not stop the data from reaching the others.
+ *
+ * @param dvcMask  devices to send to, built with XPLR_GNSS_DVC_MASK or
+ *                 XPLR_GNSS_DVC_MASK_ALL.
+ * @param format   format of the data in buffer.
+ * @param buffer   a buffer containing data to send.
+ * @param size     size of the buffer.
+ * @return         ESP_OK if every started device of the mask accepted the data,
+ *                 ESP_INVALID_ARG on invalid parameters, ESP_FAIL otherwise.
+ */
+esp_err_t xplrGnssRouteCorrectionData(uint32_t dvcMask,
+                                      xplrGnssCorrFormat_t format,
+                                      const char *buffer,
+                                      size_t size);
+
+/**
+ * @brief Gets the message statistics of a GNSS device.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param stats       receives the statistics.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssGetStatistics(uint8_t dvcProfile, xplrGnssStats_t *stats);
+
+/**
+ * @brief Runs a recorded or synthesized UBX frame through the same parsers
+ * as the UBX async, e.g. to replay scenarios made with tools/xplr_esf_scenario.py.
+ * Parsed data, snapshots, events and statistics are updated as for live data.
+ * The device must be started and its asyncs stopped, see xplrGnssStopAllAsyncs().
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param buffer      complete UBX frame, sync chars to checksum.
+ * @param size        frame length in bytes.
+ * @return            ESP_OK when parsed or not of a parsed type, ESP_INVALID_ARG on
+ *                    invalid parameters or frame, ESP_ERR_INVALID_STATE if the UBX async
+ *                    is running, the parser error otherwise.
+ */
+esp_err_t xplrGnssReplayUbxMessage(uint8_t dvcProfile, const char *buffer, size_t size);
+
+/**
+ * @brief Gets the time-to-fix milestones of the current boot.
+ * First fix, RTK float and RTK fixed are timed from boot, i.e. from the
+ * power cycle, the first time each one is reached.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param ttff        receives the milestones.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssGetTtff(uint8_t dvcProfile, xplrGnssTtff_t *ttff);
+
+/**
+ * @brief Gets the time-to-fix histogram of all recorded boots, kept in NVS.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param hist        receives the histogram.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
+ *                    ESP_ERR_INVALID_STATE if the device has not started yet.
+ */
+esp_err_t xplrGnssGetTtffHistogram(uint8_t dvcProfile, xplrGnssTtffHistogram_t *hist);
+
+/**
+ * @brief Clears the time-to-fix histogram.
+ * The histogram is cleared and stored by the next xplrGnssFsm() run.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssClearTtffHistogram(uint8_t dvcProfile);
+
 /**
  * @brief Starts all available async data getters for the GNSS module.
  * Used when initializing a device.
@@ -424,6 +506,72 @@ esp_err_t xplrGnssUbxMessagesAsyncStart(uint8_t dvcProfile);
  */
 esp_err_t xplrGnssUbxMessagesAsyncStop(uint8_t dvcProfile);
 
+/**
+ * @brief Registers a sink that receives every raw message read by the
+ * NMEA/UBX asyncs (e.g. to forward them over Bluetooth).
+ * The sink runs in the ubxlib callback task, it must copy the data and return.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param sink        sink callback, NULL to remove the current one.
+ * @param arg         user argument passed to the sink.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssSetRawMsgSink(uint8_t dvcProfile, xplrGnssRawMsgSink_t sink, void *arg);
+
+/**
+ * @brief Subscribes to location and dead reckoning events, as an
+ * alternative to polling xplrGnssHasMessage/xplrGnssConsumeMessage.
+ * Events are raised from the ubxlib callback task. When cfg->cb is set
+ * it is called directly, otherwise events are put in a queue of
+ * XPLRGNSS_EVENT_QUEUE_DEPTH entries read by xplrGnssWaitEvent; when the
+ * queue is full the oldest event is dropped.
+ * ACCURACY events are raised when the horizontal accuracy moves across
+ * cfg->accuracyThreshold and once for the first location received.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param cfg         subscriber settings, copied.
+ * @param subId       id of the new subscriber.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
+ *                    ESP_ERR_NO_MEM when all XPLRGNSS_SUBSCRIBERS_MAX slots are taken,
+ *                    ESP_ERR_INVALID_STATE if the device has not been started.
+ */
+esp_err_t xplrGnssSubscribe(uint8_t dvcProfile, const xplrGnssSubscriberCfg_t *cfg, int8_t *subId);
+
+/**
+ * @brief Removes a subscriber. Allowed from within its own callback.
+ * A queue subscriber must not be removed while a task waits on it.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param subId       id returned by xplrGnssSubscribe.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssUnsubscribe(uint8_t dvcProfile, int8_t subId);
+
+/**
+ * @brief Waits for the next event of a queue subscriber.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param subId       id returned by xplrGnssSubscribe.
+ * @param event       receives the event.
+ * @param timeout     ticks to wait, 0 to poll.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters
+ *                    or callback subscribers, ESP_ERR_TIMEOUT if no event arrived.
+ */
+esp_err_t xplrGnssWaitEvent(uint8_t dvcProfile,
+                            int8_t subId,
+                            xplrGnssEvent_t *event,
+                            TickType_t timeout);
+
+/**
+ * @brief Number of events a queue subscriber lost because its queue was full.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param subId       id returned by xplrGnssSubscribe.
+ * @param dropped     receives the counter.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrGnssGetEventsDropped(uint8_t dvcProfile, int8_t subId, uint32_t *dropped);
+
 /**
  * @brief Checks if there's an available data change in order
  * to display location information.
@@ -487,11 +635,13 @@ esp_err_t xplrGnssPrintGmapsLocation(uint8_t dvcProfile);
  * This is needed because new location data is always stored internally
  * in the device profile, especially when async getters are running and data
  * gets refreshed automatically.
+ * The copy is taken lock-free and never mixes epochs: position, accuracy
+ * and time all belong to the epoch reported in locData->epoch.
  *
  * @param dvcProfile  an integer number denoting the device profile/index.
  * @param locData     a pointer to a struct tos tore location data.
  * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
- *                    ESP_FAIL on failure.
+ *                    ESP_ERR_TIMEOUT if the data kept changing while being read.
  */
 esp_err_t xplrGnssGetLocationData(uint8_t dvcProfile, xplrGnssLocation_t *locData);
 
@@ -508,11 +658,12 @@ esp_err_t xplrGnssPrintLocationData(xplrGnssLocation_t *locData);
 /**
  * @brief Used by Dead Reckoning. Returns a struct containing IMU alignment info such as:
  * calibration mode, calibration status, calibrated angles (yaw, pitch and roll).
+ * Lock-free copy of the last ESF message, see the embedded epoch.
  *
  * @param dvcProfile        an integer number denoting the device profile/index.
  * @param imuAlignmentInfo  struct containing calibration data information.
  * @return                  ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
- *                          ESP_FAIL on failure.
+ *                          ESP_ERR_TIMEOUT if the data kept changing while being read.
  */
 esp_err_t xplrGnssGetImuAlignmentInfo(uint8_t dvcProfile,
                                       xplrGnssImuAlignmentInfo_t *imuAlignmentInfo);
@@ -526,13 +677,27 @@ esp_err_t xplrGnssGetImuAlignmentInfo(uint8_t dvcProfile,
  */
 esp_err_t xplrGnssPrintImuAlignmentInfo(xplrGnssImuAlignmentInfo_t *imuAlignmentInfo);
 
+/**
+ * @brief Gets the Dead Reckoning calibration lifecycle and sensor health:
+ * alignment status transitions and errors, time converged, fusion mode
+ * dwell times, sensor faults and the quality score of the current and
+ * of the stored calibration.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param health      receives the health info.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
+ *                    ESP_ERR_TIMEOUT if it kept changing while being read.
+ */
+esp_err_t xplrGnssGetDrHealth(uint8_t dvcProfile, xplrGnssDrHealth_t *health);
+
 /**
  * @brief Used by Dead Reckoning. Gets IMU alignment status.
+ * Lock-free copy of the last ESF message, see the embedded epoch.
  *
  * @param dvcProfile       an integer number denoting the device profile/index.
  * @param imuFusionStatus  struct containing calibration status.
  * @return                 ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
- *                         ESP_FAIL on failure.
+ *                         ESP_ERR_TIMEOUT if the data kept changing while being read.
  */
 esp_err_t xplrGnssGetImuAlignmentStatus(uint8_t dvcProfile,
                                         xplrGnssImuFusionStatus_t *imuFusionStatus);
@@ -549,11 +714,12 @@ esp_err_t xplrGnssPrintImuAlignmentStatus(xplrGnssImuFusionStatus_t *imuFusionSt
 /**
  * @brief Used by Dead Reckoning. Gets IMU sensors measurements
  * (vehicle dynamics).
+ * Lock-free copy of the last ESF message, see the embedded epoch.
  *
  * @param dvcProfile          an integer number denoting the device profile/index.
  * @param imuVehicleDynamics  struct containing sensors measurements (vehicle dynamics).
  * @return                    ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
- *                            ESP_FAIL on failure.
+ *                            ESP_ERR_TIMEOUT if the data kept changing while being read.
  */
 esp_err_t xplrGnssGetImuVehicleDynamics(uint8_t dvcProfile,
                                         xplrGnssImuVehDynMeas_t *imuVehicleDynamics);
@@ -618,6 +784,16 @@ esp_err_t xplrGnssAsyncLogStop(void);
 */
 esp_err_t xplrGnssAsyncLogDeInit(void);
 
+/**
+ * @brief   Selects the GNSS devices whose messages are written to the async log.
+ * Only device 0 is logged by default, so the log of a multi receiver setup
+ * stays a single replayable stream.
+ *
+ * @param dvcMask  devices to log, built with XPLR_GNSS_DVC_MASK.
+ * @return         ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+*/
+esp_err_t xplrGnssAsyncLogSelectDevices(uint32_t dvcMask);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
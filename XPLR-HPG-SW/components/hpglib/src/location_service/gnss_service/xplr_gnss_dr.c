@@ -0,0 +1,412 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of the C standard library are allowed here,
+ * the decoders are also built on a host.
+ */
+
+#include <string.h>
+#include "xplr_gnss_dr.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_GNSS_DR_UBX_OVERHEAD   (8U)    /* sync chars, class, id, length and checksum */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static uint16_t drUint16Decode(const uint8_t *buffer);
+static uint32_t drUint32Decode(const uint8_t *buffer);
+static bool drIsConverged(xplrGnssEsfAlgStatus_t status);
+static bool drLifecycleAlg(xplrGnssDrData_t *dr, uint8_t algErrors, int64_t nowUs);
+static bool drLifecycleStatus(xplrGnssDrData_t *dr, int64_t nowUs);
+static uint8_t drCalibScore(const xplrGnssDrData_t *dr);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+bool xplrGnssDrUbxFrameValid(const uint8_t *frame, size_t size)
+{
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    size_t i;
+    bool ret = false;
+
+    if ((frame != NULL) && (size >= XPLR_GNSS_DR_UBX_OVERHEAD) &&
+        (frame[0] == 0xB5) && (frame[1] == 0x62) &&
+        (drUint16Decode(frame + 4) == (size - XPLR_GNSS_DR_UBX_OVERHEAD))) {
+        for (i = 2; i < (size - 2); i++) {
+            ckA += frame[i];
+            ckB += ckA;
+        }
+        ret = (frame[size - 2] == ckA) && (frame[size - 1] == ckB);
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+void xplrGnssDrReset(xplrGnssDrData_t *dr)
+{
+    memset(&dr->health, 0, sizeof(xplrGnssDrHealth_t));
+    dr->health.algStatus = XPLR_GNSS_ALG_STATUS_UNKNOWN;
+    dr->health.fusionMode = XPLR_GNSS_FUSION_MODE_UNKNOWN;
+    dr->convergedSince = 0;
+    dr->lastStatusTime = 0;
+}
+
+/**
+ * UBX-ESF-INS (0x10 0x15)
+ * Check F9-HPS Interface description for more info
+ */
+void xplrGnssDrEsfInsDecode(xplrGnssDrData_t *dr, const uint8_t *frame)
+{
+    dr->dynamics.valFlags.allFlags = frame[7] & 0b00111111;
+
+    dr->dynamics.xAngRate = (int32_t) drUint32Decode(frame + 18);
+    dr->dynamics.yAngRate = (int32_t) drUint32Decode(frame + 22);
+    dr->dynamics.zAngRate = (int32_t) drUint32Decode(frame + 26);
+    dr->dynamics.xAccel = (int32_t) drUint32Decode(frame + 30);
+    dr->dynamics.yAccel = (int32_t) drUint32Decode(frame + 34);
+    dr->dynamics.zAccel = (int32_t) drUint32Decode(frame + 38);
+    dr->dynamics.epoch.iTOW = drUint32Decode(frame + 14);
+}
+
+/**
+ * UBX-ESF-ALG (0x10 0x14)
+ * Check F9-HPS Interface description for more info
+ */
+bool xplrGnssDrEsfAlgDecode(xplrGnssDrData_t *dr, const uint8_t *frame, int64_t nowUs)
+{
+    uint8_t flags = frame[11];
+
+    dr->info.mode = (xplrGnssImuCalibMode_t)(flags & 1);
+    dr->info.data.yaw   = drUint32Decode(frame + 14);
+    dr->info.data.pitch = (int16_t) drUint16Decode(frame + 18);
+    dr->info.data.roll  = (int16_t) drUint16Decode(frame + 20);
+    flags >>= 1;
+    if (flags <= XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT) {
+        dr->info.status = (xplrGnssEsfAlgStatus_t)flags;
+    } else {
+        dr->info.status = XPLR_GNSS_ALG_STATUS_UNKNOWN;
+    }
+    dr->info.epoch.iTOW = drUint32Decode(frame + 6);
+
+    return drLifecycleAlg(dr, frame[12] & 0x07, nowUs);
+}
+
+/**
+ * UBX-ESF-STATUS (0x10 0x10)
+ * Check F9-HPS Interface description for more info
+ */
+bool xplrGnssDrEsfStatusDecode(xplrGnssDrData_t *dr,
+                               const uint8_t *frame,
+                               int64_t nowUs,
+                               bool *degraded)
+{
+    const uint8_t *sensor;
+    uint8_t numSens;
+    bool ret;
+
+    *degraded = false;
+    if (frame[21] > XPLR_GNSS_SENSORS_MAX_CNT) {
+        ret = false;
+    } else {
+        dr->status.fusionMode = (xplrGnssFusionMode_t)frame[18];
+        dr->status.numSens = frame[21];
+
+        for (numSens = 0; numSens < dr->status.numSens; numSens++) {
+            sensor = frame + 22 + (4 * numSens);
+            dr->status.sensor[numSens].type  = (xplrGnssSensorType_t)(sensor[0] & 0b00111111);
+            dr->status.sensor[numSens].used  = (sensor[0] >> 6) & 1;
+            dr->status.sensor[numSens].ready = (sensor[0] >> 7) & 1;
+
+            switch (sensor[1] & 0b00000011) {
+                case 0:
+                    dr->status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_NOT_CALIBRATED;
+                    break;
+                case 1:
+                    dr->status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_CALIBRATING;
+                    break;
+
+                case 2:
+                case 3:
+                    dr->status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_CALIBRATED;
+                    break;
+
+                default:
+                    dr->status.sensor[numSens].calibStatus = XPLR_GNNS_SENSOR_CALIB_UNKNOWN;
+                    break;
+            }
+
+            dr->status.sensor[numSens].freq = sensor[2];
+            dr->status.sensor[numSens].faults.allFaults = sensor[3];
+        }
+
+        dr->status.epoch.iTOW = drUint32Decode(frame + 6);
+        *degraded = drLifecycleStatus(dr, nowUs);
+        ret = true;
+    }
+
+    return ret;
+}
+
+bool xplrGnssDrAlignValsValid(const xplrGnssImuAlignmentVals_t *vals)
+{
+    bool ret;
+
+    if ((vals->yaw > XPLR_GNSS_DR_ALIGN_YAW_MAX) ||
+        (vals->pitch < XPLR_GNSS_DR_ALIGN_PITCH_MIN) ||
+        (vals->pitch > XPLR_GNSS_DR_ALIGN_PITCH_MAX) ||
+        (vals->roll < XPLR_GNSS_DR_ALIGN_ROLL_MIN) ||
+        (vals->roll > XPLR_GNSS_DR_ALIGN_ROLL_MAX)) {
+        ret = false;
+    } else {
+        ret = true;
+    }
+
+    return ret;
+}
+
+/**
+ * UBX-UPD-SOS (0x09 0x14)
+ * Check page 173 of HPS 1.30 Interface manual for more information
+ */
+bool xplrGnssDrUpdSosDecode(xplrGnssShutdownCfg_t *backup, const uint8_t *frame)
+{
+    uint8_t cmd = frame[6];
+    uint8_t response = frame[6 + 4];
+    bool ret;
+
+    switch (cmd) {
+        case 2U:
+            /*Backup creation acknowledge*/
+            if (response == 0) {
+                backup->hasBackup = 0;
+                backup->state = XPLR_GNSS_SOS_STATE_UNKNOWN;
+            } else if (response == 1) {
+                backup->hasBackup = 1;
+                backup->state = XPLR_GNSS_SOS_STATE_ACKNOWLEDGED;
+            } else {
+                backup->hasBackup = 0;
+                backup->state = XPLR_GNSS_SOS_STATE_ERROR;
+            }
+            break;
+        case 3U:
+            /*System restored from backup*/
+            if (response == 0x00) {
+                backup->isRestored = 0;
+                backup->state = XPLR_GNSS_SOS_STATE_UNKNOWN;
+            } else if (response == 0x01) {
+                backup->isRestored = 0;
+                backup->hasBackup = 1;
+                backup->state = XPLR_GNSS_SOS_STATE_FAILED_RESTORE;
+            } else if (response == 0x02) {
+                backup->isRestored = 1;
+                backup->state = XPLR_GNSS_SOS_STATE_RESTORED;
+            } else if (response == 0x03) {
+                backup->isRestored = 0;
+                backup->state = XPLR_GNSS_SOS_STATE_NO_BACKUP;
+            } else {
+                backup->isRestored = 0;
+                backup->state = XPLR_GNSS_SOS_STATE_ERROR;
+            }
+            break;
+        default:
+            backup->hasBackup = 0;
+            backup->isRestored = 0;
+            backup->state = XPLR_GNSS_SOS_STATE_ERROR;
+            break;
+    }
+
+    if (backup->state == XPLR_GNSS_SOS_STATE_ERROR) {
+        ret = false;
+    } else {
+        ret = true;
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static uint16_t drUint16Decode(const uint8_t *buffer)
+{
+    return (uint16_t)(buffer[0] | ((uint16_t)buffer[1] << 8));
+}
+
+static uint32_t drUint32Decode(const uint8_t *buffer)
+{
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) |
+           ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static bool drIsConverged(xplrGnssEsfAlgStatus_t status)
+{
+    return (status == XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT) ||
+           (status == XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT);
+}
+
+/**
+ * Tracks the alignment status, its errors and how long it has converged
+ */
+static bool drLifecycleAlg(xplrGnssDrData_t *dr, uint8_t algErrors, int64_t nowUs)
+{
+    xplrGnssDrHealth_t *health = &dr->health;
+    bool converged = drIsConverged(dr->info.status);
+    bool degraded = ((algErrors & ~health->algErrors) != 0);
+
+    if (dr->info.status != health->algStatus) {
+        health->algTransitions++;
+        if (drIsConverged(health->algStatus) && !converged) {
+            degraded = true;
+        } else {
+            // do nothing
+        }
+        health->algStatus = dr->info.status;
+    } else {
+        // do nothing
+    }
+    health->algErrors = algErrors;
+
+    if (converged && (algErrors == 0)) {
+        if (dr->convergedSince == 0) {
+            dr->convergedSince = nowUs;
+        } else {
+            // do nothing
+        }
+        health->convergedMs = (uint32_t)((nowUs - dr->convergedSince) / 1000);
+    } else {
+        dr->convergedSince = 0;
+        health->convergedMs = 0;
+    }
+
+    health->score = drCalibScore(dr);
+
+    return degraded;
+}
+
+/**
+ * Accumulates fusion mode dwell times and tracks sensor faults
+ */
+static bool drLifecycleStatus(xplrGnssDrData_t *dr, int64_t nowUs)
+{
+    xplrGnssDrHealth_t *health = &dr->health;
+    const xplrGnssImuFusionStatus_t *status = &dr->status;
+    uint8_t faults = 0;
+    uint8_t i;
+    bool degraded;
+
+    if ((dr->lastStatusTime != 0) &&
+        (health->fusionMode >= XPLR_GNSS_FUSION_MODE_INITIALIZATION) &&
+        (health->fusionMode <= XPLR_GNSS_FUSION_MODE_DISABLED)) {
+        health->fusionDwellMs[health->fusionMode] +=
+            (uint32_t)((nowUs - dr->lastStatusTime) / 1000);
+    } else {
+        // do nothing
+    }
+    dr->lastStatusTime = nowUs;
+
+    for (i = 0; i < status->numSens; i++) {
+        faults |= status->sensor[i].faults.allFaults;
+    }
+
+    degraded = ((faults & ~health->sensorFaults) != 0);
+    if (degraded) {
+        health->faultEvents++;
+    } else {
+        // do nothing
+    }
+    health->sensorFaults = faults;
+
+    if ((health->fusionMode == XPLR_GNSS_FUSION_MODE_ENABLED) &&
+        ((status->fusionMode == XPLR_GNSS_FUSION_MODE_SUSPENDED) ||
+         (status->fusionMode == XPLR_GNSS_FUSION_MODE_DISABLED))) {
+        degraded = true;
+    } else {
+        // do nothing
+    }
+    health->fusionMode = status->fusionMode;
+    health->score = drCalibScore(dr);
+
+    return degraded;
+}
+
+/**
+ * Scores the current calibration from 0 to 100:
+ * 60 for fine alignment or 40 for coarse, 20 when ESF-ALG reports no errors
+ * and up to 20 for the share of used sensors that are calibrated and fault free.
+ * Anything not converged scores 0.
+ */
+static uint8_t drCalibScore(const xplrGnssDrData_t *dr)
+{
+    const xplrGnssImuFusionStatus_t *status = &dr->status;
+    uint8_t score;
+    uint8_t used = 0;
+    uint8_t good = 0;
+    uint8_t i;
+
+    switch (dr->health.algStatus) {
+        case XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT:
+            score = 60;
+            break;
+        case XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT:
+            score = 40;
+            break;
+        default:
+            score = 0;
+            break;
+    }
+
+    if (score > 0) {
+        if (dr->health.algErrors == 0) {
+            score += 20;
+        } else {
+            // do nothing
+        }
+
+        for (i = 0; i < status->numSens; i++) {
+            if (status->sensor[i].used) {
+                used++;
+                if ((status->sensor[i].calibStatus == XPLR_GNNS_SENSOR_CALIB_CALIBRATED) &&
+                    (status->sensor[i].faults.allFaults == 0)) {
+                    good++;
+                } else {
+                    // do nothing
+                }
+            } else {
+                // do nothing
+            }
+        }
+
+        if (used > 0) {
+            score += (uint8_t)((20U * good) / used);
+        } else {
+            // do nothing
+        }
+    } else {
+        // do nothing
+    }
+
+    return score;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_GNSS_DR_H_
+#define _XPLR_GNSS_DR_H_
+
+/* Only the C standard library here: the decoders are
+ * also built on a host, see tools/xplr_gnss_dr_replay.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "xplr_gnss_dr_types.h"
+
+/** @file
+ * @brief Decoding of the UBX-ESF messages and Dead Reckoning calibration
+ * lifecycle, and of the UBX-UPD-SOS Save on Shutdown status, used by the
+ * parsers of the gnss service. The functions take
+ * whole UBX frames, sync chars included, and the time in microseconds, so
+ * they run the same on a receiver stream, a replayed file or a host.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_GNSS_DR_UBX_CLASS_ESF      (0x10U)
+#define XPLR_GNSS_DR_UBX_ID_ESF_STATUS  (0x10U)
+#define XPLR_GNSS_DR_UBX_ID_ESF_ALG     (0x14U)
+#define XPLR_GNSS_DR_UBX_ID_ESF_INS     (0x15U)
+#define XPLR_GNSS_DR_UBX_CLASS_UPD      (0x09U)
+#define XPLR_GNSS_DR_UBX_ID_UPD_SOS     (0x14U)
+
+/**
+ * Valid IMU alignment angles, in 1e-2 degrees
+ */
+#define XPLR_GNSS_DR_ALIGN_YAW_MAX      (36000)     /* 360.00 */
+#define XPLR_GNSS_DR_ALIGN_PITCH_MIN    (-9000)     /* -90.00 */
+#define XPLR_GNSS_DR_ALIGN_PITCH_MAX    (9000)      /*  90.00 */
+#define XPLR_GNSS_DR_ALIGN_ROLL_MIN     (-18000)    /* -180.00 */
+#define XPLR_GNSS_DR_ALIGN_ROLL_MAX     (18000)     /*  180.00 */
+
+/* ----------------------------------------------------------------
+ * PUBLIC TYPES
+ * -------------------------------------------------------------- */
+
+/**
+ * Dead Reckoning data of a device
+ */
+typedef struct xplrGnssDrData_type {
+    xplrGnssImuAlignmentInfo_t info;    /**< IMU Alignment Information */
+    xplrGnssImuFusionStatus_t status;   /**< IMU Fusion status */
+    xplrGnssImuVehDynMeas_t dynamics;   /**< IMU Vehicle dynamics */
+    xplrGnssDrHealth_t health;          /**< calibration lifecycle, written by the ubxlib callback task */
+    int64_t convergedSince;             /**< time the alignment converged in us, 0 if not converged */
+    int64_t lastStatusTime;             /**< time of the last ESF-STATUS in us, 0 if none */
+    uint8_t candidateScore;             /**< score of the calibration flagged for NVS */
+    volatile uint8_t storedScore;       /**< score of the calibration stored in NVS */
+} xplrGnssDrData_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Checks sync chars, length and checksum of a UBX frame.
+ *
+ * @param frame  UBX frame.
+ * @param size   size of the frame, sync chars and checksum included.
+ * @return       true if the frame is valid.
+ */
+bool xplrGnssDrUbxFrameValid(const uint8_t *frame, size_t size);
+
+/**
+ * @brief Resets the calibration lifecycle, e.g. when the receiver restarts.
+ *
+ * @param dr     Dead Reckoning data.
+ */
+void xplrGnssDrReset(xplrGnssDrData_t *dr);
+
+/**
+ * @brief Decodes a UBX-ESF-INS frame into the vehicle dynamics.
+ *
+ * @param dr     Dead Reckoning data.
+ * @param frame  UBX-ESF-INS frame.
+ */
+void xplrGnssDrEsfInsDecode(xplrGnssDrData_t *dr, const uint8_t *frame);
+
+/**
+ * @brief Decodes a UBX-ESF-ALG frame into the alignment information and
+ * updates the calibration health: alignment transitions, errors, time
+ * converged and score.
+ *
+ * @param dr     Dead Reckoning data.
+ * @param frame  UBX-ESF-ALG frame.
+ * @param nowUs  current time in microseconds.
+ * @return       true if the calibration degraded: alignment lost or new
+ *               alignment error.
+ */
+bool xplrGnssDrEsfAlgDecode(xplrGnssDrData_t *dr, const uint8_t *frame, int64_t nowUs);
+
+/**
+ * @brief Decodes a UBX-ESF-STATUS frame into the fusion status and
+ * updates the calibration health: time in each fusion mode, sensor
+ * faults and score.
+ *
+ * @param dr        Dead Reckoning data.
+ * @param frame     UBX-ESF-STATUS frame.
+ * @param nowUs     current time in microseconds.
+ * @param degraded  set if the calibration degraded: fusion suspended or
+ *                  disabled, or new sensor fault.
+ * @return          false if the frame reports more than XPLR_GNSS_SENSORS_MAX_CNT
+ *                  sensors, nothing is decoded then.
+ */
+bool xplrGnssDrEsfStatusDecode(xplrGnssDrData_t *dr,
+                               const uint8_t *frame,
+                               int64_t nowUs,
+                               bool *degraded);
+
+/**
+ * @brief Checks that yaw, pitch and roll are within the limits of the
+ * IMU mount alignment configuration, XPLR_GNSS_DR_ALIGN_*.
+ *
+ * @param vals   alignment angles.
+ * @return       true if all three angles are within limits.
+ */
+bool xplrGnssDrAlignValsValid(const xplrGnssImuAlignmentVals_t *vals);
+
+/**
+ * @brief Decodes a UBX-UPD-SOS frame: backup creation acknowledge or
+ * restore status reported at start.
+ *
+ * @param backup  Save on Shutdown status to update.
+ * @param frame   UBX-UPD-SOS frame.
+ * @return        false if the frame reports an unknown command or
+ *                response, the state is XPLR_GNSS_SOS_STATE_ERROR then.
+ */
+bool xplrGnssDrUpdSosDecode(xplrGnssShutdownCfg_t *backup, const uint8_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_GNSS_DR_H_ */
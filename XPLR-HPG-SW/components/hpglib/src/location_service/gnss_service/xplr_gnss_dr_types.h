@@ -0,0 +1,233 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_GNSS_DR_TYPES_H_
+#define _XPLR_GNSS_DR_TYPES_H_
+
+/* Only the C standard library here: the Dead Reckoning and Save on
+ * Shutdown types are also built on a host, see tools/xplr_gnss_dr_replay.c */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @file
+ * @brief This header file defines the Dead Reckoning types of the gnss service API:
+ * IMU alignment, fusion status, vehicle dynamics and calibration health,
+ * and the Save on Shutdown status reported by UBX-UPD-SOS.
+ */
+
+/**
+ * Maximum available slots for sensors
+ */
+#define XPLR_GNSS_SENSORS_MAX_CNT   15
+
+/*INDENT-OFF*/
+
+/**
+ * IMU/DR Calibration mode
+ */
+typedef enum {
+    XPLR_GNSS_IMU_CALIBRATION_MANUAL = 0,   /**< Auto calibrate Yaw - Pitch - Roll. */
+    XPLR_GNSS_IMU_CALIBRATION_AUTO          /**< Used manually provided Yaw - Pitch - Roll. */
+} xplrGnssImuCalibMode_t;
+
+/**
+ * IMU/DR calibration status
+ */
+typedef enum {
+    XPLR_GNSS_ALG_STATUS_UNKNOWN = -1,              /**< Unknown state. */
+    XPLR_GNSS_ALG_STATUS_USER_DEFINED = 0,          /**< User defined calibration data (Manual calib). */
+    XPLR_GNSS_ALG_STATUS_ROLLPITCH_CALIBRATING,     /**< Roll - Pitch calibrating. */
+    XPLR_GNSS_ALG_STATUS_ROLLPITCHYAW_CALIBRATING,  /**< Roll - Pitch - Yaw calibrating. */
+    XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT,    /**< Using coarse alignment (no wheel tick available). */
+    XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT       /**< Using fine alignment (wheel tick in use). */
+} xplrGnssEsfAlgStatus_t;
+
+/**
+ * IMU/DR Fusion mode/status
+ */
+typedef enum {
+    XPLR_GNSS_FUSION_MODE_UNKNOWN = -1,         /**< Unknown state. */
+    XPLR_GNSS_FUSION_MODE_INITIALIZATION = 0,   /**< Fusion mode initializing/calibrating. */
+    XPLR_GNSS_FUSION_MODE_ENABLED,              /**< Fusion mode is enabled and used. */
+    XPLR_GNSS_FUSION_MODE_SUSPENDED,            /**< Fusion mode is suspended. */
+    XPLR_GNSS_FUSION_MODE_DISABLED              /**< Fusion mode is disabled. */
+} xplrGnssFusionMode_t;
+
+/**
+ * Sensor type
+ */
+typedef enum {
+    XPLR_GNSS_SENSOR_GYRO_Z_ANG_RATE = 5,       /**< Gyro Z axis angular rate. */
+    XPLR_GNSS_SENSOR_WT_RL_WHEEL = 8,           /**< Wheel Tick - Real Left. */
+    XPLR_GNSS_SENSOR_WT_RR_WHEEL,               /**< Wheel Tick - Rear Right. */
+    XPLR_GNSS_SENSOR_WT_ST_WHEEL,               /**< Wheel Tick - SIngle Tick. */
+    XPLR_GNSS_SENSOR_SPEED,                     /**< Sensor speed */
+    XPLR_GNSS_SENSOR_GYRO_TEMP,                 /**< Gyro temperature sensor. */
+    XPLR_GNSS_SENSOR_GYRO_Y_ANG_RATE,           /**< Gyro Y axis angular rate. */
+    XPLR_GNSS_SENSOR_GYRO_X_ANG_RATE,           /**< Gyro X axis angular rate. */
+    XPLR_GNSS_SENSOR_ACCEL_X_SPCF_FORCE = 16,   /**< Accelerometer X axis specific force. */
+    XPLR_GNSS_SENSOR_ACCEL_Y_SPCF_FORCE,        /**< Accelerometer Y axis specific force. */
+    XPLR_GNSS_SENSOR_ACCEL_Z_SPCF_FORCE         /**< Accelerometer Z axis specific force. */
+} xplrGnssSensorType_t;
+
+/**
+ * Sensor calibration status
+ */
+typedef enum {
+    XPLR_GNNS_SENSOR_CALIB_UNKNOWN = -1,        /**< Sensors calibration status unknown. */
+    XPLR_GNNS_SENSOR_CALIB_NOT_CALIBRATED = 0,  /**< Sensor is not calibrated.. */
+    XPLR_GNNS_SENSOR_CALIB_CALIBRATING,         /**< Sensors is calibrating.. */
+    XPLR_GNNS_SENSOR_CALIB_CALIBRATED           /**< Sensors is calibrated.. */
+} xplrGnssSensorCalibStatus_t;
+
+/**
+ * Publication info attached to every GNSS data product.
+ * Lets readers tell epochs apart and detect new data.
+ */
+typedef struct xplrGnssEpoch_type {
+    uint32_t seq;       /**< publication counter of the product, 0 if never published */
+    uint32_t iTOW;      /**< GPS time of week of the navigation epoch in ms */
+    int64_t  timestamp; /**< esp_timer time of publication in us */
+} xplrGnssEpoch_t;
+
+/**
+ * Alignment angle values
+ */
+typedef struct xplrGnssImuAlignmentVals_type {
+    uint32_t yaw;       /**< Yaw alignment value. */
+    int16_t  pitch;     /**< Pitch alignment value. */  
+    int16_t  roll;      /**< Roll alignment value. */
+} xplrGnssImuAlignmentVals_t;
+
+/**
+ * IMU/DR Alignment information as read from the module
+ */
+typedef struct xplrGnssImuAlignmentInfo_type {
+    xplrGnssImuCalibMode_t mode;        /**< Calibration mode. */
+    xplrGnssEsfAlgStatus_t status;      /**< Calibration status. */
+    xplrGnssImuAlignmentVals_t data;    /**< Alignment angle values. */
+    xplrGnssEpoch_t epoch;              /**< Epoch of the ESF-ALG message. */
+} xplrGnssImuAlignmentInfo_t;
+
+/**
+ * IMU Sensor faults
+ */
+typedef union __attribute__ ((__packed__)) xplrGnssImuEsfStatSensorFaults_type{
+    struct {
+        uint8_t badMeasurements    : 1; /**< Bad measurements detected. */
+        uint8_t badTTag            : 1; /**< Bad measurement time-tags detected. */
+        uint8_t missingMeasurments : 1; /**< Missing or time-misaligned measurements detected. */
+        uint8_t noisyMeas          : 1; /**< High measurement noise-level detected. */
+    } singleFaults;                     /**< Faults as single bit-fields. */    
+    uint8_t allFaults;                  /**< Faults as a single uint8_t. */
+} xplrGnssImuEsfStatSensorFaults_t;
+
+/**
+ * Sensor information struct
+ */
+typedef struct xplrGnssImuSensorStatus_type {
+    xplrGnssSensorType_t type;                  /**< Sensor type. */
+    bool used;                                  /**< Is sensors used in fusion. */
+    bool ready;                                 /**< Is sensor ready to be used. */
+    xplrGnssSensorCalibStatus_t calibStatus;    /**< Is sensor calibrated. */
+    uint8_t freq;                               /**< Sensors refresh frequency */
+    xplrGnssImuEsfStatSensorFaults_t faults;    /**< Sensor faults. */
+} xplrGnssImuSensorStatus_t;
+
+/**
+ * Contains information regarding fusion status
+ */
+typedef struct xplrGnssImuFusionStatus_type {
+    xplrGnssFusionMode_t fusionMode;                                /**< Current fusion mode achieved */
+    uint8_t numSens;                                                /**< Total number of sensors used by GNSS module */
+    xplrGnssImuSensorStatus_t sensor[XPLR_GNSS_SENSORS_MAX_CNT];    /**< Sensors statuses  */
+    xplrGnssEpoch_t epoch;                                          /**< Epoch of the ESF-STATUS message */
+} xplrGnssImuFusionStatus_t;
+
+/**
+ * Calibration lifecycle and sensor health of Dead Reckoning
+ */
+typedef struct xplrGnssDrHealth_type {
+    xplrGnssEsfAlgStatus_t algStatus;   /**< Current IMU alignment status */
+    uint32_t algTransitions;            /**< Alignment status changes since start */
+    uint8_t algErrors;                  /**< ESF-ALG error flags: tilt (bit 0), yaw (bit 1), angle (bit 2) */
+    uint32_t convergedMs;               /**< Time the alignment has been converged without errors */
+    xplrGnssFusionMode_t fusionMode;    /**< Current fusion mode */
+    uint32_t fusionDwellMs[XPLR_GNSS_FUSION_MODE_DISABLED + 1]; /**< Time spent in each fusion mode */
+    uint8_t sensorFaults;               /**< Fault bits (xplrGnssImuEsfStatSensorFaults_t) of all sensors OR-ed */
+    uint32_t faultEvents;               /**< Times a new sensor fault bit appeared */
+    uint8_t score;                      /**< Quality of the current calibration, 0-100 */
+    uint8_t storedScore;                /**< Quality of the calibration stored in NVS, 0 if none */
+    xplrGnssEpoch_t epoch;              /**< Publication info */
+} xplrGnssDrHealth_t;
+
+/**
+ * Validity flags for sensors measurements
+ */
+typedef union __attribute__ ((__packed__)) xplrGnssImuVehicleDynamicsFlags_type {
+    struct {
+        uint8_t xAngRateValid : 1;  /**< Compensated x-axis angular rate data validity flag */
+        uint8_t yAngRateValid : 1;  /**< Compensated y-axis angular rate data validity flag */
+        uint8_t zAngRateValid : 1;  /**< Compensated z-axis angular rate data validity flag */
+        uint8_t xAccelValid   : 1;  /**< Compensated x-axis acceleration data validity flag */
+        uint8_t yAccelValid   : 1;  /**< Compensated y-axis acceleration data validity flag */
+        uint8_t zAccelValid   : 1;  /**< Compensated z-axis acceleration data validity flag */
+    } singleFlags;                  /**< flags as single bit-fields. */
+    uint8_t allFlags;               /**< flags as a single uint8_t. */
+} xplrGnssImuVehicleDynamicsFlags_t;
+
+/**
+ * Vehicle dynamics measurement data
+ */
+typedef struct xplrGnssImuVehDynMeas_type {
+    xplrGnssImuVehicleDynamicsFlags_t valFlags; /**< Validity Flags */
+    int32_t xAngRate;   /**< Compensated x-axis angular rate */
+    int32_t yAngRate;   /**< Compensated y-axis angular rate */
+    int32_t zAngRate;   /**< Compensated x-axis angular rate */
+    int32_t xAccel;     /**< Compensated x-axis acceleration (gravity-free) */
+    int32_t yAccel;     /**< Compensated y-axis acceleration (gravity-free) */
+    int32_t zAccel;     /**< Compensated z-axis acceleration (gravity-free) */
+    xplrGnssEpoch_t epoch;  /**< Epoch of the ESF-INS message */
+} xplrGnssImuVehDynMeas_t;
+
+/**
+ * Enumeration that contains the different Save on Shutdown
+ * configuration states
+ */
+typedef enum {
+    XPLR_GNSS_SOS_STATE_ERROR = -1,     /**< Invalid or error state. */
+    XPLR_GNSS_SOS_STATE_INITIAL = 0,    /**< Initial state*/
+    XPLR_GNSS_SOS_STATE_UNKNOWN,        /**< Unknown or Not Acknowledged state. */
+    XPLR_GNSS_SOS_STATE_ACKNOWLEDGED,   /**< Acknowledged state. */
+    XPLR_GNSS_SOS_STATE_FAILED_RESTORE, /**< Failed to restore backup configuration */
+    XPLR_GNSS_SOS_STATE_RESTORED,       /**< Successfully restored backup configuration from memory */
+    XPLR_GNSS_SOS_STATE_NO_BACKUP       /**< No backup found in memory */
+} xplrGnssSoSConfigStates_t;
+
+/**
+ * Struct that contains the Save on Shutdown configuration flags
+*/
+typedef struct xplrGnssShutdownCfg_type {
+    xplrGnssSoSConfigStates_t state;    /**< State of Save on Shutdown */
+    bool isRestored;                    /**< Flag indicating module has successfully restored configuration from backup */
+    bool hasBackup;                     /**< Flag indicating module has saved backup configuration in flash */
+    int cmdAck;                         /**< Flag indicating module has acknowledged clear backup configuration command */
+} xplrGnssShutdownCfg_t;
+
+/*INDENT-ON*/
+
+#endif
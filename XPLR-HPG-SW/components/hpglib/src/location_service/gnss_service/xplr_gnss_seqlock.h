@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_GNSS_SEQLOCK_H_
+#define _XPLR_GNSS_SEQLOCK_H_
+
+/* Only standard headers here: the sequence lock is also built on a host,
+ * see tools/xplr_gnss_seqlock_stress.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file
+ * @brief Sequence lock of the GNSS data product snapshots.
+ * A single writer publishes a copy while readers copy it lock-free: the
+ * sequence counter is odd while a publication is in progress, and a read
+ * is valid only if the counter was even and unchanged around the copy.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Publish a snapshot. Only one writer per sequence counter.
+ *
+ * @param seq   sequence counter of the snapshot.
+ * @param dst   published copy.
+ * @param src   data to publish.
+ * @param size  size of the data.
+ */
+static inline void xplrGnssSeqlockPublish(uint32_t *seq, void *dst, const void *src, size_t size)
+{
+    uint32_t next = *seq + 1;
+
+    __atomic_store_n(seq, next, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_store_n(seq, next + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Try once to copy a snapshot.
+ *
+ * @param seq   sequence counter of the snapshot.
+ * @param dst   buffer for the copy.
+ * @param src   published copy.
+ * @param size  size of the data.
+ * @return      true if dst holds a whole publication, false if a
+ *              publication overlapped and the copy must be retried.
+ */
+static inline bool xplrGnssSeqlockTryRead(const uint32_t *seq, void *dst, const void *src, size_t size)
+{
+    uint32_t begin;
+    uint32_t end;
+    bool ret = false;
+
+    begin = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if ((begin & 1U) == 0) {
+        memcpy(dst, src, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(seq, __ATOMIC_RELAXED);
+        ret = (begin == end);
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_GNSS_SEQLOCK_H_ */
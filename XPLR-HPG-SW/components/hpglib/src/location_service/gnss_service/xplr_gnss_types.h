@@ -26,17 +26,13 @@
 #include "./../../../../components/ubxlib/ubxlib.h"
 #include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
+#include "xplr_gnss_dr_types.h"
 
 /** @file
  * @brief This header file defines the types used in gnss service API, such as
  * location data, dead reckoning data, and gnss device settings.
  */
 
-/**
- * Maximum available slots for sensors
- */
-#define XPLR_GNSS_SENSORS_MAX_CNT   15
-
 /**
  * Length of decryption keys.
  * This is standard at 60 bytes.
@@ -45,6 +41,11 @@
  */
 #define XPLR_GNSS_DECRYPTION_KEYS_LEN 128
 
+/**
+ * Number of time bins of the time-to-fix histogram
+ */
+#define XPLR_GNSS_TTFF_HIST_BINS    8
+
 /*INDENT-OFF*/
 
 /**
@@ -82,6 +83,8 @@ typedef enum {
     XPLR_GNSS_STATE_NVS_UPDATE,             /**< update/save data to NVS. */
     XPLR_GNSS_STATE_SAVE_ON_SHUTDOWN,       /**< perform save on shutdown routine. */
     XPLR_GNSS_STATE_CLEAR_BACKUP_MEMORY,    /**< clears previously save backup configuration from memory. */
+    XPLR_GNSS_STATE_WARM_START,             /**< injects stored position, time and keys after boot. */
+    XPLR_GNSS_STATE_WARM_START_SAVE,        /**< stores position, keys and time-to-fix histogram to NVS. */
 } xplrGnssStates_t;
 
 /**
@@ -108,12 +111,13 @@ typedef enum {
 } xplrGnssCorrDataSrc_t;
 
 /**
- * IMU/DR Calibration mode
+ * Format of correction data routed to one or more GNSS devices
  */
 typedef enum {
-    XPLR_GNSS_IMU_CALIBRATION_MANUAL = 0,   /**< Auto calibrate Yaw - Pitch - Roll. */
-    XPLR_GNSS_IMU_CALIBRATION_AUTO          /**< Used manually provided Yaw - Pitch - Roll. */
-} xplrGnssImuCalibMode_t;
+    XPLR_GNSS_CORR_FORMAT_SPARTN = 0,   /**< SPARTN messages in ubx format. */
+    XPLR_GNSS_CORR_FORMAT_RTCM,         /**< RTCM messages. */
+    XPLR_GNSS_CORR_FORMAT_KEYS          /**< PointPerfect decryption keys. */
+} xplrGnssCorrFormat_t;
 
 /**
  * Vehicle dynamics mode
@@ -132,56 +136,6 @@ typedef enum {
     XPLR_GNSS_DYNMODE_ESCOOTER          /**< E-Scooter. */
 } xplrGnssDynMode_t;
 
-/**
- * IMU/DR calibration status
- */
-typedef enum {
-    XPLR_GNSS_ALG_STATUS_UNKNOWN = -1,              /**< Unknown state. */
-    XPLR_GNSS_ALG_STATUS_USER_DEFINED = 0,          /**< User defined calibration data (Manual calib). */
-    XPLR_GNSS_ALG_STATUS_ROLLPITCH_CALIBRATING,     /**< Roll - Pitch calibrating. */
-    XPLR_GNSS_ALG_STATUS_ROLLPITCHYAW_CALIBRATING,  /**< Roll - Pitch - Yaw calibrating. */
-    XPLR_GNSS_ALG_STATUS_USING_COARSE_ALIGNMENT,    /**< Using coarse alignment (no wheel tick available). */
-    XPLR_GNSS_ALG_STATUS_USING_FINE_ALIGNMENT       /**< Using fine alignment (wheel tick in use). */
-} xplrGnssEsfAlgStatus_t;
-
-/**
- * IMU/DR Fusion mode/status
- */
-typedef enum {
-    XPLR_GNSS_FUSION_MODE_UNKNOWN = -1,         /**< Unknown state. */
-    XPLR_GNSS_FUSION_MODE_INITIALIZATION = 0,   /**< Fusion mode initializing/calibrating. */
-    XPLR_GNSS_FUSION_MODE_ENABLED,              /**< Fusion mode is enabled and used. */
-    XPLR_GNSS_FUSION_MODE_SUSPENDED,            /**< Fusion mode is suspended. */
-    XPLR_GNSS_FUSION_MODE_DISABLED              /**< Fusion mode is disabled. */
-} xplrGnssFusionMode_t;
-
-/**
- * Sensor type
- */
-typedef enum {
-    XPLR_GNSS_SENSOR_GYRO_Z_ANG_RATE = 5,       /**< Gyro Z axis angular rate. */
-    XPLR_GNSS_SENSOR_WT_RL_WHEEL = 8,           /**< Wheel Tick - Real Left. */
-    XPLR_GNSS_SENSOR_WT_RR_WHEEL,               /**< Wheel Tick - Rear Right. */
-    XPLR_GNSS_SENSOR_WT_ST_WHEEL,               /**< Wheel Tick - SIngle Tick. */
-    XPLR_GNSS_SENSOR_SPEED,                     /**< Sensor speed */
-    XPLR_GNSS_SENSOR_GYRO_TEMP,                 /**< Gyro temperature sensor. */
-    XPLR_GNSS_SENSOR_GYRO_Y_ANG_RATE,           /**< Gyro Y axis angular rate. */
-    XPLR_GNSS_SENSOR_GYRO_X_ANG_RATE,           /**< Gyro X axis angular rate. */
-    XPLR_GNSS_SENSOR_ACCEL_X_SPCF_FORCE = 16,   /**< Accelerometer X axis specific force. */
-    XPLR_GNSS_SENSOR_ACCEL_Y_SPCF_FORCE,        /**< Accelerometer Y axis specific force. */
-    XPLR_GNSS_SENSOR_ACCEL_Z_SPCF_FORCE         /**< Accelerometer Z axis specific force. */
-} xplrGnssSensorType_t;
-
-/**
- * Sensor calibration status
- */
-typedef enum {
-    XPLR_GNNS_SENSOR_CALIB_UNKNOWN = -1,        /**< Sensors calibration status unknown. */
-    XPLR_GNNS_SENSOR_CALIB_NOT_CALIBRATED = 0,  /**< Sensor is not calibrated.. */
-    XPLR_GNNS_SENSOR_CALIB_CALIBRATING,         /**< Sensors is calibrating.. */
-    XPLR_GNNS_SENSOR_CALIB_CALIBRATED           /**< Sensors is calibrated.. */
-} xplrGnssSensorCalibStatus_t;
-
 /**
  * Struct that contains accuracy metrics
  */
@@ -197,147 +151,141 @@ typedef struct xplrGnssLocation_type {
     xplrGnssAccuracy_t   accuracy;      /**< accuracy metrics */
     uLocation_t          location;      /**< ubxlib location struct */
     xplrGnssLocFixType_t locFixType;    /**< location fix type */
+    xplrGnssEpoch_t      epoch;         /**< epoch all of the above belong to */
 } xplrGnssLocation_t;
 
 /**
- * Alignment angle values
+ * GNSS Dead Reckoning settings
  */
-typedef struct xplrGnssImuAlignmentVals_type {
-    uint32_t yaw;       /**< Yaw alignment value. */
-    int16_t  pitch;     /**< Pitch alignment value. */  
-    int16_t  roll;      /**< Roll alignment value. */
-} xplrGnssImuAlignmentVals_t;
+typedef struct xplrGnssDeadReckoningCfg_type {
+    bool enable;
+    xplrGnssDynMode_t vehicleDynMode;       /**< Vehicle dynamics mode. */
+    xplrGnssImuCalibMode_t mode;            /**< Calibration mode. */   
+    xplrGnssImuAlignmentVals_t alignVals;   /**< ALignment values if Manual calibration is used. */
+} xplrGnssDeadReckoningCfg_t;
 
 /**
- * IMU/DR Alignment information as read from the module
+ * Correction data decryption keys settings
  */
-typedef struct xplrGnssImuAlignmentInfo_type {
-    xplrGnssImuCalibMode_t mode;        /**< Calibration mode. */
-    xplrGnssEsfAlgStatus_t status;      /**< Calibration status. */
-    xplrGnssImuAlignmentVals_t data;    /**< Alignment angle values. */
-} xplrGnssImuAlignmentInfo_t;
+typedef struct xplrGnssDecryptionKeys_type {
+    char keys[XPLR_GNSS_DECRYPTION_KEYS_LEN];   /**< Key in ubx ready format. */
+    uint16_t size;                              /**< key length. */
+} xplrGnssDecryptionKeys_t;
 
 /**
- * IMU Sensor faults
+ * Correction data settings
  */
-typedef union __attribute__ ((__packed__)) xplrGnssImuEsfStatSensorFaults_type{
-    struct {
-        uint8_t badMeasurements    : 1; /**< Bad measurements detected. */
-        uint8_t badTTag            : 1; /**< Bad measurement time-tags detected. */
-        uint8_t missingMeasurments : 1; /**< Missing or time-misaligned measurements detected. */
-        uint8_t noisyMeas          : 1; /**< High measurement noise-level detected. */
-    } singleFaults;                     /**< Faults as single bit-fields. */    
-    uint8_t allFaults;                  /**< Faults as a single uint8_t. */
-} xplrGnssImuEsfStatSensorFaults_t;
+typedef struct xplrGnssCorrectionCfg_type {
+    xplrGnssDecryptionKeys_t keys;  /**< Correction data decryption keys settings. */
+    xplrGnssCorrDataSrc_t source;   /**< Correction data source. */
+} xplrGnssCorrectionCfg_t;
 
 /**
- * Sensor information struct
+ * Struct that contains location metrics
  */
-typedef struct xplrGnssImuSensorStatus_type {
-    xplrGnssSensorType_t type;                  /**< Sensor type. */
-    bool used;                                  /**< Is sensors used in fusion. */
-    bool ready;                                 /**< Is sensor ready to be used. */
-    xplrGnssSensorCalibStatus_t calibStatus;    /**< Is sensor calibrated. */
-    uint8_t freq;                               /**< Sensors refresh frequency */
-    xplrGnssImuEsfStatSensorFaults_t faults;    /**< Sensor faults. */
-} xplrGnssImuSensorStatus_t;
+typedef struct xplrGnssDeviceCfg_type {
+    xplrLocationDevConf_t hw;           /**< Hardware specific settings. */
+    xplrGnssDeadReckoningCfg_t dr;      /**< Dead Reckoning settings. */
+    xplrGnssCorrectionCfg_t corrData;   /**< Correction data settings. */
+    xplrGnssShutdownCfg_t backup;       /**< Configuration for Save On Shutdown */
+} xplrGnssDeviceCfg_t;
 
 /**
- * Contains information regarding fusion status
+ * Per device message statistics
  */
-typedef struct xplrGnssImuFusionStatus_type {
-    xplrGnssFusionMode_t fusionMode;                                /**< Current fusion mode achieved */
-    uint8_t numSens;                                                /**< Total number of sensors used by GNSS module */
-    xplrGnssImuSensorStatus_t sensor[XPLR_GNSS_SENSORS_MAX_CNT];    /**< Sensors statuses  */
-} xplrGnssImuFusionStatus_t;
+typedef struct xplrGnssStats_type {
+    uint32_t ubxMsgs;       /**< UBX messages read by the async */
+    uint32_t nmeaMsgs;      /**< NMEA messages read by the async */
+    uint32_t readErrors;    /**< async reads that failed or did not fit the buffers */
+    uint32_t parseErrors;   /**< messages rejected by the parsers */
+    uint32_t corrMsgs;      /**< correction data/keys messages sent to the device */
+    uint32_t corrErrors;    /**< correction data/keys messages that failed to send */
+    uint64_t ubxParseUs;    /**< time spent in the UBX parsers in us, ubxMsgs over it gives the parser throughput */
+} xplrGnssStats_t;
 
 /**
- * Validity flags for sensors measurements
+ * Startup milestones timed on every boot
  */
-typedef union __attribute__ ((__packed__)) xplrGnssImuVehicleDynamicsFlags_type {
-    struct {
-        uint8_t xAngRateValid : 1;  /**< Compensated x-axis angular rate data validity flag */
-        uint8_t yAngRateValid : 1;  /**< Compensated y-axis angular rate data validity flag */
-        uint8_t zAngRateValid : 1;  /**< Compensated z-axis angular rate data validity flag */
-        uint8_t xAccelValid   : 1;  /**< Compensated x-axis acceleration data validity flag */
-        uint8_t yAccelValid   : 1;  /**< Compensated y-axis acceleration data validity flag */
-        uint8_t zAccelValid   : 1;  /**< Compensated z-axis acceleration data validity flag */
-    } singleFlags;                  /**< flags as single bit-fields. */
-    uint8_t allFlags;               /**< flags as a single uint8_t. */
-} xplrGnssImuVehicleDynamicsFlags_t;
+typedef enum {
+    XPLR_GNSS_TTFF_FIRST_FIX = 0,       /**< first 2D/3D fix (TTFF) */
+    XPLR_GNSS_TTFF_RTK_FLOAT,           /**< first RTK float (or fixed) solution */
+    XPLR_GNSS_TTFF_RTK_FIXED,           /**< first RTK fixed solution */
+    XPLR_GNSS_TTFF_NUMOF_MILESTONES
+} xplrGnssTtffMilestone_t;
 
 /**
- * Vehicle dynamics measurement data
+ * Time-to-fix of the current boot
  */
-typedef struct xplrGnssImuVehDynMeas_type {
-    xplrGnssImuVehicleDynamicsFlags_t valFlags; /**< Validity Flags */
-    int32_t xAngRate;   /**< Compensated x-axis angular rate */
-    int32_t yAngRate;   /**< Compensated y-axis angular rate */
-    int32_t zAngRate;   /**< Compensated x-axis angular rate */
-    int32_t xAccel;     /**< Compensated x-axis acceleration (gravity-free) */
-    int32_t yAccel;     /**< Compensated y-axis acceleration (gravity-free) */
-    int32_t zAccel;     /**< Compensated z-axis acceleration (gravity-free) */
-} xplrGnssImuVehDynMeas_t;
+typedef struct xplrGnssTtff_type {
+    uint32_t ms[XPLR_GNSS_TTFF_NUMOF_MILESTONES];   /**< time since boot each milestone was
+                                                         reached at in ms, 0 if not reached */
+    bool aided;                                     /**< stored position was injected at start */
+} xplrGnssTtff_t;
 
 /**
- * GNSS Dead Reckoning settings
+ * Time-to-fix histogram kept in NVS across boots.
+ * Bins are <5s, <10s, <20s, <30s, <60s, <120s, <300s and >=300s.
+ * Boots that never reached a milestone are boots minus the sum of its bins.
  */
-typedef struct xplrGnssDeadReckoningCfg_type {
-    bool enable;
-    xplrGnssDynMode_t vehicleDynMode;       /**< Vehicle dynamics mode. */
-    xplrGnssImuCalibMode_t mode;            /**< Calibration mode. */   
-    xplrGnssImuAlignmentVals_t alignVals;   /**< ALignment values if Manual calibration is used. */
-} xplrGnssDeadReckoningCfg_t;
+typedef struct xplrGnssTtffHistogram_type {
+    uint32_t boots;                                 /**< boots recorded */
+    uint16_t count[XPLR_GNSS_TTFF_NUMOF_MILESTONES][XPLR_GNSS_TTFF_HIST_BINS];  /**< boots per bin */
+} xplrGnssTtffHistogram_t;
 
 /**
- * Correction data decryption keys settings
+ * Callback receiving every raw message read by the NMEA/UBX asyncs.
+ * Invoked from the ubxlib callback task: it must not block.
  */
-typedef struct xplrGnssDecryptionKeys_type {
-    char keys[XPLR_GNSS_DECRYPTION_KEYS_LEN];   /**< Key in ubx ready format. */
-    uint16_t size;                              /**< key length. */
-} xplrGnssDecryptionKeys_t;
+typedef void (*xplrGnssRawMsgSink_t)(uGnssProtocol_t protocol,
+                                     const char *msg,
+                                     size_t size,
+                                     void *arg);
 
 /**
- * Correction data settings
+ * Events a subscriber can register for, may be OR-ed together
  */
-typedef struct xplrGnssCorrectionCfg_type {
-    xplrGnssDecryptionKeys_t keys;  /**< Correction data decryption keys settings. */
-    xplrGnssCorrDataSrc_t source;   /**< Correction data source. */
-} xplrGnssCorrectionCfg_t;
+typedef enum {
+    XPLR_GNSS_EVENT_LOCATION = (1 << 0),    /**< A new location epoch has been published */
+    XPLR_GNSS_EVENT_FIX_TYPE = (1 << 1),    /**< The location fix type changed */
+    XPLR_GNSS_EVENT_ACCURACY = (1 << 2),    /**< Horizontal accuracy crossed the subscriber threshold */
+    XPLR_GNSS_EVENT_DR_STATE = (1 << 3),    /**< Fusion mode or IMU alignment status changed */
+    XPLR_GNSS_EVENT_DR_DEGRADED = (1 << 4)  /**< Alignment lost, fusion suspended or a new sensor/alignment fault */
+} xplrGnssEventType_t;
 
 /**
- * Enumeration that contains the different Save on Shutdown
- * configuration states
+ * Event delivered to subscribers
  */
-typedef enum {
-    XPLR_GNSS_SOS_STATE_ERROR = -1,     /**< Invalid or error state. */
-    XPLR_GNSS_SOS_STATE_INITIAL = 0,    /**< Initial state*/
-    XPLR_GNSS_SOS_STATE_UNKNOWN,        /**< Unknown or Not Acknowledged state. */
-    XPLR_GNSS_SOS_STATE_ACKNOWLEDGED,   /**< Acknowledged state. */
-    XPLR_GNSS_SOS_STATE_FAILED_RESTORE, /**< Failed to restore backup configuration */
-    XPLR_GNSS_SOS_STATE_RESTORED,       /**< Successfully restored backup configuration from memory */
-    XPLR_GNSS_SOS_STATE_NO_BACKUP       /**< No backup found in memory */
-} xplrGnssSoSConfigStates_t;
+typedef struct xplrGnssEvent_type {
+    xplrGnssEventType_t type;                   /**< Which event happened */
+    uint8_t dvcProfile;                         /**< Device profile that raised it */
+    union {
+        xplrGnssLocation_t location;            /**< LOCATION, FIX_TYPE and ACCURACY events */
+        struct {
+            xplrGnssFusionMode_t fusionMode;    /**< Current fusion mode */
+            xplrGnssEsfAlgStatus_t algStatus;   /**< Current IMU alignment status */
+            uint8_t algErrors;                  /**< ESF-ALG error flags */
+            uint8_t sensorFaults;               /**< Sensor fault bits of all sensors OR-ed */
+            uint8_t score;                      /**< Quality of the current calibration, 0-100 */
+            xplrGnssEpoch_t epoch;              /**< Epoch of the ESF message that changed */
+        } dr;                                   /**< DR_STATE and DR_DEGRADED events */
+    } data;
+} xplrGnssEvent_t;
 
 /**
- * Struct that contains the Save on Shutdown configuration flags
-*/
-typedef struct xplrGnssShutdownCfg_type {
-    xplrGnssSoSConfigStates_t state;    /**< State of Save on Shutdown */
-    bool isRestored;                    /**< Flag indicating module has successfully restored configuration from backup */
-    bool hasBackup;                     /**< Flag indicating module has saved backup configuration in flash */
-    int cmdAck;                         /**< Flag indicating module has acknowledged clear backup configuration command */
-} xplrGnssShutdownCfg_t;
+ * Callback receiving the events of a subscriber.
+ * Invoked from the ubxlib callback task: it must not block.
+ */
+typedef void (*xplrGnssEventCb_t)(const xplrGnssEvent_t *event, void *arg);
 
 /**
- * Struct that contains location metrics
+ * Subscriber settings
  */
-typedef struct xplrGnssDeviceCfg_type {
-    xplrLocationDevConf_t hw;           /**< Hardware specific settings. */
-    xplrGnssDeadReckoningCfg_t dr;      /**< Dead Reckoning settings. */
-    xplrGnssCorrectionCfg_t corrData;   /**< Correction data settings. */
-    xplrGnssShutdownCfg_t backup;       /**< Configuration for Save On Shutdown */
-} xplrGnssDeviceCfg_t;
+typedef struct xplrGnssSubscriberCfg_type {
+    uint32_t events;            /**< OR-ed xplrGnssEventType_t the subscriber is interested in */
+    uint32_t accuracyThreshold; /**< Horizontal accuracy threshold in mm, for ACCURACY events */
+    xplrGnssEventCb_t cb;       /**< Callback receiving the events, NULL to queue them instead */
+    void *cbArg;                /**< User argument passed to cb */
+} xplrGnssSubscriberCfg_t;
 
 /**
  * Enumeration that contains the different logging submodules for the gnss module
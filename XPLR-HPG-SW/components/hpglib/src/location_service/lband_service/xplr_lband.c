@@ -24,6 +24,7 @@
 #include "string.h"
 #include "esp_task_wdt.h"
 #include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 #include "cJSON.h"
 #include "xplr_lband.h"
 #include "./../../../components/hpglib/src/common/xplr_common.h"
@@ -45,6 +46,52 @@
 #define XPLRLBAND_CONSOLE(message, ...) do{} while(0)
 #endif
 
+/**
+ * Largest UBX-RXM-PMP frame accepted.
+ * Standard is 536 bytes, 32 bytes extra for future proofing.
+ */
+#define XPLR_LBAND_PMP_FRAME_MAX        (568U)
+
+/**
+ * Queue of PMP frames between the ubxlib callback and the
+ * forwarding task, holds about 7 frames
+ */
+#define XPLR_LBAND_FWD_RING_BUF_SIZE    (4U * 1024U)
+
+/**
+ * Largest coalesced write of PMP frames to a GNSS device
+ */
+#define XPLR_LBAND_FWD_BATCH_SIZE       (2U * 1024U)
+
+/**
+ * Forwarding task settings
+ */
+#define XPLR_LBAND_FWD_TASK_STACK       (3U * 1024U)
+#define XPLR_LBAND_FWD_TASK_PRIO        (5U)
+#define XPLR_LBAND_FWD_WAIT             pdMS_TO_TICKS(100)
+#define XPLR_LBAND_FWD_STOP_RETRIES     (10U)
+
+/**
+ * UBX-RXM-PMP layout: offset of the payload in the frame,
+ * of Eb/N0 in the v0 and v1 payloads and size of the checksum
+ */
+#define XPLR_LBAND_UBX_HEADER_LEN       (6U)
+#define XPLR_LBAND_UBX_CK_LEN           (2U)
+#define XPLR_LBAND_PMP_V0_EBNO          (526U)
+#define XPLR_LBAND_PMP_V1_EBNO          (22U)
+
+/**
+ * Number of regions in the PointPerfect frequency topic
+ */
+#define XPLR_LBAND_NUMOF_REGIONS        (2U)
+
+/**
+ * Margin a position must move outside of the current region area
+ * before another region is selected (about 110 km of latitude per degree)
+ */
+#define XPLR_LBAND_REGION_HYSTERESIS_DEG    (1)
+#define XPLR_LBAND_DEG_X1E7(deg)            ((int32_t)(deg) * 10000000)
+
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
@@ -81,8 +128,30 @@ typedef struct xplrLbandAsyncIds_type {
 typedef struct xplrLbandRunContext_type {
     uDeviceHandle_t dvcHandler;     /**< ubxlib device handler */
     xplrLbandAsyncIds_t asyncIds;   /**< async id handers */
+    uDeviceHandle_t *extraDest[XPLRLBAND_NUMOF_DEST_GNSS];  /**< GNSS devices fed along with
+                                                                 dvcCfg->destHandler */
+    uint8_t numOfExtraDest;         /**< valid entries of extraDest */
+    RingbufHandle_t fwdRing;        /**< PMP frames waiting to be forwarded */
+    TaskHandle_t fwdTask;           /**< forwarding task, NULL when not running */
+    volatile bool fwdRun;           /**< cleared to stop the forwarding task */
+    char fwdBatch[XPLR_LBAND_FWD_BATCH_SIZE];   /**< coalesced frames of one write */
+    xplrLbandLinkStats_t stats;     /**< link statistics */
+    bool corrDataSentInitial;       /**< first forward not done yet */
+    uint32_t freqTable[XPLR_LBAND_NUMOF_REGIONS];   /**< frequency of each region in Hz,
+                                                         0 if unknown */
+    uint32_t freqPayloadHash;       /**< hash of the payload freqTable was parsed from */
 } xplrLbandRunContext_t;
 
+/**
+ * Area covered by the LBAND beam of a region
+ */
+typedef struct xplrLbandRegionArea_type {
+    int32_t latMinX1e7;     /**< southern edge */
+    int32_t latMaxX1e7;     /**< northern edge */
+    int32_t lonMinX1e7;     /**< western edge */
+    int32_t lonMaxX1e7;     /**< eastern edge */
+} xplrLbandRegionArea_t;
+
 /**
  * Setting struct for LBAND devices
  */
@@ -101,11 +170,26 @@ static bool hasFrwdCorrMsg = false;
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
-static const char *freqRegions[] = {
+static const char *freqRegions[XPLR_LBAND_NUMOF_REGIONS] = {
     "eu",
     "us"
 };
 
+/**
+ * Approximate coverage of the PointPerfect LBAND regions,
+ * same order as freqRegions
+ */
+static const xplrLbandRegionArea_t regionAreas[XPLR_LBAND_NUMOF_REGIONS] = {
+    {
+        XPLR_LBAND_DEG_X1E7(34), XPLR_LBAND_DEG_X1E7(72),
+        XPLR_LBAND_DEG_X1E7(-25), XPLR_LBAND_DEG_X1E7(45)
+    },
+    {
+        XPLR_LBAND_DEG_X1E7(24), XPLR_LBAND_DEG_X1E7(60),
+        XPLR_LBAND_DEG_X1E7(-130), XPLR_LBAND_DEG_X1E7(-60)
+    }
+};
+
 static xplrLband_t lbandDvcs[XPLRLBAND_NUMOF_DEVICES] = {NULL};
 static int8_t logIndex = -1;
 
@@ -121,7 +205,16 @@ static esp_err_t lbandSetFreqFromPrm(uint8_t dvcProfile, uint32_t freq);
 static esp_err_t lbandSetFreqFromCfg(uint8_t dvcProfile);
 static esp_err_t lbandParseFrequencyFromMqtt(uint8_t dvcProfile,
                                              char *mqttPayload);
+static bool lbandIsInRegionArea(xplrLbandRegion_t region,
+                                int32_t latitudeX1e7,
+                                int32_t longitudeX1e7,
+                                int32_t marginX1e7);
 static bool lbandIsDvcProfileValid(uint8_t dvcProfile);
+static esp_err_t lbandFwdStart(xplrLband_t *lbandDvc);
+static void lbandFwdStop(xplrLband_t *lbandDvc);
+static void lbandFwdTask(void *pvParams);
+static void lbandFwdWrite(xplrLband_t *lbandDvc, size_t size, uint32_t frames);
+static bool lbandPmpCheck(xplrLband_t *lbandDvc, const char *frame, size_t size);
 
 /* ----------------------------------------------------------------
  * STATIC CALLBACK FUNCTION PROTOTYPES
@@ -291,6 +384,52 @@ esp_err_t xplrLbandSetDestGnssHandler(uint8_t dvcProfile,
     return ret;
 }
 
+esp_err_t xplrLbandAddDestGnssHandler(uint8_t dvcProfile,
+                                      uDeviceHandle_t *destHandler)
+{
+    xplrLbandRunContext_t *options;
+    esp_err_t ret;
+    uint8_t i;
+    bool boolRet = lbandIsDvcProfileValid(dvcProfile);
+
+    if ((!boolRet) || (destHandler == NULL) || (lbandDvcs[dvcProfile].dvcCfg == NULL)) {
+        XPLRLBAND_CONSOLE(E, "Invalid argument! Cannot add GNSS destination handler.");
+        ret = ESP_ERR_INVALID_ARG;
+    } else if (lbandDvcs[dvcProfile].dvcCfg->destHandler == NULL) {
+        ret = xplrLbandSetDestGnssHandler(dvcProfile, destHandler);
+    } else {
+        options = &lbandDvcs[dvcProfile].options;
+        ret = ESP_OK;
+        if (lbandDvcs[dvcProfile].dvcCfg->destHandler == destHandler) {
+            XPLRLBAND_CONSOLE(D, "GNSS device handler is already a destination.");
+        } else {
+            for (i = 0; i < options->numOfExtraDest; i++) {
+                if (options->extraDest[i] == destHandler) {
+                    XPLRLBAND_CONSOLE(D, "GNSS device handler is already a destination.");
+                    break;
+                } else {
+                    // do nothing
+                }
+            }
+
+            if (i < options->numOfExtraDest) {
+                // do nothing
+            } else if (options->numOfExtraDest >= XPLRLBAND_NUMOF_DEST_GNSS) {
+                XPLRLBAND_CONSOLE(E, "Cannot add more than [%u] extra GNSS destinations!",
+                                  XPLRLBAND_NUMOF_DEST_GNSS);
+                ret = ESP_ERR_NO_MEM;
+            } else {
+                // Entry is written before it is counted, the async sender may already run
+                options->extraDest[options->numOfExtraDest] = destHandler;
+                options->numOfExtraDest++;
+                XPLRLBAND_CONSOLE(D, "Added GNSS destination handler [%u].", options->numOfExtraDest);
+            }
+        }
+    }
+
+    return ret;
+}
+
 esp_err_t xplrLbandOptionSingleValSet(uint8_t dvcProfile,
                                       uint32_t keyId,
                                       uint64_t value,
@@ -415,10 +554,17 @@ esp_err_t xplrLbandSetFrequencyFromMqtt(uint8_t dvcProfile,
         ret = ESP_ERR_INVALID_ARG;
     }
 
+    if ((ret == ESP_OK) &&
+        ((freqRegion <= XPLR_LBAND_FREQUENCY_INVALID) || (freqRegion >= (int)XPLR_LBAND_NUMOF_REGIONS))) {
+        XPLRLBAND_CONSOLE(E, "Invalid frequency region [%d]!", freqRegion);
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
     if (ret == ESP_OK) {
         lbandDvcs[dvcProfile].dvcCfg->corrDataConf.region = freqRegion;
 
         ret = lbandParseFrequencyFromMqtt(dvcProfile, mqttPayload);
+        lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = lbandDvcs[dvcProfile].options.freqTable[freqRegion];
 
         if (ret != ESP_OK || lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq == 0) {
             XPLRLBAND_CONSOLE(E, "Could not parse frequency!");
@@ -442,6 +588,68 @@ esp_err_t xplrLbandSetFrequencyFromMqtt(uint8_t dvcProfile,
     return ret;
 }
 
+esp_err_t xplrLbandSelectRegionByLocation(uint8_t dvcProfile,
+                                          int32_t latitudeX1e7,
+                                          int32_t longitudeX1e7)
+{
+    xplrLbandCorrDataCfg_t *corrDataConf;
+    xplrLbandRegion_t region;
+    xplrLbandRegion_t newRegion = XPLR_LBAND_FREQUENCY_INVALID;
+    uint32_t freq;
+    esp_err_t ret;
+    bool boolRet = lbandIsDvcProfileValid(dvcProfile);
+
+    if ((!boolRet) || (lbandDvcs[dvcProfile].dvcCfg == NULL)) {
+        XPLRLBAND_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        corrDataConf = &lbandDvcs[dvcProfile].dvcCfg->corrDataConf;
+        ret = ESP_OK;
+        /* Stay in the current region until the position is clearly outside of it */
+        if (!lbandIsInRegionArea(corrDataConf->region,
+                                 latitudeX1e7,
+                                 longitudeX1e7,
+                                 XPLR_LBAND_DEG_X1E7(XPLR_LBAND_REGION_HYSTERESIS_DEG))) {
+            for (region = XPLR_LBAND_FREQUENCY_EU; region < (int)XPLR_LBAND_NUMOF_REGIONS; region++) {
+                if (lbandIsInRegionArea(region, latitudeX1e7, longitudeX1e7, 0)) {
+                    newRegion = region;
+                    break;
+                } else {
+                    // do nothing
+                }
+            }
+        } else {
+            // do nothing
+        }
+
+        if (newRegion != XPLR_LBAND_FREQUENCY_INVALID) {
+            freq = lbandDvcs[dvcProfile].options.freqTable[newRegion];
+            if (freq == 0) {
+                XPLRLBAND_CONSOLE(W,
+                                  "No frequency known for region \"%s\", waiting for the frequency topic.",
+                                  freqRegions[newRegion]);
+                ret = ESP_ERR_INVALID_STATE;
+            } else {
+                ret = lbandSetFreqFromPrm(dvcProfile, freq);
+                if (ret == ESP_OK) {
+                    corrDataConf->region = newRegion;
+                    corrDataConf->freq = freq;
+                    XPLRLBAND_CONSOLE(I,
+                                      "Switched LBAND region to %s, frequency: %u Hz.",
+                                      freqRegions[newRegion],
+                                      freq);
+                } else {
+                    XPLRLBAND_CONSOLE(E, "Could not retune LBAND to region %s!", freqRegions[newRegion]);
+                }
+            }
+        } else {
+            // still in the current region, or outside of any coverage
+        }
+    }
+
+    return ret;
+}
+
 uint32_t xplrLbandGetFrequency(uint8_t dvcProfile)
 {
     esp_err_t espRet;
@@ -504,17 +712,21 @@ esp_err_t xplrLbandSendCorrectionDataAsyncStart(uint8_t dvcProfile)
         if (lbandDvcs[dvcProfile].dvcCfg->destHandler != NULL) {
             if (lbandDvcs[dvcProfile].options.asyncIds.ahCorrData >= 0) {
                 XPLRLBAND_CONSOLE(D, "Looks like LBAND Send Correction Data async is already running!");
+            } else if (lbandFwdStart(&lbandDvcs[dvcProfile]) != ESP_OK) {
+                XPLRLBAND_CONSOLE(E, "Failed to start the correction data forwarding task!");
+                ret = ESP_FAIL;
             } else {
                 lbandDvcs[dvcProfile].options.asyncIds.ahCorrData = uGnssMsgReceiveStart(
                                                                         lbandDvcs[dvcProfile].options.dvcHandler,
                                                                         &messageIdLBand,
                                                                         xplrLbandMessageReceivedCB,
-                                                                        lbandDvcs[dvcProfile].dvcCfg->destHandler);
+                                                                        &lbandDvcs[dvcProfile]);
                 if (lbandDvcs[dvcProfile].options.asyncIds.ahCorrData < 0) {
                     XPLRLBAND_CONSOLE(E,
                                       "LBAND Send Correction Data async failed to start with error code [%d]",
                                       lbandDvcs[dvcProfile].options.asyncIds.ahCorrData);
                     lbandDvcs[dvcProfile].options.asyncIds.ahCorrData = -1;
+                    lbandFwdStop(&lbandDvcs[dvcProfile]);
                     ret = ESP_FAIL;
                 } else {
                     XPLRLBAND_CONSOLE(D, "Started LBAND Send Correction Data async.");
@@ -545,6 +757,7 @@ esp_err_t xplrLbandSendCorrectionDataAsyncStop(uint8_t dvcProfile)
             intRet = lbandAsyncStopper(dvcProfile, lbandDvcs[dvcProfile].options.asyncIds.ahCorrData);
 
             if (intRet == 0) {
+                lbandFwdStop(&lbandDvcs[dvcProfile]);
                 if (xSemaphore != NULL) {
                     vSemaphoreDelete(xSemaphore);
                     xSemaphore = NULL;
@@ -618,6 +831,22 @@ esp_err_t xplrLbandPrintDeviceInfo(uint8_t dvcProfile)
     return ret;
 }
 
+esp_err_t xplrLbandGetLinkStats(uint8_t dvcProfile, xplrLbandLinkStats_t *stats)
+{
+    esp_err_t ret;
+    bool boolRet = lbandIsDvcProfileValid(dvcProfile);
+
+    if ((!boolRet) || (stats == NULL)) {
+        XPLRLBAND_CONSOLE(E, "Invalid argument!");
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        *stats = lbandDvcs[dvcProfile].options.stats;
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
 bool xplrLbandHasFrwdMessage(void)
 {
     bool ret;
@@ -763,7 +992,11 @@ static esp_err_t lbandParseFrequencyFromMqtt(uint8_t dvcProfile,
 {
     esp_err_t ret;
     cJSON *json, *freqs, *jregion, *current, *frequency;
-    double tmpfreq = 0;
+    uint32_t *freqTable = lbandDvcs[dvcProfile].options.freqTable;
+    uint32_t hash = 2166136261U;
+    const char *pos;
+    char *value;
+    uint8_t region;
 
     if (mqttPayload == NULL) {
         XPLRLBAND_CONSOLE(E, "mqttPayload pointer is NULL");
@@ -773,43 +1006,294 @@ static esp_err_t lbandParseFrequencyFromMqtt(uint8_t dvcProfile,
     }
 
     if (ret == ESP_OK) {
-        json = cJSON_Parse(mqttPayload);
+        /* The frequency topic rarely changes, parse it only when it does */
+        for (pos = mqttPayload; *pos != 0; pos++) {
+            hash = (hash ^ (uint8_t)*pos) * 16777619U;
+        }
 
-        if (cJSON_HasObjectItem(json, "frequencies")) {
+        if ((hash == lbandDvcs[dvcProfile].options.freqPayloadHash) &&
+            (freqTable[lbandDvcs[dvcProfile].dvcCfg->corrDataConf.region] != 0)) {
+            XPLRLBAND_CONSOLE(D, "Frequency payload unchanged, using the cached frequencies.");
+        } else {
+            memset(freqTable, 0, sizeof(lbandDvcs[dvcProfile].options.freqTable));
+            lbandDvcs[dvcProfile].options.freqPayloadHash = hash;
+            json = cJSON_Parse(mqttPayload);
             freqs = cJSON_GetObjectItem(json, "frequencies");
-            if (cJSON_HasObjectItem(freqs, freqRegions[lbandDvcs[dvcProfile].dvcCfg->corrDataConf.region])) {
-                jregion = cJSON_GetObjectItem(freqs,
-                                              freqRegions[lbandDvcs[dvcProfile].dvcCfg->corrDataConf.region]);
-                if (cJSON_HasObjectItem(jregion, "current")) {
+            if (freqs == NULL) {
+                XPLRLBAND_CONSOLE(E, "Theres no \"frequencies\" object.");
+                ret = ESP_FAIL;
+            } else {
+                /* Cache the frequencies of every region in a single pass */
+                for (region = 0; region < XPLR_LBAND_NUMOF_REGIONS; region++) {
+                    jregion = cJSON_GetObjectItem(freqs, freqRegions[region]);
                     current = cJSON_GetObjectItem(jregion, "current");
-                    if (cJSON_HasObjectItem(current, "value")) {
-                        frequency = cJSON_GetObjectItem(current, "value");
-                        sscanf(cJSON_GetStringValue(frequency), "%lf", &tmpfreq);
-                        lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = (uint32_t)((1e+6) * tmpfreq);
+                    frequency = cJSON_GetObjectItem(current, "value");
+                    value = cJSON_GetStringValue(frequency);
+                    if (value != NULL) {
+                        freqTable[region] = (uint32_t)((1e+6) * strtod(value, NULL));
+                        XPLRLBAND_CONSOLE(D,
+                                          "Region %s frequency: %u Hz.",
+                                          freqRegions[region],
+                                          freqTable[region]);
                     } else {
-                        XPLRLBAND_CONSOLE(E, "Theres no frequency \"value\" object.");
-                        lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = 0;
-                        ret = ESP_FAIL;
+                        XPLRLBAND_CONSOLE(W,
+                                          "Theres no \"%s\" current frequency value.",
+                                          freqRegions[region]);
                     }
-                } else {
-                    XPLRLBAND_CONSOLE(E, "Theres no \"current\" object.");
-                    lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = 0;
-                    ret = ESP_FAIL;
                 }
+            }
+
+            cJSON_Delete(json);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Checks if a position lies in the area of a region, grown by margin on every side
+ */
+static bool lbandIsInRegionArea(xplrLbandRegion_t region,
+                                int32_t latitudeX1e7,
+                                int32_t longitudeX1e7,
+                                int32_t marginX1e7)
+{
+    const xplrLbandRegionArea_t *area;
+    bool ret;
+
+    if ((region <= XPLR_LBAND_FREQUENCY_INVALID) || (region >= (int)XPLR_LBAND_NUMOF_REGIONS)) {
+        ret = false;
+    } else {
+        area = &regionAreas[region];
+        ret = (latitudeX1e7  >= (area->latMinX1e7 - marginX1e7)) &&
+              (latitudeX1e7  <= (area->latMaxX1e7 + marginX1e7)) &&
+              (longitudeX1e7 >= (area->lonMinX1e7 - marginX1e7)) &&
+              (longitudeX1e7 <= (area->lonMaxX1e7 + marginX1e7));
+    }
+
+    return ret;
+}
+
+/**
+ * Creates the forwarding queue and task of a device
+ */
+static esp_err_t lbandFwdStart(xplrLband_t *lbandDvc)
+{
+    esp_err_t ret;
+    BaseType_t xRet;
+
+    memset(&lbandDvc->options.stats, 0, sizeof(xplrLbandLinkStats_t));
+    lbandDvc->options.stats.ebnoMin = UINT8_MAX;
+    lbandDvc->options.corrDataSentInitial = true;
+    lbandDvc->options.fwdRing = xRingbufferCreate(XPLR_LBAND_FWD_RING_BUF_SIZE, RINGBUF_TYPE_NOSPLIT);
+
+    if (lbandDvc->options.fwdRing == NULL) {
+        XPLRLBAND_CONSOLE(E, "Could not create the forwarding queue!");
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        lbandDvc->options.fwdRun = true;
+        xRet = xTaskCreate(lbandFwdTask,
+                           "lbandFwdTask",
+                           XPLR_LBAND_FWD_TASK_STACK,
+                           lbandDvc,
+                           XPLR_LBAND_FWD_TASK_PRIO,
+                           &lbandDvc->options.fwdTask);
+        if (xRet != pdPASS) {
+            XPLRLBAND_CONSOLE(E, "Could not create the forwarding task!");
+            lbandDvc->options.fwdRun = false;
+            lbandDvc->options.fwdTask = NULL;
+            vRingbufferDelete(lbandDvc->options.fwdRing);
+            lbandDvc->options.fwdRing = NULL;
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            ret = ESP_OK;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Stops the forwarding task and frees its queue.
+ * The async feeding the queue must be stopped already.
+ */
+static void lbandFwdStop(xplrLband_t *lbandDvc)
+{
+    uint8_t retries;
+
+    lbandDvc->options.fwdRun = false;
+    for (retries = 0;
+         (lbandDvc->options.fwdTask != NULL) && (retries < XPLR_LBAND_FWD_STOP_RETRIES);
+         retries++) {
+        vTaskDelay(XPLR_LBAND_FWD_WAIT);
+    }
+
+    if (lbandDvc->options.fwdTask != NULL) {
+        XPLRLBAND_CONSOLE(W, "Forwarding task did not exit, deleting it.");
+        vTaskDelete(lbandDvc->options.fwdTask);
+        lbandDvc->options.fwdTask = NULL;
+    } else {
+        // do nothing
+    }
+
+    if (lbandDvc->options.fwdRing != NULL) {
+        vRingbufferDelete(lbandDvc->options.fwdRing);
+        lbandDvc->options.fwdRing = NULL;
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Forwarding task: drains the queued PMP frames and writes as many
+ * of them as fit in XPLR_LBAND_FWD_BATCH_SIZE with a single write
+ */
+static void lbandFwdTask(void *pvParams)
+{
+    xplrLband_t *lbandDvc = (xplrLband_t *)pvParams;
+    char *frame;
+    size_t frameSize;
+    size_t batchSize;
+    uint32_t batchFrames;
+
+    while (lbandDvc->options.fwdRun) {
+        batchSize = 0;
+        batchFrames = 0;
+        frame = (char *)xRingbufferReceive(lbandDvc->options.fwdRing, &frameSize, XPLR_LBAND_FWD_WAIT);
+        while (frame != NULL) {
+            if (frame[0] != 0) {
+                memcpy(&lbandDvc->options.fwdBatch[batchSize], frame, frameSize);
+                batchSize += frameSize;
+                batchFrames++;
             } else {
-                XPLRLBAND_CONSOLE(E,
-                                  "Theres no \"%s\" location object.",
-                                  freqRegions[lbandDvcs[dvcProfile].dvcCfg->corrDataConf.region]);
-                lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = 0;
-                ret = ESP_FAIL;
+                // frame failed its checks in the callback
+            }
+            vRingbufferReturnItem(lbandDvc->options.fwdRing, frame);
+
+            if ((batchSize + XPLR_LBAND_PMP_FRAME_MAX) <= XPLR_LBAND_FWD_BATCH_SIZE) {
+                frame = (char *)xRingbufferReceive(lbandDvc->options.fwdRing, &frameSize, 0);
+            } else {
+                frame = NULL;
             }
+        }
+
+        if (batchFrames > 0) {
+            lbandFwdWrite(lbandDvc, batchSize, batchFrames);
         } else {
-            XPLRLBAND_CONSOLE(E, "Theres no \"frequencies\" object.");
-            lbandDvcs[dvcProfile].dvcCfg->corrDataConf.freq = 0;
-            ret = ESP_FAIL;
+            // do nothing
         }
+    }
+
+    lbandDvc->options.fwdTask = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * Writes a batch of frames to every GNSS destination
+ */
+static void lbandFwdWrite(xplrLband_t *lbandDvc, size_t size, uint32_t frames)
+{
+    int32_t intRet;
+    uint8_t numOfExtraDest;
+    uint8_t i;
+
+    intRet = xplrHlprLocSrvcSendUbxFormattedCommand(lbandDvc->dvcCfg->destHandler,
+                                                    lbandDvc->options.fwdBatch,
+                                                    size);
+
+    /* The same PMP frames feed every extra receiver, e.g. of a dual antenna rig */
+    numOfExtraDest = lbandDvc->options.numOfExtraDest;
+    for (i = 0; i < numOfExtraDest; i++) {
+        if (xplrHlprLocSrvcSendUbxFormattedCommand(lbandDvc->options.extraDest[i],
+                                                   lbandDvc->options.fwdBatch,
+                                                   size) != (int32_t)size) {
+            XPLRLBAND_CONSOLE(E,
+                              "Error sending LBAND correction data to extra GNSS destination [%u]!",
+                              i);
+        } else {
+            // do nothing
+        }
+    }
 
-        cJSON_Delete(json);
+    lbandDvc->options.stats.writes++;
+    if (intRet < 0 || intRet != (int32_t)size) {
+        lbandDvc->options.stats.writeErrors++;
+        XPLRLBAND_CONSOLE(E,
+                          "Error sending LBAND correction data to GNSS, size mismatch: was [%u] bytes | sent [%d] bytes!",
+                          size,
+                          intRet);
+        XPLR_CI_CONSOLE(11, "ERROR");
+    } else {
+        lbandDvc->options.stats.framesForwarded += frames;
+        if ((xSemaphore != NULL) &&
+            (xSemaphoreTake(xSemaphore, XPLR_LBAND_SEMAPHORE_TIMEOUT) == pdTRUE)) {
+            hasFrwdCorrMsg = true;
+            xSemaphoreGive(xSemaphore);
+        }
+        XPLRLBAND_CONSOLE(D,
+                          "Sent LBAND correction data size [%d] in [%u] frames",
+                          intRet,
+                          frames);
+        if (lbandDvc->options.corrDataSentInitial) {
+            XPLR_CI_CONSOLE(11, "OK");
+            lbandDvc->options.corrDataSentInitial = false;
+        } else {
+            // do nothing
+        }
+    }
+}
+
+/**
+ * Verifies the UBX checksum of a PMP frame and records its Eb/N0
+ */
+static bool lbandPmpCheck(xplrLband_t *lbandDvc, const char *frame, size_t size)
+{
+    xplrLbandLinkStats_t *stats = &lbandDvc->options.stats;
+    const uint8_t *data = (const uint8_t *)frame;
+    const uint8_t *payload = &data[XPLR_LBAND_UBX_HEADER_LEN];
+    size_t payloadLen;
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    uint8_t ebno;
+    size_t i;
+    bool ret;
+
+    if (size <= (XPLR_LBAND_UBX_HEADER_LEN + XPLR_LBAND_UBX_CK_LEN)) {
+        stats->crcErrors++;
+        ret = false;
+    } else {
+        payloadLen = size - XPLR_LBAND_UBX_HEADER_LEN - XPLR_LBAND_UBX_CK_LEN;
+        for (i = 2; i < (size - XPLR_LBAND_UBX_CK_LEN); i++) {
+            ckA += data[i];
+            ckB += ckA;
+        }
+
+        if ((ckA != data[size - 2]) || (ckB != data[size - 1])) {
+            stats->crcErrors++;
+            XPLRLBAND_CONSOLE(W, "PMP frame checksum mismatch, frame dropped!");
+            ret = false;
+        } else {
+            if ((payload[0] == 0) && (payloadLen > XPLR_LBAND_PMP_V0_EBNO)) {
+                ebno = payload[XPLR_LBAND_PMP_V0_EBNO];
+            } else if ((payload[0] == 1) && (payloadLen > XPLR_LBAND_PMP_V1_EBNO)) {
+                ebno = payload[XPLR_LBAND_PMP_V1_EBNO];
+            } else {
+                ebno = stats->ebnoLast;
+            }
+
+            stats->ebnoLast = ebno;
+            if (ebno < stats->ebnoMin) {
+                stats->ebnoMin = ebno;
+            } else {
+                // do nothing
+            }
+            if (ebno > stats->ebnoMax) {
+                stats->ebnoMax = ebno;
+            } else {
+                // do nothing
+            }
+            ret = true;
+        }
     }
 
     return ret;
@@ -824,45 +1308,38 @@ static void xplrLbandMessageReceivedCB(uDeviceHandle_t gnssHandle,
                                        int32_t errorCodeOrLength,
                                        void *callbackParam)
 {
-    /**
-     * Standard is 536 bytes.
-     * We allocate  32 bytes extra for future proofing if needed
-     */
-    char buffer[568];
-    int32_t intRet;
+    char *frame = NULL;
     int32_t lbandCbRead;
-    static bool correctionDataSentInitial = true;
-
-    if ((errorCodeOrLength > 0) && (errorCodeOrLength <= ELEMENTCNT(buffer))) {
-        lbandCbRead = uGnssMsgReceiveCallbackRead(gnssHandle, buffer, errorCodeOrLength);
-
-        intRet = xplrHlprLocSrvcSendUbxFormattedCommand((uDeviceHandle_t *)callbackParam,
-                                                        buffer,
-                                                        lbandCbRead);
-
-        if (intRet < 0 || intRet != lbandCbRead) {
-            XPLRLBAND_CONSOLE(E,
-                              "Error sending LBAND correction data to LBAND, size mismatch: was [%d] bytes | sent [%d] bytes!",
-                              intRet,
-                              lbandCbRead);
-            XPLR_CI_CONSOLE(11, "ERROR");
-        } else {
-            if (xSemaphoreTake(xSemaphore, XPLR_LBAND_SEMAPHORE_TIMEOUT) == pdTRUE) {
-                hasFrwdCorrMsg = true;
-                xSemaphoreGive(xSemaphore);
-            }
-            XPLRLBAND_CONSOLE(D,
-                              "Sent LBAND correction data size [%d]",
-                              intRet);
-            if (correctionDataSentInitial) {
-                XPLR_CI_CONSOLE(11, "OK");
-                correctionDataSentInitial = false;
+    xplrLband_t *lbandDvc = (xplrLband_t *)callbackParam;
+
+    if ((errorCodeOrLength > 0) && (errorCodeOrLength <= XPLR_LBAND_PMP_FRAME_MAX)) {
+        lbandDvc->options.stats.framesReceived++;
+        /**
+         * The frame is read straight into the forwarding queue, writing it
+         * to the GNSS module is left to the forwarding task so a slow
+         * GNSS interface never holds back the LBAND reception.
+         */
+        if (xRingbufferSendAcquire(lbandDvc->options.fwdRing,
+                                   (void **)&frame,
+                                   errorCodeOrLength,
+                                   0) == pdTRUE) {
+            lbandCbRead = uGnssMsgReceiveCallbackRead(gnssHandle, frame, errorCodeOrLength);
+            if ((lbandCbRead != errorCodeOrLength) ||
+                (!lbandPmpCheck(lbandDvc, frame, errorCodeOrLength))) {
+                // An acquired item cannot be given back, mark it so it is not forwarded
+                frame[0] = 0;
+            } else {
+                // do nothing
             }
+            xRingbufferSendComplete(lbandDvc->options.fwdRing, frame);
+        } else {
+            lbandDvc->options.stats.framesDropped++;
+            XPLRLBAND_CONSOLE(W, "Correction data forwarding queue full, frame dropped!");
         }
     } else {
         XPLRLBAND_CONSOLE(W,
-                          "Message received [%d bytes] which is invalid! Length must be between [1] and [%d] bytes!",
-                          errorCodeOrLength, ELEMENTCNT(buffer));
+                          "Message received [%d bytes] which is invalid! Length must be between [1] and [%u] bytes!",
+                          errorCodeOrLength, XPLR_LBAND_PMP_FRAME_MAX);
         XPLR_CI_CONSOLE(11, "ERROR");
     }
 }
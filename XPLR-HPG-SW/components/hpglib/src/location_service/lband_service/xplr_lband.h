@@ -123,6 +123,20 @@ esp_err_t xplrLbandStopDevice(uint8_t dvcProfile);
 esp_err_t xplrLbandSetDestGnssHandler(uint8_t dvcProfile,
                                       uDeviceHandle_t *destHandler);
 
+/**
+ * @brief Adds a GNSS device the correction data is forwarded to, on top of
+ * the one set by xplrLbandSetDestGnssHandler, so one LBAND stream can feed
+ * several receivers. Up to XPLRLBAND_NUMOF_DEST_GNSS extra devices can be added.
+ * If no destination has been set yet it becomes the main destination.
+ *
+ * @param dvcProfile   an integer number denoting the device profile/index.
+ * @param destHandler  the GNSS destination handler.
+ * @return             ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
+ *                     ESP_ERR_NO_MEM when no more destinations fit.
+ */
+esp_err_t xplrLbandAddDestGnssHandler(uint8_t dvcProfile,
+                                      uDeviceHandle_t *destHandler);
+
 /**
  * @brief Sets a single device option/config value.
  * Refer to your device/module manual for more info
@@ -240,6 +254,27 @@ esp_err_t xplrLbandSetFrequencyFromMqtt(uint8_t dvcProfile,
                                         char *mqttPayload,
                                         xplrLbandRegion_t freqRegion);
 
+/**
+ * @brief Selects the LBAND region from the current position and retunes
+ * the LBAND module when the vehicle moves to another region.
+ * Uses the frequencies of all regions cached by the last
+ * xplrLbandSetFrequencyFromMqtt call. The current region is kept until
+ * the position is XPLR_LBAND_REGION_HYSTERESIS_DEG outside of its area,
+ * and also when the position is outside of every region.
+ * Retuning talks to the LBAND module, call it from an application task
+ * (e.g. on every new GNSS fix) and not from a GNSS callback.
+ *
+ * @param dvcProfile     an integer number denoting the device profile/index.
+ * @param latitudeX1e7   latitude in ten millionths of a degree.
+ * @param longitudeX1e7  longitude in ten millionths of a degree.
+ * @return               ESP_OK on success, ESP_INVALID_ARG on invalid parameters,
+ *                       ESP_ERR_INVALID_STATE if the frequency of the new region
+ *                       is not known yet, ESP_FAIL if retuning failed.
+ */
+esp_err_t xplrLbandSelectRegionByLocation(uint8_t dvcProfile,
+                                          int32_t latitudeX1e7,
+                                          int32_t longitudeX1e7);
+
 /**
  * @brief Reads configured frequency from LBAND
  *
@@ -313,6 +348,16 @@ esp_err_t xplrLbandPrintDeviceInfo(uint8_t dvcProfile);
 */
 bool xplrLbandHasFrwdMessage(void);
 
+/**
+ * @brief Gets the LBAND link statistics: frames received, forwarded and lost,
+ * checksum errors and the Eb/N0 reported by UBX-RXM-PMP.
+ *
+ * @param dvcProfile  an integer number denoting the device profile/index.
+ * @param stats       receives the statistics.
+ * @return            ESP_OK on success, ESP_INVALID_ARG on invalid parameters.
+ */
+esp_err_t xplrLbandGetLinkStats(uint8_t dvcProfile, xplrLbandLinkStats_t *stats);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
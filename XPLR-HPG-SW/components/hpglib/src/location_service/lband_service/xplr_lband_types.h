@@ -46,6 +46,21 @@ typedef struct xplrLbandCorrDataCfg_type {
     uint32_t freq;            /**< Hardware specific settings. */
 } xplrLbandCorrDataCfg_t;
 
+/**
+ * LBAND link statistics, counted since the correction data async was started
+ */
+typedef struct xplrLbandLinkStats_type {
+    uint32_t framesReceived;    /**< UBX-RXM-PMP frames read from the LBAND module */
+    uint32_t framesForwarded;   /**< frames written to the GNSS destination(s) */
+    uint32_t framesDropped;     /**< frames lost because the forwarding queue was full */
+    uint32_t crcErrors;         /**< frames with a bad UBX checksum, never forwarded */
+    uint32_t writes;            /**< coalesced writes to the GNSS destination(s) */
+    uint32_t writeErrors;       /**< writes the main GNSS destination did not accept */
+    uint8_t ebnoLast;           /**< Eb/N0 of the last frame, in 0.125 dB steps */
+    uint8_t ebnoMin;            /**< lowest Eb/N0 seen, in 0.125 dB steps, UINT8_MAX before the first frame */
+    uint8_t ebnoMax;            /**< highest Eb/N0 seen, in 0.125 dB steps */
+} xplrLbandLinkStats_t;
+
 /**
  * Struct that contains location metrics
  */
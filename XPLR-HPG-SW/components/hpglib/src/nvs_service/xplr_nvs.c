@@ -489,6 +489,31 @@ xplrNvs_error_t xplrNvsReadStringHex(xplrNvs_t *nvs, const char *key, char *valu
     return ret;
 }
 
+xplrNvs_error_t xplrNvsReadBlob(xplrNvs_t *nvs, const char *key, void *value, size_t *size)
+{
+    esp_err_t err;
+    xplrNvs_error_t ret;
+
+    /* open nvs in readonly */
+    ret = nvsOpen(nvs, NVS_READONLY);
+    if (ret != XPLR_NVS_OK) {
+        ret = XPLR_NVS_ERROR;
+    } else {
+        err = nvs_get_blob(nvs->handler, key, value, size);
+        if (err != ESP_OK) {
+            ret = XPLR_NVS_ERROR;
+            XPLRNVS_CONSOLE(E, "Error (0x%04x) reading key <%s> from namespace <%s>", (int32_t)err, key,
+                            nvs->tag);
+            (void)nvsClose(nvs);
+        } else {
+            XPLRNVS_CONSOLE(D, "Read key <%s> in namespace <%s>", key,  nvs->tag);
+            ret = nvsClose(nvs);
+        }
+    }
+
+    return ret;
+}
+
 xplrNvs_error_t xplrNvsWriteU8(xplrNvs_t *nvs, const char *key, uint8_t value)
 {
     esp_err_t err;
@@ -811,6 +836,38 @@ xplrNvs_error_t xplrNvsWriteStringHex(xplrNvs_t *nvs, const char *key, const cha
     return ret;
 }
 
+xplrNvs_error_t xplrNvsWriteBlob(xplrNvs_t *nvs, const char *key, const void *value, size_t size)
+{
+    esp_err_t err;
+    xplrNvs_error_t ret;
+
+    /* open nvs in read/write */
+    ret = nvsOpen(nvs, NVS_READWRITE);
+    if (ret != XPLR_NVS_OK) {
+        ret = XPLR_NVS_ERROR;
+    } else {
+        err = nvs_set_blob(nvs->handler, key, value, size);
+
+        if (err != ESP_OK) {
+            ret = XPLR_NVS_ERROR;
+            XPLRNVS_CONSOLE(E, "Error writing key <%s> to namespace <%s>", key,  nvs->tag);
+            (void)nvsClose(nvs);
+        } else {
+            err = nvs_commit(nvs->handler);
+            if (err != ESP_OK) {
+                ret = XPLR_NVS_ERROR;
+                XPLRNVS_CONSOLE(E, "Error writing key <%s> to namespace <%s>", key,  nvs->tag);
+                (void)nvsClose(nvs);
+            } else {
+                XPLRNVS_CONSOLE(D, "Wrote %u bytes to key <%s> in namespace <%s>", size, key,  nvs->tag);
+                ret = nvsClose(nvs);
+            }
+        }
+    }
+
+    return ret;
+}
+
 int8_t xplrNvsInitLogModule(xplr_cfg_logInstance_t *logCfg)
 {
     int8_t ret;
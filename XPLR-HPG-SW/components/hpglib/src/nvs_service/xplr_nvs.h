@@ -207,6 +207,17 @@ xplrNvs_error_t xplrNvsReadString(xplrNvs_t *nvs, const char *key, char *value,
  */
 xplrNvs_error_t xplrNvsReadStringHex(xplrNvs_t *nvs, const char *key, char *value, size_t *size);
 
+/**
+ * @brief Read binary data from namespace key.
+ *
+ * @param  nvs    driver struct to perform read.
+ * @param  key    keyname value to read.
+ * @param  value  pointer to buffer to store key value.
+ * @param  size   pointer to size_t holding buffer size, updated with the stored length.
+ * @return        XPLR_NVS_OK on success, XPLR_NVS_ERROR otherwise.
+ */
+xplrNvs_error_t xplrNvsReadBlob(xplrNvs_t *nvs, const char *key, void *value, size_t *size);
+
 /**
  * @brief Write unsigned byte to namespace key.
  *
@@ -307,6 +318,17 @@ xplrNvs_error_t xplrNvsWriteString(xplrNvs_t *nvs, const char *key, const char *
  */
 xplrNvs_error_t xplrNvsWriteStringHex(xplrNvs_t *nvs, const char *key, const char *value);
 
+/**
+ * @brief Write binary data to namespace key.
+ *
+ * @param  nvs    driver struct to perform write.
+ * @param  key    keyname value to write.
+ * @param  value  pointer to data to write.
+ * @param  size   length of data in bytes.
+ * @return        XPLR_NVS_OK on success, XPLR_NVS_ERROR otherwise.
+ */
+xplrNvs_error_t xplrNvsWriteBlob(xplrNvs_t *nvs, const char *key, const void *value, size_t size);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
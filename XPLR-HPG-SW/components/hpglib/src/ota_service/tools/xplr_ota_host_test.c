@@ -0,0 +1,509 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of the OTA streaming writer and verifier (xplr_ota_stream.c)
+ * against a file backed fake NOR flash.
+ *
+ * Build on Linux (mbedtls 2.28 or 3.x development files):
+ *   gcc -O1 -g -fsanitize=address,undefined -I.. \
+ *       xplr_ota_host_test.c ../xplr_ota_stream.c -lmbedcrypto -o xplr_ota_host_test
+ *
+ * Usage:
+ *   xplr_ota_host_test [seed]                  run all cases, exit code 0 when they pass
+ *   xplr_ota_host_test verify <image> <pem>    stream an image made by xplr_ota_pack.py
+ *
+ * The fake flash only accepts sector aligned erases and 16 byte aligned writes,
+ * and like NOR flash a write can only clear bits, so a missing erase shows up
+ * as a read back error.
+ */
+
+#include "xplr_ota_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/version.h"
+
+#define FLASH_SIZE          (64U * XPLR_OTA_SECTOR_SIZE)
+#define PEM_SIZE            (256U)
+#define NO_FLIP             (0xFFFFFFFFU)
+
+typedef struct {
+    FILE        *file;
+    uint32_t    flipOffset;     /* bit flipped when this byte is written */
+    unsigned    erases;
+    unsigned    writes;
+} fakeFlash_t;
+
+typedef struct {
+    mbedtls_pk_context          pk;
+    unsigned char               pem[PEM_SIZE];
+    size_t                      pemLen;
+} testKey_t;
+
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+static xplrOtaStream_t stream;      /* 4 KB sector buffer, as on target */
+static unsigned failures;
+
+/* ----------------------------------------------------------------
+ * fake flash
+ * -------------------------------------------------------------- */
+
+static int flashErase(void *ctx, uint32_t offset, uint32_t size)
+{
+    fakeFlash_t *flash = ctx;
+    uint8_t erased[XPLR_OTA_SECTOR_SIZE];
+
+    if (((offset % XPLR_OTA_SECTOR_SIZE) != 0) || ((size % XPLR_OTA_SECTOR_SIZE) != 0) ||
+        (offset + size > FLASH_SIZE)) {
+        fprintf(stderr, "  flash: bad erase 0x%x+0x%x\n", offset, size);
+        return -1;
+    }
+    memset(erased, 0xFF, sizeof(erased));
+    fseek(flash->file, offset, SEEK_SET);
+    for (uint32_t done = 0; done < size; done += XPLR_OTA_SECTOR_SIZE) {
+        fwrite(erased, 1, sizeof(erased), flash->file);
+    }
+    flash->erases++;
+    return 0;
+}
+
+static int flashWrite(void *ctx, uint32_t offset, const void *data, uint32_t size)
+{
+    fakeFlash_t *flash = ctx;
+    const uint8_t *bytes = data;
+    uint8_t cell[XPLR_OTA_SECTOR_SIZE];
+
+    if (((offset % XPLR_OTA_WRITE_ALIGN) != 0) || ((size % XPLR_OTA_WRITE_ALIGN) != 0) ||
+        (size > sizeof(cell)) || (offset + size > FLASH_SIZE)) {
+        fprintf(stderr, "  flash: bad write 0x%x+0x%x\n", offset, size);
+        return -1;
+    }
+    fseek(flash->file, offset, SEEK_SET);
+    if (fread(cell, 1, size, flash->file) != size) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        cell[i] &= bytes[i];
+        if (offset + i == flash->flipOffset) {
+            cell[i] ^= 0x10;
+        }
+    }
+    fseek(flash->file, offset, SEEK_SET);
+    fwrite(cell, 1, size, flash->file);
+    flash->writes++;
+    return 0;
+}
+
+static int flashRead(void *ctx, uint32_t offset, void *data, uint32_t size)
+{
+    fakeFlash_t *flash = ctx;
+
+    if (offset + size > FLASH_SIZE) {
+        return -1;
+    }
+    fseek(flash->file, offset, SEEK_SET);
+    return (fread(data, 1, size, flash->file) == size) ? 0 : -1;
+}
+
+static void flashOpen(fakeFlash_t *fake, xplrOtaFlash_t *flash)
+{
+    static uint8_t junk[FLASH_SIZE];
+
+    memset(fake, 0x00, sizeof(fakeFlash_t));
+    fake->file = tmpfile();
+    fake->flipOffset = NO_FLIP;
+    if (fake->file == NULL) {
+        perror("tmpfile");
+        exit(2);
+    }
+    /* leftovers of a previous image, so that a missing erase is noticed */
+    for (uint32_t i = 0; i < FLASH_SIZE; i++) {
+        junk[i] = (uint8_t)rand();
+    }
+    fwrite(junk, 1, sizeof(junk), fake->file);
+
+    flash->erase = flashErase;
+    flash->write = flashWrite;
+    flash->read = flashRead;
+    flash->ctx = fake;
+    flash->size = FLASH_SIZE;
+}
+
+/* ----------------------------------------------------------------
+ * images
+ * -------------------------------------------------------------- */
+
+static void keyGenerate(testKey_t *key)
+{
+    int err;
+
+    mbedtls_pk_init(&key->pk);
+    err = mbedtls_pk_setup(&key->pk, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    if (err == 0) {
+        err = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(key->pk),
+                                  mbedtls_ctr_drbg_random, &drbg);
+    }
+    if (err == 0) {
+        err = mbedtls_pk_write_pubkey_pem(&key->pk, key->pem, sizeof(key->pem));
+    }
+    if (err != 0) {
+        fprintf(stderr, "key generation failed: -0x%04x\n", -err);
+        exit(2);
+    }
+    key->pemLen = strlen((char *)key->pem) + 1;
+}
+
+static void put16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+}
+
+static void put32(uint8_t *buf, uint32_t value)
+{
+    put16(&buf[0], value & 0xFFFF);
+    put16(&buf[2], value >> 16);
+}
+
+/* Header followed by a random binary of binSize bytes, signed with key. */
+static uint8_t *imageBuild(testKey_t *key, uint32_t binSize, size_t *imageLen)
+{
+    uint8_t *image = calloc(1, XPLR_OTA_HEADER_SIZE + binSize);
+    uint8_t *bin = &image[XPLR_OTA_HEADER_SIZE];
+    uint8_t sig[MBEDTLS_PK_SIGNATURE_MAX_SIZE];
+    size_t sigLen = 0;
+    int err;
+
+    for (uint32_t i = 0; i < binSize; i++) {
+        bin[i] = (uint8_t)rand();
+    }
+    put32(&image[0], XPLR_OTA_MAGIC);
+    put16(&image[4], XPLR_OTA_HEADER_SIZE);
+    put32(&image[8], binSize);
+#if (MBEDTLS_VERSION_MAJOR < 3)
+    mbedtls_sha256_ret(bin, binSize, &image[16], 0);
+    err = mbedtls_pk_sign(&key->pk, MBEDTLS_MD_SHA256, &image[16], XPLR_OTA_DIGEST_SIZE,
+                          sig, &sigLen, mbedtls_ctr_drbg_random, &drbg);
+#else
+    mbedtls_sha256(bin, binSize, &image[16], 0);
+    err = mbedtls_pk_sign(&key->pk, MBEDTLS_MD_SHA256, &image[16], XPLR_OTA_DIGEST_SIZE,
+                          sig, sizeof(sig), &sigLen, mbedtls_ctr_drbg_random, &drbg);
+#endif
+    if ((err != 0) || (sigLen > XPLR_OTA_SIGNATURE_MAX)) {
+        fprintf(stderr, "signing failed: -0x%04x\n", -err);
+        exit(2);
+    }
+    put16(&image[48], (uint16_t)sigLen);
+    memcpy(&image[52], sig, sigLen);
+
+    *imageLen = XPLR_OTA_HEADER_SIZE + binSize;
+    return image;
+}
+
+/* Stream image in chunks of 1 to maxChunk bytes (0: all at once), then finish. */
+static xplrOtaStreamError_t imageStream(xplrOtaFlash_t *flash,
+                                        const testKey_t *key,
+                                        const uint8_t *image,
+                                        size_t imageLen,
+                                        size_t maxChunk)
+{
+    xplrOtaStreamError_t ret;
+    size_t offset = 0;
+    size_t chunk;
+
+    ret = xplrOtaStreamBegin(&stream, flash, key->pem, key->pemLen);
+    while ((ret == XPLR_OTA_STREAM_OK) && (offset < imageLen)) {
+        chunk = (maxChunk == 0) ? imageLen : 1 + ((size_t)rand() % maxChunk);
+        chunk = (chunk < imageLen - offset) ? chunk : imageLen - offset;
+        ret = xplrOtaStreamWrite(&stream, &image[offset], chunk);
+        offset += chunk;
+    }
+    if (ret == XPLR_OTA_STREAM_OK) {
+        ret = xplrOtaStreamFinish(&stream);
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * cases
+ * -------------------------------------------------------------- */
+
+static void expect(const char *name, xplrOtaStreamError_t got, xplrOtaStreamError_t want)
+{
+    if (got != want) {
+        failures++;
+    }
+    printf("%-44s %s (%d)\n", name, (got == want) ? "ok" : "FAILED", got);
+}
+
+/* A good image must be accepted and be in flash byte for byte. */
+static void caseGood(const char *name, testKey_t *key, uint32_t binSize, size_t maxChunk)
+{
+    fakeFlash_t fake;
+    xplrOtaFlash_t flash;
+    xplrOtaStreamError_t ret;
+    uint8_t *image;
+    uint8_t *stored;
+    size_t imageLen;
+
+    flashOpen(&fake, &flash);
+    image = imageBuild(key, binSize, &imageLen);
+    ret = imageStream(&flash, key, image, imageLen, maxChunk);
+    if (ret == XPLR_OTA_STREAM_OK) {
+        stored = malloc(binSize);
+        if ((flashRead(&fake, 0, stored, binSize) != 0) ||
+            (memcmp(stored, &image[XPLR_OTA_HEADER_SIZE], binSize) != 0) ||
+            (stream.state != XPLR_OTA_STREAM_STATE_DONE) ||
+            (fake.erases != (binSize + XPLR_OTA_SECTOR_SIZE - 1) / XPLR_OTA_SECTOR_SIZE)) {
+            ret = XPLR_OTA_STREAM_ERROR;
+        }
+        free(stored);
+    }
+    expect(name, ret, XPLR_OTA_STREAM_OK);
+
+    free(image);
+    fclose(fake.file);
+}
+
+typedef enum {
+    MUTATE_BINARY,
+    MUTATE_DIGEST,
+    MUTATE_SIGNATURE,
+    MUTATE_MAGIC,
+    MUTATE_SIG_LEN,
+    MUTATE_OVERSIZE,
+    MUTATE_TRUNCATE,
+    MUTATE_EXTEND,
+    MUTATE_FLASH_FLIP,
+    MUTATE_OTHER_KEY
+} mutation_t;
+
+static void caseBad(const char *name,
+                    testKey_t *key,
+                    testKey_t *otherKey,
+                    mutation_t mutation,
+                    xplrOtaStreamError_t want)
+{
+    const uint32_t binSize = 3 * XPLR_OTA_SECTOR_SIZE + 517;
+    fakeFlash_t fake;
+    xplrOtaFlash_t flash;
+    testKey_t *verifyKey = key;
+    xplrOtaStreamError_t ret;
+    uint8_t *image;
+    size_t imageLen;
+
+    flashOpen(&fake, &flash);
+    image = imageBuild(key, binSize, &imageLen);
+    switch (mutation) {
+        case MUTATE_BINARY:
+            image[XPLR_OTA_HEADER_SIZE + (size_t)rand() % binSize] ^= 0x01;
+            break;
+        case MUTATE_DIGEST:
+            image[16 + (size_t)rand() % XPLR_OTA_DIGEST_SIZE] ^= 0x80;
+            break;
+        case MUTATE_SIGNATURE:
+            image[52 + 10] ^= 0x04;
+            break;
+        case MUTATE_MAGIC:
+            image[0] = 'Y';
+            break;
+        case MUTATE_SIG_LEN:
+            put16(&image[48], XPLR_OTA_SIGNATURE_MAX + 1);
+            break;
+        case MUTATE_OVERSIZE:
+            put32(&image[8], FLASH_SIZE + 1);
+            break;
+        case MUTATE_TRUNCATE:
+            imageLen -= 1;
+            break;
+        case MUTATE_EXTEND:
+            image = realloc(image, imageLen + 1);
+            image[imageLen++] = 0x00;
+            break;
+        case MUTATE_FLASH_FLIP:
+            fake.flipOffset = 2 * XPLR_OTA_SECTOR_SIZE + 100;
+            break;
+        case MUTATE_OTHER_KEY:
+            verifyKey = otherKey;
+            break;
+    }
+    ret = imageStream(&flash, verifyKey, image, imageLen, 700);
+    if ((ret != XPLR_OTA_STREAM_OK) && (stream.state != XPLR_OTA_STREAM_STATE_FAILED)) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    }
+    expect(name, ret, want);
+
+    free(image);
+    fclose(fake.file);
+}
+
+/* Writes after a failure, finish twice, abort. */
+static void caseStates(testKey_t *key)
+{
+    fakeFlash_t fake;
+    xplrOtaFlash_t flash;
+    uint8_t *image;
+    size_t imageLen;
+    xplrOtaStreamError_t ret;
+
+    flashOpen(&fake, &flash);
+    image = imageBuild(key, 1000, &imageLen);
+
+    ret = imageStream(&flash, key, image, imageLen, 0);
+    expect("finish twice", (ret == XPLR_OTA_STREAM_OK) ? xplrOtaStreamFinish(&stream) : ret,
+           XPLR_OTA_STREAM_ERROR_STATE);
+
+    (void)xplrOtaStreamBegin(&stream, &flash, key->pem, key->pemLen);
+    (void)xplrOtaStreamWrite(&stream, image, 200);
+    xplrOtaStreamAbort(&stream);
+    expect("write after abort", xplrOtaStreamWrite(&stream, &image[200], 10),
+           XPLR_OTA_STREAM_ERROR_STATE);
+
+    (void)xplrOtaStreamBegin(&stream, &flash, key->pem, key->pemLen);
+    expect("finish without header", xplrOtaStreamFinish(&stream), XPLR_OTA_STREAM_ERROR_SIZE);
+
+    expect("begin with a bad key",
+           xplrOtaStreamBegin(&stream, &flash, (const uint8_t *)"not a key", 10),
+           XPLR_OTA_STREAM_ERROR);
+
+    ret = imageStream(&flash, key, image, imageLen, 1);
+    expect("byte by byte after failures", ret, XPLR_OTA_STREAM_OK);
+
+    free(image);
+    fclose(fake.file);
+}
+
+static int runAll(void)
+{
+    testKey_t key;
+    testKey_t otherKey;
+    char name[64];
+
+    keyGenerate(&key);
+    keyGenerate(&otherKey);
+
+    caseGood("1 byte binary", &key, 1, 0);
+    caseGood("15 byte binary, chunks of 1-3", &key, 15, 3);
+    caseGood("one sector", &key, XPLR_OTA_SECTOR_SIZE, 0);
+    caseGood("one sector and a byte", &key, XPLR_OTA_SECTOR_SIZE + 1, 0);
+    caseGood("whole flash", &key, FLASH_SIZE, 0);
+    for (int i = 0; i < 8; i++) {
+        uint32_t size = 1 + ((uint32_t)rand() % (20 * XPLR_OTA_SECTOR_SIZE));
+        size_t maxChunk = 1 + ((size_t)rand() % 5000);
+        snprintf(name, sizeof(name), "%u bytes, chunks of 1-%zu", size, maxChunk);
+        caseGood(name, &key, size, maxChunk);
+    }
+
+    caseBad("binary bit flipped", &key, &otherKey, MUTATE_BINARY, XPLR_OTA_STREAM_ERROR_DIGEST);
+    caseBad("header digest changed", &key, &otherKey, MUTATE_DIGEST, XPLR_OTA_STREAM_ERROR_DIGEST);
+    caseBad("signature changed", &key, &otherKey, MUTATE_SIGNATURE,
+            XPLR_OTA_STREAM_ERROR_SIGNATURE);
+    caseBad("signed with another key", &key, &otherKey, MUTATE_OTHER_KEY,
+            XPLR_OTA_STREAM_ERROR_SIGNATURE);
+    caseBad("bad magic", &key, &otherKey, MUTATE_MAGIC, XPLR_OTA_STREAM_ERROR_HEADER);
+    caseBad("signature too long", &key, &otherKey, MUTATE_SIG_LEN, XPLR_OTA_STREAM_ERROR_HEADER);
+    caseBad("larger than the partition", &key, &otherKey, MUTATE_OVERSIZE,
+            XPLR_OTA_STREAM_ERROR_SIZE);
+    caseBad("last byte missing", &key, &otherKey, MUTATE_TRUNCATE, XPLR_OTA_STREAM_ERROR_SIZE);
+    caseBad("one byte too many", &key, &otherKey, MUTATE_EXTEND, XPLR_OTA_STREAM_ERROR_SIZE);
+    caseBad("flash bit flip", &key, &otherKey, MUTATE_FLASH_FLIP,
+            XPLR_OTA_STREAM_ERROR_READBACK);
+
+    caseStates(&key);
+
+    mbedtls_pk_free(&key.pk);
+    mbedtls_pk_free(&otherKey.pk);
+    printf("%s: %u failure(s)\n", (failures == 0) ? "PASS" : "FAIL", failures);
+    return (failures == 0) ? 0 : 1;
+}
+
+/* Stream a packed image file into the fake flash. */
+static int verifyFile(const char *imagePath, const char *pemPath)
+{
+    fakeFlash_t fake;
+    xplrOtaFlash_t flash;
+    testKey_t key;
+    uint8_t buf[1000];
+    xplrOtaStreamError_t ret;
+    FILE *file;
+    size_t len;
+
+    file = fopen(pemPath, "rb");
+    if (file == NULL) {
+        perror(pemPath);
+        return 2;
+    }
+    key.pemLen = fread(key.pem, 1, sizeof(key.pem) - 1, file);
+    key.pem[key.pemLen++] = 0;
+    fclose(file);
+
+    file = fopen(imagePath, "rb");
+    if (file == NULL) {
+        perror(imagePath);
+        return 2;
+    }
+    flashOpen(&fake, &flash);
+    ret = xplrOtaStreamBegin(&stream, &flash, key.pem, key.pemLen);
+    while ((ret == XPLR_OTA_STREAM_OK) && ((len = fread(buf, 1, sizeof(buf), file)) > 0)) {
+        ret = xplrOtaStreamWrite(&stream, buf, len);
+    }
+    if (ret == XPLR_OTA_STREAM_OK) {
+        ret = xplrOtaStreamFinish(&stream);
+    }
+    fclose(file);
+    fclose(fake.file);
+
+    printf("%s: %s (%d), %u byte binary\n", imagePath,
+           (ret == XPLR_OTA_STREAM_OK) ? "valid" : "rejected", ret, stream.header.imageSize);
+    return (ret == XPLR_OTA_STREAM_OK) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned seed = (unsigned)time(NULL);
+    int ret;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) != 0) {
+        fprintf(stderr, "drbg seed failed\n");
+        return 2;
+    }
+
+    if ((argc == 4) && (strcmp(argv[1], "verify") == 0)) {
+        ret = verifyFile(argv[2], argv[3]);
+    } else if (argc <= 2) {
+        seed = (argc == 2) ? (unsigned)strtoul(argv[1], NULL, 0) : seed;
+        printf("seed %u\n", seed);
+        srand(seed);
+        ret = runAll();
+    } else {
+        fprintf(stderr, "usage: %s [seed] | verify <image> <public key pem>\n", argv[0]);
+        ret = 2;
+    }
+
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    return ret;
+}
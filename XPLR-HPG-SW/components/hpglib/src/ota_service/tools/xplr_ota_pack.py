@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+#
+# Copyright 2023 u-blox
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Pack an application binary into a signed image accepted by the ota_service.
+
+The image is the 128 byte header described in xplr_ota_stream.h followed by
+the binary. The ECDSA P-256 signature of the binary SHA-256 digest is made by
+the openssl command line tool, so the private key never has to be loaded here.
+
+Create a key pair once, and build the public one into the firmware:
+    openssl ecparam -name prime256v1 -genkey -noout -out ota_key.pem
+    openssl ec -in ota_key.pem -pubout -out ota_key_pub.pem
+"""
+
+import argparse
+import hashlib
+import struct
+import subprocess
+
+MAGIC = b"XOTA"
+HEADER_SIZE = 128
+SIGNATURE_MAX = 72
+
+
+def sign(binary_path, key_path, openssl):
+    result = subprocess.run([openssl, "dgst", "-sha256", "-sign", key_path, "-binary", binary_path],
+                            check=True, stdout=subprocess.PIPE)
+    return result.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary", help="application binary, e.g. build/<project>.bin")
+    parser.add_argument("key", help="ECDSA P-256 private key, PEM")
+    parser.add_argument("image", help="signed image to write")
+    parser.add_argument("--openssl", default="openssl", help="openssl executable")
+    args = parser.parse_args()
+
+    with open(args.binary, "rb") as src:
+        binary = src.read()
+    if not binary:
+        parser.error("empty binary")
+
+    digest = hashlib.sha256(binary).digest()
+    signature = sign(args.binary, args.key, args.openssl)
+    if len(signature) > SIGNATURE_MAX:
+        parser.error("signature of %d bytes, is the key ECDSA P-256?" % len(signature))
+
+    header = struct.pack("<4sHHII32sHH", MAGIC, HEADER_SIZE, 0, len(binary), 0,
+                         digest, len(signature), 0)
+    header += signature.ljust(SIGNATURE_MAX, b"\x00")
+    header = header.ljust(HEADER_SIZE, b"\x00")
+
+    with open(args.image, "wb") as dst:
+        dst.write(header)
+        dst.write(binary)
+
+    print("%s: %d byte binary, sha256 %s" % (args.image, len(binary), digest.hex()))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,459 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "xplr_ota.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "./../../xplr_hpglib_cfg.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#if (1 == XPLROTA_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED) && ((0 == XPLR_HPGLIB_LOG_ENABLED) || (0 == XPLROTA_LOG_ACTIVE))
+#define XPLROTA_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_PRINT_ONLY, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgOta", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#elif (1 == XPLROTA_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED) && (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLROTA_LOG_ACTIVE)
+#define XPLROTA_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_SD_AND_PRINT, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgOta", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#elif ((0 == XPLROTA_DEBUG_ACTIVE) || (0 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)) && (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLROTA_LOG_ACTIVE)
+#define XPLROTA_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_SD_ONLY, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgOta", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#else
+#define XPLROTA_CONSOLE(message, ...) do{} while(0)
+#endif
+
+/* Chunk read from an image file per write */
+#define OTA_FILE_CHUNK_SIZE         (1024U)
+
+/* ----------------------------------------------------------------
+ * STATIC TYPES
+ * -------------------------------------------------------------- */
+
+typedef struct xplrOta_type {
+    const char              *publicKey;
+    const esp_partition_t   *partition;     /**< partition being written */
+    xplrOtaFlash_t          flash;
+    SemaphoreHandle_t       mutex;
+    esp_timer_handle_t      confirmTimer;
+    esp_timer_handle_t      restartTimer;
+    bool                    active;
+    xplrOtaStreamError_t    lastError;
+} xplrOta_t;
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+static xplrOta_t ota;
+static xplrOtaStream_t otaStream;
+static uint8_t fileChunk[OTA_FILE_CHUNK_SIZE];
+static int8_t logIndex = -1;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static int otaPartitionErase(void *ctx, uint32_t offset, uint32_t size);
+static int otaPartitionWrite(void *ctx, uint32_t offset, const void *data, uint32_t size);
+static int otaPartitionRead(void *ctx, uint32_t offset, void *data, uint32_t size);
+static void otaConfirmTimerCb(void *arg);
+static void otaRestartTimerCb(void *arg);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+xplrOta_error_t xplrOtaInit(const char *publicKeyPem)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    esp_err_t espRet;
+    xplrOta_error_t ret;
+
+    if (publicKeyPem == NULL) {
+        XPLROTA_CONSOLE(E, "No public key");
+        ret = XPLR_OTA_ERROR;
+    } else {
+        ota.publicKey = publicKeyPem;
+        if (ota.mutex == NULL) {
+            ota.mutex = xSemaphoreCreateMutex();
+        }
+
+        if (ota.mutex == NULL) {
+            XPLROTA_CONSOLE(E, "Could not create mutex");
+            ret = XPLR_OTA_ERROR;
+        } else if ((esp_ota_get_state_partition(running, &state) == ESP_OK) &&
+                   (state == ESP_OTA_IMG_PENDING_VERIFY)) {
+            /* first boot of an update, roll back if it is not confirmed in time */
+            const esp_timer_create_args_t timerArgs = {
+                .callback = &otaConfirmTimerCb,
+                .name = "otaConfirm"
+            };
+            espRet = esp_timer_create(&timerArgs, &ota.confirmTimer);
+            if (espRet == ESP_OK) {
+                espRet = esp_timer_start_once(ota.confirmTimer,
+                                              (uint64_t)XPLROTA_CONFIRM_TIMEOUT_S * 1000000ULL);
+            }
+            if (espRet != ESP_OK) {
+                XPLROTA_CONSOLE(E, "Could not start confirm timer (%s)", esp_err_to_name(espRet));
+                ret = XPLR_OTA_ERROR;
+            } else {
+                XPLROTA_CONSOLE(W,
+                                "Running new firmware from <%s>, rolled back unless confirmed within %us",
+                                running->label,
+                                XPLROTA_CONFIRM_TIMEOUT_S);
+                ret = XPLR_OTA_OK;
+            }
+        } else {
+            XPLROTA_CONSOLE(D, "Running firmware from <%s>", running->label);
+            ret = XPLR_OTA_OK;
+        }
+    }
+
+    return ret;
+}
+
+bool xplrOtaIsInit(void)
+{
+    return (ota.mutex != NULL) && (ota.publicKey != NULL);
+}
+
+xplrOta_error_t xplrOtaConfirm(void)
+{
+    esp_err_t espRet;
+    xplrOta_error_t ret;
+
+    if (ota.confirmTimer == NULL) {
+        /* nothing pending */
+        ret = XPLR_OTA_OK;
+    } else {
+        espRet = esp_ota_mark_app_valid_cancel_rollback();
+        if (espRet != ESP_OK) {
+            XPLROTA_CONSOLE(E, "Could not confirm firmware (%s)", esp_err_to_name(espRet));
+            ret = XPLR_OTA_ERROR;
+        } else {
+            (void)esp_timer_stop(ota.confirmTimer);
+            (void)esp_timer_delete(ota.confirmTimer);
+            ota.confirmTimer = NULL;
+            XPLROTA_CONSOLE(I, "Firmware confirmed, rollback cancelled");
+            ret = XPLR_OTA_OK;
+        }
+    }
+
+    return ret;
+}
+
+xplrOta_error_t xplrOtaBegin(void)
+{
+    xplrOtaStreamError_t streamRet;
+    xplrOta_error_t ret;
+
+    if (!xplrOtaIsInit()) {
+        XPLROTA_CONSOLE(E, "Not initialized");
+        ret = XPLR_OTA_NOT_INIT;
+    } else if (xSemaphoreTake(ota.mutex, portMAX_DELAY) != pdTRUE) {
+        ret = XPLR_OTA_ERROR;
+    } else {
+        if (ota.active) {
+            XPLROTA_CONSOLE(W, "Update already in progress");
+            ret = XPLR_OTA_BUSY;
+        } else {
+            ota.partition = esp_ota_get_next_update_partition(NULL);
+            if (ota.partition == NULL) {
+                XPLROTA_CONSOLE(E, "No OTA partition to write to");
+                ret = XPLR_OTA_ERROR;
+            } else {
+                ota.flash.erase = otaPartitionErase;
+                ota.flash.write = otaPartitionWrite;
+                ota.flash.read = otaPartitionRead;
+                ota.flash.ctx = (void *)ota.partition;
+                ota.flash.size = ota.partition->size;
+                streamRet = xplrOtaStreamBegin(&otaStream,
+                                               &ota.flash,
+                                               (const uint8_t *)ota.publicKey,
+                                               strlen(ota.publicKey) + 1);
+                ota.lastError = streamRet;
+                if (streamRet != XPLR_OTA_STREAM_OK) {
+                    XPLROTA_CONSOLE(E, "Invalid public key");
+                    ret = XPLR_OTA_ERROR;
+                } else {
+                    ota.active = true;
+                    XPLROTA_CONSOLE(I,
+                                    "Update started, writing to <%s> (%u bytes)",
+                                    ota.partition->label,
+                                    ota.partition->size);
+                    ret = XPLR_OTA_OK;
+                }
+            }
+        }
+        xSemaphoreGive(ota.mutex);
+    }
+
+    return ret;
+}
+
+xplrOta_error_t xplrOtaWrite(const void *data, size_t len)
+{
+    xplrOtaStreamError_t streamRet;
+    xplrOta_error_t ret;
+
+    if ((ota.mutex == NULL) || (xSemaphoreTake(ota.mutex, portMAX_DELAY) != pdTRUE)) {
+        ret = XPLR_OTA_ERROR;
+    } else {
+        if (!ota.active) {
+            XPLROTA_CONSOLE(E, "No update in progress");
+            ret = XPLR_OTA_ERROR;
+        } else {
+            streamRet = xplrOtaStreamWrite(&otaStream, data, len);
+            ota.lastError = streamRet;
+            if (streamRet != XPLR_OTA_STREAM_OK) {
+                XPLROTA_CONSOLE(E,
+                                "Image rejected (%d) after %u bytes",
+                                streamRet,
+                                otaStream.received);
+                ota.active = false;
+                ret = XPLR_OTA_ERROR;
+            } else {
+                ret = XPLR_OTA_OK;
+            }
+        }
+        xSemaphoreGive(ota.mutex);
+    }
+
+    return ret;
+}
+
+xplrOta_error_t xplrOtaEnd(void)
+{
+    xplrOtaStreamError_t streamRet;
+    esp_err_t espRet;
+    xplrOta_error_t ret;
+
+    if ((ota.mutex == NULL) || (xSemaphoreTake(ota.mutex, portMAX_DELAY) != pdTRUE)) {
+        ret = XPLR_OTA_ERROR;
+    } else {
+        if (!ota.active) {
+            XPLROTA_CONSOLE(E, "No update in progress");
+            ret = XPLR_OTA_ERROR;
+        } else {
+            ota.active = false;
+            streamRet = xplrOtaStreamFinish(&otaStream);
+            ota.lastError = streamRet;
+            if (streamRet != XPLR_OTA_STREAM_OK) {
+                XPLROTA_CONSOLE(E, "Image verification failed (%d)", streamRet);
+                ret = XPLR_OTA_ERROR;
+            } else {
+                /* also checks the app image format before switching */
+                espRet = esp_ota_set_boot_partition(ota.partition);
+                if (espRet != ESP_OK) {
+                    XPLROTA_CONSOLE(E,
+                                    "Could not boot from <%s> (%s)",
+                                    ota.partition->label,
+                                    esp_err_to_name(espRet));
+                    ret = XPLR_OTA_ERROR;
+                } else {
+                    XPLROTA_CONSOLE(I,
+                                    "Image of %u bytes verified, <%s> boots next",
+                                    otaStream.header.imageSize,
+                                    ota.partition->label);
+                    ret = XPLR_OTA_OK;
+                }
+            }
+        }
+        xSemaphoreGive(ota.mutex);
+    }
+
+    return ret;
+}
+
+void xplrOtaAbort(void)
+{
+    if ((ota.mutex != NULL) && (xSemaphoreTake(ota.mutex, portMAX_DELAY) == pdTRUE)) {
+        if (ota.active) {
+            xplrOtaStreamAbort(&otaStream);
+            ota.active = false;
+            XPLROTA_CONSOLE(W, "Update aborted after %u bytes", otaStream.received);
+        }
+        xSemaphoreGive(ota.mutex);
+    }
+}
+
+xplrOta_error_t xplrOtaWriteFile(const char *path)
+{
+    FILE *file;
+    size_t len;
+    xplrOta_error_t ret;
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        XPLROTA_CONSOLE(E, "Could not open <%s>", path);
+        ret = XPLR_OTA_ERROR;
+    } else {
+        ret = xplrOtaBegin();
+        /* fileChunk is only used here, a second caller gets busy from xplrOtaBegin */
+        while (ret == XPLR_OTA_OK) {
+            len = fread(fileChunk, 1, sizeof(fileChunk), file);
+            if (len == 0) {
+                break;
+            }
+            ret = xplrOtaWrite(fileChunk, len);
+        }
+
+        if (ret == XPLR_OTA_OK) {
+            if (ferror(file) != 0) {
+                XPLROTA_CONSOLE(E, "Could not read <%s>", path);
+                xplrOtaAbort();
+                ret = XPLR_OTA_ERROR;
+            } else {
+                ret = xplrOtaEnd();
+            }
+        }
+        fclose(file);
+    }
+
+    return ret;
+}
+
+xplrOta_error_t xplrOtaRestart(uint32_t delayMs)
+{
+    esp_err_t espRet = ESP_OK;
+    xplrOta_error_t ret;
+
+    if (ota.restartTimer == NULL) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = &otaRestartTimerCb,
+            .name = "otaRestart"
+        };
+        espRet = esp_timer_create(&timerArgs, &ota.restartTimer);
+    }
+    if (espRet == ESP_OK) {
+        (void)esp_timer_stop(ota.restartTimer);
+        espRet = esp_timer_start_once(ota.restartTimer, (uint64_t)delayMs * 1000ULL);
+    }
+
+    if (espRet != ESP_OK) {
+        XPLROTA_CONSOLE(E, "Could not schedule restart (%s)", esp_err_to_name(espRet));
+        ret = XPLR_OTA_ERROR;
+    } else {
+        XPLROTA_CONSOLE(I, "Restarting in %ums", delayMs);
+        ret = XPLR_OTA_OK;
+    }
+
+    return ret;
+}
+
+void xplrOtaGetProgress(xplrOtaProgress_t *progress)
+{
+    if ((progress != NULL) && (ota.mutex != NULL) &&
+        (xSemaphoreTake(ota.mutex, portMAX_DELAY) == pdTRUE)) {
+        progress->active = ota.active;
+        progress->received = otaStream.received;
+        progress->imageSize = (otaStream.state >= XPLR_OTA_STREAM_STATE_BINARY) ?
+                              otaStream.header.imageSize : 0;
+        progress->lastError = ota.lastError;
+        xSemaphoreGive(ota.mutex);
+    } else if (progress != NULL) {
+        memset(progress, 0x00, sizeof(xplrOtaProgress_t));
+        progress->lastError = XPLR_OTA_STREAM_OK;
+    } else {
+        // do nothing
+    }
+}
+
+int8_t xplrOtaInitLogModule(xplr_cfg_logInstance_t *logCfg)
+{
+    int8_t ret;
+    xplrLog_error_t logErr;
+
+    if (logIndex < 0) {
+        /* logIndex is negative so logging has not been initialized before */
+        if (logCfg == NULL) {
+            /* logCfg is NULL so we will use the default module settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   XPLR_OTA_DEFAULT_FILENAME,
+                                   XPLRLOG_FILE_SIZE_INTERVAL,
+                                   XPLRLOG_NEW_FILE_ON_BOOT);
+        } else {
+            /* logCfg contains the instance settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   logCfg->filename,
+                                   logCfg->sizeInterval,
+                                   logCfg->erasePrev);
+        }
+        ret = logIndex;
+    } else {
+        /* logIndex is positive so logging has been initialized before */
+        logErr = xplrLogEnable(logIndex);
+        if (logErr != XPLR_LOG_OK) {
+            ret = -1;
+        } else {
+            ret = logIndex;
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t xplrOtaStopLogModule(void)
+{
+    esp_err_t ret;
+    xplrLog_error_t logErr;
+
+    logErr = xplrLogDisable(logIndex);
+    if (logErr != XPLR_LOG_OK) {
+        ret = ESP_FAIL;
+    } else {
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static int otaPartitionErase(void *ctx, uint32_t offset, uint32_t size)
+{
+    return (esp_partition_erase_range((const esp_partition_t *)ctx, offset, size) == ESP_OK) ? 0 : -1;
+}
+
+static int otaPartitionWrite(void *ctx, uint32_t offset, const void *data, uint32_t size)
+{
+    return (esp_partition_write((const esp_partition_t *)ctx, offset, data, size) == ESP_OK) ? 0 : -1;
+}
+
+static int otaPartitionRead(void *ctx, uint32_t offset, void *data, uint32_t size)
+{
+    return (esp_partition_read((const esp_partition_t *)ctx, offset, data, size) == ESP_OK) ? 0 : -1;
+}
+
+static void otaConfirmTimerCb(void *arg)
+{
+    (void)arg;
+    XPLROTA_CONSOLE(E, "Firmware not confirmed in time, rolling back");
+    (void)esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+
+static void otaRestartTimerCb(void *arg)
+{
+    (void)arg;
+    esp_restart();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_OTA_H_
+#define _XPLR_OTA_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "xplr_ota_stream.h"
+#include "./../log_service/xplr_log.h"
+#include "./../common/xplr_common.h"
+
+/** @file
+ * @brief Firmware update over any transport. A signed image (see xplr_ota_stream.h)
+ * is written to the inactive OTA partition while it is received, verified, and
+ * made the boot partition. The bootloader rolls back to the previous firmware
+ * when the new one does not confirm itself with xplrOtaConfirm().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * PUBLIC TYPES
+ * -------------------------------------------------------------- */
+
+/** Error codes specific to xplr_ota module. */
+typedef enum {
+    XPLR_OTA_NOT_INIT = -3, /**< xplrOtaInit() was not called or failed. */
+    XPLR_OTA_BUSY,          /**< another update is in progress. */
+    XPLR_OTA_ERROR,         /**< process returned with errors. */
+    XPLR_OTA_OK             /**< indicates success of returning process. */
+} xplrOta_error_t;
+
+/** Progress of the current or last update. */
+typedef struct xplrOtaProgress_type {
+    bool                    active;         /**< an update is in progress. */
+    uint32_t                received;       /**< binary bytes received. */
+    uint32_t                imageSize;      /**< binary size announced by the image header, 0 until received. */
+    xplrOtaStreamError_t    lastError;      /**< result of the last write or verification. */
+} xplrOtaProgress_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Initialize the service. To be called once at boot.
+ * When running a freshly updated firmware a timer of XPLROTA_CONFIRM_TIMEOUT_S
+ * is started, the previous firmware is booted if it expires before xplrOtaConfirm().
+ *
+ * @param publicKeyPem  ECDSA P-256 public key, PEM, that images must be signed with.
+ *                      Must stay valid, it is not copied.
+ * @return              XPLR_OTA_OK on success, XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaInit(const char *publicKeyPem);
+
+/**
+ * @brief Check if the service is initialized and updates can be received.
+ *
+ * @return  true if xplrOtaInit() succeeded, false otherwise.
+ */
+bool xplrOtaIsInit(void);
+
+/**
+ * @brief Mark the running firmware as good, cancelling the rollback.
+ * Call it once the application has proven to work, e.g. connected to its services.
+ *
+ * @return  XPLR_OTA_OK on success, XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaConfirm(void);
+
+/**
+ * @brief Start receiving an image into the inactive OTA partition.
+ *
+ * @return  XPLR_OTA_OK on success, XPLR_OTA_BUSY if an update is already in
+ *          progress, XPLR_OTA_NOT_INIT if the service is not initialized,
+ *          XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaBegin(void);
+
+/**
+ * @brief Feed the next piece of the image, as received from any transport
+ * (webserver upload, MQTT message, AT command payload...).
+ * On error the update is aborted.
+ *
+ * @param data  image bytes.
+ * @param len   number of bytes, any size.
+ * @return      XPLR_OTA_OK on success, XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaWrite(const void *data, size_t len);
+
+/**
+ * @brief Verify the received image and make it the boot partition.
+ * The new firmware runs after the next restart, see xplrOtaRestart().
+ *
+ * @return  XPLR_OTA_OK on success, XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaEnd(void);
+
+/**
+ * @brief Drop the update in progress. The boot partition is not changed.
+ */
+void xplrOtaAbort(void);
+
+/**
+ * @brief Update from an image file, e.g. stored in the SD card.
+ * Runs xplrOtaBegin(), xplrOtaWrite() and xplrOtaEnd().
+ *
+ * @param path  path of the image file.
+ * @return      XPLR_OTA_OK on success, XPLR_OTA_BUSY, XPLR_OTA_NOT_INIT or
+ *              XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaWriteFile(const char *path);
+
+/**
+ * @brief Restart the device after a delay, leaving time to report the result.
+ *
+ * @param delayMs  delay in milliseconds.
+ * @return         XPLR_OTA_OK on success, XPLR_OTA_ERROR otherwise.
+ */
+xplrOta_error_t xplrOtaRestart(uint32_t delayMs);
+
+/**
+ * @brief Get the progress of the current or last update.
+ *
+ * @param progress  filled with the progress.
+ */
+void xplrOtaGetProgress(xplrOtaProgress_t *progress);
+
+/**
+ * @brief Function that initializes logging of the module with user-selected configuration
+ *
+ * @param logCfg    Pointer to a xplr_cfg_logInstance_t configuration struct.
+ *                  If NULL, the instance will be initialized using the default settings
+ *                  (located in xplr_hpglib_cfg.h file)
+ * @return          index of the logging instance in success, -1 in failure.
+*/
+int8_t xplrOtaInitLogModule(xplr_cfg_logInstance_t *logCfg);
+
+/**
+ * @brief   Function that stops the logging of the ota module
+ *
+ * @return  ESP_OK on success, ESP_FAIL otherwise.
+*/
+esp_err_t xplrOtaStopLogModule(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_OTA_H_ */
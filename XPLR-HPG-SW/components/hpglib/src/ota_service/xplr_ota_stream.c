@@ -0,0 +1,330 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xplr_ota_stream.h"
+#include <string.h>
+#include "mbedtls/pk.h"
+#include "mbedtls/version.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define OTA_SIGNATURE_MIN           (8U)
+
+/* mbedtls 3 dropped the _ret suffix */
+#if (MBEDTLS_VERSION_MAJOR < 3)
+#define otaShaStarts(ctx)           mbedtls_sha256_starts_ret((ctx), 0)
+#define otaShaUpdate(ctx, d, l)     mbedtls_sha256_update_ret((ctx), (d), (l))
+#define otaShaFinish(ctx, out)      mbedtls_sha256_finish_ret((ctx), (out))
+#else
+#define otaShaStarts(ctx)           mbedtls_sha256_starts((ctx), 0)
+#define otaShaUpdate(ctx, d, l)     mbedtls_sha256_update((ctx), (d), (l))
+#define otaShaFinish(ctx, out)      mbedtls_sha256_finish((ctx), (out))
+#endif
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static uint16_t otaGet16(const uint8_t *buf);
+static uint32_t otaGet32(const uint8_t *buf);
+static xplrOtaStreamError_t otaHeaderParse(xplrOtaStream_t *stream);
+static xplrOtaStreamError_t otaSectorFlush(xplrOtaStream_t *stream);
+static xplrOtaStreamError_t otaSignatureCheck(xplrOtaStream_t *stream, const uint8_t *digest);
+static xplrOtaStreamError_t otaReadBack(xplrOtaStream_t *stream);
+static void otaFail(xplrOtaStream_t *stream);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+xplrOtaStreamError_t xplrOtaStreamBegin(xplrOtaStream_t *stream,
+                                        const xplrOtaFlash_t *flash,
+                                        const uint8_t *publicKey,
+                                        size_t publicKeyLen)
+{
+    mbedtls_pk_context pk;
+    xplrOtaStreamError_t ret;
+
+    if ((stream == NULL) || (flash == NULL) || (publicKey == NULL) ||
+        (flash->erase == NULL) || (flash->write == NULL) || (flash->read == NULL) ||
+        (flash->size < XPLR_OTA_SECTOR_SIZE)) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    } else {
+        /* a key that cannot be used would only be noticed after the whole download */
+        mbedtls_pk_init(&pk);
+        if ((mbedtls_pk_parse_public_key(&pk, publicKey, publicKeyLen) != 0) ||
+            !mbedtls_pk_can_do(&pk, MBEDTLS_PK_ECDSA)) {
+            ret = XPLR_OTA_STREAM_ERROR;
+        } else {
+            memset(stream, 0x00, sizeof(xplrOtaStream_t));
+            stream->flash = flash;
+            stream->publicKey = publicKey;
+            stream->publicKeyLen = publicKeyLen;
+            mbedtls_sha256_init(&stream->sha);
+            if (otaShaStarts(&stream->sha) != 0) {
+                mbedtls_sha256_free(&stream->sha);
+                ret = XPLR_OTA_STREAM_ERROR;
+            } else {
+                stream->state = XPLR_OTA_STREAM_STATE_HEADER;
+                ret = XPLR_OTA_STREAM_OK;
+            }
+        }
+        mbedtls_pk_free(&pk);
+    }
+
+    return ret;
+}
+
+xplrOtaStreamError_t xplrOtaStreamWrite(xplrOtaStream_t *stream, const void *data, size_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t chunk;
+    xplrOtaStreamError_t ret;
+
+    if ((stream == NULL) || ((data == NULL) && (len > 0))) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    } else if ((stream->state != XPLR_OTA_STREAM_STATE_HEADER) &&
+               (stream->state != XPLR_OTA_STREAM_STATE_BINARY)) {
+        ret = XPLR_OTA_STREAM_ERROR_STATE;
+    } else {
+        ret = XPLR_OTA_STREAM_OK;
+        while ((len > 0) && (ret == XPLR_OTA_STREAM_OK)) {
+            if (stream->state == XPLR_OTA_STREAM_STATE_HEADER) {
+                chunk = XPLR_OTA_HEADER_SIZE - stream->headerLen;
+                chunk = (len < chunk) ? len : chunk;
+                memcpy(&stream->headerBuf[stream->headerLen], bytes, chunk);
+                stream->headerLen += chunk;
+                if (stream->headerLen == XPLR_OTA_HEADER_SIZE) {
+                    ret = otaHeaderParse(stream);
+                }
+            } else if (len > (stream->header.imageSize - stream->received)) {
+                /* more data than announced, the image cannot be trusted */
+                chunk = len;
+                ret = XPLR_OTA_STREAM_ERROR_SIZE;
+            } else {
+                chunk = XPLR_OTA_SECTOR_SIZE - stream->sectorLen;
+                chunk = (len < chunk) ? len : chunk;
+                memcpy(&stream->sector[stream->sectorLen], bytes, chunk);
+                if (otaShaUpdate(&stream->sha, bytes, chunk) != 0) {
+                    ret = XPLR_OTA_STREAM_ERROR;
+                }
+                stream->sectorLen += chunk;
+                stream->received += chunk;
+                if ((ret == XPLR_OTA_STREAM_OK) && (stream->sectorLen == XPLR_OTA_SECTOR_SIZE)) {
+                    ret = otaSectorFlush(stream);
+                }
+            }
+            bytes += chunk;
+            len -= chunk;
+        }
+
+        if (ret != XPLR_OTA_STREAM_OK) {
+            otaFail(stream);
+        }
+    }
+
+    return ret;
+}
+
+xplrOtaStreamError_t xplrOtaStreamFinish(xplrOtaStream_t *stream)
+{
+    uint8_t digest[XPLR_OTA_DIGEST_SIZE];
+    xplrOtaStreamError_t ret;
+
+    if (stream == NULL) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    } else if ((stream->state != XPLR_OTA_STREAM_STATE_HEADER) &&
+               (stream->state != XPLR_OTA_STREAM_STATE_BINARY)) {
+        ret = XPLR_OTA_STREAM_ERROR_STATE;
+    } else if ((stream->state == XPLR_OTA_STREAM_STATE_HEADER) ||
+               (stream->received != stream->header.imageSize)) {
+        /* transfer cut short */
+        ret = XPLR_OTA_STREAM_ERROR_SIZE;
+    } else if ((stream->sectorLen > 0) && (otaSectorFlush(stream) != XPLR_OTA_STREAM_OK)) {
+        ret = XPLR_OTA_STREAM_ERROR_FLASH;
+    } else if (otaShaFinish(&stream->sha, digest) != 0) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    } else if (memcmp(digest, stream->header.digest, XPLR_OTA_DIGEST_SIZE) != 0) {
+        ret = XPLR_OTA_STREAM_ERROR_DIGEST;
+    } else {
+        ret = otaSignatureCheck(stream, digest);
+        if (ret == XPLR_OTA_STREAM_OK) {
+            ret = otaReadBack(stream);
+        }
+    }
+
+    if (stream != NULL) {
+        if (ret == XPLR_OTA_STREAM_OK) {
+            mbedtls_sha256_free(&stream->sha);
+            stream->state = XPLR_OTA_STREAM_STATE_DONE;
+        } else if (ret != XPLR_OTA_STREAM_ERROR_STATE) {
+            otaFail(stream);
+        } else {
+            // do nothing
+        }
+    }
+
+    return ret;
+}
+
+void xplrOtaStreamAbort(xplrOtaStream_t *stream)
+{
+    if ((stream != NULL) &&
+        ((stream->state == XPLR_OTA_STREAM_STATE_HEADER) ||
+         (stream->state == XPLR_OTA_STREAM_STATE_BINARY))) {
+        otaFail(stream);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static uint16_t otaGet16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static uint32_t otaGet32(const uint8_t *buf)
+{
+    return (uint32_t)otaGet16(&buf[0]) | ((uint32_t)otaGet16(&buf[2]) << 16);
+}
+
+static xplrOtaStreamError_t otaHeaderParse(xplrOtaStream_t *stream)
+{
+    const uint8_t *buf = stream->headerBuf;
+    xplrOtaHeader_t *header = &stream->header;
+    xplrOtaStreamError_t ret;
+
+    header->imageSize = otaGet32(&buf[8]);
+    memcpy(header->digest, &buf[16], XPLR_OTA_DIGEST_SIZE);
+    header->signatureLen = otaGet16(&buf[48]);
+    memcpy(header->signature, &buf[52], XPLR_OTA_SIGNATURE_MAX);
+
+    if ((otaGet32(&buf[0]) != XPLR_OTA_MAGIC) ||
+        (otaGet16(&buf[4]) != XPLR_OTA_HEADER_SIZE) ||
+        (otaGet16(&buf[6]) != 0) ||
+        (header->signatureLen < OTA_SIGNATURE_MIN) ||
+        (header->signatureLen > XPLR_OTA_SIGNATURE_MAX)) {
+        ret = XPLR_OTA_STREAM_ERROR_HEADER;
+    } else if ((header->imageSize == 0) || (header->imageSize > stream->flash->size)) {
+        ret = XPLR_OTA_STREAM_ERROR_SIZE;
+    } else {
+        stream->state = XPLR_OTA_STREAM_STATE_BINARY;
+        ret = XPLR_OTA_STREAM_OK;
+    }
+
+    return ret;
+}
+
+/**
+ * Erase the next sector and write the buffered binary to it.
+ * Only the last sector can be partial, it is padded with erased bytes.
+ */
+static xplrOtaStreamError_t otaSectorFlush(xplrOtaStream_t *stream)
+{
+    const xplrOtaFlash_t *flash = stream->flash;
+    uint32_t len = stream->sectorLen;
+    xplrOtaStreamError_t ret;
+
+    if ((len % XPLR_OTA_WRITE_ALIGN) != 0) {
+        memset(&stream->sector[len], 0xFF, XPLR_OTA_WRITE_ALIGN - (len % XPLR_OTA_WRITE_ALIGN));
+        len += XPLR_OTA_WRITE_ALIGN - (len % XPLR_OTA_WRITE_ALIGN);
+    }
+
+    if ((flash->erase(flash->ctx, stream->written, XPLR_OTA_SECTOR_SIZE) != 0) ||
+        (flash->write(flash->ctx, stream->written, stream->sector, len) != 0)) {
+        ret = XPLR_OTA_STREAM_ERROR_FLASH;
+    } else {
+        stream->written += stream->sectorLen;
+        stream->sectorLen = 0;
+        ret = XPLR_OTA_STREAM_OK;
+    }
+
+    return ret;
+}
+
+static xplrOtaStreamError_t otaSignatureCheck(xplrOtaStream_t *stream, const uint8_t *digest)
+{
+    mbedtls_pk_context pk;
+    xplrOtaStreamError_t ret;
+
+    mbedtls_pk_init(&pk);
+    if ((mbedtls_pk_parse_public_key(&pk, stream->publicKey, stream->publicKeyLen) != 0) ||
+        (mbedtls_pk_verify(&pk,
+                           MBEDTLS_MD_SHA256,
+                           digest,
+                           XPLR_OTA_DIGEST_SIZE,
+                           stream->header.signature,
+                           stream->header.signatureLen) != 0)) {
+        ret = XPLR_OTA_STREAM_ERROR_SIGNATURE;
+    } else {
+        ret = XPLR_OTA_STREAM_OK;
+    }
+    mbedtls_pk_free(&pk);
+
+    return ret;
+}
+
+/**
+ * Hash the binary again as stored in flash, the sector buffer is reused.
+ */
+static xplrOtaStreamError_t otaReadBack(xplrOtaStream_t *stream)
+{
+    const xplrOtaFlash_t *flash = stream->flash;
+    uint8_t digest[XPLR_OTA_DIGEST_SIZE];
+    uint32_t offset = 0;
+    uint32_t chunk;
+    xplrOtaStreamError_t ret = XPLR_OTA_STREAM_OK;
+
+    mbedtls_sha256_free(&stream->sha);
+    mbedtls_sha256_init(&stream->sha);
+    if (otaShaStarts(&stream->sha) != 0) {
+        ret = XPLR_OTA_STREAM_ERROR;
+    }
+
+    while ((ret == XPLR_OTA_STREAM_OK) && (offset < stream->header.imageSize)) {
+        chunk = stream->header.imageSize - offset;
+        chunk = (chunk < XPLR_OTA_SECTOR_SIZE) ? chunk : XPLR_OTA_SECTOR_SIZE;
+        if (flash->read(flash->ctx, offset, stream->sector, chunk) != 0) {
+            ret = XPLR_OTA_STREAM_ERROR_FLASH;
+        } else if (otaShaUpdate(&stream->sha, stream->sector, chunk) != 0) {
+            ret = XPLR_OTA_STREAM_ERROR;
+        } else {
+            offset += chunk;
+        }
+    }
+
+    if (ret == XPLR_OTA_STREAM_OK) {
+        if (otaShaFinish(&stream->sha, digest) != 0) {
+            ret = XPLR_OTA_STREAM_ERROR;
+        } else if (memcmp(digest, stream->header.digest, XPLR_OTA_DIGEST_SIZE) != 0) {
+            ret = XPLR_OTA_STREAM_ERROR_READBACK;
+        } else {
+            // do nothing
+        }
+    }
+
+    return ret;
+}
+
+static void otaFail(xplrOtaStream_t *stream)
+{
+    mbedtls_sha256_free(&stream->sha);
+    stream->state = XPLR_OTA_STREAM_STATE_FAILED;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_OTA_STREAM_H_
+#define _XPLR_OTA_STREAM_H_
+
+/* Only standard and mbedtls headers here: the writer is also built on a host,
+ * see tools/xplr_ota_host_test.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mbedtls/sha256.h"
+
+/** @file
+ * @brief Streaming writer and verifier of signed firmware images.
+ * An image is a 128 byte header followed by the application binary:
+ *
+ *  offset | size | content
+ *  ------ | ---- | -------
+ *  0      | 4    | magic "XOTA"
+ *  4      | 2    | header size (128)
+ *  6      | 2    | flags (0)
+ *  8      | 4    | size of the application binary
+ *  12     | 4    | reserved (0)
+ *  16     | 32   | SHA-256 digest of the application binary
+ *  48     | 2    | signature length
+ *  50     | 2    | reserved (0)
+ *  52     | 72   | ECDSA P-256 signature of the digest, DER encoded
+ *
+ * Numbers are little endian. tools/xplr_ota_pack.py builds such images.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_OTA_MAGIC                  (0x41544F58U)   /* "XOTA" */
+#define XPLR_OTA_HEADER_SIZE            (128U)
+#define XPLR_OTA_DIGEST_SIZE            (32U)
+#define XPLR_OTA_SIGNATURE_MAX          (72U)
+
+/** Flash erase unit, the binary is written one sector at a time. */
+#define XPLR_OTA_SECTOR_SIZE            (4096U)
+
+/** The last sector is padded to this, as encrypted flash requires. */
+#define XPLR_OTA_WRITE_ALIGN            (16U)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+typedef enum {
+    XPLR_OTA_STREAM_ERROR_READBACK = -8,    /**< flash content differs from what was written */
+    XPLR_OTA_STREAM_ERROR_SIGNATURE,        /**< signature does not match the public key */
+    XPLR_OTA_STREAM_ERROR_DIGEST,           /**< binary does not match the digest of the header */
+    XPLR_OTA_STREAM_ERROR_SIZE,             /**< binary too large, longer or shorter than announced */
+    XPLR_OTA_STREAM_ERROR_HEADER,           /**< not an image header */
+    XPLR_OTA_STREAM_ERROR_FLASH,            /**< flash erase, write or read failed */
+    XPLR_OTA_STREAM_ERROR_STATE,            /**< call not expected in the current state */
+    XPLR_OTA_STREAM_ERROR,                  /**< invalid argument */
+    XPLR_OTA_STREAM_OK
+} xplrOtaStreamError_t;
+
+/**
+ * Flash the binary is written to, offsets are relative to its start.
+ * Callbacks return 0 on success.
+ */
+typedef struct xplrOtaFlash_type {
+    int         (*erase)(void *ctx, uint32_t offset, uint32_t size);
+    int         (*write)(void *ctx, uint32_t offset, const void *data, uint32_t size);
+    int         (*read)(void *ctx, uint32_t offset, void *data, uint32_t size);
+    void        *ctx;
+    uint32_t    size;           /**< bytes available, a multiple of XPLR_OTA_SECTOR_SIZE */
+} xplrOtaFlash_t;
+
+/**
+ * Parsed image header.
+ */
+typedef struct xplrOtaHeader_type {
+    uint32_t    imageSize;
+    uint8_t     digest[XPLR_OTA_DIGEST_SIZE];
+    uint16_t    signatureLen;
+    uint8_t     signature[XPLR_OTA_SIGNATURE_MAX];
+} xplrOtaHeader_t;
+
+typedef enum {
+    XPLR_OTA_STREAM_STATE_IDLE = 0,
+    XPLR_OTA_STREAM_STATE_HEADER,
+    XPLR_OTA_STREAM_STATE_BINARY,
+    XPLR_OTA_STREAM_STATE_DONE,
+    XPLR_OTA_STREAM_STATE_FAILED
+} xplrOtaStreamState_t;
+
+/**
+ * Writer instance. Holds a sector buffer, keep it static.
+ */
+typedef struct xplrOtaStream_type {
+    const xplrOtaFlash_t    *flash;
+    const uint8_t           *publicKey;
+    size_t                  publicKeyLen;
+    xplrOtaStreamState_t    state;
+    xplrOtaHeader_t         header;
+    uint32_t                headerLen;      /**< header bytes received */
+    uint32_t                received;       /**< binary bytes received */
+    uint32_t                written;        /**< binary bytes in flash */
+    uint32_t                sectorLen;      /**< binary bytes waiting in sector */
+    mbedtls_sha256_context  sha;
+    uint8_t                 headerBuf[XPLR_OTA_HEADER_SIZE];
+    uint8_t                 sector[XPLR_OTA_SECTOR_SIZE];
+} xplrOtaStream_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Prepare a writer for a new image.
+ *
+ * @param stream        writer.
+ * @param flash         destination, must stay valid until the image is finished.
+ * @param publicKey     ECDSA P-256 public key checking the signature, PEM (with its
+ *                      terminating null, counted in publicKeyLen) or DER.
+ * @param publicKeyLen  length of publicKey.
+ * @return              XPLR_OTA_STREAM_OK or XPLR_OTA_STREAM_ERROR.
+ */
+xplrOtaStreamError_t xplrOtaStreamBegin(xplrOtaStream_t *stream,
+                                        const xplrOtaFlash_t *flash,
+                                        const uint8_t *publicKey,
+                                        size_t publicKeyLen);
+
+/**
+ * @brief Feed the next piece of the image, of any size.
+ * The header is checked as soon as it is complete, then the binary is
+ * hashed and written sector by sector, each sector erased just before.
+ *
+ * @param stream  writer.
+ * @param data    image bytes.
+ * @param len     number of bytes.
+ * @return        XPLR_OTA_STREAM_OK, or the error that failed the image.
+ */
+xplrOtaStreamError_t xplrOtaStreamWrite(xplrOtaStream_t *stream, const void *data, size_t len);
+
+/**
+ * @brief Write the last sector and verify the image.
+ * The digest of the received binary must match the header, the header
+ * signature must match the public key, and the binary read back from
+ * flash must have the same digest.
+ *
+ * @param stream  writer.
+ * @return        XPLR_OTA_STREAM_OK when the image in flash can be booted.
+ */
+xplrOtaStreamError_t xplrOtaStreamFinish(xplrOtaStream_t *stream);
+
+/**
+ * @brief Drop the image being written. Flash is left partially written.
+ *
+ * @param stream  writer.
+ */
+void xplrOtaStreamAbort(xplrOtaStream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_OTA_STREAM_H_ */
@@ -24,6 +24,7 @@
 #include "string.h"
 #include "xplr_thingstream.h"
 #include "xplr_log.h"
+#include "xplr_nvs.h"
 #include "cJSON.h"
 
 #include "./../../../components/hpglib/src/common/xplr_common.h"
@@ -44,6 +45,34 @@
 #define XPLR_THINGSTREAM_CONSOLE(message, ...) do{} while(0)
 #endif
 
+/**
+ * NVS storage of the cached ZTP result.
+ * Each string is stored at its real length, a full set of settings takes
+ * about 3 KB. The namespace is emptied before a new result is written so
+ * a refresh never needs room for two copies. The tag is written last, a
+ * cache without a matching tag is ignored.
+ */
+#define XPLR_THINGSTREAM_CACHE_NVS_NAMESPACE    "xplrTsCache"
+#define XPLR_THINGSTREAM_CACHE_VERSION          (2)
+#define XPLR_THINGSTREAM_CACHE_KEY_TAG          "tag"
+#define XPLR_THINGSTREAM_CACHE_KEY_URL          "urlPath"
+#define XPLR_THINGSTREAM_CACHE_KEY_BROKER       "broker"
+#define XPLR_THINGSTREAM_CACHE_KEY_PORT         "port"
+#define XPLR_THINGSTREAM_CACHE_KEY_DEVICEID     "deviceId"
+#define XPLR_THINGSTREAM_CACHE_KEY_CLIENTKEY    "clientKey"
+#define XPLR_THINGSTREAM_CACHE_KEY_CLIENTCERT   "clientCert"
+#define XPLR_THINGSTREAM_CACHE_KEY_FLAGS        "flags"
+#define XPLR_THINGSTREAM_CACHE_KEY_DKEYS        "dynKeys"
+#define XPLR_THINGSTREAM_CACHE_KEY_TOPICS       "topics"
+#define XPLR_THINGSTREAM_CACHE_KEY_TOPIC        "topic%u"
+#define XPLR_THINGSTREAM_CACHE_KEY_ROOTCA       "rootCa"
+
+/**
+ * Bits of the stored flags.
+ */
+#define XPLR_THINGSTREAM_CACHE_FLAG_MQTT        (1U << 0)
+#define XPLR_THINGSTREAM_CACHE_FLAG_LBAND       (1U << 1)
+
 /* ----------------------------------------------------------------
  * STATIC TYPES
  * -------------------------------------------------------------- */
@@ -126,6 +155,8 @@ const char tsCommThingPasswordStart[] =     "<Password>";
 const char tsCommThingPasswordEnd[] =       "</Password>";
 
 static int8_t logIndex = -1;
+static xplrNvs_t tsCacheNvs;
+static bool tsCacheNvsReady = false;
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTION PROTOTYPES
@@ -135,32 +166,46 @@ static xplr_thingstream_error_t tsCreateDeviceUid(char *uid);
 static xplr_thingstream_error_t tsApiMsgCreatePpZtp(char *msg,
                                                     size_t *size,
                                                     xplr_thingstream_t *settings);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpBrokerAddress(const char *msg,
+static cJSON *tsApiMsgParsePpZtpPayload(const char *msg);
+static xplr_thingstream_error_t tsApiMsgParsePpZtpServerInfo(const cJSON *root,
+                                                             char *value,
+                                                             size_t size,
+                                                             xplr_thingstream_pp_serverInfo_type_t info);
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicInfo(const cJSON *root,
+                                                            xplr_thingstream_pp_region_t region,
+                                                            xplr_thingstream_pp_plan_t planType,
+                                                            xplr_thingstream_pp_topic_type_t type,
+                                                            xplr_thingstream_pp_topic_t *topic);
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicsByRegionAll(const cJSON *root,
+                                                                    xplr_thingstream_pp_region_t region,
+                                                                    xplr_thingstream_pp_plan_t planType,
+                                                                    xplr_thingstream_pp_topic_t *topics);
+static xplr_thingstream_error_t tsApiMsgParsePpZtpBrokerAddress(const cJSON *root,
                                                                 char *info,
                                                                 size_t infoSize);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientCert(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientCert(const cJSON *root,
                                                              char *info,
                                                              size_t infoSize);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientKey(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientKey(const cJSON *root,
                                                             char *info,
                                                             size_t infoSize);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientId(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientId(const cJSON *root,
                                                            char *info,
                                                            size_t infoSize);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpLbandSupport(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpLbandSupport(const cJSON *root,
                                                                bool *supported);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpMqttSupport(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpMqttSupport(const cJSON *root,
                                                               bool *supported);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpDkeys(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpDkeys(const cJSON *root,
                                                         xplr_thingstream_pp_dKeys_t *dKeys);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const cJSON *root,
                                                         const char *regionFilter,
                                                         const char *typeFilter,
                                                         xplr_thingstream_pp_topic_t *topic);
-static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicList(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicList(const cJSON *root,
                                                             xplr_thingstream_pp_topic_t *topic);
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpCheckTag(const char *msg, const char *tag);
+static xplr_thingstream_error_t tsApiMsgParsePpZtpCheckTag(const cJSON *root, const char *tag);
 
 static xplr_thingstream_pp_plan_t tsPpGetPlanType(bool lbandSupported, bool mqttSupported);
 
@@ -174,20 +219,35 @@ static xplr_thingstream_error_t tsPpGetFreqTopic(xplr_thingstream_pp_sub_t *tspl
                                                  char *freqTopic);
 static xplr_thingstream_error_t tsPpGetFreqDesc(xplr_thingstream_pp_sub_t *tsplan, char *freqDesc);
 static void tsPpModifyBroker(char *brokerAddress);
-static xplr_thingstream_error_t tsPpConfigFileGetBroker(char *payload, char *brokerAddress);
-static xplr_thingstream_error_t tsPpConfigFileGetDeviceId(char *payload, char *deviceId);
-static xplr_thingstream_error_t tsPpConfigFileGetClientKey(char *payload, char *clientKey);
-static xplr_thingstream_error_t tsPpConfigFileGetClientCert(char *payload, char *clientCert);
-static xplr_thingstream_error_t tsPpConfigFileGetRootCa(char *payload, char *rootCa);
-static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(char *payload,
+static xplr_thingstream_error_t tsPpConfigFileGetBroker(cJSON *root, char *brokerAddress);
+static xplr_thingstream_error_t tsPpConfigFileGetDeviceId(cJSON *root, char *deviceId);
+static xplr_thingstream_error_t tsPpConfigFileGetClientKey(cJSON *root,
+                                                           char *clientKey,
+                                                           bool addNewLines);
+static xplr_thingstream_error_t tsPpConfigFileGetClientCert(cJSON *root,
+                                                            char *clientCert,
+                                                            bool addNewLines);
+static xplr_thingstream_error_t tsPpConfigFileGetRootCa(cJSON *root,
+                                                        char *rootCa,
+                                                        bool addNewLines);
+static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(cJSON *root,
                                                              xplr_thingstream_pp_dKeys_t *dynamicKeys);
-static xplr_thingstream_error_t tsPpConfigFileParseTopicsInfoByRegionAll(char *payload,
+static xplr_thingstream_error_t tsPpConfigFileParseTopicsInfoByRegionAll(cJSON *root,
                                                                          xplr_thingstream_pp_region_t region,
                                                                          bool lbandOverIpPreference,
                                                                          xplr_thingstream_pp_settings_t *settings);
 static xplr_thingstream_error_t tsPpConfigFileFormatCert(char *cert,
-                                                         xplr_thingstream_pp_serverInfo_type_t type);
+                                                         xplr_thingstream_pp_serverInfo_type_t type,
+                                                         bool addNewLines);
 static void tsPpSetDescFilter(xplr_thingstream_pp_settings_t *settings);
+static xplr_thingstream_error_t tsCacheOpen(void);
+static uint32_t tsCacheTag(const xplr_thingstream_t *settings,
+                           xplr_thingstream_pp_region_t region,
+                           bool lbandOverIpPreference);
+static xplrNvs_error_t tsCacheWriteStr(const char *key, const char *value, size_t sizeMax, size_t *bytes);
+static xplrNvs_error_t tsCacheReadStr(const char *key, char *value, size_t sizeMax);
+static xplrNvs_error_t tsCacheWriteTopic(uint8_t index, const xplr_thingstream_pp_topic_t *topic, size_t *bytes);
+static xplrNvs_error_t tsCacheReadTopic(uint8_t index, xplr_thingstream_pp_topic_t *topic);
 static xplr_thingstream_error_t tsCommThingParserCheckSize(const char *start,
                                                            const char *end,
                                                            size_t size);
@@ -215,11 +275,14 @@ xplr_thingstream_error_t xplrThingstreamInit(const char *ppToken,
                 case XPLR_THINGSTREAM_PP_CONN_WIFI:
                     serverUrlLength = strlen(thingstreamApiUrlWifi);
                     memcpy(&thingstream->server.serverUrl, thingstreamApiUrlWifi, serverUrlLength);
+                    /* ZTP appends its path, drop the one of a previous run */
+                    thingstream->server.serverUrl[serverUrlLength] = 0;
                     ret = XPLR_THINGSTREAM_OK;
                     break;
                 case XPLR_THINGSTREAM_PP_CONN_CELL:
                     serverUrlLength = strlen(thingstreamApiUrlCell);
                     memcpy(&thingstream->server.serverUrl, thingstreamApiUrlCell, serverUrlLength);
+                    thingstream->server.serverUrl[serverUrlLength] = 0;
                     ret = XPLR_THINGSTREAM_OK;
                     break;
                 case XPLR_THINGSTREAM_PP_CONN_INVALID:
@@ -283,42 +346,47 @@ xplr_thingstream_error_t xplrThingstreamPpConfig(const char *data,
                                                  bool lbandOverIpPreference,
                                                  xplr_thingstream_t *settings)
 {
+    cJSON *root;
     xplr_thingstream_error_t err[8];
     xplr_thingstream_error_t ret;
     xplr_thingstream_pp_plan_t subType;
 
+    /* parse the ZTP payload once and extract every field from the same tree.
+       a NULL tree is rejected by each of the parsers below. */
+    root = tsApiMsgParsePpZtpPayload(data);
+
     /* get broker configuration settings */
-    err[0] = xplrThingstreamPpParseServerInfo(data,
-                                              settings->pointPerfect.brokerAddress,
-                                              XPLR_THINGSTREAM_URL_SIZE_MAX,
-                                              XPLR_THINGSTREAM_PP_SERVER_ADDRESS);
+    err[0] = tsApiMsgParsePpZtpServerInfo(root,
+                                          settings->pointPerfect.brokerAddress,
+                                          XPLR_THINGSTREAM_URL_SIZE_MAX,
+                                          XPLR_THINGSTREAM_PP_SERVER_ADDRESS);
 
-    err[1] = xplrThingstreamPpParseServerInfo(data,
-                                              settings->pointPerfect.deviceId,
-                                              XPLR_THINGSTREAM_PP_DEVICEID_SIZE,
-                                              XPLR_THINGSTREAM_PP_SERVER_ID);
+    err[1] = tsApiMsgParsePpZtpServerInfo(root,
+                                          settings->pointPerfect.deviceId,
+                                          XPLR_THINGSTREAM_PP_DEVICEID_SIZE,
+                                          XPLR_THINGSTREAM_PP_SERVER_ID);
 
-    err[2] = xplrThingstreamPpParseServerInfo(data,
-                                              settings->pointPerfect.clientCert,
-                                              XPLR_THINGSTREAM_CERT_SIZE_MAX,
-                                              XPLR_THINGSTREAM_PP_SERVER_CERT);
+    err[2] = tsApiMsgParsePpZtpServerInfo(root,
+                                          settings->pointPerfect.clientCert,
+                                          XPLR_THINGSTREAM_CERT_SIZE_MAX,
+                                          XPLR_THINGSTREAM_PP_SERVER_CERT);
 
-    err[3] = xplrThingstreamPpParseServerInfo(data,
-                                              settings->pointPerfect.clientKey,
-                                              XPLR_THINGSTREAM_CERT_SIZE_MAX,
-                                              XPLR_THINGSTREAM_PP_SERVER_KEY);
+    err[3] = tsApiMsgParsePpZtpServerInfo(root,
+                                          settings->pointPerfect.clientKey,
+                                          XPLR_THINGSTREAM_CERT_SIZE_MAX,
+                                          XPLR_THINGSTREAM_PP_SERVER_KEY);
 
-    err[4] = xplrThingstreamPpParseLbandSupport(data,
-                                                &settings->pointPerfect.lbandSupported);
+    err[4] = tsApiMsgParsePpZtpLbandSupport(root,
+                                            &settings->pointPerfect.lbandSupported);
 
-    err[5] = xplrThingstreamPpParseMqttSupport(data,
-                                               &settings->pointPerfect.mqttSupported);
+    err[5] = tsApiMsgParsePpZtpMqttSupport(root,
+                                           &settings->pointPerfect.mqttSupported);
 
     subType = tsPpGetPlanType(settings->pointPerfect.lbandSupported,
                               settings->pointPerfect.mqttSupported);
 
-    err[6] = xplrThingstreamPpParseDynamicKeys(data,
-                                               &settings->pointPerfect.dynamicKeys);
+    err[6] = tsApiMsgParsePpZtpDkeys(root,
+                                     &settings->pointPerfect.dynamicKeys);
 
     // IPLBAND plan and LBAND correction source, parse topics as LBAND plan
     if (subType == XPLR_THINGSTREAM_PP_PLAN_IPLBAND && lbandOverIpPreference) {
@@ -327,10 +395,13 @@ xplr_thingstream_error_t xplrThingstreamPpConfig(const char *data,
         // do nothing;
     }
     /* get broker topics (region filtered) */
-    err[7] = xplrThingstreamPpParseTopicsInfoByRegionAll(data,
-                                                         region,
-                                                         subType,
-                                                         settings->pointPerfect.topicList);
+    err[7] = tsApiMsgParsePpZtpTopicsByRegionAll(root,
+                                                 region,
+                                                 subType,
+                                                 settings->pointPerfect.topicList);
+
+    /* all fields have been copied to their destinations, free the tree */
+    cJSON_Delete(root);
 
     tsPpSetDescFilter(&settings->pointPerfect);
     if ((settings->connType == XPLR_THINGSTREAM_PP_CONN_WIFI) && (err[0] == XPLR_THINGSTREAM_OK)) {
@@ -397,26 +468,12 @@ xplr_thingstream_error_t xplrThingstreamPpParseServerInfo(const char *data,
                                                           size_t size,
                                                           xplr_thingstream_pp_serverInfo_type_t info)
 {
+    cJSON *root;
     xplr_thingstream_error_t ret;
 
-    switch (info) {
-        case XPLR_THINGSTREAM_PP_SERVER_ADDRESS:
-            ret = tsApiMsgParsePpZtpBrokerAddress(data, value, size);
-            break;
-        case XPLR_THINGSTREAM_PP_SERVER_CERT:
-            ret = tsApiMsgParsePpZtpClientCert(data, value, size);
-            break;
-        case XPLR_THINGSTREAM_PP_SERVER_KEY:
-            ret = tsApiMsgParsePpZtpClientKey(data, value, size);
-            break;
-        case XPLR_THINGSTREAM_PP_SERVER_ID:
-            ret = tsApiMsgParsePpZtpClientId(data, value, size);
-            break;
-
-        default:
-            ret = XPLR_THINGSTREAM_ERROR;
-            break;
-    }
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpServerInfo(root, value, size, info);
+    cJSON_Delete(root);
 
     return ret;
 }
@@ -424,13 +481,27 @@ xplr_thingstream_error_t xplrThingstreamPpParseServerInfo(const char *data,
 xplr_thingstream_error_t xplrThingstreamPpParseLbandSupport(const char *data,
                                                             bool *lband)
 {
-    return tsApiMsgParsePpZtpLbandSupport(data, lband);
+    cJSON *root;
+    xplr_thingstream_error_t ret;
+
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpLbandSupport(root, lband);
+    cJSON_Delete(root);
+
+    return ret;
 }
 
 xplr_thingstream_error_t xplrThingstreamPpParseMqttSupport(const char *data,
                                                            bool *mqtt)
 {
-    return tsApiMsgParsePpZtpMqttSupport(data, mqtt);
+    cJSON *root;
+    xplr_thingstream_error_t ret;
+
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpMqttSupport(root, mqtt);
+    cJSON_Delete(root);
+
+    return ret;
 }
 
 xplr_thingstream_error_t xplrThingstreamPpParseTopicInfo(const char *data,
@@ -439,125 +510,12 @@ xplr_thingstream_error_t xplrThingstreamPpParseTopicInfo(const char *data,
                                                          xplr_thingstream_pp_topic_type_t type,
                                                          xplr_thingstream_pp_topic_t *topic)
 {
-    const char *regionFilter, *topicFilter;
+    cJSON *root;
     xplr_thingstream_error_t ret;
 
-    /* set region filter */
-    switch (region) {
-        case XPLR_THINGSTREAM_PP_REGION_EU:
-            regionFilter = thingstreamPpFilterRegionEU;
-            ret = XPLR_THINGSTREAM_OK;
-            break;
-        case XPLR_THINGSTREAM_PP_REGION_US:
-            regionFilter = thingstreamPpFilterRegionUS;
-            ret = XPLR_THINGSTREAM_OK;
-            break;
-        case XPLR_THINGSTREAM_PP_REGION_KR:
-            regionFilter = thingstreamPpFilterRegionKR;
-            ret = XPLR_THINGSTREAM_OK;
-            break;
-        case XPLR_THINGSTREAM_PP_REGION_AU:
-            regionFilter = thingstreamPpFilterRegionAU;
-            ret = XPLR_THINGSTREAM_OK;
-            break;
-        case XPLR_THINGSTREAM_PP_REGION_JP:
-            regionFilter = thingstreamPpFilterRegionJP;
-            ret = XPLR_THINGSTREAM_OK;
-            break;
-        default:
-            XPLR_THINGSTREAM_CONSOLE(E, "Region not supported.");
-            ret = XPLR_THINGSTREAM_ERROR;
-            break;
-    }
-
-    /* set topic filter */
-    if (ret != XPLR_THINGSTREAM_ERROR) {
-        switch (type) {
-            case XPLR_THINGSTREAM_PP_TOPIC_KEYS_DIST:
-                topicFilter = thingstreamPpFilterKeyDist;
-                /* key distribution topic does not contain region id. mask filter */
-                regionFilter = " ";
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_CORRECTION_DATA:
-                switch (planType) {
-                    case XPLR_THINGSTREAM_PP_PLAN_IP:
-                        topicFilter = thingstreamPpFilterCorrectionDataIp;
-                        ret = XPLR_THINGSTREAM_OK;
-                        break;
-                    case XPLR_THINGSTREAM_PP_PLAN_LBAND:
-                        topicFilter = thingstreamPpFilterCorrectionDataLb;
-                        ret = XPLR_THINGSTREAM_OK;
-                        break;
-                    case XPLR_THINGSTREAM_PP_PLAN_IPLBAND:
-                        topicFilter = thingstreamPpFilterCorrectionDataIpLb;
-                        ret = XPLR_THINGSTREAM_OK;
-                        break;
-                    case XPLR_THINGSTREAM_PP_PLAN_INVALID:
-                    default:
-                        ret = XPLR_THINGSTREAM_ERROR;
-                        break;
-                }
-                if (ret == XPLR_THINGSTREAM_OK) {
-                    thingstreamPpFilterCorrectionData = topicFilter;
-                }
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_GAD:
-                topicFilter = thingstreamPpFilterGAD;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_HPAC:
-                topicFilter = thingstreamPpFilterHPAC;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_OCB:
-                topicFilter = thingstreamPpFilterOCB;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_CLK:
-                topicFilter = thingstreamPpFilterClock;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_FREQ:
-                topicFilter = thingstreamPpFilterFreq;
-                /* frequencies topic does not contain region id. mask filter */
-                regionFilter = " ";
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_ALL_EU:
-                topicFilter = thingstreamPpFilterRegionEUAll;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_ALL_US:
-                topicFilter = thingstreamPpFilterRegionUSAll;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_ALL_KR:
-                topicFilter = thingstreamPpFilterRegionKRAll;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_ALL_JP:
-                topicFilter = thingstreamPpFilterRegionJPAll;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_ALL:
-                topicFilter = thingstreamPpFilterAll;
-                ret = XPLR_THINGSTREAM_OK;
-                break;
-            case XPLR_THINGSTREAM_PP_TOPIC_INVALID:
-                ret = XPLR_THINGSTREAM_ERROR;
-                break;
-
-            default:
-                ret = XPLR_THINGSTREAM_ERROR;
-                break;
-        }
-    }
-
-    /* search for topic */
-    if (ret != XPLR_THINGSTREAM_ERROR) {
-        ret = tsApiMsgParsePpZtpTopic(data, regionFilter, topicFilter, topic);
-    }
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpTopicInfo(root, region, planType, type, topic);
+    cJSON_Delete(root);
 
     return ret;
 }
@@ -567,6 +525,7 @@ xplr_thingstream_error_t xplrThingstreamPpParseTopicsInfoByRegion(const char *da
                                                                   xplr_thingstream_pp_plan_t planType,
                                                                   xplr_thingstream_pp_topic_t *topics)
 {
+    cJSON *root;
     xplr_thingstream_error_t err[4];
     xplr_thingstream_error_t ret;
 
@@ -576,19 +535,23 @@ xplr_thingstream_error_t xplrThingstreamPpParseTopicsInfoByRegion(const char *da
        Before exiting, add the frequencies topic to the list as well.
     */
 
-    for (int8_t i = 0; i < 3; i++) {
-        err[i] = xplrThingstreamPpParseTopicInfo(data,
-                                                 region,
-                                                 planType,
-                                                 (xplr_thingstream_pp_topic_type_t)i,
-                                                 &topics[i]);
-    }
+    root = tsApiMsgParsePpZtpPayload(data);
 
-    err[3] = xplrThingstreamPpParseTopicInfo(data,
+    for (int8_t i = 0; i < 3; i++) {
+        err[i] = tsApiMsgParsePpZtpTopicInfo(root,
                                              region,
                                              planType,
-                                             XPLR_THINGSTREAM_PP_TOPIC_FREQ,
-                                             &topics[3]);
+                                             (xplr_thingstream_pp_topic_type_t)i,
+                                             &topics[i]);
+    }
+
+    err[3] = tsApiMsgParsePpZtpTopicInfo(root,
+                                         region,
+                                         planType,
+                                         XPLR_THINGSTREAM_PP_TOPIC_FREQ,
+                                         &topics[3]);
+
+    cJSON_Delete(root);
 
     for (int8_t i = 0; i < 4; i++) {
         ret = err[i];
@@ -605,88 +568,12 @@ xplr_thingstream_error_t xplrThingstreamPpParseTopicsInfoByRegionAll(const char
                                                                      xplr_thingstream_pp_plan_t planType,
                                                                      xplr_thingstream_pp_topic_t *topics)
 {
-    xplr_thingstream_error_t err[7];
-    xplr_thingstream_error_t ret = XPLR_THINGSTREAM_ERROR;
-    uint8_t numOfTopics;
-    bool isRegionValid = (region == XPLR_THINGSTREAM_PP_REGION_EU) |
-                         (region == XPLR_THINGSTREAM_PP_REGION_US);
-
-    /* iterate through the topics type list and grab the info */
-    if (planType == XPLR_THINGSTREAM_PP_PLAN_LBAND) {
-        if (isRegionValid) {
-            /**
-            * For LBAND plan we need to parse 2 topics:
-            *  - Key distribution
-            *  - Frequencies
-            */
-            err[0] = xplrThingstreamPpParseTopicInfo(data,
-                                                     region,
-                                                     planType,
-                                                     XPLR_THINGSTREAM_PP_TOPIC_KEYS_DIST,
-                                                     &topics[0]);
-            err[1] = xplrThingstreamPpParseTopicInfo(data,
-                                                     region,
-                                                     planType,
-                                                     XPLR_THINGSTREAM_PP_TOPIC_FREQ,
-                                                     &topics[1]);
-            for (int8_t i = 0; i < 2; i++) {
-                ret = err[i];
-                if (err[i] != XPLR_THINGSTREAM_OK) {
-                    break;
-                }
-            }
-        } else {
-            XPLR_THINGSTREAM_CONSOLE(E, "LBAND plan is not supported in your region");
-            ret = XPLR_THINGSTREAM_ERROR;
-        }
-    } else if (region == XPLR_THINGSTREAM_PP_REGION_AU) {
-        // AU region has 2 MQTT topics
-        for (int8_t i = 0; i < 2; i++) {
-            err[i] = xplrThingstreamPpParseTopicInfo(data,
-                                                     region,
-                                                     planType,
-                                                     (xplr_thingstream_pp_topic_type_t)i,
-                                                     &topics[i]);
-        }
-        for (int8_t i = 0; i < 2; i++) {
-            ret = err[i];
-            if (err[i] != XPLR_THINGSTREAM_OK) {
-                break;
-            }
-        }
-    } else if (region == XPLR_THINGSTREAM_PP_REGION_KR &&
-               planType == XPLR_THINGSTREAM_PP_PLAN_IPLBAND) {
-        XPLR_THINGSTREAM_CONSOLE(E, "IP+LBAND plan is not supported in Korea region");
-        ret = XPLR_THINGSTREAM_ERROR;
-    } else {
-        /* IP plan has 6 topics, IPLBAND plan has 7 topics (6 + frequencies) */
-        if (planType == XPLR_THINGSTREAM_PP_PLAN_IP) {
-            numOfTopics = 6;
-        } else if (planType == XPLR_THINGSTREAM_PP_PLAN_IPLBAND) {
-            if (isRegionValid) {
-                numOfTopics = 7;
-            } else {
-                numOfTopics = 6;
-            }
-        } else {
-            numOfTopics = 0;
-            ret = XPLR_THINGSTREAM_ERROR;
-        }
+    cJSON *root;
+    xplr_thingstream_error_t ret;
 
-        for (int8_t i = 0; i < numOfTopics; i++) {
-            err[i] = xplrThingstreamPpParseTopicInfo(data,
-                                                     region,
-                                                     planType,
-                                                     (xplr_thingstream_pp_topic_type_t)i,
-                                                     &topics[i]);
-        }
-        for (int8_t i = 0; i < numOfTopics; i++) {
-            ret = err[i];
-            if (err[i] != XPLR_THINGSTREAM_OK) {
-                break;
-            }
-        }
-    }
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpTopicsByRegionAll(root, region, planType, topics);
+    cJSON_Delete(root);
 
     return ret;
 }
@@ -694,13 +581,27 @@ xplr_thingstream_error_t xplrThingstreamPpParseTopicsInfoByRegionAll(const char
 xplr_thingstream_error_t xplrThingstreamPpParseTopicsInfoAll(const char *data,
                                                              xplr_thingstream_pp_topic_t *topics)
 {
-    return tsApiMsgParsePpZtpTopicList(data, topics);
+    cJSON *root;
+    xplr_thingstream_error_t ret;
+
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpTopicList(root, topics);
+    cJSON_Delete(root);
+
+    return ret;
 }
 
 xplr_thingstream_error_t xplrThingstreamPpParseDynamicKeys(const char *data,
                                                            xplr_thingstream_pp_dKeys_t *keys)
 {
-    return tsApiMsgParsePpZtpDkeys(data, keys);
+    cJSON *root;
+    xplr_thingstream_error_t ret;
+
+    root = tsApiMsgParsePpZtpPayload(data);
+    ret = tsApiMsgParsePpZtpDkeys(root, keys);
+    cJSON_Delete(root);
+
+    return ret;
 }
 
 bool xplrThingstreamPpMsgIsKeyDist(const char *name, const xplr_thingstream_t *instance)
@@ -1065,47 +966,48 @@ xplr_thingstream_error_t xplrThingstreamPpConfigFromFile(char *data,
                                                          bool lbandOverIpPreference,
                                                          xplr_thingstream_t *instance)
 {
+    cJSON *root;
     xplr_thingstream_error_t ret;
     xplr_thingstream_error_t err[7];
     uint8_t index;
+    /* cellular (ubxlib) expects certificates without LFs, format them accordingly */
+    bool certNewLines = (instance->connType != XPLR_THINGSTREAM_PP_CONN_CELL);
 
     // Null pointer check
     if (data == NULL) {
         XPLR_THINGSTREAM_CONSOLE(E, "Payload to parse is NULL!");
         ret = XPLR_THINGSTREAM_ERROR;
     } else {
+        // Parse the payload once, all getters below share the same tree
+        root = tsApiMsgParsePpZtpPayload(data);
         // Get Broker address and port
-        err[0] = tsPpConfigFileGetBroker(data, instance->pointPerfect.brokerAddress);
+        err[0] = tsPpConfigFileGetBroker(root, instance->pointPerfect.brokerAddress);
         instance->pointPerfect.brokerPort = brokerPort;
         // Get device ID
-        err[1] = tsPpConfigFileGetDeviceId(data, instance->pointPerfect.deviceId);
+        err[1] = tsPpConfigFileGetDeviceId(root, instance->pointPerfect.deviceId);
         // Get MQTT Key
-        err[2] = tsPpConfigFileGetClientKey(data, instance->pointPerfect.clientKey);
+        err[2] = tsPpConfigFileGetClientKey(root, instance->pointPerfect.clientKey, certNewLines);
         // Get MQTT Cert
-        err[3] = tsPpConfigFileGetClientCert(data, instance->pointPerfect.clientCert);
+        err[3] = tsPpConfigFileGetClientCert(root, instance->pointPerfect.clientCert, certNewLines);
         // Get Root CA
-        err[4] = tsPpConfigFileGetRootCa(data, instance->server.rootCa);
+        err[4] = tsPpConfigFileGetRootCa(root, instance->server.rootCa, certNewLines);
         // Get Dynamic Keys
-        err[5] = tsPpConfigFileGetDynamicKeys(data, &instance->pointPerfect.dynamicKeys);
+        err[5] = tsPpConfigFileGetDynamicKeys(root, &instance->pointPerfect.dynamicKeys);
         // Get topics by region and num of topics and set mqtt and lband support flags
-        err[6] = tsPpConfigFileParseTopicsInfoByRegionAll(data,
+        err[6] = tsPpConfigFileParseTopicsInfoByRegionAll(root,
                                                           region,
                                                           lbandOverIpPreference,
                                                           &instance->pointPerfect);
+        cJSON_Delete(root);
         if ((instance->connType == XPLR_THINGSTREAM_PP_CONN_WIFI) && (err[0] == XPLR_THINGSTREAM_OK)) {
             tsPpModifyBroker(instance->pointPerfect.brokerAddress);
         } else if ((instance->connType == XPLR_THINGSTREAM_PP_CONN_CELL) &&
                    (err[0] == XPLR_THINGSTREAM_OK)) {
-            //Modify certs and broker
+            //Modify broker, certificates have already been formatted without LFs
             xplrAddPortInfo(instance->pointPerfect.brokerAddress, instance->pointPerfect.brokerPort);
-            if ((err[2] == XPLR_THINGSTREAM_OK) &&
-                (err[3] == XPLR_THINGSTREAM_OK) &&
-                (err[4] == XPLR_THINGSTREAM_OK)) {
-                /* remove LFs from certificates */
-                xplrRemoveChar(instance->pointPerfect.clientCert, '\n');
-                xplrRemoveChar(instance->pointPerfect.clientKey, '\n');
-                xplrRemoveChar(instance->server.rootCa, '\n');
-            } else {
+            if ((err[2] != XPLR_THINGSTREAM_OK) ||
+                (err[3] != XPLR_THINGSTREAM_OK) ||
+                (err[4] != XPLR_THINGSTREAM_OK)) {
                 XPLR_THINGSTREAM_CONSOLE(E, "Certificates are parsed incorrectly!");
                 err[0] = XPLR_THINGSTREAM_ERROR;
             }
@@ -1159,150 +1061,652 @@ xplr_thingstream_error_t xplrThingstreamCommConfigFromFile(char *data,
             if (err[i] != XPLR_THINGSTREAM_OK) {
                 ret = XPLR_THINGSTREAM_ERROR;
                 break;
-            } else {
-                ret = XPLR_THINGSTREAM_OK;
-            }
-        }
-    }
-    return ret;
-}
-
-int8_t xplrThingstreamInitLogModule(xplr_cfg_logInstance_t *logCfg)
-{
-    int8_t ret;
-    xplrLog_error_t logErr;
-
-    if (logIndex < 0) {
-        /* logIndex is negative so logging has not been initialized before */
-        if (logCfg == NULL) {
-            /* logCfg is NULL so we will use the default module settings */
-            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
-                                   XPLR_THINGSTREAM_DEFAULT_FILENAME,
-                                   XPLRLOG_FILE_SIZE_INTERVAL,
-                                   XPLRLOG_NEW_FILE_ON_BOOT);
-        } else {
-            /* logCfg contains the instance settings */
-            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
-                                   logCfg->filename,
-                                   logCfg->sizeInterval,
-                                   logCfg->erasePrev);
-        }
-        ret = logIndex;
-    } else {
-        /* logIndex is positive so logging has been initialized before */
-        logErr = xplrLogEnable(logIndex);
-        if (logErr != XPLR_LOG_OK) {
-            ret = -1;
-        } else {
-            ret = logIndex;
+            } else {
+                ret = XPLR_THINGSTREAM_OK;
+            }
+        }
+    }
+    return ret;
+}
+
+xplr_thingstream_error_t xplrThingstreamPpCacheSave(const xplr_thingstream_t *settings,
+                                                    xplr_thingstream_pp_region_t region,
+                                                    bool lbandOverIpPreference)
+{
+    const xplr_thingstream_pp_settings_t *pp;
+    uint32_t tag;
+    uint8_t numOfTopics;
+    uint8_t flags = 0;
+    size_t bytes = 0;
+    xplrNvs_error_t err;
+    xplr_thingstream_error_t ret;
+
+    if ((settings == NULL) || (tsCacheOpen() != XPLR_THINGSTREAM_OK)) {
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else {
+        pp = &settings->pointPerfect;
+        tag = tsCacheTag(settings, region, lbandOverIpPreference);
+        if (pp->numOfTopics > XPLR_THINGSTREAM_PP_NUMOF_TOPICS_MAX) {
+            numOfTopics = XPLR_THINGSTREAM_PP_NUMOF_TOPICS_MAX;
+        } else {
+            numOfTopics = (uint8_t)pp->numOfTopics;
+        }
+        if (pp->mqttSupported) {
+            flags |= XPLR_THINGSTREAM_CACHE_FLAG_MQTT;
+        } else {
+            // do nothing
+        }
+        if (pp->lbandSupported) {
+            flags |= XPLR_THINGSTREAM_CACHE_FLAG_LBAND;
+        } else {
+            // do nothing
+        }
+
+        /*
+         * drop the old result (tag included) first: a cache interrupted while
+         * written is never loaded and the new one has the whole namespace
+         */
+        err = xplrNvsErase(&tsCacheNvs);
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_URL,
+                                  pp->urlPath,
+                                  sizeof(pp->urlPath),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_BROKER,
+                                  pp->brokerAddress,
+                                  sizeof(pp->brokerAddress),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsWriteU16(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_PORT, pp->brokerPort);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_DEVICEID,
+                                  pp->deviceId,
+                                  sizeof(pp->deviceId),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_CLIENTKEY,
+                                  pp->clientKey,
+                                  sizeof(pp->clientKey),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_CLIENTCERT,
+                                  pp->clientCert,
+                                  sizeof(pp->clientCert),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsWriteU8(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_FLAGS, flags);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsWriteBlob(&tsCacheNvs,
+                                   XPLR_THINGSTREAM_CACHE_KEY_DKEYS,
+                                   &pp->dynamicKeys,
+                                   sizeof(pp->dynamicKeys));
+            bytes += sizeof(pp->dynamicKeys);
+        }
+        for (uint8_t i = 0; (err == XPLR_NVS_OK) && (i < numOfTopics); i++) {
+            err = tsCacheWriteTopic(i, &pp->topicList[i], &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsWriteU8(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_TOPICS, numOfTopics);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheWriteStr(XPLR_THINGSTREAM_CACHE_KEY_ROOTCA,
+                                  settings->server.rootCa,
+                                  sizeof(settings->server.rootCa),
+                                  &bytes);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsWriteU32(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_TAG, tag);
+        }
+
+        if (err != XPLR_NVS_OK) {
+            /* do not leave a partial result taking space */
+            (void)xplrNvsErase(&tsCacheNvs);
+            XPLR_THINGSTREAM_CONSOLE(E,
+                                     "Could not store ZTP result (%u bytes), is the nvs partition full?",
+                                     bytes);
+            ret = XPLR_THINGSTREAM_ERROR;
+        } else {
+            XPLR_THINGSTREAM_CONSOLE(D, "ZTP result stored, %u topics, %u bytes.", numOfTopics, bytes);
+            ret = XPLR_THINGSTREAM_OK;
+        }
+    }
+
+    return ret;
+}
+
+xplr_thingstream_error_t xplrThingstreamPpCacheLoad(xplr_thingstream_t *settings,
+                                                    xplr_thingstream_pp_region_t region,
+                                                    bool lbandOverIpPreference)
+{
+    uint32_t tag = 0;
+    uint16_t port = 0;
+    uint8_t numOfTopics = 0;
+    uint8_t flags = 0;
+    size_t size;
+    xplr_thingstream_pp_settings_t *pp;
+    xplrNvs_error_t err;
+    xplr_thingstream_error_t ret;
+
+    if ((settings == NULL) || (tsCacheOpen() != XPLR_THINGSTREAM_OK)) {
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else if ((xplrNvsReadU32(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_TAG, &tag) != XPLR_NVS_OK) ||
+               (tag != tsCacheTag(settings, region, lbandOverIpPreference))) {
+        XPLR_THINGSTREAM_CONSOLE(D, "No stored ZTP result for this token and region.");
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else {
+        pp = &settings->pointPerfect;
+        err = tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_URL, pp->urlPath, sizeof(pp->urlPath));
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_BROKER,
+                                 pp->brokerAddress,
+                                 sizeof(pp->brokerAddress));
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsReadU16(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_PORT, &port);
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_DEVICEID, pp->deviceId, sizeof(pp->deviceId));
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_CLIENTKEY, pp->clientKey, sizeof(pp->clientKey));
+        }
+        if (err == XPLR_NVS_OK) {
+            err = tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_CLIENTCERT,
+                                 pp->clientCert,
+                                 sizeof(pp->clientCert));
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsReadU8(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_FLAGS, &flags);
+        }
+        if (err == XPLR_NVS_OK) {
+            size = sizeof(pp->dynamicKeys);
+            err = xplrNvsReadBlob(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_DKEYS, &pp->dynamicKeys, &size);
+            if ((err == XPLR_NVS_OK) && (size != sizeof(pp->dynamicKeys))) {
+                err = XPLR_NVS_ERROR;
+            }
+        }
+        if (err == XPLR_NVS_OK) {
+            err = xplrNvsReadU8(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_TOPICS, &numOfTopics);
+            if ((err == XPLR_NVS_OK) && (numOfTopics > XPLR_THINGSTREAM_PP_NUMOF_TOPICS_MAX)) {
+                err = XPLR_NVS_ERROR;
+            }
+        }
+        for (uint8_t i = 0; (err == XPLR_NVS_OK) && (i < numOfTopics); i++) {
+            err = tsCacheReadTopic(i, &pp->topicList[i]);
+        }
+
+        if (err != XPLR_NVS_OK) {
+            XPLR_THINGSTREAM_CONSOLE(E, "Stored ZTP result is corrupted.");
+            ret = XPLR_THINGSTREAM_ERROR;
+        } else {
+            pp->brokerPort = port;
+            pp->mqttSupported = ((flags & XPLR_THINGSTREAM_CACHE_FLAG_MQTT) != 0);
+            pp->lbandSupported = ((flags & XPLR_THINGSTREAM_CACHE_FLAG_LBAND) != 0);
+            pp->numOfTopics = numOfTopics;
+            if (tsCacheReadStr(XPLR_THINGSTREAM_CACHE_KEY_ROOTCA,
+                               settings->server.rootCa,
+                               sizeof(settings->server.rootCa)) != XPLR_NVS_OK) {
+                settings->server.rootCa[0] = 0;
+            }
+            tsPpSetDescFilter(pp);
+            XPLR_THINGSTREAM_CONSOLE(I, "ZTP result loaded from storage, %u topics.", pp->numOfTopics);
+            ret = XPLR_THINGSTREAM_OK;
+        }
+    }
+
+    return ret;
+}
+
+bool xplrThingstreamPpCacheNeedsRefresh(const xplr_thingstream_t *settings, uint64_t nowMs)
+{
+    const xplr_thingstream_pp_dKeys_t *keys = &settings->pointPerfect.dynamicKeys;
+    uint64_t validUntil;
+    bool ret;
+
+    /* the keys given last are valid until the end of the later one */
+    validUntil = keys->current.start + keys->current.duration;
+    if ((keys->next.start + keys->next.duration) > validUntil) {
+        validUntil = keys->next.start + keys->next.duration;
+    }
+
+    if (nowMs == 0) {
+        /* time unknown, keys keep arriving over MQTT in the meantime */
+        ret = false;
+    } else if ((nowMs + ((uint64_t)XPLRTHINGSTREAM_CACHE_REFRESH_MARGIN_S * 1000ULL)) >= validUntil) {
+        XPLR_THINGSTREAM_CONSOLE(I, "Dynamic keys expire in less than %us, ZTP refresh needed.",
+                                 XPLRTHINGSTREAM_CACHE_REFRESH_MARGIN_S);
+        ret = true;
+    } else {
+        ret = false;
+    }
+
+    return ret;
+}
+
+xplr_thingstream_error_t xplrThingstreamPpCacheInvalidate(void)
+{
+    xplr_thingstream_error_t ret;
+
+    if ((tsCacheOpen() != XPLR_THINGSTREAM_OK) ||
+        (xplrNvsEraseKey(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_KEY_TAG) != XPLR_NVS_OK)) {
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else {
+        XPLR_THINGSTREAM_CONSOLE(D, "Stored ZTP result dropped.");
+        ret = XPLR_THINGSTREAM_OK;
+    }
+
+    return ret;
+}
+
+int8_t xplrThingstreamInitLogModule(xplr_cfg_logInstance_t *logCfg)
+{
+    int8_t ret;
+    xplrLog_error_t logErr;
+
+    if (logIndex < 0) {
+        /* logIndex is negative so logging has not been initialized before */
+        if (logCfg == NULL) {
+            /* logCfg is NULL so we will use the default module settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   XPLR_THINGSTREAM_DEFAULT_FILENAME,
+                                   XPLRLOG_FILE_SIZE_INTERVAL,
+                                   XPLRLOG_NEW_FILE_ON_BOOT);
+        } else {
+            /* logCfg contains the instance settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   logCfg->filename,
+                                   logCfg->sizeInterval,
+                                   logCfg->erasePrev);
+        }
+        ret = logIndex;
+    } else {
+        /* logIndex is positive so logging has been initialized before */
+        logErr = xplrLogEnable(logIndex);
+        if (logErr != XPLR_LOG_OK) {
+            ret = -1;
+        } else {
+            ret = logIndex;
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t xplrThingstreamStopLogModule(void)
+{
+    esp_err_t ret;
+    xplrLog_error_t logErr;
+
+    logErr = xplrLogDisable(logIndex);
+    if (logErr != XPLR_LOG_OK) {
+        ret = ESP_FAIL;
+    } else {
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DEFINITIONS
+ * -------------------------------------------------------------- */
+
+static xplr_thingstream_error_t tsCreateDeviceUid(char *uid)
+{
+    uint8_t mac[6];
+    int32_t err;
+    int32_t uidLength;
+    xplr_thingstream_error_t ret;
+
+    err = xplrGetDeviceMac(mac);
+
+    if (err != 0) {
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else {
+        uidLength = snprintf(uid,
+                             XPLR_THINGSTREAM_DEVICEUID_SIZE,
+                             "hpg-%02x%02x%02x",
+                             mac[3],
+                             mac[4],
+                             mac[5]);
+
+        if (uidLength < 0 || uidLength < XPLR_THINGSTREAM_DEVICEUID_SIZE - 1) {
+            ret = XPLR_THINGSTREAM_ERROR;
+        } else {
+            ret = XPLR_THINGSTREAM_OK;
+        }
+    }
+
+    return ret;
+}
+
+static xplr_thingstream_error_t tsApiMsgCreatePpZtp(char *msg, size_t *size,
+                                                    xplr_thingstream_t *settings)
+{
+    cJSON *root, *array, *element;
+    char *jMsg;
+    size_t jMsgSize;
+    xplr_thingstream_error_t ret;
+    ret = XPLR_THINGSTREAM_ERROR;
+
+    if ((strlen(settings->server.ppToken) != XPLR_THINGSTREAM_PP_TOKEN_SIZE - 1) ||
+        (strlen(settings->server.deviceId) != XPLR_THINGSTREAM_DEVICEUID_SIZE - 1)) {
+        ret = XPLR_THINGSTREAM_ERROR;
+        XPLR_THINGSTREAM_CONSOLE(E, "Token size or device uid invalid.");
+    } else {
+        root = cJSON_CreateObject();
+        array = cJSON_AddArrayToObject(root, "tags");
+        element = cJSON_CreateString("ztp");
+        cJSON_AddItemToArray(array, element);
+        cJSON_AddStringToObject(root, "token", settings->server.ppToken);
+        cJSON_AddStringToObject(root, "hardwareId", settings->server.deviceId);
+        cJSON_AddStringToObject(root, "givenName", "xplrHpg");
+        jMsg = cJSON_Print(root);
+        jMsgSize = strlen(jMsg);
+        if (*size >= jMsgSize) {
+            memcpy(msg, jMsg, jMsgSize);
+            *size = jMsgSize;
+            ret = XPLR_THINGSTREAM_OK;
+            XPLR_THINGSTREAM_CONSOLE(D, "Thingstream API PP ZTP POST of %d bytes created:\n%s", *size, msg);
+        } else {
+            ret = XPLR_THINGSTREAM_ERROR;
+            XPLR_THINGSTREAM_CONSOLE(E, "json msg of %d bytes could not fit buffer of %d bytes.", jMsgSize,
+                                     *size);
+        }
+        cJSON_Delete(root);
+        cJSON_free(jMsg);
+    }
+
+    return ret;
+}
+
+static cJSON *tsApiMsgParsePpZtpPayload(const char *msg)
+{
+    cJSON *root;
+
+    if (msg != NULL) {
+        root = cJSON_Parse(msg);
+        if (root == NULL) {
+            XPLR_THINGSTREAM_CONSOLE(E, "input msg is not a valid json.");
+        }
+    } else {
+        root = NULL;
+        XPLR_THINGSTREAM_CONSOLE(E, "input msg is <NULL>.");
+    }
+
+    return root;
+}
+
+static xplr_thingstream_error_t tsApiMsgParsePpZtpServerInfo(const cJSON *root,
+                                                             char *value,
+                                                             size_t size,
+                                                             xplr_thingstream_pp_serverInfo_type_t info)
+{
+    xplr_thingstream_error_t ret;
+
+    switch (info) {
+        case XPLR_THINGSTREAM_PP_SERVER_ADDRESS:
+            ret = tsApiMsgParsePpZtpBrokerAddress(root, value, size);
+            break;
+        case XPLR_THINGSTREAM_PP_SERVER_CERT:
+            ret = tsApiMsgParsePpZtpClientCert(root, value, size);
+            break;
+        case XPLR_THINGSTREAM_PP_SERVER_KEY:
+            ret = tsApiMsgParsePpZtpClientKey(root, value, size);
+            break;
+        case XPLR_THINGSTREAM_PP_SERVER_ID:
+            ret = tsApiMsgParsePpZtpClientId(root, value, size);
+            break;
+
+        default:
+            ret = XPLR_THINGSTREAM_ERROR;
+            break;
+    }
+
+    return ret;
+}
+
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicInfo(const cJSON *root,
+                                                            xplr_thingstream_pp_region_t region,
+                                                            xplr_thingstream_pp_plan_t planType,
+                                                            xplr_thingstream_pp_topic_type_t type,
+                                                            xplr_thingstream_pp_topic_t *topic)
+{
+    const char *regionFilter, *topicFilter;
+    xplr_thingstream_error_t ret;
+
+    /* set region filter */
+    switch (region) {
+        case XPLR_THINGSTREAM_PP_REGION_EU:
+            regionFilter = thingstreamPpFilterRegionEU;
+            ret = XPLR_THINGSTREAM_OK;
+            break;
+        case XPLR_THINGSTREAM_PP_REGION_US:
+            regionFilter = thingstreamPpFilterRegionUS;
+            ret = XPLR_THINGSTREAM_OK;
+            break;
+        case XPLR_THINGSTREAM_PP_REGION_KR:
+            regionFilter = thingstreamPpFilterRegionKR;
+            ret = XPLR_THINGSTREAM_OK;
+            break;
+        case XPLR_THINGSTREAM_PP_REGION_AU:
+            regionFilter = thingstreamPpFilterRegionAU;
+            ret = XPLR_THINGSTREAM_OK;
+            break;
+        case XPLR_THINGSTREAM_PP_REGION_JP:
+            regionFilter = thingstreamPpFilterRegionJP;
+            ret = XPLR_THINGSTREAM_OK;
+            break;
+        default:
+            XPLR_THINGSTREAM_CONSOLE(E, "Region not supported.");
+            ret = XPLR_THINGSTREAM_ERROR;
+            break;
+    }
+
+    /* set topic filter */
+    if (ret != XPLR_THINGSTREAM_ERROR) {
+        switch (type) {
+            case XPLR_THINGSTREAM_PP_TOPIC_KEYS_DIST:
+                topicFilter = thingstreamPpFilterKeyDist;
+                /* key distribution topic does not contain region id. mask filter */
+                regionFilter = " ";
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_CORRECTION_DATA:
+                switch (planType) {
+                    case XPLR_THINGSTREAM_PP_PLAN_IP:
+                        topicFilter = thingstreamPpFilterCorrectionDataIp;
+                        ret = XPLR_THINGSTREAM_OK;
+                        break;
+                    case XPLR_THINGSTREAM_PP_PLAN_LBAND:
+                        topicFilter = thingstreamPpFilterCorrectionDataLb;
+                        ret = XPLR_THINGSTREAM_OK;
+                        break;
+                    case XPLR_THINGSTREAM_PP_PLAN_IPLBAND:
+                        topicFilter = thingstreamPpFilterCorrectionDataIpLb;
+                        ret = XPLR_THINGSTREAM_OK;
+                        break;
+                    case XPLR_THINGSTREAM_PP_PLAN_INVALID:
+                    default:
+                        ret = XPLR_THINGSTREAM_ERROR;
+                        break;
+                }
+                if (ret == XPLR_THINGSTREAM_OK) {
+                    thingstreamPpFilterCorrectionData = topicFilter;
+                }
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_GAD:
+                topicFilter = thingstreamPpFilterGAD;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_HPAC:
+                topicFilter = thingstreamPpFilterHPAC;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_OCB:
+                topicFilter = thingstreamPpFilterOCB;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_CLK:
+                topicFilter = thingstreamPpFilterClock;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_FREQ:
+                topicFilter = thingstreamPpFilterFreq;
+                /* frequencies topic does not contain region id. mask filter */
+                regionFilter = " ";
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_ALL_EU:
+                topicFilter = thingstreamPpFilterRegionEUAll;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_ALL_US:
+                topicFilter = thingstreamPpFilterRegionUSAll;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_ALL_KR:
+                topicFilter = thingstreamPpFilterRegionKRAll;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_ALL_JP:
+                topicFilter = thingstreamPpFilterRegionJPAll;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_ALL:
+                topicFilter = thingstreamPpFilterAll;
+                ret = XPLR_THINGSTREAM_OK;
+                break;
+            case XPLR_THINGSTREAM_PP_TOPIC_INVALID:
+                ret = XPLR_THINGSTREAM_ERROR;
+                break;
+
+            default:
+                ret = XPLR_THINGSTREAM_ERROR;
+                break;
         }
     }
 
-    return ret;
-}
-
-esp_err_t xplrThingstreamStopLogModule(void)
-{
-    esp_err_t ret;
-    xplrLog_error_t logErr;
-
-    logErr = xplrLogDisable(logIndex);
-    if (logErr != XPLR_LOG_OK) {
-        ret = ESP_FAIL;
-    } else {
-        ret = ESP_OK;
+    /* search for topic */
+    if (ret != XPLR_THINGSTREAM_ERROR) {
+        ret = tsApiMsgParsePpZtpTopic(root, regionFilter, topicFilter, topic);
     }
 
     return ret;
 }
 
-/* ----------------------------------------------------------------
- * STATIC FUNCTION DEFINITIONS
- * -------------------------------------------------------------- */
-
-static xplr_thingstream_error_t tsCreateDeviceUid(char *uid)
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicsByRegionAll(const cJSON *root,
+                                                                    xplr_thingstream_pp_region_t region,
+                                                                    xplr_thingstream_pp_plan_t planType,
+                                                                    xplr_thingstream_pp_topic_t *topics)
 {
-    uint8_t mac[6];
-    int32_t err;
-    int32_t uidLength;
-    xplr_thingstream_error_t ret;
-
-    err = xplrGetDeviceMac(mac);
-
-    if (err != 0) {
-        ret = XPLR_THINGSTREAM_ERROR;
-    } else {
-        uidLength = snprintf(uid,
-                             XPLR_THINGSTREAM_DEVICEUID_SIZE,
-                             "hpg-%02x%02x%02x",
-                             mac[3],
-                             mac[4],
-                             mac[5]);
+    xplr_thingstream_error_t err[7];
+    xplr_thingstream_error_t ret = XPLR_THINGSTREAM_ERROR;
+    uint8_t numOfTopics;
+    bool isRegionValid = (region == XPLR_THINGSTREAM_PP_REGION_EU) |
+                         (region == XPLR_THINGSTREAM_PP_REGION_US);
 
-        if (uidLength < 0 || uidLength < XPLR_THINGSTREAM_DEVICEUID_SIZE - 1) {
-            ret = XPLR_THINGSTREAM_ERROR;
+    /* iterate through the topics type list and grab the info */
+    if (planType == XPLR_THINGSTREAM_PP_PLAN_LBAND) {
+        if (isRegionValid) {
+            /**
+            * For LBAND plan we need to parse 2 topics:
+            *  - Key distribution
+            *  - Frequencies
+            */
+            err[0] = tsApiMsgParsePpZtpTopicInfo(root,
+                                                 region,
+                                                 planType,
+                                                 XPLR_THINGSTREAM_PP_TOPIC_KEYS_DIST,
+                                                 &topics[0]);
+            err[1] = tsApiMsgParsePpZtpTopicInfo(root,
+                                                 region,
+                                                 planType,
+                                                 XPLR_THINGSTREAM_PP_TOPIC_FREQ,
+                                                 &topics[1]);
+            for (int8_t i = 0; i < 2; i++) {
+                ret = err[i];
+                if (err[i] != XPLR_THINGSTREAM_OK) {
+                    break;
+                }
+            }
         } else {
-            ret = XPLR_THINGSTREAM_OK;
+            XPLR_THINGSTREAM_CONSOLE(E, "LBAND plan is not supported in your region");
+            ret = XPLR_THINGSTREAM_ERROR;
         }
-    }
-
-    return ret;
-}
-
-static xplr_thingstream_error_t tsApiMsgCreatePpZtp(char *msg, size_t *size,
-                                                    xplr_thingstream_t *settings)
-{
-    cJSON *root, *array, *element;
-    char *jMsg;
-    size_t jMsgSize;
-    xplr_thingstream_error_t ret;
-    ret = XPLR_THINGSTREAM_ERROR;
-
-    if ((strlen(settings->server.ppToken) != XPLR_THINGSTREAM_PP_TOKEN_SIZE - 1) ||
-        (strlen(settings->server.deviceId) != XPLR_THINGSTREAM_DEVICEUID_SIZE - 1)) {
+    } else if (region == XPLR_THINGSTREAM_PP_REGION_AU) {
+        // AU region has 2 MQTT topics
+        for (int8_t i = 0; i < 2; i++) {
+            err[i] = tsApiMsgParsePpZtpTopicInfo(root,
+                                                 region,
+                                                 planType,
+                                                 (xplr_thingstream_pp_topic_type_t)i,
+                                                 &topics[i]);
+        }
+        for (int8_t i = 0; i < 2; i++) {
+            ret = err[i];
+            if (err[i] != XPLR_THINGSTREAM_OK) {
+                break;
+            }
+        }
+    } else if (region == XPLR_THINGSTREAM_PP_REGION_KR &&
+               planType == XPLR_THINGSTREAM_PP_PLAN_IPLBAND) {
+        XPLR_THINGSTREAM_CONSOLE(E, "IP+LBAND plan is not supported in Korea region");
         ret = XPLR_THINGSTREAM_ERROR;
-        XPLR_THINGSTREAM_CONSOLE(E, "Token size or device uid invalid.");
     } else {
-        root = cJSON_CreateObject();
-        array = cJSON_AddArrayToObject(root, "tags");
-        element = cJSON_CreateString("ztp");
-        cJSON_AddItemToArray(array, element);
-        cJSON_AddStringToObject(root, "token", settings->server.ppToken);
-        cJSON_AddStringToObject(root, "hardwareId", settings->server.deviceId);
-        cJSON_AddStringToObject(root, "givenName", "xplrHpg");
-        jMsg = cJSON_Print(root);
-        jMsgSize = strlen(jMsg);
-        if (*size >= jMsgSize) {
-            memcpy(msg, jMsg, jMsgSize);
-            *size = jMsgSize;
-            ret = XPLR_THINGSTREAM_OK;
-            XPLR_THINGSTREAM_CONSOLE(D, "Thingstream API PP ZTP POST of %d bytes created:\n%s", *size, msg);
+        /* IP plan has 6 topics, IPLBAND plan has 7 topics (6 + frequencies) */
+        if (planType == XPLR_THINGSTREAM_PP_PLAN_IP) {
+            numOfTopics = 6;
+        } else if (planType == XPLR_THINGSTREAM_PP_PLAN_IPLBAND) {
+            if (isRegionValid) {
+                numOfTopics = 7;
+            } else {
+                numOfTopics = 6;
+            }
         } else {
+            numOfTopics = 0;
             ret = XPLR_THINGSTREAM_ERROR;
-            XPLR_THINGSTREAM_CONSOLE(E, "json msg of %d bytes could not fit buffer of %d bytes.", jMsgSize,
-                                     *size);
         }
-        cJSON_Delete(root);
-        cJSON_free(jMsg);
+
+        for (int8_t i = 0; i < numOfTopics; i++) {
+            err[i] = tsApiMsgParsePpZtpTopicInfo(root,
+                                                 region,
+                                                 planType,
+                                                 (xplr_thingstream_pp_topic_type_t)i,
+                                                 &topics[i]);
+        }
+        for (int8_t i = 0; i < numOfTopics; i++) {
+            ret = err[i];
+            if (err[i] != XPLR_THINGSTREAM_OK) {
+                break;
+            }
+        }
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpBrokerAddress(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpBrokerAddress(const cJSON *root,
                                                                 char *info,
                                                                 size_t infoSize)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     size_t jMsgSize;
     const char *key = tsPpBrokerTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsString(element);
         if (jBool) {
@@ -1320,26 +1724,24 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpBrokerAddress(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <String>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientCert(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientCert(const cJSON *root,
                                                              char *info,
                                                              size_t infoSize)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     size_t jMsgSize;
     const char *key = tsPpClientCertTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsString(element);
         if (jBool) {
@@ -1358,26 +1760,24 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpClientCert(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <String>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientKey(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientKey(const cJSON *root,
                                                             char *info,
                                                             size_t infoSize)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     size_t jMsgSize;
     const char *key = tsPpClientKeyTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsString(element);
         if (jBool) {
@@ -1396,26 +1796,24 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpClientKey(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <String>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpClientId(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpClientId(const cJSON *root,
                                                            char *info,
                                                            size_t infoSize)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     size_t jMsgSize;
     const char *key = tsPpClientIdTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsString(element);
         if (jBool) {
@@ -1433,24 +1831,22 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpClientId(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <String>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpLbandSupport(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpLbandSupport(const cJSON *root,
                                                                bool *supported)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     const char *key = tsPpLbandSupportTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsBool(element);
         if (jBool) {
@@ -1461,24 +1857,22 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpLbandSupport(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <Bool>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpMqttSupport(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpMqttSupport(const cJSON *root,
                                                               bool *supported)
 {
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     const char *key = tsPpMqttSupportTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         element = cJSON_GetObjectItem(root, key);
         jBool = cJSON_IsBool(element);
         if (jBool) {
@@ -1489,25 +1883,23 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpMqttSupport(const char *msg,
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "json element not of type <Bool>.");
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpDkeys(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpDkeys(const cJSON *root,
                                                         xplr_thingstream_pp_dKeys_t *dKeys)
 {
-    cJSON *root, *jArrDkeys, *jObjDkeyCurrent, *jObjDkeyNext;
+    cJSON *jArrDkeys, *jObjDkeyCurrent, *jObjDkeyNext;
     bool curKeyPresent, nextKeyPresent;
     char *jKeyVal;
     const char *key = tsPpDkeysTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         jArrDkeys = cJSON_GetObjectItem(root, key);
         curKeyPresent = cJSON_HasObjectItem(jArrDkeys, tsPpDkeyCurrentTag);
         nextKeyPresent = cJSON_HasObjectItem(jArrDkeys, tsPpDkeyNextTag);
@@ -1571,18 +1963,17 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpDkeys(const char *msg,
             XPLR_THINGSTREAM_CONSOLE(E, "Tag <%s> or <%s> not found.", tsPpDkeyCurrentTag, tsPpDkeyNextTag);
             ret = XPLR_THINGSTREAM_ERROR;
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const cJSON *root,
                                                         const char *regionFilter,
                                                         const char *typeFilter,
                                                         xplr_thingstream_pp_topic_t *topic)
 {
-    cJSON *root, *jArrSubs, *jObjTopic, *jElDesc, *jElPath;
+    cJSON *jArrSubs, *jObjTopic, *jElDesc, *jElPath;
     size_t topicListSize;
     char *description, *path;
     char *regionFound, *typeFound;
@@ -1590,10 +1981,9 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const char *msg,
     const char *key = tsPpTopicsTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         jArrSubs = cJSON_GetObjectItem(root, key);
         topicListSize = cJSON_GetArraySize(jArrSubs);
         for (int i = 0; i < topicListSize; i++) {
@@ -1690,26 +2080,24 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpTopic(const char *msg,
         if (ret != XPLR_THINGSTREAM_ERROR) {
             XPLR_THINGSTREAM_CONSOLE(D, "Parsed %s @ %s.", topic->description, topic->path);
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicList(const char *msg,
+static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicList(const cJSON *root,
                                                             xplr_thingstream_pp_topic_t *topic)
 {
-    cJSON *root, *jArrSubs, *jObjTopic, *jElDesc, *jElPath;
+    cJSON *jArrSubs, *jObjTopic, *jElDesc, *jElPath;
     size_t topicListSize;
     char *description, *path;
     size_t descSize, pathSize;
     const char *key = tsPpTopicsTag;
     xplr_thingstream_error_t ret;
 
-    ret = tsApiMsgParsePpZtpCheckTag(msg, key);
+    ret = tsApiMsgParsePpZtpCheckTag(root, key);
 
     if (ret != XPLR_THINGSTREAM_ERROR) {
-        root = cJSON_Parse(msg);
         jArrSubs = cJSON_GetObjectItem(root, key);
         topicListSize = cJSON_GetArraySize(jArrSubs);
         if (topicListSize <= XPLR_THINGSTREAM_PP_NUMOF_TOPICS_MAX) {
@@ -1759,20 +2147,17 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpTopicList(const char *msg,
                                      XPLR_THINGSTREAM_PP_NUMOF_TOPICS_MAX);
             ret = XPLR_THINGSTREAM_ERROR;
         }
-        cJSON_Delete(root);
     }
 
     return ret;
 }
 
-static xplr_thingstream_error_t tsApiMsgParsePpZtpCheckTag(const char *msg, const char *tag)
+static xplr_thingstream_error_t tsApiMsgParsePpZtpCheckTag(const cJSON *root, const char *tag)
 {
-    cJSON *root;
     cJSON_bool jBool;
     xplr_thingstream_error_t ret;
 
-    if (msg != NULL) {
-        root = cJSON_Parse(msg);
+    if (root != NULL) {
         jBool = cJSON_HasObjectItem(root, tag);
         if (jBool) {
             ret = XPLR_THINGSTREAM_OK;
@@ -1781,10 +2166,9 @@ static xplr_thingstream_error_t tsApiMsgParsePpZtpCheckTag(const char *msg, cons
             ret = XPLR_THINGSTREAM_ERROR;
             XPLR_THINGSTREAM_CONSOLE(E, "Tag <%s> not found.", tag);
         }
-        cJSON_Delete(root);
     } else {
         ret = XPLR_THINGSTREAM_ERROR;
-        XPLR_THINGSTREAM_CONSOLE(E, "input msg is <NULL>.");
+        XPLR_THINGSTREAM_CONSOLE(E, "input json is <NULL>.");
     }
 
     return ret;
@@ -2000,18 +2384,17 @@ static void tsPpModifyBroker(char *brokerAddress)
     strcpy(brokerAddress, modifiedBroker);
 }
 
-static xplr_thingstream_error_t tsPpConfigFileGetBroker(char *payload, char *brokerAddress)
+static xplr_thingstream_error_t tsPpConfigFileGetBroker(cJSON *root, char *brokerAddress)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     char *token;
     char *keys[] = {"MQTT", "Connectivity", "ServerURI"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = root;
             for (int i = 0; i < 3; i++) {
                 jBool = cJSON_HasObjectItem(element, keys[i]);
@@ -2045,29 +2428,27 @@ static xplr_thingstream_error_t tsPpConfigFileGetBroker(char *payload, char *bro
                 XPLR_THINGSTREAM_CONSOLE(E, "Parsing Failed!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
 
-static xplr_thingstream_error_t tsPpConfigFileGetDeviceId(char *payload, char *deviceId)
+static xplr_thingstream_error_t tsPpConfigFileGetDeviceId(cJSON *root, char *deviceId)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     char *keys[] = {"MQTT", "Connectivity", "ClientID"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = root;
             for (int i = 0; i < 3; i++) {
                 jBool = cJSON_HasObjectItem(element, keys[i]);
@@ -2099,28 +2480,28 @@ static xplr_thingstream_error_t tsPpConfigFileGetDeviceId(char *payload, char *d
                 XPLR_THINGSTREAM_CONSOLE(E, "Parsing Failed!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
-static xplr_thingstream_error_t tsPpConfigFileGetClientKey(char *payload, char *clientKey)
+static xplr_thingstream_error_t tsPpConfigFileGetClientKey(cJSON *root,
+                                                           char *clientKey,
+                                                           bool addNewLines)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     char *keys[] = {"MQTT", "Connectivity", "ClientCredentials", "Key"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = root;
             for (int i = 0; i < 4; i++) {
                 jBool = cJSON_HasObjectItem(element, keys[i]);
@@ -2139,7 +2520,9 @@ static xplr_thingstream_error_t tsPpConfigFileGetClientKey(char *payload, char *
                     XPLR_THINGSTREAM_CONSOLE(D, "Parsed Client Key from configuration payload");
                     if (strlen(element->valuestring) <= XPLR_THINGSTREAM_CERT_SIZE_MAX) {
                         strcpy(clientKey, element->valuestring);
-                        ret = tsPpConfigFileFormatCert(clientKey, XPLR_THINGSTREAM_PP_SERVER_KEY);
+                        ret = tsPpConfigFileFormatCert(clientKey,
+                                                       XPLR_THINGSTREAM_PP_SERVER_KEY,
+                                                       addNewLines);
                     } else {
                         XPLR_THINGSTREAM_CONSOLE(E, "Parsed Client Key larger tha CERT_SIZE_MAX!");
                         ret = XPLR_THINGSTREAM_ERROR;
@@ -2152,29 +2535,29 @@ static xplr_thingstream_error_t tsPpConfigFileGetClientKey(char *payload, char *
                 XPLR_THINGSTREAM_CONSOLE(E, "Parsing Failed!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
 
-static xplr_thingstream_error_t tsPpConfigFileGetClientCert(char *payload, char *clientCert)
+static xplr_thingstream_error_t tsPpConfigFileGetClientCert(cJSON *root,
+                                                            char *clientCert,
+                                                            bool addNewLines)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     char *keys[] = {"MQTT", "Connectivity", "ClientCredentials", "Cert"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = root;
             for (int i = 0; i < 4; i++) {
                 jBool = cJSON_HasObjectItem(element, keys[i]);
@@ -2193,7 +2576,9 @@ static xplr_thingstream_error_t tsPpConfigFileGetClientCert(char *payload, char
                     XPLR_THINGSTREAM_CONSOLE(D, "Parsed Client Cert from configuration payload");
                     if (strlen(element->valuestring) <= XPLR_THINGSTREAM_CERT_SIZE_MAX) {
                         strcpy(clientCert, element->valuestring);
-                        ret = tsPpConfigFileFormatCert(clientCert, XPLR_THINGSTREAM_PP_SERVER_CERT);
+                        ret = tsPpConfigFileFormatCert(clientCert,
+                                                       XPLR_THINGSTREAM_PP_SERVER_CERT,
+                                                       addNewLines);
                     } else {
                         XPLR_THINGSTREAM_CONSOLE(E, "Parsed Client Cert larger than CERT_SIZE_MAX!");
                     }
@@ -2205,29 +2590,29 @@ static xplr_thingstream_error_t tsPpConfigFileGetClientCert(char *payload, char
                 XPLR_THINGSTREAM_CONSOLE(E, "Parsing Failed!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
 
-static xplr_thingstream_error_t tsPpConfigFileGetRootCa(char *payload, char *rootCa)
+static xplr_thingstream_error_t tsPpConfigFileGetRootCa(cJSON *root,
+                                                        char *rootCa,
+                                                        bool addNewLines)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element;
+    cJSON *element;
     cJSON_bool jBool;
     char *keys[] = {"MQTT", "Connectivity", "ClientCredentials", "RootCA"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = root;
             for (int i = 0; i < 4; i++) {
                 jBool = cJSON_HasObjectItem(element, keys[i]);
@@ -2246,7 +2631,9 @@ static xplr_thingstream_error_t tsPpConfigFileGetRootCa(char *payload, char *roo
                     XPLR_THINGSTREAM_CONSOLE(D, "Parsed Root CA from configuration payload");
                     if (strlen(element->valuestring) <= XPLR_THINGSTREAM_CERT_SIZE_MAX) {
                         strcpy(rootCa, element->valuestring);
-                        ret = tsPpConfigFileFormatCert(rootCa, XPLR_THINGSTREAM_PP_SERVER_ROOTCA);
+                        ret = tsPpConfigFileFormatCert(rootCa,
+                                                       XPLR_THINGSTREAM_PP_SERVER_ROOTCA,
+                                                       addNewLines);
                     } else {
                         XPLR_THINGSTREAM_CONSOLE(E, "Parsed Root CA larger than CERT_MAX_SIZE");
                         ret = XPLR_THINGSTREAM_ERROR;
@@ -2259,31 +2646,29 @@ static xplr_thingstream_error_t tsPpConfigFileGetRootCa(char *payload, char *roo
                 XPLR_THINGSTREAM_CONSOLE(E, "Parsing Failed!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
-static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(char *payload,
+static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(cJSON *root,
                                                              xplr_thingstream_pp_dKeys_t *dynamicKeys)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element, *currKey, *nextKey;
+    cJSON *element, *currKey, *nextKey;
     cJSON_bool jBool, hasCurrKey, hasNextKey;
     char *value;
     char *keysFilter[] = {"MQTT", "dynamicKeys", "current", "next"};
     char *keysTags[] = {"duration", "start", "value"};
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, keysFilter[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, keysFilter[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = cJSON_GetObjectItem(root, keysFilter[0]);
             jBool = cJSON_HasObjectItem(element, keysFilter[1]);
             if (jBool) {
@@ -2315,7 +2700,7 @@ static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(char *payload,
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
 
@@ -2334,23 +2719,22 @@ static xplr_thingstream_error_t tsPpConfigFileGetDynamicKeys(char *payload,
     return ret;
 }
 
-static xplr_thingstream_error_t tsPpConfigFileParseTopicsInfoByRegionAll(char *payload,
+static xplr_thingstream_error_t tsPpConfigFileParseTopicsInfoByRegionAll(cJSON *root,
                                                                          xplr_thingstream_pp_region_t region,
                                                                          bool lbandOverIpPreference,
                                                                          xplr_thingstream_pp_settings_t *settings)
 {
     xplr_thingstream_error_t ret;
-    cJSON *root, *element, *keyDist, *corrData;
+    cJSON *element, *keyDist, *corrData;
     cJSON_bool jBool, hasCorrData, hasKeyDist;
     char *subKeys[] = {"MQTT", "Subscriptions", "Key", "Data"};
     const char *secTopicsDesc[] = {thingstreamPpFilterGAD, thingstreamPpFilterHPAC, thingstreamPpFilterOCB, thingstreamPpFilterClock, thingstreamPpFilterFreq};
     char *token, *corrTopic, *secondaryTopics;
     int arraySize, index;
 
-    if (payload != NULL) {
-        ret = tsApiMsgParsePpZtpCheckTag(payload, subKeys[0]);
+    if (root != NULL) {
+        ret = tsApiMsgParsePpZtpCheckTag(root, subKeys[0]);
         if (ret == XPLR_THINGSTREAM_OK) {
-            root = cJSON_Parse(payload);
             element = cJSON_GetObjectItem(root, subKeys[0]);
             jBool = cJSON_HasObjectItem(element, subKeys[1]);
             if (jBool) {
@@ -2528,20 +2912,20 @@ static xplr_thingstream_error_t tsPpConfigFileParseTopicsInfoByRegionAll(char *p
                 XPLR_THINGSTREAM_CONSOLE(E, "Subscription tag not found in configuration file payload!");
                 ret = XPLR_THINGSTREAM_ERROR;
             }
-            cJSON_Delete(root);
         } else {
             XPLR_THINGSTREAM_CONSOLE(E, "Configuration file invalid tags");
             ret = XPLR_THINGSTREAM_ERROR;
         }
     } else {
-        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to file payload!");
+        XPLR_THINGSTREAM_CONSOLE(E, "NULL pointer to configuration payload tree!");
         ret = XPLR_THINGSTREAM_ERROR;
     }
     return ret;
 }
 
 static xplr_thingstream_error_t tsPpConfigFileFormatCert(char *cert,
-                                                         xplr_thingstream_pp_serverInfo_type_t type)
+                                                         xplr_thingstream_pp_serverInfo_type_t type,
+                                                         bool addNewLines)
 {
     esp_err_t espRet;
     xplr_thingstream_error_t ret;
@@ -2571,7 +2955,7 @@ static xplr_thingstream_error_t tsPpConfigFileFormatCert(char *cert,
             break;
     }
 
-    espRet = xplrPpConfigFileFormatCert(cert, commonCertType, true);
+    espRet = xplrPpConfigFileFormatCert(cert, commonCertType, addNewLines);
     if (espRet == ESP_OK) {
         ret = XPLR_THINGSTREAM_OK;
     } else {
@@ -2692,6 +3076,137 @@ static void tsPpSetDescFilter(xplr_thingstream_pp_settings_t *settings)
         }
     }
 }
+
+static xplr_thingstream_error_t tsCacheOpen(void)
+{
+    xplr_thingstream_error_t ret;
+
+    if (tsCacheNvsReady) {
+        ret = XPLR_THINGSTREAM_OK;
+    } else if (xplrNvsInit(&tsCacheNvs, XPLR_THINGSTREAM_CACHE_NVS_NAMESPACE) != XPLR_NVS_OK) {
+        XPLR_THINGSTREAM_CONSOLE(E, "Could not open ZTP result storage.");
+        ret = XPLR_THINGSTREAM_ERROR;
+    } else {
+        tsCacheNvsReady = true;
+        ret = XPLR_THINGSTREAM_OK;
+    }
+
+    return ret;
+}
+
+/*
+ * FNV-1a of everything the stored result depends on: token, connection
+ * type (certificates and broker are formatted per type), region, topic
+ * preference and the version of the stored layout.
+ */
+static uint32_t tsCacheTag(const xplr_thingstream_t *settings,
+                           xplr_thingstream_pp_region_t region,
+                           bool lbandOverIpPreference)
+{
+    uint32_t hash = 2166136261U;
+    int32_t extra[4] = {
+        (int32_t)settings->connType,
+        (int32_t)region,
+        (int32_t)lbandOverIpPreference,
+        (int32_t)XPLR_THINGSTREAM_CACHE_VERSION
+    };
+    const uint8_t *bytes = (const uint8_t *)extra;
+
+    for (size_t i = 0; (i < XPLR_THINGSTREAM_PP_TOKEN_SIZE) && (settings->server.ppToken[i] != 0); i++) {
+        hash = (hash ^ (uint8_t)settings->server.ppToken[i]) * 16777619U;
+    }
+    for (size_t i = 0; i < sizeof(extra); i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+static xplrNvs_error_t tsCacheWriteStr(const char *key, const char *value, size_t sizeMax, size_t *bytes)
+{
+    size_t len = strnlen(value, sizeMax);
+    xplrNvs_error_t ret;
+
+    if (len >= sizeMax) {
+        ret = XPLR_NVS_ERROR;
+    } else {
+        *bytes += len + 1;
+        ret = xplrNvsWriteString(&tsCacheNvs, key, value);
+    }
+
+    return ret;
+}
+
+static xplrNvs_error_t tsCacheReadStr(const char *key, char *value, size_t sizeMax)
+{
+    size_t size = sizeMax;
+
+    return xplrNvsReadString(&tsCacheNvs, key, value, &size);
+}
+
+/*
+ * A topic is stored as its QoS byte followed by the description and the
+ * path, both with their terminator.
+ */
+static xplrNvs_error_t tsCacheWriteTopic(uint8_t index, const xplr_thingstream_pp_topic_t *topic, size_t *bytes)
+{
+    uint8_t record[sizeof(xplr_thingstream_pp_topic_t)];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    size_t descLen = strnlen(topic->description, sizeof(topic->description));
+    size_t pathLen = strnlen(topic->path, sizeof(topic->path));
+    size_t size;
+    xplrNvs_error_t ret;
+
+    if ((descLen >= sizeof(topic->description)) || (pathLen >= sizeof(topic->path))) {
+        ret = XPLR_NVS_ERROR;
+    } else {
+        record[0] = topic->qos;
+        memcpy(&record[1], topic->description, descLen + 1);
+        memcpy(&record[2 + descLen], topic->path, pathLen + 1);
+        size = 3 + descLen + pathLen;
+        *bytes += size;
+        snprintf(key, sizeof(key), XPLR_THINGSTREAM_CACHE_KEY_TOPIC, index);
+        ret = xplrNvsWriteBlob(&tsCacheNvs, key, record, size);
+    }
+
+    return ret;
+}
+
+static xplrNvs_error_t tsCacheReadTopic(uint8_t index, xplr_thingstream_pp_topic_t *topic)
+{
+    uint8_t record[sizeof(xplr_thingstream_pp_topic_t)];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    const char *desc = (const char *)&record[1];
+    const char *path;
+    size_t size = sizeof(record);
+    size_t descLen;
+    size_t pathLen;
+    xplrNvs_error_t ret;
+
+    snprintf(key, sizeof(key), XPLR_THINGSTREAM_CACHE_KEY_TOPIC, index);
+    ret = xplrNvsReadBlob(&tsCacheNvs, key, record, &size);
+    if ((ret == XPLR_NVS_OK) && (size >= 3)) {
+        descLen = strnlen(desc, size - 1);
+        if ((descLen + 2 < size) && (descLen < sizeof(topic->description))) {
+            path = &desc[descLen + 1];
+            pathLen = strnlen(path, size - descLen - 2);
+            if ((pathLen + descLen + 3 == size) && (pathLen < sizeof(topic->path))) {
+                topic->qos = record[0];
+                memcpy(topic->description, desc, descLen + 1);
+                memcpy(topic->path, path, pathLen + 1);
+            } else {
+                ret = XPLR_NVS_ERROR;
+            }
+        } else {
+            ret = XPLR_NVS_ERROR;
+        }
+    } else {
+        ret = XPLR_NVS_ERROR;
+    }
+
+    return ret;
+}
+
 // End of file
 
 xplr_thingstream_pp_region_t xplrThingstreamRegionFromStr(const char *regionStr)
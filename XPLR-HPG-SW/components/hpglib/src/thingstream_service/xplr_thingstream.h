@@ -75,6 +75,8 @@ xplr_thingstream_error_t xplrThingstreamApiMsgCreate(xplr_thingstream_api_t cmd,
 /**
  * @brief Configure thingstream PointPerfect settings.
  *        Data provided must include the ztp response payload.
+ *        The payload is parsed once and all credentials, topics and
+ *        dynamic keys are copied directly to the settings struct.
  *
  * @param  data                  configuration payload from thingstream.
  * @param  region                thingstream location service region type
@@ -312,6 +314,56 @@ xplr_thingstream_error_t xplrThingstreamPpConfigFromFile(char *data,
 xplr_thingstream_error_t xplrThingstreamCommConfigFromFile(char *data,
                                                            xplr_thingstream_comm_thing_t *instance);
 
+/**
+ * @brief Store the PointPerfect settings obtained by ZTP in NVS, so that the next
+ *        boot can connect to the broker without repeating ZTP.
+ *        Broker, client id, certificates, dynamic keys, topics and root CA are stored,
+ *        each string at its real length (about 3 KB in total). The previous result is
+ *        erased first; on failure nothing is kept and an error is logged.
+ *
+ * @param  settings               thingstream instance configured by xplrThingstreamPpConfig().
+ * @param  region                 region given to xplrThingstreamPpConfig().
+ * @param  lbandOverIpPreference  preference given to xplrThingstreamPpConfig().
+ * @return XPLR_THINGSTREAM_OK on success, XPLR_THINGSTREAM_ERROR otherwise.
+ */
+xplr_thingstream_error_t xplrThingstreamPpCacheSave(const xplr_thingstream_t *settings,
+                                                    xplr_thingstream_pp_region_t region,
+                                                    bool lbandOverIpPreference);
+
+/**
+ * @brief Load the PointPerfect settings stored by xplrThingstreamPpCacheSave().
+ *        Only a result stored for the same token, connection type, region and
+ *        preference is loaded. Call after xplrThingstreamInit().
+ *
+ * @param  settings               thingstream instance to configure.
+ * @param  region                 thingstream location service region type.
+ * @param  lbandOverIpPreference  used on IPLBAND plan, when true the topic
+ *                                list is configured for LBAND.
+ * @return XPLR_THINGSTREAM_OK when settings were loaded, XPLR_THINGSTREAM_ERROR
+ *         when there is no usable stored result and ZTP has to run.
+ */
+xplr_thingstream_error_t xplrThingstreamPpCacheLoad(xplr_thingstream_t *settings,
+                                                    xplr_thingstream_pp_region_t region,
+                                                    bool lbandOverIpPreference);
+
+/**
+ * @brief Check if the dynamic keys of the settings are close to expiry, in which
+ *        case ZTP should run again to refresh the stored result.
+ *
+ * @param  settings  configured thingstream instance.
+ * @param  nowMs     current UTC time in ms since the Unix epoch, 0 when unknown.
+ * @return true when the keys expire within XPLRTHINGSTREAM_CACHE_REFRESH_MARGIN_S.
+ *         Always false when the time is unknown.
+ */
+bool xplrThingstreamPpCacheNeedsRefresh(const xplr_thingstream_t *settings, uint64_t nowMs);
+
+/**
+ * @brief Drop the stored ZTP result, e.g. when the broker rejects its credentials.
+ *
+ * @return XPLR_THINGSTREAM_OK on success, XPLR_THINGSTREAM_ERROR otherwise.
+ */
+xplr_thingstream_error_t xplrThingstreamPpCacheInvalidate(void);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
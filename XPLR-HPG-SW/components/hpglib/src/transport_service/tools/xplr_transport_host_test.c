@@ -0,0 +1,540 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of the transport failover (xplr_transport.c) over two loopback
+ * bearers (xplr_transport_loopback.c) standing in for Wi-Fi and cellular.
+ *
+ * Build on Linux:
+ *   gcc -O1 -g -fsanitize=address,undefined -I.. xplr_transport_host_test.c \
+ *       ../xplr_transport.c ../xplr_transport_loopback.c -o xplr_transport_host_test
+ *
+ * Usage:
+ *   xplr_transport_host_test       run all cases, exit code 0 when they pass
+ *
+ * A simulated caster sends a numbered correction frame every FRAME_PERIOD_MS
+ * to each connected bearer, after the connect time of that bearer. The client
+ * reads through the transport and records the frames it gets, duplicates are
+ * ignored as a GNSS receiver would. Each case checks the longest run of lost
+ * frames against the reconnect time of the bearer taking over. A bearer connect
+ * may block: the clock then advances while the caster keeps sending, and the
+ * frames are late instead of lost.
+ */
+
+#include "xplr_transport.h"
+#include "xplr_transport_loopback.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TICK_MS             (10U)
+#define FRAME_PERIOD_MS     (100U)
+#define FRAME_SIZE          (7U)
+#define FRAME_PREAMBLE      (0xD3U)
+#define FRAMES_MAX          (2000U)
+#define READ_SIZE           (64U)
+#define GGA_PERIOD_MS       (1000U)
+#define WIFI                (0U)
+#define CELL                (1U)
+#define BEARERS             (2U)
+
+typedef struct {
+    xplrTransportLoopback_t loopback;
+    uint32_t                connectMs;      /* time from connect to the first data */
+    bool                    stalled;        /* connected but the caster sends nothing */
+    uint32_t                connects;
+    uint32_t                connectedAt;
+    uint32_t                ggaReceived;
+    uint32_t                lost;           /* XPLR_TRANSPORT_EVENT_LOST count */
+} simBearer_t;
+
+typedef struct {
+    xplrTransport_t         transport;
+    simBearer_t             bearer[BEARERS];
+    uint32_t                now;
+    uint32_t                seq;            /* next frame sent */
+    bool                    got[FRAMES_MAX];
+    uint32_t                latency[FRAMES_MAX];    /* from sent to read, ms */
+    uint32_t                blockedMs;      /* time spent in blocking connects */
+    uint8_t                 parse[FRAME_SIZE];
+    uint32_t                parseLen;
+    uint32_t                switches;
+} sim_t;
+
+static sim_t sim;
+static unsigned failures;
+
+/* ----------------------------------------------------------------
+ * SIMULATION
+ * -------------------------------------------------------------- */
+
+static void onEvent(void *arg, xplrTransportEvent_t event, uint8_t bearer)
+{
+    sim_t *s = (sim_t *)arg;
+
+    if (event == XPLR_TRANSPORT_EVENT_LOST) {
+        s->bearer[bearer].lost++;
+    } else if (event == XPLR_TRANSPORT_EVENT_SWITCHED) {
+        s->switches++;
+    }
+}
+
+static void simInit(uint32_t wifiConnectMs, uint32_t cellConnectMs)
+{
+    static const char *names[BEARERS] = { "wifi", "cell" };
+    xplrTransportBearer_t bearers[BEARERS];
+    xplrTransportConfig_t cfg = {
+        .connectTimeoutMs = 4000U,
+        .rxTimeoutMs = 2000U,
+        .backoffMinMs = 1000U,
+        .backoffMaxMs = 8000U,
+        .onEvent = onEvent,
+        .eventArg = &sim
+    };
+    uint8_t i;
+
+    memset(&sim, 0, sizeof(sim));
+    sim.bearer[WIFI].connectMs = wifiConnectMs;
+    sim.bearer[CELL].connectMs = cellConnectMs;
+    for (i = 0; i < BEARERS; i++) {
+        xplrTransportLoopbackInit(&sim.bearer[i].loopback, false);
+        bearers[i].name = names[i];
+        bearers[i].ops = &xplrTransportLoopbackOps;
+        bearers[i].ctx = &sim.bearer[i].loopback;
+    }
+    (void)xplrTransportInit(&sim.transport, bearers, BEARERS, &cfg);
+}
+
+static void simCaster(void)
+{
+    uint8_t frame[FRAME_SIZE];
+    uint8_t gga[32];
+    simBearer_t *b;
+    uint8_t sum = 0;
+    uint8_t i;
+
+    for (i = 0; i < BEARERS; i++) {
+        b = &sim.bearer[i];
+        if (b->loopback.connects != b->connects) {
+            b->connects = b->loopback.connects;
+            b->connectedAt = sim.now;
+        }
+        b->ggaReceived += (uint32_t)xplrTransportLoopbackPull(&b->loopback, gga, sizeof(gga)) > 0;
+    }
+
+    if ((sim.now % FRAME_PERIOD_MS) == 0) {
+        frame[0] = FRAME_PREAMBLE;
+        for (i = 0; i < 4; i++) {
+            frame[1 + i] = (uint8_t)(sim.seq >> (8 * i));
+            sum += frame[1 + i];
+        }
+        frame[5] = (uint8_t)~sum;
+        frame[6] = '\n';
+        for (i = 0; i < BEARERS; i++) {
+            b = &sim.bearer[i];
+            if (b->loopback.connected && !b->stalled &&
+                ((int32_t)(sim.now - b->connectedAt) >= (int32_t)b->connectMs)) {
+                (void)xplrTransportLoopbackPush(&b->loopback, frame, sizeof(frame));
+            }
+        }
+        sim.seq++;
+    }
+}
+
+/* frames may be split or cut at a switch of bearer, resync on the preamble */
+static void simParse(const uint8_t *data, int32_t len)
+{
+    uint32_t seq;
+    uint8_t sum;
+    int32_t i;
+    uint8_t j;
+
+    for (i = 0; i < len; i++) {
+        if ((sim.parseLen == 0) && (data[i] != FRAME_PREAMBLE)) {
+            continue;
+        }
+        sim.parse[sim.parseLen++] = data[i];
+        if (sim.parseLen == FRAME_SIZE) {
+            seq = 0;
+            sum = 0;
+            for (j = 0; j < 4; j++) {
+                seq |= (uint32_t)sim.parse[1 + j] << (8 * j);
+                sum += sim.parse[1 + j];
+            }
+            sum = (uint8_t)~sum;
+            if ((sum == sim.parse[5]) && (sim.parse[6] == '\n') && (seq < FRAMES_MAX)) {
+                if (!sim.got[seq]) {
+                    sim.latency[seq] = sim.now - (seq * FRAME_PERIOD_MS);
+                }
+                sim.got[seq] = true;
+                sim.parseLen = 0;
+            } else {
+                /* not a frame, look for the next preamble */
+                for (j = 1; (j < FRAME_SIZE) && (sim.parse[j] != FRAME_PREAMBLE); j++) {
+                }
+                memmove(sim.parse, &sim.parse[j], FRAME_SIZE - j);
+                sim.parseLen = FRAME_SIZE - j;
+            }
+        }
+    }
+}
+
+/* the caster goes on while the client is blocked in a connect */
+static void simStall(void)
+{
+    simBearer_t *b;
+    uint32_t blocked = 0;
+    uint8_t i;
+
+    for (i = 0; i < BEARERS; i++) {
+        blocked += sim.bearer[i].loopback.blockedMs;
+    }
+    /* a connect made meanwhile is done at the end of the stall */
+    for (i = 0; i < BEARERS; i++) {
+        b = &sim.bearer[i];
+        if ((sim.blockedMs < blocked) && (b->loopback.connects != b->connects)) {
+            b->connects = b->loopback.connects;
+            b->connectedAt = sim.now + (blocked - sim.blockedMs);
+        }
+    }
+    while (sim.blockedMs < blocked) {
+        sim.now += TICK_MS;
+        sim.blockedMs += TICK_MS;
+        simCaster();
+    }
+}
+
+static void simRun(uint32_t untilMs)
+{
+    static const char gga[] = "$GPGGA,,,,,,0,,,,,,,,*66\r\n";
+    uint8_t buf[READ_SIZE];
+    int32_t len;
+
+    while (sim.now < untilMs) {
+        simCaster();
+        do {
+            len = xplrTransportRead(&sim.transport, buf, sizeof(buf), sim.now);
+            simParse(buf, len);
+            simStall();
+        } while (len > 0);
+        if ((sim.now % GGA_PERIOD_MS) == 0) {
+            (void)xplrTransportWrite(&sim.transport, gga, sizeof(gga) - 1, sim.now);
+            simStall();
+        }
+        sim.now += TICK_MS;
+    }
+}
+
+/* longest run of lost frames sent in [fromMs, toMs), in ms */
+static uint32_t simGap(uint32_t fromMs, uint32_t toMs)
+{
+    uint32_t run = 0;
+    uint32_t longest = 0;
+    uint32_t seq;
+
+    for (seq = fromMs / FRAME_PERIOD_MS; (seq < toMs / FRAME_PERIOD_MS) && (seq < sim.seq); seq++) {
+        run = sim.got[seq] ? 0 : run + 1;
+        if (run > longest) {
+            longest = run;
+        }
+    }
+
+    return longest * FRAME_PERIOD_MS;
+}
+
+/* longest delay of the frames sent in [fromMs, toMs) and read, in ms */
+static uint32_t simLatency(uint32_t fromMs, uint32_t toMs)
+{
+    uint32_t longest = 0;
+    uint32_t seq;
+
+    for (seq = fromMs / FRAME_PERIOD_MS; (seq < toMs / FRAME_PERIOD_MS) && (seq < sim.seq); seq++) {
+        if (sim.got[seq] && (sim.latency[seq] > longest)) {
+            longest = sim.latency[seq];
+        }
+    }
+
+    return longest;
+}
+
+static void expect(const char *name, bool ok, const char *what, long got)
+{
+    if (!ok) {
+        failures++;
+        printf("FAIL %s: %s (%ld)\n", name, what, got);
+    }
+}
+
+static void expectGap(const char *name, uint32_t fromMs, uint32_t toMs, uint32_t maxMs)
+{
+    uint32_t gap = simGap(fromMs, toMs);
+
+    expect(name, gap <= maxMs, "gap too long, ms", (long)gap);
+    printf("%-28s gap %5u ms (max %5u) switches %u\n", name, gap, maxMs, sim.switches);
+}
+
+static void expectLatency(const char *name, uint32_t fromMs, uint32_t toMs, uint32_t maxMs)
+{
+    uint32_t latency = simLatency(fromMs, toMs);
+
+    expect(name, latency <= maxMs, "frames too late, ms", (long)latency);
+    printf("%-28s late  %5u ms (max %5u) blocked %u ms\n", name, latency, maxMs, sim.blockedMs);
+}
+
+/* ----------------------------------------------------------------
+ * CASES
+ * -------------------------------------------------------------- */
+
+static void caseArguments(void)
+{
+    xplrTransportBearer_t bearers[XPLR_TRANSPORT_BEARERS_MAX + 1];
+    xplrTransportOps_t noRecv = xplrTransportLoopbackOps;
+    xplrTransportLoopback_t loopback;
+    xplrTransport_t transport;
+    uint8_t buf[8];
+    uint8_t i;
+
+    for (i = 0; i <= XPLR_TRANSPORT_BEARERS_MAX; i++) {
+        bearers[i].name = "lb";
+        bearers[i].ops = &xplrTransportLoopbackOps;
+        bearers[i].ctx = &loopback;
+    }
+    xplrTransportLoopbackInit(&loopback, false);
+    expect("arguments", xplrTransportInit(NULL, bearers, 1, NULL) == XPLR_TRANSPORT_ERROR, "no transport", 0);
+    expect("arguments", xplrTransportInit(&transport, NULL, 1, NULL) == XPLR_TRANSPORT_ERROR, "no bearers", 0);
+    expect("arguments", xplrTransportInit(&transport, bearers, 0, NULL) == XPLR_TRANSPORT_ERROR, "0 bearers", 0);
+    expect("arguments", xplrTransportInit(&transport, bearers, XPLR_TRANSPORT_BEARERS_MAX + 1, NULL) ==
+           XPLR_TRANSPORT_ERROR, "too many bearers", 0);
+    noRecv.recv = NULL;
+    bearers[1].ops = &noRecv;
+    expect("arguments", xplrTransportInit(&transport, bearers, 2, NULL) == XPLR_TRANSPORT_ERROR, "no recv", 0);
+    expect("arguments", xplrTransportInit(&transport, bearers, 1, NULL) == XPLR_TRANSPORT_OK, "defaults", 0);
+    expect("arguments", transport.cfg.rxTimeoutMs == XPLR_TRANSPORT_RX_TIMEOUT_MS_DEFAULT, "default timeout", 0);
+    expect("arguments", xplrTransportRead(&transport, NULL, sizeof(buf), 0) == 0, "no buffer", 0);
+    expect("arguments", xplrTransportWrite(&transport, buf, 0, 0) == XPLR_TRANSPORT_ERROR, "nothing to write", 0);
+    expect("arguments", xplrTransportGetActive(&transport) == -1, "nothing connected", 0);
+    printf("%-28s done\n", "arguments");
+}
+
+static void caseEcho(void)
+{
+    xplrTransportLoopback_t loopback;
+    xplrTransportBearer_t bearer = { "echo", &xplrTransportLoopbackOps, &loopback };
+    xplrTransport_t transport;
+    char buf[16] = { 0 };
+    int32_t len;
+
+    xplrTransportLoopbackInit(&loopback, true);
+    (void)xplrTransportInit(&transport, &bearer, 1, NULL);
+    expect("echo", xplrTransportWrite(&transport, "ping", 4, 0) == XPLR_TRANSPORT_OK, "write", 0);
+    len = xplrTransportRead(&transport, buf, sizeof(buf), 1);
+    expect("echo", (len == 4) && (memcmp(buf, "ping", 4) == 0), "read back", len);
+    expect("echo", xplrTransportGetBearerState(&transport, 0) == XPLR_TRANSPORT_BEARER_CONNECTED,
+           "connected", 0);
+    xplrTransportStop(&transport);
+    expect("echo", !loopback.connected, "stopped", 0);
+    printf("%-28s done\n", "echo");
+}
+
+/* GGA written while data waits on the bearer in use and on the background one */
+static void caseGgaPending(void)
+{
+    static const char gga[] = "$GPGGA,,,,,,0,,,,,,,,*66\r\n";
+    xplrTransportLoopback_t loopback[BEARERS];
+    xplrTransportBearer_t bearers[BEARERS] = {
+        { "wifi", &xplrTransportLoopbackOps, &loopback[WIFI] },
+        { "cell", &xplrTransportLoopbackOps, &loopback[CELL] }
+    };
+    xplrTransport_t transport;
+    char buf[64] = { 0 };
+    int32_t len;
+
+    xplrTransportLoopbackInit(&loopback[WIFI], false);
+    xplrTransportLoopbackInit(&loopback[CELL], false);
+    loopback[WIFI].refuse = true;
+    (void)xplrTransportInit(&transport, bearers, BEARERS, NULL);
+    (void)xplrTransportRead(&transport, buf, sizeof(buf), 0);
+    expect("gga pending", xplrTransportGetActive(&transport) == (int8_t)CELL, "on cell", 0);
+
+    /* wifi connects in the background once its backoff is over */
+    loopback[WIFI].refuse = false;
+    (void)xplrTransportLoopbackPush(&loopback[CELL], "cell", 4);
+    len = xplrTransportRead(&transport, buf, sizeof(buf), XPLR_TRANSPORT_BACKOFF_MIN_MS_DEFAULT);
+    expect("gga pending", len == 4, "cell read", len);
+    expect("gga pending", transport.candidate == (int8_t)WIFI, "wifi connecting", transport.candidate);
+
+    (void)xplrTransportLoopbackPush(&loopback[CELL], "corr", 4);
+    expect("gga pending", xplrTransportWrite(&transport, gga, sizeof(gga) - 1, 1100U) == XPLR_TRANSPORT_OK,
+           "write", 0);
+    len = xplrTransportRead(&transport, buf, sizeof(buf), 1100U);
+    expect("gga pending", (len == 4) && (memcmp(buf, "corr", 4) == 0), "cell data kept", len);
+
+    (void)xplrTransportLoopbackPush(&loopback[WIFI], "wifi", 4);
+    expect("gga pending", xplrTransportWrite(&transport, gga, sizeof(gga) - 1, 1200U) == XPLR_TRANSPORT_OK,
+           "write", 0);
+    len = xplrTransportRead(&transport, buf, sizeof(buf), 1200U);
+    expect("gga pending", (len == 4) && (memcmp(buf, "wifi", 4) == 0), "wifi data kept", len);
+    expect("gga pending", xplrTransportGetActive(&transport) == (int8_t)WIFI, "switched", 0);
+    expect("gga pending", xplrTransportLoopbackPull(&loopback[WIFI], buf, sizeof(buf)) == 2 * (sizeof(gga) - 1),
+           "gga on wifi", 0);
+    printf("%-28s done\n", "gga pending");
+}
+
+static void caseSteady(void)
+{
+    simInit(500U, 2000U);
+    simRun(20000U);
+    expectGap("steady wifi", 1000U, 20000U, 0);
+    expect("steady wifi", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+    expect("steady wifi", sim.bearer[CELL].loopback.connects == 0, "cell used", 0);
+    expect("steady wifi", sim.bearer[WIFI].ggaReceived >= 19, "gga sent",
+           (long)sim.bearer[WIFI].ggaReceived);
+}
+
+static void caseLinkDrop(void)
+{
+    simInit(500U, 2000U);
+    simRun(5000U);
+    xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, false);
+    simRun(15000U);
+    /* lost at once, the cell connect time is the only gap */
+    expectGap("wifi drop, failover", 1000U, 15000U, 2000U + FRAME_PERIOD_MS);
+    expect("wifi drop, failover", xplrTransportGetActive(&sim.transport) == (int8_t)CELL, "active", 0);
+    expect("wifi drop, failover", sim.bearer[CELL].ggaReceived >= 8, "gga on cell",
+           (long)sim.bearer[CELL].ggaReceived);
+
+    xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, true);
+    simRun(30000U);
+    /* wifi takes over once it delivers, while cell still does */
+    expectGap("wifi back, failback", 15000U, 30000U, 0);
+    expect("wifi back, failback", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+    expect("wifi back, failback", !sim.bearer[CELL].loopback.connected, "cell released", 0);
+}
+
+static void caseStall(void)
+{
+    simInit(500U, 2000U);
+    simRun(5000U);
+    sim.bearer[WIFI].stalled = true;
+    simRun(20000U);
+    /* silence detected after rxTimeoutMs, then the cell connect time */
+    expectGap("wifi stall, failover", 1000U, 20000U, 2000U + 2000U + FRAME_PERIOD_MS);
+    expect("wifi stall, failover", xplrTransportGetActive(&sim.transport) == (int8_t)CELL, "active", 0);
+    expect("wifi stall, failover", sim.bearer[WIFI].lost >= 2, "wifi retried", (long)sim.bearer[WIFI].lost);
+
+    sim.bearer[WIFI].stalled = false;
+    simRun(40000U);
+    expectGap("wifi recovers, failback", 20000U, 40000U, 0);
+    expect("wifi recovers, failback", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+}
+
+static void caseRefused(void)
+{
+    uint32_t lost;
+
+    simInit(500U, 2000U);
+    sim.bearer[WIFI].loopback.refuse = true;
+    simRun(60000U);
+    lost = sim.bearer[WIFI].lost;
+    expectGap("wifi refused, backoff", 3000U, 60000U, 0);
+    expect("wifi refused, backoff", xplrTransportGetActive(&sim.transport) == (int8_t)CELL, "active", 0);
+    /* attempts at 0, 1, 3, 7, 15 s then every 8 s */
+    expect("wifi refused, backoff", (lost >= 8) && (lost <= 12), "attempts", (long)lost);
+
+    sim.bearer[WIFI].loopback.refuse = false;
+    simRun(80000U);
+    expectGap("wifi accepted, failback", 60000U, 80000U, 0);
+    expect("wifi accepted, failback", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+}
+
+static void caseBlockingConnect(void)
+{
+    uint32_t blockedMs;
+    uint32_t attempts;
+
+    simInit(500U, 2000U);
+    sim.bearer[WIFI].loopback.connectBlockMs = 1500U;
+    simRun(5000U);
+    xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, false);
+    simRun(15000U);
+    expect("blocking connect", xplrTransportGetActive(&sim.transport) == (int8_t)CELL, "active", 0);
+
+    /* every attempt stalls the cell corrections, none is lost */
+    blockedMs = sim.bearer[WIFI].loopback.blockedMs;
+    sim.bearer[WIFI].loopback.refuse = true;
+    xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, true);
+    simRun(60000U);
+    attempts = (sim.bearer[WIFI].loopback.blockedMs - blockedMs) / 1500U;
+    expectGap("blocking refused", 15000U, 60000U, 0);
+    expectLatency("blocking refused", 15000U, 60000U, 1500U + TICK_MS);
+    expect("blocking refused", (attempts >= 7) && (attempts <= 11), "attempts", (long)attempts);
+
+    sim.bearer[WIFI].loopback.refuse = false;
+    simRun(80000U);
+    expectGap("blocking failback", 60000U, 80000U, 0);
+    expectLatency("blocking failback", 60000U, 80000U, 1500U + TICK_MS);
+    expect("blocking failback", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+}
+
+static void caseBothDown(void)
+{
+    simInit(500U, 2000U);
+    simRun(5000U);
+    xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, false);
+    xplrTransportLoopbackSetLink(&sim.bearer[CELL].loopback, false);
+    simRun(15000U);
+    expect("both down", xplrTransportGetActive(&sim.transport) == -1, "active", 0);
+
+    xplrTransportLoopbackSetLink(&sim.bearer[CELL].loopback, true);
+    simRun(25000U);
+    /* the cell link is checked on every read, no backoff as it never connected */
+    expectGap("cell up", 15000U + 2000U + FRAME_PERIOD_MS, 25000U, 0);
+    expect("cell up", xplrTransportGetActive(&sim.transport) == (int8_t)CELL, "active", 0);
+}
+
+static void caseFlapping(void)
+{
+    uint32_t t;
+
+    simInit(500U, 2000U);
+    simRun(5000U);
+    /* wifi drops for 3 s every 10 s */
+    for (t = 5000U; t < 65000U; t += 10000U) {
+        xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, false);
+        simRun(t + 3000U);
+        xplrTransportLoopbackSetLink(&sim.bearer[WIFI].loopback, true);
+        simRun(t + 10000U);
+    }
+    expectGap("wifi flapping", 1000U, 65000U, 2000U + FRAME_PERIOD_MS);
+    expect("wifi flapping", xplrTransportGetActive(&sim.transport) == (int8_t)WIFI, "active", 0);
+}
+
+int main(void)
+{
+    caseArguments();
+    caseEcho();
+    caseGgaPending();
+    caseSteady();
+    caseLinkDrop();
+    caseStall();
+    caseRefused();
+    caseBlockingConnect();
+    caseBothDown();
+    caseFlapping();
+
+    printf("%s: %u failure(s)\n", (failures == 0) ? "PASS" : "FAIL", failures);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "xplr_transport.h"
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static bool transportElapsed(uint32_t nowMs, uint32_t sinceMs, uint32_t periodMs);
+static bool transportLinkUp(xplrTransport_t *transport, uint8_t index);
+static void transportEvent(xplrTransport_t *transport, xplrTransportEvent_t event, uint8_t index);
+static void transportBackoff(xplrTransport_t *transport, uint8_t index, uint32_t nowMs);
+static void transportLose(xplrTransport_t *transport, uint8_t index, uint32_t nowMs);
+static bool transportConnect(xplrTransport_t *transport, uint8_t index, uint32_t nowMs);
+static void transportReceived(xplrTransport_t *transport, uint8_t index, uint32_t nowMs);
+static void transportSwitch(xplrTransport_t *transport, uint8_t index);
+static void transportCheck(xplrTransport_t *transport, uint32_t nowMs);
+static void transportSelect(xplrTransport_t *transport, uint32_t nowMs);
+static int32_t transportSend(xplrTransport_t *transport,
+                             uint8_t index,
+                             const void *data,
+                             size_t len,
+                             uint32_t nowMs);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+xplrTransport_error_t xplrTransportInit(xplrTransport_t *transport,
+                                        const xplrTransportBearer_t *bearers,
+                                        uint8_t count,
+                                        const xplrTransportConfig_t *cfg)
+{
+    xplrTransport_error_t ret = XPLR_TRANSPORT_OK;
+    uint8_t i;
+
+    if ((transport == NULL) || (bearers == NULL) ||
+        (count == 0) || (count > XPLR_TRANSPORT_BEARERS_MAX)) {
+        ret = XPLR_TRANSPORT_ERROR;
+    } else {
+        for (i = 0; i < count; i++) {
+            if ((bearers[i].ops == NULL) ||
+                (bearers[i].ops->connect == NULL) ||
+                (bearers[i].ops->disconnect == NULL) ||
+                (bearers[i].ops->send == NULL) ||
+                (bearers[i].ops->recv == NULL)) {
+                ret = XPLR_TRANSPORT_ERROR;
+            } else {
+                // do nothing
+            }
+        }
+    }
+
+    if (ret == XPLR_TRANSPORT_OK) {
+        memset(transport, 0, sizeof(*transport));
+        if (cfg != NULL) {
+            transport->cfg = *cfg;
+        }
+        if (transport->cfg.connectTimeoutMs == 0) {
+            transport->cfg.connectTimeoutMs = XPLR_TRANSPORT_CONNECT_TIMEOUT_MS_DEFAULT;
+        }
+        if (transport->cfg.rxTimeoutMs == 0) {
+            transport->cfg.rxTimeoutMs = XPLR_TRANSPORT_RX_TIMEOUT_MS_DEFAULT;
+        }
+        if (transport->cfg.backoffMinMs == 0) {
+            transport->cfg.backoffMinMs = XPLR_TRANSPORT_BACKOFF_MIN_MS_DEFAULT;
+        }
+        if (transport->cfg.backoffMaxMs == 0) {
+            transport->cfg.backoffMaxMs = XPLR_TRANSPORT_BACKOFF_MAX_MS_DEFAULT;
+        }
+        if (transport->cfg.backoffMaxMs < transport->cfg.backoffMinMs) {
+            transport->cfg.backoffMaxMs = transport->cfg.backoffMinMs;
+        }
+
+        memcpy(transport->bearer, bearers, count * sizeof(bearers[0]));
+        for (i = 0; i < count; i++) {
+            transport->link[i].state = XPLR_TRANSPORT_BEARER_IDLE;
+            transport->link[i].backoffMs = transport->cfg.backoffMinMs;
+        }
+        transport->count = count;
+        transport->active = -1;
+        transport->candidate = -1;
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+int32_t xplrTransportRead(xplrTransport_t *transport, void *buf, size_t size, uint32_t nowMs)
+{
+    int32_t ret = 0;
+    int32_t rxLen;
+    uint8_t index;
+
+    if ((transport == NULL) || (transport->count == 0) || (buf == NULL) || (size == 0)) {
+        // do nothing
+    } else {
+        transportCheck(transport, nowMs);
+        transportSelect(transport, nowMs);
+
+        /* the preferred bearer takes over with its first data, the one in use is dropped */
+        if (transport->candidate >= 0) {
+            index = (uint8_t)transport->candidate;
+            rxLen = transport->bearer[index].ops->recv(transport->bearer[index].ctx, buf, size);
+            if (rxLen > 0) {
+                transportReceived(transport, index, nowMs);
+                transportSwitch(transport, index);
+                ret = rxLen;
+            } else if (rxLen < 0) {
+                transportLose(transport, index, nowMs);
+            } else {
+                // do nothing
+            }
+        }
+
+        if ((ret == 0) && (transport->active >= 0)) {
+            index = (uint8_t)transport->active;
+            rxLen = transport->bearer[index].ops->recv(transport->bearer[index].ctx, buf, size);
+            if (rxLen > 0) {
+                transportReceived(transport, index, nowMs);
+                ret = rxLen;
+            } else if (rxLen < 0) {
+                /* start the next bearer right away, its connect time is the only gap */
+                transportLose(transport, index, nowMs);
+                transportSelect(transport, nowMs);
+            } else {
+                // do nothing
+            }
+        }
+    }
+
+    return ret;
+}
+
+xplrTransport_error_t xplrTransportWrite(xplrTransport_t *transport,
+                                         const void *data,
+                                         size_t len,
+                                         uint32_t nowMs)
+{
+    xplrTransport_error_t ret = XPLR_TRANSPORT_ERROR;
+    int32_t txLen;
+
+    if ((transport == NULL) || (transport->count == 0) || (data == NULL) || (len == 0)) {
+        // do nothing
+    } else {
+        transportCheck(transport, nowMs);
+        transportSelect(transport, nowMs);
+
+        if (transport->candidate >= 0) {
+            (void)transportSend(transport, (uint8_t)transport->candidate, data, len, nowMs);
+        }
+
+        if (transport->active >= 0) {
+            txLen = transportSend(transport, (uint8_t)transport->active, data, len, nowMs);
+            if ((txLen < 0) && (transport->active >= 0)) {
+                /* failed over while sending, give the data to the new bearer */
+                txLen = transportSend(transport, (uint8_t)transport->active, data, len, nowMs);
+            }
+            if (txLen == (int32_t)len) {
+                ret = XPLR_TRANSPORT_OK;
+            }
+        }
+    }
+
+    return ret;
+}
+
+void xplrTransportStop(xplrTransport_t *transport)
+{
+    uint8_t i;
+
+    if (transport != NULL) {
+        for (i = 0; i < transport->count; i++) {
+            if ((transport->link[i].state == XPLR_TRANSPORT_BEARER_CONNECTING) ||
+                (transport->link[i].state == XPLR_TRANSPORT_BEARER_CONNECTED)) {
+                transport->bearer[i].ops->disconnect(transport->bearer[i].ctx);
+            }
+            transport->link[i].state = XPLR_TRANSPORT_BEARER_IDLE;
+            transport->link[i].backoffMs = transport->cfg.backoffMinMs;
+        }
+        transport->active = -1;
+        transport->candidate = -1;
+    }
+}
+
+int8_t xplrTransportGetActive(const xplrTransport_t *transport)
+{
+    return (transport != NULL) ? transport->active : -1;
+}
+
+xplrTransportBearerState_t xplrTransportGetBearerState(const xplrTransport_t *transport,
+                                                       uint8_t bearer)
+{
+    xplrTransportBearerState_t ret;
+
+    if ((transport != NULL) && (bearer < transport->count)) {
+        ret = transport->link[bearer].state;
+    } else {
+        ret = XPLR_TRANSPORT_BEARER_IDLE;
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static bool transportElapsed(uint32_t nowMs, uint32_t sinceMs, uint32_t periodMs)
+{
+    return (uint32_t)(nowMs - sinceMs) >= periodMs;
+}
+
+static bool transportLinkUp(xplrTransport_t *transport, uint8_t index)
+{
+    const xplrTransportBearer_t *bearer = &transport->bearer[index];
+
+    return (bearer->ops->linkUp == NULL) || bearer->ops->linkUp(bearer->ctx);
+}
+
+static void transportEvent(xplrTransport_t *transport, xplrTransportEvent_t event, uint8_t index)
+{
+    if (transport->cfg.onEvent != NULL) {
+        transport->cfg.onEvent(transport->cfg.eventArg, event, index);
+    }
+}
+
+static void transportBackoff(xplrTransport_t *transport, uint8_t index, uint32_t nowMs)
+{
+    xplrTransportLink_t *link = &transport->link[index];
+
+    link->state = XPLR_TRANSPORT_BEARER_BACKOFF;
+    link->retryMs = nowMs + link->backoffMs;
+    if (link->backoffMs < (transport->cfg.backoffMaxMs / 2U)) {
+        link->backoffMs *= 2U;
+    } else {
+        link->backoffMs = transport->cfg.backoffMaxMs;
+    }
+
+    if (transport->active == (int8_t)index) {
+        transport->active = -1;
+    } else if (transport->candidate == (int8_t)index) {
+        transport->candidate = -1;
+    } else {
+        // do nothing
+    }
+
+    transportEvent(transport, XPLR_TRANSPORT_EVENT_LOST, index);
+}
+
+static void transportLose(xplrTransport_t *transport, uint8_t index, uint32_t nowMs)
+{
+    transport->bearer[index].ops->disconnect(transport->bearer[index].ctx);
+    transportBackoff(transport, index, nowMs);
+}
+
+static bool transportConnect(xplrTransport_t *transport, uint8_t index, uint32_t nowMs)
+{
+    bool ret;
+
+    if (transport->bearer[index].ops->connect(transport->bearer[index].ctx) == 0) {
+        transport->link[index].state = XPLR_TRANSPORT_BEARER_CONNECTING;
+        transport->link[index].sinceMs = nowMs;
+        ret = true;
+    } else {
+        transportBackoff(transport, index, nowMs);
+        ret = false;
+    }
+
+    return ret;
+}
+
+static void transportReceived(xplrTransport_t *transport, uint8_t index, uint32_t nowMs)
+{
+    xplrTransportLink_t *link = &transport->link[index];
+
+    link->sinceMs = nowMs;
+    if (link->state == XPLR_TRANSPORT_BEARER_CONNECTING) {
+        link->state = XPLR_TRANSPORT_BEARER_CONNECTED;
+        link->backoffMs = transport->cfg.backoffMinMs;
+        transportEvent(transport, XPLR_TRANSPORT_EVENT_CONNECTED, index);
+    }
+}
+
+static void transportSwitch(xplrTransport_t *transport, uint8_t index)
+{
+    int8_t previous = transport->active;
+
+    if ((previous >= 0) && (previous != (int8_t)index)) {
+        /* still healthy, it is idle and available as a fallback again */
+        transport->bearer[previous].ops->disconnect(transport->bearer[previous].ctx);
+        transport->link[previous].state = XPLR_TRANSPORT_BEARER_IDLE;
+    }
+    if (transport->candidate == (int8_t)index) {
+        transport->candidate = -1;
+    }
+    transport->active = (int8_t)index;
+    transport->switches++;
+    transportEvent(transport, XPLR_TRANSPORT_EVENT_SWITCHED, index);
+}
+
+static void transportCheck(xplrTransport_t *transport, uint32_t nowMs)
+{
+    xplrTransportLink_t *link;
+    uint8_t i;
+
+    for (i = 0; i < transport->count; i++) {
+        link = &transport->link[i];
+        switch (link->state) {
+            case XPLR_TRANSPORT_BEARER_CONNECTING:
+                if (!transportLinkUp(transport, i) ||
+                    transportElapsed(nowMs, link->sinceMs, transport->cfg.connectTimeoutMs)) {
+                    transportLose(transport, i, nowMs);
+                }
+                break;
+            case XPLR_TRANSPORT_BEARER_CONNECTED:
+                if (!transportLinkUp(transport, i) ||
+                    transportElapsed(nowMs, link->sinceMs, transport->cfg.rxTimeoutMs)) {
+                    transportLose(transport, i, nowMs);
+                }
+                break;
+            case XPLR_TRANSPORT_BEARER_BACKOFF:
+                if ((int32_t)(nowMs - link->retryMs) >= 0) {
+                    link->state = XPLR_TRANSPORT_BEARER_IDLE;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void transportSelect(xplrTransport_t *transport, uint32_t nowMs)
+{
+    uint8_t i;
+
+    if (transport->active < 0) {
+        if (transport->candidate >= 0) {
+            transportSwitch(transport, (uint8_t)transport->candidate);
+        } else {
+            for (i = 0; (i < transport->count) && (transport->active < 0); i++) {
+                if ((transport->link[i].state == XPLR_TRANSPORT_BEARER_IDLE) &&
+                    transportLinkUp(transport, i) &&
+                    transportConnect(transport, i, nowMs)) {
+                    transportSwitch(transport, i);
+                }
+            }
+        }
+    }
+
+    /* fail back: try the bearers preferred to the one in use */
+    if ((transport->active > 0) && (transport->candidate < 0)) {
+        for (i = 0; (i < (uint8_t)transport->active) && (transport->candidate < 0); i++) {
+            if ((transport->link[i].state == XPLR_TRANSPORT_BEARER_IDLE) &&
+                transportLinkUp(transport, i) &&
+                transportConnect(transport, i, nowMs)) {
+                transport->candidate = (int8_t)i;
+            }
+        }
+    }
+}
+
+static int32_t transportSend(xplrTransport_t *transport,
+                             uint8_t index,
+                             const void *data,
+                             size_t len,
+                             uint32_t nowMs)
+{
+    int32_t ret = transport->bearer[index].ops->send(transport->bearer[index].ctx, data, len);
+
+    if (ret < 0) {
+        transportLose(transport, index, nowMs);
+        transportSelect(transport, nowMs);
+    }
+
+    return ret;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_TRANSPORT_H_
+#define _XPLR_TRANSPORT_H_
+
+/* Only standard headers here: the transport is also built on a host,
+ * see tools/xplr_transport_host_test.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file
+ * @brief Bearer independent transport for correction clients.
+ * A correction client reads and writes through one xplrTransport_t, which runs
+ * over a list of bearers (e.g. NTRIP over Wi-Fi, NTRIP over cellular) given in
+ * order of preference:
+ * - when the bearer in use is lost, the next available one is connected at once.
+ * - while a less preferred bearer is in use, the preferred ones are connected in
+ *   the background and take over only once they deliver data, so going back
+ *   does not interrupt the corrections.
+ *
+ * The transport is not thread safe, it is meant to be driven by the task
+ * of the correction client.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_TRANSPORT_BEARERS_MAX                  (4U)
+
+/* Defaults of the xplrTransportConfig_t fields left to 0 */
+#define XPLR_TRANSPORT_CONNECT_TIMEOUT_MS_DEFAULT   (15000U)    /* connected bearer has to deliver data within this */
+#define XPLR_TRANSPORT_RX_TIMEOUT_MS_DEFAULT        (10000U)    /* silence after which a bearer is considered lost */
+#define XPLR_TRANSPORT_BACKOFF_MIN_MS_DEFAULT       (1000U)     /* first retry delay of a lost bearer */
+#define XPLR_TRANSPORT_BACKOFF_MAX_MS_DEFAULT       (60000U)    /* retry delay doubles up to this */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+typedef enum {
+    XPLR_TRANSPORT_ERROR = -1,  /**< process returned with errors. */
+    XPLR_TRANSPORT_OK           /**< indicates success of returning process. */
+} xplrTransport_error_t;
+
+/**
+ * Bearer implementation. Callbacks get the ctx of their xplrTransportBearer_t.
+ * Byte stream bearers (NTRIP) return any number of bytes from recv, message
+ * bearers (MQTT) return one whole message.
+ */
+typedef struct xplrTransportOps_type {
+    int32_t (*connect)(void *ctx);                                  /**< 0 when connected or connecting, negative on error. Should not block, see xplrTransportRead() */
+    void    (*disconnect)(void *ctx);
+    int32_t (*send)(void *ctx, const void *data, size_t len);       /**< bytes sent, negative when the connection is lost. Keeps data waiting for recv */
+    int32_t (*recv)(void *ctx, void *buf, size_t size);             /**< bytes received, 0 if none, negative when the connection is lost */
+    bool    (*linkUp)(void *ctx);                                   /**< optional, network of the bearer available (Wi-Fi associated, cell registered) */
+} xplrTransportOps_t;
+
+typedef struct xplrTransportBearer_type {
+    const char                  *name;
+    const xplrTransportOps_t    *ops;
+    void                        *ctx;
+} xplrTransportBearer_t;
+
+typedef enum {
+    XPLR_TRANSPORT_BEARER_IDLE = 0,     /**< not connected, may be connected when needed */
+    XPLR_TRANSPORT_BEARER_CONNECTING,   /**< connected, no data yet */
+    XPLR_TRANSPORT_BEARER_CONNECTED,    /**< delivering data */
+    XPLR_TRANSPORT_BEARER_BACKOFF       /**< lost, waiting before the next attempt */
+} xplrTransportBearerState_t;
+
+typedef enum {
+    XPLR_TRANSPORT_EVENT_CONNECTED = 0, /**< bearer delivered its first data */
+    XPLR_TRANSPORT_EVENT_LOST,          /**< bearer failed to connect, dropped or went silent */
+    XPLR_TRANSPORT_EVENT_SWITCHED       /**< bearer is now the one in use */
+} xplrTransportEvent_t;
+
+typedef struct xplrTransportConfig_type {
+    uint32_t    connectTimeoutMs;
+    uint32_t    rxTimeoutMs;
+    uint32_t    backoffMinMs;
+    uint32_t    backoffMaxMs;
+    void        (*onEvent)(void *arg, xplrTransportEvent_t event, uint8_t bearer);  /**< optional */
+    void        *eventArg;
+} xplrTransportConfig_t;
+
+typedef struct xplrTransportLink_type {
+    xplrTransportBearerState_t  state;
+    uint32_t                    sinceMs;    /**< time of connect, or of the last data once connected */
+    uint32_t                    retryMs;    /**< end of the backoff */
+    uint32_t                    backoffMs;
+} xplrTransportLink_t;
+
+/**
+ * Transport instance.
+ */
+typedef struct xplrTransport_type {
+    xplrTransportConfig_t   cfg;
+    xplrTransportBearer_t   bearer[XPLR_TRANSPORT_BEARERS_MAX];
+    xplrTransportLink_t     link[XPLR_TRANSPORT_BEARERS_MAX];
+    uint8_t                 count;
+    int8_t                  active;         /**< bearer in use, -1 if none */
+    int8_t                  candidate;      /**< preferred bearer connecting in the background, -1 if none */
+    uint32_t                switches;
+} xplrTransport_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Set up a transport. Nothing is connected before the first read or write.
+ *
+ * @param transport     transport.
+ * @param bearers       bearers, most preferred first. Copied.
+ * @param count         number of bearers, up to XPLR_TRANSPORT_BEARERS_MAX.
+ * @param cfg           timeouts and event callback, may be NULL for the defaults.
+ * @return              XPLR_TRANSPORT_OK on success, XPLR_TRANSPORT_ERROR otherwise.
+ */
+xplrTransport_error_t xplrTransportInit(xplrTransport_t *transport,
+                                        const xplrTransportBearer_t *bearers,
+                                        uint8_t count,
+                                        const xplrTransportConfig_t *cfg);
+
+/**
+ * @brief Connect, fail over or fail back as needed, then read from the bearer in use.
+ * To be called periodically, also when no data is expected, as it drives the bearers.
+ * A bearer connect that blocks stalls the read for as long, also while failing
+ * back: once per attempt, the attempts of a failing bearer spaced by its backoff.
+ * The bearer in use has to buffer its data meanwhile, and the stall has to stay
+ * below rxTimeoutMs or that bearer is taken as silent.
+ *
+ * @param transport     transport.
+ * @param buf           buffer for the received data.
+ * @param size          size of buf, at least the largest message of the bearers.
+ * @param nowMs         a millisecond clock, allowed to wrap.
+ * @return              bytes received, 0 if none.
+ */
+int32_t xplrTransportRead(xplrTransport_t *transport, void *buf, size_t size, uint32_t nowMs);
+
+/**
+ * @brief Send data, e.g. a GGA message, to the bearer in use and to the one
+ * connecting in the background, so that it is ready to take over.
+ *
+ * @param transport     transport.
+ * @param data          data to send.
+ * @param len           length of data.
+ * @param nowMs         a millisecond clock, allowed to wrap.
+ * @return              XPLR_TRANSPORT_OK when the bearer in use sent the data,
+ *                      XPLR_TRANSPORT_ERROR otherwise.
+ */
+xplrTransport_error_t xplrTransportWrite(xplrTransport_t *transport,
+                                         const void *data,
+                                         size_t len,
+                                         uint32_t nowMs);
+
+/**
+ * @brief Disconnect all bearers. The transport connects again on the next read or write.
+ *
+ * @param transport     transport.
+ */
+void xplrTransportStop(xplrTransport_t *transport);
+
+/**
+ * @brief Get the bearer in use.
+ *
+ * @param transport     transport.
+ * @return              index of the bearer, -1 if none.
+ */
+int8_t xplrTransportGetActive(const xplrTransport_t *transport);
+
+/**
+ * @brief Get the state of a bearer.
+ *
+ * @param transport     transport.
+ * @param bearer        index of the bearer.
+ * @return              state of the bearer, XPLR_TRANSPORT_BEARER_IDLE for an invalid index.
+ */
+xplrTransportBearerState_t xplrTransportGetBearerState(const xplrTransport_t *transport,
+                                                       uint8_t bearer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_TRANSPORT_H_ */
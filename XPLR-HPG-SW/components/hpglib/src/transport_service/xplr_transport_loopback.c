@@ -0,0 +1,196 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "xplr_transport_loopback.h"
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static int32_t loopbackConnect(void *ctx);
+static void loopbackDisconnect(void *ctx);
+static int32_t loopbackSend(void *ctx, const void *data, size_t len);
+static int32_t loopbackRecv(void *ctx, void *buf, size_t size);
+static bool loopbackLinkUp(void *ctx);
+static size_t loopbackQueue(xplrTransportLoopback_t *loopback, const uint8_t *data, size_t len);
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+const xplrTransportOps_t xplrTransportLoopbackOps = {
+    .connect = loopbackConnect,
+    .disconnect = loopbackDisconnect,
+    .send = loopbackSend,
+    .recv = loopbackRecv,
+    .linkUp = loopbackLinkUp
+};
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+void xplrTransportLoopbackInit(xplrTransportLoopback_t *loopback, bool echo)
+{
+    if (loopback != NULL) {
+        memset(loopback, 0, sizeof(*loopback));
+        loopback->linkUp = true;
+        loopback->echo = echo;
+    }
+}
+
+size_t xplrTransportLoopbackPush(xplrTransportLoopback_t *loopback, const void *data, size_t len)
+{
+    size_t ret = 0;
+
+    if ((loopback != NULL) && (data != NULL) && loopback->connected) {
+        ret = loopbackQueue(loopback, (const uint8_t *)data, len);
+    }
+
+    return ret;
+}
+
+size_t xplrTransportLoopbackPull(xplrTransportLoopback_t *loopback, void *buf, size_t size)
+{
+    size_t ret = 0;
+
+    if ((loopback != NULL) && (buf != NULL)) {
+        ret = (loopback->txLen < size) ? loopback->txLen : size;
+        memcpy(buf, loopback->tx, ret);
+        memmove(loopback->tx, &loopback->tx[ret], loopback->txLen - ret);
+        loopback->txLen -= (uint32_t)ret;
+    }
+
+    return ret;
+}
+
+void xplrTransportLoopbackSetLink(xplrTransportLoopback_t *loopback, bool up)
+{
+    if (loopback != NULL) {
+        loopback->linkUp = up;
+        if (!up) {
+            loopback->connected = false;
+            loopback->rxLen = 0;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static int32_t loopbackConnect(void *ctx)
+{
+    xplrTransportLoopback_t *loopback = (xplrTransportLoopback_t *)ctx;
+    int32_t ret;
+
+    if (loopback->linkUp) {
+        /* socket connect and handshake, a refusal comes at the end of it */
+        loopback->blockedMs += loopback->connectBlockMs;
+    }
+
+    if (!loopback->linkUp || loopback->refuse) {
+        ret = -1;
+    } else {
+        loopback->connected = true;
+        loopback->rxHead = 0;
+        loopback->rxLen = 0;
+        loopback->txLen = 0;
+        loopback->connects++;
+        ret = 0;
+    }
+
+    return ret;
+}
+
+static void loopbackDisconnect(void *ctx)
+{
+    xplrTransportLoopback_t *loopback = (xplrTransportLoopback_t *)ctx;
+
+    loopback->connected = false;
+    loopback->rxLen = 0;
+}
+
+static int32_t loopbackSend(void *ctx, const void *data, size_t len)
+{
+    xplrTransportLoopback_t *loopback = (xplrTransportLoopback_t *)ctx;
+    size_t room;
+    int32_t ret;
+
+    if (!loopback->connected) {
+        ret = -1;
+    } else if (loopback->echo) {
+        ret = (int32_t)loopbackQueue(loopback, (const uint8_t *)data, len);
+    } else {
+        room = sizeof(loopback->tx) - loopback->txLen;
+        if (len > room) {
+            len = room;
+        }
+        memcpy(&loopback->tx[loopback->txLen], data, len);
+        loopback->txLen += (uint32_t)len;
+        ret = (int32_t)len;
+    }
+
+    return ret;
+}
+
+static int32_t loopbackRecv(void *ctx, void *buf, size_t size)
+{
+    xplrTransportLoopback_t *loopback = (xplrTransportLoopback_t *)ctx;
+    uint8_t *dst = (uint8_t *)buf;
+    size_t len;
+    size_t part;
+    int32_t ret;
+
+    if (!loopback->connected) {
+        ret = -1;
+    } else {
+        len = (loopback->rxLen < size) ? loopback->rxLen : size;
+        part = sizeof(loopback->rx) - loopback->rxHead;
+        if (part > len) {
+            part = len;
+        }
+        memcpy(dst, &loopback->rx[loopback->rxHead], part);
+        memcpy(&dst[part], loopback->rx, len - part);
+        loopback->rxHead = (uint32_t)((loopback->rxHead + len) % sizeof(loopback->rx));
+        loopback->rxLen -= (uint32_t)len;
+        ret = (int32_t)len;
+    }
+
+    return ret;
+}
+
+static bool loopbackLinkUp(void *ctx)
+{
+    return ((xplrTransportLoopback_t *)ctx)->linkUp;
+}
+
+static size_t loopbackQueue(xplrTransportLoopback_t *loopback, const uint8_t *data, size_t len)
+{
+    size_t room = sizeof(loopback->rx) - loopback->rxLen;
+    size_t i;
+
+    if (len > room) {
+        len = room;
+    }
+    for (i = 0; i < len; i++) {
+        loopback->rx[(loopback->rxHead + loopback->rxLen + i) % sizeof(loopback->rx)] = data[i];
+    }
+    loopback->rxLen += (uint32_t)len;
+
+    return len;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_TRANSPORT_LOOPBACK_H_
+#define _XPLR_TRANSPORT_LOOPBACK_H_
+
+/* Only standard headers here: the loopback is also built on a host,
+ * see tools/xplr_transport_host_test.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "xplr_transport.h"
+
+/** @file
+ * @brief In memory bearer for xplrTransport_t, standing in for a network
+ * bearer in tests. The test plays the server: it pushes the data the bearer
+ * receives and pulls what the client sent. In echo mode what the client sends
+ * is received back. The link can be dropped and connections refused to
+ * exercise failover. Connect can be made to block, the time is only counted:
+ * the test advances its clock by it.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_TRANSPORT_LOOPBACK_SIZE    (2048U)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+typedef struct xplrTransportLoopback_type {
+    uint8_t     rx[XPLR_TRANSPORT_LOOPBACK_SIZE];   /**< ring of data waiting for recv */
+    uint32_t    rxHead;
+    uint32_t    rxLen;
+    uint8_t     tx[XPLR_TRANSPORT_LOOPBACK_SIZE];   /**< data sent, waiting for xplrTransportLoopbackPull() */
+    uint32_t    txLen;
+    bool        linkUp;
+    bool        connected;
+    bool        refuse;         /**< connect fails */
+    bool        echo;           /**< sent data is received back */
+    uint32_t    connects;       /**< successful connects */
+    uint32_t    connectBlockMs; /**< time a connect on a link that is up blocks, refused or not */
+    uint32_t    blockedMs;      /**< time connect blocked in total */
+} xplrTransportLoopback_t;
+
+/** Bearer callbacks, the ctx is a xplrTransportLoopback_t. */
+extern const xplrTransportOps_t xplrTransportLoopbackOps;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Set up a loopback bearer, link up and not connected.
+ *
+ * @param loopback  bearer.
+ * @param echo      receive back the data sent.
+ */
+void xplrTransportLoopbackInit(xplrTransportLoopback_t *loopback, bool echo);
+
+/**
+ * @brief Server side: queue data to be received. Like on a socket, data
+ * pushed while the bearer is not connected is lost.
+ *
+ * @param loopback  bearer.
+ * @param data      data to queue.
+ * @param len       length of data.
+ * @return          bytes queued.
+ */
+size_t xplrTransportLoopbackPush(xplrTransportLoopback_t *loopback, const void *data, size_t len);
+
+/**
+ * @brief Server side: take the data sent by the client.
+ *
+ * @param loopback  bearer.
+ * @param buf       buffer for the data.
+ * @param size      size of buf.
+ * @return          bytes copied.
+ */
+size_t xplrTransportLoopbackPull(xplrTransportLoopback_t *loopback, void *buf, size_t size);
+
+/**
+ * @brief Bring the link of the bearer up or down. Going down drops the
+ * connection: pending data is lost and recv and send fail until reconnected.
+ *
+ * @param loopback  bearer.
+ * @param up        link state.
+ */
+void xplrTransportLoopbackSetLink(xplrTransportLoopback_t *loopback, bool up);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_TRANSPORT_LOOPBACK_H_ */
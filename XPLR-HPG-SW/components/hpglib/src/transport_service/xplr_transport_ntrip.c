@@ -0,0 +1,467 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "xplr_transport_ntrip.h"
+#include "./../../xplr_hpglib_cfg.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#if (1 == XPLRTRANSPORT_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED) && ((0 == XPLR_HPGLIB_LOG_ENABLED) || (0 == XPLRTRANSPORT_LOG_ACTIVE))
+#define XPLRTRANSPORT_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_PRINT_ONLY, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgTransport", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#elif (1 == XPLRTRANSPORT_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED) && (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLRTRANSPORT_LOG_ACTIVE)
+#define XPLRTRANSPORT_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_SD_AND_PRINT, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgTransport", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#elif ((0 == XPLRTRANSPORT_DEBUG_ACTIVE) || (0 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)) && (1 == XPLR_HPGLIB_LOG_ENABLED) && (1 == XPLRTRANSPORT_LOG_ACTIVE)
+#define XPLRTRANSPORT_CONSOLE(tag, message, ...) XPLRLOG(logIndex, XPLR_LOG_SD_ONLY, XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "hpgTransport", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#else
+#define XPLRTRANSPORT_CONSOLE(message, ...) do{} while(0)
+#endif
+
+#define XPLR_TRANSPORT_NTRIP_CONNECT_TASK_STACK     (4 * 1024)
+#define XPLR_TRANSPORT_NTRIP_CONNECT_TASK_PRIO      (3)
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static int32_t ntripConnect(void *ctx);
+static void ntripDisconnect(void *ctx);
+static int32_t ntripSend(void *ctx, const void *data, size_t len);
+static int32_t ntripRecv(void *ctx, void *buf, size_t size);
+static bool ntripLinkUp(void *ctx);
+static bool ntripIsConnected(xplrTransportNtrip_t *ntrip, bool *connecting);
+static void ntripConnectTask(void *pvParams);
+static xplrTransport_error_t ntripSetup(xplrTransportNtrip_t *ntrip,
+                                        xplrTransportNtripBearer_t bearer,
+                                        void *client,
+                                        const xplr_ntrip_config_t *config,
+                                        bool configured,
+                                        SemaphoreHandle_t semaphore,
+                                        bool (*linkUp)(void));
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+static int8_t logIndex = -1;
+static portMUX_TYPE ntripLock = portMUX_INITIALIZER_UNLOCKED;  /* connect task and bearer state */
+
+const xplrTransportOps_t xplrTransportNtripOps = {
+    .connect = ntripConnect,
+    .disconnect = ntripDisconnect,
+    .send = ntripSend,
+    .recv = ntripRecv,
+    .linkUp = ntripLinkUp
+};
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+xplrTransport_error_t xplrTransportNtripWifiSetup(xplrTransportNtrip_t *ntrip,
+                                                  xplrWifi_ntrip_client_t *client,
+                                                  SemaphoreHandle_t semaphore,
+                                                  bool (*linkUp)(void))
+{
+    xplrTransport_error_t ret;
+
+    if (client == NULL) {
+        XPLRTRANSPORT_CONSOLE(E, "No Wi-Fi NTRIP client");
+        ret = XPLR_TRANSPORT_ERROR;
+    } else {
+        ret = ntripSetup(ntrip,
+                         XPLR_TRANSPORT_NTRIP_WIFI,
+                         client,
+                         client->config,
+                         client->config_set && client->credentials_set,
+                         semaphore,
+                         linkUp);
+    }
+
+    return ret;
+}
+
+xplrTransport_error_t xplrTransportNtripCellSetup(xplrTransportNtrip_t *ntrip,
+                                                  xplrCell_ntrip_client_t *client,
+                                                  SemaphoreHandle_t semaphore,
+                                                  bool (*linkUp)(void))
+{
+    xplrTransport_error_t ret;
+
+    if (client == NULL) {
+        XPLRTRANSPORT_CONSOLE(E, "No cell NTRIP client");
+        ret = XPLR_TRANSPORT_ERROR;
+    } else {
+        ret = ntripSetup(ntrip,
+                         XPLR_TRANSPORT_NTRIP_CELL,
+                         client,
+                         client->config,
+                         client->config_set && client->credentials_set,
+                         semaphore,
+                         linkUp);
+    }
+
+    return ret;
+}
+
+int8_t xplrTransportNtripInitLogModule(xplr_cfg_logInstance_t *logCfg)
+{
+    int8_t ret;
+    xplrLog_error_t logErr;
+
+    if (logIndex < 0) {
+        /* logIndex is negative so logging has not been initialized before */
+        if (logCfg == NULL) {
+            /* logCfg is NULL so we will use the default module settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   XPLR_TRANSPORT_DEFAULT_FILENAME,
+                                   XPLRLOG_FILE_SIZE_INTERVAL,
+                                   XPLRLOG_NEW_FILE_ON_BOOT);
+        } else {
+            /* logCfg contains the instance settings */
+            logIndex = xplrLogInit(XPLR_LOG_DEVICE_INFO,
+                                   logCfg->filename,
+                                   logCfg->sizeInterval,
+                                   logCfg->erasePrev);
+        }
+        ret = logIndex;
+    } else {
+        /* logIndex is positive so logging has been initialized before */
+        logErr = xplrLogEnable(logIndex);
+        if (logErr != XPLR_LOG_OK) {
+            ret = -1;
+        } else {
+            ret = logIndex;
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t xplrTransportNtripStopLogModule(void)
+{
+    esp_err_t ret;
+    xplrLog_error_t logErr;
+
+    logErr = xplrLogDisable(logIndex);
+    if (logErr != XPLR_LOG_OK) {
+        ret = ESP_FAIL;
+    } else {
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static xplrTransport_error_t ntripSetup(xplrTransportNtrip_t *ntrip,
+                                        xplrTransportNtripBearer_t bearer,
+                                        void *client,
+                                        const xplr_ntrip_config_t *config,
+                                        bool configured,
+                                        SemaphoreHandle_t semaphore,
+                                        bool (*linkUp)(void))
+{
+    xplrTransport_error_t ret;
+
+    if ((ntrip == NULL) || (semaphore == NULL) || (config == NULL) || !configured) {
+        XPLRTRANSPORT_CONSOLE(E, "NTRIP client configuration or credentials not set");
+        ret = XPLR_TRANSPORT_ERROR;
+    } else {
+        memset(ntrip, 0, sizeof(*ntrip));
+        ntrip->bearer = bearer;
+        ntrip->client = client;
+        ntrip->semaphore = semaphore;
+        ntrip->server = config->server;
+        ntrip->credentials = config->credentials;
+        ntrip->linkUp = linkUp;
+        ret = XPLR_TRANSPORT_OK;
+    }
+
+    return ret;
+}
+
+/**
+ * Starts the client init in a task, recv reports when it is done. Fails
+ * while the init of a connection dropped meanwhile still runs.
+ */
+static int32_t ntripConnect(void *ctx)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)ctx;
+    const xplr_ntrip_credentials_t *cred = &ntrip->credentials;
+    xplrWifi_ntrip_client_t *wifi;
+    xplrCell_ntrip_client_t *cell;
+    BaseType_t xRet;
+    bool busy;
+    int32_t ret;
+
+    portENTER_CRITICAL(&ntripLock);
+    busy = (ntrip->connectTask != NULL) || ntrip->connected;
+    portEXIT_CRITICAL(&ntripLock);
+
+    if (busy) {
+        XPLRTRANSPORT_CONSOLE(W, "NTRIP over %s still running, not connecting again",
+                              (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ? "Wi-Fi" : "cell");
+        ret = -1;
+    } else {
+        /* deinit drops the configuration, set it again from the copy */
+        if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+            wifi = (xplrWifi_ntrip_client_t *)ntrip->client;
+            if (!wifi->config_set) {
+                xplrWifiNtripSetConfig(wifi,
+                                       wifi->config,
+                                       ntrip->server.host,
+                                       ntrip->server.port,
+                                       ntrip->server.mountpoint,
+                                       ntrip->server.ggaNecessary);
+                xplrWifiNtripSetCredentials(wifi,
+                                            cred->useAuth,
+                                            cred->username,
+                                            cred->password,
+                                            cred->userAgent);
+            }
+        } else {
+            cell = (xplrCell_ntrip_client_t *)ntrip->client;
+            if (!cell->config_set) {
+                xplrCellNtripSetConfig(cell,
+                                       cell->config,
+                                       ntrip->server.host,
+                                       ntrip->server.port,
+                                       ntrip->server.mountpoint,
+                                       cell->cellDvcProfile,
+                                       ntrip->server.ggaNecessary);
+                xplrCellNtripSetCredentials(cell,
+                                            cred->useAuth,
+                                            cred->username,
+                                            cred->password,
+                                            cred->userAgent);
+            }
+        }
+
+        ntrip->cancel = false;
+        /* the handle is set before the task runs */
+        xRet = xTaskCreate(ntripConnectTask,
+                           "ntripConnectTask",
+                           XPLR_TRANSPORT_NTRIP_CONNECT_TASK_STACK,
+                           ntrip,
+                           XPLR_TRANSPORT_NTRIP_CONNECT_TASK_PRIO,
+                           &ntrip->connectTask);
+        if (xRet != pdPASS) {
+            ntrip->connectTask = NULL;
+            XPLRTRANSPORT_CONSOLE(E, "Could not create the NTRIP connect task");
+            ret = -1;
+        } else {
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+static void ntripDisconnect(void *ctx)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)ctx;
+    xplr_ntrip_error_t ntripRet;
+    bool connected;
+
+    portENTER_CRITICAL(&ntripLock);
+    connected = ntrip->connected;
+    if (ntrip->connectTask != NULL) {
+        /* still in the init, the connect task drops it */
+        ntrip->cancel = true;
+    }
+    ntrip->connected = false;
+    portEXIT_CRITICAL(&ntripLock);
+
+    if (connected) {
+        if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+            ntripRet = xplrWifiNtripDeInit((xplrWifi_ntrip_client_t *)ntrip->client);
+        } else {
+            ntripRet = xplrCellNtripDeInit((xplrCell_ntrip_client_t *)ntrip->client);
+        }
+        if (ntripRet != XPLR_NTRIP_OK) {
+            XPLRTRANSPORT_CONSOLE(W, "NTRIP client deinit failed");
+        }
+        XPLRTRANSPORT_CONSOLE(I, "NTRIP over %s disconnected",
+                              (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ? "Wi-Fi" : "cell");
+    }
+}
+
+/**
+ * Sends GGA only when the client asks for it: sending moves the client to
+ * READY, which would drop a correction chunk not read yet. Other writes are
+ * taken as sent, the caster gets the next GGA on its request.
+ */
+static int32_t ntripSend(void *ctx, const void *data, size_t len)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)ctx;
+    xplrWifi_ntrip_client_t *wifi = (xplrWifi_ntrip_client_t *)ntrip->client;
+    xplrCell_ntrip_client_t *cell = (xplrCell_ntrip_client_t *)ntrip->client;
+    xplr_ntrip_state_t state;
+    xplr_ntrip_error_t ntripRet;
+    bool connecting;
+    int32_t ret;
+
+    if (ntripIsConnected(ntrip, &connecting)) {
+        state = (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ?
+                xplrWifiNtripGetClientState(wifi) : xplrCellNtripGetClientState(cell);
+    } else {
+        state = connecting ? XPLR_NTRIP_STATE_BUSY : XPLR_NTRIP_STATE_ERROR;
+    }
+
+    switch (state) {
+        case XPLR_NTRIP_STATE_BUSY:
+            /* nothing sent before the handshake is done */
+            ret = 0;
+            break;
+        case XPLR_NTRIP_STATE_REQUEST_GGA:
+            /* the clients do not modify the GGA buffer */
+            if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+                ntripRet = xplrWifiNtripSendGGA(wifi, (char *)data, (uint32_t)len);
+            } else {
+                ntripRet = xplrCellNtripSendGGA(cell, (char *)data, (uint32_t)len);
+            }
+            ret = (ntripRet == XPLR_NTRIP_OK) ? (int32_t)len : -1;
+            break;
+        case XPLR_NTRIP_STATE_ERROR:
+        case XPLR_NTRIP_STATE_CONNECTION_RESET:
+            ret = -1;
+            break;
+        default:
+            ret = (int32_t)len;
+            break;
+    }
+
+    return ret;
+}
+
+static int32_t ntripRecv(void *ctx, void *buf, size_t size)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)ctx;
+    xplrWifi_ntrip_client_t *wifi = (xplrWifi_ntrip_client_t *)ntrip->client;
+    xplrCell_ntrip_client_t *cell = (xplrCell_ntrip_client_t *)ntrip->client;
+    xplr_ntrip_state_t state;
+    xplr_ntrip_error_t ntripRet;
+    uint32_t corrDataSize = 0;
+    bool connecting;
+    int32_t ret;
+
+    if (ntripIsConnected(ntrip, &connecting)) {
+        state = (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ?
+                xplrWifiNtripGetClientState(wifi) : xplrCellNtripGetClientState(cell);
+    } else {
+        /* connecting bearers are timed out by the transport */
+        state = connecting ? XPLR_NTRIP_STATE_BUSY : XPLR_NTRIP_STATE_ERROR;
+    }
+
+    switch (state) {
+        case XPLR_NTRIP_STATE_CORRECTION_DATA_AVAILABLE:
+            if (size < XPLRNTRIP_RECEIVE_DATA_SIZE) {
+                XPLRTRANSPORT_CONSOLE(E, "Read buffer smaller than XPLRNTRIP_RECEIVE_DATA_SIZE");
+                ret = 0;
+            } else {
+                if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+                    ntripRet = xplrWifiNtripGetCorrectionData(wifi, (char *)buf, (uint32_t)size, &corrDataSize);
+                } else {
+                    ntripRet = xplrCellNtripGetCorrectionData(cell, (char *)buf, (uint32_t)size, &corrDataSize);
+                }
+                ret = (ntripRet == XPLR_NTRIP_OK) ? (int32_t)corrDataSize : -1;
+            }
+            break;
+        case XPLR_NTRIP_STATE_ERROR:
+        case XPLR_NTRIP_STATE_CONNECTION_RESET:
+            ret = -1;
+            break;
+        default:
+            /* GGA requests are served by the periodic transport writes */
+            ret = 0;
+            break;
+    }
+
+    return ret;
+}
+
+static bool ntripLinkUp(void *ctx)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)ctx;
+
+    return (ntrip->linkUp == NULL) || ntrip->linkUp();
+}
+
+static bool ntripIsConnected(xplrTransportNtrip_t *ntrip, bool *connecting)
+{
+    bool ret;
+
+    portENTER_CRITICAL(&ntripLock);
+    ret = ntrip->connected;
+    *connecting = (ntrip->connectTask != NULL) && !ntrip->cancel;
+    portEXIT_CRITICAL(&ntripLock);
+
+    return ret;
+}
+
+/**
+ * Runs the client init, which blocks for the socket connect and the caster
+ * handshake, away from the task driving the transport.
+ */
+static void ntripConnectTask(void *pvParams)
+{
+    xplrTransportNtrip_t *ntrip = (xplrTransportNtrip_t *)pvParams;
+    xplr_ntrip_error_t ntripRet;
+    bool dropped;
+
+    if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+        ntripRet = xplrWifiNtripInit((xplrWifi_ntrip_client_t *)ntrip->client, ntrip->semaphore);
+    } else {
+        ntripRet = xplrCellNtripInit((xplrCell_ntrip_client_t *)ntrip->client, ntrip->semaphore);
+    }
+
+    portENTER_CRITICAL(&ntripLock);
+    dropped = ntrip->cancel;
+    if (!dropped) {
+        ntrip->connected = (ntripRet == XPLR_NTRIP_OK);
+    }
+    portEXIT_CRITICAL(&ntripLock);
+
+    if (dropped && (ntripRet == XPLR_NTRIP_OK)) {
+        if (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) {
+            (void)xplrWifiNtripDeInit((xplrWifi_ntrip_client_t *)ntrip->client);
+        } else {
+            (void)xplrCellNtripDeInit((xplrCell_ntrip_client_t *)ntrip->client);
+        }
+    }
+
+    if (dropped) {
+        XPLRTRANSPORT_CONSOLE(I, "NTRIP over %s dropped while connecting",
+                              (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ? "Wi-Fi" : "cell");
+    } else if (ntripRet == XPLR_NTRIP_OK) {
+        XPLRTRANSPORT_CONSOLE(I, "NTRIP over %s connected",
+                              (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ? "Wi-Fi" : "cell");
+    } else {
+        XPLRTRANSPORT_CONSOLE(W, "NTRIP over %s failed to connect",
+                              (ntrip->bearer == XPLR_TRANSPORT_NTRIP_WIFI) ? "Wi-Fi" : "cell");
+    }
+
+    portENTER_CRITICAL(&ntripLock);
+    ntrip->connectTask = NULL;
+    portEXIT_CRITICAL(&ntripLock);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_TRANSPORT_NTRIP_H_
+#define _XPLR_TRANSPORT_NTRIP_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "xplr_transport.h"
+#include "./../ntripWiFiClient_service/xplr_wifi_ntrip_client.h"
+#include "./../ntripCellClient_service/xplr_cell_ntrip_client.h"
+#include "./../log_service/xplr_log.h"
+#include "./../common/xplr_common.h"
+
+/** @file
+ * @brief Bearers of xplrTransport_t over the NTRIP clients, so that one
+ * correction client gets RTCM from the caster over Wi-Fi or cellular,
+ * whichever is up. Read returns the correction data, write sends GGA.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * PUBLIC TYPES
+ * -------------------------------------------------------------- */
+
+typedef enum {
+    XPLR_TRANSPORT_NTRIP_WIFI = 0,
+    XPLR_TRANSPORT_NTRIP_CELL
+} xplrTransportNtripBearer_t;
+
+/**
+ * NTRIP bearer, the ctx of xplrTransportNtripOps.
+ * The Wi-Fi and the cellular clients can run at the same time,
+ * there can be only one of each. Connect runs the client init, socket
+ * connect and caster handshake, in a task of its own: the read that
+ * connects returns at once and the bearer is connecting until it is done.
+ */
+typedef struct xplrTransportNtrip_type {
+    xplrTransportNtripBearer_t  bearer;
+    void                        *client;        /**< xplrWifi_ntrip_client_t or xplrCell_ntrip_client_t */
+    SemaphoreHandle_t           semaphore;      /**< given to the client init */
+    xplr_ntrip_server_config_t  server;         /**< restored on every connect, the client deinit drops it */
+    xplr_ntrip_credentials_t    credentials;
+    bool                        (*linkUp)(void);
+    TaskHandle_t                connectTask;    /**< runs the client init, NULL when done */
+    bool                        connected;      /**< client initialized */
+    bool                        cancel;         /**< disconnected while connecting, dropped when the init is done */
+} xplrTransportNtrip_t;
+
+/** Bearer callbacks, the ctx is a xplrTransportNtrip_t. */
+extern const xplrTransportOps_t xplrTransportNtripOps;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Set up a bearer over the Wi-Fi NTRIP client. The client configuration
+ * and credentials must have been set, the client must not be initialized:
+ * the transport connects it when needed.
+ *
+ * @param ntrip         bearer.
+ * @param client        Wi-Fi NTRIP client.
+ * @param semaphore     semaphore for the client, created by the application.
+ * @param linkUp        optional, tells if Wi-Fi is connected. When NULL a lost
+ *                      network is only noticed by the client or by the silence.
+ * @return              XPLR_TRANSPORT_OK on success, XPLR_TRANSPORT_ERROR otherwise.
+ */
+xplrTransport_error_t xplrTransportNtripWifiSetup(xplrTransportNtrip_t *ntrip,
+                                                  xplrWifi_ntrip_client_t *client,
+                                                  SemaphoreHandle_t semaphore,
+                                                  bool (*linkUp)(void));
+
+/**
+ * @brief Set up a bearer over the cellular NTRIP client. The client configuration
+ * and credentials must have been set, the client must not be initialized:
+ * the transport connects it when needed.
+ *
+ * @param ntrip         bearer.
+ * @param client        cellular NTRIP client.
+ * @param semaphore     semaphore for the client, created by the application.
+ * @param linkUp        optional, tells if the cellular module is registered.
+ * @return              XPLR_TRANSPORT_OK on success, XPLR_TRANSPORT_ERROR otherwise.
+ */
+xplrTransport_error_t xplrTransportNtripCellSetup(xplrTransportNtrip_t *ntrip,
+                                                  xplrCell_ntrip_client_t *client,
+                                                  SemaphoreHandle_t semaphore,
+                                                  bool (*linkUp)(void));
+
+/**
+ * @brief Function that initializes logging of the module with user-selected configuration
+ *
+ * @param logCfg    Pointer to a xplr_cfg_logInstance_t configuration struct.
+ *                  If NULL, the instance will be initialized using the default settings
+ *                  (located in xplr_hpglib_cfg.h file)
+ * @return          index of the logging instance in success, -1 in failure.
+*/
+int8_t xplrTransportNtripInitLogModule(xplr_cfg_logInstance_t *logCfg);
+
+/**
+ * @brief   Function that stops the logging of the transport ntrip module
+ *
+ * @return  ESP_OK on success, ESP_FAIL otherwise.
+*/
+esp_err_t xplrTransportNtripStopLogModule(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_TRANSPORT_NTRIP_H_ */
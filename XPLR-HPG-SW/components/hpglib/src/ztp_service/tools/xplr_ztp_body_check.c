@@ -0,0 +1,362 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host check of the Wi-Fi ZTP body handling (xplr_ztp_body.c) against the
+ * replies of xplr_ztp_standin.py.
+ *
+ * Every case starts the stand-in in one of its modes on a local port, posts
+ * a ZTP request over plain HTTP and hands the body to the body handling the
+ * way xplrZtpGetPayloadWifi() does: the Content-Length header reserves the
+ * payload, then the body arrives de-chunked, one piece per chunk or per
+ * PIECE_SIZE bytes. A complete body must be copied byte for byte, in the user
+ * buffer or in a heap copy when it does not fit, a body larger than the heap
+ * limit must be rejected and a truncated one reported as incomplete. The
+ * payload is then released as with xplrZtpFreePayload(), the address
+ * sanitizer reports any leak.
+ *
+ * Build and run on Linux, from this directory (python3 runs the stand-in):
+ *   gcc -O1 -g -fsanitize=address,undefined -I.. xplr_ztp_body_check.c ../xplr_ztp_body.c -o xplr_ztp_body_check
+ *
+ * Usage:
+ *   xplr_ztp_body_check [case ...]
+ *
+ * Without cases all of them run. Prints the outcome of every case and PASS,
+ * or FAIL with the failing cases. The exit code is 0 on PASS.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "xplr_ztp_body.h"
+
+#define PAYLOAD_SIZE        (6U * 1024U)    /* XPLRZTP_PAYLOAD_SIZE_MAX, payload of the examples */
+#define PAYLOAD_HEAP_MAX    (32U * 1024U)   /* XPLRZTP_PAYLOAD_HEAP_MAX */
+#define PIECE_SIZE          (512U)          /* buffer_size of esp_http_client */
+#define PORT_BASE           (18440U)
+#define CONNECT_RETRIES     (100U)
+#define CONNECT_RETRY_MS    (50U)
+#define RESPONSE_MAX        (256U * 1024U)
+
+typedef enum {
+    EXPECT_BUFFER,      /* complete, in the user buffer */
+    EXPECT_HEAP,        /* complete, moved to the heap */
+    EXPECT_REJECTED,    /* larger than PAYLOAD_HEAP_MAX */
+    EXPECT_TRUNCATED    /* connection closed in the middle of the JSON */
+} expect_t;
+
+typedef struct {
+    const char  *name;
+    const char  *args[6];   /* stand-in mode and options */
+    size_t      bufferSize; /* user buffer */
+    expect_t    expect;
+} checkCase_t;
+
+static const checkCase_t cases[] = {
+    { "plain",          { "plain" },                                    PAYLOAD_SIZE,   EXPECT_BUFFER },
+    { "plain-small",    { "plain" },                                    256,            EXPECT_HEAP },
+    { "chunked",        { "chunked" },                                  PAYLOAD_SIZE,   EXPECT_BUFFER },
+    { "chunked-bytes",  { "chunked", "--chunk-size", "1" },             PAYLOAD_SIZE,   EXPECT_BUFFER },
+    { "drip",           { "drip", "--chunk-size", "700", "--delay", "0.01" }, PAYLOAD_SIZE, EXPECT_BUFFER },
+    { "oversized",      { "oversized", "--size", "12" },                PAYLOAD_SIZE,   EXPECT_HEAP },
+    { "oversized-max",  { "oversized", "--size", "40" },                PAYLOAD_SIZE,   EXPECT_REJECTED },
+    { "truncated",      { "truncated" },                                PAYLOAD_SIZE,   EXPECT_TRUNCATED },
+};
+
+#define CASES_CNT   (sizeof(cases) / sizeof(cases[0]))
+
+typedef struct {
+    int         status;         /* HTTP status code */
+    char        *body;          /* de-chunked body as received */
+    size_t      bodyLength;
+    size_t      *chunks;        /* size of every chunk, the whole body when not chunked */
+    size_t      chunksCnt;
+    long        contentLength;  /* -1 when chunked */
+} response_t;
+
+static void sleepMs(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+
+    nanosleep(&ts, NULL);
+}
+
+static pid_t standinStart(const checkCase_t *c, unsigned int port)
+{
+    const char *argv[12];
+    char portStr[8];
+    size_t n = 0;
+    pid_t pid;
+
+    snprintf(portStr, sizeof(portStr), "%u", port);
+    argv[n++] = "python3";
+    argv[n++] = "xplr_ztp_standin.py";
+    for (size_t i = 0; (i < 6) && (c->args[i] != NULL); i++) {
+        argv[n++] = c->args[i];
+    }
+    argv[n++] = "--port";
+    argv[n++] = portStr;
+    argv[n] = NULL;
+
+    pid = fork();
+    if (pid == 0) {
+        if (freopen("/dev/null", "w", stderr) == NULL) {
+            _exit(127);
+        }
+        execvp(argv[0], (char *const *)argv);
+        _exit(127);
+    }
+
+    return pid;
+}
+
+static void standinStop(pid_t pid)
+{
+    if (pid > 0) {
+        kill(pid, SIGINT);
+        waitpid(pid, NULL, 0);
+    }
+}
+
+static int standinConnect(unsigned int port)
+{
+    struct sockaddr_in addr;
+    int sock = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (unsigned int i = 0; (i < CONNECT_RETRIES) && (sock < 0); i++) {
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(sock);
+            sock = -1;
+            sleepMs(CONNECT_RETRY_MS);
+        }
+    }
+
+    return sock;
+}
+
+/* Posts the ZTP request and reads the raw reply until the stand-in closes */
+static size_t ztpPost(int sock, char *raw, size_t size)
+{
+    static const char post[] = "{\"tags\": [\"ztp\"],\"token\":\"00000000-0000-0000-0000-000000000000\","
+                               "\"hardwareId\":\"xplr-hpg-check\",\"givenName\":\"xplr-hpg-check\"}";
+    char request[512];
+    size_t length = 0;
+    ssize_t n;
+    int len;
+
+    len = snprintf(request, sizeof(request),
+                   "POST /ztp HTTP/1.1\r\nHost: localhost\r\n"
+                   "Content-Type: application/json\r\nAccept: application/json\r\n"
+                   "Connection: close\r\nContent-Length: %zu\r\n\r\n%s",
+                   strlen(post), post);
+    if (write(sock, request, (size_t)len) != len) {
+        return 0;
+    }
+
+    while ((length < (size - 1)) && ((n = read(sock, raw + length, size - 1 - length)) > 0)) {
+        length += (size_t)n;
+    }
+    raw[length] = 0;
+
+    return length;
+}
+
+/* Splits the raw reply in status, headers and de-chunked body, as esp_http_client does */
+static void responseParse(char *raw, size_t rawLength, response_t *rsp)
+{
+    char *end = raw + rawLength;
+    char *line = raw;
+    char *eol;
+    bool chunked = false;
+    unsigned long chunk;
+
+    rsp->status = 0;
+    rsp->contentLength = -1;
+    rsp->body = malloc(rawLength + 1);
+    rsp->bodyLength = 0;
+    rsp->chunks = malloc((rawLength + 1) * sizeof(size_t));
+    rsp->chunksCnt = 0;
+
+    /* status line and headers */
+    while ((line < end) && ((eol = strstr(line, "\r\n")) != NULL) && (eol != line)) {
+        *eol = 0;
+        if (strncmp(line, "HTTP/1.", 7) == 0) {
+            rsp->status = atoi(line + 9);
+        } else if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            rsp->contentLength = atol(line + 15);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = (strstr(line + 18, "chunked") != NULL);
+        }
+        line = eol + 2;
+    }
+    line += 2;
+
+    if (!chunked) {
+        rsp->bodyLength = (size_t)(end - line);
+        memcpy(rsp->body, line, rsp->bodyLength);
+        rsp->chunks[rsp->chunksCnt++] = rsp->bodyLength;
+    } else {
+        while ((line < end) && ((eol = strstr(line, "\r\n")) != NULL)) {
+            chunk = strtoul(line, NULL, 16);
+            line = eol + 2;
+            if ((chunk == 0) || (line >= end)) {
+                break;
+            }
+            if (chunk > (unsigned long)(end - line)) {
+                chunk = (unsigned long)(end - line);
+            }
+            memcpy(rsp->body + rsp->bodyLength, line, chunk);
+            rsp->bodyLength += chunk;
+            rsp->chunks[rsp->chunksCnt++] = chunk;
+            line += chunk + 2;
+        }
+    }
+    rsp->body[rsp->bodyLength] = 0;
+}
+
+/* Hands the body to the body handling as the HTTP events of xplrZtpGetPayloadWifi() do */
+static void bodyFeed(xplrZtpBody_t *body, const response_t *rsp)
+{
+    const char *data = rsp->body;
+    size_t piece;
+
+    if (rsp->contentLength >= 0) {
+        (void)xplrZtpBodyReserve(body, (size_t)rsp->contentLength + 1);
+    }
+    for (size_t i = 0; i < rsp->chunksCnt; i++) {
+        for (size_t offset = 0; offset < rsp->chunks[i]; offset += piece) {
+            piece = rsp->chunks[i] - offset;
+            if (piece > PIECE_SIZE) {
+                piece = PIECE_SIZE;
+            }
+            (void)xplrZtpBodyAppend(body, data + offset, piece);
+        }
+        data += rsp->chunks[i];
+    }
+}
+
+static bool caseRun(const checkCase_t *c, unsigned int port)
+{
+    static char raw[RESPONSE_MAX];
+    char *buffer = malloc(c->bufferSize);
+    xplrZtpBody_t body;
+    response_t rsp;
+    pid_t pid;
+    size_t rawLength = 0;
+    bool copied;
+    bool ok;
+    int sock;
+
+    pid = standinStart(c, port);
+    sock = standinConnect(port);
+    if (sock >= 0) {
+        rawLength = ztpPost(sock, raw, sizeof(raw));
+        close(sock);
+    }
+    standinStop(pid);
+    if (rawLength == 0) {
+        printf("  %-14s no reply from xplr_ztp_standin.py\n", c->name);
+        free(buffer);
+        return false;
+    }
+
+    responseParse(raw, rawLength, &rsp);
+    xplrZtpBodyInit(&body, buffer, c->bufferSize, false, PAYLOAD_HEAP_MAX);
+    bodyFeed(&body, &rsp);
+
+    copied = (body.payload != NULL) && (body.length == rsp.bodyLength) &&
+             (strlen(body.payload) == rsp.bodyLength) &&
+             (memcmp(body.payload, rsp.body, rsp.bodyLength) == 0);
+
+    switch (c->expect) {
+        case EXPECT_BUFFER:
+            ok = body.complete && !body.error && copied &&
+                 !body.allocated && (body.payload == buffer);
+            break;
+        case EXPECT_HEAP:
+            ok = body.complete && !body.error && copied &&
+                 body.allocated && (body.payload != buffer) &&
+                 (body.payloadSize > rsp.bodyLength) && (body.payloadSize <= PAYLOAD_HEAP_MAX);
+            break;
+        case EXPECT_REJECTED:
+            ok = body.error && (rsp.bodyLength >= PAYLOAD_HEAP_MAX) &&
+                 (body.length == rsp.bodyLength) && (body.payloadSize <= PAYLOAD_HEAP_MAX);
+            break;
+        case EXPECT_TRUNCATED:
+            ok = !body.complete && !body.error && body.started && (body.depth > 0) && copied;
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    printf("  %-14s HTTP %d, %6zu bytes in %4u pieces, %s, %s %zu bytes: %s\n",
+           c->name, rsp.status, body.length, body.chunks,
+           body.error ? "rejected" : (body.complete ? "complete" : "truncated"),
+           body.allocated ? "heap" : "buffer", body.payloadSize,
+           ok ? "ok" : "FAILED");
+
+    xplrZtpBodyFree(&body);
+    ok = ok && !body.allocated && (body.payload == NULL || body.payload == buffer);
+    free(rsp.chunks);
+    free(rsp.body);
+    free(buffer);
+
+    return ok && (rsp.status == 200);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int failed = 0;
+    unsigned int run = 0;
+    bool selected;
+
+    printf("ZTP body against xplr_ztp_standin.py, buffer %u, heap limit %u, pieces of %u bytes\n",
+           PAYLOAD_SIZE, PAYLOAD_HEAP_MAX, PIECE_SIZE);
+    for (unsigned int i = 0; i < CASES_CNT; i++) {
+        selected = (argc < 2);
+        for (int a = 1; a < argc; a++) {
+            selected = selected || (strcmp(argv[a], cases[i].name) == 0);
+        }
+        if (selected) {
+            run++;
+            if (!caseRun(&cases[i], PORT_BASE + i)) {
+                failed++;
+            }
+        }
+    }
+
+    if ((run == 0) || (failed > 0)) {
+        printf("FAIL: %u of %u cases\n", failed, run);
+    } else {
+        printf("PASS: %u cases\n", run);
+    }
+
+    return ((run == 0) || (failed > 0)) ? 1 : 0;
+}
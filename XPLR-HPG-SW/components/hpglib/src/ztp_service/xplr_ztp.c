@@ -15,12 +15,15 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_http_client.h"
 #include "esp_check.h"
 #include "esp_log.h"
 #include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
 #include "xplr_ztp.h"
+#include "xplr_ztp_body.h"
 #include "xplr_http_client.h"
 #include "xplr_common.h"
 
@@ -40,13 +43,52 @@
 #else
 #define XPLRZTP_CONSOLE(message, ...) do{} while(0)
 #endif
+
+/**
+ * Size of the ZTP POST body
+ */
+#define XPLR_ZTP_POST_DATA_SIZE             (150U)
+
+/**
+ * Timeout of the cellular ZTP request, the http client gives it up a few
+ * seconds later, this margin covers it and the reconnection that follows
+ */
+#define XPLR_ZTP_CELL_TIMEOUT_S             (30)
+#define XPLR_ZTP_CELL_TIMEOUT_MARGIN_S      (15U)
+
+#if (XPLRZTP_PAYLOAD_HEAP_MAX > UINT16_MAX)
+#error "XPLRZTP_PAYLOAD_HEAP_MAX must fit in xplrZtpData_t.payloadLength."
+#endif
+
+/* ----------------------------------------------------------------
+ * STATIC TYPES
+ * -------------------------------------------------------------- */
+
+/**
+ * ZTP response body, kept in step with the xplrZtpData_t of the request
+ */
+typedef struct ztpRspBody_type {
+    xplrZtpData_t   *ztpData;       /**< destination of the body */
+    xplrZtpBody_t   body;           /**< body in progress, see xplr_ztp_body.h */
+} ztpRspBody_t;
+
+/**
+ * Cellular ZTP request, served by the asynchronous requests of the http client
+ */
+typedef struct ztpCellRequest_type {
+    SemaphoreHandle_t   done;       /**< given when the request is over */
+    int32_t             statusCode; /**< http status code or negative error */
+    bool                truncated;  /**< body longer than XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE */
+} ztpCellRequest_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * --------------------------------------------------------------- */
-static uint32_t bufferStackPointer = 0;
-static size_t max_buffer_size;
+static ztpRspBody_t ztpWifiBody;
+static ztpRspBody_t ztpCellBody;
+static ztpCellRequest_t ztpCellRequest;
+static char ztpCellPostData[XPLR_ZTP_POST_DATA_SIZE];
 static xplrCell_http_client_t httpCellClient;
-static xplrCell_http_session_t httpSessionCell;
 static esp_http_client_handle_t httpWifiClient;
 static int8_t logIndex = -1;
 /* ----------------------------------------------------------------
@@ -54,10 +96,13 @@ static int8_t logIndex = -1;
  * -------------------------------------------------------------- */
 
 static esp_err_t httpWifiCallback(esp_http_client_event_handle_t evt);
-static void httpCellCallback(uDeviceHandle_t devHandle,
-                             int32_t statusCodeOrError,
-                             size_t responseSize,
-                             void *pResponseCallbackParam);
+static bool httpCellSink(const char *data, size_t length, size_t offset, void *arg);
+static void httpCellDone(int8_t dvcProfile,
+                         int32_t requestId,
+                         int32_t statusCode,
+                         size_t rspSize,
+                         bool truncated,
+                         void *arg);
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTION PROTOTYPES
@@ -74,17 +119,19 @@ static esp_err_t ztpWifiSetPostData(char *post_data,
 static esp_err_t ztpWifiPostMsg(esp_http_client_handle_t httpWifiClient,
                                 xplrZtpData_t *ztpData);
 static void ztpWifiHttpCleanup(esp_http_client_handle_t httpWifiClient);
-static void ztpWifiPopulateBuffer(char *payload, char *source, uint16_t length);
+static esp_err_t ztpRspBodyAppend(ztpRspBody_t *rspBody, const char *data, size_t length);
+static bool ztpRspBodyReserve(ztpRspBody_t *rspBody, size_t needed);
+static void ztpRspBodySync(ztpRspBody_t *rspBody);
 /**
  * CELL
 */
 static void ztpCellClientConfig(xplrCell_http_client_t *httpCellClient,
                                 xplr_thingstream_t *thingstream,
-                                xplrZtpData_t *ztpData,
                                 const char *rootCaName);
 static esp_err_t ztpCellHttpConnect(xplrCom_cell_config_t *cellConfig,
                                     xplrCell_http_client_t *httpCellClient);
 static esp_err_t ztpCellPostMsg(xplrCell_http_client_t *httpCellClient,
+                                xplr_thingstream_t *thingstream,
                                 xplrZtpData_t *ztpData,
                                 xplrCom_cell_config_t *cellConfig);
 
@@ -96,7 +143,7 @@ esp_err_t xplrZtpGetPayloadWifi(xplr_thingstream_t *thingstream,
                                 xplrZtpData_t *ztpData)
 {
     esp_err_t ret;
-    char post_data[150] = {0};
+    char post_data[XPLR_ZTP_POST_DATA_SIZE] = {0};
     // Setup HTTP client
     esp_http_client_config_t config_post = {
         .url = NULL,
@@ -104,22 +151,27 @@ esp_err_t xplrZtpGetPayloadWifi(xplr_thingstream_t *thingstream,
         .event_handler = httpWifiCallback,
         .cert_pem = thingstream->server.rootCa,
         .transport_type = HTTP_TRANSPORT_OVER_SSL,
-        .user_data = ztpData->payload
+        .user_data = &ztpWifiBody
     };
 
-    strcat(thingstream->server.serverUrl, thingstream->pointPerfect.urlPath);
-    config_post.url = thingstream->server.serverUrl;
-    max_buffer_size = ztpData->payloadLength;
-
     /* Null pointer check*/
-    if (ztpData->payload == NULL ||
-        ztpData == NULL ||
+    if (ztpData == NULL ||
+        ((ztpData->payload == NULL) && (ztpData->onData == NULL)) ||
         thingstream == NULL ||
         thingstream->server.ppToken == NULL ||
         thingstream->server.deviceId == NULL) {
         XPLRZTP_CONSOLE(E, "NULL pointer detected!");
         ret = ESP_FAIL;
     } else {
+        strcat(thingstream->server.serverUrl, thingstream->pointPerfect.urlPath);
+        config_post.url = thingstream->server.serverUrl;
+        ztpWifiBody.ztpData = ztpData;
+        xplrZtpBodyInit(&ztpWifiBody.body,
+                        ztpData->payload,
+                        ztpData->payloadLength,
+                        ztpData->payloadAllocated,
+                        XPLRZTP_PAYLOAD_HEAP_MAX);
+        ztpRspBodySync(&ztpWifiBody);
         XPLRZTP_CONSOLE(D, "POST URL: %s", thingstream->server.serverUrl);
         //Initialize HTTP Client
         httpWifiClient = esp_http_client_init(&config_post);
@@ -133,7 +185,7 @@ esp_err_t xplrZtpGetPayloadWifi(xplr_thingstream_t *thingstream,
                 XPLRZTP_CONSOLE(E, "Setting POST headers failed!");
             } else {
                 //Create ZTP message
-                ret = ztpWifiSetPostData(post_data, 150, thingstream, httpWifiClient);
+                ret = ztpWifiSetPostData(post_data, XPLR_ZTP_POST_DATA_SIZE, thingstream, httpWifiClient);
                 if (ret != ESP_OK) {
                     XPLRZTP_CONSOLE(E, "Setting POST message failed!");
                 } else {
@@ -146,55 +198,40 @@ esp_err_t xplrZtpGetPayloadWifi(xplr_thingstream_t *thingstream,
     return ret;
 }
 
+void xplrZtpFreePayload(xplrZtpData_t *ztpData)
+{
+    if ((ztpData != NULL) && ztpData->payloadAllocated) {
+        free(ztpData->payload);
+        ztpData->payload = NULL;
+        ztpData->payloadLength = 0;
+        ztpData->payloadAllocated = false;
+    } else {
+        // do nothing
+    }
+}
+
 esp_err_t xplrZtpGetPayloadCell(const char *rootCaName,
                                 xplr_thingstream_t *thingstream,
                                 xplrZtpData_t *ztpData,
                                 xplrCom_cell_config_t *cellConfig)
 {
     esp_err_t ret;
-    xplr_thingstream_error_t tsErr;
-    int64_t timeNow, startTime;
 
     if (rootCaName == NULL ||
         thingstream == NULL ||
         ztpData == NULL ||
+        ((ztpData->payload == NULL) && (ztpData->onData == NULL)) ||
         cellConfig == NULL) {
         ret = ESP_FAIL;
         XPLRZTP_CONSOLE(E, "Null pointer! Cannot perform ZTP!");
     } else {
         //Config HTTP Client
-        ztpCellClientConfig(&httpCellClient, thingstream, ztpData, rootCaName);
+        ztpCellClientConfig(&httpCellClient, thingstream, rootCaName);
         //Connect to server
         ret = ztpCellHttpConnect(cellConfig, &httpCellClient);
-        //Create ZTP message for POST
         if (ret == ESP_OK) {
-            tsErr = xplrThingstreamApiMsgCreate(XPLR_THINGSTREAM_API_LOCATION_ZTP,
-                                                ztpData->payload,
-                                                &httpCellClient.session->data.bufferSizeOut,
-                                                thingstream);
-            if (tsErr == XPLR_THINGSTREAM_OK) {
-
-                //Perform HTTP POST
-                ret = ztpCellPostMsg(&httpCellClient, ztpData, cellConfig);
-                //Get payload from the request (triggered by callback)
-                startTime = esp_timer_get_time();
-                timeNow = startTime;
-                while (!httpCellClient.session->requestPending &&
-                       (timeNow - startTime) <= XPLR_ZTP_HTTP_TIMEOUT_MS) {
-                    // wait until a response to the POST request arrives
-                    timeNow = esp_timer_get_time();
-                }
-                if ((timeNow - startTime) > XPLR_ZTP_HTTP_TIMEOUT_MS) {
-                    XPLRZTP_CONSOLE(E, "HTTP POST timeout!");
-                    ret = ESP_ERR_TIMEOUT;
-                } else {
-                    ret = ESP_OK;
-                }
-            } else {
-                XPLRZTP_CONSOLE(E, "Could not create POST message for ZTP");
-                ret = ESP_FAIL;
-            }
-
+            //Perform HTTP POST, the body is received by the http client worker
+            ret = ztpCellPostMsg(&httpCellClient, thingstream, ztpData, cellConfig);
         } else {
             XPLRZTP_CONSOLE(E, "Error in http client setup");
         }
@@ -333,32 +370,30 @@ static esp_err_t ztpWifiPostMsg(esp_http_client_handle_t httpWifiClient,
                                 xplrZtpData_t *ztpData)
 {
     esp_err_t ret;
-    int length;
     // Blocking function no need for while loop or termination flag
     ret = esp_http_client_perform(httpWifiClient);
     if (ret != ESP_OK) {
         XPLRZTP_CONSOLE(E, "Error in HTTP POST");
-        ztpWifiHttpCleanup(httpWifiClient);
     } else {
         ztpData->httpReturnCode = esp_http_client_get_status_code(httpWifiClient);
-        length = esp_http_client_get_content_length(httpWifiClient);
-        if (length > ztpData->payloadLength - 1) {
-            ztpData->payload[0] = 0;
-            XPLRZTP_CONSOLE(E, "HTTPS POST payload larger [%d] than buffer [%d]!",
-                            length,
-                            ztpData->payloadLength - 1);
-            ztpWifiHttpCleanup(httpWifiClient);
-        } else {
-            //Do nothing
-        }
     }
 
-    if (ztpData->httpReturnCode == HttpStatus_Ok) {
-        XPLRZTP_CONSOLE(D, "HTTPS POST request OK.");
-        ret = ESP_OK;
-    } else {
+    if (ret != ESP_OK) {
+        // do nothing
+    } else if (ztpData->httpReturnCode != HttpStatus_Ok) {
         XPLRZTP_CONSOLE(D, "HTTPS POST request failed: Code [%d]", ztpData->httpReturnCode);
         ret = ESP_FAIL;
+    } else if (ztpWifiBody.body.error || !ztpWifiBody.body.complete) {
+        XPLRZTP_CONSOLE(E, "HTTPS POST payload %s after %u bytes in %u chunks!",
+                        ztpWifiBody.body.error ? "rejected" : "truncated",
+                        ztpData->bodyLength,
+                        ztpWifiBody.body.chunks);
+        ret = ESP_FAIL;
+    } else {
+        XPLRZTP_CONSOLE(D, "HTTPS POST request OK, %u bytes in %u chunks.",
+                        ztpData->bodyLength,
+                        ztpWifiBody.body.chunks);
+        ret = ESP_OK;
     }
 
     XPLRZTP_CONSOLE(D, "HTTPS POST: Return Code - %d", ztpData->httpReturnCode);
@@ -381,17 +416,84 @@ static void ztpWifiHttpCleanup(esp_http_client_handle_t httpWifiClient)
 }
 
 /*
- * Populates the buffer from the HTTP EVENTS to be sent back as a result.
+ * Hands a piece of the response body to the user callback and
+ * appends it to the payload, as it arrives from the HTTP events.
  */
-static void ztpWifiPopulateBuffer(char *payload, char *source, uint16_t length)
+static esp_err_t ztpRspBodyAppend(ztpRspBody_t *rspBody, const char *data, size_t length)
 {
-    if (bufferStackPointer < max_buffer_size) {
-        memcpy(payload + bufferStackPointer, source, length);
-        bufferStackPointer += length;
-        payload[bufferStackPointer] = 0;
+    xplrZtpData_t *ztpData = rspBody->ztpData;
+    xplrZtpBody_t *body = &rspBody->body;
+    bool rejected = body->error;
+    esp_err_t err;
+
+    if (!xplrZtpBodyScan(body, data, length)) {
+        if (!rejected) {
+            XPLRZTP_CONSOLE(E, "Payload is not a single JSON object!");
+        } else {
+            // do nothing
+        }
+    } else if (ztpData->onData != NULL) {
+        err = ztpData->onData(data, length, ztpData->onDataArg);
+        if (err != ESP_OK) {
+            XPLRZTP_CONSOLE(E, "Payload rejected by the data callback (%d)", err);
+            body->error = true;
+        } else {
+            // do nothing
+        }
+    } else {
+        // do nothing
+    }
+
+    if (!body->error) {
+        (void)ztpRspBodyReserve(rspBody, body->length + length + 1);
     } else {
-        XPLRZTP_CONSOLE(E, "Payload buffer not big enough. Could not copy all data from HTTP!");
+        // do nothing
     }
+    (void)xplrZtpBodyCopy(body, data, length);
+    ztpRspBodySync(rspBody);
+
+    return body->error ? ESP_FAIL : ESP_OK;
+}
+
+/*
+ * Makes room for needed bytes in the payload.
+ * The user buffer is left for a heap copy once it is too small.
+ */
+static bool ztpRspBodyReserve(ztpRspBody_t *rspBody, size_t needed)
+{
+    xplrZtpBody_t *body = &rspBody->body;
+    size_t size = body->payloadSize;
+    bool ret;
+
+    ret = xplrZtpBodyReserve(body, needed);
+    if (!ret) {
+        if (needed > body->payloadMax) {
+            XPLRZTP_CONSOLE(E, "Payload [%u] larger than %u bytes!", needed, body->payloadMax);
+        } else {
+            XPLRZTP_CONSOLE(E, "Could not allocate the payload for %u bytes!", needed);
+        }
+    } else if (body->payloadSize != size) {
+        XPLRZTP_CONSOLE(D, "Payload buffer grown to %u bytes", body->payloadSize);
+    } else {
+        // do nothing
+    }
+    ztpRspBodySync(rspBody);
+
+    return ret;
+}
+
+/*
+ * Mirrors the body in progress to the ZTP data of the request,
+ * so a payload moved to the heap is always released by xplrZtpFreePayload().
+ */
+static void ztpRspBodySync(ztpRspBody_t *rspBody)
+{
+    xplrZtpData_t *ztpData = rspBody->ztpData;
+
+    ztpData->payload = rspBody->body.payload;
+    ztpData->payloadLength = (uint16_t)rspBody->body.payloadSize;
+    ztpData->payloadAllocated = rspBody->body.allocated;
+    ztpData->bodyLength = rspBody->body.length;
 }
 
 /* -------------------------------------------
@@ -403,23 +505,17 @@ static void ztpWifiPopulateBuffer(char *payload, char *source, uint16_t length)
 */
 static void ztpCellClientConfig(xplrCell_http_client_t *httpCellClient,
                                 xplr_thingstream_t *thingstream,
-                                xplrZtpData_t *ztpData,
                                 const char *rootCaName)
 {
     //Create and config a cell http client
     httpCellClient->credentials.token = thingstream->server.ppToken;
     httpCellClient->credentials.rootCa = thingstream->server.rootCa;
     httpCellClient->credentials.rootCaName = rootCaName;
-    httpCellClient->session = &httpSessionCell;
-    httpCellClient->session->data.buffer = ztpData->payload;
-    httpCellClient->session->data.bufferSizeOut = ztpData->payloadLength;
-    httpCellClient->session->data.path = thingstream->pointPerfect.urlPath;
-    memcpy(httpCellClient->session->data.contentType, HTTP_POST_HEADER_TYPE_DATA_CONTENT, 17);
-    httpCellClient->session->data.bufferSizeIn = ztpData->payloadLength;
-    httpCellClient->responseCb = &httpCellCallback;
+    //No response callback, the client serves xplrCellHttpRequestAsync()
+    httpCellClient->responseCb = NULL;
     //Config HTTP server settings
     httpCellClient->settings.errorOnBusy = false;
-    httpCellClient->settings.timeoutSeconds = 30;
+    httpCellClient->settings.timeoutSeconds = XPLR_ZTP_CELL_TIMEOUT_S;
     httpCellClient->settings.serverAddress = thingstream->server.serverUrl;
     httpCellClient->settings.registerMethod = XPLR_CELL_HTTP_CERT_METHOD_ROOTCA;
     httpCellClient->settings.async = true;
@@ -458,35 +554,103 @@ static esp_err_t ztpCellHttpConnect(xplrCom_cell_config_t *cellConfig,
 }
 
 /**
- * Function that handles the POST request for ZTP (via Cellular)
+ * Function that handles the POST request for ZTP (via Cellular).
+ * The request is queued to the http client, which hands the body to
+ * httpCellSink() and reports the end to httpCellDone().
 */
 static esp_err_t ztpCellPostMsg(xplrCell_http_client_t *httpCellClient,
+                                xplr_thingstream_t *thingstream,
                                 xplrZtpData_t *ztpData,
                                 xplrCom_cell_config_t *cellConfig)
 {
-    esp_err_t ret;
+    xplrCell_http_request_t request = {
+        .method = XPLR_CELL_HTTP_METHOD_POST,
+        .clientId = httpCellClient->id,
+        .host = NULL,
+        .path = thingstream->pointPerfect.urlPath,
+        .body = ztpCellPostData,
+        .contentType = HTTP_POST_HEADER_TYPE_DATA_CONTENT,
+        .sink = httpCellSink,
+        .sinkArg = &ztpCellBody,
+        .done = httpCellDone,
+        .doneArg = &ztpCellRequest
+    };
+    TickType_t wait = pdMS_TO_TICKS((XPLR_ZTP_CELL_TIMEOUT_S + XPLR_ZTP_CELL_TIMEOUT_MARGIN_S) * 1000U);
+    size_t postSize = sizeof(ztpCellPostData);
+    xplr_thingstream_error_t tsErr;
     xplrCell_http_error_t err;
-    xplrCom_cell_connect_t comState;
+    esp_err_t ret;
 
-    comState = xplrComCellFsmConnectGetState(cellConfig->profileIndex);
-    if (comState == XPLR_COM_CELL_CONNECTED) {
-        err = xplrCellHttpPostRequest(cellConfig->profileIndex, httpCellClient->id, NULL);
-        vTaskDelay(1);
-        if (err == XPLR_CELL_HTTP_ERROR) {
-            ret = ESP_FAIL;
+    if (ztpCellRequest.done == NULL) {
+        ztpCellRequest.done = xSemaphoreCreateBinary();
+    } else {
+        // do nothing
+    }
+
+    /* over cellular the body is bounded by the http client, keep it in the user buffer */
+    ztpCellBody.ztpData = ztpData;
+    xplrZtpBodyInit(&ztpCellBody.body,
+                    ztpData->payload,
+                    ztpData->payloadLength,
+                    ztpData->payloadAllocated,
+                    ztpData->payloadLength);
+    ztpRspBodySync(&ztpCellBody);
+    ztpCellRequest.statusCode = XPLR_CELL_HTTP_STATUS_DROPPED;
+    ztpCellRequest.truncated = false;
+
+    tsErr = xplrThingstreamApiMsgCreate(XPLR_THINGSTREAM_API_LOCATION_ZTP,
+                                        ztpCellPostData,
+                                        &postSize,
+                                        thingstream);
+    if (ztpCellRequest.done == NULL) {
+        XPLRZTP_CONSOLE(E, "Could not create the ZTP request semaphore!");
+        ret = ESP_FAIL;
+    } else if (tsErr != XPLR_THINGSTREAM_OK) {
+        XPLRZTP_CONSOLE(E, "Could not create POST message for ZTP");
+        ret = ESP_FAIL;
+    } else if (xplrComCellFsmConnectGetState(cellConfig->profileIndex) != XPLR_COM_CELL_CONNECTED) {
+        ret = ESP_FAIL;
+    } else {
+        request.bodySize = strlen(ztpCellPostData);
+        /* a done left from a request given up before */
+        (void)xSemaphoreTake(ztpCellRequest.done, 0);
+        err = xplrCellHttpRequestAsync(cellConfig->profileIndex, &request, NULL);
+        if (err != XPLR_CELL_HTTP_OK) {
             XPLRZTP_CONSOLE(E, "Device %d, client %d (http) POST REQUEST to %s, failed.\n",
                             cellConfig->profileIndex,
                             httpCellClient->id,
-                            httpCellClient->session->data.path);
+                            request.path);
+            ret = ESP_FAIL;
+        } else if (xSemaphoreTake(ztpCellRequest.done, wait) != pdTRUE) {
+            /* the disconnect drops the request, wait for it to let go of the payload */
+            XPLRZTP_CONSOLE(E, "HTTP POST timeout!");
+            xplrCellHttpDisconnect(cellConfig->profileIndex, httpCellClient->id);
+            (void)xSemaphoreTake(ztpCellRequest.done, wait);
+            ret = ESP_ERR_TIMEOUT;
         } else {
             ret = ESP_OK;
-            XPLRZTP_CONSOLE(D, "Device %d, client %d (http) POST REQUEST to %s, ok.\n",
-                            cellConfig->profileIndex,
-                            httpCellClient->id,
-                            httpCellClient->session->data.path);
         }
-    } else {
+    }
+
+    if (ret != ESP_OK) {
+        // do nothing
+    } else if (ztpCellRequest.statusCode < 0) {
+        XPLRZTP_CONSOLE(E, "HTTPS POST request failed (%d)", ztpCellRequest.statusCode);
         ret = ESP_FAIL;
+    } else {
+        ztpData->httpReturnCode = (HttpStatus_Code)ztpCellRequest.statusCode;
+        if (ztpData->httpReturnCode != HttpStatus_Ok) {
+            XPLRZTP_CONSOLE(D, "HTTPS POST request failed: Code [%d]", ztpData->httpReturnCode);
+            ret = ESP_FAIL;
+        } else if (ztpCellRequest.truncated || ztpCellBody.body.error || !ztpCellBody.body.complete) {
+            XPLRZTP_CONSOLE(E, "HTTPS POST payload %s after %u bytes!",
+                            ztpCellBody.body.error ? "rejected" : "truncated",
+                            ztpData->bodyLength);
+            ret = ESP_FAIL;
+        } else {
+            XPLRZTP_CONSOLE(D, "HTTPS POST request OK, %u bytes.", ztpData->bodyLength);
+            ret = ESP_OK;
+        }
     }
 
     return ret;
@@ -503,6 +667,7 @@ static esp_err_t ztpCellPostMsg(xplrCell_http_client_t *httpCellClient,
  */
 static esp_err_t httpWifiCallback(esp_http_client_event_handle_t evt)
 {
+    ztpRspBody_t *rspBody = (ztpRspBody_t *)evt->user_data;
     esp_err_t ret;
 
     switch (evt->event_id) {
@@ -516,16 +681,22 @@ static esp_err_t httpWifiCallback(esp_http_client_event_handle_t evt)
             break;
 
         case HTTP_EVENT_ON_HEADER:
+            /* size the payload once when the length is known up front */
+            if (strcasecmp(evt->header_key, "Content-Length") == 0) {
+                (void)ztpRspBodyReserve(rspBody, strtoul(evt->header_value, NULL, 10) + 1);
+            } else {
+                // do nothing
+            }
             ret = ESP_OK;
             break;
 
         case HTTP_EVENT_ON_DATA:
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                ztpWifiPopulateBuffer((char *)evt->user_data, evt->data, evt->data_len);
-                ret = ESP_OK;
+            /* chunked bodies arrive already de-chunked, pieces are handled the same way */
+            if (esp_http_client_get_status_code(evt->client) == HttpStatus_Ok) {
+                ret = ztpRspBodyAppend(rspBody, evt->data, evt->data_len);
             } else {
-                XPLRZTP_CONSOLE(W, "HTTP_DATA_IS_CHUNKED!");
-                ret = ESP_FAIL;
+                XPLRZTP_CONSOLE(W, "HTTP error body: %.*s", evt->data_len, (char *)evt->data);
+                ret = ESP_OK;
             }
             break;
 
@@ -548,26 +719,32 @@ static esp_err_t httpWifiCallback(esp_http_client_event_handle_t evt)
 }
 
 /*
- * Handles HTTP(S) Events as they arrive after performing a POST request.
+ * Receives the ZTP response body from the http client worker.
  * Specific for cellular.
  */
-static void httpCellCallback(uDeviceHandle_t devHandle,
-                             int32_t statusCodeOrError,
-                             size_t responseSize,
-                             void *pResponseCallbackParam)
+static bool httpCellSink(const char *data, size_t length, size_t offset, void *arg)
 {
-    XPLRZTP_CONSOLE(I, "Http response callback fired with code (%d).", statusCodeOrError);
-    XPLRZTP_CONSOLE(D, "Message size of %d bytes.\n", responseSize);
-
-    httpCellClient.session->error = statusCodeOrError;
-    if (statusCodeOrError > -1) {
-        httpCellClient.session->statusCode = statusCodeOrError;
-        httpCellClient.session->rspAvailable = true;
-        httpCellClient.session->rspSize = responseSize;
-        httpCellClient.session->data.bufferSizeOut = XPLRZTP_PAYLOAD_SIZE_MAX;
-    }
+    (void)offset;
 
-    if (httpCellClient.session->requestPending) {
-        httpCellClient.session->requestPending = false;
-    }
-}
\ No newline at end of file
+    return (ztpRspBodyAppend((ztpRspBody_t *)arg, data, length) == ESP_OK);
+}
+
+/*
+ * Called by the http client worker once the ZTP request is over.
+ * Specific for cellular.
+ */
+static void httpCellDone(int8_t dvcProfile,
+                         int32_t requestId,
+                         int32_t statusCode,
+                         size_t rspSize,
+                         bool truncated,
+                         void *arg)
+{
+    ztpCellRequest_t *cellRequest = (ztpCellRequest_t *)arg;
+    (void)dvcProfile;
+
+    XPLRZTP_CONSOLE(I, "Http request %d done with code (%d), %u bytes.", requestId, statusCode, rspSize);
+    cellRequest->statusCode = statusCode;
+    cellRequest->truncated = truncated;
+    xSemaphoreGive(cellRequest->done);
+}
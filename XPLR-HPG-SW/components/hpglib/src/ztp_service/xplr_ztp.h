@@ -61,13 +61,24 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/**
+ * Receives the ZTP response body piece by piece while it is downloaded.
+ * Return ESP_OK to keep going, anything else fails the request.
+ */
+typedef esp_err_t (*xplrZtpDataCb_t)(const char *data, size_t length, void *arg);
+
 /**
  * Contains ZTP payload in a form of a JSON string
  */
 typedef struct xplrZtpData_type {
-    char *payload;                  /**< the payload/JSON itself */
+    char *payload;                  /**< the payload/JSON itself, NULL to only stream it to onData */
     uint16_t payloadLength;         /**< length of payload/JSON. */
     HttpStatus_Code httpReturnCode; /**< HTTP/S return code */
+    xplrZtpDataCb_t onData;         /**< optional, called with every piece of the body as it arrives */
+    void *onDataArg;                /**< user argument passed to onData */
+    size_t bodyLength;              /**< bytes of body received */
+    bool payloadAllocated;          /**< payload was moved to the heap to fit the body,
+                                         release it with xplrZtpFreePayload() */
 } xplrZtpData_t;
 
 /* ----------------------------------------------------------------
@@ -78,6 +89,9 @@ typedef struct xplrZtpData_type {
  * @brief Function that handles the ZTP with Thingstream and fetches the required
  *        credentials to be able to connect and subscribe to Thingstream. Specific
  *        for WiFi.
+ *        Plain and chunked responses are accepted. The body is handed to ztpData->onData
+ *        as it arrives and copied to ztpData->payload; a body larger than payloadLength
+ *        moves the payload to the heap, up to XPLRZTP_PAYLOAD_HEAP_MAX bytes.
  *
  * @param thingstream  Thingstream configuration struct pointer. Must be initialized.
  * @param ztpData      a xplrZtpData_type struct that contains payload and http return code.
@@ -90,7 +104,10 @@ esp_err_t xplrZtpGetPayloadWifi(xplr_thingstream_t *thingstream,
 /**
  * @brief Function that handles the ZTP with Thingstream and fetches the required
  *        credentials to be able to connect and subscribe to Thingstream. Specific
- *        for cell.
+ *        for cell. The POST is queued with xplrCellHttpRequestAsync() and the call
+ *        waits for it to be over. The body goes to ztpData->onData, if set, and to
+ *        the payload, which is not moved to the heap: a body that does not fit
+ *        payloadLength fails the request.
  *
  * @param rootCaName   root certificate name for HTTPS request.
  *                     This must be provided since the request requires SSL
@@ -106,6 +123,14 @@ esp_err_t xplrZtpGetPayloadCell(const char *rootCaName,
                                 xplrZtpData_t *ztpData,
                                 xplrCom_cell_config_t *cellConfig);
 
+/**
+ * @brief Release a payload that xplrZtpGetPayloadWifi() moved to the heap.
+ *        Does nothing if the payload is the buffer given by the user.
+ *
+ * @param ztpData      ZTP data holding the payload.
+ */
+void xplrZtpFreePayload(xplrZtpData_t *ztpData);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of the C standard library are allowed here,
+ * the body handling is also built on a host.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "xplr_ztp_body.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define XPLR_ZTP_BODY_HEAP_MIN      (1024U)     /* first heap copy when there is no user buffer */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+void xplrZtpBodyInit(xplrZtpBody_t *body,
+                     char *buffer,
+                     size_t size,
+                     bool allocated,
+                     size_t sizeMax)
+{
+    memset(body, 0, sizeof(xplrZtpBody_t));
+    body->payload = buffer;
+    body->payloadSize = size;
+    body->payloadMax = sizeMax;
+    body->allocated = allocated;
+    if ((buffer != NULL) && (size > 0)) {
+        buffer[0] = 0;
+    } else {
+        // do nothing
+    }
+}
+
+bool xplrZtpBodyReserve(xplrZtpBody_t *body, size_t needed)
+{
+    size_t newSize;
+    char *newPayload;
+    bool ret;
+
+    if ((body->payload == NULL) || (needed <= body->payloadSize)) {
+        ret = true;
+    } else if (needed > body->payloadMax) {
+        ret = false;
+    } else {
+        newSize = (body->payloadSize > 0) ? body->payloadSize : XPLR_ZTP_BODY_HEAP_MIN;
+        while (newSize < needed) {
+            newSize *= 2;
+        }
+        if (newSize > body->payloadMax) {
+            newSize = body->payloadMax;
+        } else {
+            // do nothing
+        }
+
+        if (body->allocated) {
+            newPayload = realloc(body->payload, newSize);
+        } else {
+            newPayload = malloc(newSize);
+            if (newPayload != NULL) {
+                memcpy(newPayload, body->payload, body->length);
+            } else {
+                // do nothing
+            }
+        }
+
+        if (newPayload == NULL) {
+            ret = false;
+        } else {
+            body->payload = newPayload;
+            body->payloadSize = newSize;
+            body->allocated = true;
+            ret = true;
+        }
+    }
+
+    if (!ret) {
+        body->error = true;
+    } else {
+        // do nothing
+    }
+
+    return ret;
+}
+
+bool xplrZtpBodyScan(xplrZtpBody_t *body, const char *data, size_t length)
+{
+    char c;
+
+    body->chunks++;
+    for (size_t i = 0; (i < length) && !body->error; i++) {
+        c = data[i];
+        if (body->inString) {
+            if (body->escape) {
+                body->escape = false;
+            } else if (c == '\\') {
+                body->escape = true;
+            } else if (c == '"') {
+                body->inString = false;
+            } else {
+                // do nothing
+            }
+        } else if ((c == ' ') || (c == '\n') || (c == '\r') || (c == '\t')) {
+            // do nothing
+        } else if (body->complete) {
+            /* data after the top level value */
+            body->error = true;
+        } else if (!body->started) {
+            if (c == '{') {
+                body->started = true;
+                body->depth = 1;
+            } else {
+                body->error = true;
+            }
+        } else if (c == '"') {
+            body->inString = true;
+        } else if ((c == '{') || (c == '[')) {
+            body->depth++;
+        } else if ((c == '}') || (c == ']')) {
+            body->depth--;
+            body->complete = (body->depth == 0);
+        } else {
+            // do nothing
+        }
+    }
+
+    return !body->error;
+}
+
+bool xplrZtpBodyCopy(xplrZtpBody_t *body, const char *data, size_t length)
+{
+    if ((body->payload != NULL) && !body->error &&
+        xplrZtpBodyReserve(body, body->length + length + 1)) {
+        memcpy(body->payload + body->length, data, length);
+        body->payload[body->length + length] = 0;
+    } else {
+        // do nothing
+    }
+    body->length += length;
+
+    return !body->error;
+}
+
+bool xplrZtpBodyAppend(xplrZtpBody_t *body, const char *data, size_t length)
+{
+    (void)xplrZtpBodyScan(body, data, length);
+
+    return xplrZtpBodyCopy(body, data, length);
+}
+
+void xplrZtpBodyFree(xplrZtpBody_t *body)
+{
+    if (body->allocated) {
+        free(body->payload);
+        body->payload = NULL;
+        body->payloadSize = 0;
+        body->allocated = false;
+    } else {
+        // do nothing
+    }
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_ZTP_BODY_H_
+#define _XPLR_ZTP_BODY_H_
+
+/* Only the C standard library here: the body handling is
+ * also built on a host, see tools/xplr_ztp_body_check.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file
+ * @brief Assembly of a ZTP response body from the pieces handed by the
+ * HTTP client, plain or de-chunked. The JSON structure is followed while the
+ * body arrives, so a truncated or non JSON body is caught without parsing it,
+ * and the copy moves from the user buffer to the heap when it gets too small.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * PUBLIC TYPES
+ * -------------------------------------------------------------- */
+
+/**
+ * Progress of a ZTP response body
+ */
+typedef struct xplrZtpBody_type {
+    char        *payload;       /**< copy of the body, NULL to only follow its structure */
+    size_t      payloadSize;    /**< size of payload */
+    size_t      payloadMax;     /**< largest size payload may grow to on the heap */
+    size_t      length;         /**< bytes of body received */
+    bool        allocated;      /**< payload is a heap copy, release it with xplrZtpBodyFree() */
+    uint32_t    chunks;         /**< pieces received */
+    int16_t     depth;          /**< JSON object/array nesting */
+    bool        started;        /**< first JSON character seen */
+    bool        inString;       /**< inside a JSON string */
+    bool        escape;         /**< previous character was a backslash in a string */
+    bool        complete;       /**< top level JSON value closed */
+    bool        error;          /**< body rejected, the request fails */
+} xplrZtpBody_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Starts a new body.
+ *
+ * @param body        body to start.
+ * @param buffer      user buffer for the copy, NULL to keep no copy.
+ *                    May already be a heap copy of a previous body.
+ * @param size        size of buffer.
+ * @param allocated   buffer is a heap copy that may be reallocated.
+ * @param sizeMax     largest size the copy may grow to.
+ */
+void xplrZtpBodyInit(xplrZtpBody_t *body,
+                     char *buffer,
+                     size_t size,
+                     bool allocated,
+                     size_t sizeMax);
+
+/**
+ * @brief Makes room for needed bytes in the copy, moving it to the heap
+ *        when the user buffer is too small.
+ *
+ * @param body    body in progress.
+ * @param needed  bytes needed, terminator included.
+ * @return        false if needed is above sizeMax or the heap is exhausted,
+ *                the body is rejected then.
+ */
+bool xplrZtpBodyReserve(xplrZtpBody_t *body, size_t needed);
+
+/**
+ * @brief Follows the JSON structure of a piece of the body.
+ *        Rejects a body that is not a JSON object or goes on after it.
+ *
+ * @param body    body in progress.
+ * @param data    piece of the body.
+ * @param length  size of data.
+ * @return        false if the body is rejected.
+ */
+bool xplrZtpBodyScan(xplrZtpBody_t *body, const char *data, size_t length);
+
+/**
+ * @brief Appends a piece of the body to the copy, null terminated.
+ *
+ * @param body    body in progress.
+ * @param data    piece of the body.
+ * @param length  size of data.
+ * @return        false if the body is rejected.
+ */
+bool xplrZtpBodyCopy(xplrZtpBody_t *body, const char *data, size_t length);
+
+/**
+ * @brief xplrZtpBodyScan() then xplrZtpBodyCopy() for a piece of the body.
+ *
+ * @param body    body in progress.
+ * @param data    piece of the body.
+ * @param length  size of data.
+ * @return        false if the body is rejected.
+ */
+bool xplrZtpBodyAppend(xplrZtpBody_t *body, const char *data, size_t length);
+
+/**
+ * @brief Releases the copy if it was moved to the heap.
+ *
+ * @param body    body to release.
+ */
+void xplrZtpBodyFree(xplrZtpBody_t *body);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_ZTP_BODY_H_ */
@@ -97,6 +97,8 @@ extern "C" {
 #define XPLRBLUETOOTH_DEBUG_ACTIVE                     (1U)
 #define XPLRATSERVER_DEBUG_ACTIVE                      (1U)
 #define XPLRATPARSER_DEBUG_ACTIVE                      (1U)
+#define XPLROTA_DEBUG_ACTIVE                           (1U)
+#define XPLRTRANSPORT_DEBUG_ACTIVE                     (1U)
 
 /**
  * Select in which modules to activate the logging in the SD card
@@ -118,20 +120,44 @@ extern "C" {
 #define XPLRBLUETOOTH_LOG_ACTIVE                       (1U)
 #define XPLRATSERVER_LOG_ACTIVE                        (1U)
 #define XPLRATPARSER_LOG_ACTIVE                        (1U)
+#define XPLROTA_LOG_ACTIVE                             (1U)
+#define XPLRTRANSPORT_LOG_ACTIVE                       (1U)
 
 
 /**
  * Configure hpg module settings
  */
 #define XPLRCOM_NUMOF_DEVICES                          (1U)
+#define XPLRCOM_CELL_RETRY_MAX                         (3U)                         /* Retries of a failing connection step before going to error */
+#define XPLRCOM_CELL_BACKOFF_INITIAL_MS                (2000U)                      /* Delay before the first retry, grows up to XPLRCOM_CELL_BACKOFF_MAX_MS */
+#define XPLRCOM_CELL_BACKOFF_MAX_MS                    (30000U)
+#define XPLRCOM_CELL_READY_TIMEOUT_MS                  (60000U)                     /* Time the module may stay busy after a reboot */
+#define XPLRCOM_CELL_PROFILE_CACHE_ACTIVE              (1U)                         /* Skip MNO/RAT/band setup when already applied */
 #define XPLRCELL_MQTT_NUMOF_CLIENTS                    (1U)
+#define XPLRCELL_HTTP_NUMOF_CLIENTS                    (2U)                         /* HTTP connections per cellular device, SARA-R5 has 4 HTTP profiles */
+#define XPLRCELL_HTTP_ASYNC_QUEUE_LEN                  (8U)                         /* Asynchronous HTTP requests waiting per cellular device */
+#define XPLRCELL_HTTP_ASYNC_RSP_BUFFER_SIZE            (XPLRZTP_PAYLOAD_SIZE_MAX)   /* Response buffer of each connection serving asynchronous requests, fits a ZTP reply */
 #define XPLRGNSS_NUMOF_DEVICES                         (1U)
+#define XPLRGNSS_SUBSCRIBERS_MAX                       (4U)
+#define XPLRGNSS_EVENT_QUEUE_DEPTH                     (4U)
+#define XPLRGNSS_WARM_START_ACTIVE                     (1U)
 #define XPLRLBAND_NUMOF_DEVICES                        (1U)
+#define XPLRLBAND_NUMOF_DEST_GNSS                      (XPLRGNSS_NUMOF_DEVICES)
 #define XPLRATSERVER_NUMOF_SERVERS                     (1U)
 #define XPLRCELL_MQTT_MAX_SIZE_OF_TOPIC_NAME           (64U)
 #define XPLRCELL_MQTT_MAX_SIZE_OF_TOPIC_PAYLOAD        (10U * 1024U)
 #define XPLRZTP_PAYLOAD_SIZE_MAX                       (6U * 1024U)
+#define XPLRZTP_PAYLOAD_HEAP_MAX                       (32U * 1024U)                /* Largest ZTP body kept in memory over Wi-Fi */
+#define XPLRTHINGSTREAM_CACHE_REFRESH_MARGIN_S         (2U * 24U * 60U * 60U)       /* Refresh a stored ZTP result this long before its keys expire */
 #define XPLRCELL_GREETING_MESSAGE_MAX                  (64U)
+#define XPLRWIFISTARTER_NETWORKS_MAX                   (4U)                         /* Networks stored for roaming, besides the configured one */
+#define XPLRWIFISTARTER_BACKOFF_INITIAL_MS             (250U)                       /* Delay of the second reconnect attempt, the first one is immediate */
+#define XPLRWIFISTARTER_BACKOFF_MAX_MS                 (30000U)                     /* Longest delay between reconnect attempts */
+#define XPLRWIFISTARTER_SCAN_MIN_INTERVAL_MS           (15000U)                     /* Scan results younger than this are served without a new radio scan */
+#define XPLRWIFIDNS_CLIENT_RATE                        (20U)                        /* Captive DNS queries per second answered per client */
+#define XPLRWIFIDNS_CLIENT_BURST                       (40U)                        /* Captive DNS queries a client may send at once */
+#define XPLRWIFIWEBSERVER_TELEMETRY_PERIOD_MS          (1000U)                      /* Period of the telemetry pushed to the live tracker pages */
+#define XPLROTA_CONFIRM_TIMEOUT_S                      (300U)                       /* A new firmware not confirmed within this time is rolled back */
 #if (XPLRCELL_MQTT_NUMOF_CLIENTS > 1)
 #error "Only one (1) MQTT client is currently supported from ubxlib."
 #endif
@@ -140,6 +166,12 @@ extern "C" {
 #define XPLRBLUETOOTH_RX_BUFFER_SIZE                   (4U * 1024U)
 #define XPLRBLUETOOTH_NUMOF_DEVICES                    (3)
 #define XPLRBLUETOOTH_MAX_MSG_SIZE                     (256U)
+#define XPLRBLUETOOTH_DEVICE_RX_BUFFER_SIZE            ((XPLRBLUETOOTH_RX_BUFFER_SIZE / XPLRBLUETOOTH_NUMOF_DEVICES) & ~3U)  /* Per device share of the RX buffer, word aligned */
+#define XPLRBLUETOOTH_STREAM_BATCH_SIZE                (512U)                       /* Max bytes written to the connected devices per stream batch */
+#define XPLRBLUETOOTH_STREAM_FLUSH_MS                  (20U)                        /* Time a partial stream batch waits for more data before being sent */
+#if (XPLRBLUETOOTH_DEVICE_RX_BUFFER_SIZE < (XPLRBLUETOOTH_MAX_MSG_SIZE + 8U))
+#error "XPLRBLUETOOTH_RX_BUFFER_SIZE too small to hold a max size message for every device."
+#endif
 #define XPLRBLUETOOTH_MODE_OFF                         (255)
 #define XPLRBLUETOOTH_MODE_BT_CLASSIC                  (0)                          /* Only supported in HPG-2 board (NINA-W1 variant) */
 #define XPLRBLUETOOTH_MODE_BLE                         (1)
@@ -174,6 +206,8 @@ extern "C" {
 #define XPLR_AT_PARSER_DEFAULT_FILENAME         "xplr_at_parser.log"
 #define XPLR_AT_SERVER_DEFAULT_FILENAME         "xplr_at_server.log"
 #define XPLR_BLUETOOTH_DEFAULT_FILENAME         "xplr_bluetooth.log"
+#define XPLR_OTA_DEFAULT_FILENAME               "xplr_ota.log"
+#define XPLR_TRANSPORT_DEFAULT_FILENAME         "xplr_transport.log"
 
 /**
  * Macro definition to "surpress" any compiler warning message regarding "unused variables".
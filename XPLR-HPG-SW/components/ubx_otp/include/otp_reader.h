@@ -39,8 +39,61 @@ typedef struct {
     otp_ops_t *otp_ops;
 } otp_device_t;
 
+/**
+ * Fields of otp_identity_t, set in its programmed mask when present in otp.
+ */
+typedef enum {
+    OTP_FIELD_RF_FREQ_CALIBRATION   = (1 << 0),
+    OTP_FIELD_MAC_WIFI_STA          = (1 << 1),
+    OTP_FIELD_MAC_WIFI_AP           = (1 << 2),
+    OTP_FIELD_MAC_ETH               = (1 << 3),
+    OTP_FIELD_MAC_BT                = (1 << 4),
+    OTP_FIELD_UUID                  = (1 << 5),
+    OTP_FIELD_SERIAL                = (1 << 6),
+    OTP_FIELD_TYPE_CODE             = (1 << 7)
+} otp_field_t;
+
+/**
+ * Device identity read from otp once, see otp_snapshot_load().
+ * Fields not programmed in otp are zero.
+ */
+typedef struct {
+    const char *part_name;                                  /**< flash part holding the otp */
+    uint32_t programmed;                                    /**< otp_field_t mask of the fields programmed */
+    int8_t rf_freq_calibration;                             /**< rf frequency error, ppm */
+    uint8_t mac_wifi_sta[cbOTP_SIZE_MAC];
+    uint8_t mac_wifi_ap[cbOTP_SIZE_MAC];
+    uint8_t mac_eth[cbOTP_SIZE_MAC];
+    uint8_t mac_bt[cbOTP_SIZE_MAC];
+    uint8_t uuid[cbOTP_SIZE_UUID];
+    uint8_t serial[cbOTP_SIZE_SERIAL];
+    uint8_t type_code[cbOTP_SIZE_TYPE_CODE];
+} otp_identity_t;
+
+/**
+* @brief Read all identity fields from otp into a RAM snapshot, protected by a crc.
+*        The otp is only accessed the first time; later calls and all otp_read_*
+*        functions below are served from the snapshot, without switching the
+*        SPI flash to otp mode. To be called early at boot, before Wi-Fi is started.
+*
+* @return ESP_OK if the snapshot is available, ESP_FAIL if the otp could not be read
+*/
+esp_err_t otp_snapshot_load(void);
+
+/**
+* @brief Get a consistent copy of the device identity.
+*        Loads the snapshot if needed. A snapshot failing its crc check is
+*        read again from otp.
+*
+* @param identity filled with the device identity
+*
+* @return ESP_OK if successful, ESP_FAIL if not
+*/
+esp_err_t otp_get_identity(otp_identity_t *identity);
+
 /**
 * @brief Read device specific rf frequency calibration value from otp.
+*        This and the otp_read_* functions below are served from the snapshot.
 *
 * @param freq_calibration pointer to rf frequency calibration
 *
@@ -107,7 +160,7 @@ esp_err_t otp_read_type_code(uint8_t type_code[cbOTP_SIZE_TYPE_CODE]);
  */
 esp_err_t otp_probe(void);
 /**
- * Read a OTP parameter
+ * Read a OTP parameter directly from the flash, bypassing the snapshot
  * @param offset  The offset of the parameter to write
  * @param len     The length of the parameter to write
  * @param buf     Pointer to data to be written
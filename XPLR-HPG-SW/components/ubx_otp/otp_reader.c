@@ -15,11 +15,15 @@
  */
 #include "sdkconfig.h"
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
 #include "otp_defs.h"
 #include "otp_reader.h"
 #include "otp_is25lp.h"
@@ -42,6 +46,9 @@
 #define IS25W16_JEDEC_ID    0x0015709D
 #define IS25L16_JEDEC_ID    0x0015609D
 
+/* otp parameters from offset 0 up to the end of the type code, read at once */
+#define OTP_SNAPSHOT_SIZE   (cbOTP_OFFSET_TYPE_CODE + cbOTP_SIZE_TYPE_CODE)
+
 /*===========================================================================
 * DECLARATIONS
 *=========================================================================*/
@@ -53,7 +60,17 @@ typedef struct {
     esp_err_t (*otp_chip_probe)(otp_device_t *otpDev);
 } otp_device_list_t;
 
+typedef struct {
+    otp_identity_t identity;
+    uint32_t crc;
+    bool loaded;
+} otp_snapshot_t;
+
 static esp_err_t is_valid_parameter(uint8_t buf[], uint32_t len);
+static void otp_snapshot_field(otp_identity_t *identity, otp_field_t field,
+                               uint8_t *dst, const uint8_t *src, uint32_t len);
+static bool otp_snapshot_copy(otp_identity_t *identity);
+static esp_err_t otp_identity_read(otp_field_t field, size_t offset, uint8_t *buf, uint32_t len);
 /*===========================================================================
  * DEFINITIONS
  *=========================================================================*/
@@ -68,6 +85,8 @@ static otp_device_list_t otp_list[] = {
     {"IS25LP016D", IS25L16_JEDEC_ID, 0x00,            0x400,    otp_is25lp_probe}
 };
 static otp_device_t otp_device;
+static otp_snapshot_t otp_snapshot;
+static portMUX_TYPE otp_snapshot_lock = portMUX_INITIALIZER_UNLOCKED;
 const spi_flash_guard_funcs_t *spi_flash_guard_funcs = NULL;
 /*===========================================================================
 * FUNCTIONS
@@ -261,131 +280,206 @@ uint32_t otp_read(uint32_t offset, uint8_t *buf, uint32_t len)
     return ((err == ESP_OK) ? len : 0);
 }
 
-esp_err_t otp_read_rf_freq_calibration(int8_t *freq_calibration)
+esp_err_t otp_snapshot_load(void)
 {
-    esp_err_t ret;
+    uint8_t raw[OTP_SNAPSHOT_SIZE];
+    otp_identity_t identity;
+    esp_err_t ret = ESP_OK;
 
-    if (freq_calibration == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (otp_snapshot.loaded) {
+        return ESP_OK;
     }
 
-    ret = otp_read(cbOTP_OFFSET_RF_FREQ_CALIBRATION, (uint8_t *)freq_calibration, 1);
-    if (ret != cbOTP_SIZE_RF_FREQ_CALIBRATION) {
-        freq_calibration = 0;
+    if (otp_device.otp_ops == NULL) {
+        ret = otp_probe();
+    }
+    if ((ret == ESP_OK) && (otp_read(0, raw, sizeof(raw)) != sizeof(raw))) {
+        ESP_LOGE("OTP", "Could not read identity from otp\n");
         ret = ESP_FAIL;
-    } else {
-        ret = ESP_OK;
+    }
+
+    if (ret == ESP_OK) {
+        memset(&identity, 0, sizeof(identity));
+        identity.part_name = otp_device.otp_part_name;
+        identity.rf_freq_calibration = (int8_t)raw[cbOTP_OFFSET_RF_FREQ_CALIBRATION];
+        identity.programmed = OTP_FIELD_RF_FREQ_CALIBRATION;
+        otp_snapshot_field(&identity, OTP_FIELD_MAC_WIFI_STA, identity.mac_wifi_sta,
+                           &raw[cbOTP_OFFSET_MAC_WLAN], cbOTP_SIZE_MAC);
+        otp_snapshot_field(&identity, OTP_FIELD_MAC_WIFI_AP, identity.mac_wifi_ap,
+                           &raw[cbOTP_OFFSET_MAC_WLAN_AP], cbOTP_SIZE_MAC);
+        otp_snapshot_field(&identity, OTP_FIELD_MAC_ETH, identity.mac_eth,
+                           &raw[cbOTP_OFFSET_MAC_ETHERNET], cbOTP_SIZE_MAC);
+        otp_snapshot_field(&identity, OTP_FIELD_MAC_BT, identity.mac_bt,
+                           &raw[cbOTP_OFFSET_MAC_BLUETOOTH], cbOTP_SIZE_MAC);
+        otp_snapshot_field(&identity, OTP_FIELD_UUID, identity.uuid,
+                           &raw[cbOTP_OFFSET_UUID], cbOTP_SIZE_UUID);
+        otp_snapshot_field(&identity, OTP_FIELD_SERIAL, identity.serial,
+                           &raw[cbOTP_OFFSET_SERIAL], cbOTP_SIZE_SERIAL);
+        otp_snapshot_field(&identity, OTP_FIELD_TYPE_CODE, identity.type_code,
+                           &raw[cbOTP_OFFSET_TYPE_CODE], cbOTP_SIZE_TYPE_CODE);
+
+        /* the crc is computed on the stored copy, padding included */
+        portENTER_CRITICAL(&otp_snapshot_lock);
+        otp_snapshot.identity = identity;
+        otp_snapshot.crc = esp_rom_crc32_le(0, (const uint8_t *)&otp_snapshot.identity,
+                                            sizeof(otp_identity_t));
+        otp_snapshot.loaded = true;
+        portEXIT_CRITICAL(&otp_snapshot_lock);
+        ESP_LOGI("OTP", "Identity snapshot loaded, fields 0x%02x\n", (unsigned)identity.programmed);
     }
 
     return ret;
 }
 
-esp_err_t otp_read_mac_wifi_sta(uint8_t mac[cbOTP_SIZE_MAC])
+esp_err_t otp_get_identity(otp_identity_t *identity)
 {
-    esp_err_t ret;
+    esp_err_t ret = ESP_OK;
 
-    if (mac == NULL) {
+    if (identity == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_MAC_WLAN, mac, cbOTP_SIZE_MAC);
-    if (ret != cbOTP_SIZE_MAC) {
-        memset(mac, 0, cbOTP_SIZE_MAC);
-        ret = ESP_FAIL;
-    } else {
-        ret = is_valid_parameter(mac, cbOTP_SIZE_MAC);
+    if (!otp_snapshot_copy(identity)) {
+        if (otp_snapshot.loaded) {
+            ESP_LOGW("OTP", "Identity snapshot corrupted, reading otp again\n");
+            portENTER_CRITICAL(&otp_snapshot_lock);
+            otp_snapshot.loaded = false;
+            portEXIT_CRITICAL(&otp_snapshot_lock);
+        }
+        ret = otp_snapshot_load();
+        if ((ret == ESP_OK) && !otp_snapshot_copy(identity)) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    if (ret != ESP_OK) {
+        memset(identity, 0, sizeof(otp_identity_t));
     }
+
     return ret;
 }
 
-esp_err_t otp_read_mac_wifi_ap(uint8_t mac[cbOTP_SIZE_MAC])
+esp_err_t otp_read_rf_freq_calibration(int8_t *freq_calibration)
 {
-    esp_err_t ret;
+    if (freq_calibration == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    return otp_identity_read(OTP_FIELD_RF_FREQ_CALIBRATION,
+                             offsetof(otp_identity_t, rf_freq_calibration),
+                             (uint8_t *)freq_calibration,
+                             cbOTP_SIZE_RF_FREQ_CALIBRATION);
+}
+
+esp_err_t otp_read_mac_wifi_sta(uint8_t mac[cbOTP_SIZE_MAC])
+{
     if (mac == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_MAC_WLAN_AP, mac, cbOTP_SIZE_MAC);
-    if (ret != cbOTP_SIZE_MAC) {
-        memset(mac, 0, cbOTP_SIZE_MAC);
-        ret = ESP_FAIL;
-    } else {
-        ret = is_valid_parameter(mac, cbOTP_SIZE_MAC);
-    }
-    return ret;
+    return otp_identity_read(OTP_FIELD_MAC_WIFI_STA, offsetof(otp_identity_t, mac_wifi_sta),
+                             mac, cbOTP_SIZE_MAC);
 }
 
-esp_err_t otp_read_mac_eth(uint8_t mac[cbOTP_SIZE_MAC])
+esp_err_t otp_read_mac_wifi_ap(uint8_t mac[cbOTP_SIZE_MAC])
 {
-    esp_err_t ret;
-
     if (mac == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_MAC_ETHERNET, mac, cbOTP_SIZE_MAC);
-    if (ret != cbOTP_SIZE_MAC) {
-        memset(mac, 0, cbOTP_SIZE_MAC);
-        ret = ESP_FAIL;
-    } else {
-        ret = is_valid_parameter(mac, cbOTP_SIZE_MAC);
+    return otp_identity_read(OTP_FIELD_MAC_WIFI_AP, offsetof(otp_identity_t, mac_wifi_ap),
+                             mac, cbOTP_SIZE_MAC);
+}
+
+esp_err_t otp_read_mac_eth(uint8_t mac[cbOTP_SIZE_MAC])
+{
+    if (mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    return ret;
+    return otp_identity_read(OTP_FIELD_MAC_ETH, offsetof(otp_identity_t, mac_eth),
+                             mac, cbOTP_SIZE_MAC);
 }
 
 esp_err_t otp_read_mac_bt(uint8_t mac[cbOTP_SIZE_MAC])
 {
-    esp_err_t ret;
-
     if (mac == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_MAC_BLUETOOTH, mac, cbOTP_SIZE_MAC);
-    if (ret != cbOTP_SIZE_MAC) {
-        memset(mac, 0, cbOTP_SIZE_MAC);
-        ret = ESP_FAIL;
-    } else {
-        ret = is_valid_parameter(mac, cbOTP_SIZE_MAC);
-    }
-    return ret;
+    return otp_identity_read(OTP_FIELD_MAC_BT, offsetof(otp_identity_t, mac_bt),
+                             mac, cbOTP_SIZE_MAC);
 }
 
 esp_err_t otp_read_uuid(uint8_t uuid[cbOTP_SIZE_UUID])
 {
-    esp_err_t ret;
-
     if (uuid == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_UUID, uuid, cbOTP_SIZE_UUID);
-    if (ret != cbOTP_SIZE_UUID) {
-        memset(uuid, 0, cbOTP_SIZE_UUID);
-        ret = ESP_FAIL;
-    } else {
-        ret = is_valid_parameter(uuid, cbOTP_SIZE_UUID);
-    }
-    return ret;
+    return otp_identity_read(OTP_FIELD_UUID, offsetof(otp_identity_t, uuid),
+                             uuid, cbOTP_SIZE_UUID);
 }
 
 esp_err_t otp_read_type_code(uint8_t type_code[cbOTP_SIZE_TYPE_CODE])
 {
-    esp_err_t ret;
-
     if (type_code == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ret = otp_read(cbOTP_OFFSET_TYPE_CODE, type_code, cbOTP_SIZE_TYPE_CODE);
-    if (ret != cbOTP_SIZE_TYPE_CODE) {
-        memset(type_code, 0, cbOTP_SIZE_TYPE_CODE);
-        ret = ESP_FAIL;
+    return otp_identity_read(OTP_FIELD_TYPE_CODE, offsetof(otp_identity_t, type_code),
+                             type_code, cbOTP_SIZE_TYPE_CODE);
+}
+
+/**
+* @brief Copy a parameter into the identity if it is programmed.
+*/
+static void otp_snapshot_field(otp_identity_t *identity, otp_field_t field,
+                               uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    if (is_valid_parameter((uint8_t *)src, len) == ESP_OK) {
+        memcpy(dst, src, len);
+        identity->programmed |= field;
+    }
+}
+
+/**
+* @brief Copy the snapshot out if it is loaded and passes its crc check.
+*/
+static bool otp_snapshot_copy(otp_identity_t *identity)
+{
+    bool valid;
+
+    portENTER_CRITICAL(&otp_snapshot_lock);
+    valid = otp_snapshot.loaded &&
+            (esp_rom_crc32_le(0, (const uint8_t *)&otp_snapshot.identity,
+                              sizeof(otp_identity_t)) == otp_snapshot.crc);
+    if (valid) {
+        *identity = otp_snapshot.identity;
+    }
+    portEXIT_CRITICAL(&otp_snapshot_lock);
+
+    return valid;
+}
+
+/**
+* @brief Serve one identity field from the snapshot.
+*
+* @return ESP_OK if the field is programmed, ESP_FAIL if not (buf is zeroed)
+*/
+static esp_err_t otp_identity_read(otp_field_t field, size_t offset, uint8_t *buf, uint32_t len)
+{
+    otp_identity_t identity;
+    esp_err_t ret;
+
+    ret = otp_get_identity(&identity);
+    if ((ret == ESP_OK) && ((identity.programmed & field) != 0)) {
+        memcpy(buf, (const uint8_t *)&identity + offset, len);
     } else {
-        ret = is_valid_parameter(type_code, cbOTP_SIZE_TYPE_CODE);
+        memset(buf, 0, len);
+        ret = ESP_FAIL;
     }
+
     return ret;
 }
 
@@ -147,6 +147,8 @@ typedef struct xplrMqttWifiFsmUCD_type {
     uint64_t lastMsgTime;                   /**< last time stamp when the client received a message
                                                  from the broker. Needed to implement the watchdog mechanism */
     bool enableWatchdog;                    /**< option to enable the watchdog timer for MQTT message reception */
+    bool credentialsRejected;               /**< the broker refused the client id, its credentials or its certificate,
+                                                 cleared on the next successful connection */
 } xplrMqttWifiFsmUCD_t;
 
 /**
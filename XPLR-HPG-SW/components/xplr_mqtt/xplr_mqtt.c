@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "esp_check.h"
+#include "esp_tls.h"
 #include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
 #include "esp_heap_caps.h"
@@ -152,6 +153,7 @@ esp_err_t xplrMqttWifiInitClient(xplrMqttWifiClient_t *client,
     }
     /*INDENT-OFF*/
     client->ucd.isConnected = false;
+    client->ucd.credentialsRejected = false;
     client->ucd.xRingbuffer = xRingbufferCreate(client->ucd.ringBufferSlotsNumber * sizeof(xplrMqttWifiRingBuffItem_t),
                                                 RINGBUF_TYPE_NOSPLIT);
     if (client->ucd.xRingbuffer == NULL) {
@@ -773,6 +775,7 @@ static esp_err_t xplrMqttWifiEventHandlerCb(esp_mqtt_event_handle_t event)
         case MQTT_EVENT_CONNECTED:
             xplrMqttWifiUpdateNextState(ucd, XPLR_MQTTWIFI_STATE_CONNECTED);
             ucd->isConnected = true;
+            ucd->credentialsRejected = false;
 #if (XPLR_CI_CONSOLE_ACTIVE != 1)
             XPLRMQTTWIFI_CONSOLE(D, "MQTT event connected!");
 #endif
@@ -816,6 +819,19 @@ static esp_err_t xplrMqttWifiEventHandlerCb(esp_mqtt_event_handle_t event)
 #if (XPLR_CI_CONSOLE_ACTIVE != 1)
             XPLRMQTTWIFI_CONSOLE(E, "MQTT event error!");
 #endif
+            /*
+             * CONNECT refused for the client id or its credentials, or failed TLS
+             * handshake: the credentials are not accepted anymore. A broker refusing
+             * as unavailable says nothing about them.
+             */
+            if (((event->error_handle->error_type == MQTT_ERROR_TYPE_CONNECTION_REFUSED) &&
+                 ((event->error_handle->connect_return_code == MQTT_CONNECTION_REFUSE_ID_REJECTED) ||
+                  (event->error_handle->connect_return_code == MQTT_CONNECTION_REFUSE_BAD_USERNAME) ||
+                  (event->error_handle->connect_return_code == MQTT_CONNECTION_REFUSE_NOT_AUTHORIZED))) ||
+                ((event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) &&
+                 (event->error_handle->esp_tls_last_esp_err == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED))) {
+                ucd->credentialsRejected = true;
+            }
             xplrMqttWifiUpdateNextStateToError(ucd);
             break;
 
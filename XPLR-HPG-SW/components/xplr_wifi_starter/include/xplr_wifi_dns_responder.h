@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023 u-blox Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _XPLR_WIFI_DNS_RESPONDER_H_
+#define _XPLR_WIFI_DNS_RESPONDER_H_
+
+/* Only standard headers here: the responder is also built on a host,
+ * see tools/xplr_dns_loopback.c */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Largest DNS message over UDP without EDNS. */
+#define XPLR_WIFI_DNS_MSG_MAX           (512U)
+
+/** Clients tracked for rate limiting, the least recently seen is replaced. */
+#define XPLR_WIFI_DNS_CLIENTS_MAX       (8U)
+
+/** Length of the prebuilt A answer (name pointer, type, class, ttl, rdlength, IPv4). */
+#define XPLR_WIFI_DNS_ANSWER_LEN        (16U)
+
+/** Length of the prebuilt SOA authority record sent with empty answers. */
+#define XPLR_WIFI_DNS_SOA_LEN           (34U)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/**
+ * Responder settings.
+ */
+typedef struct xplrWifiDnsResponderCfg_type {
+    uint32_t    ipAddr;         /**< IPv4 address every A query resolves to, network byte order. */
+    uint32_t    ttlSec;         /**< TTL of the A answer. */
+    uint32_t    negativeTtlSec; /**< Time other query types (AAAA, HTTPS...) are cached as empty. */
+    uint32_t    clientRate;     /**< Queries per second allowed per client, 0 to disable rate limiting. */
+    uint32_t    clientBurst;    /**< Queries a client may send at once before being limited. */
+} xplrWifiDnsResponderCfg_t;
+
+/**
+ * Responder counters.
+ */
+typedef struct xplrWifiDnsResponderStats_type {
+    uint32_t    queries;        /**< Datagrams received. */
+    uint32_t    answered;       /**< Replies with an A answer. */
+    uint32_t    empty;          /**< Replies without answer, for other query types. */
+    uint32_t    errors;         /**< Replies with an error code (FORMERR, NOTIMP, REFUSED). */
+    uint32_t    dropped;        /**< Datagrams ignored, too short or not a query. */
+    uint32_t    limited;        /**< Queries dropped by the rate limit. */
+} xplrWifiDnsResponderStats_t;
+
+/**
+ * Rate limiting state of a client, a token bucket in thousandths of a query.
+ */
+typedef struct xplrWifiDnsClient_type {
+    uint32_t    addr;
+    uint32_t    tokens;
+    uint32_t    lastMs;
+} xplrWifiDnsClient_t;
+
+/**
+ * Responder instance.
+ */
+typedef struct xplrWifiDnsResponder_type {
+    xplrWifiDnsResponderCfg_t   cfg;
+    uint8_t                     answer[XPLR_WIFI_DNS_ANSWER_LEN];
+    uint8_t                     soa[XPLR_WIFI_DNS_SOA_LEN];
+    xplrWifiDnsClient_t         clients[XPLR_WIFI_DNS_CLIENTS_MAX];
+    xplrWifiDnsResponderStats_t stats;
+} xplrWifiDnsResponder_t;
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/**
+ * @brief Prepare a responder and its reply templates.
+ *
+ * @param rsp   responder to initialize.
+ * @param cfg   responder settings, copied.
+ */
+void xplrWifiDnsResponderInit(xplrWifiDnsResponder_t *rsp, const xplrWifiDnsResponderCfg_t *cfg);
+
+/**
+ * @brief Change the address A queries resolve to.
+ *
+ * @param rsp     responder.
+ * @param ipAddr  IPv4 address, network byte order.
+ */
+void xplrWifiDnsResponderSetIp(xplrWifiDnsResponder_t *rsp, uint32_t ipAddr);
+
+/**
+ * @brief Account a query of a client against its rate limit.
+ *
+ * @param rsp         responder.
+ * @param clientAddr  IPv4 address of the client.
+ * @param nowMs       monotonic time in milliseconds.
+ * @return            true when the query should be answered.
+ */
+bool xplrWifiDnsResponderAllow(xplrWifiDnsResponder_t *rsp, uint32_t clientAddr, uint32_t nowMs);
+
+/**
+ * @brief Build the reply to a query.
+ * A and ANY queries of class IN get the configured address, other types
+ * an empty answer with a SOA record so that clients stop waiting for them.
+ * Malformed queries get FORMERR, other opcodes NOTIMP.
+ *
+ * @param rsp       responder.
+ * @param query     received datagram.
+ * @param queryLen  length of the datagram.
+ * @param reply     buffer receiving the reply.
+ * @param replyMax  size of the reply buffer.
+ * @return          length of the reply, 0 when nothing should be sent.
+ */
+size_t xplrWifiDnsResponderBuild(xplrWifiDnsResponder_t *rsp,
+                                 const uint8_t *query,
+                                 size_t queryLen,
+                                 uint8_t *reply,
+                                 size_t replyMax);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XPLR_WIFI_DNS_RESPONDER_H_ */
@@ -101,7 +101,7 @@ typedef enum {
     XPLR_WIFISTARTER_STATE_WIFI_WAIT_CONFIG,      /**< waits for credentials config. */
     XPLR_WIFISTARTER_STATE_CONNECT_WIFI,          /**< connect to Access Point. */
     XPLR_WIFISTARTER_STATE_CONNECT_WAIT,          /**< wait for conenction to AP. */
-    XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT,    /**< schedule reconnect at period. */
+    XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT,    /**< reconnect attempts failed repeatedly, retrying with backoff. */
     XPLR_WIFISTARTER_STATE_STOP_WIFI,             /**< stops/disconnects Wi-Fi. */
     XPLR_WIFISTARTER_STATE_DISCONNECT_OK          /**< successfully disconnected. */
 } xplrWifiStarterFsmStates_t;
@@ -168,6 +168,17 @@ typedef struct xplrWifiStarterOpts_type {
     bool webserver;                  /**< activate webserver. */
 } xplrWifiStarterOpts_t;
 
+/**
+ * Network stored for roaming.
+ * The network of xplrWifiStarterOpts_t (or the one set through the webserver)
+ * is always a candidate too, with priority 0.
+ */
+typedef struct xplrWifiStarterNetwork_type {
+    char    ssid[XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX];         /**< SSID of the network. */
+    char    password[XPLR_WIFISTARTER_NVS_PASSWORD_LENGTH_MAX]; /**< password of the network. */
+    uint8_t priority;                                           /**< higher is preferred over a stronger signal. */
+} xplrWifiStarterNetwork_t;
+
 // *INDENT-OFF*
 /**
  * Wi-Fi SSID scan list.
@@ -177,6 +188,11 @@ typedef struct xplrWifiStarterScanList_type {
     char        name[XPLR_WIFISTARTER_SSID_SCAN_MAX][XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX]; /**< List of SSID names found during scan. */
     uint16_t    found;                                                                      /**< Total number of discovered SSIDs. */
     int8_t      rssi[XPLR_WIFISTARTER_SSID_SCAN_MAX];                                       /**< RSSI list of discovered SSIDs. */
+    uint8_t     bssid[XPLR_WIFISTARTER_SSID_SCAN_MAX][6];                                   /**< BSSID list of discovered SSIDs. */
+    uint8_t     channel[XPLR_WIFISTARTER_SSID_SCAN_MAX];                                    /**< Primary channel list of discovered SSIDs. */
+    uint8_t     authmode[XPLR_WIFISTARTER_SSID_SCAN_MAX];                                   /**< Auth mode (wifi_auth_mode_t) list of discovered SSIDs. */
+    uint32_t    ageMs;                                                                      /**< Time since the scan completed. */
+    bool        scanning;                                                                   /**< A scan is in progress, newer results will follow. */
 } xplrWifiStarterScanList_t;
 // *INDENT-ON*
 
@@ -226,14 +242,63 @@ xplrWifiStarterFsmStates_t xplrWifiStarterGetCurrentFsmState(void);
 xplrWifiStarterFsmStates_t xplrWifiStarterGetPreviousFsmState(void);
 
 /**
- * @brief Scan for available SSIDs.
+ * @brief Get the results of the last SSID scan, without blocking.
+ * Results are cached and shared by all callers. When they are older than
+ * XPLRWIFISTARTER_SCAN_MIN_INTERVAL_MS a new scan is started in the
+ * background, the results of which are returned by the next calls.
  *
  * @param scanInfo scan list of type xplrWifiStarterScanList_t to store scan results.
  *
+ * @return  zero on success, ESP_ERR_NOT_FINISHED when no scan has
+ *          completed yet or negative error code on failure.
+ */
+esp_err_t xplrWifiStarterScanNetwork(xplrWifiStarterScanList_t *scanInfo);
+
+/**
+ * @brief Start an SSID scan in the background.
+ * Does nothing when a scan is running or the cached results are younger
+ * than XPLRWIFISTARTER_SCAN_MIN_INTERVAL_MS, so that repeated requests do
+ * not interrupt the station link.
+ *
  * @return  zero on success or negative error
  *          code on failure.
  */
-esp_err_t xplrWifiStarterScanNetwork(xplrWifiStarterScanList_t *scanInfo);
+esp_err_t xplrWifiStarterScanRequest(void);
+
+/**
+ * @brief Store a network for roaming, or update the one with the same SSID.
+ * On every disconnection the visible network with the highest priority, and
+ * among equal priorities the strongest access point, is selected from the
+ * latest scan results and connected to straight away. Further attempts back off
+ * exponentially, from XPLRWIFISTARTER_BACKOFF_INITIAL_MS up to
+ * XPLRWIFISTARTER_BACKOFF_MAX_MS, with jitter.
+ * Up to XPLRWIFISTARTER_NETWORKS_MAX networks are kept in NVS.
+ *
+ * @param ssid      SSID of the network.
+ * @param password  password of the network.
+ * @param priority  priority of the network, higher is preferred.
+ * @return  XPLR_WIFISTARTER_OK on success or XPLR_WIFISTARTER_ERROR on failure.
+ */
+xplrWifiStarterError_t xplrWifiStarterNetworkAdd(const char *ssid,
+                                                 const char *password,
+                                                 uint8_t priority);
+
+/**
+ * @brief Remove a stored network.
+ *
+ * @param ssid  SSID of the network.
+ * @return  XPLR_WIFISTARTER_OK on success or XPLR_WIFISTARTER_ERROR if not stored.
+ */
+xplrWifiStarterError_t xplrWifiStarterNetworkRemove(const char *ssid);
+
+/**
+ * @brief Copy the stored networks.
+ *
+ * @param list  array receiving the networks.
+ * @param size  number of elements in list.
+ * @return  number of networks copied.
+ */
+uint8_t xplrWifiStarterNetworkGetList(xplrWifiStarterNetwork_t *list, uint8_t size);
 
 /**
  * @brief Triggers software reset.
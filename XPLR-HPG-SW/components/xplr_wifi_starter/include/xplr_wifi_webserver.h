@@ -85,6 +85,24 @@ typedef struct xplrWifiWebServerDataLocation_type {
     int64_t timeUtc;             /**< the UTC time at which the location fix was made. */
 } xplrWifiWebServerDataLocation_t;
 
+/** Telemetry pushed to the "Live tracker" pages that subscribed to it. */
+typedef struct xplrWifiWebServerDataTelemetry_type {
+    int32_t  latitudeX1e7;          /**< latitude in ten millionths of a degree. */
+    int32_t  longitudeX1e7;         /**< longitude in ten millionths of a degree. */
+    int32_t  altitudeMm;            /**< altitude in millimetres. */
+    int32_t  speedMmPerSec;         /**< speed in millimetres per second. */
+    uint32_t accuracy;              /**< horizontal accuracy, in tenths of a millimetre. */
+    int8_t   fixType;               /**< location fix type, same values as diagnostics ready. */
+    int64_t  timeUtc;               /**< UTC time of the fix, in seconds. */
+    int64_t  correctionTime;        /**< esp_timer time (us) the last correction was fed to the GNSS, 0 if none. */
+    uint32_t mqttMsgs;              /**< MQTT messages received. */
+    uint32_t mqttBytes;             /**< MQTT bytes received. */
+    bool     btEnabled;             /**< true if the Bluetooth fields below are valid. */
+    uint8_t  btDevices;             /**< Bluetooth devices connected. */
+    uint32_t btBytesSent;           /**< bytes written to Bluetooth devices. */
+    uint32_t btMsgsDropped;         /**< messages dropped by the Bluetooth stream. */
+} xplrWifiWebServerDataTelemetry_t;
+
 /** Device diagnostics data, used in "home" tab. */
 typedef struct xplrWifiWebServerDataDiagnostics_type {
     int8_t  configured;             /**< tristate thingstream status. -1 not configured, 0 set, 1 connected. */
@@ -158,6 +176,17 @@ esp_err_t xplrWifiWebserverSendLocation(char *jMsg);
  */
 esp_err_t xplrWifiWebserverSendMessage(char *message);
 
+/**
+ * @brief Update the telemetry snapshot.
+ *        The snapshot is encoded once and pushed to every websocket client
+ *        that sent a "dvcTelemetry" request, every XPLRWIFIWEBSERVER_TELEMETRY_PERIOD_MS.
+ *        Clients that do not keep up are disconnected.
+ *
+ * @param telemetryData  telemetry data, copied.
+ * @return             ESP_OK on success, ESP_FAIL on error.
+ */
+esp_err_t xplrWifiWebserverSendTelemetry(const xplrWifiWebServerDataTelemetry_t *telemetryData);
+
 /**
  * @brief Function that initializes logging of the module with user-selected configuration
  *
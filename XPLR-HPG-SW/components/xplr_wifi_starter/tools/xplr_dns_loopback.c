@@ -0,0 +1,305 @@
+/*
+ * Copyright 2023 u-blox Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host harness of the captive portal DNS responder (xplr_wifi_dns_responder.c).
+ *
+ * Build on Linux:
+ *   gcc -O2 -g -fsanitize=address,undefined -I../include \
+ *       xplr_dns_loopback.c ../xplr_wifi_dns_responder.c -o xplr_dns_loopback
+ *
+ * Usage:
+ *   xplr_dns_loopback serve [port] [rate]           answer on 127.0.0.1 (default port 5353),
+ *                                                   rate 0 turns the per client limit off
+ *   xplr_dns_loopback load [port] [queries] [clients]
+ *                                                   flood a server, each client from its own 127.0.0.x
+ *   xplr_dns_loopback fuzz [iterations] [seed]      random and mutated queries, in process
+ *
+ * A served query can be checked with: dig @127.0.0.1 -p 5353 connectivitycheck.gstatic.com AAAA
+ * Built with -DXPLR_DNS_LIBFUZZER and -fsanitize=fuzzer the responder is a libFuzzer target instead.
+ */
+
+#include "xplr_wifi_dns_responder.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOOPBACK_PORT       (5353)
+#define LOOPBACK_AP_IP      "192.168.4.1"
+#define LOOPBACK_RATE       (20U)       /* as XPLRWIFIDNS_CLIENT_RATE */
+#define LOOPBACK_BURST      (40U)       /* as XPLRWIFIDNS_CLIENT_BURST */
+#define LOAD_CLIENTS_MAX    (64)
+
+static const char *loadNames[] = {
+    "connectivitycheck.gstatic.com",
+    "captive.apple.com",
+    "www.msftconnecttest.com",
+    "clients3.google.com",
+    "detectportal.firefox.com"
+};
+static const uint16_t loadTypes[] = {1, 28, 65};    /* A, AAAA, HTTPS */
+
+static volatile sig_atomic_t stop;
+
+static void responderInit(xplrWifiDnsResponder_t *rsp, uint32_t rate)
+{
+    xplrWifiDnsResponderCfg_t cfg = {
+        .ipAddr = inet_addr(LOOPBACK_AP_IP),
+        .ttlSec = 300,
+        .negativeTtlSec = 60,
+        .clientRate = rate,
+        .clientBurst = LOOPBACK_BURST
+    };
+
+    xplrWifiDnsResponderInit(rsp, &cfg);
+}
+
+static uint32_t nowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+
+static size_t queryBuild(uint8_t *buf, uint16_t id, const char *name, uint16_t type)
+{
+    size_t len = 12;
+    const char *label = name;
+    const char *dot;
+    size_t labelLen;
+
+    memset(buf, 0x00, 12);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xFF;
+    buf[2] = 0x01;                      /* RD */
+    buf[5] = 1;                         /* one question */
+    while (*label != 0) {
+        dot = strchr(label, '.');
+        labelLen = (dot != NULL) ? (size_t)(dot - label) : strlen(label);
+        buf[len++] = (uint8_t)labelLen;
+        memcpy(&buf[len], label, labelLen);
+        len += labelLen;
+        label += labelLen + ((dot != NULL) ? 1 : 0);
+    }
+    buf[len++] = 0;
+    buf[len++] = type >> 8;
+    buf[len++] = type & 0xFF;
+    buf[len++] = 0;
+    buf[len++] = 1;                     /* IN */
+
+    return len;
+}
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int serve(int port, uint32_t rate)
+{
+    xplrWifiDnsResponder_t rsp;
+    struct sockaddr_in addr;
+    struct sockaddr_in source;
+    socklen_t sourceLen;
+    uint8_t rx[XPLR_WIFI_DNS_MSG_MAX];
+    uint8_t tx[XPLR_WIFI_DNS_MSG_MAX];
+    size_t replyLen;
+    ssize_t len;
+    struct sigaction action;
+    int sock;
+
+    responderInit(&rsp, rate);
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0x00, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((sock < 0) || (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)) {
+        perror("bind");
+        return 1;
+    }
+
+    /* no SA_RESTART, so that ctrl-c interrupts recvfrom() */
+    memset(&action, 0x00, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, NULL);
+    printf("answering on 127.0.0.1:%d with %s, ctrl-c to stop\n", port, LOOPBACK_AP_IP);
+    while (!stop) {
+        sourceLen = sizeof(source);
+        len = recvfrom(sock, rx, sizeof(rx), 0, (struct sockaddr *)&source, &sourceLen);
+        if (len < 0) {
+            continue;
+        }
+        if (xplrWifiDnsResponderAllow(&rsp, source.sin_addr.s_addr, nowMs())) {
+            replyLen = xplrWifiDnsResponderBuild(&rsp, rx, (size_t)len, tx, sizeof(tx));
+            if (replyLen > 0) {
+                (void)sendto(sock, tx, replyLen, 0, (struct sockaddr *)&source, sourceLen);
+            }
+        }
+    }
+
+    printf("\nqueries:%u answered:%u empty:%u errors:%u dropped:%u limited:%u\n",
+           rsp.stats.queries, rsp.stats.answered, rsp.stats.empty,
+           rsp.stats.errors, rsp.stats.dropped, rsp.stats.limited);
+    close(sock);
+    return 0;
+}
+
+static int load(int port, unsigned queries, int clients)
+{
+    int socks[LOAD_CLIENTS_MAX];
+    struct sockaddr_in server;
+    struct sockaddr_in local;
+    struct timeval timeout = {0, 200000};
+    uint8_t buf[XPLR_WIFI_DNS_MSG_MAX];
+    unsigned replies = 0;
+    uint32_t start;
+    uint32_t elapsed;
+    size_t len;
+
+    memset(&server, 0x00, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int i = 0; i < clients; i++) {
+        /* the rate limit is per address: every client gets its own loopback address */
+        socks[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&local, 0x00, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + i);
+        if ((socks[i] < 0) || (bind(socks[i], (struct sockaddr *)&local, sizeof(local)) < 0)) {
+            perror("client bind");
+            return 1;
+        }
+        setsockopt(socks[i], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    start = nowMs();
+    for (unsigned q = 0; q < queries; q++) {
+        int sock = socks[q % clients];
+        len = queryBuild(buf, (uint16_t)q,
+                         loadNames[q % (sizeof(loadNames) / sizeof(loadNames[0]))],
+                         loadTypes[q % (sizeof(loadTypes) / sizeof(loadTypes[0]))]);
+        (void)sendto(sock, buf, len, 0, (struct sockaddr *)&server, sizeof(server));
+        if (recv(sock, buf, sizeof(buf), 0) > 0) {
+            replies++;
+        }
+    }
+    elapsed = nowMs() - start;
+
+    printf("%u queries from %d clients, %u replies in %u ms (%.0f queries/s)\n",
+           queries, clients, replies, elapsed, (elapsed > 0) ? (queries * 1000.0 / elapsed) : 0.0);
+    for (int i = 0; i < clients; i++) {
+        close(socks[i]);
+    }
+    return 0;
+}
+
+/* Checks that must hold for any input. */
+static void fuzzOne(xplrWifiDnsResponder_t *rsp, const uint8_t *query, size_t len)
+{
+    uint8_t reply[XPLR_WIFI_DNS_MSG_MAX];
+    size_t replyLen;
+
+    replyLen = xplrWifiDnsResponderBuild(rsp, query, len, reply, sizeof(reply));
+    if ((replyLen > sizeof(reply)) ||
+        ((replyLen > 0) && ((replyLen < 12) || ((reply[2] & 0x80) == 0) || (memcmp(reply, query, 2) != 0)))) {
+        fprintf(stderr, "bad reply of %zu bytes to a %zu bytes query\n", replyLen, len);
+        abort();
+    }
+}
+
+#ifdef XPLR_DNS_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static xplrWifiDnsResponder_t rsp;
+
+    responderInit(&rsp, 0);
+    fuzzOne(&rsp, data, size);
+    return 0;
+}
+
+#else
+
+static int fuzz(unsigned iterations, unsigned seed)
+{
+    xplrWifiDnsResponder_t rsp;
+    uint8_t query[XPLR_WIFI_DNS_MSG_MAX];
+    size_t len;
+
+    responderInit(&rsp, 0);
+    srand(seed);
+    for (unsigned i = 0; i < iterations; i++) {
+        if ((i % 2) == 0) {
+            /* valid query with a few flipped bytes */
+            len = queryBuild(query, (uint16_t)rand(), loadNames[rand() % 5], (uint16_t)rand());
+            for (int flips = rand() % 4; flips > 0; flips--) {
+                query[rand() % len] = (uint8_t)rand();
+            }
+            len = (rand() % 8 == 0) ? (size_t)(rand() % (len + 1)) : len;
+        } else {
+            len = rand() % sizeof(query);
+            for (size_t j = 0; j < len; j++) {
+                query[j] = (uint8_t)rand();
+            }
+        }
+        fuzzOne(&rsp, query, len);
+    }
+
+    printf("%u inputs, answered:%u empty:%u errors:%u dropped:%u\n",
+           iterations, rsp.stats.answered, rsp.stats.empty, rsp.stats.errors, rsp.stats.dropped);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = (argc > 1) ? argv[1] : "";
+    int ret;
+
+    if (strcmp(mode, "serve") == 0) {
+        ret = serve((argc > 2) ? atoi(argv[2]) : LOOPBACK_PORT,
+                    (argc > 3) ? (uint32_t)atoi(argv[3]) : LOOPBACK_RATE);
+    } else if (strcmp(mode, "load") == 0) {
+        int clients = (argc > 4) ? atoi(argv[4]) : 1;
+        clients = (clients < 1) ? 1 : ((clients > LOAD_CLIENTS_MAX) ? LOAD_CLIENTS_MAX : clients);
+        ret = load((argc > 2) ? atoi(argv[2]) : LOOPBACK_PORT,
+                   (argc > 3) ? (unsigned)atoi(argv[3]) : 1000,
+                   clients);
+    } else if (strcmp(mode, "fuzz") == 0) {
+        ret = fuzz((argc > 2) ? (unsigned)atoi(argv[2]) : 1000000,
+                   (argc > 3) ? (unsigned)atoi(argv[3]) : (unsigned)time(NULL));
+    } else {
+        fprintf(stderr, "usage: %s serve [port] [rate] | load [port] [queries] [clients] | fuzz [iterations] [seed]\n",
+                argv[0]);
+        ret = 2;
+    }
+
+    return ret;
+}
+
+#endif
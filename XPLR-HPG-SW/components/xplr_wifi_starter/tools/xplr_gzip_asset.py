@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+#
+# Copyright 2023 u-blox Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Compress a captive portal asset so it can be embedded and served with
+Content-Encoding: gzip by the xplr_wifi_webserver.
+
+The output is reproducible (no file name or timestamp in the gzip header) so
+that an unchanged asset always produces the same binary and ETag.
+"""
+
+import argparse
+import gzip
+import os
+import re
+
+SOURCE_MAP_RE = re.compile(rb"\n?(//|/\*)# sourceMappingURL=[^\s*]+(\s*\*/)?\s*$")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("src", help="asset to compress")
+    parser.add_argument("dst", help="compressed output file")
+    parser.add_argument("--strip-source-map", action="store_true",
+                        help="remove the trailing sourceMappingURL comment")
+    args = parser.parse_args()
+
+    with open(args.src, "rb") as src:
+        data = src.read()
+
+    if args.strip_source_map:
+        data = SOURCE_MAP_RE.sub(b"\n", data)
+
+    out_dir = os.path.dirname(args.dst)
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+
+    with open(args.dst, "wb") as raw:
+        with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=raw, mtime=0) as dst:
+            dst.write(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -17,6 +17,7 @@
 #if (XPLR_CFG_ENABLE_WEBSERVERDNS == 1)
 
 #include "xplr_wifi_dns.h"
+#include "xplr_wifi_dns_responder.h"
 #include <sys/param.h>
 #include "esp_system.h"
 #include "nvs_flash.h"
@@ -31,13 +32,13 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#define DNS_PORT        (53)
-#define DNS_MAX_LEN     (256)
+#define DNS_PORT                (53)
 
-#define OPCODE_MASK     (0x7800)
-#define QR_FLAG         (1 << 7)
-#define QD_TYPE_A       (0x0001)
-#define ANS_TTL_SEC     (300)
+#define ANS_TTL_SEC             (300)
+#define ANS_NEGATIVE_TTL_SEC    (60)       /* caching of the empty AAAA/HTTPS answers */
+#define DNS_STATS_PERIOD_MS     (60000)
+#define DNS_RX_RETRY_MS         (10)       /* pause after a receive error, e.g. out of buffers */
+#define DNS_RX_TIMEOUT_MS       (500)      /* longest wait of the server for a stop request */
 
 #if (1 == XPLRWIFIDNS_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
 #define XPLRWIFIDNS_CONSOLE(tag, message, ...)   esp_rom_printf(XPLR_HPGLIB_LOG_FORMAT(tag, message), esp_log_timestamp(), "xplrWifiDns", __FUNCTION__, __LINE__, ##__VA_ARGS__)
@@ -45,46 +46,16 @@
 #define XPLRWIFIDNS_CONSOLE(message, ...) do{} while(0)
 #endif
 
-/* ----------------------------------------------------------------
- * STATIC TYPES
- * -------------------------------------------------------------- */
-
-// DNS Header Packet
-typedef struct __attribute__((__packed__))
-{
-    uint16_t id;
-    uint16_t flags;
-    uint16_t qd_count;
-    uint16_t an_count;
-    uint16_t ns_count;
-    uint16_t ar_count;
-}
-dns_header_t;
-
-// DNS Question Packet
-typedef struct {
-    uint16_t type;
-    uint16_t class;
-} dns_question_t;
-
-// DNS Answer Packet
-typedef struct __attribute__((__packed__))
-{
-    uint16_t ptr_offset;
-    uint16_t type;
-    uint16_t class;
-    uint32_t ttl;
-    uint16_t addr_len;
-    uint32_t ip_addr;
-}
-dns_answer_t;
-
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
-TaskHandle_t dnsTask;
-int sock;
+static TaskHandle_t dnsTask;
+static int sock = -1;
+static volatile bool dnsRunning;
+static xplrWifiDnsResponder_t dnsResponder;
+static uint8_t dnsRxBuffer[XPLR_WIFI_DNS_MSG_MAX];
+static uint8_t dnsTxBuffer[XPLR_WIFI_DNS_MSG_MAX];
 char hostnameConfigured[32 + 1];
 
 /* ----------------------------------------------------------------
@@ -93,9 +64,8 @@ char hostnameConfigured[32 + 1];
 
 /* Used when in AP mode */
 
-static char *parse_dns_name(char *raw_name, char *parsed_name, size_t parsed_name_max_len);
-static int parse_dns_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len);
-void xDns_server(void *pvParameters);
+static uint32_t dnsApIp(void);
+static void xDns_server(void *pvParameters);
 
 /* Used when in STA mode */
 
@@ -107,15 +77,23 @@ static char *mDnsGenerateHostname(void);
  * -------------------------------------------------------------- */
 void xplrWifiDnsStart(void)
 {
-    xTaskCreate(xDns_server, "xplrDnsServer", 4096, NULL, 5, dnsTask);
+    if (dnsTask == NULL) {
+        dnsRunning = true;
+        xTaskCreate(xDns_server, "xplrDnsServer", 4096, NULL, 5, &dnsTask);
+    }
 }
 
 void xplrWifiDnsStop(void)
 {
-    XPLRWIFIDNS_CONSOLE(E, "Shutting down socket");
-    shutdown(sock, 0);
-    close(sock);
-    vTaskDelete(dnsTask);
+    if (dnsTask != NULL) {
+        XPLRWIFIDNS_CONSOLE(D, "Shutting down socket");
+        /**
+         * The task owns the socket and closes it on its way out, once
+         * recvfrom() returns or times out, then deletes itself.
+         */
+        dnsRunning = false;
+        shutdown(sock, SHUT_RD);
+    }
 }
 
 char *xplrWifiStaDnsStart(void)
@@ -144,180 +122,116 @@ void xplrWifiStaDnsStop(void)
  * STATIC FUNCTION DESCRIPTORS
  * -------------------------------------------------------------- */
 
-static char *parse_dns_name(char *raw_name, char *parsed_name, size_t parsed_name_max_len)
+static uint32_t dnsApIp(void)
 {
-    char *label = raw_name;
-    char *name_itr = parsed_name;
-    int name_len = 0;
-
-    do {
-        int sub_name_len = *label;
-        // (len + 1) since we are adding  a '.'
-        name_len += (sub_name_len + 1);
-        if (name_len > parsed_name_max_len) {
-            return NULL;
-        }
-
-        // Copy the sub name that follows the the label
-        memcpy(name_itr, label + 1, sub_name_len);
-        name_itr[sub_name_len] = '.';
-        name_itr += (sub_name_len + 1);
-        label += sub_name_len + 1;
-    } while (*label != 0);
-
-    // Terminate the final string, replacing the last '.'
-    parsed_name[name_len - 1] = '\0';
-    // Return pointer to first char after the name
-    return label + 1;
-}
-
-static int parse_dns_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len)
-{
-    if (req_len > dns_reply_max_len) {
-        return -1;
-    }
-
-    // Prepare the reply
-    memset(dns_reply, 0, dns_reply_max_len);
-    memcpy(dns_reply, req, req_len);
-
-    // Endianess of NW packet different from chip
-    dns_header_t *header = (dns_header_t *)dns_reply;
-    XPLRWIFIDNS_CONSOLE(D, "DNS query with header id: 0x%X, flags: 0x%X, qd_count: %d",
-                        ntohs(header->id), ntohs(header->flags), ntohs(header->qd_count));
-
-    // Not a standard query
-    if ((header->flags & OPCODE_MASK) != 0) {
-        return 0;
-    }
-
-    // Set question response flag
-    header->flags |= QR_FLAG;
-
-    uint16_t qd_count = ntohs(header->qd_count);
-    header->an_count = htons(qd_count);
+    esp_netif_ip_info_t ipInfo;
+    uint32_t ret;
 
-    int reply_len = qd_count * sizeof(dns_answer_t) + req_len;
-    if (reply_len > dns_reply_max_len) {
-        return -1;
+    if (esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_AP_DEF"), &ipInfo) == ESP_OK) {
+        ret = ipInfo.ip.addr;
+    } else {
+        ret = 0;
     }
 
-    // Pointer to current answer and question
-    char *cur_ans_ptr = dns_reply + req_len;
-    char *cur_qd_ptr = dns_reply + sizeof(dns_header_t);
-    char name[128];
-
-    // Respond to all questions with the ESP32's IP address
-    for (int i = 0; i < qd_count; i++) {
-        char *name_end_ptr = parse_dns_name(cur_qd_ptr, name, sizeof(name));
-        if (name_end_ptr == NULL) {
-            XPLRWIFIDNS_CONSOLE(E, "Failed to parse DNS question: %s", cur_qd_ptr);
-            return -1;
-        }
-
-        dns_question_t *question = (dns_question_t *)(name_end_ptr);
-        uint16_t qd_type = ntohs(question->type);
-        uint16_t qd_class = ntohs(question->class);
-
-        XPLRWIFIDNS_CONSOLE(D, "Received type: %d | Class: %d | Question for: %s", qd_type, qd_class, name);
-
-        if (qd_type == QD_TYPE_A) {
-            dns_answer_t *answer = (dns_answer_t *)cur_ans_ptr;
-
-            answer->ptr_offset = htons(0xC000 | (cur_qd_ptr - dns_reply));
-            answer->type = htons(qd_type);
-            answer->class = htons(qd_class);
-            answer->ttl = htonl(ANS_TTL_SEC);
-
-            esp_netif_ip_info_t ip_info;
-            esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_AP_DEF"), &ip_info);
-            XPLRWIFIDNS_CONSOLE(D, "Answer with PTR offset: 0x%X and IP 0x%X", ntohs(answer->ptr_offset),
-                                ip_info.ip.addr);
-
-            answer->addr_len = htons(sizeof(ip_info.ip.addr));
-            answer->ip_addr = ip_info.ip.addr;
-        }
-    }
-    return reply_len;
+    return ret;
 }
 
-void xDns_server(void *pvParameters)
+static void xDns_server(void *pvParameters)
 {
-    char rx_buffer[128];
-    char addr_str[128];
-    int addr_family;
-    int ip_protocol;
-
-    while (1) {
-
-        struct sockaddr_in dest_addr;
-        dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(DNS_PORT);
-        addr_family = AF_INET;
-        ip_protocol = IPPROTO_IP;
-        inet_ntoa_r(dest_addr.sin_addr, addr_str, sizeof(addr_str) - 1);
-
-        sock = socket(addr_family, SOCK_DGRAM, ip_protocol);
-        if (sock < 0) {
-            XPLRWIFIDNS_CONSOLE(E, "Unable to create socket: errno %d", errno);
-            break;
-        }
-        XPLRWIFIDNS_CONSOLE(D, "Socket created");
-
-        int err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    xplrWifiDnsResponderCfg_t cfg = {
+        .ipAddr = dnsApIp(),
+        .ttlSec = ANS_TTL_SEC,
+        .negativeTtlSec = ANS_NEGATIVE_TTL_SEC,
+        .clientRate = XPLRWIFIDNS_CLIENT_RATE,
+        .clientBurst = XPLRWIFIDNS_CLIENT_BURST
+    };
+    xplrWifiDnsResponderStats_t *stats = &dnsResponder.stats;
+    struct timeval rxTimeout = {
+        .tv_sec = 0,
+        .tv_usec = DNS_RX_TIMEOUT_MS * 1000
+    };
+    struct sockaddr_in dest_addr;
+    struct sockaddr_in source_addr;
+    socklen_t socklen;
+    uint32_t sendErrors = 0;
+    uint32_t nowMs;
+    uint32_t statsMs = 0;
+    size_t replyLen;
+    int len;
+    int err;
+
+    xplrWifiDnsResponderInit(&dnsResponder, &cfg);
+
+    memset(&dest_addr, 0x00, sizeof(dest_addr));
+    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(DNS_PORT);
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        XPLRWIFIDNS_CONSOLE(E, "Unable to create socket: errno %d", errno);
+        dnsRunning = false;
+    } else {
+        err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
         if (err < 0) {
             XPLRWIFIDNS_CONSOLE(E, "Socket unable to bind: errno %d", errno);
+            dnsRunning = false;
+        } else {
+            XPLRWIFIDNS_CONSOLE(D, "Socket bound, port %d", DNS_PORT);
+            /* shutdown() does not wake a UDP recvfrom() in lwIP, a stop is seen at the timeout */
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &rxTimeout, sizeof(rxTimeout));
         }
-        XPLRWIFIDNS_CONSOLE(D, "Socket bound, port %d", DNS_PORT);
-
-        while (1) {
-            XPLRWIFIDNS_CONSOLE(D, "Waiting for data");
-            struct sockaddr_in source_addr;
-            socklen_t socklen = sizeof(source_addr);
-            int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&source_addr,
-                               &socklen);
-
-            // Error occurred during receiving
-            if (len < 0) {
-                XPLRWIFIDNS_CONSOLE(E, "recvfrom failed: errno %d", errno);
-                close(sock);
+    }
+
+    /* one socket for the lifetime of the server, a failed datagram is not a reason to recreate it */
+    while (dnsRunning) {
+        socklen = sizeof(source_addr);
+        len = recvfrom(sock, dnsRxBuffer, sizeof(dnsRxBuffer), 0, (struct sockaddr *)&source_addr, &socklen);
+        if (len < 0) {
+            if (dnsRunning && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+                // do nothing, receive timeout
+            } else if (dnsRunning && (errno != EBADF)) {
+                XPLRWIFIDNS_CONSOLE(W, "recvfrom failed: errno %d", errno);
+                vTaskDelay(pdMS_TO_TICKS(DNS_RX_RETRY_MS));
+            } else {
                 break;
             }
-            // Data received
-            else {
-                // Get the sender's ip address as string
-                if (source_addr.sin_family == AF_INET) {
-                    inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr.s_addr, addr_str, sizeof(addr_str) - 1);
+        } else {
+            nowMs = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+            if (xplrWifiDnsResponderAllow(&dnsResponder, source_addr.sin_addr.s_addr, nowMs)) {
+                if (dnsResponder.cfg.ipAddr == 0) {
+                    /* server started before the AP got its address */
+                    xplrWifiDnsResponderSetIp(&dnsResponder, dnsApIp());
                 }
-
-                // Null-terminate whatever we received and treat like a string...
-                rx_buffer[len] = 0;
-
-                char reply[DNS_MAX_LEN];
-                int reply_len = parse_dns_request(rx_buffer, len, reply, DNS_MAX_LEN);
-
-                XPLRWIFIDNS_CONSOLE(D, "Received %d bytes from %s | DNS reply with len: %d", len, addr_str,
-                                    reply_len);
-                if (reply_len <= 0) {
-                    XPLRWIFIDNS_CONSOLE(E, "Failed to prepare a DNS reply");
-                } else {
-                    int err = sendto(sock, reply, reply_len, 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
-                    if (err < 0) {
-                        XPLRWIFIDNS_CONSOLE(E, "Error occurred during sending: errno %d", errno);
-                        break;
-                    }
+                replyLen = xplrWifiDnsResponderBuild(&dnsResponder,
+                                                     dnsRxBuffer,
+                                                     len,
+                                                     dnsTxBuffer,
+                                                     sizeof(dnsTxBuffer));
+                if ((replyLen > 0) &&
+                    (sendto(sock, dnsTxBuffer, replyLen, 0, (struct sockaddr *)&source_addr, socklen) < 0)) {
+                    sendErrors++;
                 }
             }
-        }
 
-        if (sock != -1) {
-            XPLRWIFIDNS_CONSOLE(E, "Shutting down socket");
-            shutdown(sock, 0);
-            close(sock);
+            /* no per packet logging, phones send dozens of queries per second */
+            if ((nowMs - statsMs) >= DNS_STATS_PERIOD_MS) {
+                XPLRWIFIDNS_CONSOLE(D,
+                                    "queries:%u answered:%u empty:%u errors:%u dropped:%u limited:%u send errors:%u",
+                                    stats->queries, stats->answered, stats->empty, stats->errors,
+                                    stats->dropped, stats->limited, sendErrors);
+                statsMs = nowMs;
+            }
         }
     }
-    vTaskDelete(dnsTask);
+
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    XPLRWIFIDNS_CONSOLE(D, "DNS server stopped");
+    dnsTask = NULL;
+    vTaskDelete(NULL);
 }
 
 static void mDnsInit(void)
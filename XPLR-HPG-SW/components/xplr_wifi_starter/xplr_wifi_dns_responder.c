@@ -0,0 +1,277 @@
+/*
+ * Copyright 2023 u-blox Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xplr_wifi_dns_responder.h"
+#include <string.h>
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#define DNS_HEADER_LEN      (12U)
+#define DNS_NAME_MAX        (255U)
+#define DNS_LABEL_MAX       (63U)
+#define DNS_NAME_PTR        (0xC00CU)    /* compression pointer to the question name */
+
+#define DNS_FLAG_QR         (0x80U)      /* first flags byte */
+#define DNS_FLAG_OPCODE     (0x78U)
+#define DNS_FLAG_AA         (0x04U)
+#define DNS_FLAG_RD         (0x01U)
+#define DNS_FLAG_RA         (0x80U)      /* second flags byte */
+
+#define DNS_RCODE_NOERROR   (0U)
+#define DNS_RCODE_FORMERR   (1U)
+#define DNS_RCODE_NOTIMP    (4U)
+#define DNS_RCODE_REFUSED   (5U)
+
+#define DNS_TYPE_A          (1U)
+#define DNS_TYPE_SOA        (6U)
+#define DNS_TYPE_ANY        (255U)
+#define DNS_CLASS_IN        (1U)
+#define DNS_CLASS_ANY       (255U)
+
+#define DNS_TOKEN           (1000U)      /* bucket units per query */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION PROTOTYPES
+ * -------------------------------------------------------------- */
+
+static uint16_t dnsGet16(const uint8_t *buf);
+static void dnsPut16(uint8_t *buf, uint16_t value);
+static void dnsPut32(uint8_t *buf, uint32_t value);
+static size_t dnsQuestionEnd(const uint8_t *query, size_t queryLen);
+static size_t dnsReplyError(xplrWifiDnsResponder_t *rsp,
+                            const uint8_t *query,
+                            uint8_t *reply,
+                            uint8_t rcode);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+void xplrWifiDnsResponderInit(xplrWifiDnsResponder_t *rsp, const xplrWifiDnsResponderCfg_t *cfg)
+{
+    uint8_t *soa = rsp->soa;
+
+    memset(rsp, 0x00, sizeof(xplrWifiDnsResponder_t));
+    rsp->cfg = *cfg;
+
+    /* A answer, the address is filled by xplrWifiDnsResponderSetIp() */
+    dnsPut16(&rsp->answer[0], DNS_NAME_PTR);
+    dnsPut16(&rsp->answer[2], DNS_TYPE_A);
+    dnsPut16(&rsp->answer[4], DNS_CLASS_IN);
+    dnsPut32(&rsp->answer[6], cfg->ttlSec);
+    dnsPut16(&rsp->answer[10], 4);
+    xplrWifiDnsResponderSetIp(rsp, cfg->ipAddr);
+
+    /* SOA of the root, its minimum field sets how long an empty answer is cached */
+    dnsPut16(&soa[0], DNS_NAME_PTR);
+    dnsPut16(&soa[2], DNS_TYPE_SOA);
+    dnsPut16(&soa[4], DNS_CLASS_IN);
+    dnsPut32(&soa[6], cfg->negativeTtlSec);
+    dnsPut16(&soa[10], XPLR_WIFI_DNS_SOA_LEN - 12);
+    soa[12] = 0;                            /* mname */
+    soa[13] = 0;                            /* rname */
+    dnsPut32(&soa[14], 1);                  /* serial */
+    dnsPut32(&soa[18], 3600);               /* refresh */
+    dnsPut32(&soa[22], 600);                /* retry */
+    dnsPut32(&soa[26], 86400);              /* expire */
+    dnsPut32(&soa[30], cfg->negativeTtlSec);
+}
+
+void xplrWifiDnsResponderSetIp(xplrWifiDnsResponder_t *rsp, uint32_t ipAddr)
+{
+    rsp->cfg.ipAddr = ipAddr;
+    /* already in network byte order */
+    memcpy(&rsp->answer[12], &ipAddr, sizeof(ipAddr));
+}
+
+bool xplrWifiDnsResponderAllow(xplrWifiDnsResponder_t *rsp, uint32_t clientAddr, uint32_t nowMs)
+{
+    xplrWifiDnsClient_t *client = NULL;
+    xplrWifiDnsClient_t *oldest = &rsp->clients[0];
+    uint32_t capacity = rsp->cfg.clientBurst * DNS_TOKEN;
+    uint64_t tokens;
+    bool ret;
+
+    if (rsp->cfg.clientRate == 0) {
+        ret = true;
+    } else {
+        for (size_t i = 0; (i < XPLR_WIFI_DNS_CLIENTS_MAX) && (client == NULL); i++) {
+            if ((rsp->clients[i].lastMs != 0) && (rsp->clients[i].addr == clientAddr)) {
+                client = &rsp->clients[i];
+            } else if ((oldest->lastMs != 0) &&
+                       ((rsp->clients[i].lastMs == 0) ||
+                        ((uint32_t)(nowMs - rsp->clients[i].lastMs) > (uint32_t)(nowMs - oldest->lastMs)))) {
+                /* unused entries first, then the least recently seen */
+                oldest = &rsp->clients[i];
+            } else {
+                // do nothing
+            }
+        }
+
+        if (client == NULL) {
+            /* new client, or one forgotten since: starts with a full bucket */
+            client = oldest;
+            client->addr = clientAddr;
+            client->tokens = capacity;
+        } else {
+            tokens = client->tokens + ((uint64_t)(nowMs - client->lastMs) * rsp->cfg.clientRate);
+            client->tokens = (tokens > capacity) ? capacity : (uint32_t)tokens;
+        }
+        /* never 0, so that the entry counts as used */
+        client->lastMs = (nowMs != 0) ? nowMs : 1;
+
+        if (client->tokens >= DNS_TOKEN) {
+            client->tokens -= DNS_TOKEN;
+            ret = true;
+        } else {
+            rsp->stats.limited++;
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+size_t xplrWifiDnsResponderBuild(xplrWifiDnsResponder_t *rsp,
+                                 const uint8_t *query,
+                                 size_t queryLen,
+                                 uint8_t *reply,
+                                 size_t replyMax)
+{
+    size_t questionEnd;
+    uint16_t type;
+    uint16_t class;
+    size_t ret;
+
+    rsp->stats.queries++;
+
+    if ((queryLen < DNS_HEADER_LEN) || (replyMax < DNS_HEADER_LEN) || ((query[2] & DNS_FLAG_QR) != 0)) {
+        /* too short, or a response: never answer it, it could loop */
+        rsp->stats.dropped++;
+        ret = 0;
+    } else if ((query[2] & DNS_FLAG_OPCODE) != 0) {
+        ret = dnsReplyError(rsp, query, reply, DNS_RCODE_NOTIMP);
+    } else if (dnsGet16(&query[4]) != 1) {
+        /* no resolver sends more than one question */
+        ret = dnsReplyError(rsp, query, reply, DNS_RCODE_FORMERR);
+    } else {
+        questionEnd = dnsQuestionEnd(query, queryLen);
+        if (questionEnd == 0) {
+            ret = dnsReplyError(rsp, query, reply, DNS_RCODE_FORMERR);
+        } else if ((questionEnd + XPLR_WIFI_DNS_SOA_LEN) > replyMax) {
+            rsp->stats.dropped++;
+            ret = 0;
+        } else {
+            type = dnsGet16(&query[questionEnd - 4]);
+            class = dnsGet16(&query[questionEnd - 2]);
+
+            /* header and question are echoed, additional records (EDNS) are dropped */
+            memcpy(reply, query, questionEnd);
+            reply[2] = DNS_FLAG_QR | DNS_FLAG_AA | (query[2] & DNS_FLAG_RD);
+            reply[3] = DNS_FLAG_RA | DNS_RCODE_NOERROR;
+            memset(&reply[6], 0x00, 6);
+            ret = questionEnd;
+
+            if ((class != DNS_CLASS_IN) && (class != DNS_CLASS_ANY)) {
+                reply[3] = DNS_FLAG_RA | DNS_RCODE_REFUSED;
+                rsp->stats.errors++;
+            } else if ((type == DNS_TYPE_A) || (type == DNS_TYPE_ANY)) {
+                memcpy(&reply[ret], rsp->answer, XPLR_WIFI_DNS_ANSWER_LEN);
+                dnsPut16(&reply[6], 1);
+                ret += XPLR_WIFI_DNS_ANSWER_LEN;
+                rsp->stats.answered++;
+            } else {
+                /* AAAA, HTTPS, SVCB...: the name exists without such records */
+                memcpy(&reply[ret], rsp->soa, XPLR_WIFI_DNS_SOA_LEN);
+                dnsPut16(&reply[8], 1);
+                ret += XPLR_WIFI_DNS_SOA_LEN;
+                rsp->stats.empty++;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTION DESCRIPTORS
+ * -------------------------------------------------------------- */
+
+static uint16_t dnsGet16(const uint8_t *buf)
+{
+    return (uint16_t)((buf[0] << 8) | buf[1]);
+}
+
+static void dnsPut16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)(value >> 8);
+    buf[1] = (uint8_t)value;
+}
+
+static void dnsPut32(uint8_t *buf, uint32_t value)
+{
+    dnsPut16(&buf[0], (uint16_t)(value >> 16));
+    dnsPut16(&buf[2], (uint16_t)value);
+}
+
+/**
+ * Offset following the type and class of the question, 0 if it is malformed.
+ * Compression pointers are not expected in a question and are rejected.
+ */
+static size_t dnsQuestionEnd(const uint8_t *query, size_t queryLen)
+{
+    size_t offset = DNS_HEADER_LEN;
+    size_t nameLen = 0;
+    size_t ret = 0;
+    uint8_t label;
+
+    while (offset < queryLen) {
+        label = query[offset];
+        if (label == 0) {
+            offset++;
+            if ((offset + 4) <= queryLen) {
+                ret = offset + 4;
+            }
+            break;
+        } else if (label > DNS_LABEL_MAX) {
+            break;
+        } else {
+            nameLen += label + 1;
+            if (nameLen > DNS_NAME_MAX) {
+                break;
+            }
+            offset += label + 1;
+        }
+    }
+
+    return ret;
+}
+
+static size_t dnsReplyError(xplrWifiDnsResponder_t *rsp,
+                            const uint8_t *query,
+                            uint8_t *reply,
+                            uint8_t rcode)
+{
+    memcpy(reply, query, 2);
+    reply[2] = DNS_FLAG_QR | (query[2] & (DNS_FLAG_OPCODE | DNS_FLAG_RD));
+    reply[3] = DNS_FLAG_RA | rcode;
+    memset(&reply[4], 0x00, DNS_HEADER_LEN - 4);
+    rsp->stats.errors++;
+
+    return DNS_HEADER_LEN;
+}
@@ -24,10 +24,13 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_mac.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "lwip/sockets.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/timer.h"
 #include "./../../../components/hpglib/src/common/xplr_common.h"
 #if defined(XPLR_BOARD_SELECTED_IS_C214)
@@ -67,14 +70,42 @@
 #define XPLR_WIFI_NVS_NAMESPACE_LENGTH_MAX    16
 
 /**
- * Max retries after a waiting period of RETRY_PERIOD_SECS
+ * Reconnect attempts before reporting XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT.
+ * Quick handovers between access points stay in XPLR_WIFISTARTER_STATE_CONNECT_WAIT.
  */
-#define MAX_RETRIES   10
+#define XPLR_WIFI_RETRIES_BEFORE_SCHEDULE   5
 
 /**
- * Retry period to wait before retrying to connect MAX_RETRIES times
+ * Random share (percent) added to or removed from a reconnect backoff delay
  */
-#define RETRY_PERIOD_SECS 10
+#define XPLR_WIFI_BACKOFF_JITTER_PCT        25
+
+/**
+ * Failed attempts on a network before the next candidate is tried
+ */
+#define XPLR_WIFI_NETWORK_FAILS_MAX         2
+
+/**
+ * Age after which scan results are refreshed before choosing a network
+ */
+#define XPLR_WIFI_SCAN_CACHE_MAX_AGE_MS     10000
+
+/**
+ * Weakest access point considered when choosing a network
+ */
+#define XPLR_WIFI_ROAM_RSSI_MIN             (-85)
+
+/**
+ * Active scan time per channel, short to keep the station link up while scanning
+ */
+#define XPLR_WIFI_SCAN_DWELL_MIN_MS         0
+#define XPLR_WIFI_SCAN_DWELL_MAX_MS         80
+
+/**
+ * NVS namespace and key of the stored networks
+ */
+#define XPLR_WIFI_NVS_NETWORKS_NAMESPACE    "xplrWifiNets"
+#define XPLR_WIFI_NVS_NETWORKS_KEY          "networks"
 
 /**
  * User notification period for displaying STA info when connected.
@@ -91,10 +122,17 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Events posted by the module to its own handler. */
+enum {
+    XPLR_WIFISTARTER_EVENT_RECONNECT = 0  /**< reconnect backoff elapsed. */
+};
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+ESP_EVENT_DEFINE_BASE(XPLR_WIFISTARTER_EVENT);
+
 /* Wi-Fi related variables */
 
 const char *nvsNamespace = "xplrWifiCfg";
@@ -105,7 +143,7 @@ static xplrWifiStarterFsmStates_t wifiFsm[2] = {
 };
 static esp_event_handler_instance_t instanceAnyId;
 static esp_event_handler_instance_t instanceGotIp;
-static int sRetryNum = 0;
+static esp_event_handler_instance_t instanceReconnect;
 static uint64_t lastActionTime;
 static uint64_t connectedStateTime;
 
@@ -119,6 +157,32 @@ bool diagnosticsInfoUpdated;
 
 static xplrWifiStarterOpts_t userOptions;
 
+/* roaming related variables */
+
+static xplrWifiStarterNetwork_t primaryNetwork;                                 /* configured network, priority 0 */
+static xplrWifiStarterNetwork_t storedNetworks[XPLRWIFISTARTER_NETWORKS_MAX];
+static uint8_t storedNetworksCount;
+static bool storedNetworksLoaded;
+static xplrNvs_t storedNetworksNvs;
+static uint8_t roamFails[XPLRWIFISTARTER_NETWORKS_MAX + 1];                     /* [0] primary, then stored */
+static int8_t roamIndex = -1;                                                   /* candidate of the current attempt */
+static portMUX_TYPE roamLock = portMUX_INITIALIZER_UNLOCKED;                     /* stored networks, roamFails and roamIndex,
+                                                                                   changed by the app and read by the event task */
+static bool roamUsedCache;                                                      /* current attempt targets a scanned AP */
+static bool roamScanPending;
+static uint32_t roamAttempts;
+static char roamSsid[XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX];
+static esp_timer_handle_t roamTimer;
+
+/* scan related variables, the cache is written by the event handler */
+
+static wifi_ap_record_t scanCache[XPLR_WIFISTARTER_SSID_SCAN_MAX];
+static uint16_t scanCacheCount;
+static int64_t scanCacheTime;                                                   /* completion of the cached scan */
+static int64_t scanStartTime;
+static bool scanPending;
+static SemaphoreHandle_t scanMutex;
+
 static xplrWifiStarterError_t ret;
 
 static bool cleanup = false;
@@ -163,6 +227,20 @@ static void wifiPrintMac(const unsigned char *mac);
 static void wifiStaPrintInfo(void);
 static void wifiApGetIp(void);
 static void wifiApPrintInfo(void);
+static esp_err_t wifiNetworksLoad(void);
+static esp_err_t wifiNetworksSave(void);
+static void wifiNetworksErase(void);
+static xplrWifiStarterNetwork_t *wifiRoamCandidate(uint8_t index);
+static void wifiRoamSetPrimary(void);
+static bool wifiScanCacheFresh(void);
+static esp_err_t wifiScanStart(bool rateLimited);
+static void wifiScanCacheUpdate(void);
+static const wifi_ap_record_t *wifiScanCacheFind(const char *ssid);
+static void wifiRoamSelect(void);
+static void wifiRoamStart(void);
+static void wifiRoamConnect(void);
+static void wifiRoamSchedule(void);
+static void wifiRoamTimerCb(void *arg);
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
@@ -184,6 +262,9 @@ xplrWifiStarterError_t xplrWifiStarterFsm()
             if (esp_ret == ESP_OK) {
                 esp_ret = wifiNvsLoad();
                 if (esp_ret == ESP_OK) {
+                    if (wifiNetworksLoad() != ESP_OK) {
+                        XPLRWIFISTARTER_CONSOLE(W, "Stored networks not available, using the configured one only.");
+                    }
                     xplrWifiStarterPrivateUpdateNextState(XPLR_WIFISTARTER_STATE_NETIF_INIT);
                     XPLRWIFISTARTER_CONSOLE(D, "Init flash successful!");
                 } else {
@@ -446,15 +527,16 @@ xplrWifiStarterError_t xplrWifiStarterFsm()
             break;
 
         case XPLR_WIFISTARTER_STATE_CONNECT_WIFI:
-            esp_ret = esp_wifi_connect();
-            if (esp_ret == ESP_OK) {
-                xplrWifiStarterPrivateUpdateNextState(XPLR_WIFISTARTER_STATE_CONNECT_WAIT);
-                XPLRWIFISTARTER_CONSOLE(D, "Call esp_wifi_connect success!");
-            } else {
-                xplrWifiStarterPrivateUpdateNextStateToError();
-                lastActionTime = MICROTOSEC(esp_timer_get_time());
-                XPLRWIFISTARTER_CONSOLE(E, "Call esp_wifi_connect failed!");
-            }
+            /* further attempts are made by the event handler */
+            wifiRoamSetPrimary();
+            roamAttempts = 0;
+            portENTER_CRITICAL(&roamLock);
+            memset(roamFails, 0x00, sizeof(roamFails));
+            portEXIT_CRITICAL(&roamLock);
+            lastActionTime = MICROTOSEC(esp_timer_get_time());
+            xplrWifiStarterPrivateUpdateNextState(XPLR_WIFISTARTER_STATE_CONNECT_WAIT);
+            wifiRoamStart();
+            XPLRWIFISTARTER_CONSOLE(D, "Connecting, %u stored networks.", storedNetworksCount);
             break;
 
         case XPLR_WIFISTARTER_STATE_CONNECT_WAIT:
@@ -473,7 +555,7 @@ xplrWifiStarterError_t xplrWifiStarterFsm()
                     connectedStateTime = MICROTOSEC(esp_timer_get_time());
                 }
                 if (!diagnosticsInfoUpdated) {
-                    webserverData.diagnostics.ssid = userOptions.storage.ssid;
+                    webserverData.diagnostics.ssid = roamSsid;
                     webserverData.diagnostics.hostname = staHostname;
                     webserverData.diagnostics.ip = staIpString;
                     webserverData.diagnostics.plan = userOptions.storage.ppClientPlan;
@@ -484,11 +566,8 @@ xplrWifiStarterError_t xplrWifiStarterFsm()
             break;
 
         case XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT:
-            if ((MICROTOSEC(esp_timer_get_time()) - lastActionTime) >= RETRY_PERIOD_SECS) {
-                XPLRWIFISTARTER_CONSOLE(D, "Trying to reconnect!");
-                sRetryNum = 0;
-                xplrWifiStarterPrivateUpdateNextState(XPLR_WIFISTARTER_STATE_CONNECT_WIFI);
-            }
+            /* the backoff timer of the event handler reconnects */
+            ret = XPLR_WIFISTARTER_OK;
             break;
 
         case XPLR_WIFISTARTER_STATE_STOP_WIFI:
@@ -554,6 +633,9 @@ esp_err_t xplrWifiStarterInitConnection(xplrWifiStarterOpts_t *wifiOptions)
     xplrWifiStarterPrivateInitCfg();
 
     wifiConfig.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    /* pick the strongest access point of the network, not the first one found */
+    wifiConfig.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    wifiConfig.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
 
     /* get wifi user options from app */
     memcpy(&userOptions, wifiOptions, sizeof(xplrWifiStarterOpts_t));
@@ -610,43 +692,33 @@ xplrWifiStarterFsmStates_t xplrWifiStarterGetPreviousFsmState(void)
 esp_err_t xplrWifiStarterScanNetwork(xplrWifiStarterScanList_t *scanInfo)
 {
     esp_err_t ret;
-    wifi_ap_record_t  apInfo[XPLR_WIFISTARTER_SSID_SCAN_MAX];
     size_t index = 0;
-    //wifi_scan_config_t scanConfig;
+    size_t len;
 
-    memset(apInfo, 0, sizeof(apInfo));
     memset(scanInfo, 0, sizeof(xplrWifiStarterScanList_t));
 
-    ret = esp_wifi_scan_start(NULL, true);
-    if (ret != ESP_OK) {
-        XPLRWIFISTARTER_CONSOLE(W, "SSID scan start failed with error:[%s]", esp_err_to_name(ret));
+    if (scanMutex == NULL) {
+        XPLRWIFISTARTER_CONSOLE(W, "SSID scan requested before Wi-Fi start.");
+        ret = ESP_ERR_INVALID_STATE;
     } else {
-        scanInfo->found = XPLR_WIFISTARTER_SSID_SCAN_MAX;
-        ret = esp_wifi_scan_get_ap_records(&scanInfo->found, apInfo);
+        ret = xplrWifiStarterScanRequest();
         if (ret != ESP_OK) {
-            XPLRWIFISTARTER_CONSOLE(W, "SSID scan failed with error:[%s]", esp_err_to_name(ret));
-        } else {
-            ret = esp_wifi_scan_get_ap_num(&scanInfo->found);
+            /* the cached results are still served */
+            XPLRWIFISTARTER_CONSOLE(W, "SSID scan start failed with error:[%s]", esp_err_to_name(ret));
         }
 
-        if (ret != ESP_OK) {
-            XPLRWIFISTARTER_CONSOLE(W, "SSID scan failed with error:[%s]", esp_err_to_name(ret));
-        } else {
-            /* clear list */
-            for (int i = 0; i < XPLR_WIFISTARTER_SSID_SCAN_MAX; i++) {
-                memset(&scanInfo->name[i][0], 0x00, XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX);
-            }
-            /* copy scan info */
-            for (int i = 0; ((i < scanInfo->found) && (i < XPLR_WIFISTARTER_SSID_SCAN_MAX)); i++) {
-                if (strlen((char *)apInfo[i].ssid) < XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX) {
-                    memcpy(&scanInfo->name[index][0], apInfo[i].ssid, strlen((char *)apInfo[i].ssid));
-                    scanInfo->rssi[index] = apInfo[i].rssi;
+        xSemaphoreTake(scanMutex, portMAX_DELAY);
+        scanInfo->scanning = scanPending;
+        if (scanCacheTime > 0) {
+            for (int i = 0; i < scanCacheCount; i++) {
+                len = strnlen((char *)scanCache[i].ssid, sizeof(scanCache[i].ssid));
+                if (len < XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX) {
+                    memcpy(&scanInfo->name[index][0], scanCache[i].ssid, len);
+                    memcpy(&scanInfo->bssid[index][0], scanCache[i].bssid, sizeof(scanInfo->bssid[index]));
+                    scanInfo->rssi[index] = scanCache[i].rssi;
+                    scanInfo->channel[index] = scanCache[i].primary;
+                    scanInfo->authmode[index] = (uint8_t)scanCache[i].authmode;
                     index++;
-                    XPLRWIFISTARTER_CONSOLE(D,
-                                            "Found SSID %s with RSSI:[%d]",
-                                            &scanInfo->name[index - 1][0],
-                                            scanInfo->rssi[index - 1]);
-                    vTaskDelay(pdMS_TO_TICKS(5));
                 } else {
                     XPLRWIFISTARTER_CONSOLE(W,
                                             "SSID name is more than %d chars, skipping scanlist",
@@ -654,7 +726,139 @@ esp_err_t xplrWifiStarterScanNetwork(xplrWifiStarterScanList_t *scanInfo)
                 }
             }
             scanInfo->found = index;
+            scanInfo->ageMs = (uint32_t)((esp_timer_get_time() - scanCacheTime) / 1000);
+            ret = ESP_OK;
+        } else if (ret == ESP_OK) {
+            ret = ESP_ERR_NOT_FINISHED;
+        } else {
+            // do nothing
         }
+        xSemaphoreGive(scanMutex);
+
+        XPLRWIFISTARTER_CONSOLE(D, "%u SSIDs served, %u ms old%s.",
+                                scanInfo->found,
+                                scanInfo->ageMs,
+                                scanInfo->scanning ? ", scan in progress" : "");
+    }
+
+    return ret;
+}
+
+esp_err_t xplrWifiStarterScanRequest(void)
+{
+    esp_err_t ret;
+
+    if (scanMutex == NULL) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        ret = wifiScanStart(true);
+    }
+
+    return ret;
+}
+
+xplrWifiStarterError_t xplrWifiStarterNetworkAdd(const char *ssid,
+                                                 const char *password,
+                                                 uint8_t priority)
+{
+    xplrWifiStarterNetwork_t *network = NULL;
+    xplrWifiStarterError_t ret;
+
+    if ((ssid == NULL) || (password == NULL) ||
+        (strlen(ssid) == 0) ||
+        (strlen(ssid) >= XPLR_WIFISTARTER_NVS_SSID_LENGTH_MAX) ||
+        (strlen(password) >= XPLR_WIFISTARTER_NVS_PASSWORD_LENGTH_MAX)) {
+        XPLRWIFISTARTER_CONSOLE(E, "Invalid network.");
+        ret = XPLR_WIFISTARTER_ERROR;
+    } else if (wifiNetworksLoad() != ESP_OK) {
+        ret = XPLR_WIFISTARTER_ERROR;
+    } else {
+        portENTER_CRITICAL(&roamLock);
+        for (uint8_t i = 0; (i < storedNetworksCount) && (network == NULL); i++) {
+            if (strcmp(storedNetworks[i].ssid, ssid) == 0) {
+                network = &storedNetworks[i];
+            }
+        }
+
+        if ((network == NULL) && (storedNetworksCount < XPLRWIFISTARTER_NETWORKS_MAX)) {
+            network = &storedNetworks[storedNetworksCount];
+            memset(network, 0x00, sizeof(xplrWifiStarterNetwork_t));
+            strcpy(network->ssid, ssid);
+            roamFails[storedNetworksCount + 1] = 0;
+            storedNetworksCount++;
+        }
+
+        if (network != NULL) {
+            memset(network->password, 0x00, XPLR_WIFISTARTER_NVS_PASSWORD_LENGTH_MAX);
+            strcpy(network->password, password);
+            network->priority = priority;
+        }
+        portEXIT_CRITICAL(&roamLock);
+
+        if (network == NULL) {
+            XPLRWIFISTARTER_CONSOLE(E, "Cannot store %s, %u networks already stored.",
+                                    ssid, XPLRWIFISTARTER_NETWORKS_MAX);
+            ret = XPLR_WIFISTARTER_ERROR;
+        } else {
+            if (wifiNetworksSave() == ESP_OK) {
+                XPLRWIFISTARTER_CONSOLE(D, "Network %s stored with priority %u.", ssid, priority);
+                ret = XPLR_WIFISTARTER_OK;
+            } else {
+                ret = XPLR_WIFISTARTER_ERROR;
+            }
+        }
+    }
+
+    return ret;
+}
+
+xplrWifiStarterError_t xplrWifiStarterNetworkRemove(const char *ssid)
+{
+    xplrWifiStarterError_t ret = XPLR_WIFISTARTER_ERROR;
+    bool removed = false;
+
+    if ((ssid != NULL) && (wifiNetworksLoad() == ESP_OK)) {
+        portENTER_CRITICAL(&roamLock);
+        for (uint8_t i = 0; (i < storedNetworksCount) && !removed; i++) {
+            if (strcmp(storedNetworks[i].ssid, ssid) == 0) {
+                memmove(&storedNetworks[i],
+                        &storedNetworks[i + 1],
+                        (storedNetworksCount - i - 1) * sizeof(xplrWifiStarterNetwork_t));
+                memmove(&roamFails[i + 1],
+                        &roamFails[i + 2],
+                        (storedNetworksCount - i - 1) * sizeof(roamFails[0]));
+                storedNetworksCount--;
+                memset(&storedNetworks[storedNetworksCount], 0x00, sizeof(xplrWifiStarterNetwork_t));
+                /* a later attempt may still pick it once */
+                roamIndex = -1;
+                removed = true;
+            }
+        }
+        portEXIT_CRITICAL(&roamLock);
+
+        if (removed) {
+            ret = (wifiNetworksSave() == ESP_OK) ? XPLR_WIFISTARTER_OK : XPLR_WIFISTARTER_ERROR;
+        }
+    }
+
+    if (ret != XPLR_WIFISTARTER_OK) {
+        XPLRWIFISTARTER_CONSOLE(W, "Network %s not removed.", (ssid != NULL) ? ssid : "");
+    } else {
+        XPLRWIFISTARTER_CONSOLE(D, "Network %s removed.", ssid);
+    }
+
+    return ret;
+}
+
+uint8_t xplrWifiStarterNetworkGetList(xplrWifiStarterNetwork_t *list, uint8_t size)
+{
+    uint8_t ret = 0;
+
+    if ((list != NULL) && (wifiNetworksLoad() == ESP_OK)) {
+        portENTER_CRITICAL(&roamLock);
+        ret = (storedNetworksCount < size) ? storedNetworksCount : size;
+        memcpy(list, storedNetworks, ret * sizeof(xplrWifiStarterNetwork_t));
+        portEXIT_CRITICAL(&roamLock);
     }
 
     return ret;
@@ -1193,18 +1397,25 @@ static void event_handler(void *arg,
                           int32_t event_id,
                           void *event_data)
 {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (sRetryNum < MAX_RETRIES) {
-            ret = esp_wifi_connect();
+    wifi_event_sta_disconnected_t *disconnected;
 
-            lastActionTime = MICROTOSEC(esp_timer_get_time());
-            sRetryNum++;
-            XPLRWIFISTARTER_CONSOLE(D, "Retry no [%d] to connect", sRetryNum);
-        } else {
-            sRetryNum = 0;
-            xplrWifiStarterPrivateUpdateNextState(XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT);
-            XPLRWIFISTARTER_CONSOLE(D, "Scheduling reconnect in %d seconds.", RETRY_PERIOD_SECS);
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        disconnected = (wifi_event_sta_disconnected_t *)event_data;
+        XPLRWIFISTARTER_CONSOLE(D, "Disconnected from %s, reason %u.",
+                                roamSsid, (disconnected != NULL) ? disconnected->reason : 0);
+        if ((wifiFsm[0] != XPLR_WIFISTARTER_STATE_CONNECT_OK) && (roamIndex >= 0)) {
+            /* the attempt failed, a dropped connection is not held against the network */
+            portENTER_CRITICAL(&roamLock);
+            if ((roamIndex >= 0) && (roamFails[roamIndex] < UINT8_MAX)) {
+                roamFails[roamIndex]++;
+            }
+            portEXIT_CRITICAL(&roamLock);
+            if (roamUsedCache) {
+                /* the access point may be gone, scan again */
+                scanCacheTime = 0;
+            }
         }
+        wifiRoamSchedule();
 
         if (userOptions.webserver) {
             webserverData.diagnostics.connected = 0;
@@ -1212,8 +1423,21 @@ static void event_handler(void *arg,
             memset(staIpString, 0x00, 16);
         }
 
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
+        wifiScanCacheUpdate();
+        if (roamScanPending) {
+            roamScanPending = false;
+            wifiRoamConnect();
+        }
+    } else if (event_base == XPLR_WIFISTARTER_EVENT && event_id == XPLR_WIFISTARTER_EVENT_RECONNECT) {
+        wifiRoamStart();
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        sRetryNum = 0;
+        roamAttempts = 0;
+        portENTER_CRITICAL(&roamLock);
+        if (roamIndex >= 0) {
+            roamFails[roamIndex] = 0;
+        }
+        portEXIT_CRITICAL(&roamLock);
         wifiGetIp();
         wifiStaPrintInfo();
         if (userOptions.webserver) {
@@ -1807,9 +2031,11 @@ static esp_err_t wifiNvsErase(uint8_t opt)
     esp_err_t ret;
 
     if (opt == 0) { //erase all
+        wifiNetworksErase();
         err[0] = xplrNvsErase(&storage->nvs);
         numOfNvsEntries = 1;
     } else if (opt == 1) { //erase wifi creds
+        wifiNetworksErase();
         err[0] = xplrNvsEraseKey(&storage->nvs, "id");
         err[1] = xplrNvsEraseKey(&storage->nvs, "ssid");
         err[2] = xplrNvsEraseKey(&storage->nvs, "pwd");
@@ -1889,6 +2115,33 @@ static esp_err_t xplrWifiStarterPrivateRegisterHandlers(void)
         return ret;
     }
 
+    ret = esp_event_handler_instance_register(XPLR_WIFISTARTER_EVENT,
+                                              XPLR_WIFISTARTER_EVENT_RECONNECT,
+                                              &event_handler,
+                                              NULL,
+                                              &instanceReconnect);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (scanMutex == NULL) {
+        scanMutex = xSemaphoreCreateMutex();
+        if (scanMutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (roamTimer == NULL) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = &wifiRoamTimerCb,
+            .name = "wifiRoam"
+        };
+        ret = esp_timer_create(&timerArgs, &roamTimer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
     return ESP_OK;
 }
 
@@ -1896,6 +2149,19 @@ static esp_err_t xplrWifiStarterPrivateUnregisterHandlers(void)
 {
     esp_err_t ret;
 
+    if (roamTimer != NULL) {
+        (void)esp_timer_stop(roamTimer);
+    }
+    roamScanPending = false;
+    scanPending = false;
+
+    ret = esp_event_handler_instance_unregister(XPLR_WIFISTARTER_EVENT,
+                                                XPLR_WIFISTARTER_EVENT_RECONNECT,
+                                                instanceReconnect);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_ARG) {
+        return ret;
+    }
+
     ret = esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instanceGotIp);
     if (ret != ESP_OK && ret != ESP_ERR_INVALID_ARG) {
         return ret;
@@ -2003,13 +2269,8 @@ static void wifiStaPrintInfo(void)
 {
 #if (1 == XPLRWIFISTARTER_DEBUG_ACTIVE) && (1 == XPLR_HPGLIB_SERIAL_DEBUG_ENABLED)
     XPLRWIFISTARTER_CONSOLE(I, "Station connected with following settings:");
-    if (userOptions.webserver) {
-        printf("SSID: %s\n", userOptions.storage.ssid);
-        printf("Password: %s\n", userOptions.storage.password);
-    } else {
-        printf("SSID: %s\n", userOptions.ssid);
-        printf("Password: %s\n", userOptions.password);
-    }
+    printf("SSID: %s\n", roamSsid);
+    printf("Password: %s\n", (char *)wifiConfig.sta.password);
 
     printf("IP: %s\n", staIpString);
 #endif
@@ -2031,3 +2292,352 @@ static void wifiApPrintInfo(void)
     printf("IP: %s\n", apIpString);
 #endif
 }
+
+static esp_err_t wifiNetworksLoad(void)
+{
+    size_t size = sizeof(storedNetworks);
+    xplrNvs_error_t err;
+    esp_err_t ret;
+
+    if (storedNetworksLoaded) {
+        ret = ESP_OK;
+    } else if (xplrNvsInit(&storedNetworksNvs, XPLR_WIFI_NVS_NETWORKS_NAMESPACE) != XPLR_NVS_OK) {
+        XPLRWIFISTARTER_CONSOLE(E, "Failed to init nvs namespace <%s>.", XPLR_WIFI_NVS_NETWORKS_NAMESPACE);
+        ret = ESP_FAIL;
+    } else {
+        /* nothing is stored in RAM yet, the event task only reads up to the count */
+        err = xplrNvsReadBlob(&storedNetworksNvs, XPLR_WIFI_NVS_NETWORKS_KEY, storedNetworks, &size);
+        portENTER_CRITICAL(&roamLock);
+        if ((err == XPLR_NVS_OK) && ((size % sizeof(xplrWifiStarterNetwork_t)) == 0)) {
+            storedNetworksCount = size / sizeof(xplrWifiStarterNetwork_t);
+        } else {
+            /* nothing stored yet, or stored by a different layout */
+            memset(storedNetworks, 0x00, sizeof(storedNetworks));
+            storedNetworksCount = 0;
+        }
+        portEXIT_CRITICAL(&roamLock);
+        storedNetworksLoaded = true;
+        XPLRWIFISTARTER_CONSOLE(D, "%u stored networks loaded.", storedNetworksCount);
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+static esp_err_t wifiNetworksSave(void)
+{
+    xplrNvs_error_t err;
+    esp_err_t ret;
+
+    if (storedNetworksCount > 0) {
+        err = xplrNvsWriteBlob(&storedNetworksNvs,
+                               XPLR_WIFI_NVS_NETWORKS_KEY,
+                               storedNetworks,
+                               storedNetworksCount * sizeof(xplrWifiStarterNetwork_t));
+    } else {
+        err = xplrNvsEraseKey(&storedNetworksNvs, XPLR_WIFI_NVS_NETWORKS_KEY);
+    }
+
+    if (err != XPLR_NVS_OK) {
+        XPLRWIFISTARTER_CONSOLE(E, "Failed to store networks.");
+        ret = ESP_FAIL;
+    } else {
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+static void wifiNetworksErase(void)
+{
+    bool erased = false;
+
+    if (wifiNetworksLoad() == ESP_OK) {
+        portENTER_CRITICAL(&roamLock);
+        if (storedNetworksCount > 0) {
+            storedNetworksCount = 0;
+            memset(storedNetworks, 0x00, sizeof(storedNetworks));
+            erased = true;
+        }
+        roamIndex = -1;
+        portEXIT_CRITICAL(&roamLock);
+        if (erased) {
+            (void)wifiNetworksSave();
+        }
+    }
+}
+
+static xplrWifiStarterNetwork_t *wifiRoamCandidate(uint8_t index)
+{
+    return (index == 0) ? &primaryNetwork : &storedNetworks[index - 1];
+}
+
+/**
+ * Keeps the configured network, taken from the station config, as candidate 0.
+ */
+static void wifiRoamSetPrimary(void)
+{
+    memset(&primaryNetwork, 0x00, sizeof(primaryNetwork));
+    memcpy(primaryNetwork.ssid, wifiConfig.sta.ssid, sizeof(wifiConfig.sta.ssid));
+    memcpy(primaryNetwork.password, wifiConfig.sta.password, sizeof(wifiConfig.sta.password));
+    primaryNetwork.priority = 0;
+}
+
+static bool wifiScanCacheFresh(void)
+{
+    return (scanCacheTime > 0) &&
+           ((esp_timer_get_time() - scanCacheTime) < (XPLR_WIFI_SCAN_CACHE_MAX_AGE_MS * 1000LL));
+}
+
+/**
+ * Starts a background scan, its results are cached on WIFI_EVENT_SCAN_DONE.
+ * Dwell times are kept short to limit the time the station is off channel.
+ */
+static esp_err_t wifiScanStart(bool rateLimited)
+{
+    wifi_scan_config_t scanConfig;
+    esp_err_t ret;
+
+    if (scanMutex != NULL) {
+        xSemaphoreTake(scanMutex, portMAX_DELAY);
+    }
+
+    if (scanPending) {
+        ret = ESP_OK;
+    } else if (rateLimited && (scanStartTime > 0) &&
+               ((esp_timer_get_time() - scanStartTime) < (XPLRWIFISTARTER_SCAN_MIN_INTERVAL_MS * 1000LL))) {
+        /* the cached results are recent enough */
+        ret = ESP_OK;
+    } else {
+        memset(&scanConfig, 0x00, sizeof(scanConfig));
+        scanConfig.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+        scanConfig.scan_time.active.min = XPLR_WIFI_SCAN_DWELL_MIN_MS;
+        scanConfig.scan_time.active.max = XPLR_WIFI_SCAN_DWELL_MAX_MS;
+        ret = esp_wifi_scan_start(&scanConfig, false);
+        if (ret == ESP_OK) {
+            scanPending = true;
+            scanStartTime = esp_timer_get_time();
+        }
+    }
+
+    if (scanMutex != NULL) {
+        xSemaphoreGive(scanMutex);
+    }
+
+    return ret;
+}
+
+static void wifiScanCacheUpdate(void)
+{
+    uint16_t count = XPLR_WIFISTARTER_SSID_SCAN_MAX;
+    esp_err_t err;
+
+    if (scanMutex != NULL) {
+        xSemaphoreTake(scanMutex, portMAX_DELAY);
+        /* also frees the records kept by the driver */
+        err = esp_wifi_scan_get_ap_records(&count, scanCache);
+        if (err == ESP_OK) {
+            scanCacheCount = count;
+            scanCacheTime = esp_timer_get_time();
+        } else {
+            XPLRWIFISTARTER_CONSOLE(W, "Failed to get scan results (%s).", esp_err_to_name(err));
+        }
+        scanPending = false;
+        xSemaphoreGive(scanMutex);
+        XPLRWIFISTARTER_CONSOLE(D, "Scan done, %u access points cached.", scanCacheCount);
+    }
+}
+
+/**
+ * Strongest access point of a network in the scan results, NULL if none is usable.
+ */
+static const wifi_ap_record_t *wifiScanCacheFind(const char *ssid)
+{
+    const wifi_ap_record_t *ret = NULL;
+
+    for (uint16_t i = 0; i < scanCacheCount; i++) {
+        if ((strncmp((const char *)scanCache[i].ssid, ssid, sizeof(scanCache[i].ssid)) == 0) &&
+            (scanCache[i].rssi >= XPLR_WIFI_ROAM_RSSI_MIN) &&
+            ((ret == NULL) || (scanCache[i].rssi > ret->rssi))) {
+            ret = &scanCache[i];
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Writes the station config of the next attempt. Visible networks are ranked
+ * by priority then signal, and their strongest access point is targeted
+ * directly. When none is visible the highest priority network is tried and
+ * the driver scans for it. The stored networks are locked while ranking,
+ * the app task may add or remove one meanwhile.
+ */
+static void wifiRoamSelect(void)
+{
+    const xplrWifiStarterNetwork_t *candidate;
+    const wifi_ap_record_t *record;
+    const wifi_ap_record_t *bestRecord = NULL;
+    uint8_t candidates;
+    int8_t best = -1;
+    int8_t fallback = -1;
+    bool fresh = wifiScanCacheFresh();
+    bool allFailed = true;
+
+    portENTER_CRITICAL(&roamLock);
+    candidates = storedNetworksCount + 1;
+    for (uint8_t i = 0; i < candidates; i++) {
+        if ((wifiRoamCandidate(i)->ssid[0] != 0) && (roamFails[i] < XPLR_WIFI_NETWORK_FAILS_MAX)) {
+            allFailed = false;
+        }
+    }
+    if (allFailed) {
+        /* every network failed, start over */
+        memset(roamFails, 0x00, sizeof(roamFails));
+    }
+
+    for (uint8_t i = 0; i < candidates; i++) {
+        candidate = wifiRoamCandidate(i);
+        if ((candidate->ssid[0] == 0) || (roamFails[i] >= XPLR_WIFI_NETWORK_FAILS_MAX)) {
+            continue;
+        }
+        record = fresh ? wifiScanCacheFind(candidate->ssid) : NULL;
+        if ((record != NULL) &&
+            ((bestRecord == NULL) ||
+             (candidate->priority > wifiRoamCandidate(best)->priority) ||
+             ((candidate->priority == wifiRoamCandidate(best)->priority) &&
+              (record->rssi > bestRecord->rssi)))) {
+            best = i;
+            bestRecord = record;
+        }
+        if ((fallback < 0) || (candidate->priority > wifiRoamCandidate(fallback)->priority)) {
+            fallback = i;
+        }
+    }
+
+    roamUsedCache = (bestRecord != NULL);
+    roamIndex = (best >= 0) ? best : fallback;
+    if (roamIndex >= 0) {
+        candidate = wifiRoamCandidate(roamIndex);
+        memset(wifiConfig.sta.ssid, 0x00, sizeof(wifiConfig.sta.ssid));
+        memset(wifiConfig.sta.password, 0x00, sizeof(wifiConfig.sta.password));
+        memcpy(wifiConfig.sta.ssid, candidate->ssid, strnlen(candidate->ssid, sizeof(wifiConfig.sta.ssid)));
+        memcpy(wifiConfig.sta.password,
+               candidate->password,
+               strnlen(candidate->password, sizeof(wifiConfig.sta.password)));
+        memset(roamSsid, 0x00, sizeof(roamSsid));
+        strncpy(roamSsid, candidate->ssid, sizeof(roamSsid) - 1);
+        if (bestRecord != NULL) {
+            memcpy(wifiConfig.sta.bssid, bestRecord->bssid, sizeof(wifiConfig.sta.bssid));
+            wifiConfig.sta.bssid_set = true;
+            wifiConfig.sta.channel = bestRecord->primary;
+        } else {
+            wifiConfig.sta.bssid_set = false;
+            wifiConfig.sta.channel = 0;
+        }
+    }
+    portEXIT_CRITICAL(&roamLock);
+
+    /* the scan results only change on this task */
+    if (bestRecord != NULL) {
+        XPLRWIFISTARTER_CONSOLE(D, "Selected %s, RSSI %d, channel %u.",
+                                roamSsid, bestRecord->rssi, bestRecord->primary);
+    } else if (roamIndex >= 0) {
+        XPLRWIFISTARTER_CONSOLE(D, "Selected %s, not in the scan results.", roamSsid);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Connects right away, or scans first when other networks are stored and
+ * the scan results are old.
+ */
+static void wifiRoamStart(void)
+{
+    esp_err_t err;
+
+    if ((storedNetworksCount > 0) && !wifiScanCacheFresh()) {
+        /* a scan already running is waited for */
+        err = wifiScanStart(false);
+        if (err == ESP_OK) {
+            roamScanPending = true;
+        } else {
+            XPLRWIFISTARTER_CONSOLE(W, "Roaming scan failed (%s), connecting without it.",
+                                    esp_err_to_name(err));
+            wifiRoamConnect();
+        }
+    } else {
+        wifiRoamConnect();
+    }
+}
+
+static void wifiRoamConnect(void)
+{
+    esp_err_t err;
+
+    wifiRoamSelect();
+    err = esp_wifi_set_config(WIFI_IF_STA, &wifiConfig);
+    if (err == ESP_OK) {
+        err = esp_wifi_connect();
+    }
+
+    lastActionTime = MICROTOSEC(esp_timer_get_time());
+    if (err != ESP_OK) {
+        XPLRWIFISTARTER_CONSOLE(E, "Connecting to %s failed (%s).", roamSsid, esp_err_to_name(err));
+        wifiRoamSchedule();
+    } else {
+        XPLRWIFISTARTER_CONSOLE(D, "Connecting to %s, attempt %u.", roamSsid, roamAttempts + 1);
+    }
+}
+
+/**
+ * Plans the next attempt: the first one is immediate, the next ones back off
+ * exponentially with jitter so that devices losing the same AP do not retry together.
+ */
+static void wifiRoamSchedule(void)
+{
+    uint32_t delayMs;
+    uint32_t jitterMs;
+    uint32_t shift;
+    xplrWifiStarterFsmStates_t state;
+
+    roamAttempts++;
+    if (roamAttempts == 1) {
+        delayMs = 0;
+    } else {
+        shift = (roamAttempts - 2 < 16) ? (roamAttempts - 2) : 16;
+        delayMs = XPLRWIFISTARTER_BACKOFF_INITIAL_MS << shift;
+        if (delayMs > XPLRWIFISTARTER_BACKOFF_MAX_MS) {
+            delayMs = XPLRWIFISTARTER_BACKOFF_MAX_MS;
+        }
+        jitterMs = (delayMs * XPLR_WIFI_BACKOFF_JITTER_PCT) / 100;
+        delayMs = delayMs - jitterMs + (esp_random() % ((2 * jitterMs) + 1));
+    }
+
+    state = (roamAttempts > XPLR_WIFI_RETRIES_BEFORE_SCHEDULE) ?
+            XPLR_WIFISTARTER_STATE_SCHEDULE_RECONNECT : XPLR_WIFISTARTER_STATE_CONNECT_WAIT;
+    if (wifiFsm[0] != state) {
+        xplrWifiStarterPrivateUpdateNextState(state);
+    }
+    lastActionTime = MICROTOSEC(esp_timer_get_time());
+
+    if ((delayMs == 0) || (roamTimer == NULL)) {
+        wifiRoamStart();
+    } else {
+        (void)esp_timer_stop(roamTimer);
+        if (esp_timer_start_once(roamTimer, (uint64_t)delayMs * 1000ULL) != ESP_OK) {
+            XPLRWIFISTARTER_CONSOLE(E, "Reconnect timer failed, reconnecting now.");
+            wifiRoamStart();
+        } else {
+            XPLRWIFISTARTER_CONSOLE(D, "Reconnect attempt %u in %u ms.", roamAttempts, delayMs);
+        }
+    }
+}
+
+static void wifiRoamTimerCb(void *arg)
+{
+    (void)arg;
+    /* hand over to the event task, where the other Wi-Fi events are handled */
+    (void)esp_event_post(XPLR_WIFISTARTER_EVENT, XPLR_WIFISTARTER_EVENT_RECONNECT, NULL, 0, 0);
+}
@@ -21,10 +21,14 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include "esp_vfs.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
 #include "xplr_wifi_starter.h"
 #include "xplr_wifi_webserver.h"
 #include "cJSON.h"
 #include "./../hpglib/xplr_hpglib_cfg.h"
+#include "./../hpglib/src/ota_service/xplr_ota.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -33,6 +37,36 @@
 /* Data buffer for websocket transactions */
 #define WEBSOCKET_BUFSIZE           (CONFIG_WS_BUFFER_SIZE)
 
+/* Cache policy of html pages and of the portal own scripts and styles,
+ * which change with the firmware: always revalidated against their ETag */
+#define WEBSERVER_CACHE_PAGE        "no-cache"
+
+/* Cache policy of vendored libraries and images, which do not change
+ * between firmware versions */
+#define WEBSERVER_CACHE_STATIC      "public, max-age=604800"
+
+/* Size of a quoted 32bit ETag plus terminator */
+#define WEBSERVER_ETAG_SIZE         (sizeof("\"00000000\""))
+
+/* Max size of an If-None-Match request header we try to match */
+#define WEBSERVER_IF_NONE_MATCH_MAX (64U)
+
+/* Telemetry frame, the longest encoding is 240 bytes */
+#define WEBSERVER_TELEMETRY_SIZE    (256U)
+
+/* Consecutive pushes a client may miss, its socket still being full,
+ * before it is disconnected */
+#define WEBSERVER_TELEMETRY_MISSES  (3U)
+
+/* Firmware upload is received and written in chunks of this size */
+#define WEBSERVER_OTA_CHUNK_SIZE    (1024U)
+
+/* Receive timeouts tolerated in a row during a firmware upload */
+#define WEBSERVER_OTA_TIMEOUTS_MAX  (5U)
+
+/* Time left to the response before restarting into a new firmware */
+#define WEBSERVER_OTA_RESTART_MS    (2000U)
+
 /**
  * Debugging print macro
  */
@@ -68,6 +102,7 @@ typedef struct xplrWifiWebserverUris_type {
     httpd_uri_t xplrHpg;
     httpd_uri_t xplrHpgCss;
     httpd_uri_t ws;
+    httpd_uri_t ota;
 } xplrWifiWebserverUris_t;
 
 typedef struct xplrWifiWebserver_type {
@@ -76,9 +111,22 @@ typedef struct xplrWifiWebserver_type {
     xplrWifiWebserverUris_t     uris;
     bool                        running;
     uint8_t                     wsBuf[WEBSOCKET_BUFSIZE];
+    uint8_t                     otaBuf[WEBSERVER_OTA_CHUNK_SIZE];
     xplrWifiWebServerData_t     *wsData;
 } xplrWifiWebserver_t;
 
+typedef struct xplrWifiWebserverTelemetry_type {
+    xplrWifiWebServerDataTelemetry_t    data;       /* latest snapshot, guarded by lock */
+    bool                                valid;
+    portMUX_TYPE                        lock;
+    esp_timer_handle_t                  timer;
+    volatile bool                       pushPending;
+    int                                 fds[XPLR_WIFIWEBSERVER_SOCKETS_OPEN_MAX];
+    uint8_t                             misses[XPLR_WIFIWEBSERVER_SOCKETS_OPEN_MAX];
+    uint8_t                             subscribers;
+    char                                frame[WEBSERVER_TELEMETRY_SIZE];
+} xplrWifiWebserverTelemetry_t;
+
 typedef enum {
     XPLR_WEBSERVER_WSREQ_INVALID = -1,
     XPLR_WEBSERVER_WSREQ_STATUS,
@@ -99,6 +147,7 @@ typedef enum {
     XPLR_WEBSERVER_WSREQ_DR_SET,
     XPLR_WEBSERVER_WSREQ_LOCATION,
     XPLR_WEBSERVER_WSREQ_MESSAGE,
+    XPLR_WEBSERVER_WSREQ_TELEMETRY,
     XPLR_WEBSERVER_WSREQ_SUPPORTED  //number of requests supported
 } xplrWifiWebserverWsReqType_t;
 
@@ -111,6 +160,9 @@ httpd_ws_frame_t        locationFrame;
 char                    locationFrameBuff[512];
 httpd_ws_frame_t        messageFrame;
 char                    messageFrameBuff[512];
+static xplrWifiWebserverTelemetry_t telemetry = {
+    .lock = portMUX_INITIALIZER_UNLOCKED
+};
 static int8_t           logIndex = -1;
 
 /* ----------------------------------------------------------------
@@ -124,9 +176,11 @@ static esp_err_t settingsGetHandler(httpd_req_t *req);
 static esp_err_t liveTrackerGetHandler(httpd_req_t *req);
 static esp_err_t errorGetHandler(httpd_req_t *req);
 static esp_err_t bootstrapGetHandler(httpd_req_t *req);
-static esp_err_t bootstrapMapGetHandler(httpd_req_t *req);
 static esp_err_t bootstrapCssGetHandler(httpd_req_t *req);
+#if defined(CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS)
+static esp_err_t bootstrapMapGetHandler(httpd_req_t *req);
 static esp_err_t bootstrapCssMapGetHandler(httpd_req_t *req);
+#endif
 static esp_err_t fontAwesomeGetHandler(httpd_req_t *req);
 static esp_err_t fontAwesomeCssGetHandler(httpd_req_t *req);
 static esp_err_t jQueryGetHandler(httpd_req_t *req);
@@ -134,7 +188,16 @@ static esp_err_t favIconGetHandler(httpd_req_t *req);
 static esp_err_t ubloxLogoSvgGetHandler(httpd_req_t *req);
 static esp_err_t xplrHpgGetHandler(httpd_req_t *req);
 static esp_err_t xplrHpgCssGetHandler(httpd_req_t *req);
+static esp_err_t otaPostHandler(httpd_req_t *req);
 static esp_err_t error404Handler(httpd_req_t *req, httpd_err_code_t err);
+static esp_err_t webserverSendAsset(httpd_req_t *req,
+                                    const char *type,
+                                    const unsigned char *start,
+                                    const unsigned char *end,
+                                    bool gzipped,
+                                    const char *cacheControl,
+                                    uint32_t *etag);
+static uint32_t webserverAssetEtag(const unsigned char *start, size_t size);
 static bool xplrHpgThingstreamCredsConfigured(void);
 
 /* websocket */
@@ -142,6 +205,18 @@ static bool xplrHpgThingstreamCredsConfigured(void);
 static esp_err_t wsGetHandler(httpd_req_t *req);
 static esp_err_t wsParseData(httpd_req_t *req, uint8_t *data);
 static esp_err_t wsServeReq(httpd_req_t *req, xplrWifiWebserverWsReqType_t type);
+static void wsSessionClose(httpd_handle_t hd, int sockfd);
+
+/* telemetry */
+
+static esp_err_t telemetryStart(void);
+static void telemetryStop(void);
+static void telemetryTimerCb(void *arg);
+static void telemetryPush(void *arg);
+static size_t telemetryEncode(char *buf, size_t size);
+static esp_err_t telemetrySubscribe(httpd_req_t *req);
+static void telemetryUnsubscribe(uint8_t index);
+static bool telemetryWritable(int fd);
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS DESCRIPTORS
@@ -162,6 +237,7 @@ httpd_handle_t  xplrWifiWebserverStart(xplrWifiWebServerData_t *data)
         webserver.config.max_uri_handlers = WEBSERVER_URIS_MAX;
         webserver.config.lru_purge_enable = true;
         webserver.config.uri_match_fn = httpd_uri_match_wildcard;
+        webserver.config.close_fn = wsSessionClose;
 
         /* set uris to handle */
         webserver.uris.index.uri = "/";
@@ -189,17 +265,20 @@ httpd_handle_t  xplrWifiWebserverStart(xplrWifiWebServerData_t *data)
         webserver.uris.bootstrap.method = HTTP_GET;
         webserver.uris.bootstrap.handler = bootstrapGetHandler;
 
-        webserver.uris.bootstrapMap.uri = "/static/js/bootstrap.bundle.min.js.map";
-        webserver.uris.bootstrapMap.method = HTTP_GET;
-        webserver.uris.bootstrapMap.handler = bootstrapMapGetHandler;
-
         webserver.uris.bootstrapCss.uri = "/static/css/bootstrap.min.css";
         webserver.uris.bootstrapCss.method = HTTP_GET;
         webserver.uris.bootstrapCss.handler = bootstrapCssGetHandler;
 
+#if defined(CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS)
+        /* source maps are only embedded when CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS is set */
+        webserver.uris.bootstrapMap.uri = "/static/js/bootstrap.bundle.min.js.map";
+        webserver.uris.bootstrapMap.method = HTTP_GET;
+        webserver.uris.bootstrapMap.handler = bootstrapMapGetHandler;
+
         webserver.uris.bootstrapCssMap.uri = "/static/css/bootstrap.min.css.map";
         webserver.uris.bootstrapCssMap.method = HTTP_GET;
         webserver.uris.bootstrapCssMap.handler = bootstrapCssMapGetHandler;
+#endif
 
         webserver.uris.fontAwesome.uri = "/static/js/fontawesome.min.js";
         webserver.uris.fontAwesome.method = HTTP_GET;
@@ -235,6 +314,10 @@ httpd_handle_t  xplrWifiWebserverStart(xplrWifiWebServerData_t *data)
         webserver.uris.ws.user_ctx = NULL;
         webserver.uris.ws.is_websocket  = true;
 
+        webserver.uris.ota.uri = "/ota";
+        webserver.uris.ota.method = HTTP_POST;
+        webserver.uris.ota.handler = otaPostHandler;
+
         // Start the httpd server
         XPLRWIFIWEBSERVER_CONSOLE(D, "Starting server on port: '%d'", webserver.config.server_port);
         err = httpd_start(&webserver.instance, &webserver.config);
@@ -247,9 +330,11 @@ httpd_handle_t  xplrWifiWebserverStart(xplrWifiWebServerData_t *data)
             httpd_register_uri_handler(webserver.instance, &webserver.uris.liveTracker);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.error);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.bootstrap);
-            httpd_register_uri_handler(webserver.instance, &webserver.uris.bootstrapMap);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.bootstrapCss);
+#if defined(CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS)
+            httpd_register_uri_handler(webserver.instance, &webserver.uris.bootstrapMap);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.bootstrapCssMap);
+#endif
             httpd_register_uri_handler(webserver.instance, &webserver.uris.fontAwesome);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.fontAwesomeCss);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.jQuery);
@@ -258,10 +343,20 @@ httpd_handle_t  xplrWifiWebserverStart(xplrWifiWebServerData_t *data)
             httpd_register_uri_handler(webserver.instance, &webserver.uris.xplrHpg);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.xplrHpgCss);
             httpd_register_uri_handler(webserver.instance, &webserver.uris.ws);
+            /* uploads are only accepted once the application initialized the ota service */
+            if (xplrOtaIsInit()) {
+                httpd_register_uri_handler(webserver.instance, &webserver.uris.ota);
+            } else {
+                XPLRWIFIWEBSERVER_CONSOLE(W, "OTA service not initialized, firmware upload disabled");
+            }
             httpd_register_err_handler(webserver.instance, HTTPD_404_NOT_FOUND, error404Handler);
 
             webserver.wsData = data;
             webserver.running = true;
+
+            if (telemetryStart() != ESP_OK) {
+                XPLRWIFIWEBSERVER_CONSOLE(W, "Telemetry push not available");
+            }
         } else {
             XPLRWIFIWEBSERVER_CONSOLE(E, "Error starting webserver: %s", esp_err_to_name(err));
         }
@@ -276,9 +371,12 @@ esp_err_t xplrWifiWebserverStop(void)
 {
     esp_err_t ret;
 
+    telemetryStop();
     ret = httpd_stop(webserver.instance);
     webserver.instance = NULL;
     webserver.wsData = NULL;
+    webserver.running = false;
+    telemetry.subscribers = 0;
 
     return ret;
 }
@@ -313,6 +411,24 @@ esp_err_t xplrWifiWebserverSendMessage(char *message)
     return ret;
 }
 
+esp_err_t xplrWifiWebserverSendTelemetry(const xplrWifiWebServerDataTelemetry_t *telemetryData)
+{
+    esp_err_t ret;
+
+    if (telemetryData != NULL) {
+        /* only copied here, encoding is done once per push for all clients */
+        portENTER_CRITICAL(&telemetry.lock);
+        memcpy(&telemetry.data, telemetryData, sizeof(xplrWifiWebServerDataTelemetry_t));
+        telemetry.valid = true;
+        portEXIT_CRITICAL(&telemetry.lock);
+        ret = ESP_OK;
+    } else {
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
 int8_t xplrWifiWebserverInitLogModule(xplr_cfg_logInstance_t *logCfg)
 {
     int8_t ret;
@@ -368,17 +484,12 @@ esp_err_t xplrWifiWebserverStopLogModule(void)
 static esp_err_t indexGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char indexStart[] asm("_binary_index_html_start");
-    extern const unsigned char indexEnd[]   asm("_binary_index_html_end");
-    const size_t pageSize = (indexEnd - indexStart);
+    static uint32_t etag = 0;
+    extern const unsigned char indexStart[] asm("_binary_index_html_gz_start");
+    extern const unsigned char indexEnd[]   asm("_binary_index_html_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for index.html");
-    ret = httpd_resp_set_type(req, "text/html");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for index");
-    } else {
-        ret = httpd_resp_send(req, (const char *)indexStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/html", indexStart, indexEnd, true, WEBSERVER_CACHE_PAGE, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to index get request");
@@ -392,17 +503,12 @@ static esp_err_t indexGetHandler(httpd_req_t *req)
 static esp_err_t settingsGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char settingsStart[] asm("_binary_settings_html_start");
-    extern const unsigned char settingsEnd[]   asm("_binary_settings_html_end");
-    const size_t pageSize = (settingsEnd - settingsStart);
+    static uint32_t etag = 0;
+    extern const unsigned char settingsStart[] asm("_binary_settings_html_gz_start");
+    extern const unsigned char settingsEnd[]   asm("_binary_settings_html_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for settings.html");
-    ret = httpd_resp_set_type(req, "text/html");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for settings");
-    } else {
-        ret = httpd_resp_send(req, (const char *)settingsStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/html", settingsStart, settingsEnd, true, WEBSERVER_CACHE_PAGE, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to settings get request");
@@ -416,17 +522,12 @@ static esp_err_t settingsGetHandler(httpd_req_t *req)
 static esp_err_t liveTrackerGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char trackerStart[] asm("_binary_tracker_html_start");
-    extern const unsigned char trackerEnd[]   asm("_binary_tracker_html_end");
-    const size_t pageSize = (trackerEnd - trackerStart);
+    static uint32_t etag = 0;
+    extern const unsigned char trackerStart[] asm("_binary_tracker_html_gz_start");
+    extern const unsigned char trackerEnd[]   asm("_binary_tracker_html_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for tracker.html");
-    ret = httpd_resp_set_type(req, "text/html");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for index");
-    } else {
-        ret = httpd_resp_send(req, (const char *)trackerStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/html", trackerStart, trackerEnd, true, WEBSERVER_CACHE_PAGE, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to tracker get request");
@@ -440,17 +541,12 @@ static esp_err_t liveTrackerGetHandler(httpd_req_t *req)
 static esp_err_t errorGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char errorStart[] asm("_binary_error_html_start");
-    extern const unsigned char errorEnd[]   asm("_binary_error_html_end");
-    const size_t pageSize = (errorEnd - errorStart);
+    static uint32_t etag = 0;
+    extern const unsigned char errorStart[] asm("_binary_error_html_gz_start");
+    extern const unsigned char errorEnd[]   asm("_binary_error_html_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for error.html");
-    ret = httpd_resp_set_type(req, "text/html");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for error");
-    } else {
-        ret = httpd_resp_send(req, (const char *)errorStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/html", errorStart, errorEnd, true, WEBSERVER_CACHE_PAGE, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to error get request");
@@ -464,17 +560,12 @@ static esp_err_t errorGetHandler(httpd_req_t *req)
 static esp_err_t bootstrapGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char bootstrapJsStart[] asm("_binary_bootstrap_bundle_min_js_start");
-    extern const unsigned char bootstrapJsEnd[]   asm("_binary_bootstrap_bundle_min_js_end");
-    const size_t pageSize = (bootstrapJsEnd - bootstrapJsStart);
+    static uint32_t etag = 0;
+    extern const unsigned char bootstrapJsStart[] asm("_binary_bootstrap_bundle_min_js_gz_start");
+    extern const unsigned char bootstrapJsEnd[]   asm("_binary_bootstrap_bundle_min_js_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for bootstrap.bundle.min.js");
-    ret = httpd_resp_set_type(req, "text/javascript");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for js");
-    } else {
-        ret = httpd_resp_send(req, (const char *)bootstrapJsStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/javascript", bootstrapJsStart, bootstrapJsEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to bootstrap get request");
@@ -485,20 +576,16 @@ static esp_err_t bootstrapGetHandler(httpd_req_t *req)
     return ret;
 }
 
+#if defined(CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS)
 static esp_err_t bootstrapMapGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char bootstrapJsMapStart[] asm("_binary_bootstrap_bundle_min_js_map_start");
-    extern const unsigned char bootstrapJsMapEnd[]   asm("_binary_bootstrap_bundle_min_js_map_end");
-    const size_t pageSize = (bootstrapJsMapEnd - bootstrapJsMapStart);
+    static uint32_t etag = 0;
+    extern const unsigned char bootstrapJsMapStart[] asm("_binary_bootstrap_bundle_min_js_map_gz_start");
+    extern const unsigned char bootstrapJsMapEnd[]   asm("_binary_bootstrap_bundle_min_js_map_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for bootstrap.bundle.min.js.map");
-    ret = httpd_resp_set_type(req, "application/json");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for js");
-    } else {
-        ret = httpd_resp_send(req, (const char *)bootstrapJsMapStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "application/json", bootstrapJsMapStart, bootstrapJsMapEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to bootstrap get request");
@@ -508,21 +595,17 @@ static esp_err_t bootstrapMapGetHandler(httpd_req_t *req)
 
     return ret;
 }
+#endif
 
 static esp_err_t bootstrapCssGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char bootstrapCssStart[] asm("_binary_bootstrap_min_css_start");
-    extern const unsigned char bootstrapCssEnd[]   asm("_binary_bootstrap_min_css_end");
-    const size_t pageSize = (bootstrapCssEnd - bootstrapCssStart);
+    static uint32_t etag = 0;
+    extern const unsigned char bootstrapCssStart[] asm("_binary_bootstrap_min_css_gz_start");
+    extern const unsigned char bootstrapCssEnd[]   asm("_binary_bootstrap_min_css_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for bootstrap.min.css");
-    ret = httpd_resp_set_type(req, "text/css");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for css");
-    } else {
-        ret = httpd_resp_send(req, (const char *)bootstrapCssStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/css", bootstrapCssStart, bootstrapCssEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to bootstrap css get request");
@@ -533,20 +616,16 @@ static esp_err_t bootstrapCssGetHandler(httpd_req_t *req)
     return ret;
 }
 
+#if defined(CONFIG_XPLR_WIFI_PORTAL_SOURCE_MAPS)
 static esp_err_t bootstrapCssMapGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char bootstrapCssMapStart[] asm("_binary_bootstrap_min_css_map_start");
-    extern const unsigned char bootstrapCssMapEnd[]   asm("_binary_bootstrap_min_css_map_end");
-    const size_t pageSize = (bootstrapCssMapEnd - bootstrapCssMapStart);
+    static uint32_t etag = 0;
+    extern const unsigned char bootstrapCssMapStart[] asm("_binary_bootstrap_min_css_map_gz_start");
+    extern const unsigned char bootstrapCssMapEnd[]   asm("_binary_bootstrap_min_css_map_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for bootstrap.min.css.map");
-    ret = httpd_resp_set_type(req, "application/json");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for css.map");
-    } else {
-        ret = httpd_resp_send(req, (const char *)bootstrapCssMapStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "application/json", bootstrapCssMapStart, bootstrapCssMapEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to bootstrap css get request");
@@ -556,21 +635,17 @@ static esp_err_t bootstrapCssMapGetHandler(httpd_req_t *req)
 
     return ret;
 }
+#endif
 
 static esp_err_t fontAwesomeGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char fontAwesomeJsStart[] asm("_binary_fontawesome_min_js_start");
-    extern const unsigned char fontAwesomeJsEnd[]   asm("_binary_fontawesome_min_js_end");
-    const size_t pageSize = (fontAwesomeJsEnd - fontAwesomeJsStart);
+    static uint32_t etag = 0;
+    extern const unsigned char fontAwesomeJsStart[] asm("_binary_fontawesome_min_js_gz_start");
+    extern const unsigned char fontAwesomeJsEnd[]   asm("_binary_fontawesome_min_js_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for fontawesome.min.js");
-    ret = httpd_resp_set_type(req, "text/javascript");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for js");
-    } else {
-        ret = httpd_resp_send(req, (const char *)fontAwesomeJsStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/javascript", fontAwesomeJsStart, fontAwesomeJsEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to fontawesome get request");
@@ -584,17 +659,12 @@ static esp_err_t fontAwesomeGetHandler(httpd_req_t *req)
 static esp_err_t fontAwesomeCssGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char fontawesomeCssStart[] asm("_binary_fontawesome_min_css_start");
-    extern const unsigned char fontawesomeCssEnd[]   asm("_binary_fontawesome_min_css_end");
-    const size_t pageSize = (fontawesomeCssEnd - fontawesomeCssStart);
+    static uint32_t etag = 0;
+    extern const unsigned char fontawesomeCssStart[] asm("_binary_fontawesome_min_css_gz_start");
+    extern const unsigned char fontawesomeCssEnd[]   asm("_binary_fontawesome_min_css_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for fontawesome.min.css");
-    ret = httpd_resp_set_type(req, "text/css");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for css");
-    } else {
-        ret = httpd_resp_send(req, (const char *)fontawesomeCssStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/css", fontawesomeCssStart, fontawesomeCssEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to fontawesome css get request");
@@ -608,17 +678,12 @@ static esp_err_t fontAwesomeCssGetHandler(httpd_req_t *req)
 static esp_err_t jQueryGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char jQueryJsStart[] asm("_binary_jquery_min_js_start");
-    extern const unsigned char jQueryJsEnd[]   asm("_binary_jquery_min_js_end");
-    const size_t pageSize = (jQueryJsEnd - jQueryJsStart);
+    static uint32_t etag = 0;
+    extern const unsigned char jQueryJsStart[] asm("_binary_jquery_min_js_gz_start");
+    extern const unsigned char jQueryJsEnd[]   asm("_binary_jquery_min_js_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for jquery.min.js");
-    ret = httpd_resp_set_type(req, "text/javascript");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for js");
-    } else {
-        ret = httpd_resp_send(req, (const char *)jQueryJsStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/javascript", jQueryJsStart, jQueryJsEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to jQuery get request");
@@ -632,17 +697,12 @@ static esp_err_t jQueryGetHandler(httpd_req_t *req)
 static esp_err_t favIconGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
+    static uint32_t etag = 0;
     extern const unsigned char favIconStart[] asm("_binary_favicon_ico_start");
     extern const unsigned char favIconEnd[]   asm("_binary_favicon_ico_end");
-    const size_t pageSize = (favIconEnd - favIconStart);
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for favicon.ico");
-    ret = httpd_resp_set_type(req, "image/x-icon");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for ico");
-    } else {
-        ret = httpd_resp_send(req, (const char *)favIconStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "image/x-icon", favIconStart, favIconEnd, false, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to favicon get request");
@@ -656,17 +716,12 @@ static esp_err_t favIconGetHandler(httpd_req_t *req)
 static esp_err_t ubloxLogoSvgGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char ubxLogoSvgStart[] asm("_binary_ublox_logo_svg_start");
-    extern const unsigned char ubxLogoSvgEnd[]   asm("_binary_ublox_logo_svg_end");
-    const size_t pageSize = (ubxLogoSvgEnd - ubxLogoSvgStart);
+    static uint32_t etag = 0;
+    extern const unsigned char ubxLogoSvgStart[] asm("_binary_ublox_logo_svg_gz_start");
+    extern const unsigned char ubxLogoSvgEnd[]   asm("_binary_ublox_logo_svg_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for ublox_logo.svg");
-    ret = httpd_resp_set_type(req, "image/svg+xml");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for svg");
-    } else {
-        ret = httpd_resp_send(req, (const char *)ubxLogoSvgStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "image/svg+xml", ubxLogoSvgStart, ubxLogoSvgEnd, true, WEBSERVER_CACHE_STATIC, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to ublox logo (svg) get request");
@@ -680,17 +735,12 @@ static esp_err_t ubloxLogoSvgGetHandler(httpd_req_t *req)
 static esp_err_t xplrHpgGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char xplrHpgJsStart[] asm("_binary_xplrHpg_js_start");
-    extern const unsigned char xplrHpgJsEnd[]   asm("_binary_xplrHpg_js_end");
-    const size_t pageSize = (xplrHpgJsEnd - xplrHpgJsStart);
+    static uint32_t etag = 0;
+    extern const unsigned char xplrHpgJsStart[] asm("_binary_xplrHpg_js_gz_start");
+    extern const unsigned char xplrHpgJsEnd[]   asm("_binary_xplrHpg_js_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for xplrHpg.js");
-    ret = httpd_resp_set_type(req, "text/javascript");
-    if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for js");
-    } else {
-        ret = httpd_resp_send(req, (const char *)xplrHpgJsStart, pageSize);
-    }
+    ret = webserverSendAsset(req, "text/javascript", xplrHpgJsStart, xplrHpgJsEnd, true, WEBSERVER_CACHE_PAGE, &etag);
 
     if (ret != ESP_OK) {
         XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to xplrHpg get request");
@@ -704,22 +754,85 @@ static esp_err_t xplrHpgGetHandler(httpd_req_t *req)
 static esp_err_t xplrHpgCssGetHandler(httpd_req_t *req)
 {
     esp_err_t ret;
-    extern const unsigned char xplrHpgCssStart[] asm("_binary_xplrHpg_css_start");
-    extern const unsigned char xplrHpgCssEnd[]   asm("_binary_xplrHpg_css_end");
-    const size_t pageSize = (xplrHpgCssEnd - xplrHpgCssStart);
+    static uint32_t etag = 0;
+    extern const unsigned char xplrHpgCssStart[] asm("_binary_xplrHpg_css_gz_start");
+    extern const unsigned char xplrHpgCssEnd[]   asm("_binary_xplrHpg_css_gz_end");
 
     XPLRWIFIWEBSERVER_CONSOLE(D, "Got request for xplrHpg.css");
-    ret = httpd_resp_set_type(req, "text/css");
+    ret = webserverSendAsset(req, "text/css", xplrHpgCssStart, xplrHpgCssEnd, true, WEBSERVER_CACHE_PAGE, &etag);
+
     if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp type for css");
+        XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to xplrHpg css get request");
     } else {
-        ret = httpd_resp_send(req, (const char *)xplrHpgCssStart, pageSize);
+        XPLRWIFIWEBSERVER_CONSOLE(D, "Responded to xplrHpg css get request, ok");
+    }
+
+    return ret;
+}
+
+/**
+ * Firmware upload, the request body is a signed image (see xplr_ota_stream.h)
+ * e.g. curl --data-binary @image.bin http://<device>/ota
+ * Written to flash while it is received, the device restarts into it when valid.
+ */
+static esp_err_t otaPostHandler(httpd_req_t *req)
+{
+    size_t remaining = req->content_len;
+    uint8_t timeouts = 0;
+    int len;
+    xplrOta_error_t otaRet;
+    esp_err_t ret;
+
+    XPLRWIFIWEBSERVER_CONSOLE(I, "Firmware upload of %u bytes", (unsigned)req->content_len);
+    otaRet = xplrOtaBegin();
+    while ((otaRet == XPLR_OTA_OK) && (remaining > 0)) {
+        len = httpd_req_recv(req,
+                             (char *)webserver.otaBuf,
+                             MIN(remaining, sizeof(webserver.otaBuf)));
+        if ((len == HTTPD_SOCK_ERR_TIMEOUT) && (++timeouts < WEBSERVER_OTA_TIMEOUTS_MAX)) {
+            // try again
+        } else if (len <= 0) {
+            XPLRWIFIWEBSERVER_CONSOLE(E, "Firmware upload interrupted, %u bytes missing", (unsigned)remaining);
+            xplrOtaAbort();
+            otaRet = XPLR_OTA_ERROR;
+        } else {
+            timeouts = 0;
+            remaining -= len;
+            otaRet = xplrOtaWrite(webserver.otaBuf, len);
+        }
+    }
+    if (otaRet == XPLR_OTA_OK) {
+        otaRet = xplrOtaEnd();
+    }
+
+    switch (otaRet) {
+        case XPLR_OTA_OK:
+            ret = httpd_resp_send(req, "Firmware updated, restarting", HTTPD_RESP_USE_STRLEN);
+            if (xplrOtaRestart(WEBSERVER_OTA_RESTART_MS) != XPLR_OTA_OK) {
+                XPLRWIFIWEBSERVER_CONSOLE(E, "Restart the device to run the new firmware");
+            }
+            break;
+        case XPLR_OTA_BUSY:
+            ret = httpd_resp_set_status(req, "409 Conflict");
+            if (ret == ESP_OK) {
+                ret = httpd_resp_send(req, "Firmware update already in progress", HTTPD_RESP_USE_STRLEN);
+            }
+            break;
+        case XPLR_OTA_NOT_INIT:
+            ret = httpd_resp_set_status(req, "503 Service Unavailable");
+            if (ret == ESP_OK) {
+                ret = httpd_resp_send(req, "Firmware update not available", HTTPD_RESP_USE_STRLEN);
+            }
+            break;
+        default:
+            ret = httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Firmware image rejected");
+            break;
     }
 
     if (ret != ESP_OK) {
-        XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to xplrHpg css get request");
+        XPLRWIFIWEBSERVER_CONSOLE(E, "Error responding to firmware upload");
     } else {
-        XPLRWIFIWEBSERVER_CONSOLE(D, "Responded to xplrHpg css get request, ok");
+        XPLRWIFIWEBSERVER_CONSOLE(D, "Responded to firmware upload (%d)", otaRet);
     }
 
     return ret;
@@ -762,6 +875,83 @@ esp_err_t error404Handler(httpd_req_t *req, httpd_err_code_t err)
     return ret;
 }
 
+static esp_err_t webserverSendAsset(httpd_req_t *req,
+                                    const char *type,
+                                    const unsigned char *start,
+                                    const unsigned char *end,
+                                    bool gzipped,
+                                    const char *cacheControl,
+                                    uint32_t *etag)
+{
+    esp_err_t ret;
+    const size_t assetSize = (end - start);
+    char etagStr[WEBSERVER_ETAG_SIZE];
+    char ifNoneMatch[WEBSERVER_IF_NONE_MATCH_MAX];
+    bool notModified = false;
+
+    /* embedded assets never change at runtime, hash them once on first request */
+    if (*etag == 0) {
+        *etag = webserverAssetEtag(start, assetSize);
+    } else {
+        // Do nothing
+    }
+    snprintf(etagStr, sizeof(etagStr), "\"%08x\"", (unsigned int)*etag);
+
+    if (httpd_req_get_hdr_value_str(req,
+                                    "If-None-Match",
+                                    ifNoneMatch,
+                                    sizeof(ifNoneMatch)) == ESP_OK) {
+        notModified = (strstr(ifNoneMatch, etagStr) != NULL);
+    } else {
+        // Do nothing
+    }
+
+    ret = httpd_resp_set_type(req, type);
+    if (ret == ESP_OK) {
+        ret = httpd_resp_set_hdr(req, "Cache-Control", cacheControl);
+    }
+    if (ret == ESP_OK) {
+        ret = httpd_resp_set_hdr(req, "ETag", etagStr);
+    }
+    if ((ret == ESP_OK) && gzipped && !notModified) {
+        ret = httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+
+    if (ret != ESP_OK) {
+        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not set rsp headers for %s", req->uri);
+    } else if (notModified) {
+        ret = httpd_resp_set_status(req, "304 Not Modified");
+        if (ret == ESP_OK) {
+            ret = httpd_resp_send(req, NULL, 0);
+        }
+        XPLRWIFIWEBSERVER_CONSOLE(D, "%s not modified", req->uri);
+    } else {
+        ret = httpd_resp_send(req, (const char *)start, assetSize);
+    }
+
+    return ret;
+}
+
+static uint32_t webserverAssetEtag(const unsigned char *start, size_t size)
+{
+    /* FNV-1a, good enough to tell embedded asset revisions apart */
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= start[i];
+        hash *= 16777619U;
+    }
+
+    /* 0 marks a not yet computed ETag */
+    if (hash == 0) {
+        hash = 1;
+    } else {
+        // Do nothing
+    }
+
+    return hash;
+}
+
 static bool xplrHpgThingstreamCredsConfigured(void)
 {
     int res[6];
@@ -1046,6 +1236,11 @@ static esp_err_t wsParseData(httpd_req_t *req, uint8_t *data)
                               strlen("dvcLocation")) == 0) {
                 reqType = XPLR_WEBSERVER_WSREQ_LOCATION;
                 break;
+            } else if (memcmp(reqValue,
+                              "dvcTelemetry",
+                              strlen("dvcTelemetry")) == 0) {
+                reqType = XPLR_WEBSERVER_WSREQ_TELEMETRY;
+                break;
             } else if (memcmp(reqValue,
                               "dvcMessage",
                               strlen("dvcMessage")) == 0) {
@@ -1208,13 +1403,15 @@ static esp_err_t wsServeReq(httpd_req_t *req, xplrWifiWebserverWsReqType_t type)
             break;
         case XPLR_WEBSERVER_WSREQ_SCAN:
             XPLRWIFIWEBSERVER_CONSOLE(D, "Websocket device SSID scan request received, creating response");
+            /* served from the scan cache, the page asks again while a scan is running */
             ret = xplrWifiStarterScanNetwork(&webserver.wsData->wifiScan);
-            if (ret != ESP_OK) {
+            if ((ret != ESP_OK) && (ret != ESP_ERR_NOT_FINISHED)) {
                 XPLRWIFIWEBSERVER_CONSOLE(W, "Failed to scan network");
             } else {
                 wsOut = cJSON_CreateObject();
                 if (wsOut != NULL) {
                     cJSON_AddStringToObject(wsOut, "rsp", "dvcSsidScan");
+                    cJSON_AddBoolToObject(wsOut, "scanning", webserver.wsData->wifiScan.scanning);
                     array = cJSON_AddArrayToObject(wsOut, "scan");
                     for (int i = 0; i < webserver.wsData->wifiScan.found; i++) {
                         element = cJSON_CreateString(&webserver.wsData->wifiScan.name[i][0]);
@@ -1264,6 +1461,9 @@ static esp_err_t wsServeReq(httpd_req_t *req, xplrWifiWebserverWsReqType_t type)
                 ret = ESP_OK;
             }
             break;
+        case XPLR_WEBSERVER_WSREQ_TELEMETRY:
+            ret = telemetrySubscribe(req);
+            break;
         case XPLR_WEBSERVER_WSREQ_WIFI_SET:
         case XPLR_WEBSERVER_WSREQ_ROOTCA_SET:
         case XPLR_WEBSERVER_WSREQ_PPID_SET:
@@ -1288,3 +1488,224 @@ static esp_err_t wsServeReq(httpd_req_t *req, xplrWifiWebserverWsReqType_t type)
 
     return ret;
 }
+
+static void wsSessionClose(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+
+    for (uint8_t i = 0; i < telemetry.subscribers; i++) {
+        if (telemetry.fds[i] == sockfd) {
+            telemetryUnsubscribe(i);
+            break;
+        }
+    }
+
+    /* a custom close callback has to close the socket itself */
+    close(sockfd);
+}
+
+static esp_err_t telemetryStart(void)
+{
+    const esp_timer_create_args_t timerArgs = {
+        .callback = telemetryTimerCb,
+        .name = "wsTelemetry"
+    };
+    esp_err_t ret;
+
+    telemetry.subscribers = 0;
+    telemetry.pushPending = false;
+    if (telemetry.timer == NULL) {
+        ret = esp_timer_create(&timerArgs, &telemetry.timer);
+    } else {
+        ret = ESP_OK;
+    }
+
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(telemetry.timer, XPLRWIFIWEBSERVER_TELEMETRY_PERIOD_MS * 1000U);
+    }
+
+    if (ret != ESP_OK) {
+        XPLRWIFIWEBSERVER_CONSOLE(E, "Could not start telemetry timer: %s", esp_err_to_name(ret));
+    }
+
+    return ret;
+}
+
+static void telemetryStop(void)
+{
+    if (telemetry.timer != NULL) {
+        (void)esp_timer_stop(telemetry.timer);
+    } else {
+        // do nothing
+    }
+}
+
+/**
+ * Runs in the esp_timer task: only hands the push over to the server task,
+ * which owns the sockets and the subscriber table.
+ */
+static void telemetryTimerCb(void *arg)
+{
+    (void)arg;
+
+    /* a push still pending means clients are slow, this period is skipped */
+    if (webserver.running && telemetry.valid && (telemetry.subscribers > 0) && !telemetry.pushPending) {
+        telemetry.pushPending = true;
+        if (httpd_queue_work(webserver.instance, telemetryPush, NULL) != ESP_OK) {
+            telemetry.pushPending = false;
+        }
+    } else {
+        // do nothing
+    }
+}
+
+static void telemetryPush(void *arg)
+{
+    httpd_ws_frame_t frame;
+    uint8_t i = 0;
+    int fd;
+    esp_err_t err;
+
+    (void)arg;
+    memset(&frame, 0, sizeof(httpd_ws_frame_t));
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *)telemetry.frame;
+    frame.len = telemetryEncode(telemetry.frame, sizeof(telemetry.frame));
+
+    while ((frame.len > 0) && (i < telemetry.subscribers)) {
+        fd = telemetry.fds[i];
+        if (httpd_ws_get_fd_info(webserver.instance, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            telemetryUnsubscribe(i);
+        } else if (!telemetryWritable(fd)) {
+            /* sending now would block every other client until the send timeout */
+            telemetry.misses[i]++;
+            if (telemetry.misses[i] >= WEBSERVER_TELEMETRY_MISSES) {
+                XPLRWIFIWEBSERVER_CONSOLE(W, "Telemetry client %d too slow, closing it", fd);
+                (void)httpd_sess_trigger_close(webserver.instance, fd);
+                telemetryUnsubscribe(i);
+            } else {
+                i++;
+            }
+        } else {
+            err = httpd_ws_send_frame_async(webserver.instance, fd, &frame);
+            if (err != ESP_OK) {
+                XPLRWIFIWEBSERVER_CONSOLE(W, "Telemetry send to client %d failed, closing it", fd);
+                (void)httpd_sess_trigger_close(webserver.instance, fd);
+                telemetryUnsubscribe(i);
+            } else {
+                telemetry.misses[i] = 0;
+                i++;
+            }
+        }
+    }
+
+    telemetry.pushPending = false;
+}
+
+/**
+ * Compact json of the snapshot, values are kept in their integer units.
+ * Returns the length of the frame, 0 if it did not fit.
+ */
+static size_t telemetryEncode(char *buf, size_t size)
+{
+    xplrWifiWebServerDataTelemetry_t data;
+    long long correctionAge;
+    int len;
+    size_t ret;
+
+    portENTER_CRITICAL(&telemetry.lock);
+    memcpy(&data, &telemetry.data, sizeof(xplrWifiWebServerDataTelemetry_t));
+    portEXIT_CRITICAL(&telemetry.lock);
+
+    /* computed per push so that it keeps growing when corrections stop */
+    if (data.correctionTime > 0) {
+        correctionAge = (long long)((esp_timer_get_time() - data.correctionTime) / 1000);
+    } else {
+        correctionAge = -1;
+    }
+
+    len = snprintf(buf,
+                   size,
+                   "{\"rsp\":\"dvcTelemetry\",\"lat\":%d,\"lon\":%d,\"alt\":%d,\"spd\":%d,"
+                   "\"acc\":%u,\"fix\":%d,\"utc\":%lld,\"cAge\":%lld,\"mqtt\":[%u,%u]",
+                   (int)data.latitudeX1e7,
+                   (int)data.longitudeX1e7,
+                   (int)data.altitudeMm,
+                   (int)data.speedMmPerSec,
+                   (unsigned int)data.accuracy,
+                   (int)data.fixType,
+                   (long long)data.timeUtc,
+                   correctionAge,
+                   (unsigned int)data.mqttMsgs,
+                   (unsigned int)data.mqttBytes);
+
+    if ((len > 0) && ((size_t)len < size) && data.btEnabled) {
+        len += snprintf(&buf[len],
+                        size - len,
+                        ",\"bt\":[%u,%u,%u]",
+                        (unsigned int)data.btDevices,
+                        (unsigned int)data.btBytesSent,
+                        (unsigned int)data.btMsgsDropped);
+    }
+
+    if ((len > 0) && ((size_t)len < size)) {
+        len += snprintf(&buf[len], size - len, "}");
+    }
+
+    if ((len > 0) && ((size_t)len < size)) {
+        ret = (size_t)len;
+    } else {
+        XPLRWIFIWEBSERVER_CONSOLE(E, "Telemetry frame does not fit in %u bytes", (unsigned int)size);
+        ret = 0;
+    }
+
+    return ret;
+}
+
+static esp_err_t telemetrySubscribe(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+    bool found = false;
+    esp_err_t ret;
+
+    for (uint8_t i = 0; i < telemetry.subscribers; i++) {
+        if (telemetry.fds[i] == fd) {
+            found = true;
+            break;
+        }
+    }
+
+    if (found) {
+        ret = ESP_OK;
+    } else if (telemetry.subscribers < XPLR_WIFIWEBSERVER_SOCKETS_OPEN_MAX) {
+        telemetry.fds[telemetry.subscribers] = fd;
+        telemetry.misses[telemetry.subscribers] = 0;
+        telemetry.subscribers++;
+        XPLRWIFIWEBSERVER_CONSOLE(D, "Telemetry client %d subscribed (%u)", fd, telemetry.subscribers);
+        ret = ESP_OK;
+    } else {
+        XPLRWIFIWEBSERVER_CONSOLE(W, "Telemetry subscribers full");
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
+static void telemetryUnsubscribe(uint8_t index)
+{
+    /* order does not matter, the last one takes the freed slot */
+    telemetry.subscribers--;
+    telemetry.fds[index] = telemetry.fds[telemetry.subscribers];
+    telemetry.misses[index] = telemetry.misses[telemetry.subscribers];
+}
+
+static bool telemetryWritable(int fd)
+{
+    fd_set writeSet;
+    struct timeval timeout = {0, 0};
+
+    FD_ZERO(&writeSet);
+    FD_SET(fd, &writeSet);
+
+    return (select(fd + 1, NULL, &writeSet, NULL, &timeout) > 0);
+}
@@ -330,6 +330,8 @@ TaskHandle_t cardDetectTaskHandler;
 int32_t cellReboots = 0;    /**< Count of total reboots of the cellular module */
 static bool failedRecover = false;
 static bool enableLband = false;
+/* Running on a ZTP result stored by a previous run, until the broker accepts it */
+static bool ztpFromStorage = false;
 static char *configData = ztpPayload;
 /* The name of the configuration file */
 static char configFilename[] = "xplr_config.json";
@@ -391,6 +393,10 @@ static app_error_t thingstreamInit(const char *token, xplr_thingstream_t *instan
 /* update mqtt client with new parameters obtained from ztp response */
 static void thingstreamUpdateMqttClient(xplr_thingstream_t *instance,
                                         xplrCell_mqtt_client_t *client);
+/* load the PointPerfect credentials stored by a previous ztp */
+static app_error_t thingstreamLoadStoredCreds(void);
+/* drop stored PointPerfect credentials the broker did not accept */
+static void thingstreamDropStoredCreds(void);
 /* initialize the GNSS module */
 static app_error_t gnssInit(void);
 /* initialize the LBand module */
@@ -560,15 +566,25 @@ void app_main(void)
                 configCellHttpSettings(&httpClient);
                 cellHttpClientSetServer(urlAwsRootCa, XPLR_CELL_HTTP_CERT_METHOD_NONE, true);
                 app.error = thingstreamInit(ztpPpToken, &thingstreamSettings);
-                if (app.error == APP_ERROR_OK) {
-                    httpClient.credentials.rootCa = thingstreamSettings.server.rootCa;
-                    app.error = cellHttpClientConnect();
-                }
-
-                if (app.error == APP_ERROR_OK) {
-                    app.state[0] = APP_FSM_GET_ROOT_CA;
+                if ((app.error == APP_ERROR_OK) && (thingstreamLoadStoredCreds() == APP_ERROR_OK)) {
+                    /* credentials of a previous ZTP, skip the root CA and ZTP requests */
+                    APP_CONSOLE(I, "Using stored ZTP result, skipping ZTP.");
+                    if (thingstreamSettings.pointPerfect.lbandSupported && (!lbandConfigured) && enableLband) {
+                        app.state[0] = APP_FSM_CONFIG_LBAND;
+                    } else {
+                        app.state[0] = APP_FSM_INIT_MQTT_CLIENT;
+                    }
                 } else {
-                    app.state[0] = APP_FSM_ERROR;
+                    if (app.error == APP_ERROR_OK) {
+                        httpClient.credentials.rootCa = thingstreamSettings.server.rootCa;
+                        app.error = cellHttpClientConnect();
+                    }
+
+                    if (app.error == APP_ERROR_OK) {
+                        app.state[0] = APP_FSM_GET_ROOT_CA;
+                    } else {
+                        app.state[0] = APP_FSM_ERROR;
+                    }
                 }
                 break;
             case APP_FSM_GET_ROOT_CA:
@@ -610,6 +626,11 @@ void app_main(void)
                 app.error = cellHttpClientApplyThingstreamCreds();
                 if (app.error == APP_ERROR_OK) {
                     XPLR_CI_CONSOLE(2308, "OK");
+                    if (xplrThingstreamPpCacheSave(&thingstreamSettings,
+                                                   ppRegion,
+                                                   (bool)gnssCorrSrc) != XPLR_THINGSTREAM_OK) {
+                        APP_CONSOLE(W, "ZTP result not stored, ZTP will run on next boot.");
+                    }
                     if (thingstreamSettings.pointPerfect.lbandSupported && (!lbandConfigured) && enableLband) {
                         app.state[0] = APP_FSM_CONFIG_LBAND;
                     } else {
@@ -656,6 +677,10 @@ void app_main(void)
                         XPLR_CI_CONSOLE(2310, "OK");
                         mqttDataFetchedInitial = false;
                     }
+                    if (ztpFromStorage && (mqttClient.fsm[0] == XPLR_CELL_MQTT_CLIENT_FSM_READY)) {
+                        /* the broker accepted the stored credentials */
+                        ztpFromStorage = false;
+                    }
                 } else {
                     if (MICROTOSEC(esp_timer_get_time() - app.stats.gnssLastAction) >= APP_INACTIVITY_TIMEOUT) {
                         app.state[1] = app.state[0];
@@ -664,7 +689,11 @@ void app_main(void)
                     }
                 }
 
-                if (app.error != APP_ERROR_OK) {
+                if ((app.error == APP_ERROR_MQTT_CLIENT) && ztpFromStorage) {
+                    /* the stored credentials never connected, run ZTP again */
+                    thingstreamDropStoredCreds();
+                    app.state[0] = APP_FSM_INIT_HTTP_CLIENT;
+                } else if (app.error != APP_ERROR_OK) {
                     app.state[0] = APP_FSM_ERROR;
                 } else {
                     /* fwd msg to GNSS */
@@ -1464,6 +1493,36 @@ static app_error_t thingstreamInit(const char *token, xplr_thingstream_t *instan
     return ret;
 }
 
+static app_error_t thingstreamLoadStoredCreds(void)
+{
+    xplr_thingstream_error_t tsErr;
+    app_error_t ret;
+
+    tsErr = xplrThingstreamPpCacheLoad(&thingstreamSettings, ppRegion, (bool)gnssCorrSrc);
+    if ((tsErr != XPLR_THINGSTREAM_OK) || (thingstreamSettings.server.rootCa[0] == 0)) {
+        ztpFromStorage = false;
+        ret = APP_ERROR_THINGSTREAM;
+    } else {
+        if (thingstreamSettings.pointPerfect.lbandSupported) {
+            enableLband = (bool)gnssCorrSrc;
+        }
+        thingstreamUpdateMqttClient(&thingstreamSettings, &mqttClient);
+        ztpFromStorage = true;
+        ret = APP_ERROR_OK;
+    }
+
+    return ret;
+}
+
+static void thingstreamDropStoredCreds(void)
+{
+    APP_CONSOLE(W, "Broker did not accept the stored ZTP result, running ZTP again.");
+    xplrThingstreamPpCacheInvalidate();
+    xplrCellMqttDeInit(cellConfig.profileIndex, mqttClient.id);
+    memset(&thingstreamSettings, 0x00, sizeof(xplr_thingstream_t));
+    ztpFromStorage = false;
+}
+
 static void thingstreamUpdateMqttClient(xplr_thingstream_t *instance,
                                         xplrCell_mqtt_client_t *client)
 {
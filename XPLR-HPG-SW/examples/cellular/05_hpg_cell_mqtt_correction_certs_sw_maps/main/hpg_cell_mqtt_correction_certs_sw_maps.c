@@ -111,6 +111,11 @@
  */
 #define APP_BT_BUFFER_SIZE XPLRBLUETOOTH_MAX_MSG_SIZE * XPLRBLUETOOTH_NUMOF_DEVICES
 
+/**
+ * The size of the Bluetooth NMEA stream buffer (fits several 10 Hz epochs of full NMEA)
+ */
+#define APP_BT_STREAM_BUFFER_SIZE (4U * 1024U)
+
 #define APP_SD_HOT_PLUG_FUNCTIONALITY   (1U) & APP_SD_LOGGING_ENABLED   /* Option to enable/disable the hot plug functionality for the SD card */
 #define APP_RESTART_ON_ERROR            (1U)                            /* Trigger soft reset if device in error state*/
 
@@ -361,6 +366,7 @@ xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\
 xplrBluetooth_client_t xplrBtClient;
 SemaphoreHandle_t btSemaphore;
 char xplrBluetoothMessageBuffer[APP_BT_BUFFER_SIZE];
+static uint8_t xplrBluetoothStreamBuffer[APP_BT_STREAM_BUFFER_SIZE] __attribute__((aligned(4)));
 xplrBluetooth_error_t btError;
 bool btIsInit = false;
 static uint64_t timePrevLoc;
@@ -438,6 +444,7 @@ static void gnssLocationPrint(void);
 static void initBt(void);
 /* sends location data to bluetooth connected device */
 static void appSendLocationToBt(uint8_t periodSecs);
+static void appGnssToBtSink(uGnssProtocol_t protocol, const char *msg, size_t size, void *arg);
 #if 1 == APP_PRINT_IMU_DATA
 /* print dead reckoning info to console */
 static void gnssDeadReckoningPrint(void);
@@ -1267,30 +1274,45 @@ static void initBt(void)
                       btSemaphore,
                       xplrBluetoothMessageBuffer,
                       APP_BT_BUFFER_SIZE);
+    btError = xplrBluetoothStreamStart(xplrBluetoothStreamBuffer, APP_BT_STREAM_BUFFER_SIZE);
+    if (btError != XPLR_BLUETOOTH_OK) {
+        APP_CONSOLE(W, "Could not start Bluetooth NMEA stream!");
+    } else if (xplrGnssSetRawMsgSink(gnssDvcPrfId, appGnssToBtSink, NULL) != ESP_OK) {
+        APP_CONSOLE(W, "Could not forward GNSS messages to Bluetooth!");
+    } else {
+        // Do nothing
+    }
 }
 
 /**
- * Prints location in console and sends to SW maps via Bt
+ * Forwards every NMEA sentence read by the GNSS asyncs to the Bluetooth stream.
+ * Runs in the GNSS callback context, xplrBluetoothStreamPush never blocks.
+ */
+static void appGnssToBtSink(uGnssProtocol_t protocol, const char *msg, size_t size, void *arg)
+{
+    if (protocol == U_GNSS_PROTOCOL_NMEA) {
+        (void)xplrBluetoothStreamPush(msg, size);
+    }
+}
+
+/**
+ * Reports the NMEA stream sent to SW maps via Bt
  */
 static void appSendLocationToBt(uint8_t periodSecs)
 {
-    char GgaMsg[256];
-    char *GgaMsgPtr = GgaMsg;
-    char **GgaMsgPtrPtr = &GgaMsgPtr;
-    int32_t len;
+    xplrBluetooth_stream_stats_t btStats;
 
     if ((MICROTOSEC(esp_timer_get_time()) - timePrevLoc >= periodSecs)) {
         switch (xplrBluetoothGetState()) {
             case XPLR_BLUETOOTH_CONN_STATE_CONNECTED:
-                len = xplrGnssGetGgaMessage(0, GgaMsgPtrPtr, ELEMENTCNT(GgaMsg));
-                btError = xplrBluetoothWrite(&xplrBtClient.devices[0], GgaMsg, len);
-                if (btError != XPLR_BLUETOOTH_OK) {
-                    APP_CONSOLE(W, "Couldn't send location to Bluetooth device with handle -> [%d]",
-                                xplrBtClient.devices[0].handle);
-                } else {
-                    APP_CONSOLE(I, "Sent location successfully to Bluetooth device with handle -> [%d]",
-                                xplrBtClient.devices[0].handle);
-                }
+            case XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE:
+                // NMEA is streamed from the GNSS asyncs, only report how the stream is doing
+                xplrBluetoothStreamGetStats(&btStats);
+                APP_CONSOLE(I,
+                            "Bluetooth stream: queued [%u] dropped [%u] sent [%u] bytes",
+                            btStats.msgsQueued,
+                            btStats.msgsDropped,
+                            btStats.bytesSent);
                 break;
             case XPLR_BLUETOOTH_CONN_STATE_READY:
                 APP_CONSOLE(D, "No bluetooth device connected");
@@ -1486,6 +1508,7 @@ static app_error_t appTerminate(void)
     uint64_t startTime;
     xplrCell_mqtt_error_t err;
 
+    xplrGnssSetRawMsgSink(gnssDvcPrfId, NULL, NULL);
     xplrBluetoothDeInit();
 
     err = xplrCellMqttUnsubscribeFromTopicList(cellConfig.profileIndex, 0);
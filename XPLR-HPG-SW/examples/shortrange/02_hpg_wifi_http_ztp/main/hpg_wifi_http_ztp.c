@@ -203,6 +203,7 @@ static esp_err_t appInitBoard(void);
 static void appInitWiFi(void);
 static esp_err_t appGetRootCa(void);
 static void appApplyThingstreamCreds(void);
+static void appReleaseZtpPayload(void);
 static void appHaltExecution(void);
 #if (APP_SD_HOT_PLUG_FUNCTIONALITY == 1)
 static void appInitHotPlugTask(void);
@@ -276,6 +277,7 @@ void app_main(void)
                                     XPLR_CI_CONSOLE(204, "ERROR");
                                 }
                             }
+                            appReleaseZtpPayload();
                         } else {
                             APP_CONSOLE(E, "Error in fetching Root CA certificate");
                             XPLR_CI_CONSOLE(203, "ERROR");
@@ -688,6 +690,17 @@ static void appApplyThingstreamCreds(void)
     }
 }
 
+/**
+ * Function that releases a ZTP payload moved to the heap and
+ * gets back to the payload buffer for the next request
+*/
+static void appReleaseZtpPayload(void)
+{
+    xplrZtpFreePayload(&ztpData);
+    ztpData.payload = payload;
+    ztpData.payloadLength = APP_ZTP_PAYLOAD_BUF_SIZE;
+}
+
 /**
  * CALLBACK FUNCTION
 */
@@ -1318,6 +1318,15 @@ static void appPrintLocation(uint8_t periodSecs)
                     XPLR_CI_CONSOLE(10, "OK");
                 }
             }
+            /* Follow the vehicle to the LBAND beam of the region it is in */
+            if (enableLband && (locData.locFixType != XPLR_GNSS_LOCFIX_INVALID)) {
+                espRet = xplrLbandSelectRegionByLocation(lbandDvcPrfId,
+                                                         locData.location.latitudeX1e7,
+                                                         locData.location.longitudeX1e7);
+                if (espRet == ESP_FAIL) {
+                    APP_CONSOLE(W, "Could not switch LBAND region!");
+                }
+            }
             espRet = xplrGnssPrintLocationData(&locData);
             if (espRet != ESP_OK) {
                 APP_CONSOLE(W, "Could not print gnss location data!");
@@ -99,6 +99,11 @@
  */
 #define APP_INACTIVITY_TIMEOUT          30
 
+/**
+ * Period in seconds to check if the stored ZTP result is close to expiry
+ */
+#define APP_ZTP_REFRESH_CHECK_PERIOD    60
+
 /*
  * Button for shutting down device
  */
@@ -303,9 +308,11 @@ xplrMqttWifiPayload_t mqttMessage = {
  */
 static bool requestDc;
 static bool gotZtp;
+static bool ztpFromStorage = false;
 static bool isNeededTopic;
 static bool deviceOffRequested = false;
 static bool isPlanLband = false;
+static bool lbandStarted = false;
 
 /**
  * Stack pointer used in HTTP response callback
@@ -363,6 +370,9 @@ static void appInitGnssDevice(void);
 static void appInitLbandDevice(void);
 static esp_err_t appGetRootCa(void);
 static esp_err_t appApplyThingstreamCreds(void);
+static esp_err_t appLoadStoredCreds(void);
+static void appRefreshStoredCreds(void);
+static void appReleaseZtpPayload(void);
 static void appMqttInit(void);
 static void appPrintLocation(uint8_t periodSecs);
 #if 1 == APP_PRINT_IMU_DATA
@@ -495,6 +505,11 @@ void app_main(void)
                     APP_CONSOLE(E, "Error in Thingstream configuration");
                     XPLR_CI_CONSOLE(405, "ERROR");
                     appHaltExecution();
+                } else if (appLoadStoredCreds() == ESP_OK) {
+                    XPLR_CI_CONSOLE(405, "OK");
+                    /* credentials of a previous ZTP, connect straight to the broker */
+                    gotZtp = true;
+                    APP_CONSOLE(I, "Using stored ZTP result, skipping ZTP.");
                 } else {
                     XPLR_CI_CONSOLE(405, "OK");
                     espRet = appGetRootCa();
@@ -519,8 +534,14 @@ void app_main(void)
                             } else {
                                 gotZtp = true;
                                 APP_CONSOLE(I, "ZTP Successful!");
+                                if (xplrThingstreamPpCacheSave(&thingstreamSettings,
+                                                               ppRegion,
+                                                               (bool)gnssCorrSrc) != XPLR_THINGSTREAM_OK) {
+                                    APP_CONSOLE(W, "ZTP result not stored, ZTP will run on next boot.");
+                                }
                             }
                         }
+                        appReleaseZtpPayload();
                     }
                 }
                 /**
@@ -534,9 +555,14 @@ void app_main(void)
 
                 if (thingstreamSettings.pointPerfect.lbandSupported) {
                     isPlanLband = (bool)gnssCorrSrc;
-                    if (isPlanLband) {
-                        /* We have Lband support, so we need to initialize the module */
+                    if (isPlanLband && !lbandStarted) {
+                        /**
+                         * We have Lband support, so we need to initialize the module.
+                         * Only once, ZTP and MQTT run again on Wi-Fi reconnects and
+                         * rejected credentials while the module keeps forwarding.
+                         */
                         appInitLbandDevice();
+                        lbandStarted = true;
                     }
                     if (!thingstreamSettings.pointPerfect.mqttSupported) {
                         appMqttInit();
@@ -556,6 +582,21 @@ void app_main(void)
             XPLR_CI_CONSOLE(409, "ERROR");
         }
 
+        /**
+         * The broker refused the stored credentials. Drop them and run ZTP
+         * again, which also restarts the MQTT client.
+         */
+        if (ztpFromStorage && mqttClient.ucd.credentialsRejected) {
+            APP_CONSOLE(W, "Broker rejected the stored ZTP result, running ZTP again.");
+            xplrThingstreamPpCacheInvalidate();
+            if (mqttClient.handler != NULL) {
+                xplrMqttWifiHardDisconnect(&mqttClient);
+            }
+            mqttClient.ucd.credentialsRejected = false;
+            ztpFromStorage = false;
+            gotZtp = false;
+        }
+
         switch (xplrMqttWifiGetCurrentState(&mqttClient)) {
             /**
              * Subscribe to some topics
@@ -655,6 +696,7 @@ void app_main(void)
                 } else if (mqttGetItemErr == XPLR_MQTTWIFI_ITEM_ERROR) {
                     XPLR_CI_CONSOLE(411, "ERROR");
                 }
+                appRefreshStoredCreds();
                 break;
             case XPLR_MQTTWIFI_STATE_DISCONNECTED_OK:
                 // We have a disconnect event (probably from the watchdog). Let's reconnect
@@ -1403,6 +1445,76 @@ static esp_err_t appApplyThingstreamCreds(void)
     return espRet;
 }
 
+/**
+ * Function that loads the Thingstream credentials stored by a previous ZTP
+*/
+static esp_err_t appLoadStoredCreds(void)
+{
+    esp_err_t espRet;
+    xplr_thingstream_error_t tsErr;
+
+    tsErr = xplrThingstreamPpCacheLoad(&thingstreamSettings, ppRegion, (bool)gnssCorrSrc);
+    if ((tsErr != XPLR_THINGSTREAM_OK) || (thingstreamSettings.server.rootCa[0] == 0)) {
+        ztpFromStorage = false;
+        espRet = ESP_FAIL;
+    } else {
+        ztpFromStorage = true;
+        espRet = ESP_OK;
+    }
+    return espRet;
+}
+
+/**
+ * Function that runs ZTP again when the dynamic keys of the credentials
+ * are about to expire, while corrections keep flowing.
+ * The new result is stored and used from the next connection on.
+*/
+static void appRefreshStoredCreds(void)
+{
+    static uint64_t lastCheck = 0;
+    esp_err_t espRet;
+    uint64_t nowMs = 0;
+
+    if ((lastCheck == 0) ||
+        (MICROTOSEC(esp_timer_get_time() - lastCheck) >= APP_ZTP_REFRESH_CHECK_PERIOD)) {
+        lastCheck = esp_timer_get_time();
+
+        /* the GNSS knows the time, even before the clock of the board is set */
+        if ((xplrGnssGetLocationData(gnssDvcPrfId, &locData) == ESP_OK) &&
+            (locData.location.timeUtc > 0)) {
+            nowMs = (uint64_t)locData.location.timeUtc * 1000ULL;
+        }
+
+        if (xplrThingstreamPpCacheNeedsRefresh(&thingstreamSettings, nowMs) &&
+            (xplrThingstreamInit(tsPpZtpToken, &thingstreamSettings) == XPLR_THINGSTREAM_OK)) {
+            espRet = xplrZtpGetPayloadWifi(&thingstreamSettings, &ztpData);
+            if ((espRet == ESP_OK) && (appApplyThingstreamCreds() == ESP_OK)) {
+                if (xplrThingstreamPpCacheSave(&thingstreamSettings,
+                                               ppRegion,
+                                               (bool)gnssCorrSrc) == XPLR_THINGSTREAM_OK) {
+                    APP_CONSOLE(I, "ZTP result refreshed.");
+                } else {
+                    APP_CONSOLE(W, "ZTP result refreshed but not stored, ZTP will run on next boot.");
+                }
+            } else {
+                APP_CONSOLE(W, "ZTP refresh failed, will retry in %ds.", APP_ZTP_REFRESH_CHECK_PERIOD);
+            }
+            appReleaseZtpPayload();
+        }
+    }
+}
+
+/**
+ * Function that releases a ZTP payload moved to the heap and
+ * gets back to the payload buffer for the next request
+*/
+static void appReleaseZtpPayload(void)
+{
+    xplrZtpFreePayload(&ztpData);
+    ztpData.payload = ztpPostPayload;
+    ztpData.payloadLength = APP_ZTP_PAYLOAD_BUF_SIZE;
+}
+
 /**
  * Populate some example settings
  */
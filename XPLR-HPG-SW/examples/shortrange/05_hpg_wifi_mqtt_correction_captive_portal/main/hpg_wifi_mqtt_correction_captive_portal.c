@@ -31,6 +31,7 @@
  */
 
 #include <stdio.h>
+#include <sys/stat.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -47,6 +48,7 @@
 #include "./../../../../components/hpglib/xplr_hpglib_cfg.h"
 #include "./../../../components/hpglib/src/location_service/gnss_service/xplr_gnss.h"
 #include "./../../../components/hpglib/src/location_service/lband_service/xplr_lband.h"
+#include "./../../../components/hpglib/src/ota_service/xplr_ota.h"
 #include "./../../../components/hpglib/src/common/xplr_common.h"
 #if defined(XPLR_BOARD_SELECTED_IS_C214)
 #include "./../../../../../components/boards/xplr-hpg2-c214/board.h"
@@ -94,6 +96,10 @@
 #define APP_INACTIVITY_TIMEOUT      (30)                            /* Time in seconds to trigger an inactivity timeout and cause a restart */
 #define APP_RESTART_ON_ERROR        (1U)                            /* Trigger soft reset if device in error state */
 #define APP_SD_DETECT_UPDATE_PERIOD (1U)                            /* Seconds to update the SD detect pin value */
+#define APP_OTA_SD_IMAGE            "update.ota"                    /* Signed firmware image applied from the SD card at boot */
+#define APP_OTA_SD_IMAGE_DONE       "update.ota.done"               /* Name given to the SD card image once applied */
+#define APP_OTA_SD_IMAGE_BAD        "update.ota.bad"                /* Name given to the SD card image when rejected */
+#define APP_OTA_RESTART_MS          (1000U)                         /* Delay before restarting into a firmware from the SD card */
 #if 1 == APP_PRINT_IMU_DATA
 #define APP_DEADRECK_PRINT_PERIOD   (10U)                           /* Seconds to print dead reckoning */
 #endif
@@ -145,6 +151,7 @@ typedef struct appHpg_type {
     xplrGnssImuVehDynMeas_t imuVehicleDynamics;
     xplrGnssStates_t gnssState;
     xplrGnssLocation_t location;
+    xplrWifiWebServerDataTelemetry_t telemetry;   /**< Telemetry pushed to the live tracker */
 } appHpg_t;
 
 /* ----------------------------------------------------------------
@@ -153,6 +160,12 @@ typedef struct appHpg_type {
 
 static const char mqttHost[] = "mqtts://pp.services.u-blox.com";
 
+/*
+ * Public key that firmware updates must be signed with, see ota_service README.
+ * Replace ota_key_pub.pem with the public key of your own signing key pair.
+ */
+extern const uint8_t otaPublicKeyStart[] asm("_binary_ota_key_pub_pem_start");
+
 /*
  * Fill this struct with your desired settings and try to connect
  * This is used only if you wish to override the setting from KConfig
@@ -229,6 +242,10 @@ static bool cardDetect = false;
 static esp_err_t appInitLogging(void);
 #endif
 static esp_err_t appInitBoard(void);
+static esp_err_t appInitOta(void);
+#if (APP_SD_LOGGING_ENABLED == 1)
+static void appOtaFromSd(void);
+#endif
 static esp_err_t appInitWiFi(void);
 static esp_err_t appInitNvs(void);
 static void appConfigGnssSettings(xplrGnssDeviceCfg_t *cfg);
@@ -297,6 +314,7 @@ void app_main(void)
     }
 #endif
     appInitBoard();
+    appInitOta();
     appInitWiFi();
     appInitNvs();
     appInitGnssDevice();
@@ -372,6 +390,10 @@ void app_main(void)
                         xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_CONFIGURED, (void *)&tVal);
                         APP_CONSOLE(D, "Subscription plan is %s.", plan);
                         APP_CONSOLE(D, "Subscribed to required topics successfully.");
+                        /* connected to the correction service, a new firmware is kept */
+                        if (xplrOtaConfirm() != XPLR_OTA_OK) {
+                            APP_CONSOLE(E, "Failed to confirm the running firmware");
+                        }
                     }
                     break;
                 case XPLR_MQTTWIFI_STATE_SUBSCRIBED:
@@ -386,6 +408,8 @@ void app_main(void)
                         mqttStats[0][0]++;
                         mqttStats[0][1] += mqttMessage.dataLength;
                         snprintf(mqttStatsStr, 64, "Messages: %u (%u bytes)", mqttStats[0][0], mqttStats[0][1]);
+                        hpg.telemetry.mqttMsgs = mqttStats[0][0];
+                        hpg.telemetry.mqttBytes = mqttStats[0][1];
                         xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_MQTTSTATS,
                                                                (void *)mqttStatsStr);
                         tVal = 1;
@@ -428,6 +452,7 @@ void app_main(void)
                                             APP_CONSOLE(E, "Failed to send correction data!");
                                             XPLR_CI_CONSOLE(511, "ERROR");
                                         } else {
+                                            hpg.telemetry.correctionTime = esp_timer_get_time();
                                             if (receivedMqttData == false) {
                                                 XPLR_CI_CONSOLE(511, "OK");
                                                 receivedMqttData = true;
@@ -468,6 +493,7 @@ void app_main(void)
                                         APP_CONSOLE(E, "Failed to send correction data!");
                                         XPLR_CI_CONSOLE(511, "ERROR");
                                     } else {
+                                        hpg.telemetry.correctionTime = esp_timer_get_time();
                                         if (receivedMqttData == false) {
                                             XPLR_CI_CONSOLE(511, "OK");
                                             receivedMqttData = true;
@@ -703,6 +729,58 @@ static esp_err_t appInitBoard(void)
     return ret;
 }
 
+/*
+ * Initialize the OTA service, before the webserver so that it accepts uploads
+ */
+static esp_err_t appInitOta(void)
+{
+    esp_err_t ret;
+
+    if (xplrOtaInit((const char *)otaPublicKeyStart) != XPLR_OTA_OK) {
+        APP_CONSOLE(E, "OTA service initialization failed!");
+        ret = ESP_FAIL;
+    } else {
+        APP_CONSOLE(D, "OTA service initialized");
+#if (APP_SD_LOGGING_ENABLED == 1)
+        appOtaFromSd();
+#endif
+        ret = ESP_OK;
+    }
+
+    return ret;
+}
+
+#if (APP_SD_LOGGING_ENABLED == 1)
+/*
+ * Update from a firmware image in the SD card, if there is one
+ */
+static void appOtaFromSd(void)
+{
+    char path[64];
+    struct stat st;
+    xplrOta_error_t otaErr;
+
+    snprintf(path, sizeof(path), "%s/%s", DEFAULT_MOUNT_POINT, APP_OTA_SD_IMAGE);
+    if (xplrSdIsCardInit() && (stat(path, &st) == 0)) {
+        APP_CONSOLE(I, "Firmware image found in the SD card (%ld bytes)", (long)st.st_size);
+        otaErr = xplrOtaWriteFile(path);
+        /* renamed in both cases, so that the image is not applied again on every boot */
+        if (otaErr == XPLR_OTA_OK) {
+            (void)xplrSdRenameFile(APP_OTA_SD_IMAGE, APP_OTA_SD_IMAGE_DONE);
+            APP_CONSOLE(I, "Firmware updated from the SD card, restarting");
+            if (xplrOtaRestart(APP_OTA_RESTART_MS) != XPLR_OTA_OK) {
+                APP_CONSOLE(E, "Restart the device to run the new firmware");
+            }
+        } else {
+            (void)xplrSdRenameFile(APP_OTA_SD_IMAGE, APP_OTA_SD_IMAGE_BAD);
+            APP_CONSOLE(E, "Firmware image in the SD card rejected");
+        }
+    } else {
+        // do nothing
+    }
+}
+#endif
+
 /*
  * Initialize WiFi
  */
@@ -1045,70 +1123,54 @@ static esp_err_t appUpdateServerLocation(uint8_t periodSecs)
     xplrGnssLocation_t gnssInfo;
     char gMapStr[256] = {0};
     char timestamp[32] = {0};
-    cJSON *jDoc;
-    char *jBuff = NULL;
+    static char jLocation[512];
     int8_t i8Val;
 
     static uint64_t prevTime = 0;
-    esp_err_t err[2];
     esp_err_t ret;
 
     if ((MICROTOSEC(esp_timer_get_time()) - prevTime >= periodSecs) && xplrGnssHasMessage(0)) {
-        err[0] = xplrGnssGetLocationData(0, &gnssInfo);
-        if (err[0] != ESP_OK) {
+        ret = xplrGnssGetLocationData(0, &gnssInfo);
+        if (ret != ESP_OK) {
             APP_CONSOLE(E, "Could not get gnss location");
         } else {
-            err[1] = xplrGnssGetGmapsLocation(0, gMapStr, 256);
-            if (err[1] != ESP_OK) {
+            /* MQTT stats and correction time are kept up to date by the main loop */
+            hpg.telemetry.latitudeX1e7 = gnssInfo.location.latitudeX1e7;
+            hpg.telemetry.longitudeX1e7 = gnssInfo.location.longitudeX1e7;
+            hpg.telemetry.altitudeMm = gnssInfo.location.altitudeMillimetres;
+            hpg.telemetry.speedMmPerSec = gnssInfo.location.speedMillimetresPerSecond;
+            hpg.telemetry.accuracy = gnssInfo.accuracy.horizontal;
+            hpg.telemetry.fixType = (int8_t)gnssInfo.locFixType;
+            hpg.telemetry.timeUtc = gnssInfo.location.timeUtc;
+            ret = xplrWifiWebserverSendTelemetry(&hpg.telemetry);
+
+            /* polled by clients that do not subscribe to the telemetry push */
+            if (xplrGnssGetGmapsLocation(0, gMapStr, 256) != ESP_OK) {
                 APP_CONSOLE(E, "Could not build Gmap string");
             }
-        }
-
-        for (int i = 0; i < 2; i++) {
-            if (err[i] != ESP_OK) {
-                ret = ESP_FAIL;
-                break;
-            }
-            ret = ESP_OK;
-        }
-
-        if (ret != ESP_FAIL) {
             xplrTimestampToTime(gnssInfo.location.timeUtc,
                                 timestamp,
                                 32);
-
-            jDoc = cJSON_CreateObject();
-            if (jDoc != NULL) {
-                cJSON_AddStringToObject(jDoc, "rsp", "dvcLocation");
-                cJSON_AddNumberToObject(jDoc, "lat", (double)gnssInfo.location.latitudeX1e7 * (1e-7));
-                cJSON_AddNumberToObject(jDoc, "lon", (double)gnssInfo.location.longitudeX1e7 * (1e-7));
-                cJSON_AddNumberToObject(jDoc, "alt", (double)gnssInfo.location.altitudeMillimetres * (1e-3));
-                cJSON_AddNumberToObject(jDoc, "speed", (double)gnssInfo.location.speedMillimetresPerSecond);
-                cJSON_AddNumberToObject(jDoc, "accuracy", (double)gnssInfo.accuracy.horizontal * (1e-4));
-                cJSON_AddNumberToObject(jDoc, "type", (double)gnssInfo.locFixType);
-                cJSON_AddStringToObject(jDoc, "timestamp", timestamp);
-                cJSON_AddStringToObject(jDoc, "gMap", gMapStr);
-
-                jBuff = cJSON_Print(jDoc);
-                if (jBuff != NULL) {
-                    xplrWifiStarterWebserverLocationSet(jBuff);
-                    i8Val = (int8_t)gnssInfo.locFixType;
-                    xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_READY,
-                                                           (void *)&i8Val);
-
-                    xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_GNSS_ACCURACY,
-                                                           (void *)&gnssInfo.accuracy.horizontal);
-                    cJSON_free(jBuff);
-                    jBuff = NULL;
-                } else {
-                    ret = ESP_FAIL;
-                    APP_CONSOLE(E, "Failed to create json buffer");
-                }
-                cJSON_Delete(jDoc);
-            } else {
-                ret = ESP_FAIL;
-                APP_CONSOLE(E, "Failed to create json doc");
-            }
+            snprintf(jLocation,
+                     sizeof(jLocation),
+                     "{\"rsp\":\"dvcLocation\",\"lat\":%.7f,\"lon\":%.7f,\"alt\":%.3f,"
+                     "\"speed\":%d,\"accuracy\":%.4f,\"type\":%d,"
+                     "\"timestamp\":\"%s\",\"gMap\":\"%s\"}",
+                     (double)gnssInfo.location.latitudeX1e7 * (1e-7),
+                     (double)gnssInfo.location.longitudeX1e7 * (1e-7),
+                     (double)gnssInfo.location.altitudeMillimetres * (1e-3),
+                     (int)gnssInfo.location.speedMillimetresPerSecond,
+                     (double)gnssInfo.accuracy.horizontal * (1e-4),
+                     (int)gnssInfo.locFixType,
+                     timestamp,
+                     gMapStr);
+            xplrWifiStarterWebserverLocationSet(jLocation);
+
+            i8Val = (int8_t)gnssInfo.locFixType;
+            xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_READY,
+                                                   (void *)&i8Val);
+            xplrWifiStarterWebserverDiagnosticsSet(XPLR_WIFISTARTER_SERVERDIAG_GNSS_ACCURACY,
+                                                   (void *)&gnssInfo.accuracy.horizontal);
         }
 
         prevTime = MICROTOSEC(esp_timer_get_time());
@@ -202,6 +202,9 @@ class xplrHpgHtmlBuilder {
     } else if (element == "ssidScanResults") {
       if (value.rsp == "dvcSsidScan") {
         ctx = "";
+        if (value.scanning && value.scan.length == 0) {
+          ctx += '<div class="row"><div class="col">Scanning...</div></div>';
+        }
         for (const msg of value.scan) {
           ctx +=
             '\
@@ -257,6 +260,16 @@ class xplrHpgData {
         "gMap":null}'
     );
 
+    this.telemetry = JSON.parse(
+      '{"subscribed":false, \
+        "corrAge":null, \
+        "mqttMsgs":null, \
+        "mqttBytes":null, \
+        "btDevices":null, \
+        "btBytes":null, \
+        "btDropped":null}'
+    );
+
     this.diagnostics = JSON.parse(
       '{"wifi":null, \
         "thingstream":null, \
@@ -700,6 +713,7 @@ class xplrHpg {
       };
 
       this.data.socket.onclose = function (event) {
+        self.data.telemetry.subscribed = false;
         if (event.wasClean) {
           alert(`Websocket connection closed cleanly, code=${event.code} reason=${event.reason}`);
         } else {
@@ -769,6 +783,18 @@ class xplrHpg {
     }
   }
 
+  wsRequestDvcTelemetry() {
+    if (this.data.socketStatus == 1) {
+      let text = '{"req":"dvcTelemetry"}';
+      const jObj = JSON.parse(text);
+      consoleLog("[xplrHpg] Device telemetry subscribe msg:" + JSON.stringify(jObj), "cyan");
+      this.data.socket.send(JSON.stringify(jObj));
+      this.data.telemetry.subscribed = true;
+    } else {
+      consoleLog("[xplrHpg] Websocket dvcRequest failed, socket state:" + this.data.socket.readyState, "red");
+    }
+  }
+
   wsUpdateWifiCreds(ssid, password) {
     this.data.ssid = ssid;
     this.data.password = password;
@@ -1040,79 +1066,38 @@ class xplrHpg {
             break;
           case "dvcSsidScan":
             this.eventDisplay("jsSsidScan", "update", msg);
+            if (msg.scanning) {
+              // device is still scanning, its cached results are asked again
+              setTimeout(() => {
+                this.wsRequestDvcSsidScan();
+              }, 1000);
+            }
             this.data.socketBufferIn.splice(--index, 1);
             break;
           case "dvcLocation":
-            //format lat,lon and accuracy to fixed digits
-            let fLat, fLon, fAcc;
-            fLat = msg.lat.toFixed(7);
-            fLon = msg.lon.toFixed(7);
-            fAcc = msg.accuracy.toFixed(3);
-
-            this.data.gnss.latitude = fLat;
-            this.data.gnss.longitude = fLon;
-            this.data.gnss.altitude = msg.alt;
-            this.data.gnss.speed = msg.speed;
-            this.data.gnss.accuracy = fAcc;
-            this.data.gnss.fixType = msg.type;
-            this.data.gnss.timestamp = msg.timestamp;
-            this.data.gnss.gMap = msg.gMap;
-            if (this.data.diagnostics.wifi == "connected") {
-              if (this.data.gnss.latitude != null && this.data.gnss.longitude != null) {
-                let lon = this.data.gnss.longitude;
-                let lat = this.data.gnss.latitude;
-                this.mapInstance.updateMapLocation(lon, lat);
-              }
-            }
-
-            let fixType = null;
-            switch (msg.type) {
-              case -1:
-              case 0:
-                fixType = "noSignal";
-                break;
-              case 1:
-                fixType = "3D";
-                break;
-              case 2:
-                fixType = "DGNSS";
-                break;
-              case 4:
-                fixType = "RTK-Fixed";
-                break;
-              case 5:
-                fixType = "RTK-Float";
-                break;
-              case 6:
-                fixType = "Dead Reckon";
-                break;
-            }
-
-            let logMsg =
-              msg.timestamp +
-              " " +
-              this.data.info.plan +
-              " " +
-              this.data.gnss.accuracy +
-              " " +
-              this.data.gnss.latitude +
-              " " +
-              this.data.gnss.longitude +
-              " " +
-              fixType;
-
-            //https://www.regexpal.com/
-            const log = logMsg.match(
-              //time        src   acc           lat          lon          fix
-              /^\d+:\d+:\d+ (\S+) (\d+(\.\d+)?) (-?\d+\.\d+) (-?\d+\.\d+) (\S+)/
-            );
-
-            if (log != null) {
-              this.trackerLog(log[0]);
-            } else {
-              consoleLog("Error matching gnss info!", "red");
+            this.gnssLocationUpdate(msg);
+            this.data.socketBufferIn.splice(--index, 1);
+            break;
+          case "dvcTelemetry":
+            //pushed by the device once subscribed, values are in integer units
+            this.data.telemetry.corrAge = msg.cAge;
+            this.data.telemetry.mqttMsgs = msg.mqtt[0];
+            this.data.telemetry.mqttBytes = msg.mqtt[1];
+            if (msg.bt !== undefined) {
+              this.data.telemetry.btDevices = msg.bt[0];
+              this.data.telemetry.btBytes = msg.bt[1];
+              this.data.telemetry.btDropped = msg.bt[2];
             }
-
+            this.gnssLocationUpdate({
+              lat: msg.lat * 1e-7,
+              lon: msg.lon * 1e-7,
+              alt: msg.alt * 1e-3,
+              speed: msg.spd,
+              accuracy: msg.acc * 1e-4,
+              type: msg.fix,
+              timestamp: new Date(msg.utc * 1000).toISOString().substring(11, 19),
+              corrAge: msg.cAge,
+            });
             this.data.socketBufferIn.splice(--index, 1);
             break;
           default:
@@ -1124,6 +1109,88 @@ class xplrHpg {
     }
   }
 
+  gnssLocationUpdate(msg) {
+    //format lat,lon and accuracy to fixed digits
+    let fLat, fLon, fAcc;
+    fLat = msg.lat.toFixed(7);
+    fLon = msg.lon.toFixed(7);
+    fAcc = msg.accuracy.toFixed(3);
+
+    this.data.gnss.latitude = fLat;
+    this.data.gnss.longitude = fLon;
+    this.data.gnss.altitude = msg.alt;
+    this.data.gnss.speed = msg.speed;
+    this.data.gnss.accuracy = fAcc;
+    this.data.gnss.fixType = msg.type;
+    this.data.gnss.timestamp = msg.timestamp;
+    this.data.gnss.gMap = msg.gMap;
+    if (this.data.diagnostics.wifi == "connected") {
+      if (this.data.gnss.latitude != null && this.data.gnss.longitude != null) {
+        let lon = this.data.gnss.longitude;
+        let lat = this.data.gnss.latitude;
+        this.mapInstance.updateMapLocation(lon, lat);
+      }
+    }
+
+    let fixType = null;
+    switch (msg.type) {
+      case -1:
+      case 0:
+        fixType = "noSignal";
+        break;
+      case 1:
+        fixType = "3D";
+        break;
+      case 2:
+        fixType = "DGNSS";
+        break;
+      case 4:
+        fixType = "RTK-Fixed";
+        break;
+      case 5:
+        fixType = "RTK-Float";
+        break;
+      case 6:
+        fixType = "Dead Reckon";
+        break;
+    }
+
+    let logMsg =
+      msg.timestamp +
+      " " +
+      this.data.info.plan +
+      " " +
+      this.data.gnss.accuracy +
+      " " +
+      this.data.gnss.latitude +
+      " " +
+      this.data.gnss.longitude +
+      " " +
+      fixType;
+
+    //https://www.regexpal.com/
+    const log = logMsg.match(
+      //time        src   acc           lat          lon          fix
+      /^\d+:\d+:\d+ (\S+) (\d+(\.\d+)?) (-?\d+\.\d+) (-?\d+\.\d+) (\S+)/
+    );
+
+    if (log != null) {
+      let line = log[0];
+      if (msg.corrAge !== undefined) {
+        line += msg.corrAge < 0 ? " corr n/a" : " corr " + (msg.corrAge / 1000).toFixed(1) + "s";
+        //stats only come with the telemetry push
+        let tel = this.data.telemetry;
+        line += " mqtt " + tel.mqttMsgs + "/" + tel.mqttBytes + "B";
+        if (tel.btDevices != null) {
+          line += " bt " + tel.btDevices + "dev " + tel.btBytes + "B " + tel.btDropped + "drop";
+        }
+      }
+      this.trackerLog(line);
+    } else {
+      consoleLog("Error matching gnss info!", "red");
+    }
+  }
+
   trackerLog(message, color = "black") {
     let output = document.querySelector("#gnssLog");
     if (output != null) {
@@ -1155,9 +1222,12 @@ class xplrHpg {
         sleep(100).then(() => {
           this.wsRequestDvcInfo();
         });
-        sleep(100).then(() => {
-          this.wsRequestDvcLocation();
-        });
+        if (!this.data.telemetry.subscribed) {
+          // location and stats are then pushed by the device at its own rate
+          sleep(100).then(() => {
+            this.wsRequestDvcTelemetry();
+          });
+        }
         if (this.data.diagnostics.wifi == "connected") {
           if (this.loopOnce == null) {
             if (this.data.gnss.latitude != null && this.data.gnss.longitude != null) {
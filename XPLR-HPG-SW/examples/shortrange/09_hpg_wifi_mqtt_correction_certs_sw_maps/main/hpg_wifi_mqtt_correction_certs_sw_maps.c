@@ -131,6 +131,11 @@
  */
 #define APP_BT_BUFFER_SIZE XPLRBLUETOOTH_MAX_MSG_SIZE * XPLRBLUETOOTH_NUMOF_DEVICES
 
+/**
+ * The size of the Bluetooth NMEA stream buffer (fits several 10 Hz epochs of full NMEA)
+ */
+#define APP_BT_STREAM_BUFFER_SIZE (4U * 1024U)
+
 /**
  * Time in seconds to trigger an inactivity timeout and cause a restart
  */
@@ -321,6 +326,7 @@ xplrBluetooth_client_t xplrBtClient;
 SemaphoreHandle_t btSemaphore;
 uint16_t timeNow;
 char xplrBluetoothMessageBuffer[APP_BT_BUFFER_SIZE];
+static uint8_t xplrBluetoothStreamBuffer[APP_BT_STREAM_BUFFER_SIZE] __attribute__((aligned(4)));
 xplrBluetooth_error_t btError;
 bool btIsInit = false;
 
@@ -364,6 +370,7 @@ static void appInitGnssDevice(void);
 static void appInitLbandDevice(void);
 static void appMqttInit(void);
 static void appSendLocationToBt(uint8_t periodSecs);
+static void appGnssToBtSink(uGnssProtocol_t protocol, const char *msg, size_t size, void *arg);
 #if 1 == APP_PRINT_IMU_DATA
 static void appPrintDeadReckoning(uint8_t periodSecs);
 #endif
@@ -618,6 +625,7 @@ void app_main(void)
         }
 
         if (deviceOffRequested) {
+            xplrGnssSetRawMsgSink(gnssDvcPrfId, NULL, NULL);
             xplrBluetoothDisconnectAllDevices();
             xplrBluetoothDeInit();
             xplrMqttWifiUnsubscribeFromTopicArrayZtp(&mqttClient, &thingstreamSettings.pointPerfect);
@@ -880,6 +888,15 @@ void appInitBt(void)
                       btSemaphore,
                       xplrBluetoothMessageBuffer,
                       APP_BT_BUFFER_SIZE);
+    btError = xplrBluetoothStreamStart(xplrBluetoothStreamBuffer, APP_BT_STREAM_BUFFER_SIZE);
+    if (btError != XPLR_BLUETOOTH_OK) {
+        APP_CONSOLE(W, "Could not start Bluetooth NMEA stream!");
+    } else {
+        espRet = xplrGnssSetRawMsgSink(gnssDvcPrfId, appGnssToBtSink, NULL);
+        if (espRet != ESP_OK) {
+            APP_CONSOLE(W, "Could not forward GNSS messages to Bluetooth!");
+        }
+    }
 }
 
 /**
@@ -1045,15 +1062,22 @@ static void appMqttInit(void)
 }
 
 /**
- * Prints location in console and sends to SW maps via Bt
+ * Forwards every NMEA sentence read by the GNSS asyncs to the Bluetooth stream.
+ * Runs in the GNSS callback context, xplrBluetoothStreamPush never blocks.
  */
-static void appSendLocationToBt(uint8_t periodSecs)
+static void appGnssToBtSink(uGnssProtocol_t protocol, const char *msg, size_t size, void *arg)
 {
-    char GgaMsg[256];
-    char *GgaMsgPtr = GgaMsg;
-    char **GgaMsgPtrPtr = &GgaMsgPtr;
-    int32_t len;
+    if (protocol == U_GNSS_PROTOCOL_NMEA) {
+        (void)xplrBluetoothStreamPush(msg, size);
+    }
+}
 
+/**
+ * Prints location in console and reports the NMEA stream to SW maps via Bt
+ */
+static void appSendLocationToBt(uint8_t periodSecs)
+{
+    xplrBluetooth_stream_stats_t btStats;
 
     if ((MICROTOSEC(esp_timer_get_time()) - timePrevLoc >= periodSecs) &&
         xplrGnssHasMessage(gnssDvcPrfId)) {
@@ -1074,15 +1098,14 @@ static void appSendLocationToBt(uint8_t periodSecs)
 
         switch (xplrBluetoothGetState()) {
             case XPLR_BLUETOOTH_CONN_STATE_CONNECTED:
-                len = xplrGnssGetGgaMessage(0, GgaMsgPtrPtr, ELEMENTCNT(GgaMsg));
-                btError = xplrBluetoothWrite(&xplrBtClient.devices[0], GgaMsg, len);
-                if (btError != XPLR_BLUETOOTH_OK) {
-                    APP_CONSOLE(W, "Couldn't send location to Bluetooth device with handle -> [%d]",
-                                xplrBtClient.devices[0].handle);
-                } else {
-                    APP_CONSOLE(I, "Sent location successfully to Bluetooth device with handle -> [%d]",
-                                xplrBtClient.devices[0].handle);
-                }
+            case XPLR_BLUETOOTH_CONN_STATE_MSG_AVAILABLE:
+                // NMEA is streamed from the GNSS asyncs, only report how the stream is doing
+                xplrBluetoothStreamGetStats(&btStats);
+                APP_CONSOLE(I,
+                            "Bluetooth stream: queued [%u] dropped [%u] sent [%u] bytes",
+                            btStats.msgsQueued,
+                            btStats.msgsDropped,
+                            btStats.bytesSent);
                 break;
             case XPLR_BLUETOOTH_CONN_STATE_READY:
                 APP_CONSOLE(D, "No bluetooth device connected");